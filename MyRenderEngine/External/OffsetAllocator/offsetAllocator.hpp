@@ -1,3 +1,4 @@
+#pragma once
 // (C) Sebastian Aaltonen 2023
 // MIT License (see file: LICENSE)
 
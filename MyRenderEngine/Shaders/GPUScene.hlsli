@@ -24,7 +24,7 @@ struct InstanceData
     uint m_tangentBufferAddress;
     
     uint m_bVertexAnimation;
-    uint m_materialDataAddress;
+    uint m_materialIndex;
     uint m_objectID;
     float m_scale;
     
@@ -3,6 +3,7 @@
 #define VA_SATURATE saturate
 #include "XeGTAO.h"
 #include "XeGTAO.hlsli"
+#include "GTAOHalfRes.hlsli"
 
 ConstantBuffer<GTAOConstants> gtaoCB : register(b1);
 
@@ -113,4 +114,156 @@ void GTAODenoise(const uint2 dispatchThreadID : SV_DispatchThreadID)
     XeGTAO_Denoise(pixCoordBase, gtaoCB, srcWorkingAOTerm, srcWorkingEdges, samplerPointClamp, outFinalAOTerm, true);
 }
 
+cbuffer downsampleCB : register(b0)
+{
+    uint c_srcFullDepth;
+    uint c_srcFullNormal;
+    uint c_outHalfDepth;
+    uint c_outHalfNormal;
+    uint2 c_halfSize;
+};
+
+// Takes the top left pixel of every 2x2 pixels, the upsample expects the depth and the normal of exactly these pixels
+[numthreads(8, 8, 1)]
+void GTAODownsampleCS(const uint2 dispatchThreadID : SV_DispatchThreadID)
+{
+    if (any(dispatchThreadID >= c_halfSize))
+    {
+        return;
+    }
+
+    Texture2D<float> srcFullDepth = ResourceDescriptorHeap[c_srcFullDepth];
+    Texture2D srcFullNormal = ResourceDescriptorHeap[c_srcFullNormal];
+    RWTexture2D<float> outHalfDepth = ResourceDescriptorHeap[c_outHalfDepth];
+    RWTexture2D<unorm float4> outHalfNormal = ResourceDescriptorHeap[c_outHalfNormal];
+
+    outHalfDepth[dispatchThreadID] = srcFullDepth[dispatchThreadID * 2];
+    outHalfNormal[dispatchThreadID] = srcFullNormal[dispatchThreadID * 2];
+}
+
+cbuffer temporalCB : register(b0)
+{
+    uint c_srcHalfAOTerm;
+    uint c_srcHalfDepth;
+    uint c_srcHistory;
+    uint c_outHistory;
+    uint2 c_historySize;
+};
+
+// The velocity target isn't rendered, the history is reprojected with the depth and rejected when the depth of the last frame doesn't match
+[numthreads(8, 8, 1)]
+void GTAOTemporal(const uint2 pixCoord : SV_DispatchThreadID)
+{
+    if (any(pixCoord >= c_historySize))
+    {
+        return;
+    }
+
+    Texture2D<uint> srcHalfAOTerm = ResourceDescriptorHeap[c_srcHalfAOTerm];
+    Texture2D<float> srcHalfDepth = ResourceDescriptorHeap[c_srcHalfDepth];
+    Texture2D<float2> srcHistory = ResourceDescriptorHeap[c_srcHistory];
+    Texture2D<float> prevDepthTexture = ResourceDescriptorHeap[SceneCB.m_prevSceneDepthSRV];
+    SamplerState pointClampSampler = SamplerDescriptorHeap[SceneCB.m_pointClampSampler];
+    SamplerState bilinearClampSampler = SamplerDescriptorHeap[SceneCB.m_bilinearClampSampler];
+    RWTexture2D<float2> outHistory = ResourceDescriptorHeap[c_outHistory];
+
+    float ao = srcHalfAOTerm[pixCoord] / 255.0;
+    float depth = srcHalfDepth[pixCoord];
+
+    float2 history = float2(1.0, 0.0);
+    bool bHistoryValid = false;
+
+    if (depth > 0.0)
+    {
+        float3 worldPos = GetWorldPosition(pixCoord * 2, depth);
+        float4 prevClipPos = mul(GetCameraCB().m_mtxPrevViewProjection, float4(worldPos, 1.0));
+        float2 prevUV = GetScreenUV(prevClipPos.xy / prevClipPos.w);
+
+        if (prevClipPos.w > 0.0 && all(prevUV >= 0.0) && all(prevUV <= 1.0))
+        {
+            float prevLinearDepth = GetLinearDepth(prevDepthTexture.SampleLevel(pointClampSampler, prevUV, 0));
+            bHistoryValid = abs(prevLinearDepth - prevClipPos.w) < GTAO_TEMPORAL_DEPTH_THRESHOLD * prevClipPos.w;
+
+            // The history texels are at the centers of the top left pixels
+            float2 historyPos = (prevUV * SceneCB.m_renderSize - 0.5) * 0.5;
+            history = srcHistory.SampleLevel(bilinearClampSampler, (historyPos + 0.5) / c_historySize, 0);
+        }
+    }
 
+    outHistory[pixCoord] = AccumulateGTAOHistory(history, ao, bHistoryValid);
+}
+
+cbuffer upsampleCB : register(b0)
+{
+    uint c_srcLowAO;
+    uint c_srcLowDepth;
+    uint c_srcLowNormal;
+    uint c_srcHighDepth;
+    uint c_srcHighNormal;
+    uint c_outHighAOTerm;
+    uint2 c_lowSize;
+};
+
+// See UpsampleGTAO of GTAOHalfRes.cpp
+[numthreads(8, 8, 1)]
+void GTAOUpsample(const uint2 pixCoord : SV_DispatchThreadID)
+{
+    if (any(pixCoord >= SceneCB.m_renderSize))
+    {
+        return;
+    }
+
+    Texture2D<float2> srcLowAO = ResourceDescriptorHeap[c_srcLowAO];
+    Texture2D<float> srcLowDepth = ResourceDescriptorHeap[c_srcLowDepth];
+    Texture2D srcLowNormal = ResourceDescriptorHeap[c_srcLowNormal];
+    Texture2D<float> srcHighDepth = ResourceDescriptorHeap[c_srcHighDepth];
+    Texture2D srcHighNormal = ResourceDescriptorHeap[c_srcHighNormal];
+    RWTexture2D<uint> outHighAOTerm = ResourceDescriptorHeap[c_outHighAOTerm];
+
+    float highNDCDepth = srcHighDepth[pixCoord];
+    if (highNDCDepth == 0.0) //< No AO for infinite distance
+    {
+        outHighAOTerm[pixCoord] = 255;
+        return;
+    }
+
+    float highDepth = GetLinearDepth(highNDCDepth);
+    float3 highNormal = DecodeNormal(srcHighNormal[pixCoord].xyz);
+
+    const uint2 offsets[4] = { uint2(0, 0), uint2(1, 0), uint2(0, 1), uint2(1, 1) };
+    uint2 basePos = pixCoord / 2;
+    float4 bilinearWeights = GetGTAOUpsampleBilinearWeights(float2(pixCoord % 2) * 0.5);
+
+    float ao = 0.0;
+    float weightSum = 0.0;
+    float closestAO = 1.0;
+    float closestDepthDiff = 3.402823466e+38;
+
+    [unroll]
+    for (uint i = 0; i < 4; ++i)
+    {
+        if (bilinearWeights[i] == 0.0)
+        {
+            continue;
+        }
+
+        uint2 pos = min(basePos + offsets[i], c_lowSize - 1);
+        float lowAO = srcLowAO[pos].x;
+        float lowDepth = GetLinearDepth(srcLowDepth[pos]);
+        float3 lowNormal = DecodeNormal(srcLowNormal[pos].xyz);
+
+        float weight = GetGTAOUpsampleWeight(bilinearWeights[i], lowDepth, highDepth, lowNormal, highNormal);
+        ao += lowAO * weight;
+        weightSum += weight;
+
+        float depthDiff = abs(lowDepth - highDepth);
+        if (depthDiff < closestDepthDiff)
+        {
+            closestDepthDiff = depthDiff;
+            closestAO = lowAO;
+        }
+    }
+
+    ao = weightSum < GTAO_UPSAMPLE_MIN_WEIGHT ? closestAO : ao / weightSum;
+    outHighAOTerm[pixCoord] = uint(saturate(ao) * 255.0 + 0.5);
+}
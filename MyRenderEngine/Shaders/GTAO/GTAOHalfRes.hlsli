@@ -0,0 +1,36 @@
+#pragma once
+
+#define GTAO_TEMPORAL_MAX_FRAMES 8              //< The weight of the current frame doesn't drop below 1 / GTAO_TEMPORAL_MAX_FRAMES
+#define GTAO_TEMPORAL_DEPTH_THRESHOLD 0.05      //< Relative difference of the reprojected linear depth above which the history is rejected
+#define GTAO_UPSAMPLE_DEPTH_SHARPNESS 64.0      //< The depth weight halves every 1 / GTAO_UPSAMPLE_DEPTH_SHARPNESS of relative linear depth difference
+#define GTAO_UPSAMPLE_NORMAL_POWER 8.0
+#define GTAO_UPSAMPLE_MIN_WEIGHT 0.0001         //< Below this sum of the weights the texel of the closest depth is taken
+
+// The half resolution GTAO runs on the top left pixel of every 2x2 pixels, so a full resolution pixel p lies at p / 2 in the half resolution texels.
+// Even pixels take their own texel, the others weight the texels around them by bilinear weights times depth and normal weights,
+// so the AO of one surface doesn't bleed to another one.
+// The history is a RG16F texture of the accumulated AO and the accumulated frame count, a count of 0 is no history
+
+#ifndef __cplusplus
+
+// Weights of the texels (0, 0), (1, 0), (0, 1) and (1, 1) around a position of fraction f
+float4 GetGTAOUpsampleBilinearWeights(float2 f)
+{
+    return float4((1.0 - f.x) * (1.0 - f.y), f.x * (1.0 - f.y), (1.0 - f.x) * f.y, f.x * f.y);
+}
+
+// Depths are linear, normals are world space
+float GetGTAOUpsampleWeight(float bilinearWeight, float lowDepth, float highDepth, float3 lowNormal, float3 highNormal)
+{
+    float depthWeight = exp2(-abs(lowDepth - highDepth) / max(highDepth, 1e-4) * GTAO_UPSAMPLE_DEPTH_SHARPNESS);
+    float normalWeight = pow(saturate(dot(lowNormal, highNormal)), GTAO_UPSAMPLE_NORMAL_POWER);
+    return bilinearWeight * depthWeight * normalWeight;
+}
+
+float2 AccumulateGTAOHistory(float2 history, float ao, bool bHistoryValid)
+{
+    float frameCount = bHistoryValid ? min(history.y + 1.0, GTAO_TEMPORAL_MAX_FRAMES) : 1.0;
+    return float2(lerp(history.x, ao, 1.0 / frameCount), frameCount);
+}
+
+#endif // __cplusplus
@@ -137,6 +137,8 @@ struct SceneConstant
 
     uint m_localLightDataAddress;
     uint m_localLightCount;
+    uint m_materialDataAddress;     //< Material table in the scene static buffer
+    uint m_virtualShadowMapDataAddress;
 };
 
 #ifndef __cplusplus
@@ -1,4 +1,5 @@
 #include "../Common.hlsli"
+#include "HZB.hlsli"
 
 // SPD -> single pass downsample
 cbuffer spdConstants : register(b1)
@@ -11,6 +12,10 @@ cbuffer spdConstants : register(b1)
     uint c_imgSrc;
     uint c_spdGlobalAtomicUAV;
     
+    uint c_imgMip0;         //< The fused builds write mip 0 while loading the source
+    uint2 c_srcSize;
+    uint c_padding;
+    
     // HLSL packing rules : every element in a array is store in a four-component vector
     uint4 c_imgDst[12]; 
 }
@@ -23,6 +28,77 @@ groupshared AU1 spdCounter;
 groupshared AF1 spdIntermediateR[16][16];
 groupshared AF1 spdIntermediateG[16][16];
 
+#if HZB_FUSED_REPROJECTION
+
+// Empty texels take the farthest depth of the neighbours, sky texels are empty as well
+float ResolveReprojectedDepth(Texture2D<uint> reprojectedDepthTexture, int2 pos)
+{
+    uint value = reprojectedDepthTexture[pos];
+    float depth = value == HZB_REPROJECTION_EMPTY ? 0.0 : asfloat(value);
+    if (depth == 0.0)
+    {
+        float minDepth = 1.0;
+        for (int y = -HZB_DILATION_RADIUS; y <= HZB_DILATION_RADIUS; ++y)
+        {
+            for (int x = -HZB_DILATION_RADIUS; x <= HZB_DILATION_RADIUS; ++x)
+            {
+                uint neighbour = reprojectedDepthTexture[pos + int2(x, y)];     //< Out of bounds loads are 0
+                float d = neighbour == HZB_REPROJECTION_EMPTY ? 0.0 : asfloat(neighbour);
+                if (d > 0.0 && d < minDepth)
+                {
+                    minDepth = d;
+                }
+            }
+        }
+
+        if (minDepth != 1.0)
+        {
+            depth = minDepth;
+        }
+    }
+    return depth;
+}
+
+AF4 SpdLoadSourceImage(ASU2 p, AU1 slice)
+{
+    Texture2D<uint> reprojectedDepthTexture = ResourceDescriptorHeap[c_imgSrc];
+    RWTexture2D<float> imgMip0 = ResourceDescriptorHeap[c_imgMip0];
+
+    float depth = ResolveReprojectedDepth(reprojectedDepthTexture, p);
+    imgMip0[p] = depth;
+    return AF4(depth, 0, 0, 0);
+}
+
+#elif HZB_FUSED_DEPTH
+
+// Min and max of every depth texel the HZB texel overlaps, the sampler reduction of a 2x2 footprint misses texels when the depth buffer is more than twice as large
+AF4 SpdLoadSourceImage(ASU2 p, AU1 slice)
+{
+    Texture2D<float> depthTexture = ResourceDescriptorHeap[c_imgSrc];
+    RWTexture2D<float2> imgMip0 = ResourceDescriptorHeap[c_imgMip0];
+    
+    uint2 hzbSize;
+    imgMip0.GetDimensions(hzbSize.x, hzbSize.y);
+    
+    uint2 footprintX = GetHZBFootprint(p.x, c_srcSize.x, hzbSize.x);
+    uint2 footprintY = GetHZBFootprint(p.y, c_srcSize.y, hzbSize.y);
+    
+    float2 minMax = float2(1.0, 0.0);
+    for (uint y = footprintY.x; y < footprintY.y; ++y)
+    {
+        for (uint x = footprintX.x; x < footprintX.y; ++x)
+        {
+            float depth = depthTexture[uint2(x, y)];
+            minMax = float2(min(minMax.x, depth), max(minMax.y, depth));
+        }
+    }
+    
+    imgMip0[p] = minMax;
+    return AF4(minMax, 0, 0);
+}
+
+#else
+
 AF4 SpdLoadSourceImage(ASU2 p, AU1 slice)
 {
     Texture2D imgSrc = ResourceDescriptorHeap[c_imgSrc];
@@ -31,7 +107,7 @@ AF4 SpdLoadSourceImage(ASU2 p, AU1 slice)
     AF2 textureCoord = p * c_invInputSize + (0.5 * c_invInputSize);
     
 #if MIN_MAX_FILTER
-    AF4 result = AF4(imgSrc.SampleLevel(minSampler, texureCoord, 0).x, imgSrc.SampleLevel(maxSampler, textureCoord, 0).y, 0, 0);
+    AF4 result = AF4(imgSrc.SampleLevel(minSampler, textureCoord, 0).x, imgSrc.SampleLevel(maxSampler, textureCoord, 0).y, 0, 0);
 #else
     AF4 result = AF4(imgSrc.SampleLevel(minSampler, textureCoord, 0).x, 0, 0, 0);
 #endif
@@ -39,6 +115,10 @@ AF4 SpdLoadSourceImage(ASU2 p, AU1 slice)
     return result;
 }
 
+#define SPD_LINEAR_SAMPLER // We are using a min lenear reduction sampler
+
+#endif
+
 AF4 SpdLoad(ASU2 tex, AU1 slice)
 {
 #if MIN_MAX_FILTER
@@ -118,7 +198,6 @@ AF4 SpdReduce4(AF4 v0, AF4 v1, AF4 v2, AF4 v3)
 #endif
 }
 
-#define SPD_LINEAR_SAMPLER // We are using a min lenear reduction sampler
 #include "../FFX/ffx_spd.h"
 
 [numthreads(256, 1, 1)]
@@ -0,0 +1,17 @@
+#pragma once
+
+#define HZB_REPROJECTION_EMPTY 0xFFFFFFFF       //< Reprojected depth texels which no pixel of the last frame moved to
+#define HZB_DILATION_RADIUS 1                   //< Empty reprojected texels take the farthest depth of the neighbours in this radius
+
+// The fused HZB builds write mip 0 from SpdLoadSourceImage, so the reprojected depth and the depth buffer are reduced in the same dispatch as the mips.
+// A texel of mip 0 reduces every depth texel it overlaps, the depth buffer isn't a multiple of the HZB size
+
+#ifndef __cplusplus
+
+// Range [x, y) of the source texels a texel overlaps, when the source isn't exactly twice as large the neighbour ranges share the border texels
+uint2 GetHZBFootprint(uint texel, uint srcSize, uint dstSize)
+{
+    return uint2(texel * srcSize / dstSize, ((texel + 1) * srcSize + dstSize - 1) / dstSize);
+}
+
+#endif // __cplusplus
@@ -8,14 +8,13 @@ cbuffer RootConstants : register(b0)
     uint c_hzbHeight;
 };
 
-[numthreads(8, 8, 1)]
-void DepthReprojection(uint3 dispatchThreadID : SV_DispatchThreadID)
+// xy : texel of the current frame the HZB texel of the last frame moves to, z : depth
+float3 ReprojectTexel(uint2 texel)
 {
     Texture2D<float> prevDepthTexture = ResourceDescriptorHeap[SceneCB.m_prevSceneDepthSRV];
-    RWTexture2D<float> reprojectedDepthTexture = ResourceDescriptorHeap[c_outputUAV];
     SamplerState maxReductionSampler = SamplerDescriptorHeap[SceneCB.m_maxReductionSampler];
     
-    float2 uv = (dispatchThreadID.xy + 0.5f) / float2(c_hzbWidth, c_hzbHeight);
+    float2 uv = (texel + 0.5f) / float2(c_hzbWidth, c_hzbHeight);
     
     float prevNDCDepth = prevDepthTexture.SampleLevel(maxReductionSampler, uv, 0);
     
@@ -31,7 +30,30 @@ void DepthReprojection(uint3 dispatchThreadID : SV_DispatchThreadID)
     float2 reprojectedUV = GetScreenUV(reprojectedPosition.xy);
     float2 reprojectedScreenPos = reprojectedUV * float2(c_hzbWidth, c_hzbHeight);
     
-    reprojectedDepthTexture[reprojectedScreenPos] = saturate(reprojectedDepth);
+    return float3(reprojectedScreenPos, saturate(reprojectedDepth));
+}
+
+[numthreads(8, 8, 1)]
+void DepthReprojection(uint3 dispatchThreadID : SV_DispatchThreadID)
+{
+    RWTexture2D<float> reprojectedDepthTexture = ResourceDescriptorHeap[c_outputUAV];
+    
+    float3 reprojected = ReprojectTexel(dispatchThreadID.xy);
+    reprojectedDepthTexture[reprojected.xy] = reprojected.z;
+}
+
+// The farthest of the texels moving to the same place wins, the output is cleared to HZB_REPROJECTION_EMPTY of HZB.hlsli.
+// The dilation and the mips are done by the fused HZB build of HZB.hlsl
+[numthreads(8, 8, 1)]
+void DepthReprojectionAtomic(uint3 dispatchThreadID : SV_DispatchThreadID)
+{
+    RWTexture2D<uint> reprojectedDepthTexture = ResourceDescriptorHeap[c_outputUAV];
+    
+    float3 reprojected = ReprojectTexel(dispatchThreadID.xy);
+    if (all(reprojected.xy >= 0.0) && all(reprojected.xy < float2(c_hzbWidth, c_hzbHeight)))
+    {
+        InterlockedMin(reprojectedDepthTexture[uint2(reprojected.xy)], asuint(reprojected.z));
+    }
 }
 
 [numthreads(8, 8, 1)]
@@ -1,7 +1,7 @@
 cbuffer ResourceCB : register(b0)
 {
     uint c_VertexBufferID;
-    uint c_VertexOffset;
+    uint c_VertexOffset;    //< In bytes
     uint c_TextureID;
     uint c_SamplerID;
 };
@@ -41,8 +41,8 @@ struct PSInput
 
 PSInput vs_main(uint vertexID : SV_VertexID)
 {
-    StructuredBuffer<Vertex> VB = ResourceDescriptorHeap[c_VertexBufferID];
-    Vertex vertex = VB[vertexID + c_VertexOffset];
+    ByteAddressBuffer VB = ResourceDescriptorHeap[c_VertexBufferID];
+    Vertex vertex = VB.Load<Vertex>(c_VertexOffset + sizeof(Vertex) * vertexID);
     
     PSInput output;
     output.m_pos = mul(ProjectionMatrix, float4(vertex.m_pos.xy, 0.0f, 1.0f));
@@ -131,35 +131,74 @@ cbuffer BuildMeshletListConstants : register(b0)
 {
     uint c_dispatchIndex;
     uint c_cullingResultSRV;
-    uint c_originMeshletListAddress;
-    uint c_originMeshletCount;
+    uint c_instanceRecordAddress;       // uint2(instanceIndex, meshletCount) per instance
+    uint c_instanceRecordCount;
     uint c_meshletListOffset;
     uint c_meshletListBufferUAV;
     uint c_meshletListBufferCounterUAV;
 };
 
+groupshared uint s_meshletOffsets[64];    //< Wave prefix sums of the meshlet counts, at the group index of each lane
+groupshared uint s_instanceIndices[64];
+
+// One thread per instance, visible instances append all their meshlets to the list of the PSO bucket.
+// The meshlets of the whole wave are written by all its lanes, so an instance with many meshlets doesn't stall the wave
 [numthreads(64, 1, 1)]
-void BuildMeshletList(uint3 dispatchThreadID : SV_DispatchThreadID)
+void BuildMeshletList(uint3 dispatchThreadID : SV_DispatchThreadID, uint groupIndex : SV_GroupIndex)
 {
-    if(dispatchThreadID.x >= c_originMeshletCount)
+    uint instanceIndex = 0;
+    uint meshletCount = 0;
+    
+    if(dispatchThreadID.x < c_instanceRecordCount)
     {
-        return;    
-    }
+        ByteAddressBuffer constantBuffer = ResourceDescriptorHeap[SceneCB.m_sceneConstantBufferSRV];
+        uint2 instanceRecord = constantBuffer.Load2(c_instanceRecordAddress + sizeof(uint2) * dispatchThreadID.x);
     
-    ByteAddressBuffer constantBuffer = ResourceDescriptorHeap[SceneCB.m_sceneConstantBufferSRV];
-    uint2 meshlet = constantBuffer.Load2(c_originMeshletListAddress + sizeof(uint2) * dispatchThreadID.x);
+        Buffer<uint> cullingResultBuffer = ResourceDescriptorHeap[c_cullingResultSRV];
+        instanceIndex = instanceRecord.x;
+        meshletCount = (cullingResultBuffer[instanceIndex] == 1 ? instanceRecord.y : 0);
+    }
     
-    Buffer<uint> cullingResultBuffer = ResourceDescriptorHeap[c_cullingResultSRV];
-    bool bVisible = (cullingResultBuffer[meshlet.x] == 1 ? true : false);
+    // Prefix sum in the wave, so only one atomic per wave is needed to allocate the output range
+    uint localOffset = WavePrefixSum(meshletCount);
+    uint waveMeshletCount = WaveActiveSum(meshletCount);
     
-    if(bVisible)
+    uint waveOffset = 0;
+    if(WaveIsFirstLane() && waveMeshletCount > 0)
     {
-        RWStructuredBuffer<uint2> meshletListBuffer = ResourceDescriptorHeap[c_meshletListBufferUAV];
         RWBuffer<uint> counterBuffer = ResourceDescriptorHeap[c_meshletListBufferCounterUAV];
+        InterlockedAdd(counterBuffer[c_dispatchIndex], waveMeshletCount, waveOffset);
+    }
+    waveOffset = WaveReadLaneFirst(waveOffset);
+    
+    s_meshletOffsets[groupIndex] = localOffset;
+    s_instanceIndices[groupIndex] = instanceIndex;
+    GroupMemoryBarrierWithGroupSync();
+    
+    uint laneCount = WaveGetLaneCount();
+    uint firstLane = groupIndex - WaveGetLaneIndex();
+    
+    RWStructuredBuffer<uint2> meshletListBuffer = ResourceDescriptorHeap[c_meshletListBufferUAV];
+    for(uint item = WaveGetLaneIndex(); item < waveMeshletCount; item += laneCount)
+    {
+        // The owner is the last lane whose offset is not after the item, lanes without meshlets share the offset of the next lane
+        uint low = 0;
+        uint high = laneCount;
+        while(high - low > 1)
+        {
+            uint middle = (low + high) / 2;
+            if(s_meshletOffsets[firstLane + middle] <= item)
+            {
+                low = middle;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
         
-        uint meshletsCount;
-        InterlockedAdd(counterBuffer[c_dispatchIndex], 1, meshletsCount);
-        meshletListBuffer[c_meshletListOffset + meshletsCount] = meshlet;
+        uint meshletIndex = item - s_meshletOffsets[firstLane + low];
+        meshletListBuffer[c_meshletListOffset + waveOffset + item] = uint2(s_instanceIndices[firstLane + low], meshletIndex);
     }
 }
 
@@ -1,4 +1,5 @@
 #pragma once
+#include "GPUScene.hlsli"
 
 struct Meshlet
 {
@@ -18,4 +19,15 @@ struct MeshletPayload
 {
     uint m_instanceIndices[32];
     uint m_meshletIndices[32];
-};
\ No newline at end of file
+    uint m_firstVisibleMeshlet;     //< In the visible meshlet list of the visibility buffer, the group's meshlets follow it
+};
+
+// Meshlets of skinned instances are in the animation buffer, their bounds are refreshed by VertexSkining.hlsl every frame
+Meshlet LoadMeshlet(InstanceData instanceData, uint meshletIndex)
+{
+    if (instanceData.m_bVertexAnimation)
+    {
+        return LoadSceneAnimationBuffer<Meshlet>(instanceData.m_meshletBufferAddress, meshletIndex);
+    }
+    return LoadSceneStaticBuffer<Meshlet>(instanceData.m_meshletBufferAddress, meshletIndex);
+}
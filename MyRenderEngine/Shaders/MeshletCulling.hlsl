@@ -2,6 +2,7 @@
 #include "Meshlet.hlsli"
 #include "Debug.hlsli"
 #include "Stats.hlsli"
+#include "SoftwareRaster.hlsli"
 
 cbuffer MeshletCullingConstant : register(b0)
 {
@@ -12,6 +13,10 @@ cbuffer MeshletCullingConstant : register(b0)
     uint c_dispatchIndex;
     
     uint c_bIsFirstPass;
+    
+    uint c_visibleMeshletListUAV;       //< Visibility buffer only, meshlets rendered by both phases
+    uint c_visibleMeshletCounterUAV;
+    uint c_bSoftwareRaster;
 };
 
 groupshared MeshletPayload s_Payload;
@@ -77,6 +82,25 @@ bool Cull(Meshlet meshlet, uint instanceIndex, uint meshletIndex)
     return true;
 }
 
+#if VISIBILITY_BUFFER
+bool IsSoftwareRaster(Meshlet meshlet, uint instanceIndex)
+{
+#if ALPHA_TEST
+    return false;
+#else
+    InstanceData instanceData = GetInstanceData(instanceIndex);
+    float3 center = mul(instanceData.m_mtxWorld, float4(meshlet.m_center, 1.0f)).xyz;
+    float radius = meshlet.m_radius * instanceData.m_scale;
+    center = mul(GetCameraCB().m_mtxView, float4(center, 1.0)).xyz;
+    
+    // Fails for the meshlets crossing the near plane, they need clipping
+    float4 aabb;
+    return ProjectSphere(center, radius, GetCameraCB().m_nearZ, GetCameraCB().m_mtxProjection[0][0], GetCameraCB().m_mtxProjection[1][1], aabb) &&
+        IsSoftwareRasterMeshlet(aabb, (float2) SceneCB.m_renderSize);
+#endif
+}
+#endif
+
 [numthreads(32, 1, 1)]
 void as_main(uint3 dispatchThreadID : SV_DispatchThreadID)
 {
@@ -84,14 +108,16 @@ void as_main(uint3 dispatchThreadID : SV_DispatchThreadID)
     uint totalMeshletCount = counterBuffer[c_dispatchIndex];
     
     bool bIsVisible = false;
+    bool bSoftwareRaster = false;
+    uint2 dataPerMeshlet = uint2(0, 0);
     if(dispatchThreadID.x < totalMeshletCount)
     {
         StructuredBuffer<uint2> meshletListBuffer = ResourceDescriptorHeap[c_meshletListBufferSRV];
-        uint2 dataPerMeshlet = meshletListBuffer[c_meshletListBufferOffset + dispatchThreadID.x];
+        dataPerMeshlet = meshletListBuffer[c_meshletListBufferOffset + dispatchThreadID.x];
         uint instanceIndex = dataPerMeshlet.x;
         uint meshletIndex = dataPerMeshlet.y;
         
-        Meshlet meshLet = LoadSceneStaticBuffer<Meshlet>(GetInstanceData(instanceIndex).m_meshletBufferAddress, meshletIndex);
+        Meshlet meshLet = LoadMeshlet(GetInstanceData(instanceIndex), meshletIndex);
         bIsVisible = Cull(meshLet, instanceIndex, meshletIndex);
   
         if(c_bIsFirstPass)
@@ -102,6 +128,20 @@ void as_main(uint3 dispatchThreadID : SV_DispatchThreadID)
             stats(bIsVisible ? STATS_2ND_PHASE_RENDERED_TRIANGLE : STATS_2ND_PHASE_CULLED_TRIANGLE, meshLet.m_triangleCount);
         }
         
+#if VISIBILITY_BUFFER
+        // Small meshlets are rendered by SoftwareRaster.hlsl instead of the mesh shader
+        if (bIsVisible && c_bSoftwareRaster)
+        {
+            bSoftwareRaster = IsSoftwareRaster(meshLet, instanceIndex);
+            bIsVisible = !bSoftwareRaster;
+            
+            if (bSoftwareRaster)
+            {
+                stats(c_bIsFirstPass ? STATS_1ST_PHASE_SOFTWARE_RASTER_MESHLET : STATS_2ND_PHASE_SOFTWARE_RASTER_MESHLET, 1);
+            }
+        }
+#endif
+        
         if(bIsVisible)
         {
             uint index = WavePrefixCountBits(bIsVisible);
@@ -111,6 +151,46 @@ void as_main(uint3 dispatchThreadID : SV_DispatchThreadID)
     }
     
     uint visibleMeshletCount = WaveActiveCountBits(bIsVisible);
+    
+#if VISIBILITY_BUFFER
+    // The visibility ID of a pixel is its meshlet in this list, one atomic per group
+    RWBuffer<uint> visibleMeshletCounter = ResourceDescriptorHeap[c_visibleMeshletCounterUAV];
+    uint softwareRasterCount = WaveActiveCountBits(bSoftwareRaster);
+    uint firstVisibleMeshlet = 0;
+    uint firstSoftwareRaster = 0;
+    if (WaveIsFirstLane())
+    {
+        if (visibleMeshletCount > 0)
+        {
+            InterlockedAdd(visibleMeshletCounter[0], visibleMeshletCount, firstVisibleMeshlet);
+        }
+        if (softwareRasterCount > 0)
+        {
+            InterlockedAdd(visibleMeshletCounter[c_bIsFirstPass ? 1 : 2], softwareRasterCount, firstSoftwareRaster);
+        }
+    }
+    firstVisibleMeshlet = WaveReadLaneFirst(firstVisibleMeshlet);
+    firstSoftwareRaster = WaveReadLaneFirst(firstSoftwareRaster);
+    
+    RWStructuredBuffer<uint2> visibleMeshletList = ResourceDescriptorHeap[c_visibleMeshletListUAV];
+    if (bSoftwareRaster)
+    {
+        uint visibleMeshletCapacity, stride;
+        visibleMeshletList.GetDimensions(visibleMeshletCapacity, stride);
+        
+        // The 2nd phase ones follow the 1st phase ones, which SoftwareRaster.hlsl reads the count of
+        uint softwareRasterIndex = (c_bIsFirstPass ? 0 : visibleMeshletCounter[1]) + firstSoftwareRaster + WavePrefixCountBits(bSoftwareRaster);
+        visibleMeshletList[GetSoftwareRasterVisibleMeshlet(visibleMeshletCapacity, softwareRasterIndex)] = dataPerMeshlet;
+    }
+    
+    if (bIsVisible)
+    {
+        uint index = WavePrefixCountBits(bIsVisible);
+        visibleMeshletList[firstVisibleMeshlet + index] = uint2(s_Payload.m_instanceIndices[index], s_Payload.m_meshletIndices[index]);
+    }
+    s_Payload.m_firstVisibleMeshlet = firstVisibleMeshlet;
+#endif
+    
     DispatchMesh(visibleMeshletCount, 1, 1, s_Payload); //< Dispatch threadgroups of mesh shader
 }
 
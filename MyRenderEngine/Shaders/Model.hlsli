@@ -5,11 +5,17 @@
 #include "GPUScene.hlsli"
 #include "Debug.hlsli"
 
+// Ray tracing and the uber material read the texture presence and the material features from the material table,
+// other shaders get them from the permutation defines
+#if defined(RAY_TRACING) || UBER_MATERIAL
+#define MATERIAL_FEATURES_FROM_TABLE 1
+#endif
+
 namespace model
 {
     ModelMaterialConstant GetMaterialConstant(uint instanceID)
     {
-        return LoadSceneConstantBuffer<ModelMaterialConstant>(GetInstanceData(instanceID).m_materialDataAddress);
+        return LoadSceneStaticBuffer<ModelMaterialConstant>(SceneCB.m_materialDataAddress, GetInstanceData(instanceID).m_materialIndex);
     }
     
     struct Vertex
@@ -162,22 +168,60 @@ namespace model
 #endif
     }
     
+#if VISIBILITY_BUFFER_RESOLVE
+    // Screen space derivatives of the uv, set by the visibility buffer resolve. Its pixels are not in quads of the same triangle
+    static float2 s_uvDDX;
+    static float2 s_uvDDY;
+#endif
+    
     float4 SampleMaterialTexture(MaterialTextureInfo textureInfo, float2 uv, float mipLOD)
     {
         Texture2D texture = GetMaterialTexture2D(textureInfo.m_index);
         SamplerState textureSampler = GetMaterialSampler();
+#if VISIBILITY_BUFFER_RESOLVE
+        float2 uvX = textureInfo.TransformUV(uv + s_uvDDX);     //< The transform is affine, so it applies to the neighbours too
+        float2 uvY = textureInfo.TransformUV(uv + s_uvDDY);
+#endif
         uv = textureInfo.TransformUV(uv);
         
 #ifdef RAY_TRACING
         return texture.SampleLevel(textureSampler, uv, mipLOD);
+#elif VISIBILITY_BUFFER_RESOLVE
+        return texture.SampleGrad(textureSampler, uv, uvX - uv, uvY - uv);
 #else
         return texture.Sample(textureSampler, uv);
 #endif
     }
     
+    bool IsPBRMetallicRoughness(uint instanceID)
+    {
+#if MATERIAL_FEATURES_FROM_TABLE
+        return GetMaterialConstant(instanceID).m_bPBRMatallicRoughness;
+#else
+    #if PBR_METALLIC_ROUGHNESS
+        return true;
+    #else
+        return false;
+    #endif
+#endif
+    }
+    
+    bool IsDoubleSided(uint instanceID)
+    {
+#if MATERIAL_FEATURES_FROM_TABLE
+        return GetMaterialConstant(instanceID).m_bDoubleSided;
+#else
+    #if DOUBLE_SIDED
+        return true;
+    #else
+        return false;
+    #endif
+#endif
+    }
+    
     bool IsAlbedoTextureEnabled(uint instanceID)
     {
-#ifdef RAY_TRACING
+#if MATERIAL_FEATURES_FROM_TABLE
         return GetMaterialConstant(instanceID).m_albedoTexture.m_index != INVALID_RESOURCE_INDEX;
 #else
     #if ALBEDO_TEXTURE
@@ -190,8 +234,8 @@ namespace model
     
     bool IsMetallicRoughnessTextureEnabled(uint instanceID)
     {
-#ifdef RAY_TRACING
-        return GetMaterialConstant(instanceID).m_metallicRhoughnessTexture.m_index != INVALID_RESOURCE_INDEX;
+#if MATERIAL_FEATURES_FROM_TABLE
+        return GetMaterialConstant(instanceID).m_metallicRoughnessTexture.m_index != INVALID_RESOURCE_INDEX;
 #else
     #if METALLIC_ROUGHNESS_TEXTURE
         return true;
@@ -203,9 +247,9 @@ namespace model
     
     bool IsAOMetallicRoughnessTextureEnabled(uint instanceID)
     {
-#ifdef RAY_TRACING
-        retrun GetMaterialConstant(instanceIndex).m_metallicRoughnessTexture.m_index != INVALID_RESOURCE_INDEX && 
-        GetMaterialConstant(instanceIndex).m_metallicRoughnessTexture.index == GetMaterialConstant(instanceIndex).m_aoTexture.m_index;
+#if MATERIAL_FEATURES_FROM_TABLE
+        return GetMaterialConstant(instanceID).m_metallicRoughnessTexture.m_index != INVALID_RESOURCE_INDEX && 
+            GetMaterialConstant(instanceID).m_metallicRoughnessTexture.m_index == GetMaterialConstant(instanceID).m_aoTexture.m_index;
 #else
     #if AO_METALLIC_ROUGHNESS_TEXTURE
         return true;
@@ -250,7 +294,7 @@ namespace model
     
     bool IsDiffuseTextureEnabled(uint instanceID)
     {
-#ifdef RAY_TRACING
+#if MATERIAL_FEATURES_FROM_TABLE
         return GetMaterialConstant(instanceID).m_diffuseTexture.m_index != INVALID_RESOURCE_INDEX;
 #else
     #if DIFFUSE_TEXTURE
@@ -263,7 +307,7 @@ namespace model
     
     bool IsSpecularGlossinessTextureEnabled(uint instanceID)
     {
-#ifdef RAY_TRACING
+#if MATERIAL_FEATURES_FROM_TABLE
         return GetMaterialConstant(instanceID).m_specularGlossinessTexture.m_index != INVALID_RESOURCE_INDEX;
 #else
     #if SPECULAR_GLOSSINESS_TEXTURE
@@ -303,7 +347,7 @@ namespace model
     
     bool IsNormalTextureEnabled(uint instanceID)
     {
-#ifdef RAY_TRACING
+#if MATERIAL_FEATURES_FROM_TABLE
         return GetMaterialConstant(instanceID).m_normalTexture.m_index != INVALID_RESOURCE_INDEX;
 #else
     #if NORMAL_TEXTURE
@@ -316,7 +360,7 @@ namespace model
     
     bool IsRGNormalTextureEnabled(uint instanceID)
     {
-#ifdef RAY_TRACING
+#if MATERIAL_FEATURES_FROM_TABLE
         return GetMaterialConstant(instanceID).m_bRGNormalTexture;
 #else
     #if RG_NORMAL_TEXTURE
@@ -348,7 +392,7 @@ namespace model
     
     bool IsAOTextureEnabled(uint instanceID)
     {
-#ifdef RAY_TRACING
+#if MATERIAL_FEATURES_FROM_TABLE
         return GetMaterialConstant(instanceID).m_aoTexture.m_index != INVALID_RESOURCE_INDEX;
 #else
     #if AO_TEXTURE
@@ -374,7 +418,7 @@ namespace model
     
     bool IsEmissiveTextureEnabled(uint instanceID)
     {
-#ifdef RAY_TRACING
+#if MATERIAL_FEATURES_FROM_TABLE
         return GetMaterialConstant(instanceID).m_emissiveTexture.m_index != INVALID_RESOURCE_INDEX;
 #else
     #if EMISSIVE_TEXTURE
@@ -398,10 +442,10 @@ namespace model
     
     bool IsAnisotropyTextureEnabled(uint instanceID)
     {
-#ifdef RAY_TRACING
-        return GetMaterialConstant(instanceID).m_anisotropyTexture.m_index = INVALID_RESOURCE_INDEX;
+#if MATERIAL_FEATURES_FROM_TABLE
+        return GetMaterialConstant(instanceID).m_anisotropyTexture.m_index != INVALID_RESOURCE_INDEX;
 #else
-    #if ANISOTROPY_TANGENT_TEXTURE
+    #if ANISOTROPIC_TANGENT_TEXTURE
         return true;
     #else
         return false;
@@ -425,7 +469,7 @@ namespace model
     
     bool IsSheenColorTextureEnabled(uint instanceID)
     {
-#ifdef RAY_TRACING
+#if MATERIAL_FEATURES_FROM_TABLE
         return GetMaterialConstant(instanceID).m_sheenColorTexture.m_index != INVALID_RESOURCE_INDEX;
 #else
     #if SHEEN_COLOR_TEXTURE
@@ -438,11 +482,11 @@ namespace model
     
     bool IsSheenColorRoughnessTextureEnabled(uint instanceID)
     {
-#ifdef RAY_TRACING
+#if MATERIAL_FEATURES_FROM_TABLE
         return GetMaterialConstant(instanceID).m_sheenColorTexture.m_index != INVALID_RESOURCE_INDEX &&
             GetMaterialConstant(instanceID).m_sheenColorTexture.m_index == GetMaterialConstant(instanceID).m_sheenRoughnessTexture.m_index;
 #else
-    #if SHENN_COLOR_ROUGHNESS_TEXTURE
+    #if SHEEN_COLOR_ROUGHNESS_TEXTURE
         return true;
     #else
         return false;
@@ -452,7 +496,7 @@ namespace model
     
     bool IsSheenRoughnessTextureEnabled(uint instanceID)
     {
-#ifdef RAY_TRACING
+#if MATERIAL_FEATURES_FROM_TABLE
         return GetMaterialConstant(instanceID).m_sheenRoughnessTexture.m_index != INVALID_RESOURCE_INDEX;
 #else
     #if SHEEN_ROUGHNESS_TEXTURE
@@ -490,7 +534,7 @@ namespace model
     
     bool IsClearCoatTextureEnabled(uint instanceID)
     {
-#ifdef RAY_TRACING
+#if MATERIAL_FEATURES_FROM_TABLE
         return GetMaterialConstant(instanceID).m_clearCoatTexture.m_index != INVALID_RESOURCE_INDEX;
 #else
     #if CLEAR_COAT_TEXTURE
@@ -503,7 +547,7 @@ namespace model
     
     bool IsClearCoatRoughnessCombinedTextureEnabled(uint instanceID)
     {
-#ifdef RAY_TRACING
+#if MATERIAL_FEATURES_FROM_TABLE
         return GetMaterialConstant(instanceID).m_clearCoatTexture.m_index != INVALID_RESOURCE_INDEX &&
             GetMaterialConstant(instanceID).m_clearCoatTexture.m_index == GetMaterialConstant(instanceID).m_clearCoatRoughnessTexture.m_index;
 #else
@@ -517,7 +561,7 @@ namespace model
     
     bool IsClearCoatRoughnessTextureEnabled(uint instanceID)
     {
-#ifdef RAY_TRACING
+#if MATERIAL_FEATURES_FROM_TABLE
         return GetMaterialConstant(instanceID).m_clearCoatRoughnessTexture.m_index != INVALID_RESOURCE_INDEX;
 #else
     #if CLEAR_COAT_ROUGHNESS_TEXTURE
@@ -555,7 +599,7 @@ namespace model
     
     bool IsClearCoatNormalTextureEnabled(uint instanceID)
     {
-#ifdef RAY_TRACING
+#if MATERIAL_FEATURES_FROM_TABLE
         return GetMaterialConstant(instanceID).m_clearCoatNormalTexture.m_index != INVALID_RESOURCE_INDEX;
 #else
     #if CLEAR_COAT_NORMAL_TEXTURE
@@ -568,7 +612,7 @@ namespace model
     
     bool IsRGClearCoatNormalTextureEnabled(uint instanceID)
     {
-#ifdef RAY_TRACING
+#if MATERIAL_FEATURES_FROM_TABLE
         return GetMaterialConstant(instanceID).m_bRGClearCoatNormalTexture;
 #else
     #if RG_CLEAR_COAT_NORMAL_TEXTURE
@@ -602,11 +646,14 @@ namespace model
     {
         float alpha = 1.0;
         ModelMaterialConstant material = GetMaterialConstant(instanceID);
-#if ALBEDO_TEXTURE
-        alpha = SampleMaterialTexture(material.m_albedoTexture, uv, 0).a;
-#elif DIFFUSE_TEXTURE
-        alpha = SampleMaterialTexture(material.m_diffuseTexture, uv, 0).a;
-#endif
+        if (IsAlbedoTextureEnabled(instanceID))
+        {
+            alpha = SampleMaterialTexture(material.m_albedoTexture, uv, 0).a;
+        }
+        else if (IsDiffuseTextureEnabled(instanceID))
+        {
+            alpha = SampleMaterialTexture(material.m_diffuseTexture, uv, 0).a;
+        }
         
         clip(alpha - material.m_alphCutoff);
     }
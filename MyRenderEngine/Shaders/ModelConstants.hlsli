@@ -43,7 +43,8 @@ struct ModelMaterialConstant
     uint m_bDoubleSided;
     
     uint m_bRGClearCoatNormalTexture;
-    uint3 _padding;   
+    uint m_bFrontFaceCCW;       //< Only used by the software rasterizer, the hardware one gets it from the PSO
+    uint2 _padding;   
 };
 
 #ifndef __cplusplus
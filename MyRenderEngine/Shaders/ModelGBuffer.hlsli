@@ -0,0 +1,63 @@
+#pragma once
+#include "Model.hlsli"
+#include "ShadingModel.hlsli"
+
+struct GBufferOutput
+{
+    float4 m_diffuseRT : SV_TARGET0;
+    float4 m_specularRT : SV_TARGET1;
+    float4 m_normalRT : SV_TARGET2;
+    float3 m_emissiveRT : SV_TARGET3;
+    float4 m_customDataRT : SV_TARGET4;
+};
+
+// Material of a surface point in the G-buffer layout, shared by the G-buffer pass and the visibility buffer resolve
+GBufferOutput GetGBufferOutput(uint instanceID, float2 uv, float3 normal, float3 tangent, float3 bitangent, bool bIsFrontFace)
+{
+    ShadingModel shadingModel = (ShadingModel)model::GetMaterialConstant(instanceID).m_shadingModel;
+    
+    model::PBRMetallicRoughness pbrMetallicRoughness = model::GetMaterialMetallicRoughness(instanceID, uv);
+    model::PBRSpecularGlossiness pbrSpecularGlossiness = model::GetMaterialSpecularGlossiness(instanceID, uv);
+    
+    if (model::IsNormalTextureEnabled(instanceID))
+    {
+        normal = model::GetMaterialNormal(instanceID, uv, tangent, bitangent, normal);
+    }
+    
+    if (model::IsDoubleSided(instanceID))
+    {
+        normal *= bIsFrontFace ? 1.0 : -1.0;
+    }
+    float3 anisotropyT = model::GetMaterialAnisotropyTangent(instanceID, uv, tangent, bitangent, normal);
+    float ao = model::GetMaterialAO(instanceID, uv);
+    float3 emissive = model::GetMaterialEmissive(instanceID, uv);
+    
+    float3 diffuse = float3(1, 1, 1);
+    float3 specular = float3(0, 0, 0);
+    float roughness = 1.0;
+    float alpha = 1.0;
+    
+    // Compile time constants in the permutations, branches on the material table in the uber material
+    if (model::IsPBRMetallicRoughness(instanceID))
+    {
+        diffuse = pbrMetallicRoughness.m_albedo * (1.0 - pbrMetallicRoughness.m_metallic);
+        specular = lerp(0.04, pbrMetallicRoughness.m_albedo, pbrMetallicRoughness.m_metallic);
+        roughness = pbrMetallicRoughness.m_roughness;
+        alpha = pbrMetallicRoughness.m_alpha;
+        ao *= pbrMetallicRoughness.m_ao;
+    }
+
+    if (SceneCB.m_showMeshlets)
+    {
+        //uint hash = 
+    }
+    
+    GBufferOutput output;
+    output.m_diffuseRT = float4(diffuse, 1.0);
+    output.m_specularRT = float4(specular, EncodeShadingModel(shadingModel));
+    output.m_normalRT = float4(EncodeNormal(normal), roughness);
+    output.m_emissiveRT = emissive;
+    output.m_customDataRT = float4(0, 0, 0, 0);
+    
+    return output;
+}
\ No newline at end of file
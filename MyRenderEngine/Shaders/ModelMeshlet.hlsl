@@ -25,7 +25,7 @@ void ms_main(
         return;    
     }
     
-    Meshlet meshlet = LoadSceneStaticBuffer<Meshlet>(instanceData.m_meshletBufferAddress, meshletIndex);
+    Meshlet meshlet = LoadMeshlet(instanceData, meshletIndex);
     
     SetMeshOutputCounts(meshlet.m_vertexCount, meshlet.m_triangleCount);
     
@@ -68,7 +68,7 @@ void ms_direct_main(
         return;    
     }
     
-    Meshlet meshlet = LoadSceneStaticBuffer<Meshlet>(instanceData.m_meshletBufferAddress, meshletIndex);
+    Meshlet meshlet = LoadMeshlet(instanceData, meshletIndex);
     SetMeshOutputCounts(meshlet.m_vertexCount, meshlet.m_triangleCount);
     
     if(groupThreadID < meshlet.m_triangleCount)
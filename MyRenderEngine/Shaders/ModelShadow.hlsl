@@ -0,0 +1,110 @@
+#include "Model.hlsli"
+#include "Meshlet.hlsli"
+#include "VirtualShadowMap.hlsli"
+
+cbuffer ShadowConstant : register(b0)
+{
+    uint c_instanceIndex;
+    uint c_meshletCount;
+};
+
+ConstantBuffer<VirtualShadowMapPageConstant> PageCB : register(b1);
+
+struct VertexOutput
+{
+    float4 m_pos : SV_Position;
+    float2 m_uv : TEXCOORD;
+    nointerpolation uint m_instanceIndex : COLOR0;
+};
+
+groupshared MeshletPayload s_Payload;
+
+// Meshlets outside the frustum of the page are culled, the cone and occlusion culling of the base pass don't apply to the light
+[numthreads(32, 1, 1)]
+void as_main(uint3 dispatchThreadID : SV_DispatchThreadID)
+{
+    uint meshletIndex = dispatchThreadID.x;
+
+    bool bIsVisible = false;
+    if (meshletIndex < c_meshletCount)
+    {
+        InstanceData instanceData = GetInstanceData(c_instanceIndex);
+        Meshlet meshlet = LoadMeshlet(instanceData, meshletIndex);
+
+        float3 center = mul(instanceData.m_mtxWorld, float4(meshlet.m_center, 1.0f)).xyz;
+        float radius = meshlet.m_radius * instanceData.m_scale;
+
+        bIsVisible = true;
+        for (uint i = 0; i < 6; ++i)
+        {
+            if (dot(center, PageCB.m_planes[i].xyz) + PageCB.m_planes[i].w + radius < 0)
+            {
+                bIsVisible = false;
+            }
+        }
+
+        if (bIsVisible)
+        {
+            uint index = WavePrefixCountBits(bIsVisible);
+            s_Payload.m_instanceIndices[index] = c_instanceIndex;
+            s_Payload.m_meshletIndices[index] = meshletIndex;
+        }
+    }
+
+    uint visibleMeshletCount = WaveActiveCountBits(bIsVisible);
+    DispatchMesh(visibleMeshletCount, 1, 1, s_Payload);
+}
+
+[numthreads(128, 1, 1)]
+[outputtopology("triangle")]
+void ms_main(
+    uint groupThreadID : SV_GroupThreadID,
+    uint groupID : SV_GroupID,
+    in payload MeshletPayload payload,
+    out indices uint3 indices[124],
+    out vertices VertexOutput vertices[64])
+{
+    uint instanceIndex = payload.m_instanceIndices[groupID];
+    uint meshletIndex = payload.m_meshletIndices[groupID];
+
+    InstanceData instanceData = GetInstanceData(instanceIndex);
+    Meshlet meshlet = LoadMeshlet(instanceData, meshletIndex);
+
+    SetMeshOutputCounts(meshlet.m_vertexCount, meshlet.m_triangleCount);
+
+    if (groupThreadID < meshlet.m_triangleCount)
+    {
+        uint3 index = uint3(
+            LoadSceneStaticBuffer<uint16_t>(instanceData.m_meshletIndicesBufferAddress, meshlet.m_triangleOffset + groupThreadID * 3),
+            LoadSceneStaticBuffer<uint16_t>(instanceData.m_meshletIndicesBufferAddress, meshlet.m_triangleOffset + groupThreadID * 3 + 1),
+            LoadSceneStaticBuffer<uint16_t>(instanceData.m_meshletIndicesBufferAddress, meshlet.m_triangleOffset + groupThreadID * 3 + 2));
+
+        indices[groupThreadID] = index;
+    }
+
+    if (groupThreadID < meshlet.m_vertexCount)
+    {
+        uint vertexID = LoadSceneStaticBuffer<uint>(instanceData.m_meshletVerticesBufferAddress, meshlet.m_vertexOffset + groupThreadID);
+
+        // Only the position and uv are needed
+        float3 pos = instanceData.m_bVertexAnimation ?
+            LoadSceneAnimationBuffer<float3>(instanceData.m_posBufferAddress, vertexID) :
+            LoadSceneStaticBuffer<float3>(instanceData.m_posBufferAddress, vertexID);
+
+        float4 worldPos = mul(instanceData.m_mtxWorld, float4(pos, 1.0));
+
+        VertexOutput v;
+        v.m_pos = mul(PageCB.m_mtxViewProjection, worldPos);
+        v.m_uv = LoadSceneStaticBuffer<float2>(instanceData.m_uvBufferAddress, vertexID);
+        v.m_instanceIndex = instanceIndex;
+
+        vertices[groupThreadID] = v;
+    }
+}
+
+void ps_main(VertexOutput input)
+{
+#if ALPHA_TEST
+    model::AlphaTest(input.m_instanceIndex, input.m_uv);
+#endif
+}
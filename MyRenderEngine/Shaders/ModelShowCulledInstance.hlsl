@@ -50,7 +50,7 @@ void ms_main(uint groupThreadID : SV_GroupThreadID,
         return;
     }
 
-    Meshlet meshlet = LoadSceneStaticBuffer<Meshlet>(instanceData.m_meshletBufferAddress, meshletIndex);
+    Meshlet meshlet = LoadMeshlet(instanceData, meshletIndex);
     SetMeshOutputCounts(meshlet.m_vertexCount, meshlet.m_triangleCount);
     
     if (groupThreadID < meshlet.m_triangleCount)
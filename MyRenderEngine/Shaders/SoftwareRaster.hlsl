@@ -0,0 +1,106 @@
+#include "Model.hlsli"
+#include "Meshlet.hlsli"
+#include "SoftwareRaster.hlsli"
+
+cbuffer SoftwareRasterConstants : register(b0)
+{
+    uint c_visibleMeshletListSRV;
+    uint c_visibleMeshletCounterSRV;
+    uint c_visibilityBufferUAV;
+    uint c_bIsFirstPhase;
+};
+
+groupshared float3 s_screenPos[64];
+
+// The meshlets which MeshletCulling.hlsl found too small for the hardware rasterizer, their pixels are merged into the visibility buffer with 64 bits atomics
+[numthreads(SW_RASTER_GROUP_SIZE, 1, 1)]
+void cs_raster(uint groupThreadID : SV_GroupThreadID, uint groupID : SV_GroupID)
+{
+    StructuredBuffer<uint2> visibleMeshletList = ResourceDescriptorHeap[c_visibleMeshletListSRV];
+    Buffer<uint> visibleMeshletCounter = ResourceDescriptorHeap[c_visibleMeshletCounterSRV];
+
+    uint visibleMeshletCapacity, stride;
+    visibleMeshletList.GetDimensions(visibleMeshletCapacity, stride);
+
+    uint softwareRasterIndex = (c_bIsFirstPhase ? 0 : visibleMeshletCounter[1]) + groupID;
+    uint visibleMeshletIndex = GetSoftwareRasterVisibleMeshlet(visibleMeshletCapacity, softwareRasterIndex);
+    uint2 visibleMeshlet = visibleMeshletList[visibleMeshletIndex];
+    uint instanceIndex = visibleMeshlet.x;
+
+    InstanceData instanceData = GetInstanceData(instanceIndex);
+    Meshlet meshlet = LoadMeshlet(instanceData, visibleMeshlet.y);
+
+    if (groupThreadID < meshlet.m_vertexCount)
+    {
+        uint vertexID = LoadSceneStaticBuffer<uint>(instanceData.m_meshletVerticesBufferAddress, meshlet.m_vertexOffset + groupThreadID);
+
+        float3 pos = instanceData.m_bVertexAnimation ?
+            LoadSceneAnimationBuffer<float3>(instanceData.m_posBufferAddress, vertexID) :
+            LoadSceneStaticBuffer<float3>(instanceData.m_posBufferAddress, vertexID);
+
+        float4 clipPos = mul(GetCameraCB().m_mtxViewProjection, mul(instanceData.m_mtxWorld, float4(pos, 1.0)));
+        s_screenPos[groupThreadID] = ClipToScreen(clipPos, (float2) SceneCB.m_renderSize);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (groupThreadID >= meshlet.m_triangleCount)
+    {
+        return;
+    }
+
+    uint3 index = uint3(
+        LoadSceneStaticBuffer<uint16_t>(instanceData.m_meshletIndicesBufferAddress, meshlet.m_triangleOffset + groupThreadID * 3),
+        LoadSceneStaticBuffer<uint16_t>(instanceData.m_meshletIndicesBufferAddress, meshlet.m_triangleOffset + groupThreadID * 3 + 1),
+        LoadSceneStaticBuffer<uint16_t>(instanceData.m_meshletIndicesBufferAddress, meshlet.m_triangleOffset + groupThreadID * 3 + 2));
+
+    // The cull mode and the winding are PSO states of the hardware path
+    ModelMaterialConstant material = model::GetMaterialConstant(instanceIndex);
+    RasterTriangle tri = SetupRasterTriangle(s_screenPos[index.x], s_screenPos[index.y], s_screenPos[index.z], SceneCB.m_renderSize, material.m_bDoubleSided, material.m_bFrontFaceCCW);
+    if (!tri.m_bVisible)
+    {
+        return;
+    }
+
+    uint visibilityID = PackVisibilityID(visibleMeshletIndex, groupThreadID) | (tri.m_bFrontFace ? VISIBILITY_BUFFER_FRONT_FACE_BIT : 0);
+
+    RWTexture2D<uint64_t> visibilityBuffer = ResourceDescriptorHeap[c_visibilityBufferUAV];
+    for (int y = tri.m_minPixel.y; y <= tri.m_maxPixel.y; ++y)
+    {
+        for (int x = tri.m_minPixel.x; x <= tri.m_maxPixel.x; ++x)
+        {
+            float depth;
+            if (RasterizePixel(tri, int2(x, y), depth))
+            {
+                InterlockedMax(visibilityBuffer[uint2(x, y)], PackVisibilityTexel(visibilityID, depth));
+            }
+        }
+    }
+}
+
+cbuffer BuildCommandConstants : register(b0)
+{
+    uint c_counterSRV;
+    uint c_commandUAV;
+    uint c_bIsFirstPhaseCommand;
+};
+
+[numthreads(1, 1, 1)]
+void cs_build_command()
+{
+    Buffer<uint> visibleMeshletCounter = ResourceDescriptorHeap[c_counterSRV];
+    RWStructuredBuffer<uint3> commandBuffer = ResourceDescriptorHeap[c_commandUAV];
+
+    commandBuffer[0] = uint3(visibleMeshletCounter[c_bIsFirstPhaseCommand ? 1 : 2], 1, 1);
+}
+
+cbuffer DepthMergeConstants : register(b0)
+{
+    uint c_visibilityBufferSRV;
+};
+
+// The depth buffer gets the software rasterized pixels for the HZB and the lighting passes, the visibility buffer depth is never behind it
+float ps_depth_merge(float4 pos : SV_Position) : SV_Depth
+{
+    Texture2D<uint2> visibilityBuffer = ResourceDescriptorHeap[c_visibilityBufferSRV];
+    return asfloat(visibilityBuffer[uint2(pos.xy)].y);
+}
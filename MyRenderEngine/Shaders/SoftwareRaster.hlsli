@@ -0,0 +1,114 @@
+#pragma once
+#include "VisibilityBuffer.hlsli"
+
+#define SW_RASTER_MAX_MESHLET_PIXELS 32         //< Meshlets with smaller screen bounds are rasterized by SoftwareRaster.hlsl
+#define SW_RASTER_SUBPIXEL_BITS 8               //< Vertices are snapped to 1/256 pixel as the hardware does
+#define SW_RASTER_SUBPIXEL_SCALE (1 << SW_RASTER_SUBPIXEL_BITS)
+#define SW_RASTER_GROUP_SIZE 128                //< One group per meshlet, one thread per triangle
+
+// The software rasterized meshlets are added to the end of the visible meshlet list and grow backwards, the hardware ones grow from the start.
+// The visible meshlet counter has the hardware count in [0] and the software count of the two phases in [1] and [2]
+
+#ifndef __cplusplus
+
+uint GetSoftwareRasterVisibleMeshlet(uint visibleMeshletCapacity, uint softwareRasterIndex)
+{
+    return visibleMeshletCapacity - 1 - softwareRasterIndex;
+}
+
+// aabb is the uv rect of ProjectSphere
+bool IsSoftwareRasterMeshlet(float4 aabb, float2 renderSize)
+{
+    float2 size = (aabb.zw - aabb.xy) * renderSize;
+    return max(size.x, size.y) <= SW_RASTER_MAX_MESHLET_PIXELS;
+}
+
+// Closer depth wins InterlockedMax with reversed z, the ID is the low half as uint2(ID, depth) of the RG32UI texel
+uint64_t PackVisibilityTexel(uint visibilityID, float depth)
+{
+    return ((uint64_t) asuint(depth) << 32) | visibilityID;
+}
+
+// xy in pixels, z is the depth
+float3 ClipToScreen(float4 clipPos, float2 renderSize)
+{
+    float3 ndc = clipPos.xyz / clipPos.w;
+    return float3((ndc.xy * float2(0.5, -0.5) + 0.5) * renderSize, ndc.z);
+}
+
+struct RasterTriangle
+{
+    int2 m_v0;              //< Fixed point pixel positions, clockwise on the screen
+    int2 m_v1;
+    int2 m_v2;
+    float3 m_depth;
+    float m_rcpArea;
+    int3 m_bias;            //< Top-left rule, pixel centers on an edge are only covered by top and left edges
+    int2 m_minPixel;
+    int2 m_maxPixel;
+    bool m_bVisible;
+    bool m_bFrontFace;
+};
+
+int EdgeFunction(int2 a, int2 b, int2 p)
+{
+    return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+}
+
+int GetEdgeBias(int2 a, int2 b)
+{
+    int2 edge = b - a;
+    bool bTopLeft = edge.y < 0 || (edge.y == 0 && edge.x > 0);
+    return bTopLeft ? 0 : -1;
+}
+
+// Same coverage as the hardware rasterizer : 8 bits subpixel snapping, pixel center sampling and the top-left rule.
+// Vertices have to be in front of the near plane, so the meshlets crossing it stay on the hardware path
+RasterTriangle SetupRasterTriangle(float3 p0, float3 p1, float3 p2, uint2 renderSize, bool bDoubleSided, bool bFrontFaceCCW)
+{
+    RasterTriangle tri;
+    tri.m_v0 = int2(floor(p0.xy * SW_RASTER_SUBPIXEL_SCALE + 0.5));
+    tri.m_v1 = int2(floor(p1.xy * SW_RASTER_SUBPIXEL_SCALE + 0.5));
+    tri.m_v2 = int2(floor(p2.xy * SW_RASTER_SUBPIXEL_SCALE + 0.5));
+    tri.m_depth = float3(p0.z, p1.z, p2.z);
+
+    // Positive area is clockwise on the screen, y is down
+    int area = EdgeFunction(tri.m_v0, tri.m_v1, tri.m_v2);
+    tri.m_bFrontFace = bFrontFaceCCW ? area < 0 : area > 0;
+    tri.m_bVisible = area != 0 && (bDoubleSided || tri.m_bFrontFace);
+
+    if (area < 0)
+    {
+        int2 v = tri.m_v1;
+        tri.m_v1 = tri.m_v2;
+        tri.m_v2 = v;
+        tri.m_depth = tri.m_depth.xzy;
+        area = -area;
+    }
+    tri.m_rcpArea = 1.0 / (float) area;
+
+    tri.m_bias = int3(GetEdgeBias(tri.m_v1, tri.m_v2), GetEdgeBias(tri.m_v2, tri.m_v0), GetEdgeBias(tri.m_v0, tri.m_v1));
+
+    // Pixels whose center is in the bounds
+    int2 minPos = min(tri.m_v0, min(tri.m_v1, tri.m_v2));
+    int2 maxPos = max(tri.m_v0, max(tri.m_v1, tri.m_v2));
+    const int halfPixel = SW_RASTER_SUBPIXEL_SCALE / 2;
+    tri.m_minPixel = max((minPos - halfPixel + SW_RASTER_SUBPIXEL_SCALE - 1) >> SW_RASTER_SUBPIXEL_BITS, 0);
+    tri.m_maxPixel = min((maxPos - halfPixel) >> SW_RASTER_SUBPIXEL_BITS, int2(renderSize) - 1);
+
+    // Bounds the loop of a thread if a triangle is larger than its meshlet bounds
+    tri.m_maxPixel = min(tri.m_maxPixel, tri.m_minPixel + SW_RASTER_MAX_MESHLET_PIXELS);
+    return tri;
+}
+
+bool RasterizePixel(RasterTriangle tri, int2 pixel, out float depth)
+{
+    int2 center = pixel * SW_RASTER_SUBPIXEL_SCALE + SW_RASTER_SUBPIXEL_SCALE / 2;
+    int3 w = int3(EdgeFunction(tri.m_v1, tri.m_v2, center), EdgeFunction(tri.m_v2, tri.m_v0, center), EdgeFunction(tri.m_v0, tri.m_v1, center));
+
+    // z/w is linear in screen space
+    depth = dot(float3(w), tri.m_depth) * tri.m_rcpArea;
+    return all(w + tri.m_bias >= 0);
+}
+
+#endif // __cplusplus
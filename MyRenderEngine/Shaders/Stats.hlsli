@@ -24,6 +24,9 @@
 #define STATS_2ND_PHASE_CULLED_TRIANGLE 14
 #define STATS_2ND_PHASE_RENDERED_TRIANGLE 15
 
+#define STATS_1ST_PHASE_SOFTWARE_RASTER_MESHLET 16   //< Part of the rendered meshlets
+#define STATS_2ND_PHASE_SOFTWARE_RASTER_MESHLET 17
+
 #define STATS_MAX_TYPE_COUNT 1024
 
 #ifndef __cplusplus
@@ -0,0 +1,108 @@
+#include "GPUScene.hlsli"
+#include "Meshlet.hlsli"
+
+#define INVALID_ADDRESS 0xFFFFFFFF
+#define FLOAT_MAX 3.402823466e+38
+
+// 12 uints don't fit the root constants, passed as a root CBV
+cbuffer SkinningConstants : register(b1)
+{
+    uint c_meshletBufferAddress;            //< Scene static buffer
+    uint c_meshletVerticesBufferAddress;
+    uint c_paletteAddress;                  //< Scene constant buffer
+    uint c_posBufferAddress;
+
+    uint c_normalBufferAddress;
+    uint c_tangentBufferAddress;
+    uint c_jointBufferAddress;              //< 4 uint16 per vertex
+    uint c_weightBufferAddress;
+
+    uint c_animPosBufferAddress;            //< Scene animation buffer
+    uint c_animNormalBufferAddress;
+    uint c_animTangentBufferAddress;
+    uint c_animMeshletBufferAddress;
+};
+
+groupshared float3 s_boundsMin[64];
+groupshared float3 s_boundsMax[64];
+groupshared float s_radiusSq[64];
+
+float4x4 LoadPalette(uint joint)
+{
+    return LoadSceneConstantBuffer<float4x4>(c_paletteAddress + sizeof(float4x4) * joint);
+}
+
+// One group per meshlet, so the meshlet bounds are refreshed from the skinned positions in the same pass.
+// Vertices shared by meshlets are skinned by each of them to the same value
+[numthreads(64, 1, 1)]  //< Have to match the max vertices of the meshlets
+void main(uint groupThreadID : SV_GroupThreadID, uint groupID : SV_GroupID)
+{
+    Meshlet meshlet = LoadSceneStaticBuffer<Meshlet>(c_meshletBufferAddress, groupID);
+    bool bValid = groupThreadID < meshlet.m_vertexCount;
+
+    float3 pos = float3(0.0, 0.0, 0.0);
+    if (bValid)
+    {
+        uint vertexID = LoadSceneStaticBuffer<uint>(c_meshletVerticesBufferAddress, meshlet.m_vertexOffset + groupThreadID);
+
+        uint2 packedJoints = LoadSceneStaticBuffer<uint2>(c_jointBufferAddress, vertexID);
+        uint4 joints = uint4(packedJoints.x & 0xFFFF, packedJoints.x >> 16, packedJoints.y & 0xFFFF, packedJoints.y >> 16);
+        float4 weights = LoadSceneStaticBuffer<float4>(c_weightBufferAddress, vertexID);
+
+        float4x4 mtxSkin = LoadPalette(joints.x) * weights.x + LoadPalette(joints.y) * weights.y +
+            LoadPalette(joints.z) * weights.z + LoadPalette(joints.w) * weights.w;
+
+        pos = mul(mtxSkin, float4(LoadSceneStaticBuffer<float3>(c_posBufferAddress, vertexID), 1.0)).xyz;
+        StoreScenceAnimationBuffer<float3>(c_animPosBufferAddress, vertexID, pos);
+
+        // Palettes without non uniform scale, the normal doesn't need the inverse transpose
+        if (c_normalBufferAddress != INVALID_ADDRESS)
+        {
+            float3 normal = LoadSceneStaticBuffer<float3>(c_normalBufferAddress, vertexID);
+            StoreScenceAnimationBuffer<float3>(c_animNormalBufferAddress, vertexID, normalize(mul(mtxSkin, float4(normal, 0.0)).xyz));
+        }
+
+        if (c_tangentBufferAddress != INVALID_ADDRESS)
+        {
+            float4 tangent = LoadSceneStaticBuffer<float4>(c_tangentBufferAddress, vertexID);
+            tangent.xyz = normalize(mul(mtxSkin, float4(tangent.xyz, 0.0)).xyz);
+            StoreScenceAnimationBuffer<float4>(c_animTangentBufferAddress, vertexID, tangent);
+        }
+    }
+
+    s_boundsMin[groupThreadID] = bValid ? pos : FLOAT_MAX;
+    s_boundsMax[groupThreadID] = bValid ? pos : -FLOAT_MAX;
+    GroupMemoryBarrierWithGroupSync();
+
+    for (uint s = 32; s > 0; s >>= 1)
+    {
+        if (groupThreadID < s)
+        {
+            s_boundsMin[groupThreadID] = min(s_boundsMin[groupThreadID], s_boundsMin[groupThreadID + s]);
+            s_boundsMax[groupThreadID] = max(s_boundsMax[groupThreadID], s_boundsMax[groupThreadID + s]);
+        }
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    float3 center = (s_boundsMin[0] + s_boundsMax[0]) * 0.5;
+    float3 offset = pos - center;
+    s_radiusSq[groupThreadID] = bValid ? dot(offset, offset) : 0.0;
+    GroupMemoryBarrierWithGroupSync();
+
+    for (uint s = 32; s > 0; s >>= 1)
+    {
+        if (groupThreadID < s)
+        {
+            s_radiusSq[groupThreadID] = max(s_radiusSq[groupThreadID], s_radiusSq[groupThreadID + s]);
+        }
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    if (groupThreadID == 0)
+    {
+        meshlet.m_center = center;
+        meshlet.m_radius = sqrt(s_radiusSq[0]);
+        meshlet.m_cone = 0x7F000000;    //< Cutoff 1, the cone of the bind pose doesn't hold anymore, never back face culled
+        StoreScenceAnimationBuffer<Meshlet>(c_animMeshletBufferAddress, groupID, meshlet);
+    }
+}
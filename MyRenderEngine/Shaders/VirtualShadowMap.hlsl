@@ -0,0 +1,101 @@
+#include "Common.hlsli"
+#include "VirtualShadowMap.hlsli"
+
+cbuffer VirtualShadowMapConstant : register(b0)
+{
+    uint c_depthSRV;
+    uint c_outputUAV;
+};
+
+// Full screen triangle at the far plane, the viewport is the rendered page
+float4 vs_clear_page(uint vertexID : SV_VertexID) : SV_Position
+{
+    float4 pos;
+    pos.x = (float) (vertexID / 2) * 4.0 - 1.0;
+    pos.y = (float) (vertexID % 2) * 4.0 - 1.0;
+    pos.z = 0.0;
+    pos.w = 1.0;
+    return pos;
+}
+
+// Pages seen by the depth buffer are requested, in the layout of the page table. They are read back and allocated on CPU
+[numthreads(8, 8, 1)]
+void cs_mark_pages(uint3 dispatchThreadID : SV_DispatchThreadID)
+{
+    if (any(dispatchThreadID.xy >= SceneCB.m_renderSize))
+    {
+        return;
+    }
+
+    Texture2D<float> depthTexture = ResourceDescriptorHeap[c_depthSRV];
+    float depth = depthTexture[dispatchThreadID.xy];
+    if (depth == 0.0)
+    {
+        return;     //< Sky
+    }
+
+    RWBuffer<uint> requestBuffer = ResourceDescriptorHeap[c_outputUAV];
+    float3 worldPos = GetWorldPosition(dispatchThreadID.xy, depth);
+    VirtualShadowMapData data = GetVirtualShadowMapData();
+
+    if (data.m_bDirectionalLight)
+    {
+        for (uint level = GetClipmapLevel(worldPos); level < VSM_CLIPMAP_LEVELS; ++level)
+        {
+            VirtualShadowMapView view = GetVirtualShadowMapView(data, level);
+
+            uint entry;
+            if (GetPageTableEntry(view, GetPagePosition(view, worldPos), entry))
+            {
+                requestBuffer[entry] = 1;
+                break;
+            }
+        }
+    }
+
+    for (uint slot = 0; slot < data.m_localLightCount; ++slot)
+    {
+        uint lightIndex = GetLocalLightSlotIndex(data, slot);
+        if (lightIndex == VSM_INVALID_LIGHT)
+        {
+            continue;
+        }
+
+        LocalLightData light = GetLocalLightData(lightIndex);
+
+        float3 direction = worldPos - light.m_position;
+        if (dot(direction, direction) < light.m_radius * light.m_radius)
+        {
+            VirtualShadowMapView view = GetVirtualShadowMapView(data, VSM_CLIPMAP_LEVELS + slot * 6 + GetCubeFace(direction));
+
+            uint entry;
+            if (GetPageTableEntry(view, GetPagePosition(view, worldPos), entry))
+            {
+                requestBuffer[entry] = 1;
+            }
+        }
+    }
+}
+
+// Visibility of the primary directional light, 1 : lit
+[numthreads(8, 8, 1)]
+void cs_shadow_mask(uint3 dispatchThreadID : SV_DispatchThreadID)
+{
+    if (any(dispatchThreadID.xy >= SceneCB.m_renderSize))
+    {
+        return;
+    }
+
+    Texture2D<float> depthTexture = ResourceDescriptorHeap[c_depthSRV];
+    RWTexture2D<unorm float> outputTexture = ResourceDescriptorHeap[c_outputUAV];
+
+    float depth = depthTexture[dispatchThreadID.xy];
+    if (depth == 0.0)
+    {
+        outputTexture[dispatchThreadID.xy] = 1.0;
+        return;
+    }
+
+    float3 worldPos = GetWorldPosition(dispatchThreadID.xy, depth);
+    outputTexture[dispatchThreadID.xy] = GetDirectionalShadow(worldPos);
+}
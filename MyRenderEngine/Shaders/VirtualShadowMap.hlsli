@@ -0,0 +1,182 @@
+#pragma once
+#include "GPUScene.hlsli"
+
+#define VSM_PAGE_SIZE 128                   //< Texels per side of a page
+#define VSM_LEVEL_PAGES 32                  //< Pages per side of the resident window of a clipmap level
+#define VSM_CLIPMAP_LEVELS 8
+#define VSM_CLIPMAP_BASE_EXTENT 8.0f        //< World size of the window of the finest level, doubled per level
+#define VSM_DIRECTIONAL_DEPTH_RANGE 1000.0f //< Clipmap depth covers the world within this distance of the origin along the light
+#define VSM_LOCAL_LIGHT_PAGES 8             //< Pages per side of a cube face of a local light
+#define VSM_LOCAL_LIGHT_NEAR 0.05f
+#define VSM_MAX_LOCAL_LIGHTS 16
+#define VSM_POOL_PAGES 32                   //< Physical pages per side of the pool texture
+#define VSM_MAX_VIEWS (VSM_CLIPMAP_LEVELS + VSM_MAX_LOCAL_LIGHTS * 6)
+#define VSM_LOCAL_LIGHT_PAGE_TABLE_OFFSET (VSM_CLIPMAP_LEVELS * VSM_LEVEL_PAGES * VSM_LEVEL_PAGES)
+#define VSM_PAGE_TABLE_SIZE (VSM_LOCAL_LIGHT_PAGE_TABLE_OFFSET + VSM_MAX_LOCAL_LIGHTS * 6 * VSM_LOCAL_LIGHT_PAGES * VSM_LOCAL_LIGHT_PAGES)
+#define VSM_INVALID_PAGE 0xFFFFFFFF
+#define VSM_INVALID_LIGHT 0xFFFFFFFF          //< Light slots not in use
+
+// Views 0 ~ VSM_CLIPMAP_LEVELS - 1 are the clipmap levels of the primary directional light,
+// the cube faces of the shadowed local lights follow them, 6 views per light slot
+struct VirtualShadowMapView
+{
+    float4x4 m_mtxPage;         //< World to page units of the view, xy / w : page coordinate, z / w : depth
+    int2 m_pageOrigin;          //< Page of the first page table entry, clipmap windows follow the camera
+    uint m_pageTableOffset;
+    uint m_pageCount;           //< Pages per side of the page table of the view
+};
+
+struct VirtualShadowMapData
+{
+    uint m_pageTableAddress;    //< Physical page per virtual page, in the scene constant buffer
+    uint m_viewAddress;
+    uint m_physicalPagesSRV;
+    uint m_bDirectionalLight;
+
+    uint m_localLightCount;     //< Light slots in use
+    uint3 _padding;
+
+    uint4 m_localLightIndices[VSM_MAX_LOCAL_LIGHTS / 4];   //< Local light of each slot
+};
+
+// Root constant buffer of the shadow meshlet passes, one per rendered page
+struct VirtualShadowMapPageConstant
+{
+    float4x4 m_mtxViewProjection;   //< World to the clip space of the page
+    float4 m_planes[6];
+};
+
+#ifndef __cplusplus
+
+VirtualShadowMapData GetVirtualShadowMapData()
+{
+    return LoadSceneConstantBuffer<VirtualShadowMapData>(SceneCB.m_virtualShadowMapDataAddress);
+}
+
+VirtualShadowMapView GetVirtualShadowMapView(VirtualShadowMapData data, uint view)
+{
+    return LoadSceneConstantBuffer<VirtualShadowMapView>(data.m_viewAddress + sizeof(VirtualShadowMapView) * view);
+}
+
+uint GetLocalLightSlotIndex(VirtualShadowMapData data, uint slot)
+{
+    return data.m_localLightIndices[slot / 4][slot % 4];
+}
+
+// Finest level whose window contains the position, windows are centered at the camera
+uint GetClipmapLevel(float3 worldPos)
+{
+    float distance = length(worldPos - GetCameraCB().m_cameraPos);
+    float level = ceil(log2(max(distance * 2.0f / VSM_CLIPMAP_BASE_EXTENT, 1.0f)));
+    return (uint) min(level, VSM_CLIPMAP_LEVELS - 1);
+}
+
+// +X, -X, +Y, -Y, +Z, -Z by the major axis of the direction from the light
+uint GetCubeFace(float3 direction)
+{
+    float3 a = abs(direction);
+    if (a.x >= a.y && a.x >= a.z)
+    {
+        return direction.x > 0.0f ? 0 : 1;
+    }
+    if (a.y >= a.z)
+    {
+        return direction.y > 0.0f ? 2 : 3;
+    }
+    return direction.z > 0.0f ? 4 : 5;
+}
+
+float3 GetPagePosition(VirtualShadowMapView view, float3 worldPos)
+{
+    float4 pos = mul(view.m_mtxPage, float4(worldPos, 1.0f));
+    return pos.xyz / pos.w;
+}
+
+// Page table entry of the position, false if it is outside the page table of the view
+bool GetPageTableEntry(VirtualShadowMapView view, float3 pagePos, out uint entry)
+{
+    int2 page = int2(floor(pagePos.xy)) - view.m_pageOrigin;
+    entry = view.m_pageTableOffset + page.y * view.m_pageCount + page.x;
+    return all(page >= 0) && all(page < (int2) view.m_pageCount);
+}
+
+uint GetPhysicalPage(VirtualShadowMapData data, uint entry)
+{
+    return LoadSceneConstantBuffer<uint>(data.m_pageTableAddress + sizeof(uint) * entry);
+}
+
+// 1 : lit, 0 : shadowed, bias is in depth units
+float SamplePhysicalPage(VirtualShadowMapData data, uint physicalPage, float3 pagePos, float bias)
+{
+    Texture2D<float> physicalPages = ResourceDescriptorHeap[data.m_physicalPagesSRV];
+
+    uint2 pageTexel = uint2(physicalPage % VSM_POOL_PAGES, physicalPage / VSM_POOL_PAGES) * VSM_PAGE_SIZE;
+    uint2 texel = pageTexel + min((uint2) (frac(pagePos.xy) * VSM_PAGE_SIZE), VSM_PAGE_SIZE - 1);
+
+    float occluderDepth = physicalPages[texel];
+    return pagePos.z + bias >= occluderDepth ? 1.0f : 0.0f;     //< Reversed z, larger is closer to the light
+}
+
+// Pages which are not rendered yet fall back to the coarser levels, lit if none of them is resident
+float GetDirectionalShadow(float3 worldPos)
+{
+    VirtualShadowMapData data = GetVirtualShadowMapData();
+    if (!data.m_bDirectionalLight)
+    {
+        return 1.0f;
+    }
+
+    for (uint level = GetClipmapLevel(worldPos); level < VSM_CLIPMAP_LEVELS; ++level)
+    {
+        VirtualShadowMapView view = GetVirtualShadowMapView(data, level);
+        float3 pagePos = GetPagePosition(view, worldPos);
+
+        uint entry;
+        if (GetPageTableEntry(view, pagePos, entry))
+        {
+            uint physicalPage = GetPhysicalPage(data, entry);
+            if (physicalPage != VSM_INVALID_PAGE)
+            {
+                // A texel of the level in depth units
+                float bias = 2.0f * (VSM_CLIPMAP_BASE_EXTENT * (1u << level) / (VSM_LEVEL_PAGES * VSM_PAGE_SIZE)) / (2.0f * VSM_DIRECTIONAL_DEPTH_RANGE);
+                return SamplePhysicalPage(data, physicalPage, pagePos, bias);
+            }
+        }
+    }
+
+    return 1.0f;
+}
+
+float GetLocalLightShadow(uint lightIndex, float3 worldPos)
+{
+    VirtualShadowMapData data = GetVirtualShadowMapData();
+
+    for (uint slot = 0; slot < data.m_localLightCount; ++slot)
+    {
+        if (GetLocalLightSlotIndex(data, slot) != lightIndex)
+        {
+            continue;
+        }
+
+        LocalLightData light = GetLocalLightData(lightIndex);
+        uint face = GetCubeFace(worldPos - light.m_position);
+
+        VirtualShadowMapView view = GetVirtualShadowMapView(data, VSM_CLIPMAP_LEVELS + slot * 6 + face);
+        float3 pagePos = GetPagePosition(view, worldPos);
+
+        uint entry;
+        if (GetPageTableEntry(view, pagePos, entry))
+        {
+            uint physicalPage = GetPhysicalPage(data, entry);
+            if (physicalPage != VSM_INVALID_PAGE)
+            {
+                return SamplePhysicalPage(data, physicalPage, pagePos, pagePos.z * 0.01f);
+            }
+        }
+        return 1.0f;
+    }
+
+    return 1.0f;    //< Lights without a slot are not shadowed
+}
+
+#endif // __cplusplus
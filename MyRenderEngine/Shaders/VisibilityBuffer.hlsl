@@ -0,0 +1,75 @@
+#include "Model.hlsli"
+#include "Meshlet.hlsli"
+#include "VisibilityBuffer.hlsli"
+
+struct VertexOutput
+{
+    float4 m_pos : SV_Position;
+    float2 m_uv : TEXCOORD;
+    nointerpolation uint m_instanceIndex : COLOR0;
+};
+
+struct PrimitiveOutput
+{
+    uint m_visibilityID : VISIBILITY_ID;
+};
+
+// Only the position and the uv of alpha test are output, the other attributes are reconstructed by VisibilityBufferResolve.hlsl
+[numthreads(128, 1, 1)]
+[outputtopology("triangle")]
+void ms_main(
+    uint groupThreadID : SV_GroupThreadID,
+    uint groupID : SV_GroupID,
+    in payload MeshletPayload payload,
+    out indices uint3 indices[124],
+    out primitives PrimitiveOutput primitives[124],
+    out vertices VertexOutput vertices[64])
+{
+    uint instanceIndex = payload.m_instanceIndices[groupID];
+    uint meshletIndex = payload.m_meshletIndices[groupID];
+    uint visibleMeshletIndex = payload.m_firstVisibleMeshlet + groupID;
+
+    InstanceData instanceData = GetInstanceData(instanceIndex);
+    Meshlet meshlet = LoadMeshlet(instanceData, meshletIndex);
+
+    SetMeshOutputCounts(meshlet.m_vertexCount, meshlet.m_triangleCount);
+
+    if (groupThreadID < meshlet.m_triangleCount)
+    {
+        uint3 index = uint3(
+            LoadSceneStaticBuffer<uint16_t>(instanceData.m_meshletIndicesBufferAddress, meshlet.m_triangleOffset + groupThreadID * 3),
+            LoadSceneStaticBuffer<uint16_t>(instanceData.m_meshletIndicesBufferAddress, meshlet.m_triangleOffset + groupThreadID * 3 + 1),
+            LoadSceneStaticBuffer<uint16_t>(instanceData.m_meshletIndicesBufferAddress, meshlet.m_triangleOffset + groupThreadID * 3 + 2));
+
+        indices[groupThreadID] = index;
+        primitives[groupThreadID].m_visibilityID = PackVisibilityID(visibleMeshletIndex, groupThreadID);
+    }
+
+    if (groupThreadID < meshlet.m_vertexCount)
+    {
+        uint vertexID = LoadSceneStaticBuffer<uint>(instanceData.m_meshletVerticesBufferAddress, meshlet.m_vertexOffset + groupThreadID);
+
+        float3 pos = instanceData.m_bVertexAnimation ?
+            LoadSceneAnimationBuffer<float3>(instanceData.m_posBufferAddress, vertexID) :
+            LoadSceneStaticBuffer<float3>(instanceData.m_posBufferAddress, vertexID);
+
+        float4 worldPos = mul(instanceData.m_mtxWorld, float4(pos, 1.0));
+
+        VertexOutput v;
+        v.m_pos = mul(GetCameraCB().m_mtxViewProjection, worldPos);
+        v.m_uv = LoadSceneStaticBuffer<float2>(instanceData.m_uvBufferAddress, vertexID);
+        v.m_instanceIndex = instanceIndex;
+
+        vertices[groupThreadID] = v;
+    }
+}
+
+uint2 ps_main(VertexOutput input, PrimitiveOutput primitive, bool isFrontFace : SV_IsFrontFace) : SV_Target0
+{
+#if ALPHA_TEST
+    model::AlphaTest(input.m_instanceIndex, input.m_uv);
+#endif
+
+    uint visibilityID = primitive.m_visibilityID | (isFrontFace ? VISIBILITY_BUFFER_FRONT_FACE_BIT : 0);
+    return uint2(visibilityID, asuint(input.m_pos.z));
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "GPUScene.hlsli"
+
+#define VISIBILITY_BUFFER_TRIANGLE_BITS 7           //< 124 triangles per meshlet, has to match the mesh optimizer setting
+#define VISIBILITY_BUFFER_TRIANGLE_MASK ((1u << VISIBILITY_BUFFER_TRIANGLE_BITS) - 1)
+#define VISIBILITY_BUFFER_FRONT_FACE_BIT (1u << VISIBILITY_BUFFER_TRIANGLE_BITS)   //< Set by the pixel shader, the winding of a material is a PSO state
+#define VISIBILITY_BUFFER_MESHLET_SHIFT (VISIBILITY_BUFFER_TRIANGLE_BITS + 1)
+#define VISIBILITY_BUFFER_BIN_COUNT 8192            //< One bin per material table entry
+#define VISIBILITY_BUFFER_BIN_GROUP_SIZE 1024       //< Threads of the bin prefix sum, each of them sums VISIBILITY_BUFFER_BIN_COUNT / 1024 bins
+#define VISIBILITY_BUFFER_RESOLVE_GROUP_SIZE 64
+
+// A texel of the visibility buffer is uint2(visibility ID, asuint(depth)), so the depth is the high half when it is read as a uint64.
+// The visibility ID is the index in the visible meshlet list of the frame, the facing and the triangle in the meshlet. 0 depth is the sky
+
+#ifndef __cplusplus
+
+uint PackVisibilityID(uint visibleMeshletIndex, uint triangleIndex)
+{
+    return (visibleMeshletIndex << VISIBILITY_BUFFER_MESHLET_SHIFT) | triangleIndex;
+}
+
+void UnpackVisibilityID(uint id, out uint visibleMeshletIndex, out uint triangleIndex, out bool bFrontFace)
+{
+    visibleMeshletIndex = id >> VISIBILITY_BUFFER_MESHLET_SHIFT;
+    triangleIndex = id & VISIBILITY_BUFFER_TRIANGLE_MASK;
+    bFrontFace = (id & VISIBILITY_BUFFER_FRONT_FACE_BIT) != 0;
+}
+
+// Screen positions of the material bins, the render size is under 64K
+uint PackPixelPosition(uint2 pos)
+{
+    return pos.x | (pos.y << 16);
+}
+
+uint2 UnpackPixelPosition(uint packed)
+{
+    return uint2(packed & 0xFFFF, packed >> 16);
+}
+
+struct Barycentrics
+{
+    float3 m_lambda;    //< Perspective correct weights of the 3 vertices
+    float3 m_ddx;       //< Change of the weights to the next pixel in x
+    float3 m_ddy;
+};
+
+// Weights and their screen space derivatives of a pixel in a triangle, from the clip positions of its vertices.
+// "The Filtered and Culled Visibility Buffer", Wolfgang Engel. 2016
+Barycentrics ComputeBarycentrics(float4 clipPos0, float4 clipPos1, float4 clipPos2, float2 ndcPos, float2 renderSize)
+{
+    float3 invW = rcp(float3(clipPos0.w, clipPos1.w, clipPos2.w));
+
+    float2 ndc0 = clipPos0.xy * invW.x;
+    float2 ndc1 = clipPos1.xy * invW.y;
+    float2 ndc2 = clipPos2.xy * invW.z;
+
+    // Derivatives of the weights divided by w in ndc space, they are linear in screen space
+    float2 edge0 = ndc2 - ndc1;
+    float2 edge1 = ndc0 - ndc1;
+    float invDet = rcp(edge0.x * edge1.y - edge0.y * edge1.x);
+    float3 ddxOverW = float3(ndc1.y - ndc2.y, ndc2.y - ndc0.y, ndc0.y - ndc1.y) * invDet * invW;
+    float3 ddyOverW = float3(ndc2.x - ndc1.x, ndc0.x - ndc2.x, ndc1.x - ndc0.x) * invDet * invW;
+    float ddxInvW = dot(ddxOverW, float3(1.0, 1.0, 1.0));
+    float ddyInvW = dot(ddyOverW, float3(1.0, 1.0, 1.0));
+
+    float2 delta = ndcPos - ndc0;
+    float interpInvW = invW.x + delta.x * ddxInvW + delta.y * ddyInvW;
+    float interpW = rcp(interpInvW);
+
+    Barycentrics result;
+    result.m_lambda = interpW * (float3(invW.x, 0.0, 0.0) + delta.x * ddxOverW + delta.y * ddyOverW);
+
+    // One pixel step in ndc, y of the screen is down
+    float2 pixelSize = 2.0 / renderSize;
+    ddxOverW *= pixelSize.x;
+    ddyOverW *= -pixelSize.y;
+    ddxInvW *= pixelSize.x;
+    ddyInvW *= -pixelSize.y;
+
+    result.m_ddx = rcp(interpInvW + ddxInvW) * (result.m_lambda * interpInvW + ddxOverW) - result.m_lambda;
+    result.m_ddy = rcp(interpInvW + ddyInvW) * (result.m_lambda * interpInvW + ddyOverW) - result.m_lambda;
+
+    return result;
+}
+
+template<typename T>
+T InterpolateAttribute(Barycentrics barycentrics, T a0, T a1, T a2)
+{
+    return a0 * barycentrics.m_lambda.x + a1 * barycentrics.m_lambda.y + a2 * barycentrics.m_lambda.z;
+}
+
+template<typename T>
+T InterpolateAttributeDDX(Barycentrics barycentrics, T a0, T a1, T a2)
+{
+    return a0 * barycentrics.m_ddx.x + a1 * barycentrics.m_ddx.y + a2 * barycentrics.m_ddx.z;
+}
+
+template<typename T>
+T InterpolateAttributeDDY(Barycentrics barycentrics, T a0, T a1, T a2)
+{
+    return a0 * barycentrics.m_ddy.x + a1 * barycentrics.m_ddy.y + a2 * barycentrics.m_ddy.z;
+}
+
+#endif // __cplusplus
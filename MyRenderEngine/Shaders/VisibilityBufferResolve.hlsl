@@ -0,0 +1,245 @@
+#include "ModelGBuffer.hlsli"
+#include "Meshlet.hlsli"
+#include "VisibilityBuffer.hlsli"
+
+struct VisibleTriangle
+{
+    uint m_instanceIndex;
+    uint m_meshletIndex;
+    uint m_triangleIndex;
+    bool m_bFrontFace;
+};
+
+VisibleTriangle GetVisibleTriangle(uint visibleMeshletListSRV, uint visibilityID)
+{
+    StructuredBuffer<uint2> visibleMeshletList = ResourceDescriptorHeap[visibleMeshletListSRV];
+
+    uint visibleMeshletIndex;
+    VisibleTriangle visibleTriangle;
+    UnpackVisibilityID(visibilityID, visibleMeshletIndex, visibleTriangle.m_triangleIndex, visibleTriangle.m_bFrontFace);
+
+    uint2 visibleMeshlet = visibleMeshletList[visibleMeshletIndex];
+    visibleTriangle.m_instanceIndex = visibleMeshlet.x;
+    visibleTriangle.m_meshletIndex = visibleMeshlet.y;
+    return visibleTriangle;
+}
+
+cbuffer ClassifyConstants : register(b0)
+{
+    uint c_visibilityBufferSRV;
+    uint c_visibleMeshletListSRV;
+    uint c_binCounterUAV;
+    uint c_binCursorUAV;
+    uint c_pixelListUAV;
+};
+
+// Material bin of the pixel, VISIBILITY_BUFFER_BIN_COUNT for the sky
+uint GetPixelBin(uint2 pos, out uint visibilityID)
+{
+    visibilityID = 0;
+    if (any(pos >= SceneCB.m_renderSize))
+    {
+        return VISIBILITY_BUFFER_BIN_COUNT;
+    }
+
+    Texture2D<uint2> visibilityBuffer = ResourceDescriptorHeap[c_visibilityBufferSRV];
+    uint2 texel = visibilityBuffer[pos];
+    if (texel.y == 0)
+    {
+        return VISIBILITY_BUFFER_BIN_COUNT;
+    }
+
+    visibilityID = texel.x;
+    VisibleTriangle visibleTriangle = GetVisibleTriangle(c_visibleMeshletListSRV, visibilityID);
+    return GetInstanceData(visibleTriangle.m_instanceIndex).m_materialIndex;
+}
+
+// Pixels per material, neighbouring pixels mostly share it so the lanes of one material add with one atomic
+[numthreads(8, 8, 1)]
+void cs_classify(uint3 dispatchThreadID : SV_DispatchThreadID)
+{
+    uint visibilityID;
+    uint bin = GetPixelBin(dispatchThreadID.xy, visibilityID);
+    if (bin >= VISIBILITY_BUFFER_BIN_COUNT)
+    {
+        return;
+    }
+
+    RWBuffer<uint> binCounter = ResourceDescriptorHeap[c_binCounterUAV];
+    for (;;)
+    {
+        uint waveBin = WaveReadLaneFirst(bin);
+        if (bin == waveBin)
+        {
+            uint count = WaveActiveCountBits(true);
+            if (WaveIsFirstLane())
+            {
+                InterlockedAdd(binCounter[waveBin], count);
+            }
+            break;
+        }
+    }
+}
+
+// Pixels are written to the range of their bin, which cs_build_bins starts the cursor of
+[numthreads(8, 8, 1)]
+void cs_scatter(uint3 dispatchThreadID : SV_DispatchThreadID)
+{
+    uint visibilityID;
+    uint bin = GetPixelBin(dispatchThreadID.xy, visibilityID);
+    if (bin >= VISIBILITY_BUFFER_BIN_COUNT)
+    {
+        return;
+    }
+
+    RWBuffer<uint> binCursor = ResourceDescriptorHeap[c_binCursorUAV];
+    RWStructuredBuffer<uint2> pixelList = ResourceDescriptorHeap[c_pixelListUAV];
+    for (;;)
+    {
+        uint waveBin = WaveReadLaneFirst(bin);
+        if (bin == waveBin)
+        {
+            uint count = WaveActiveCountBits(true);
+            uint offset = 0;
+            if (WaveIsFirstLane())
+            {
+                InterlockedAdd(binCursor[waveBin], count, offset);
+            }
+            offset = WaveReadLaneFirst(offset) + WavePrefixCountBits(true);
+
+            pixelList[offset] = uint2(PackPixelPosition(dispatchThreadID.xy), visibilityID);
+            break;
+        }
+    }
+}
+
+cbuffer BuildBinsConstants : register(b0)
+{
+    uint c_binCounterSRV;
+    uint c_binCursorOutputUAV;
+    uint c_indirectCommandUAV;
+};
+
+groupshared uint s_waveOffsets[VISIBILITY_BUFFER_BIN_GROUP_SIZE / 4];   //< Waves have 4 lanes at least
+groupshared uint s_pixelCount;
+
+// Exclusive prefix sum of the bin sizes, the bins are in material order in the pixel list
+[numthreads(VISIBILITY_BUFFER_BIN_GROUP_SIZE, 1, 1)]
+void cs_build_bins(uint groupThreadID : SV_GroupThreadID)
+{
+    const uint binsPerThread = VISIBILITY_BUFFER_BIN_COUNT / VISIBILITY_BUFFER_BIN_GROUP_SIZE;
+    uint firstBin = groupThreadID * binsPerThread;
+
+    Buffer<uint> binCounter = ResourceDescriptorHeap[c_binCounterSRV];
+    uint counts[binsPerThread];
+    uint threadCount = 0;
+    for (uint i = 0; i < binsPerThread; ++i)
+    {
+        counts[i] = binCounter[firstBin + i];
+        threadCount += counts[i];
+    }
+
+    uint waveIndex = groupThreadID / WaveGetLaneCount();
+    uint offset = WavePrefixSum(threadCount);
+    if (WaveGetLaneIndex() == WaveGetLaneCount() - 1)
+    {
+        s_waveOffsets[waveIndex] = offset + threadCount;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (groupThreadID == 0)
+    {
+        uint sum = 0;
+        for (uint wave = 0; wave < VISIBILITY_BUFFER_BIN_GROUP_SIZE / WaveGetLaneCount(); ++wave)
+        {
+            uint waveCount = s_waveOffsets[wave];
+            s_waveOffsets[wave] = sum;
+            sum += waveCount;
+        }
+        s_pixelCount = sum;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    RWBuffer<uint> binCursor = ResourceDescriptorHeap[c_binCursorOutputUAV];
+    offset += s_waveOffsets[waveIndex];
+    for (uint j = 0; j < binsPerThread; ++j)
+    {
+        binCursor[firstBin + j] = offset;
+        offset += counts[j];
+    }
+
+    if (groupThreadID == 0)
+    {
+        RWStructuredBuffer<uint3> commandBuffer = ResourceDescriptorHeap[c_indirectCommandUAV];
+        commandBuffer[0] = uint3((s_pixelCount + VISIBILITY_BUFFER_RESOLVE_GROUP_SIZE - 1) / VISIBILITY_BUFFER_RESOLVE_GROUP_SIZE, 1, 1);
+    }
+}
+
+cbuffer ResolveConstants : register(b0)
+{
+    uint c_resolveMeshletListSRV;
+    uint c_binEndSRV;           //< Cursors after cs_scatter, the last one is the pixel count
+    uint c_pixelListSRV;
+    uint c_diffuseRTUAV;
+    uint c_specularRTUAV;
+    uint c_normalRTUAV;
+    uint c_emissiveRTUAV;
+    uint c_customDataRTUAV;
+};
+
+// One thread per covered pixel in material order, so the branches of the uber material mostly agree in a wave
+[numthreads(VISIBILITY_BUFFER_RESOLVE_GROUP_SIZE, 1, 1)]
+void cs_resolve(uint3 dispatchThreadID : SV_DispatchThreadID)
+{
+    Buffer<uint> binEnd = ResourceDescriptorHeap[c_binEndSRV];
+    if (dispatchThreadID.x >= binEnd[VISIBILITY_BUFFER_BIN_COUNT - 1])
+    {
+        return;
+    }
+
+    StructuredBuffer<uint2> pixelList = ResourceDescriptorHeap[c_pixelListSRV];
+    uint2 pixel = pixelList[dispatchThreadID.x];
+    uint2 pos = UnpackPixelPosition(pixel.x);
+
+    VisibleTriangle visibleTriangle = GetVisibleTriangle(c_resolveMeshletListSRV, pixel.y);
+    uint instanceIndex = visibleTriangle.m_instanceIndex;
+    InstanceData instanceData = GetInstanceData(instanceIndex);
+    Meshlet meshlet = LoadMeshlet(instanceData, visibleTriangle.m_meshletIndex);
+
+    uint indexOffset = meshlet.m_triangleOffset + visibleTriangle.m_triangleIndex * 3;
+    uint3 index = uint3(
+        LoadSceneStaticBuffer<uint16_t>(instanceData.m_meshletIndicesBufferAddress, indexOffset),
+        LoadSceneStaticBuffer<uint16_t>(instanceData.m_meshletIndicesBufferAddress, indexOffset + 1),
+        LoadSceneStaticBuffer<uint16_t>(instanceData.m_meshletIndicesBufferAddress, indexOffset + 2));
+
+    // Same vertex transform as the G-buffer pass
+    model::VertexOutput v0 = model::GetVertexOutput(instanceIndex, LoadSceneStaticBuffer<uint>(instanceData.m_meshletVerticesBufferAddress, meshlet.m_vertexOffset + index.x));
+    model::VertexOutput v1 = model::GetVertexOutput(instanceIndex, LoadSceneStaticBuffer<uint>(instanceData.m_meshletVerticesBufferAddress, meshlet.m_vertexOffset + index.y));
+    model::VertexOutput v2 = model::GetVertexOutput(instanceIndex, LoadSceneStaticBuffer<uint>(instanceData.m_meshletVerticesBufferAddress, meshlet.m_vertexOffset + index.z));
+
+    float2 ndcPos = (GetScreenUV(pos, SceneCB.m_rcpRenderSize) * 2.0 - 1.0) * float2(1.0, -1.0);
+    Barycentrics barycentrics = ComputeBarycentrics(v0.m_pos, v1.m_pos, v2.m_pos, ndcPos, (float2) SceneCB.m_renderSize);
+
+    float2 uv = InterpolateAttribute(barycentrics, v0.m_uv, v1.m_uv, v2.m_uv);
+    model::s_uvDDX = InterpolateAttributeDDX(barycentrics, v0.m_uv, v1.m_uv, v2.m_uv);
+    model::s_uvDDY = InterpolateAttributeDDY(barycentrics, v0.m_uv, v1.m_uv, v2.m_uv);
+
+    float3 normal = normalize(InterpolateAttribute(barycentrics, v0.m_normal, v1.m_normal, v2.m_normal));
+    float3 tangent = normalize(InterpolateAttribute(barycentrics, v0.m_tangent, v1.m_tangent, v2.m_tangent));
+    float3 bitangent = normalize(InterpolateAttribute(barycentrics, v0.m_bitangent, v1.m_bitangent, v2.m_bitangent));
+
+    GBufferOutput output = GetGBufferOutput(instanceIndex, uv, normal, tangent, bitangent, visibleTriangle.m_bFrontFace);
+
+    // The SRGB targets are written by their UNORM views
+    RWTexture2D<float4> diffuseRT = ResourceDescriptorHeap[c_diffuseRTUAV];
+    RWTexture2D<float4> specularRT = ResourceDescriptorHeap[c_specularRTUAV];
+    RWTexture2D<float4> normalRT = ResourceDescriptorHeap[c_normalRTUAV];
+    RWTexture2D<float3> emissiveRT = ResourceDescriptorHeap[c_emissiveRTUAV];
+    RWTexture2D<float4> customDataRT = ResourceDescriptorHeap[c_customDataRTUAV];
+
+    diffuseRT[pos] = float4(LinearToSRGB(output.m_diffuseRT.xyz), output.m_diffuseRT.w);
+    specularRT[pos] = float4(LinearToSRGB(output.m_specularRT.xyz), output.m_specularRT.w);
+    normalRT[pos] = output.m_normalRT;
+    emissiveRT[pos] = output.m_emissiveRT;
+    customDataRT[pos] = output.m_customDataRT;
+}
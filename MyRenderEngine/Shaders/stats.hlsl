@@ -47,6 +47,9 @@ void main()
     debug::PrintString(screenPos, color, ',', ' ');
     debug::PrintString(screenPos, color, 'r', 'e', 'n', 'd', 'e', 'r', 'e', 'd', ' ');
     debug::PrintInt(screenPos, color, statsBuffer[STATS_1ST_PHASE_RENDERED_MESHLET]);
+    debug::PrintString(screenPos, color, ',', ' ');
+    debug::PrintString(screenPos, color, 's', 'o', 'f', 't', 'w', 'a', 'r', 'e', ' ');
+    debug::PrintInt(screenPos, color, statsBuffer[STATS_1ST_PHASE_SOFTWARE_RASTER_MESHLET]);
     
     screenPos.x = 120;
     screenPos.y += 20;
@@ -87,6 +90,9 @@ void main()
     debug::PrintString(screenPos, color, ',', ' ');
     debug::PrintString(screenPos, color, 'r', 'e', 'n', 'd', 'e', 'r', 'e', 'd', ' ');
     debug::PrintInt(screenPos, color, statsBuffer[STATS_2ND_PHASE_RENDERED_MESHLET]);
+    debug::PrintString(screenPos, color, ',', ' ');
+    debug::PrintString(screenPos, color, 's', 'o', 'f', 't', 'w', 'a', 'r', 'e', ' ');
+    debug::PrintInt(screenPos, color, statsBuffer[STATS_2ND_PHASE_SOFTWARE_RASTER_MESHLET]);
     
     screenPos.x = 120;
     screenPos.y += 20;
@@ -90,6 +90,7 @@ void Engine::Init(const eastl::string& workPath, void* windowHandle, uint32_t wi
 void Engine::Tick()
 {
     CPU_EVENT("Tick", "Engine::Tick");
+    m_pRenderer->PaceFrame();   //< Before the input is sampled, so the frame starts with the newest input
     m_frameTime = (float)stm_sec(stm_laptime(&m_lastFrameTime));
 
     m_pEditor->NewFrame();
@@ -103,8 +104,15 @@ void Engine::Tick()
     }
     else
     {
-        m_pEditor->Tick();
-        m_pWorld->Tick(m_frameTime);
+        FrameTrace* pFrameTrace = m_pRenderer->GetFrameTrace();
+        {
+            FrameTraceScope scope(pFrameTrace, "Editor::Tick");
+            m_pEditor->Tick();
+        }
+        {
+            FrameTraceScope scope(pFrameTrace, "World::Tick");
+            m_pWorld->Tick(m_frameTime);
+        }
         m_pRenderer->RenderFrame();
     }
 
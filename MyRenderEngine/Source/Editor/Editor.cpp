@@ -3,8 +3,14 @@
 #include "Im3DImpl.h"
 #include "Core/Engine.h"
 #include "Renderer/TextureLoader.h"
+#include "RHI/RHIDescriptorAllocator.h"
+#include "Tests/Tests.h"
 #include "Utils/assert.h"
 #include "Utils/system.h"
+#include "Utils/log.h"
+#include "Utils/profiler.h"
+#include "Utils/math.h"
+#include "sokol/sokol_time.h"
 #include "imgui/imgui.h"
 #include "ImFileDialog/ImFileDialog.h"
 #include "ImGuizmo/ImGuizmo.h"
@@ -15,10 +21,12 @@
 Editor::Editor(Renderer* pRenderer)
 {
     m_pRenderer = pRenderer;
-    m_pImGuiImpl = eastl::make_unique<ImGuiImpl>(pRenderer);
+    m_pRingBuffer = eastl::make_unique<UploadRingBuffer>(pRenderer->GetDevice(), "Editor::m_pRingBuffer");
+
+    m_pImGuiImpl = eastl::make_unique<ImGuiImpl>(pRenderer, m_pRingBuffer.get());
     m_pImGuiImpl->Init();
 
-    m_pIm3DImpl = eastl::make_unique<Im3DImpl>(pRenderer);
+    m_pIm3DImpl = eastl::make_unique<Im3DImpl>(pRenderer, m_pRingBuffer.get());
     m_pIm3DImpl->Init();
     
     ifd::FileDialog::Instance().CreateTexture = [this](uint8_t* data, int w, int h, char fmt) -> void*
@@ -53,6 +61,14 @@ Editor::~Editor()
 
 void Editor::NewFrame()
 {
+    if (m_runTests)
+    {
+        m_runTests = false;
+        RunTests();
+    }
+
+    uint64_t startTime = stm_now();
+
     m_pImGuiImpl->NewFrame();
     m_pIm3DImpl->NewFrame();
 
@@ -65,24 +81,49 @@ void Editor::NewFrame()
 
         m_pRenderer->RequestMouseHitTest((uint32_t)mousePos.x, (uint32_t)mousePos.y);
     }
+
+    m_uiCPUTime = stm_since(startTime);
 }
 
 
 void Editor::Tick()
 {
+    uint64_t startTime = stm_now();
+
     FlushPendingTextureDeletions();
     //BuildDockLayout();
     
     DrawMenu();
+    DrawGPUMemoryStats();
+
+    if (ImGui::IsKeyPressed(ImGuiKey_F11, false))
+    {
+        m_pRenderer->GetFrameTrace()->Capture();
+    }
+
     //DrawToolBar();
     //DrawGizmo();
     //DrawFrameStats();
+
+    m_uiCPUTime += stm_since(startTime);
 }
 
 void Editor::Render(IRHICommandList* pCommandList)
 {
+    uint64_t startTime = stm_now();
+
     m_pImGuiImpl->Render(pCommandList);
     m_pIm3DImpl->Render(pCommandList);
+
+    m_uiCPUTime += stm_since(startTime);
+
+    MICROPROFILE_COUNTER_SET("Editor/UI/CPUUs", (int64_t) stm_us(m_uiCPUTime));
+    MICROPROFILE_COUNTER_SET("Editor/UI/UploadBytes", m_pRingBuffer->GetFrameBytes());
+    MICROPROFILE_COUNTER_SET("Editor/UI/RingBufferSize", m_pRingBuffer->GetSize());
+    MICROPROFILE_COUNTER_SET("Editor/UI/ImGuiCommands", m_pImGuiImpl->GetCommandCount());
+    MICROPROFILE_COUNTER_SET("Editor/UI/ImGuiDraws", m_pImGuiImpl->GetDrawCount());
+    MICROPROFILE_COUNTER_SET("Editor/UI/Im3dDrawLists", m_pIm3DImpl->GetDrawListCount());
+    MICROPROFILE_COUNTER_SET("Editor/UI/Im3dDraws", m_pIm3DImpl->GetDrawCount());
 }
 
 void Editor::BuildDockLayout()
@@ -112,6 +153,11 @@ void Editor::DrawMenu()
             {
             }
 
+            if (ImGui::MenuItem("Save Scene"))
+            {
+                ifd::FileDialog::Instance().Save("SceneSaveDialog", "Save Scene", "Binary Scene (*.scene){.scene},XML File (*.xml){.xml}");
+            }
+
             ImGui::EndMenu();
         }
 
@@ -122,6 +168,8 @@ void Editor::DrawMenu()
                 m_pRenderer->GetSwapChain()->SetVsyncEnabled(m_vsync);
             }
 
+            ImGui::MenuItem("GPU Memory Stats", "", &m_showGPUMemoryStats);
+
             if (ImGui::MenuItem("GPU Driven Stats", "", &m_showGPUDrivenStats))
             {
                 m_pRenderer->SetGPUDrivenStatsEnabled(m_showGPUDrivenStats);
@@ -137,12 +185,103 @@ void Editor::DrawMenu()
 
             }
 
+            bool showShadowMask = m_pRenderer->GetOutputType() == RendererOutput::Shadow;
+            if (ImGui::MenuItem("Show Shadow Mask", "", &showShadowMask))
+            {
+                m_pRenderer->SetOutputType(showShadowMask ? RendererOutput::Shadow : RendererOutput::Default);
+            }
+
+            bool uberMaterial = m_pRenderer->IsUberMaterialEnabled();
+            if (ImGui::MenuItem("Uber Material", "", &uberMaterial))
+            {
+                m_pRenderer->SetUberMaterialEnabled(uberMaterial);
+            }
+
+            bool visibilityBuffer = m_pRenderer->IsVisibilityBufferEnabled();
+            if (ImGui::MenuItem("Visibility Buffer", "", &visibilityBuffer))
+            {
+                m_pRenderer->SetVisibilityBufferEnabled(visibilityBuffer);
+            }
+
+            bool softwareRaster = m_pRenderer->IsSoftwareRasterEnabled();
+            if (ImGui::MenuItem("Software Raster", "", &softwareRaster, visibilityBuffer))
+            {
+                m_pRenderer->SetSoftwareRasterEnabled(softwareRaster);
+            }
+
+            bool fusedHZB = m_pRenderer->IsFusedHZBEnabled();
+            if (ImGui::MenuItem("Fused HZB", "", &fusedHZB))
+            {
+                m_pRenderer->SetFusedHZBEnabled(fusedHZB);
+            }
+
+            bool halfResGTAO = m_pRenderer->IsHalfResGTAOEnabled();
+            if (ImGui::MenuItem("Half Res GTAO", "", &halfResGTAO))
+            {
+                m_pRenderer->SetHalfResGTAOEnabled(halfResGTAO);
+            }
+
             bool asyncCompute = m_pRenderer->IsAsyncComputeEnabled();
             if (ImGui::MenuItem("Async Compute", "", &asyncCompute))
             {
                 m_pRenderer->SetAsyncComputeEnabled(asyncCompute);
             }
 
+            RenderGraph* pRenderGraph = m_pRenderer->GetRenderGraph();
+            bool asyncScheduling = pRenderGraph->IsAsyncSchedulingEnabled();
+            if (ImGui::MenuItem("Auto Async Compute", "", &asyncScheduling, asyncCompute))
+            {
+                pRenderGraph->SetAsyncSchedulingEnabled(asyncScheduling);
+            }
+
+            World* pWorld = Engine::GetInstance()->GetWorld();
+            bool bvhCulling = pWorld->IsBVHCullingEnabled();
+            if (ImGui::MenuItem("BVH Culling", "", &bvhCulling))
+            {
+                pWorld->SetBVHCullingEnabled(bvhCulling);
+            }
+
+            bool occlusionCulling = pWorld->IsOcclusionCullingEnabled();
+            if (ImGui::MenuItem("CPU Occlusion Culling", "", &occlusionCulling))
+            {
+                pWorld->SetOcclusionCullingEnabled(occlusionCulling);
+            }
+
+            if (ImGui::BeginMenu("Frames In Flight"))
+            {
+                for (uint32_t i = 1; i <= RHI_MAX_INFLIGHT_FRAMES; ++i)
+                {
+                    if (ImGui::MenuItem(fmt::format("{}", i).c_str(), "", m_pRenderer->GetFramesInFlight() == i))
+                    {
+                        m_pRenderer->SetFramesInFlight(i);
+                    }
+                }
+                ImGui::EndMenu();
+            }
+
+            FramePacer* pFramePacer = m_pRenderer->GetFramePacer();
+            bool framePacing = pFramePacer->IsEnabled();
+            if (ImGui::MenuItem("Frame Pacing", "", &framePacing))
+            {
+                pFramePacer->SetEnabled(framePacing);
+            }
+
+            bool logFrameLatency = m_pRenderer->IsFrameLatencyLogEnabled();
+            if (ImGui::MenuItem("Log Frame Latency", "", &logFrameLatency))
+            {
+                m_pRenderer->SetFrameLatencyLogEnabled(logFrameLatency);
+            }
+
+            if (ImGui::MenuItem("Run Tests"))
+            {
+                m_runTests = true;
+            }
+
+            if (ImGui::MenuItem("Capture Frame Trace", "F11", false, !m_pRenderer->GetFrameTrace()->IsCapturing()))
+            {
+                m_pRenderer->GetFrameTrace()->Capture();
+            }
+
             if (ImGui::MenuItem("Reload Shader"))
             {
                 m_pRenderer->ReloadShaders();
@@ -164,6 +303,17 @@ void Editor::DrawMenu()
 
         ifd::FileDialog::Instance().Close();
     }
+
+    if (ifd::FileDialog::Instance().IsDone("SceneSaveDialog"))
+    {
+        if (ifd::FileDialog::Instance().HasResult())
+        {
+            eastl::string file = ifd::FileDialog::Instance().GetResult().u8string().c_str();
+            Engine::GetInstance()->GetWorld()->SaveScene(file);
+        }
+
+        ifd::FileDialog::Instance().Close();
+    }
 }
 
 void Editor::DrawToolBar()
@@ -181,9 +331,61 @@ void Editor::DrawFrameStats()
     // todo:
 }
 
-void Editor::CreateGPUMemoryStas()
+void Editor::DrawGPUMemoryStats()
 {
-    // todo:
+    if (!m_showGPUMemoryStats)
+    {
+        return;
+    }
+
+    if (ImGui::Begin("GPU Memory Stats", &m_showGPUMemoryStats))
+    {
+        eastl::vector<RHIDescriptorAllocatorStats> descriptorStats;
+        m_pRenderer->GetDevice()->GetDescriptorAllocatorStats(descriptorStats);
+
+        if (ImGui::CollapsingHeader("Descriptor Heaps", ImGuiTreeNodeFlags_DefaultOpen))
+        {
+            for (size_t i = 0; i < descriptorStats.size(); ++i)
+            {
+                const RHIDescriptorAllocatorStats& stats = descriptorStats[i];
+                uint32_t usedCount = stats.m_allocatedCount - stats.m_cachedCount - stats.m_pendingFreeCount;
+
+                ImGui::Text("%s", stats.m_name.c_str());
+                ImGui::ProgressBar((float) stats.m_allocatedCount / stats.m_capacity, ImVec2(-1.0f, 0.0f),
+                    fmt::format("{} / {}", stats.m_allocatedCount, stats.m_capacity).c_str());
+                ImGui::Text("used %u, cached %u, pending free %u", usedCount, stats.m_cachedCount, stats.m_pendingFreeCount);
+                ImGui::Text("free regions %u, largest %u, fragmentation %.1f%%", stats.m_freeRegionCount, stats.m_largestFreeRegion, stats.m_fragmentation * 100.0f);
+                ImGui::Separator();
+            }
+        }
+
+        eastl::vector<ResourcePoolStats> poolStats;
+        m_pRenderer->GetResourcePool()->GetStats(poolStats);
+
+        if (ImGui::CollapsingHeader("Resource Pools", ImGuiTreeNodeFlags_DefaultOpen))
+        {
+            for (size_t i = 0; i < poolStats.size(); ++i)
+            {
+                const ResourcePoolStats& stats = poolStats[i];
+
+                ImGui::Text("%s", stats.m_name.c_str());
+                ImGui::ProgressBar(stats.m_reservedBytes > 0 ? (float) stats.m_usedBytes / stats.m_reservedBytes : 0.0f, ImVec2(-1.0f, 0.0f),
+                    fmt::format("{:.2f} / {:.2f} MB", stats.m_usedBytes / (1024.0f * 1024.0f), stats.m_reservedBytes / (1024.0f * 1024.0f)).c_str());
+                ImGui::Text("%u resources in %u blocks, pending free %u", stats.m_resourceCount, stats.m_blockCount, stats.m_pendingFreeCount);
+                ImGui::Text("saved %.2f MB against dedicated resources", stats.GetSavedBytes() / (1024.0f * 1024.0f));
+                ImGui::Separator();
+            }
+        }
+
+        if (ImGui::CollapsingHeader("UI Ring Buffer", ImGuiTreeNodeFlags_DefaultOpen))
+        {
+            ImGui::Text("%.2f MB, grown %u times", m_pRingBuffer->GetSize() / (1024.0f * 1024.0f), m_pRingBuffer->GetGrowCount());
+            ImGui::Text("%.1f KB uploaded last frame, %.2f ms cpu", m_pRingBuffer->GetFrameBytes() / 1024.0f, stm_ms(m_uiCPUTime));
+            ImGui::Text("ImGui %u commands in %u draws, Im3d %u draw lists in %u draws", m_pImGuiImpl->GetCommandCount(), m_pImGuiImpl->GetDrawCount(),
+                m_pIm3DImpl->GetDrawListCount(), m_pIm3DImpl->GetDrawCount());
+        }
+    }
+    ImGui::End();
 }
 
 void Editor::ShowRenderGraoh()
@@ -241,4 +443,4 @@ void Editor::FlushPendingTextureDeletions()
     }
 
     m_pendingDeletions.clear();
-}
\ No newline at end of file
+}
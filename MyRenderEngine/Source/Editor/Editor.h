@@ -1,5 +1,6 @@
 #pragma once
 #include "Renderer/Renderer.h"
+#include "Renderer/UploadRingBuffer.h"
 #include "EASTL/hash_map.h"
 #include "EASTL/functional.h"
 
@@ -20,12 +21,13 @@ private:
     void DrawGizmo();
     void DrawFrameStats();
     
-    void CreateGPUMemoryStas();
+    void DrawGPUMemoryStats();
     void ShowRenderGraoh();
     void FlushPendingTextureDeletions();
 
 private:
     Renderer* m_pRenderer = nullptr;
+    eastl::unique_ptr<UploadRingBuffer> m_pRingBuffer;     //< Vertices and indices of ImGui and Im3d, destroyed after them
     eastl::unique_ptr<class ImGuiImpl> m_pImGuiImpl;
     eastl::unique_ptr<class Im3DImpl> m_pIm3DImpl;
     
@@ -41,8 +43,10 @@ private:
     bool m_showLighting = false;
     bool m_showPostProcess = false;
     bool m_resetLayout = false;
+    bool m_runTests = false;    //< Run before the next frame is begun, benchmarks of GPU times tick the engine
 
     unsigned int m_dockSpace = 0;
+    uint64_t m_uiCPUTime = 0;       //< Ticks spent building and rendering the UI this frame
 
     struct Command
     {
@@ -4,7 +4,7 @@
 #include "im3d/im3d.h"
 #include "imgui/imgui.h"
 
-Im3DImpl::Im3DImpl(Renderer* pRenderer) : m_pRenderer(pRenderer)
+Im3DImpl::Im3DImpl(Renderer* pRenderer, UploadRingBuffer* pRingBuffer) : m_pRenderer(pRenderer), m_pRingBuffer(pRingBuffer)
 {
 
 }
@@ -92,36 +92,53 @@ void Im3DImpl::Render(IRHICommandList* pCommandList)
 
 	Im3d::EndFrame();
 
-	uint32_t frameIndex = m_pRenderer->GetFrameID() % RHI_MAX_INFLIGHT_FRAMES;
+	m_drawListCount = Im3d::GetDrawListCount();
+	m_drawCount = 0;
+
 	uint vertexCount = GetVertexCount();
+	if (vertexCount == 0)
+	{
+		return;
+	}
 
-	if (m_pVertexBuffer[frameIndex] == nullptr || m_pVertexBuffer[frameIndex]->GetBuffer()->GetDesc().m_size < vertexCount * sizeof(Im3d::VertexData))
+	UploadRingAllocation vertices = m_pRingBuffer->Allocate(vertexCount * sizeof(Im3d::VertexData));
+	if (vertices.m_pBuffer == nullptr)
 	{
-		m_pVertexBuffer[frameIndex].reset(m_pRenderer->CreateRawBuffer(nullptr, (vertexCount + 1000) * sizeof(Im3d::VertexData), "Im3D Vertex Buffer"));	//< The 1000 is use to make sure we don't re-size vertex buffer frequently
+		return;
 	}
 
+	// Draw lists are copied back to back, adjacent ones of the same primitive type are drawn together, which keeps the draw order
 	uint32_t vertexBufferOffset = 0;
-	for (uint32_t i = 0; i < Im3d::GetDrawListCount(); ++i)
+	for (uint32_t i = 0; i < Im3d::GetDrawListCount();)
 	{
-		const Im3d::DrawList& drawList = Im3d::GetDrawLists()[i];
+		Im3d::DrawPrimitiveType primType = Im3d::GetDrawLists()[i].m_primType;
+		uint32_t firstVertexOffset = vertexBufferOffset;
+		uint32_t runVertexCount = 0;
+
+		for (; i < Im3d::GetDrawListCount() && Im3d::GetDrawLists()[i].m_primType == primType; ++i)
+		{
+			const Im3d::DrawList& drawList = Im3d::GetDrawLists()[i];
+
+			memcpy(vertices.m_pCPUAddress + vertexBufferOffset, drawList.m_vertexData, sizeof(Im3d::VertexData) * drawList.m_vertexCount);
+			vertexBufferOffset += sizeof(Im3d::VertexData) * drawList.m_vertexCount;
+			runVertexCount += drawList.m_vertexCount;
+		}
 
-		memcpy((char*)m_pVertexBuffer[frameIndex]->GetBuffer()->GetCPUAddress() + vertexBufferOffset, drawList.m_vertexData, sizeof(Im3d::VertexData) * drawList.m_vertexCount);
-		
 		uint32_t primitiveCount = 0;
-		switch (drawList.m_primType)
+		switch (primType)
 		{
 		case Im3d::DrawPrimitive_Points:
-			primitiveCount = drawList.m_vertexCount;
+			primitiveCount = runVertexCount;
 			pCommandList->SetPipelineState(m_pPointPSO);
 			break;
 
 		case Im3d::DrawPrimitive_Lines:
-			primitiveCount = drawList.m_vertexCount / 2;
+			primitiveCount = runVertexCount / 2;
 			pCommandList->SetPipelineState(m_pLinePSO);
 			break;
 
 		case Im3d::DrawPrimitive_Triangles:
-			primitiveCount = drawList.m_vertexCount / 3;
+			primitiveCount = runVertexCount / 3;
 			pCommandList->SetPipelineState(m_pTrianglePSO);
 			break;
 
@@ -129,16 +146,21 @@ void Im3DImpl::Render(IRHICommandList* pCommandList)
 			break;
 		}
 
+		if (primitiveCount == 0)
+		{
+			continue;
+		}
+
 		uint32_t cb[] =
 		{
 			primitiveCount,
-			m_pVertexBuffer[frameIndex]->GetSRV()->GetHeapIndex(),
-			vertexBufferOffset
+			vertices.m_pSRV->GetHeapIndex(),
+			vertices.m_offset + firstVertexOffset
 		};
 
 		pCommandList->SetGraphicsConstants(0, cb, sizeof(cb));
 		pCommandList->DispatchMesh(DivideRoundingUp(primitiveCount, 64), 1, 1);
-		vertexBufferOffset += sizeof(Im3d::VertexData) * drawList.m_vertexCount;
+		++m_drawCount;
 	}
 }
 
@@ -1,26 +1,31 @@
 #pragma once
 
 #include "Renderer/Renderer.h"
+#include "Renderer/UploadRingBuffer.h"
 
 class Im3DImpl
 {
 public:
-    Im3DImpl(Renderer* pRenderer);
+    Im3DImpl(Renderer* pRenderer, UploadRingBuffer* pRingBuffer);
     ~Im3DImpl();
 
     bool Init();
     void NewFrame();
     void Render(IRHICommandList* pCommandList);
+
+    uint32_t GetDrawListCount() const { return m_drawListCount; }   //< Of the last frame
+    uint32_t GetDrawCount() const { return m_drawCount; }
     
 private:
     uint32_t GetVertexCount() const;
     
 private:
     Renderer* m_pRenderer;
+    UploadRingBuffer* m_pRingBuffer = nullptr;
     IRHIPipelineState* m_pPointPSO = nullptr;
     IRHIPipelineState* m_pLinePSO = nullptr;
     IRHIPipelineState* m_pTrianglePSO = nullptr;
 
-    eastl::unique_ptr<RawBuffer> m_pVertexBuffer[RHI_MAX_INFLIGHT_FRAMES];
-    
+    uint32_t m_drawListCount = 0;
+    uint32_t m_drawCount = 0;
 };
\ No newline at end of file
@@ -5,9 +5,10 @@
 #include "imgui/imgui_impl_win32.h"
 #include "ImGuizmo/ImGuizmo.h"
 
-ImGuiImpl::ImGuiImpl(Renderer* pRenderer)
+ImGuiImpl::ImGuiImpl(Renderer* pRenderer, UploadRingBuffer* pRingBuffer)
 {
     m_pRenderer = pRenderer;
+    m_pRingBuffer = pRingBuffer;
     
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -91,100 +92,156 @@ void ImGuiImpl::Render(IRHICommandList* pCommandList)
     // Prepare the data for rendering so you can call GetDrawData()
     ImGui::Render();
 
-    IRHIDevice* pDevice = m_pRenderer->GetDevice();
     ImDrawData* pDrawData = ImGui::GetDrawData();
+    m_commandCount = 0;
+    m_drawCount = 0;
 
     // Avoid rendering when minimized
-    if (pDrawData->DisplaySize.x <= 0.0f || pDrawData->DisplaySize.y <= 0.0f)
+    if (pDrawData->DisplaySize.x <= 0.0f || pDrawData->DisplaySize.y <= 0.0f || pDrawData->TotalIdxCount == 0)
     {
         return;
     }
 
-    uint32_t frameIndex = pDevice->GetFrameID() % RHI_MAX_INFLIGHT_FRAMES;
-
-    if (m_pVertexBuffer[frameIndex] == nullptr || m_pVertexBuffer[frameIndex]->GetBuffer()->GetDesc().m_size < pDrawData->TotalVtxCount * sizeof(ImDrawVert))
-    {
-        // 2048 is use for resvered space, so we don't have to recreate vertex buffer when UI changed
-        m_pVertexBuffer[frameIndex].reset(m_pRenderer->CreateStructedBuffer(nullptr, sizeof(ImDrawVert), pDrawData->TotalVtxCount, "ImGuiImpl VB", RHIMemoryType::CPUToGPU));
-    }
-
-    if (m_pIndexBuffer[frameIndex] == nullptr || m_pIndexBuffer[frameIndex]->GetIndexCount() < pDrawData->TotalIdxCount)
+    UploadRingAllocation vertices = m_pRingBuffer->Allocate(pDrawData->TotalVtxCount * sizeof(ImDrawVert));
+    UploadRingAllocation indices = m_pRingBuffer->Allocate(pDrawData->TotalIdxCount * sizeof(uint32_t));
+    if (vertices.m_pBuffer == nullptr || indices.m_pBuffer == nullptr)
     {
-        // 2048 is use for resvered space, so we don't have to recreate vertex buffer when UI changed
-        m_pIndexBuffer[frameIndex].reset(m_pRenderer->CreateIndexBuffer(nullptr, sizeof(ImDrawIdx), pDrawData->TotalIdxCount, "ImGuiImpl IB", RHIMemoryType::CPUToGPU));
+        return;
     }
 
-    ImDrawVert *pVtxDst = (ImDrawVert*) m_pVertexBuffer[frameIndex]->GetBuffer()->GetCPUAddress();
-    ImDrawIdx *pIdxDst = (ImDrawIdx*) m_pIndexBuffer[frameIndex]->GetBuffer()->GetCPUAddress();
+    // Indices are rebased to the first vertex of the frame, so commands of different draw lists can share a draw
+    ImDrawVert* pVtxDst = (ImDrawVert*) vertices.m_pCPUAddress;
+    uint32_t* pIdxDst = (uint32_t*) indices.m_pCPUAddress;
+    uint32_t globalVtxOffset = 0;
     for (int n = 0; n < pDrawData->CmdListsCount; ++ n)
     {
         const ImDrawList* pCmdList = pDrawData->CmdLists[n];
-        memcpy(pVtxDst, pCmdList->VtxBuffer.Data, pCmdList->VtxBuffer.Size * sizeof(ImDrawVert));
-        memcpy(pIdxDst, pCmdList->IdxBuffer.Data, pCmdList->IdxBuffer.Size * sizeof(ImDrawIdx));
+        memcpy(pVtxDst + globalVtxOffset, pCmdList->VtxBuffer.Data, pCmdList->VtxBuffer.Size * sizeof(ImDrawVert));
 
-        pVtxDst += pCmdList->VtxBuffer.Size;
-        pIdxDst += pCmdList->IdxBuffer.Size;
+        for (int cmdIndex = 0; cmdIndex < pCmdList->CmdBuffer.Size; ++cmdIndex)
+        {
+            const ImDrawCmd& cmd = pCmdList->CmdBuffer[cmdIndex];
+            uint32_t vtxOffset = globalVtxOffset + cmd.VtxOffset;
+            for (uint32_t i = cmd.IdxOffset; i < cmd.IdxOffset + cmd.ElemCount; ++i)
+            {
+                *pIdxDst++ = pCmdList->IdxBuffer.Data[i] + vtxOffset;
+            }
+        }
+        globalVtxOffset += pCmdList->VtxBuffer.Size;
     }
 
-    SetupRenderStates(pCommandList, frameIndex);
-
-    int globalVtxOffset = 0;
-    int globalIdxOffset = 0;
+    SetupRenderStates(pCommandList, indices);
 
     ImVec2 clipOff = pDrawData->DisplayPos;
     ImVec2 clipScale = pDrawData->FramebufferScale;
     uint32_t viewportWidth = pDrawData->DisplaySize.x * clipScale.x;
     uint32_t viewportHeight = pDrawData->DisplaySize.y * clipScale.y;
 
+    // Adjacent commands with the same texture and scissor are drawn together, the state is set only when it changes
+    struct Draw
+    {
+        IRHIDescriptor* m_pTexture = nullptr;
+        uint32_t m_scissor[4] = {};
+        uint32_t m_firstIndex = 0;
+        uint32_t m_indexCount = 0;
+    };
+
+    Draw pendingDraw;
+    IRHIDescriptor* pBoundTexture = nullptr;
+    uint32_t boundScissor[4] = { UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX };
+
+    auto flush = [&]()
+    {
+        if (pendingDraw.m_indexCount == 0)
+        {
+            return;
+        }
+
+        if (memcmp(boundScissor, pendingDraw.m_scissor, sizeof(boundScissor)) != 0)
+        {
+            pCommandList->SetScissorRect(pendingDraw.m_scissor[0], pendingDraw.m_scissor[1], pendingDraw.m_scissor[2], pendingDraw.m_scissor[3]);
+            memcpy(boundScissor, pendingDraw.m_scissor, sizeof(boundScissor));
+        }
+
+        if (pBoundTexture != pendingDraw.m_pTexture)
+        {
+            uint32_t resourceIDs[4] = {
+                vertices.m_pSRV->GetHeapIndex(),
+                vertices.m_offset,
+                pendingDraw.m_pTexture->GetHeapIndex(),
+                m_pRenderer->GetLinearSampler()->GetHeapIndex()};
+
+            pCommandList->SetGraphicsConstants(0, resourceIDs, sizeof(resourceIDs));
+            pBoundTexture = pendingDraw.m_pTexture;
+        }
+
+        pCommandList->DrawIndexed(pendingDraw.m_indexCount, 1, pendingDraw.m_firstIndex);
+        pendingDraw.m_indexCount = 0;
+        ++m_drawCount;
+    };
+
+    uint32_t globalIdxOffset = 0;
     for (int n = 0; n < pDrawData->CmdListsCount; ++n)
     {
         const ImDrawList* pCmdList = pDrawData->CmdLists[n];
         for (int cmdIndex = 0; cmdIndex < pCmdList->CmdBuffer.Size; ++cmdIndex)
         {
             const ImDrawCmd* pCmd = &pCmdList->CmdBuffer[cmdIndex];
+            ++m_commandCount;
 
             if (pCmd->UserCallback != NULL)
             {
+                flush();
+
                 // User callback, registered via ImDrawList::AddCallback()
                 // (ImDrawCallback_ResetRenderState is a special callback value used by the user to request the renderer to reset render state.)
                 if (pCmd->UserCallback == ImDrawCallback_ResetRenderState)
                 {
-                    SetupRenderStates(pCommandList, frameIndex);
+                    SetupRenderStates(pCommandList, indices);
                 }else
                 {
                     pCmd->UserCallback(pCmdList, pCmd);
                 }
+
+                pBoundTexture = nullptr;
+                boundScissor[0] = UINT32_MAX;
             }else
             {
                 ImVec2 clipMin((pCmd->ClipRect.x - clipOff.x) * clipScale.x, (pCmd->ClipRect.y - clipOff.y) * clipScale.y);
                 ImVec2 clipMax((pCmd->ClipRect.z - clipOff.x) * clipScale.x, (pCmd->ClipRect.w - clipOff.y) * clipScale.y);
-                if (clipMax.x <= clipMin.x || clipMax.y <= clipMin.y)
+                if (clipMax.x > clipMin.x && clipMax.y > clipMin.y && pCmd->ElemCount > 0)
                 {
-                    continue;
+                    Draw draw;
+                    draw.m_pTexture = (IRHIDescriptor*) pCmd->TextureId;
+                    draw.m_scissor[0] = (uint32_t) eastl::max(clipMin.x, 0.0f);
+                    draw.m_scissor[1] = (uint32_t) eastl::max(clipMin.y, 0.0f);
+                    draw.m_scissor[2] = eastl::clamp((uint32_t) (clipMax.x - clipMin.x), 0u, viewportWidth);
+                    draw.m_scissor[3] = eastl::clamp((uint32_t) (clipMax.y - clipMin.y), 0u, viewportHeight);
+                    draw.m_firstIndex = globalIdxOffset;
+                    draw.m_indexCount = pCmd->ElemCount;
+
+                    bool bMergeable = pendingDraw.m_indexCount > 0 && pendingDraw.m_pTexture == draw.m_pTexture &&
+                        memcmp(pendingDraw.m_scissor, draw.m_scissor, sizeof(draw.m_scissor)) == 0 &&
+                        pendingDraw.m_firstIndex + pendingDraw.m_indexCount == draw.m_firstIndex;
+
+                    if (bMergeable)
+                    {
+                        pendingDraw.m_indexCount += draw.m_indexCount;
+                    }
+                    else
+                    {
+                        flush();
+                        pendingDraw = draw;
+                    }
                 }
-
-                pCommandList->SetScissorRect(
-                    eastl::max(clipMin.x, 0.0f),
-                    eastl::max(clipMin.y, 0.0f),
-                    eastl::clamp((uint32_t)(clipMax.x - clipMin.x), 0u, viewportWidth),
-                    eastl::clamp((uint32_t)(clipMax.y - clipMin.y), 0u, viewportHeight));
-
-                uint32_t resourceIDs[4] = {
-                    m_pVertexBuffer[frameIndex]->GetSRV()->GetHeapIndex(),
-                    pCmd->VtxOffset + globalVtxOffset,
-                    ((IRHIDescriptor*)pCmd->TextureId)->GetHeapIndex(),
-                    m_pRenderer->GetLinearSampler()->GetHeapIndex()};
-
-                pCommandList->SetGraphicsConstants(0, resourceIDs, sizeof(resourceIDs));
-                pCommandList->DrawIndexed(pCmd->ElemCount, 1, pCmd->IdxOffset + globalIdxOffset);
             }
+            globalIdxOffset += pCmd->ElemCount;
         }
-        globalVtxOffset += pCmdList->VtxBuffer.Size;
-        globalIdxOffset += pCmdList->IdxBuffer.Size;
     }
+    flush();
 }
 
-void ImGuiImpl::SetupRenderStates(IRHICommandList* pCommandList, uint32_t frameIndex)
+void ImGuiImpl::SetupRenderStates(IRHICommandList* pCommandList, const UploadRingAllocation& indices)
 {
     ImDrawData *pDrawData = ImGui::GetDrawData();
 
@@ -194,7 +251,7 @@ void ImGuiImpl::SetupRenderStates(IRHICommandList* pCommandList, uint32_t frameI
         (uint32_t)(pDrawData->DisplaySize.x * pDrawData->FramebufferScale.x),
         (uint32_t)(pDrawData->DisplaySize.y * pDrawData->FramebufferScale.y));
     pCommandList->SetPipelineState(m_pPSO);
-    pCommandList->SetIndexBuffer(m_pIndexBuffer[frameIndex]->GetBuffer(), 0, m_pIndexBuffer[frameIndex]->GetFormat());
+    pCommandList->SetIndexBuffer(indices.m_pBuffer, indices.m_offset, RHIFormat::R32UI);
     
     float left = pDrawData->DisplayPos.x;
     float right = pDrawData->DisplayPos.x + pDrawData->DisplaySize.x;
@@ -1,26 +1,32 @@
 #pragma once
 
 #include "Renderer/Renderer.h"
+#include "Renderer/UploadRingBuffer.h"
 #include "EASTL/functional.h"
 
 class ImGuiImpl
 {
 public:
-    ImGuiImpl(Renderer* pRenderer);
+    ImGuiImpl(Renderer* pRenderer, UploadRingBuffer* pRingBuffer);
     ~ImGuiImpl();
 
     bool Init();
     void NewFrame();
     void Render(IRHICommandList* pCommandList);
 
+    uint32_t GetCommandCount() const { return m_commandCount; }     //< Of the last frame
+    uint32_t GetDrawCount() const { return m_drawCount; }
+
 private:
-    void SetupRenderStates(IRHICommandList* pCommandList, uint32_t frameIndex);
+    void SetupRenderStates(IRHICommandList* pCommandList, const UploadRingAllocation& indices);
     
 private:
     Renderer* m_pRenderer = nullptr;
+    UploadRingBuffer* m_pRingBuffer = nullptr;
     IRHIPipelineState* m_pPSO = nullptr;
 
     eastl::unique_ptr<Texture2D> m_pFontTexture;
-    eastl::unique_ptr<StructedBuffer> m_pVertexBuffer[RHI_MAX_INFLIGHT_FRAMES];
-    eastl::unique_ptr<IndexBuffer> m_pIndexBuffer[RHI_MAX_INFLIGHT_FRAMES];
+
+    uint32_t m_commandCount = 0;
+    uint32_t m_drawCount = 0;
 };
\ No newline at end of file
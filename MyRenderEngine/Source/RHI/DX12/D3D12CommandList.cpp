@@ -28,6 +28,7 @@ D3D12CommandList::~D3D12CommandList()
     D3D12Device* pDevice = (D3D12Device*) m_pDevice;
     pDevice->Delete(m_pCommandAllocator);
     pDevice->Delete(m_pCommandList);
+    pDevice->Delete(m_pTimestampHeap);
 }
 bool D3D12CommandList::Create()
 {
@@ -90,12 +91,36 @@ bool D3D12CommandList::Create()
     }
 
     m_pCommandList->Close();
+
+    if (m_queueType != RHICommandQueue::Copy || pDevice->IsCopyQueueTimestampSupported())
+    {
+        D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+        queryHeapDesc.Type = m_queueType == RHICommandQueue::Copy ? D3D12_QUERY_HEAP_TYPE_COPY_QUEUE_TIMESTAMP : D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+        queryHeapDesc.Count = RHI_MAX_TIMESTAMP_QUERIES;
+
+        hResult = pD3D12Device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_pTimestampHeap));
+        if (FAILED(hResult))
+        {
+            MY_ERROR("[Command List] failed to create timestamp query heap {}", m_name);
+            return false;
+        }
+        m_pTimestampHeap->SetName(string_to_wstring(m_name + " timestamp heap").c_str());
+
+        RHIBufferDesc readbackDesc;
+        readbackDesc.m_size = sizeof(uint64_t) * RHI_MAX_TIMESTAMP_QUERIES;
+        readbackDesc.m_memoryType = RHIMemoryType::GPUToCPU;
+        m_pTimestampReadback.reset(pDevice->CreateBuffer(readbackDesc, m_name + " timestamp readback"));
+    }
+
     return true;
 }
 
 void D3D12CommandList::ResetAllocator()
 {
     m_pCommandAllocator->Reset();
+
+    m_timestampCount = 0;
+    m_resolvedTimestampCount = 0;
 }
 
 void D3D12CommandList::Begin()
@@ -109,6 +134,14 @@ void D3D12CommandList::Begin()
 void D3D12CommandList::End()
 {
     FlushBarriers();
+
+    if (m_timestampCount > m_resolvedTimestampCount)
+    {
+        m_pCommandList->ResolveQueryData(m_pTimestampHeap, D3D12_QUERY_TYPE_TIMESTAMP, m_resolvedTimestampCount, m_timestampCount - m_resolvedTimestampCount,
+            (ID3D12Resource*) m_pTimestampReadback->GetHandle(), sizeof(uint64_t) * m_resolvedTimestampCount);
+        m_resolvedTimestampCount = m_timestampCount;
+    }
+
     m_pCommandList->Close();
 }
 
@@ -209,6 +242,25 @@ void D3D12CommandList::EndEvent()
     ags::EndEvent(m_pCommandList);
 }
 
+uint32_t D3D12CommandList::WriteTimestamp()
+{
+    if (m_pTimestampHeap == nullptr || m_timestampCount == RHI_MAX_TIMESTAMP_QUERIES)
+    {
+        return RHI_INVALID_RESOURCE;
+    }
+
+    m_pCommandList->EndQuery(m_pTimestampHeap, D3D12_QUERY_TYPE_TIMESTAMP, m_timestampCount);
+    ++m_commandCount;   //< The list must be executed for the query to be resolved
+
+    return m_timestampCount++;
+}
+
+const uint64_t* D3D12CommandList::ReadTimestamps(uint32_t& count) const
+{
+    count = m_resolvedTimestampCount;
+    return count > 0 ? (const uint64_t*) m_pTimestampReadback->GetCPUAddress() : nullptr;
+}
+
 void D3D12CommandList::CopyBufferToTexture(IRHITexture* pDstTexture, uint32_t mipLevel, uint32_t arraySlice, IRHIBuffer* pSrcBuffer, uint32_t offset)
 {
     FlushBarriers();
@@ -391,7 +443,7 @@ void D3D12CommandList::UpdateTileMappings(IRHITexture* pTexture, IRHIHeap* pHeap
         D3D12_TILE_MAPPING_FLAG_NONE);
 }
 
-void D3D12CommandList::TextureBarrier(IRHITexture* pTexture, uint32_t subresource, RHIAccessFlags accessBefore, RHIAccessFlags accessAfter)
+void D3D12CommandList::TextureBarrier(IRHITexture* pTexture, uint32_t subresource, RHIAccessFlags accessBefore, RHIAccessFlags accessAfter, RHIBarrierSplit split)
 {
     D3D12_TEXTURE_BARRIER barrier = {};
     barrier.SyncBefore = RHIToD3D12BarrierSync(accessBefore);
@@ -402,6 +454,7 @@ void D3D12CommandList::TextureBarrier(IRHITexture* pTexture, uint32_t subresourc
     barrier.LayoutAfter = RHIToD3D12BarrierLayout(accessAfter);
     barrier.pResource = (ID3D12Resource*) pTexture->GetHandle();
     barrier.Subresources = CD3DX12_BARRIER_SUBRESOURCE_RANGE(subresource);
+    ApplyBarrierSplit(split, barrier.SyncBefore, barrier.SyncAfter);
 
     if (accessBefore & RHIAccessBit::RHIAccessDiscard)
     {
@@ -411,7 +464,7 @@ void D3D12CommandList::TextureBarrier(IRHITexture* pTexture, uint32_t subresourc
     m_textureBarriers.push_back(barrier);
 }
 
-void D3D12CommandList::BufferBarrier(IRHIBuffer* pBuffer, RHIAccessFlags accessBefore, RHIAccessFlags accessAfter)
+void D3D12CommandList::BufferBarrier(IRHIBuffer* pBuffer, RHIAccessFlags accessBefore, RHIAccessFlags accessAfter, RHIBarrierSplit split)
 {
     D3D12_BUFFER_BARRIER barrier = {};
     barrier.SyncBefore = RHIToD3D12BarrierSync(accessBefore);
@@ -421,6 +474,7 @@ void D3D12CommandList::BufferBarrier(IRHIBuffer* pBuffer, RHIAccessFlags accessB
     barrier.pResource = (ID3D12Resource*) pBuffer->GetHandle();
     barrier.Offset = 0;
     barrier.Size = UINT64_MAX;
+    ApplyBarrierSplit(split, barrier.SyncBefore, barrier.SyncAfter);
 
     m_bufferBarriers.push_back(barrier);
 }
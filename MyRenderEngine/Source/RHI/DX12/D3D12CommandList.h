@@ -1,6 +1,8 @@
 #pragma once
 #include "D3D12Headers.h"
 #include "RHI/RHICommandList.h"
+#include "RHI/RHIBuffer.h"
+#include "EASTL/unique_ptr.h"
 
 class D3D12CommandList : public IRHICommandList
 {
@@ -26,6 +28,8 @@ public:
     virtual void EndProfiling() override;
     virtual void BeginEvent(const eastl::string& eventName) override;
     virtual void EndEvent() override;
+    virtual uint32_t WriteTimestamp() override;
+    virtual const uint64_t* ReadTimestamps(uint32_t& count) const override;
     
     virtual void CopyBufferToTexture(IRHITexture* pDstTexture, uint32_t mipLevel, uint32_t arraySize, IRHIBuffer* pSrcBuffer, uint32_t offset) override;
     virtual void CopyTextureToBuffer(IRHIBuffer* pDstBuffer, IRHITexture* pSrcTexture, uint32_t mipLevel, uint32_t arraySize) override;
@@ -36,8 +40,8 @@ public:
     virtual void WriteBuffer(IRHIBuffer* pBuffer, uint32_t offset, uint32_t data) override;
     virtual void UpdateTileMappings(IRHITexture* pTexture, IRHIHeap* pHeap, uint32_t mappingCount, const RHITileMapping* pMappings) override;
 
-    virtual void TextureBarrier(IRHITexture* pTexture, uint32_t subResource, RHIAccessFlags accessBefore, RHIAccessFlags accessAfter) override;
-    virtual void BufferBarrier(IRHIBuffer* pBuffer, RHIAccessFlags accessBefore, RHIAccessFlags accessAfter) override;
+    virtual void TextureBarrier(IRHITexture* pTexture, uint32_t subResource, RHIAccessFlags accessBefore, RHIAccessFlags accessAfter, RHIBarrierSplit split = RHIBarrierSplit::None) override;
+    virtual void BufferBarrier(IRHIBuffer* pBuffer, RHIAccessFlags accessBefore, RHIAccessFlags accessAfter, RHIBarrierSplit split = RHIBarrierSplit::None) override;
     virtual void GlobalBarrier(RHIAccessFlags accessBefore, RHIAccessFlags accessAfter) override;
     virtual void FlushBarriers() override;
 
@@ -93,6 +97,11 @@ private:
     
     eastl::vector<IRHISwapChain*> m_pendingSwapChain;
 
+    ID3D12QueryHeap* m_pTimestampHeap = nullptr;            //< nullptr when the queue has no timestamp support
+    eastl::unique_ptr<IRHIBuffer> m_pTimestampReadback;
+    uint32_t m_timestampCount = 0;
+    uint32_t m_resolvedTimestampCount = 0;                  //< Written before the last End
+
 #if MICROPROFILE_GPU_TIMERS_D3D12
     struct MicroProfileThreadLogGpu* m_pProfileLog = nullptr;
     int m_profileQueue = -1;
@@ -97,14 +97,15 @@ bool D3D12ShaderResourceView::Create()
             const RHIBufferDesc& bufferDesc = ((IRHIBuffer*) m_pResource)->GetDesc();
             MY_ASSERT(bufferDesc.m_usage & RHIBufferUsageBit::RHIBufferUsageStructedBuffer);
             MY_ASSERT(m_desc.m_format == RHIFormat::Unknown);
-            MY_ASSERT(m_desc.m_buffer.m_offset % bufferDesc.m_stride == 0);
-            MY_ASSERT(m_desc.m_buffer.m_size % bufferDesc.m_stride == 0);
+            uint32_t stride = m_desc.m_buffer.m_stride != 0 ? m_desc.m_buffer.m_stride : bufferDesc.m_stride;
+            MY_ASSERT(m_desc.m_buffer.m_offset % stride == 0);
+            MY_ASSERT(m_desc.m_buffer.m_size % stride == 0);
 
             srvDesc.Format = DXGI_FORMAT_UNKNOWN;
             srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
-            srvDesc.Buffer.FirstElement = m_desc.m_buffer.m_offset / bufferDesc.m_stride;
-            srvDesc.Buffer.NumElements = m_desc.m_buffer.m_size / bufferDesc.m_stride;
-            srvDesc.Buffer.StructureByteStride = bufferDesc.m_stride;
+            srvDesc.Buffer.FirstElement = m_desc.m_buffer.m_offset / stride;
+            srvDesc.Buffer.NumElements = m_desc.m_buffer.m_size / stride;
+            srvDesc.Buffer.StructureByteStride = stride;
             break;
         }
 
@@ -112,13 +113,14 @@ bool D3D12ShaderResourceView::Create()
         {
             const RHIBufferDesc& bufferDesc = ((IRHIBuffer*)m_pResource)->GetDesc();
             MY_ASSERT(bufferDesc.m_usage & RHIBufferUsageBit::RHIBufferUsageTypedBuffer);
-            MY_ASSERT(m_desc.m_buffer.m_offset % bufferDesc.m_stride == 0);
-            MY_ASSERT(m_desc.m_buffer.m_size % bufferDesc.m_stride == 0);
+            uint32_t stride = m_desc.m_buffer.m_stride != 0 ? m_desc.m_buffer.m_stride : bufferDesc.m_stride;
+            MY_ASSERT(m_desc.m_buffer.m_offset % stride == 0);
+            MY_ASSERT(m_desc.m_buffer.m_size % stride == 0);
 
             srvDesc.Format = DXGIFormat(m_desc.m_format);
             srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
-            srvDesc.Buffer.FirstElement = m_desc.m_buffer.m_offset / bufferDesc.m_stride;
-            srvDesc.Buffer.NumElements = m_desc.m_buffer.m_size / bufferDesc.m_stride;
+            srvDesc.Buffer.FirstElement = m_desc.m_buffer.m_offset / stride;
+            srvDesc.Buffer.NumElements = m_desc.m_buffer.m_size / stride;
             break;
         }
 
@@ -13,15 +13,22 @@
 #include "Utils/log.h"
 #include "Utils/string.h"
 #include "Utils/math.h"
+#include "Utils/profiler.h"
 #include "magic_enum/magic_enum.hpp"
 #include "ags.h"
 #include "d3d12ma/D3D12MemAlloc.h"
 #include "PixRuntime.h"
 #include "microprofile/microprofile.h"
+#include "sokol/sokol_time.h"
+#include <thread>
 
 #pragma comment(lib, "d3d12.lib")
 #pragma comment(lib, "dxgi.lib")
 
+#define DEFERRED_DELETION_TIME_BUDGET 500   //< Microseconds per frame, retired objects over the budget wait for the next frame
+#define DEFERRED_DELETION_MIN_COUNT 64      //< Released every frame regardless of the budget, so the ring always drains
+#define DEFERRED_DELETION_BATCH_SIZE 32     //< Released outside of the lock in batches
+
 extern "C" { _declspec(dllexport) extern const UINT D3D12SDKVersion = 614; }
 extern "C" { _declspec(dllexport) extern const char* D3D12SDKPath = u8".\\D3D12\\"; }
 
@@ -70,16 +77,15 @@ static IDXGIAdapter1* FindAdapter(IDXGIFactory6* pDXGIFactory, D3D_FEATURE_LEVEL
     return selectAdapter == nullptr ? nullptr : *selectAdapter;
 }
 
-D3D12DescriptorAllocator::D3D12DescriptorAllocator(ID3D12Device* pDevice, D3D12_DESCRIPTOR_HEAP_TYPE heapType, bool shaderVisible, uint32_t descriptorCount, const eastl::string& name)
+D3D12DescriptorAllocator::D3D12DescriptorAllocator(ID3D12Device* pDevice, D3D12_DESCRIPTOR_HEAP_TYPE heapType, bool shaderVisible, uint32_t descriptorCount, const eastl::string& name) :
+    m_allocator(descriptorCount, name)
 {
     m_descriptorSize = pDevice->GetDescriptorHandleIncrementSize(heapType);
-    m_descriptorCount = descriptorCount;
-    m_allocatedCount = 0;
     m_shaderVisible = shaderVisible;
 
     D3D12_DESCRIPTOR_HEAP_DESC desc = {};
     desc.Type = heapType;
-    desc.NumDescriptors = m_descriptorCount;
+    desc.NumDescriptors = descriptorCount;
     if (m_shaderVisible)
     {
         desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
@@ -94,24 +100,20 @@ D3D12DescriptorAllocator::~D3D12DescriptorAllocator()
     SAFE_RELEASE(m_pHeap);
 }
 
-D3D12Descriptor D3D12DescriptorAllocator::Allocate()
+D3D12Descriptor D3D12DescriptorAllocator::Allocate(uint32_t count)
 {
-    if (!m_freeDescriptors.empty())
+    uint32_t index = m_allocator.Allocate(count);
+    if (index == RHI_INVALID_RESOURCE)
     {
-        D3D12Descriptor descriptor = m_freeDescriptors.back();
-        m_freeDescriptors.pop_back();
-        return descriptor;
+        return D3D12Descriptor();
     }
 
-    MY_ASSERT(m_allocatedCount <= m_descriptorCount);
-    D3D12Descriptor descriptor = GetDescriptor(m_allocatedCount);
-    ++m_allocatedCount;
-    return descriptor;
+    return GetDescriptor(index);
 }
 
-void D3D12DescriptorAllocator::Free(const D3D12Descriptor& descriptor)
+void D3D12DescriptorAllocator::Free(const D3D12Descriptor& descriptor, uint64_t frameID, uint32_t count)
 {
-    m_freeDescriptors.push_back(descriptor);
+    m_allocator.DeferredFree(descriptor.index, count, frameID);
 }
 
 D3D12Descriptor D3D12DescriptorAllocator::GetDescriptor(uint32_t index) const
@@ -127,33 +129,180 @@ D3D12Descriptor D3D12DescriptorAllocator::GetDescriptor(uint32_t index) const
     return descriptor;
 }
 
-D3D12ConstantBufferAllocator::D3D12ConstantBufferAllocator(D3D12Device* pDevice, uint32_t size, const eastl::string& name)
+D3D12ConstantBufferAllocator::D3D12ConstantBufferAllocator(D3D12Device* pDevice, const eastl::string& name)
 {
+    m_pDevice = pDevice;
+    m_name = name;
+
     RHIBufferDesc desc = {};
-    desc.m_size = size;
+    desc.m_size = D3D12_CB_BLOCK_SIZE;
     desc.m_memoryType = RHIMemoryType::CPUToGPU;
     desc.m_usage = RHIBufferUsageBit::RHIBufferUsageConstantBuffer;
 
-    m_pBuffer.reset(pDevice->CreateBuffer(desc, name));
+    m_pBlocks[0].reset(pDevice->CreateBuffer(desc, name));
+    m_blockCount = 1;
 }
 
-void D3D12ConstantBufferAllocator::Allocate(uint32_t size, void** ppCPUAddress, uint64_t* pGPUAddress)
+uint64_t D3D12ConstantBufferAllocator::Allocate(const void* data, uint32_t size)
 {
-    MY_ASSERT(m_allocatedSize + size <= m_pBuffer->GetDesc().m_size);
-    *ppCPUAddress = static_cast<char*>(m_pBuffer->GetCPUAddress()) + m_allocatedSize;
-    *pGPUAddress = m_pBuffer->GetGPUAddress() + m_allocatedSize;
-    
-    m_allocatedSize += RoundUpPow2(size, 256); //< Aligment a mutiple of 256    
+    MY_ASSERT(size > 0);
+    uint32_t alignedSize = RoundUpPow2(size, 256); //< Aligment a mutiple of 256
+
+    if (alignedSize > D3D12_CB_PAGE_SIZE)
+    {
+        char* pCPUAddress;
+        uint64_t gpuAddress;
+        CarveRange(alignedSize, &pCPUAddress, &gpuAddress);
+        memcpy(pCPUAddress, data, size);
+
+        m_largeRequestedBytes += size;
+        m_largeUsedBytes += alignedSize;
+        return gpuAddress;
+    }
+
+    ThreadPage& page = GetThreadPage();
+    std::lock_guard<std::mutex> lock(page.m_mutex);
+
+    page.m_requestedBytes += size;
+
+    // CBV addresses must be 256 bytes aligned, so small payloads can't share a slot unless they are identical,
+    // which is common for per draw constants set again with unchanged values
+    if (page.m_lastSmallSize == size && memcmp(page.m_lastSmallData, data, size) == 0)
+    {
+        page.m_sharedBytes += size;
+        return page.m_gpuAddress + page.m_lastSmallOffset;
+    }
+
+    if (page.m_offset + alignedSize > page.m_size)
+    {
+        page.m_wastedBytes += page.m_size - page.m_offset;
+
+        CarveRange(D3D12_CB_PAGE_SIZE, &page.m_pCPUAddress, &page.m_gpuAddress);
+        page.m_offset = 0;
+        page.m_size = D3D12_CB_PAGE_SIZE;
+        page.m_lastSmallSize = 0;
+        ++page.m_pageCount;
+    }
+
+    uint32_t offset = page.m_offset;
+    memcpy(page.m_pCPUAddress + offset, data, size);
+
+    page.m_offset += alignedSize;
+    page.m_usedBytes += alignedSize;
+    page.m_wastedBytes += alignedSize - size;
+
+    if (size <= D3D12_CB_SMALL_SIZE)
+    {
+        memcpy(page.m_lastSmallData, data, size);
+        page.m_lastSmallOffset = offset;
+        page.m_lastSmallSize = size;
+    }
+
+    return page.m_gpuAddress + offset;
 }
 
 void D3D12ConstantBufferAllocator::Reset()
 {
-    m_allocatedSize = 0;
+    for (uint32_t i = 0; i < D3D12_CB_THREAD_PAGE_COUNT; ++i)
+    {
+        ThreadPage& page = m_pages[i];
+        page.m_pCPUAddress = nullptr;
+        page.m_gpuAddress = 0;
+        page.m_offset = 0;
+        page.m_size = 0;
+        page.m_lastSmallSize = 0;
+        page.m_requestedBytes = 0;
+        page.m_usedBytes = 0;
+        page.m_wastedBytes = 0;
+        page.m_sharedBytes = 0;
+        page.m_pageCount = 0;
+    }
+
+    m_blockCursor = 0;
+    m_largeRequestedBytes = 0;
+    m_largeUsedBytes = 0;
+}
+
+D3D12ConstantBufferStats D3D12ConstantBufferAllocator::GetStats()
+{
+    D3D12ConstantBufferStats stats;
+
+    for (uint32_t i = 0; i < D3D12_CB_THREAD_PAGE_COUNT; ++i)
+    {
+        ThreadPage& page = m_pages[i];
+        std::lock_guard<std::mutex> lock(page.m_mutex);
+
+        stats.m_requestedBytes += page.m_requestedBytes;
+        stats.m_usedBytes += page.m_usedBytes;
+        stats.m_wastedBytes += page.m_wastedBytes + (page.m_size - page.m_offset);
+        stats.m_sharedBytes += page.m_sharedBytes;
+        stats.m_pageCount += page.m_pageCount;
+    }
+
+    uint64_t largeRequestedBytes = m_largeRequestedBytes.load();
+    uint64_t largeUsedBytes = m_largeUsedBytes.load();
+
+    stats.m_requestedBytes += largeRequestedBytes;
+    stats.m_usedBytes += largeUsedBytes;
+    stats.m_wastedBytes += largeUsedBytes - largeRequestedBytes;
+    stats.m_reservedBytes = (uint64_t) m_blockCount.load() * D3D12_CB_BLOCK_SIZE;
+    stats.m_blockCount = (uint32_t) (m_blockCursor.load() >> 32) + 1;
+
+    return stats;
+}
+
+D3D12ConstantBufferAllocator::ThreadPage& D3D12ConstantBufferAllocator::GetThreadPage()
+{
+    static thread_local uint32_t pageIndex = (uint32_t) (std::hash<std::thread::id>()(std::this_thread::get_id()) % D3D12_CB_THREAD_PAGE_COUNT);
+    return m_pages[pageIndex];
+}
+
+void D3D12ConstantBufferAllocator::CarveRange(uint32_t size, char** ppCPUAddress, uint64_t* pGPUAddress)
+{
+    MY_ASSERT(size <= D3D12_CB_BLOCK_SIZE);
+
+    while (true)
+    {
+        uint64_t cursor = m_blockCursor.fetch_add(size);
+        uint32_t block = (uint32_t) (cursor >> 32);
+        uint32_t offset = (uint32_t) cursor;
+
+        if ((uint64_t) offset + size <= D3D12_CB_BLOCK_SIZE)
+        {
+            IRHIBuffer* pBlock = m_pBlocks[block].get();
+            *ppCPUAddress = (char*) pBlock->GetCPUAddress() + offset;
+            *pGPUAddress = pBlock->GetGPUAddress() + offset;
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_growMutex);
+
+        // Another thread has already moved on to the next block
+        if ((uint32_t) (m_blockCursor.load() >> 32) != block)
+        {
+            continue;
+        }
+
+        uint32_t nextBlock = block + 1;
+        if (nextBlock == m_blockCount.load())
+        {
+            MY_ASSERT(nextBlock < D3D12_CB_MAX_BLOCKS);
+
+            RHIBufferDesc desc = m_pBlocks[0]->GetDesc();
+            m_pBlocks[nextBlock].reset(m_pDevice->CreateBuffer(desc, fmt::format("{} {}", m_name, nextBlock).c_str()));
+            m_blockCount = nextBlock + 1;
+
+            MY_INFO("[{}] frame constants overflowed, grown to {} MB", m_name, (uint64_t) m_blockCount.load() * D3D12_CB_BLOCK_SIZE / (1024 * 1024));
+        }
+
+        m_blockCursor = (uint64_t) nextBlock << 32;
+    }
 }
 
 D3D12Device::D3D12Device(const RHIDeviceDesc& desc)
 {
     m_desc = desc;
+    m_retirementRing.resize(1024);
 }
 
 D3D12Device::~D3D12Device()
@@ -222,6 +371,15 @@ void D3D12Device::BeginFrame()
 
 void D3D12Device::EndFrame()
 {
+    D3D12ConstantBufferStats cbStats = m_pConstantBufferAllocator[m_frameID % RHI_MAX_INFLIGHT_FRAMES]->GetStats();
+    MICROPROFILE_COUNTER_SET("RHI/ConstantBuffer/RequestedBytes", cbStats.m_requestedBytes);
+    MICROPROFILE_COUNTER_SET("RHI/ConstantBuffer/UsedBytes", cbStats.m_usedBytes);
+    MICROPROFILE_COUNTER_SET("RHI/ConstantBuffer/WastedBytes", cbStats.m_wastedBytes);
+    MICROPROFILE_COUNTER_SET("RHI/ConstantBuffer/SharedBytes", cbStats.m_sharedBytes);
+    MICROPROFILE_COUNTER_SET("RHI/ConstantBuffer/ReservedBytes", cbStats.m_reservedBytes);
+    MICROPROFILE_COUNTER_SET("RHI/ConstantBuffer/Pages", cbStats.m_pageCount);
+    MICROPROFILE_COUNTER_SET("RHI/ConstantBuffer/Blocks", cbStats.m_blockCount);
+
     ++ m_frameID;
     m_pResourceAllocator->SetCurrentFrameIndex((UINT) m_frameID);
 }
@@ -418,6 +576,63 @@ uint32_t D3D12Device::GetAllocationSize(const RHITextureDesc& desc)
     return (uint32_t) info.SizeInBytes;
 }
 
+uint32_t D3D12Device::GetSmallAllocationSize(const RHITextureDesc& desc)
+{
+    D3D12_RESOURCE_DESC resourceDesc = RHIToD3D12ResourceDesc(desc);
+    D3D12_RESOURCE_ALLOCATION_INFO info = GetSmallResourceAllocationInfo(m_pD3D12Device, resourceDesc);
+    return (uint32_t) info.SizeInBytes;
+}
+
+void D3D12Device::GetDescriptorAllocatorStats(eastl::vector<RHIDescriptorAllocatorStats>& stats)
+{
+    stats.push_back(m_pResourceDescriptorAllocator->GetStats());
+    stats.push_back(m_pSamplerAllocator->GetStats());
+    stats.push_back(m_pRTVAllocator->GetStats());
+    stats.push_back(m_pDSVAllocator->GetStats());
+    stats.push_back(m_pNonShaderVisibleUAVAllocator->GetStats());
+}
+
+uint64_t D3D12Device::GetTimestampFrequency(RHICommandQueue queue)
+{
+    uint64_t frequency = 0;
+    GetQueue(queue)->GetTimestampFrequency(&frequency);
+    return frequency;
+}
+
+bool D3D12Device::GetTimestampCalibration(RHICommandQueue queue, uint64_t& gpuTimestamp, double& cpuTimeUs)
+{
+    uint64_t cpuTimestamp = 0;
+    if (FAILED(GetQueue(queue)->GetClockCalibration(&gpuTimestamp, &cpuTimestamp)))
+    {
+        return false;
+    }
+
+    // The calibration is in QPC ticks, move it to the sokol_time clock by the time elapsed since then
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    double nowUs = stm_us(stm_now());
+
+    cpuTimeUs = nowUs - (double) (counter.QuadPart - (int64_t) cpuTimestamp) * 1000000.0 / frequency.QuadPart;
+    return true;
+}
+
+ID3D12CommandQueue* D3D12Device::GetQueue(RHICommandQueue queue) const
+{
+    switch (queue)
+    {
+        case RHICommandQueue::Graphics:
+            return m_pGraphicsQueue;
+        case RHICommandQueue::Compute:
+            return m_pComputeQueue;
+        case RHICommandQueue::Copy:
+            return m_pCopyQueue;
+        default:
+            MY_ASSERT(false);
+            return nullptr;
+    }
+}
+
 bool D3D12Device::Init()
 {
     UINT dxgiFactoryFlag = 0;
@@ -544,7 +759,7 @@ bool D3D12Device::Init()
     for (uint32_t i = 0; i < RHI_MAX_INFLIGHT_FRAMES; ++i)
     {
         eastl::string name = fmt::format("CB Allocator {}", i).c_str();
-        m_pConstantBufferAllocator[i] = eastl::make_unique<D3D12ConstantBufferAllocator> (this, 8 * 1024 * 1024, name);
+        m_pConstantBufferAllocator[i] = eastl::make_unique<D3D12ConstantBufferAllocator> (this, name);
     }
 
     m_pRTVAllocator = eastl::make_unique<D3D12DescriptorAllocator> (m_pD3D12Device, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, false, 512, "RTV Heap");
@@ -573,14 +788,8 @@ bool D3D12Device::Init()
 
 D3D12_GPU_VIRTUAL_ADDRESS D3D12Device::AllocateConstantBuffer(const void* data, size_t dataSize)
 {
-    void* cpuAddress;
-    uint64_t gpuAddress;
-    
     uint32_t index = m_frameID % RHI_MAX_INFLIGHT_FRAMES;
-    m_pConstantBufferAllocator[index]->Allocate((uint32_t) dataSize, &cpuAddress, &gpuAddress);
-
-    memcpy(cpuAddress, data, dataSize);
-    return gpuAddress;
+    return m_pConstantBufferAllocator[index]->Allocate(data, (uint32_t) dataSize);
 }
 
 void D3D12Device::FlushDeferredDeletions()
@@ -592,7 +801,7 @@ void D3D12Device::Delete(IUnknown* pObject)
 {
     if (pObject)
     {
-        m_objectDeletionQueue.push({ pObject, m_frameID });
+        Retire(pObject, nullptr);
     }
 }
 
@@ -600,7 +809,7 @@ void D3D12Device::Delete(D3D12MA::Allocation* pAllocation)
 {
     if (pAllocation)
     {
-        m_allocationDeletionQueue.push({ pAllocation, m_frameID });
+        Retire(nullptr, pAllocation);
     }
 }
 
@@ -608,7 +817,7 @@ void D3D12Device::DeleteRTV(const D3D12Descriptor& descriptor)
 {
     if (!IsNullDescriptor(descriptor))
     {
-        m_rtvDeletionQueue.push({descriptor, m_frameID});
+        m_pRTVAllocator->Free(descriptor, m_frameID);
     }
 }
 
@@ -616,15 +825,15 @@ void D3D12Device::DeleteDSV(const D3D12Descriptor& descriptor)
 {
     if (!IsNullDescriptor(descriptor))
     {
-        m_dsvDeletionQueue.push({ descriptor, m_frameID });
+        m_pDSVAllocator->Free(descriptor, m_frameID);
     }
 }
 
-void D3D12Device::DeleteResoruce(const D3D12Descriptor& descriptor)
+void D3D12Device::DeleteResoruce(const D3D12Descriptor& descriptor, uint32_t count)
 {
     if (!IsNullDescriptor(descriptor))
     {
-        m_resourceDeletionQueue.push({ descriptor, m_frameID });
+        m_pResourceDescriptorAllocator->Free(descriptor, m_frameID, count);
     }
 }
 
@@ -632,7 +841,7 @@ void D3D12Device::DeleteSampler(const D3D12Descriptor& descriptor)
 {
     if (!IsNullDescriptor(descriptor))
     {
-        m_samplerDeletionQueue.push({ descriptor, m_frameID });
+        m_pSamplerAllocator->Free(descriptor, m_frameID);
     }
 }
 
@@ -640,94 +849,101 @@ void D3D12Device::DeleteNonShaderVisiableUAV(const D3D12Descriptor& descriptor)
 {
     if (!IsNullDescriptor(descriptor))
     {
-        m_nonShaderVisibleUAVDeletionQueue.push({ descriptor, m_frameID });
+        m_pNonShaderVisibleUAVAllocator->Free(descriptor, m_frameID);
     }
 }
 
-void D3D12Device::DoDeferredDeletion(bool forceDelete)
+void D3D12Device::Retire(IUnknown* pObject, D3D12MA::Allocation* pAllocation)
 {
-    while (!m_objectDeletionQueue.empty())
-    {
-        auto item = m_objectDeletionQueue.front();
-        if(!forceDelete && item.m_frame + m_desc.m_maxFrameDelay > m_frameID)
-        {
-            break;
-        }
+    uint64_t size = pAllocation ? pAllocation->GetSize() : 0;
+    m_pendingReleaseBytes += size;
 
-        SAFE_RELEASE(item.m_pObject);
-        m_objectDeletionQueue.pop();
-    }
+    std::lock_guard<std::mutex> lock(m_retirementMutex);
 
-    while (!m_allocationDeletionQueue.empty())
+    uint32_t capacity = (uint32_t) m_retirementRing.size();
+    if (m_retirementCount == capacity)
     {
-        auto item = m_allocationDeletionQueue.front();
-        if (!forceDelete && item.m_frame + m_desc.m_maxFrameDelay > m_frameID)
+        eastl::vector<Retirement> ring(capacity * 2);
+        for (uint32_t i = 0; i < m_retirementCount; ++i)
         {
-            break;
+            ring[i] = m_retirementRing[(m_retirementHead + i) & (capacity - 1)];
         }
 
-        SAFE_RELEASE(item.m_pAllocation);
-        m_allocationDeletionQueue.pop();
+        m_retirementRing.swap(ring);
+        m_retirementHead = 0;
+        capacity *= 2;
     }
 
-    while (!m_rtvDeletionQueue.empty())
-    {
-        auto item = m_rtvDeletionQueue.front();
-        if(!forceDelete && item.m_frame + m_desc.m_maxFrameDelay > m_frameID)
-        {
-            break;
-        }
+    uint32_t tail = (m_retirementHead + m_retirementCount) & (capacity - 1);
+    m_retirementRing[tail] = { pObject, pAllocation, size, m_frameID };
+    ++m_retirementCount;
+}
 
-        m_pRTVAllocator->Free(item.m_descriptor);
-        m_rtvDeletionQueue.pop();
-    }
+void D3D12Device::DoDeferredDeletion(bool forceDelete)
+{
+    CPU_EVENT("Render", "D3D12Device::DoDeferredDeletion");
+
+    uint64_t startTime = stm_now();
+    uint32_t releasedCount = 0;
+    uint32_t pendingCount = 0;
+    Retirement batch[DEFERRED_DELETION_BATCH_SIZE];
 
-    while (!m_dsvDeletionQueue.empty())
+    while (true)
     {
-        auto item = m_dsvDeletionQueue.front();
-        if (!forceDelete && item.m_frame + m_desc.m_maxFrameDelay > m_frameID)
+        uint32_t batchCount = 0;
         {
-            break;
+            std::lock_guard<std::mutex> lock(m_retirementMutex);
+
+            uint32_t mask = (uint32_t) m_retirementRing.size() - 1;
+            while (batchCount < DEFERRED_DELETION_BATCH_SIZE && m_retirementCount > 0)
+            {
+                const Retirement& item = m_retirementRing[m_retirementHead];
+                if (!forceDelete && item.m_frame + m_desc.m_maxFrameDelay > m_frameID)
+                {
+                    break;
+                }
+
+                batch[batchCount++] = item;
+                m_retirementHead = (m_retirementHead + 1) & mask;
+                --m_retirementCount;
+            }
+
+            pendingCount = m_retirementCount;
         }
 
-        m_pDSVAllocator->Free(item.m_descriptor);
-        m_dsvDeletionQueue.pop();
-    }
-    
-    while (!m_resourceDeletionQueue.empty())
-    {
-        auto item = m_resourceDeletionQueue.front();
-        if (!forceDelete && item.m_frame + m_desc.m_maxFrameDelay > m_frameID)
+        if (batchCount == 0)
         {
             break;
         }
 
-        m_pResourceDescriptorAllocator->Free(item.m_descriptor);
-        m_resourceDeletionQueue.pop();
-    }
-
-    while (!m_samplerDeletionQueue.empty())
-    {
-        auto item = m_samplerDeletionQueue.front();
-        if (!forceDelete && item.m_frame + m_desc.m_maxFrameDelay > m_frameID)
+        for (uint32_t i = 0; i < batchCount; ++i)
         {
-            break;
+            SAFE_RELEASE(batch[i].m_pObject);
+            SAFE_RELEASE(batch[i].m_pAllocation);
+            m_pendingReleaseBytes -= batch[i].m_size;
         }
+        releasedCount += batchCount;
 
-        m_pSamplerAllocator->Free(item.m_descriptor);
-        m_samplerDeletionQueue.pop();
-    }
-
-    while (!m_nonShaderVisibleUAVDeletionQueue.empty())
-    {
-        auto item = m_nonShaderVisibleUAVDeletionQueue.front();
-        if (!forceDelete && item.m_frame + m_desc.m_maxFrameDelay > m_frameID)
+        if (!forceDelete && releasedCount >= DEFERRED_DELETION_MIN_COUNT && stm_us(stm_since(startTime)) > DEFERRED_DELETION_TIME_BUDGET)
         {
             break;
         }
+    }
+
+    MICROPROFILE_COUNTER_SET("RHI/DeferredDeletion/PendingObjects", pendingCount);
+    MICROPROFILE_COUNTER_SET("RHI/DeferredDeletion/PendingBytes", m_pendingReleaseBytes.load());
+    MICROPROFILE_COUNTER_SET("RHI/DeferredDeletion/ReleasedObjects", releasedCount);
+    MICROPROFILE_COUNTER_SET("RHI/DeferredDeletion/TimeUs", (int64_t) stm_us(stm_since(startTime)));
 
-        m_pNonShaderVisibleUAVAllocator->Free(item.m_descriptor);
-        m_nonShaderVisibleUAVDeletionQueue.pop();
+    // Descriptors freed in frame N are recycled when frame N + maxFrameDelay begins, as the other deletions
+    if (forceDelete || m_frameID >= m_desc.m_maxFrameDelay)
+    {
+        uint64_t completedFrameID = forceDelete ? UINT64_MAX : m_frameID - m_desc.m_maxFrameDelay;
+        m_pRTVAllocator->ProcessDeferredFrees(completedFrameID);
+        m_pDSVAllocator->ProcessDeferredFrees(completedFrameID);
+        m_pResourceDescriptorAllocator->ProcessDeferredFrees(completedFrameID);
+        m_pSamplerAllocator->ProcessDeferredFrees(completedFrameID);
+        m_pNonShaderVisibleUAVAllocator->ProcessDeferredFrees(completedFrameID);
     }
 }
 
@@ -842,9 +1058,9 @@ D3D12Descriptor D3D12Device::AllocateDSV()
     return m_pDSVAllocator->Allocate();
 }
 
-D3D12Descriptor D3D12Device::AllocateResourceDescriptor()
+D3D12Descriptor D3D12Device::AllocateResourceDescriptor(uint32_t count)
 {
-    return m_pResourceDescriptorAllocator->Allocate();
+    return m_pResourceDescriptorAllocator->Allocate(count);
 }
 
 D3D12Descriptor D3D12Device::AllocateSampler()
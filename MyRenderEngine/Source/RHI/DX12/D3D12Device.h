@@ -1,8 +1,10 @@
 #pragma once
 #include "D3D12Headers.h"
 #include "../RHIDevice.h"
+#include "../RHIDescriptorAllocator.h"
 #include "EASTL/unique_ptr.h"
-#include "EASTL/queue.h"
+#include "EASTL/atomic.h"
+#include <mutex>
 
 // {D414FCFE-F480-497E-8BC8-86C209F9194E}
 static GUID ComponentID =
@@ -20,35 +22,98 @@ public:
     D3D12DescriptorAllocator(ID3D12Device* pDevice, D3D12_DESCRIPTOR_HEAP_TYPE heapType, bool shaderVisible, uint32_t descriptorCount, const eastl::string& name);
     ~D3D12DescriptorAllocator();
 
-    D3D12Descriptor Allocate();
-    void Free(const D3D12Descriptor& descriptor);
+    // Thread safe, returns the first descriptor of a contiguous range
+    D3D12Descriptor Allocate(uint32_t count = 1);
+
+    // Thread safe, the range is recycled after the GPU finishes the frame frameID
+    void Free(const D3D12Descriptor& descriptor, uint64_t frameID, uint32_t count = 1);
+    void ProcessDeferredFrees(uint64_t completedFrameID) { m_allocator.ProcessDeferredFrees(completedFrameID); }
 
     ID3D12DescriptorHeap* GetHeap() const { return m_pHeap; }
     D3D12Descriptor GetDescriptor(uint32_t index) const;
+    RHIDescriptorAllocatorStats GetStats() { return m_allocator.GetStats(); }
 
 private:
     ID3D12DescriptorHeap* m_pHeap = nullptr;
     uint32_t m_descriptorSize = 0;
-    uint32_t m_descriptorCount = 0;
-    uint32_t m_allocatedCount = 0;
     bool m_shaderVisible = false;
-    eastl::vector<D3D12Descriptor> m_freeDescriptors;
-
+    RHIDescriptorAllocator m_allocator;
 };
 
 class D3D12Device;
 
+#define D3D12_CB_BLOCK_SIZE (8 * 1024 * 1024)    //< Pool buffers of one frame, a new one is added when a frame overflows
+#define D3D12_CB_MAX_BLOCKS 32
+#define D3D12_CB_PAGE_SIZE (64 * 1024)          //< Carved from the pool by each thread, larger payloads get their own range
+#define D3D12_CB_THREAD_PAGE_COUNT 16           //< Threads are hashed to the pages, a collision only shares a page
+#define D3D12_CB_SMALL_SIZE 256                 //< Payloads up to this size take the tight packing path
+
+struct D3D12ConstantBufferStats
+{
+    uint64_t m_requestedBytes = 0;      //< Sum of the payload sizes
+    uint64_t m_usedBytes = 0;           //< Pool memory the payloads occupy, with the 256 bytes alignment
+    uint64_t m_wastedBytes = 0;         //< Alignment padding and unused page tails
+    uint64_t m_sharedBytes = 0;         //< Small payloads which reused an identical earlier one
+    uint64_t m_reservedBytes = 0;       //< Size of all pool buffers
+    uint32_t m_pageCount = 0;
+    uint32_t m_blockCount = 0;
+};
+
+// Constant memory of one in-flight frame. Each thread fills its own page, pages are carved from the pool buffers
+// with one atomic add, and the pool grows by a buffer instead of failing when a frame needs more
 class D3D12ConstantBufferAllocator
 {
 public:
-    D3D12ConstantBufferAllocator(D3D12Device* pDevice, uint32_t size, const eastl::string& name);
-    
-    void Allocate(uint32_t size, void** ppCPUAddress, uint64_t* pGPUAddress);
+    D3D12ConstantBufferAllocator(D3D12Device* pDevice, const eastl::string& name);
+
+    // Thread safe, copies the data and returns its GPU address
+    uint64_t Allocate(const void* data, uint32_t size);
+
+    // Not thread safe, the GPU must be done with the frame
     void Reset();
 
+    // Call at the end of frame, after the last Allocate
+    D3D12ConstantBufferStats GetStats();
+
 private:
-    eastl::unique_ptr<IRHIBuffer> m_pBuffer = nullptr;
-    uint32_t m_allocatedSize = 0;
+    struct alignas(64) ThreadPage
+    {
+        std::mutex m_mutex;
+        char* m_pCPUAddress = nullptr;
+        uint64_t m_gpuAddress = 0;
+        uint32_t m_offset = 0;
+        uint32_t m_size = 0;
+
+        // Last small payload, a repeated one is bound again rather than copied to a new 256 bytes slot.
+        // Compared against a CPU copy, the upload heap is write combined and slow to read
+        uint32_t m_lastSmallOffset = 0;
+        uint32_t m_lastSmallSize = 0;       //< 0 when the page has no small payload
+        char m_lastSmallData[D3D12_CB_SMALL_SIZE];
+
+        uint64_t m_requestedBytes = 0;
+        uint64_t m_usedBytes = 0;
+        uint64_t m_wastedBytes = 0;
+        uint64_t m_sharedBytes = 0;
+        uint32_t m_pageCount = 0;
+    };
+
+    ThreadPage& GetThreadPage();
+
+    // Switches to the next block, or grows the pool, when the current block is full
+    void CarveRange(uint32_t size, char** ppCPUAddress, uint64_t* pGPUAddress);
+
+private:
+    D3D12Device* m_pDevice = nullptr;
+    eastl::string m_name;
+
+    eastl::unique_ptr<IRHIBuffer> m_pBlocks[D3D12_CB_MAX_BLOCKS];
+    eastl::atomic<uint32_t> m_blockCount{ 0 };
+    eastl::atomic<uint64_t> m_blockCursor{ 0 };    //< Current block index in the high 32 bits, offset in the low 32 bits
+    std::mutex m_growMutex;
+
+    ThreadPage m_pages[D3D12_CB_THREAD_PAGE_COUNT];
+    eastl::atomic<uint64_t> m_largeRequestedBytes{ 0 };  //< Payloads larger than a page, which bypass the thread pages
+    eastl::atomic<uint64_t> m_largeUsedBytes{ 0 };
 };
 
 class D3D12Device : public IRHIDevice
@@ -82,12 +147,18 @@ public:
     virtual IRHIRayTracingTLAS* CreateRayTracongTLAS(const RHIRayTracingTLASDesc& desc, const eastl::string& name) override;
 
     virtual uint32_t GetAllocationSize(const RHITextureDesc& desc) override;
+    virtual uint32_t GetSmallAllocationSize(const RHITextureDesc& desc) override;
+    virtual void GetDescriptorAllocatorStats(eastl::vector<RHIDescriptorAllocatorStats>& stats) override;
+    virtual uint64_t GetTimestampFrequency(RHICommandQueue queue) override;
+    virtual bool GetTimestampCalibration(RHICommandQueue queue, uint64_t& gpuTimestamp, double& cpuTimeUs) override;
 
     bool Init();
     IDXGIFactory5* GetDXGIFactory() const { return m_pDXGIFactory; }
     ID3D12CommandQueue* GetGraphicsQueue() const { return m_pGraphicsQueue; }
     ID3D12CommandQueue* GetComputeQueue() const { return m_pComputeQueue; }
     ID3D12CommandQueue* GetCopyQueue() const { return m_pCopyQueue; }
+    ID3D12CommandQueue* GetQueue(RHICommandQueue queue) const;
+    bool IsCopyQueueTimestampSupported() const { return m_featureSupport.CopyQueueTimestampQueriesSupported(); }
     ID3D12RootSignature* GetRootSignature() const { return m_pRootSignature; }
     ID3D12CommandSignature* GetDrawSignature() const { return m_pDrawSignature; }
     ID3D12CommandSignature* GetDrawIndexedSignature() const { return m_pDrawIndexedSignature; }
@@ -109,13 +180,13 @@ public:
     void Delete(D3D12MA::Allocation* pAllocation);
     void DeleteRTV(const D3D12Descriptor& descriptor);
     void DeleteDSV(const D3D12Descriptor& descriptor);
-    void DeleteResoruce(const D3D12Descriptor& descriptor);
+    void DeleteResoruce(const D3D12Descriptor& descriptor, uint32_t count = 1);
     void DeleteSampler(const D3D12Descriptor& descriptor);
     void DeleteNonShaderVisiableUAV(const D3D12Descriptor& descriptor);
 
     D3D12Descriptor AllocateRTV();
     D3D12Descriptor AllocateDSV();
-    D3D12Descriptor AllocateResourceDescriptor();
+    D3D12Descriptor AllocateResourceDescriptor(uint32_t count = 1);
     D3D12Descriptor AllocateSampler();
     D3D12Descriptor AllocateNonShaderVisibleUAV();
 
@@ -126,6 +197,7 @@ public:
 #endif
 
 private:
+    void Retire(IUnknown* pObject, D3D12MA::Allocation* pAllocation);
     void DoDeferredDeletion(bool forceDelete = false);
     void CreateRootSignature();
     void CreateIndirectCommandSignatures();
@@ -164,30 +236,20 @@ protected:
     eastl::unique_ptr<D3D12DescriptorAllocator> m_pSamplerAllocator;
     eastl::unique_ptr<D3D12DescriptorAllocator> m_pNonShaderVisibleUAVAllocator;
   
-    struct ObjectDeletion
-    {
-        IUnknown* m_pObject;
-        uint64_t m_frame;
-    };
-    eastl::queue<ObjectDeletion> m_objectDeletionQueue;
-
-    struct AllocationDeletion
+    // Objects and allocations are released in the order of Delete calls, once their frame has retired
+    struct Retirement
     {
+        IUnknown* m_pObject;                //< Only one of m_pObject and m_pAllocation is set
         D3D12MA::Allocation* m_pAllocation;
+        uint64_t m_size;                    //< Allocation size in bytes
         uint64_t m_frame;
     };
-    eastl::queue<AllocationDeletion> m_allocationDeletionQueue;
+    std::mutex m_retirementMutex;
+    eastl::vector<Retirement> m_retirementRing; //< Size is a power of 2, doubled when full
+    uint32_t m_retirementHead = 0;              //< Oldest item
+    uint32_t m_retirementCount = 0;
+    eastl::atomic<uint64_t> m_pendingReleaseBytes{ 0 };
 
-    struct DescriptorDeletion
-    {
-        D3D12Descriptor m_descriptor;
-        uint64_t m_frame;
-    };
-    eastl::queue<DescriptorDeletion> m_rtvDeletionQueue;
-    eastl::queue<DescriptorDeletion> m_dsvDeletionQueue;
-    eastl::queue<DescriptorDeletion> m_resourceDeletionQueue;
-    eastl::queue<DescriptorDeletion> m_samplerDeletionQueue;
-    eastl::queue<DescriptorDeletion> m_nonShaderVisibleUAVDeletionQueue;
     
 #if MICROPROFILE_GPU_TIMERS_D3D12
     int m_profileGraphicsQueue = -1;
@@ -13,6 +13,7 @@ public:
     virtual void* GetHandle() const override { return m_pFence; }
     virtual void Wait(uint64_t value) override;
     virtual void Signal(uint64_t value) override; 
+    virtual uint64_t GetCompletedValue() const override { return m_pFence->GetCompletedValue(); }
 
     bool Create();
 
@@ -72,6 +72,19 @@ inline D3D12_BARRIER_SYNC RHIToD3D12BarrierSync(RHIAccessFlags flags)
     return sync;
 }
 
+// The begin half only waits for the accesses before, the end half only blocks the accesses after
+inline void ApplyBarrierSplit(RHIBarrierSplit split, D3D12_BARRIER_SYNC& syncBefore, D3D12_BARRIER_SYNC& syncAfter)
+{
+    if (split == RHIBarrierSplit::Begin)
+    {
+        syncAfter = D3D12_BARRIER_SYNC_SPLIT;
+    }
+    else if (split == RHIBarrierSplit::End)
+    {
+        syncBefore = D3D12_BARRIER_SYNC_SPLIT;
+    }
+}
+
 inline D3D12_BARRIER_ACCESS RHIToD3D12BarrierAccess(RHIAccessFlags flags)
 {
     if (flags & RHIAccessDiscard)
@@ -599,6 +612,16 @@ inline D3D12_RESOURCE_DESC RHIToD3D12ResourceDesc(const RHITextureDesc& desc)
     if (desc.m_usage & RHITextureUsageUnorderedAccess)
     {
         resourceDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+
+        // SRGB formats can't be UAV, the views of the typeless resource pick the SRGB or the UNORM format
+        if (desc.m_format == RHIFormat::RGBA8SRGB)
+        {
+            resourceDesc.Format = DXGI_FORMAT_R8G8B8A8_TYPELESS;
+        }
+        else if (desc.m_format == RHIFormat::BGRA8SRGB)
+        {
+            resourceDesc.Format = DXGI_FORMAT_B8G8R8A8_TYPELESS;
+        }
     }
 
     switch (desc.m_type)
@@ -645,6 +668,25 @@ inline D3D12_RESOURCE_DESC RHIToD3D12ResourceDesc(const RHITextureDesc& desc)
     return resourceDesc;
 }
 
+// Small textures which are not render targets or depth stencils can be placed with 4KB alignment instead of 64KB,
+// the alignment is kept in the desc when the device accepts it
+inline D3D12_RESOURCE_ALLOCATION_INFO GetSmallResourceAllocationInfo(ID3D12Device* pDevice, D3D12_RESOURCE_DESC& desc)
+{
+    if (!(desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) &&
+        desc.Layout == D3D12_TEXTURE_LAYOUT_UNKNOWN && desc.SampleDesc.Count == 1)
+    {
+        desc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+        D3D12_RESOURCE_ALLOCATION_INFO info = pDevice->GetResourceAllocationInfo(0, 1, &desc);
+        if (info.Alignment == D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT)
+        {
+            return info;
+        }
+    }
+
+    desc.Alignment = 0;
+    return pDevice->GetResourceAllocationInfo(0, 1, &desc);
+}
+
 inline D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS RHIToD3D12RTASBuildFlags(RHIRayTracingASFlags flags)
 {
     D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS d3d12Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_NONE;
@@ -125,9 +125,13 @@ bool D3D12Texture::Create()
     {
         MY_ASSERT(m_desc.m_allocationType == RHIAllocationType::Placed);
         MY_ASSERT(m_desc.m_memoryType == m_desc.m_heap->GetDesc().m_memoryType);
+
+        // Heap offsets come from GetSmallAllocationSize, so the placed texture takes the small alignment when it can
+        GetSmallResourceAllocationInfo(device, resourceDesc);
+        D3D12_RESOURCE_DESC1 placedDesc1 = CD3DX12_RESOURCE_DESC1(resourceDesc);
         
         hResult = pAllocator->CreateAliasingResource2((D3D12MA::Allocation*) m_desc.m_heap->GetHandle(),
-             m_desc.m_heapOffset, &resourceDesc1, initialLayout, nullptr, 0, nullptr, IID_PPV_ARGS(&m_pTexture));
+             m_desc.m_heapOffset, &placedDesc1, initialLayout, nullptr, 0, nullptr, IID_PPV_ARGS(&m_pTexture));
     }
     else if (m_desc.m_allocationType == RHIAllocationType::Sparse)
     {
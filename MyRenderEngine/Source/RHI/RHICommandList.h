@@ -32,6 +32,12 @@ public:
     virtual void EndProfiling() = 0;
     virtual void BeginEvent(const eastl::string& eventName) = 0;
     virtual void EndEvent() = 0;
+
+    // Returns the query index, RHI_INVALID_RESOURCE when the query heap is full or the queue has no timestamp support.
+    // Queries are resolved at End, and are valid until the next ResetAllocator
+    virtual uint32_t WriteTimestamp() = 0;
+    // Only valid after the GPU has finished the command list, returns nullptr when nothing was written
+    virtual const uint64_t* ReadTimestamps(uint32_t& count) const = 0;
     
     virtual void CopyBufferToTexture(IRHITexture* pDstTexture, uint32_t mipLevel, uint32_t arraySize, IRHIBuffer* pSrcBuffer, uint32_t offset) = 0;
     virtual void CopyTextureToBuffer(IRHIBuffer* pDstBuffer, IRHITexture* pSrcTexture, uint32_t mipLevel, uint32_t arraySize) = 0;
@@ -42,8 +48,8 @@ public:
     virtual void WriteBuffer(IRHIBuffer* pBuffer, uint32_t offset, uint32_t data) = 0;
     virtual void UpdateTileMappings(IRHITexture* pTexture, IRHIHeap* pHeap, uint32_t mappingCount, const RHITileMapping* pMappings) = 0;
 
-    virtual void TextureBarrier(IRHITexture* pTexture, uint32_t subResource, RHIAccessFlags accessBefore, RHIAccessFlags accessAfter) = 0;
-    virtual void BufferBarrier(IRHIBuffer* pBuffer, RHIAccessFlags accessBefore, RHIAccessFlags accessAfter) = 0;
+    virtual void TextureBarrier(IRHITexture* pTexture, uint32_t subResource, RHIAccessFlags accessBefore, RHIAccessFlags accessAfter, RHIBarrierSplit split = RHIBarrierSplit::None) = 0;
+    virtual void BufferBarrier(IRHIBuffer* pBuffer, RHIAccessFlags accessBefore, RHIAccessFlags accessAfter, RHIBarrierSplit split = RHIBarrierSplit::None) = 0;
     virtual void GlobalBarrier(RHIAccessFlags accessBefore, RHIAccessFlags accessAfter) = 0;
     virtual void FlushBarriers() = 0;
 
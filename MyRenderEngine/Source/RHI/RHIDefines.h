@@ -16,6 +16,7 @@ static const uint32_t RHI_MAX_INFLIGHT_FRAMES = 3;
 static const uint32_t RHI_MAX_ROOT_CONSTATNS = 8;
 static const uint32_t RHI_MAX_CBV_BINDINGS = 3;
 static const uint32_t RHI_MAX_RENDER_TARGET_ACCOUNT = 8;
+static const uint32_t RHI_MAX_TIMESTAMP_QUERIES = 1024;    //< Per command list, between two ResetAllocator calls
 
 enum class RHIRenderBackEnd
 {
@@ -245,6 +246,13 @@ enum RHIAccessBit
 };
 using RHIAccessFlags = uint32_t;
 
+enum class RHIBarrierSplit
+{
+    None,
+    Begin,      //< Waits for the accesses before, the resource can't be used until the end barrier
+    End,        //< Must be recorded in the same command list as the begin barrier
+};
+
 enum class RHIShaderResourceViewType
 {
     Texture2D,
@@ -377,6 +385,7 @@ struct RHIShaderResourceViewDesc
         {
             uint32_t m_size = 0;
             uint32_t m_offset = 0;
+            uint32_t m_stride = 0;      //< 0 takes the stride of the buffer, set for a view into a shared buffer
         } m_buffer;
     };
     
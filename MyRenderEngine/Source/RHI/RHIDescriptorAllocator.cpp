@@ -0,0 +1,233 @@
+#include "RHIDescriptorAllocator.h"
+#include "Utils/math.h"
+#include "EASTL/algorithm.h"
+#include <thread>
+
+class SpinLockGuard
+{
+public:
+    SpinLockGuard(eastl::atomic<bool>& lock) : m_lock(lock)
+    {
+        while (m_lock.exchange(true))
+        {
+            while (m_lock.load())
+            {
+            }
+        }
+    }
+
+    ~SpinLockGuard()
+    {
+        m_lock.store(false);
+    }
+
+private:
+    eastl::atomic<bool>& m_lock;
+};
+
+RHIDescriptorAllocator::RHIDescriptorAllocator(uint32_t capacity, const eastl::string& name) :
+    m_allocator(capacity, capacity + 2)   //< Enough nodes even when every index is allocated alone
+{
+    m_capacity = capacity;
+    m_name = name;
+
+    // Small heaps (RTV, DSV, sampler) must not be drained by the caches of a few threads
+    m_cacheRefillSize = min((uint32_t) RHI_DESCRIPTOR_CACHE_SIZE / 2, capacity / (RHI_DESCRIPTOR_CACHE_COUNT * 4));
+
+    m_metadata.resize(capacity, OffsetAllocator::Allocation::NO_SPACE);
+}
+
+uint32_t RHIDescriptorAllocator::Allocate(uint32_t count)
+{
+    MY_ASSERT(count > 0);
+
+    uint32_t index = RHI_INVALID_RESOURCE;
+
+    if (count == 1 && m_cacheRefillSize > 0)
+    {
+        ThreadCache& cache = GetThreadCache();
+        SpinLockGuard lock(cache.m_lock);
+
+        if (cache.m_count == 0)
+        {
+            RefillCache(cache);
+        }
+
+        if (cache.m_count > 0)
+        {
+            index = cache.m_indices[--cache.m_count];
+        }
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        index = AllocateRange(count);
+    }
+
+    MY_ASSERT(index != RHI_INVALID_RESOURCE);
+    return index;
+}
+
+void RHIDescriptorAllocator::Free(uint32_t index, uint32_t count)
+{
+    MY_ASSERT(index + count <= m_capacity);
+
+    if (count == 1 && m_cacheRefillSize > 0)
+    {
+        ThreadCache& cache = GetThreadCache();
+        SpinLockGuard lock(cache.m_lock);
+
+        if (cache.m_count == m_cacheRefillSize * 2)
+        {
+            FlushCache(cache, m_cacheRefillSize);
+        }
+
+        cache.m_indices[cache.m_count++] = index;
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        FreeRange(index, count);
+    }
+}
+
+void RHIDescriptorAllocator::DeferredFree(uint32_t index, uint32_t count, uint64_t fenceValue)
+{
+    MY_ASSERT(index + count <= m_capacity);
+
+    ThreadCache& cache = GetThreadCache();
+    SpinLockGuard lock(cache.m_lock);
+    cache.m_deferredFrees.push_back({ index, count, fenceValue });
+}
+
+void RHIDescriptorAllocator::ProcessDeferredFrees(uint64_t completedFenceValue)
+{
+    eastl::vector<DeferredRange> completedFrees;
+
+    for (uint32_t i = 0; i < RHI_DESCRIPTOR_CACHE_COUNT; ++i)
+    {
+        ThreadCache& cache = m_caches[i];
+        SpinLockGuard lock(cache.m_lock);
+
+        size_t pendingCount = 0;
+        for (size_t j = 0; j < cache.m_deferredFrees.size(); ++j)
+        {
+            const DeferredRange& range = cache.m_deferredFrees[j];
+            if (range.m_fenceValue <= completedFenceValue)
+            {
+                completedFrees.push_back(range);
+            }
+            else
+            {
+                cache.m_deferredFrees[pendingCount++] = range;
+            }
+        }
+        cache.m_deferredFrees.resize(pendingCount);
+    }
+
+    if (!completedFrees.empty())
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t i = 0; i < completedFrees.size(); ++i)
+        {
+            FreeRange(completedFrees[i].m_index, completedFrees[i].m_count);
+        }
+    }
+}
+
+RHIDescriptorAllocatorStats RHIDescriptorAllocator::GetStats()
+{
+    RHIDescriptorAllocatorStats stats;
+    stats.m_name = m_name;
+    stats.m_capacity = m_capacity;
+
+    for (uint32_t i = 0; i < RHI_DESCRIPTOR_CACHE_COUNT; ++i)
+    {
+        ThreadCache& cache = m_caches[i];
+        SpinLockGuard lock(cache.m_lock);
+
+        stats.m_cachedCount += cache.m_count;
+        for (size_t j = 0; j < cache.m_deferredFrees.size(); ++j)
+        {
+            stats.m_pendingFreeCount += cache.m_deferredFrees[j].m_count;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    OffsetAllocator::StorageReport report = m_allocator.storageReport();
+    OffsetAllocator::StorageReportFull fullReport = m_allocator.storageReportFull();
+
+    stats.m_allocatedCount = m_capacity - report.totalFreeSpace;
+    stats.m_largestFreeRegion = report.largestFreeRegion;
+    for (uint32_t i = 0; i < OffsetAllocator::NUM_LEAF_BINS; ++i)
+    {
+        stats.m_freeRegionCount += fullReport.freeRegions[i].count;
+    }
+
+    if (report.totalFreeSpace > 0)
+    {
+        stats.m_fragmentation = 1.0f - (float) report.largestFreeRegion / report.totalFreeSpace;
+    }
+
+    return stats;
+}
+
+RHIDescriptorAllocator::ThreadCache& RHIDescriptorAllocator::GetThreadCache()
+{
+    static thread_local uint32_t cacheIndex = (uint32_t) (std::hash<std::thread::id>()(std::this_thread::get_id()) % RHI_DESCRIPTOR_CACHE_COUNT);
+    return m_caches[cacheIndex];
+}
+
+void RHIDescriptorAllocator::RefillCache(ThreadCache& cache)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (uint32_t i = 0; i < m_cacheRefillSize; ++i)
+    {
+        uint32_t index = AllocateRange(1);
+        if (index == RHI_INVALID_RESOURCE)
+        {
+            break;
+        }
+
+        cache.m_indices[cache.m_count++] = index;
+    }
+
+    // Reversed, so a thread pops its indices in ascending order
+    eastl::reverse(cache.m_indices, cache.m_indices + cache.m_count);
+}
+
+void RHIDescriptorAllocator::FlushCache(ThreadCache& cache, uint32_t count)
+{
+    MY_ASSERT(count <= cache.m_count);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        FreeRange(cache.m_indices[--cache.m_count], 1);
+    }
+}
+
+uint32_t RHIDescriptorAllocator::AllocateRange(uint32_t count)
+{
+    OffsetAllocator::Allocation allocation = m_allocator.allocate(count);
+    if (allocation.offset == OffsetAllocator::Allocation::NO_SPACE)
+    {
+        return RHI_INVALID_RESOURCE;
+    }
+
+    m_metadata[allocation.offset] = allocation.metadata;
+    return allocation.offset;
+}
+
+void RHIDescriptorAllocator::FreeRange(uint32_t index, uint32_t count)
+{
+    OffsetAllocator::Allocation allocation;
+    allocation.offset = index;
+    allocation.metadata = m_metadata[index];
+    MY_ASSERT(allocation.metadata != OffsetAllocator::Allocation::NO_SPACE); //< Double free
+    MY_ASSERT(m_allocator.allocationSize(allocation) == count);
+
+    m_allocator.free(allocation);
+    m_metadata[index] = OffsetAllocator::Allocation::NO_SPACE;
+}
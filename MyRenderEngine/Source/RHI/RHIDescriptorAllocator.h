@@ -0,0 +1,80 @@
+#pragma once
+#include "RHIDefines.h"
+#include "OffsetAllocator/offsetAllocator.hpp"
+#include "EASTL/atomic.h"
+#include <mutex>
+
+#define RHI_DESCRIPTOR_CACHE_COUNT 16       //< Threads are hashed to the caches, a collision only costs a short spin
+#define RHI_DESCRIPTOR_CACHE_SIZE 64
+
+struct RHIDescriptorAllocatorStats
+{
+    eastl::string m_name;
+    uint32_t m_capacity = 0;
+    uint32_t m_allocatedCount = 0;      //< Indices taken from the heap, including the cached and the pending ones
+    uint32_t m_cachedCount = 0;         //< Free indices held by the thread caches
+    uint32_t m_pendingFreeCount = 0;    //< Freed indices waiting for their fence
+    uint32_t m_freeRegionCount = 0;
+    uint32_t m_largestFreeRegion = 0;
+    float m_fragmentation = 0.0f;       //< 1 - largest free region / free count
+};
+
+// Allocates descriptor heap indices, single ones or contiguous ranges, from any thread.
+// Ranges come from an OffsetAllocator (TLSF) over the index space, single indices are served by per-thread caches
+// which are refilled and flushed in batches. Deferred frees are tagged with a fence value (frame ID)
+// and recycled in ProcessDeferredFrees once that fence value is completed
+class RHIDescriptorAllocator
+{
+public:
+    RHIDescriptorAllocator(uint32_t capacity, const eastl::string& name);
+
+    // Returns the first index of the range, RHI_INVALID_RESOURCE when the heap is full
+    uint32_t Allocate(uint32_t count = 1);
+
+    // The range must be exactly the allocated one, and not be used by GPU anymore
+    void Free(uint32_t index, uint32_t count = 1);
+
+    // The range is recycled when ProcessDeferredFrees is called with a completed fence value >= fenceValue
+    void DeferredFree(uint32_t index, uint32_t count, uint64_t fenceValue);
+
+    // Thread safe, usually called once at the beginning of frame
+    void ProcessDeferredFrees(uint64_t completedFenceValue);
+
+    RHIDescriptorAllocatorStats GetStats();
+    uint32_t GetCapacity() const { return m_capacity; }
+
+private:
+    struct DeferredRange
+    {
+        uint32_t m_index;
+        uint32_t m_count;
+        uint64_t m_fenceValue;
+    };
+
+    struct alignas(64) ThreadCache
+    {
+        eastl::atomic<bool> m_lock{ false };
+        uint32_t m_count = 0;
+        uint32_t m_indices[RHI_DESCRIPTOR_CACHE_SIZE];
+        eastl::vector<DeferredRange> m_deferredFrees;
+    };
+
+    ThreadCache& GetThreadCache();
+    void RefillCache(ThreadCache& cache);
+    void FlushCache(ThreadCache& cache, uint32_t count);
+
+    // m_mutex must be held
+    uint32_t AllocateRange(uint32_t count);
+    void FreeRange(uint32_t index, uint32_t count);
+
+private:
+    uint32_t m_capacity = 0;
+    uint32_t m_cacheRefillSize = 0;     //< 0 when the heap is too small to be cached
+    eastl::string m_name;
+
+    ThreadCache m_caches[RHI_DESCRIPTOR_CACHE_COUNT];
+
+    std::mutex m_mutex;
+    OffsetAllocator::Allocator m_allocator;
+    eastl::vector<OffsetAllocator::NodeIndex> m_metadata;   //< Allocation node of every allocated first index
+};
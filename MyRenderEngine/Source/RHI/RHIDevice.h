@@ -13,6 +13,7 @@ class IRHIPipelineState;
 class IRHIDescriptor;
 class IRHIRayTracingBLAS;
 class IRHIRayTracingTLAS;
+struct RHIDescriptorAllocatorStats;
 
 class IRHIDevice
 {
@@ -43,4 +44,11 @@ public:
     virtual IRHIRayTracingTLAS* CreateRayTracongTLAS(const RHIRayTracingTLASDesc& desc, const eastl::string& name) = 0;
 
     virtual uint32_t GetAllocationSize(const RHITextureDesc& desc) = 0;
+    virtual uint32_t GetSmallAllocationSize(const RHITextureDesc& desc) = 0;    //< With the 4KB placement alignment when the texture allows it, for placing in a heap
+    virtual void GetDescriptorAllocatorStats(eastl::vector<RHIDescriptorAllocatorStats>& stats) = 0;
+
+    // Ticks per second of the timestamps written on the queue
+    virtual uint64_t GetTimestampFrequency(RHICommandQueue queue) = 0;
+    // A GPU timestamp of the queue and the CPU time sampled at the same moment, in microseconds of sokol_time (stm_now)
+    virtual bool GetTimestampCalibration(RHICommandQueue queue, uint64_t& gpuTimestamp, double& cpuTimeUs) = 0;
 };
\ No newline at end of file
@@ -8,4 +8,5 @@ public:
     
     virtual void Wait(uint64_t) = 0;
     virtual void Signal(uint64_t) = 0;
+    virtual uint64_t GetCompletedValue() const = 0;
 };
\ No newline at end of file
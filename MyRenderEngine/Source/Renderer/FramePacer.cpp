@@ -0,0 +1,201 @@
+#include "FramePacer.h"
+#include "Utils/math.h"
+
+double FramePacer::GetDelay(double nowUs) const
+{
+    if (!m_bEnabled || m_averageGPUUs == 0.0f)
+    {
+        return 0.0;
+    }
+
+    // Begin late enough to sample the newest input, early enough that the GPU never waits for the submit
+    double beginUs = m_predictedGPUFreeUs - m_marginUs - m_averageCPUUs;
+    return max(beginUs - nowUs, 0.0);
+}
+
+void FramePacer::BeginFrame(uint64_t frameID, double beginUs, double delayUs, double fenceWaitUs)
+{
+    FrameRecord& frame = m_frames[frameID % FRAME_PACER_HISTORY];
+    frame = FrameRecord();
+    frame.m_frameID = frameID;
+    frame.m_beginUs = beginUs;
+    frame.m_delayUs = (float) delayUs;
+    frame.m_fenceWaitUs = (float) fenceWaitUs;
+}
+
+void FramePacer::SubmitFrame(uint64_t frameID, double submitUs)
+{
+    FrameRecord* pFrame = FindFrame(frameID);
+    if (pFrame == nullptr)
+    {
+        return;
+    }
+
+    pFrame->m_submitUs = submitUs;
+    pFrame->m_bSubmitted = true;
+
+    float cpuUs = (float) (submitUs - pFrame->m_beginUs);
+    m_averageCPUUs = m_averageCPUUs == 0.0f ? cpuUs : m_averageCPUUs + (cpuUs - m_averageCPUUs) * FRAME_PACER_AVERAGE_WEIGHT;
+
+    m_lastSubmittedFrame = frameID;
+    PredictGPUFree();
+}
+
+bool FramePacer::ResolveFrame(uint64_t frameID, double gpuBeginUs, double gpuEndUs, FrameLatency& latency)
+{
+    FrameRecord* pFrame = FindFrame(frameID);
+    if (pFrame == nullptr || !pFrame->m_bSubmitted)
+    {
+        return false;
+    }
+
+    pFrame->m_gpuEndUs = gpuEndUs;
+    pFrame->m_bResolved = true;
+
+    latency.m_frameID = frameID;
+    latency.m_delayUs = pFrame->m_delayUs;
+    latency.m_fenceWaitUs = pFrame->m_fenceWaitUs;
+    latency.m_cpuUs = (float) (pFrame->m_submitUs - pFrame->m_beginUs);
+    latency.m_queueUs = (float) max(gpuBeginUs - pFrame->m_submitUs, 0.0);
+    latency.m_gpuUs = (float) (gpuEndUs - gpuBeginUs);
+    latency.m_starvedUs = 0.0f;
+    latency.m_totalUs = (float) (gpuEndUs - pFrame->m_beginUs);
+
+    FrameRecord* pPrevFrame = frameID > 0 ? FindFrame(frameID - 1) : nullptr;
+    if (pPrevFrame != nullptr && pPrevFrame->m_bResolved)
+    {
+        latency.m_starvedUs = (float) max(min(gpuBeginUs, pFrame->m_submitUs) - pPrevFrame->m_gpuEndUs, 0.0);
+    }
+
+    m_averageGPUUs = m_averageGPUUs == 0.0f ? latency.m_gpuUs : m_averageGPUUs + (latency.m_gpuUs - m_averageGPUUs) * FRAME_PACER_AVERAGE_WEIGHT;
+
+    // The GPU waited for a frame the pacer held back, submit earlier from now on, otherwise creep back to the minimum
+    if (latency.m_starvedUs > 0.0f && latency.m_delayUs > 0.0f)
+    {
+        m_marginUs = min(m_marginUs + latency.m_starvedUs, FRAME_PACER_MAX_MARGIN_US);
+    }
+    else
+    {
+        m_marginUs = max(m_marginUs - (m_marginUs - FRAME_PACER_MIN_MARGIN_US) * FRAME_PACER_AVERAGE_WEIGHT, FRAME_PACER_MIN_MARGIN_US);
+    }
+
+    if (m_lastResolvedFrame == UINT64_MAX || frameID > m_lastResolvedFrame)
+    {
+        m_lastResolvedFrame = frameID;
+    }
+    PredictGPUFree();
+
+    return true;
+}
+
+FramePacer::FrameRecord* FramePacer::FindFrame(uint64_t frameID)
+{
+    FrameRecord& frame = m_frames[frameID % FRAME_PACER_HISTORY];
+    return frame.m_frameID == frameID ? &frame : nullptr;
+}
+
+void FramePacer::PredictGPUFree()
+{
+    if (m_lastSubmittedFrame == UINT64_MAX)
+    {
+        return;
+    }
+
+    // Starts from the newest frame with known GPU timings, every frame after it runs the average GPU time once the GPU gets to it
+    uint64_t firstFrame = m_lastSubmittedFrame + 1 >= FRAME_PACER_HISTORY ? m_lastSubmittedFrame + 1 - FRAME_PACER_HISTORY : 0;
+    double gpuFreeUs = 0.0;
+
+    FrameRecord* pResolvedFrame = m_lastResolvedFrame != UINT64_MAX ? FindFrame(m_lastResolvedFrame) : nullptr;
+    if (pResolvedFrame != nullptr && m_lastResolvedFrame >= firstFrame)
+    {
+        gpuFreeUs = pResolvedFrame->m_gpuEndUs;
+        firstFrame = m_lastResolvedFrame + 1;
+    }
+
+    for (uint64_t frameID = firstFrame; frameID <= m_lastSubmittedFrame; ++frameID)
+    {
+        FrameRecord* pFrame = FindFrame(frameID);
+        if (pFrame != nullptr && pFrame->m_bSubmitted)
+        {
+            gpuFreeUs = max(gpuFreeUs, pFrame->m_submitUs) + m_averageGPUUs;
+        }
+    }
+
+    m_predictedGPUFreeUs = gpuFreeUs;
+}
+
+void FramePacer::Simulate(const FramePacerSimulationDesc& desc, FramePacerSimulationResult& result, eastl::vector<FrameLatency>* pLatencies)
+{
+    FramePacer pacer;
+    pacer.SetEnabled(desc.m_bPacing);
+
+    // Fixed seed, runs with and without pacing see the same timings
+    uint32_t seed = 1;
+    auto random = [&seed]()
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return (float) (seed >> 8) / 16777216.0f * 2.0f - 1.0f;
+    };
+
+    eastl::vector<double> gpuBeginUs(desc.m_frameCount);
+    eastl::vector<double> gpuEndUs(desc.m_frameCount);
+    uint32_t warmUpFrames = desc.m_frameCount / 10;
+
+    double nowUs = 0.0;
+    double latencySumUs = 0.0;
+    double busySumUs = 0.0;
+    double starvedSumUs = 0.0;
+    uint32_t firstFrame = UINT32_MAX;
+    uint32_t lastFrame = 0;
+
+    for (uint32_t frameID = 0; frameID < desc.m_frameCount; ++frameID)
+    {
+        double fenceWaitUs = 0.0;
+        if (frameID >= desc.m_framesInFlight)
+        {
+            fenceWaitUs = max(gpuEndUs[frameID - desc.m_framesInFlight] - nowUs, 0.0);
+            nowUs += fenceWaitUs;
+        }
+
+        double delayUs = pacer.GetDelay(nowUs);
+        nowUs += delayUs;
+        pacer.BeginFrame(frameID, nowUs, delayUs, fenceWaitUs);
+
+        if (frameID >= desc.m_resolveDelay)
+        {
+            uint32_t resolvedFrame = frameID - desc.m_resolveDelay;
+
+            FrameLatency latency;
+            if (pacer.ResolveFrame(resolvedFrame, gpuBeginUs[resolvedFrame], gpuEndUs[resolvedFrame], latency) && resolvedFrame >= warmUpFrames)
+            {
+                latencySumUs += latency.m_totalUs;
+                busySumUs += latency.m_gpuUs;
+                starvedSumUs += latency.m_starvedUs;
+                firstFrame = min(firstFrame, resolvedFrame);
+                lastFrame = resolvedFrame;
+
+                if (pLatencies != nullptr)
+                {
+                    pLatencies->push_back(latency);
+                }
+            }
+        }
+
+        nowUs += desc.m_cpuUs * (1.0f + desc.m_jitter * random());
+        pacer.SubmitFrame(frameID, nowUs);
+
+        gpuBeginUs[frameID] = frameID > 0 ? max(nowUs, gpuEndUs[frameID - 1]) : nowUs;
+        gpuEndUs[frameID] = gpuBeginUs[frameID] + desc.m_gpuUs * (1.0f + desc.m_jitter * random());
+    }
+
+    result = FramePacerSimulationResult();
+    if (firstFrame >= lastFrame)
+    {
+        return;
+    }
+
+    uint32_t frameCount = lastFrame - firstFrame + 1;
+    result.m_averageLatencyUs = (float) (latencySumUs / frameCount);
+    result.m_averageFrameUs = (float) ((gpuEndUs[lastFrame] - gpuEndUs[firstFrame]) / (frameCount - 1));
+    result.m_gpuIdleRatio = (float) (starvedSumUs / (busySumUs + starvedSumUs));
+}
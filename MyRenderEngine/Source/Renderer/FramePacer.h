@@ -0,0 +1,93 @@
+#pragma once
+#include "EASTL/vector.h"
+#include <stdint.h>
+
+#define FRAME_PACER_HISTORY 16                  //< Frames tracked from their begin until their GPU timings are resolved
+#define FRAME_PACER_AVERAGE_WEIGHT 0.1f         //< Weight of the newest frame in the average CPU and GPU times
+#define FRAME_PACER_MIN_MARGIN_US 500.0f        //< A frame is submitted at least this long before the GPU is predicted to run out of work
+#define FRAME_PACER_MAX_MARGIN_US 4000.0f
+
+// Where the time from sampling the input of a frame to the GPU finishing it went
+struct FrameLatency
+{
+    uint64_t m_frameID = 0;
+    float m_delayUs = 0.0f;         //< Pacing wait before the frame began
+    float m_fenceWaitUs = 0.0f;     //< Frames in flight wait before the frame began
+    float m_cpuUs = 0.0f;           //< Begin of the frame to its submit
+    float m_queueUs = 0.0f;         //< Submit to the GPU starting the frame
+    float m_gpuUs = 0.0f;
+    float m_starvedUs = 0.0f;       //< GPU idle before the frame was submitted
+    float m_totalUs = 0.0f;         //< Begin of the frame to the GPU finishing it
+};
+
+struct FramePacerSimulationDesc
+{
+    uint32_t m_frameCount = 600;
+    uint32_t m_framesInFlight = 2;
+    uint32_t m_resolveDelay = 3;    //< GPU timings of a frame are known this many frames later, as with FrameTrace
+    bool m_bPacing = true;
+    float m_cpuUs = 4000.0f;
+    float m_gpuUs = 10000.0f;
+    float m_jitter = 0.1f;          //< Random variation of the CPU and GPU times, as a fraction of them
+};
+
+struct FramePacerSimulationResult
+{
+    float m_averageLatencyUs = 0.0f;
+    float m_averageFrameUs = 0.0f;  //< Between the GPU finishing two frames
+    float m_gpuIdleRatio = 0.0f;    //< GPU starved, not counting the warm up frames
+};
+
+// Picks when to begin the next frame. Deeper queues keep the GPU busy but the input of a frame waits for all frames ahead of it,
+// so the frame is delayed until it can just be submitted before the GPU is predicted to finish the queued work.
+// Pure timing logic, the times are passed in, so it runs against simulated timings as well as the renderer
+class FramePacer
+{
+public:
+    void SetEnabled(bool value) { m_bEnabled = value; }
+    bool IsEnabled() const { return m_bEnabled; }
+
+    // How long to wait at nowUs before beginning the next frame, 0 until GPU timings are resolved
+    double GetDelay(double nowUs) const;
+
+    void BeginFrame(uint64_t frameID, double beginUs, double delayUs, double fenceWaitUs);
+    void SubmitFrame(uint64_t frameID, double submitUs);
+
+    // GPU timeline of a finished frame in CPU time. Returns false when the frame is not tracked anymore
+    bool ResolveFrame(uint64_t frameID, double gpuBeginUs, double gpuEndUs, FrameLatency& latency);
+
+    float GetAverageCPUTime() const { return m_averageCPUUs; }
+    float GetAverageGPUTime() const { return m_averageGPUUs; }
+    float GetMargin() const { return m_marginUs; }
+
+    // Runs the controller against a simulated CPU and GPU on a virtual clock, which needs no device
+    static void Simulate(const FramePacerSimulationDesc& desc, FramePacerSimulationResult& result, eastl::vector<FrameLatency>* pLatencies = nullptr);
+
+private:
+    struct FrameRecord
+    {
+        uint64_t m_frameID = UINT64_MAX;
+        double m_beginUs = 0.0;
+        double m_submitUs = 0.0;
+        double m_gpuEndUs = 0.0;
+        float m_delayUs = 0.0f;
+        float m_fenceWaitUs = 0.0f;
+        bool m_bSubmitted = false;
+        bool m_bResolved = false;
+    };
+
+    FrameRecord* FindFrame(uint64_t frameID);
+    void PredictGPUFree();
+
+private:
+    bool m_bEnabled = true;
+
+    FrameRecord m_frames[FRAME_PACER_HISTORY];
+    uint64_t m_lastSubmittedFrame = UINT64_MAX;
+    uint64_t m_lastResolvedFrame = UINT64_MAX;
+
+    float m_averageCPUUs = 0.0f;
+    float m_averageGPUUs = 0.0f;
+    float m_marginUs = FRAME_PACER_MIN_MARGIN_US;
+    double m_predictedGPUFreeUs = 0.0;
+};
@@ -0,0 +1,240 @@
+#include "FrameTrace.h"
+#include "Core/Engine.h"
+#include "Utils/profiler.h"
+#include "Utils/log.h"
+#include "Utils/math.h"
+#include "sokol/sokol_time.h"
+#include <fstream>
+
+enum TraceProcess
+{
+    TraceProcessCPU,
+    TraceProcessGPU,
+};
+
+enum TraceCPUThread
+{
+    TraceThreadMain,
+    TraceThreadFrames,
+};
+
+static const char* s_queueNames[] = { "Graphics Queue", "Compute Queue", "Copy Queue" };
+
+static eastl::string EscapeJson(const eastl::string& text)
+{
+    eastl::string result;
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        if (text[i] == '"' || text[i] == '\\')
+        {
+            result.push_back('\\');
+        }
+        result.push_back(text[i]);
+    }
+    return result;
+}
+
+FrameTrace::FrameTrace(IRHIDevice* pDevice)
+{
+    m_pDevice = pDevice;
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        m_timestampFrequency[i] = pDevice->GetTimestampFrequency((RHICommandQueue) i);
+    }
+}
+
+void FrameTrace::BeginFrame()
+{
+    CPU_EVENT("Render", "FrameTrace::BeginFrame");
+
+    m_resolvedGPUSpan = FrameTraceGPUSpan();
+
+    FrameEvents& frame = m_frames[m_pDevice->GetFrameID() % RHI_MAX_INFLIGHT_FRAMES];
+    if (frame.m_bValid)
+    {
+        ResolveFrame(frame);
+        frame.m_bValid = false;
+    }
+}
+
+void FrameTrace::EndFrame()
+{
+    double nowUs = stm_us(stm_now());
+
+    m_recordingFrame.m_frameID = m_pDevice->GetFrameID();
+    m_recordingFrame.m_bValid = true;
+    m_recordingFrame.m_beginUs = m_lastFrameEndUs > 0.0 ? m_lastFrameEndUs : nowUs;
+    m_recordingFrame.m_endUs = nowUs;
+    m_lastFrameEndUs = nowUs;
+
+    // The slot was resolved in BeginFrame, swapping keeps the capacity of its vectors for the next frame
+    FrameEvents& frame = m_frames[m_recordingFrame.m_frameID % RHI_MAX_INFLIGHT_FRAMES];
+    eastl::swap(frame, m_recordingFrame);
+    m_recordingFrame.m_cpuEvents.clear();
+    m_recordingFrame.m_gpuEvents.clear();
+}
+
+uint32_t FrameTrace::BeginCPUEvent(const eastl::string& name)
+{
+    double nowUs = stm_us(stm_now());
+    m_recordingFrame.m_cpuEvents.push_back({ name, nowUs, nowUs });
+    return (uint32_t) m_recordingFrame.m_cpuEvents.size() - 1;
+}
+
+void FrameTrace::EndCPUEvent(uint32_t event)
+{
+    m_recordingFrame.m_cpuEvents[event].m_endUs = stm_us(stm_now());
+}
+
+uint32_t FrameTrace::BeginGPUEvent(IRHICommandList* pCommandList, const eastl::string& name)
+{
+    uint32_t query = pCommandList->WriteTimestamp();
+    m_recordingFrame.m_gpuEvents.push_back({ name, pCommandList, query, RHI_INVALID_RESOURCE });
+    return (uint32_t) m_recordingFrame.m_gpuEvents.size() - 1;
+}
+
+void FrameTrace::EndGPUEvent(IRHICommandList* pCommandList, uint32_t event)
+{
+    GPUEvent& gpuEvent = m_recordingFrame.m_gpuEvents[event];
+    MY_ASSERT(gpuEvent.m_pCommandList == pCommandList);
+
+    gpuEvent.m_endQuery = pCommandList->WriteTimestamp();
+}
+
+void FrameTrace::Capture(uint32_t frameCount)
+{
+    if (m_captureFrameCount == 0)
+    {
+        m_capturedEvents.clear();
+        m_captureFrameCount = frameCount;
+    }
+}
+
+float FrameTrace::GetAverageGPUTime(const eastl::string& name) const
+{
+    auto iter = m_averageGPUTimes.find(name);
+    return iter != m_averageGPUTimes.end() ? iter->second : 0.0f;
+}
+
+void FrameTrace::ResolveFrame(const FrameEvents& frame)
+{
+    // One calibration per queue and frame, so the clock drift never accumulates
+    uint64_t calibrationTimestamp[3] = {};
+    double calibrationTimeUs[3] = {};
+    bool calibrated[3] = {};
+    double queueBusyUs[3] = {};
+
+    for (size_t i = 0; i < frame.m_gpuEvents.size(); ++i)
+    {
+        const GPUEvent& event = frame.m_gpuEvents[i];
+
+        uint32_t count = 0;
+        const uint64_t* pTimestamps = event.m_pCommandList->ReadTimestamps(count);
+        if (pTimestamps == nullptr || event.m_beginQuery >= count || event.m_endQuery >= count)
+        {
+            continue;   //< Out of queries, or no timestamp support on the queue
+        }
+
+        uint32_t queue = (uint32_t) event.m_pCommandList->GetQueue();
+        if (!calibrated[queue])
+        {
+            calibrated[queue] = m_pDevice->GetTimestampCalibration((RHICommandQueue) queue, calibrationTimestamp[queue], calibrationTimeUs[queue]);
+            if (!calibrated[queue])
+            {
+                continue;
+            }
+        }
+
+        double ticksToUs = 1000000.0 / (double) m_timestampFrequency[queue];
+        double beginUs = calibrationTimeUs[queue] + (double) (int64_t) (pTimestamps[event.m_beginQuery] - calibrationTimestamp[queue]) * ticksToUs;
+        double durationUs = (double) (int64_t) (pTimestamps[event.m_endQuery] - pTimestamps[event.m_beginQuery]) * ticksToUs;
+        queueBusyUs[queue] += durationUs;
+
+        if (!m_resolvedGPUSpan.m_bValid)
+        {
+            m_resolvedGPUSpan.m_frameID = frame.m_frameID;
+            m_resolvedGPUSpan.m_beginUs = beginUs;
+            m_resolvedGPUSpan.m_endUs = beginUs + durationUs;
+            m_resolvedGPUSpan.m_bValid = true;
+        }
+        m_resolvedGPUSpan.m_beginUs = min(m_resolvedGPUSpan.m_beginUs, beginUs);
+        m_resolvedGPUSpan.m_endUs = max(m_resolvedGPUSpan.m_endUs, beginUs + durationUs);
+
+        float& averageUs = m_averageGPUTimes[event.m_name];
+        averageUs = averageUs == 0.0f ? (float) durationUs : averageUs + ((float) durationUs - averageUs) * FRAME_TRACE_AVERAGE_WEIGHT;
+
+        if (IsCapturing())
+        {
+            m_capturedEvents.push_back({ event.m_name, TraceProcessGPU, queue, beginUs, durationUs, frame.m_frameID });
+        }
+    }
+
+    MICROPROFILE_COUNTER_SET("Renderer/FrameTrace/GraphicsQueueUs", (int64_t) queueBusyUs[(uint32_t) RHICommandQueue::Graphics]);
+    MICROPROFILE_COUNTER_SET("Renderer/FrameTrace/ComputeQueueUs", (int64_t) queueBusyUs[(uint32_t) RHICommandQueue::Compute]);
+    MICROPROFILE_COUNTER_SET("Renderer/FrameTrace/CopyQueueUs", (int64_t) queueBusyUs[(uint32_t) RHICommandQueue::Copy]);
+
+    if (!IsCapturing())
+    {
+        return;
+    }
+
+    m_capturedEvents.push_back({ fmt::format("Frame {}", frame.m_frameID).c_str(), TraceProcessCPU, TraceThreadFrames,
+        frame.m_beginUs, frame.m_endUs - frame.m_beginUs, frame.m_frameID });
+
+    for (size_t i = 0; i < frame.m_cpuEvents.size(); ++i)
+    {
+        const CPUEvent& event = frame.m_cpuEvents[i];
+        m_capturedEvents.push_back({ event.m_name, TraceProcessCPU, TraceThreadMain, event.m_beginUs, event.m_endUs - event.m_beginUs, frame.m_frameID });
+    }
+
+    if (--m_captureFrameCount == 0)
+    {
+        WriteCapture();
+    }
+}
+
+void FrameTrace::WriteCapture()
+{
+    CPU_EVENT("Render", "FrameTrace::WriteCapture");
+
+    if (m_capturedEvents.empty())
+    {
+        return;
+    }
+
+    double originUs = m_capturedEvents[0].m_beginUs;
+    for (size_t i = 1; i < m_capturedEvents.size(); ++i)
+    {
+        originUs = min(originUs, m_capturedEvents[i].m_beginUs);
+    }
+
+    eastl::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    json += fmt::format("{{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":{},\"args\":{{\"name\":\"CPU\"}}}},\n", (int) TraceProcessCPU).c_str();
+    json += fmt::format("{{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":{},\"args\":{{\"name\":\"GPU\"}}}},\n", (int) TraceProcessGPU).c_str();
+    json += fmt::format("{{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":{},\"tid\":{},\"args\":{{\"name\":\"Main Thread\"}}}},\n", (int) TraceProcessCPU, (int) TraceThreadMain).c_str();
+    json += fmt::format("{{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":{},\"tid\":{},\"args\":{{\"name\":\"Frames\"}}}},\n", (int) TraceProcessCPU, (int) TraceThreadFrames).c_str();
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        json += fmt::format("{{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":{},\"tid\":{},\"args\":{{\"name\":\"{}\"}}}},\n", (int) TraceProcessGPU, i, s_queueNames[i]).c_str();
+    }
+
+    for (size_t i = 0; i < m_capturedEvents.size(); ++i)
+    {
+        const TraceEvent& event = m_capturedEvents[i];
+        json += fmt::format("{{\"ph\":\"X\",\"name\":\"{}\",\"pid\":{},\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f},\"args\":{{\"frame\":{}}}}}{}\n",
+            EscapeJson(event.m_name).c_str(), event.m_process, event.m_thread, event.m_beginUs - originUs, event.m_durationUs, event.m_frameID,
+            i + 1 < m_capturedEvents.size() ? "," : "").c_str();
+    }
+    json += "]}\n";
+
+    eastl::string file = Engine::GetInstance()->GetWorkPath() + fmt::format("frame_trace_{}.json", m_capturedEvents[0].m_frameID).c_str();
+
+    std::ofstream stream;
+    stream.open(file.c_str());
+    stream << json.c_str();
+    stream.close();
+
+    MY_INFO("[FrameTrace] exported {} events to {}", m_capturedEvents.size(), file);
+    m_capturedEvents.clear();
+}
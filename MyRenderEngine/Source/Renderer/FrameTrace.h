@@ -0,0 +1,119 @@
+#pragma once
+#include "RHI/RHI.h"
+#include "EASTL/vector.h"
+#include "EASTL/string.h"
+#include "EASTL/hash_map.h"
+
+#define FRAME_TRACE_CAPTURE_FRAMES 8
+#define FRAME_TRACE_AVERAGE_WEIGHT 0.1f     //< Weight of the newest frame in the average GPU time of an event
+
+// GPU timeline of a frame in CPU time, from its first to its last timed event on any queue
+struct FrameTraceGPUSpan
+{
+    uint64_t m_frameID = 0;
+    double m_beginUs = 0.0;
+    double m_endUs = 0.0;
+    bool m_bValid = false;
+};
+
+// CPU and GPU timeline of every frame. GPU events are bracketed by timestamp queries on their own command list,
+// so work on the graphics, compute and copy queues is timed alike. Timestamps are read RHI_MAX_INFLIGHT_FRAMES later,
+// when the frame fence has been waited, and a capture of a few frames can be exported as Chrome trace json
+// which opens in chrome://tracing or ui.perfetto.dev
+class FrameTrace
+{
+public:
+    FrameTrace(IRHIDevice* pDevice);
+
+    // Called after the frame fence wait, before the command lists of the frame are reset
+    void BeginFrame();
+    // Called before IRHIDevice::EndFrame, events of the frame must be ended already
+    void EndFrame();
+
+    uint32_t BeginCPUEvent(const eastl::string& name);
+    void EndCPUEvent(uint32_t event);
+
+    uint32_t BeginGPUEvent(IRHICommandList* pCommandList, const eastl::string& name);
+    void EndGPUEvent(IRHICommandList* pCommandList, uint32_t event);
+
+    // Exports the next frameCount resolved frames to frame_trace_<frame ID>.json in the work path
+    void Capture(uint32_t frameCount = FRAME_TRACE_CAPTURE_FRAMES);
+    bool IsCapturing() const { return m_captureFrameCount > 0; }
+
+    // Smoothed GPU time of the events with this name, 0 when it was never timed
+    float GetAverageGPUTime(const eastl::string& name) const;
+
+    // The frame resolved by the last BeginFrame, not valid when there was none or nothing of it was timed
+    const FrameTraceGPUSpan& GetResolvedGPUSpan() const { return m_resolvedGPUSpan; }
+
+private:
+    struct CPUEvent
+    {
+        eastl::string m_name;
+        double m_beginUs;
+        double m_endUs;
+    };
+
+    struct GPUEvent
+    {
+        eastl::string m_name;
+        IRHICommandList* m_pCommandList;
+        uint32_t m_beginQuery;
+        uint32_t m_endQuery;
+    };
+
+    struct FrameEvents
+    {
+        uint64_t m_frameID = 0;
+        bool m_bValid = false;
+        double m_beginUs = 0.0;
+        double m_endUs = 0.0;
+        eastl::vector<CPUEvent> m_cpuEvents;
+        eastl::vector<GPUEvent> m_gpuEvents;
+    };
+
+    struct TraceEvent
+    {
+        eastl::string m_name;
+        uint32_t m_process;
+        uint32_t m_thread;
+        double m_beginUs;
+        double m_durationUs;
+        uint64_t m_frameID;
+    };
+
+    void ResolveFrame(const FrameEvents& frame);
+    void WriteCapture();
+
+private:
+    IRHIDevice* m_pDevice = nullptr;
+    uint64_t m_timestampFrequency[3] = {};      //< Indexed by RHICommandQueue
+
+    FrameEvents m_recordingFrame;
+    FrameEvents m_frames[RHI_MAX_INFLIGHT_FRAMES];   //< Waiting for the GPU
+    double m_lastFrameEndUs = 0.0;
+    FrameTraceGPUSpan m_resolvedGPUSpan;
+
+    eastl::hash_map<eastl::string, float> m_averageGPUTimes;
+
+    uint32_t m_captureFrameCount = 0;
+    eastl::vector<TraceEvent> m_capturedEvents;
+};
+
+class FrameTraceScope
+{
+public:
+    FrameTraceScope(FrameTrace* pTrace, const eastl::string& name) : m_pTrace(pTrace)
+    {
+        m_event = m_pTrace->BeginCPUEvent(name);
+    }
+
+    ~FrameTraceScope()
+    {
+        m_pTrace->EndCPUEvent(m_event);
+    }
+
+private:
+    FrameTrace* m_pTrace;
+    uint32_t m_event;
+};
@@ -1,5 +1,6 @@
 #include "GPUScene.h"
 #include "Renderer.h"
+#include "Utils/profiler.h"
 
 #define MAX_CONSTANT_BUFFER_SIZE (8 * 1024 * 1024) //< 8 MB
 #define ALLOCATION_ALIGNMENT (4)
@@ -16,6 +17,8 @@ GPUScene::GPUScene(Renderer* pRenderer)
     m_pSceneAnimationBuffer.reset(pRenderer->CreateRawBuffer(nullptr, animationBufferSize, "GPUScene::m_pSceneAnimationBuffer", RHIMemoryType::GPUOnly, true));
     m_pSceneAnimationBufferAllocator = eastl::make_unique<OffsetAllocator::Allocator>(animationBufferSize);
 
+    m_materialTableBuffer = AllocateStaticBuffer(sizeof(ModelMaterialConstant) * MATERIAL_TABLE_MAX_COUNT);
+
     for (int i = 0; i < RHI_MAX_INFLIGHT_FRAMES; ++i)
     {
         m_pConstantBuffer[i].reset(pRenderer->CreateRawBuffer(nullptr, MAX_CONSTANT_BUFFER_SIZE, "GPUScene::m_pConstantBuffer", RHIMemoryType::CPUToGPU));
@@ -24,7 +27,7 @@ GPUScene::GPUScene(Renderer* pRenderer)
 
 GPUScene::~GPUScene()
 {
-
+    FreeStaticBuffer(m_materialTableBuffer);
 }
 
 OffsetAllocator::Allocation GPUScene::AllocateStaticBuffer(uint32_t size)
@@ -84,6 +87,41 @@ void GPUScene::Update()
     m_localLightsDataAddress = m_pRenderer->AllocateSceneConstant(m_localLightsData.data(), sizeof(LocalLightData) * GetLocalLightCount());
 }
 
+uint32_t GPUScene::UpdateMaterial(uint32_t index, const ModelMaterialConstant& data)
+{
+    return m_materialTable.Update(index, data, m_pRenderer->GetFrameID());
+}
+
+void GPUScene::ReleaseMaterial(uint32_t index)
+{
+    m_materialTable.Release(index, m_pRenderer->GetFrameID());
+}
+
+void GPUScene::UploadMaterials()
+{
+    // Slots released in frame N are reused when frame N + RHI_MAX_INFLIGHT_FRAMES begins, the frames before may still read them
+    uint64_t frameID = m_pRenderer->GetFrameID();
+    if (frameID >= RHI_MAX_INFLIGHT_FRAMES)
+    {
+        m_materialTable.ProcessPendingReleases(frameID - RHI_MAX_INFLIGHT_FRAMES);
+    }
+
+    m_materialTable.CollectDirtyRanges(m_materialUploadRanges);
+    m_materialBytesUploaded = 0;
+
+    for (size_t i = 0; i < m_materialUploadRanges.size(); ++i)
+    {
+        uint32_t firstSlot = m_materialUploadRanges[i].x;
+        uint32_t size = sizeof(ModelMaterialConstant) * m_materialUploadRanges[i].y;
+
+        m_pRenderer->UploadBuffer(m_pSceneStaticBuffer->GetBuffer(), m_materialTableBuffer.offset + sizeof(ModelMaterialConstant) * firstSlot, m_materialTable.GetData(firstSlot), size);
+        m_materialBytesUploaded += size;
+    }
+
+    MICROPROFILE_COUNTER_SET("Renderer/GPUScene/MaterialCount", m_materialTable.GetUsedCount());
+    MICROPROFILE_COUNTER_SET("Renderer/GPUScene/MaterialBytesUploaded", m_materialBytesUploaded);
+}
+
 void GPUScene::BuildRayTracingAS(IRHICommandList* pCommandList)
 {
     GPU_EVENT(pCommandList, "BuildTLAS");
@@ -109,6 +147,19 @@ uint32_t GPUScene::AddInstance(const InstanceData& data, IRHIRayTracingBLAS* pBL
     m_instanceData.push_back(data);
     uint32_t instanceID = (uint32_t) m_instanceData.size() - 1;
 
+    if (data.m_bVertexAnimation || !nearly_equal(data.m_mtxWorld, data.m_mtxPrevWorld))
+    {
+        m_dirtyBounds.push_back(float4(data.m_center, data.m_radius));
+
+        // Skinned bounds of the last frame are not known, they were added in that frame
+        if (!data.m_bVertexAnimation)
+        {
+            float4 localCenter = mul(transpose(data.m_mtxWorldInverseTranspose), float4(data.m_center, 1.0f));
+            float4 prevCenter = mul(data.m_mtxPrevWorld, localCenter);
+            m_dirtyBounds.push_back(float4(prevCenter.xyz(), data.m_radius));
+        }
+    }
+
     if (pBLAS)
     {
         float4x4 transform = transpose(data.m_mtxWorld);
@@ -135,6 +186,8 @@ uint32_t GPUScene::AddLocalLight(const LocalLightData& data)
 void GPUScene::ResetFrameData()
 {
     m_instanceData.clear();
+    m_dirtyBounds.clear();
+    m_localLightsData.clear();      //< Lights are added again by their ticks
     m_constantBufferOffset = 0;
 }
 
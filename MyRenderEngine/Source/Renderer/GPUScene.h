@@ -1,5 +1,6 @@
 #pragma once
 #include "Resource/RawBuffer.h"
+#include "MaterialTable.h"
 #include "Utils/math.h"
 #include "OffsetAllocator/offsetAllocator.hpp"
 #include "GPUScene.hlsli"
@@ -25,6 +26,15 @@ public:
 
     uint32_t AddLocalLight(const LocalLightData& data);
     uint32_t GetLocalLightCount() const { return (uint32_t) m_localLightsData.size(); }
+    const eastl::vector<LocalLightData>& GetLocalLights() const { return m_localLightsData; }
+
+    // World space spheres of the instances which moved or are skinned in this frame, at their current and previous transforms
+    const eastl::vector<float4>& GetDirtyBounds() const { return m_dirtyBounds; }
+
+    uint32_t UpdateMaterial(uint32_t index, const ModelMaterialConstant& data);
+    void ReleaseMaterial(uint32_t index);
+    void UploadMaterials();     //< Before the uploads of the frame are submitted
+    uint32_t GetMaterialBytesUploaded() const { return m_materialBytesUploaded; }   //< In this frame
 
     void Update();
     void BuildRayTracingAS(IRHICommandList* pCommandList);
@@ -45,6 +55,7 @@ public:
 
     uint32_t GetInstanceDataAddress() const { return m_instanceDataAddress; }
     uint32_t GetLocalLightsDataAddress() const { return m_localLightsDataAddress; }
+    uint32_t GetMaterialDataAddress() const { return m_materialTableBuffer.offset; }   //< In the scene static buffer
     
     IRHIDescriptor* GetRayTracingTLASSRV() const { return m_pSceneTLASSRV.get(); }
 
@@ -53,6 +64,7 @@ private:
     
     eastl::vector<InstanceData> m_instanceData;
     uint32_t m_instanceDataAddress = 0;
+    eastl::vector<float4> m_dirtyBounds;
 
     eastl::vector<LocalLightData> m_localLightsData;
     uint32_t m_localLightsDataAddress = 0;
@@ -63,6 +75,11 @@ private:
     eastl::unique_ptr<RawBuffer> m_pSceneAnimationBuffer;
     eastl::unique_ptr<OffsetAllocator::Allocator> m_pSceneAnimationBufferAllocator;
 
+    MaterialTable m_materialTable;
+    OffsetAllocator::Allocation m_materialTableBuffer;
+    eastl::vector<uint2> m_materialUploadRanges;
+    uint32_t m_materialBytesUploaded = 0;
+
     eastl::unique_ptr<RawBuffer> m_pConstantBuffer[RHI_MAX_INFLIGHT_FRAMES];    // todo: change tp GPU memory, and only update dirty regions
     uint32_t m_constantBufferOffset = 0;
 
@@ -0,0 +1,58 @@
+#include "GTAOHalfRes.h"
+#include <cfloat>
+
+float4 GetGTAOUpsampleBilinearWeights(float2 f)
+{
+    return float4((1.0f - f.x) * (1.0f - f.y), f.x * (1.0f - f.y), (1.0f - f.x) * f.y, f.x * f.y);
+}
+
+float GetGTAOUpsampleWeight(float bilinearWeight, float lowDepth, float highDepth, float3 lowNormal, float3 highNormal)
+{
+    float depthWeight = exp2f(-fabsf(lowDepth - highDepth) / eastl::max(highDepth, 1e-4f) * GTAO_UPSAMPLE_DEPTH_SHARPNESS);
+    float normalWeight = powf(clamp(dot(lowNormal, highNormal), 0.0f, 1.0f), GTAO_UPSAMPLE_NORMAL_POWER);
+    return bilinearWeight * depthWeight * normalWeight;
+}
+
+float2 AccumulateGTAOHistory(float2 history, float ao, bool bHistoryValid)
+{
+    float frameCount = bHistoryValid ? eastl::min(history.y + 1.0f, (float) GTAO_TEMPORAL_MAX_FRAMES) : 1.0f;
+    return float2(lerp(history.x, ao, 1.0f / frameCount), frameCount);
+}
+
+float UpsampleGTAO(const eastl::vector<float>& lowAO, const eastl::vector<float>& lowDepth, const eastl::vector<float3>& lowNormal, uint2 lowSize,
+    uint2 highPos, float highDepth, float3 highNormal)
+{
+    const uint2 offsets[4] = { uint2(0, 0), uint2(1, 0), uint2(0, 1), uint2(1, 1) };
+
+    uint2 basePos = highPos / 2u;
+    float4 bilinearWeights = GetGTAOUpsampleBilinearWeights(float2(highPos % 2u) * 0.5f);
+
+    float ao = 0.0f;
+    float weightSum = 0.0f;
+    float closestAO = 0.0f;
+    float closestDepthDiff = FLT_MAX;
+
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        if (bilinearWeights[i] == 0.0f)
+        {
+            continue;
+        }
+
+        uint2 pos = min(basePos + offsets[i], lowSize - 1u);
+        uint32_t index = pos.y * lowSize.x + pos.x;
+
+        float weight = GetGTAOUpsampleWeight(bilinearWeights[i], lowDepth[index], highDepth, lowNormal[index], highNormal);
+        ao += lowAO[index] * weight;
+        weightSum += weight;
+
+        float depthDiff = fabsf(lowDepth[index] - highDepth);
+        if (depthDiff < closestDepthDiff)
+        {
+            closestDepthDiff = depthDiff;
+            closestAO = lowAO[index];
+        }
+    }
+
+    return weightSum < GTAO_UPSAMPLE_MIN_WEIGHT ? closestAO : ao / weightSum;
+}
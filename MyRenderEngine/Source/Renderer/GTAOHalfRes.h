@@ -0,0 +1,14 @@
+#pragma once
+#include "Utils/math.h"
+#include "GTAO/GTAOHalfRes.hlsli"
+#include "EASTL/vector.h"
+
+// CPU reference of the temporal accumulation and the upsampling of the half resolution GTAO, see GTAOTemporal and GTAOUpsample of GTAO.hlsl
+
+float4 GetGTAOUpsampleBilinearWeights(float2 f);
+float GetGTAOUpsampleWeight(float bilinearWeight, float lowDepth, float highDepth, float3 lowNormal, float3 highNormal);
+float2 AccumulateGTAOHistory(float2 history, float ao, bool bHistoryValid);
+
+// AO of the full resolution pixel highPos, the half resolution AO, linear depths and normals have lowSize.x * lowSize.y texels
+float UpsampleGTAO(const eastl::vector<float>& lowAO, const eastl::vector<float>& lowDepth, const eastl::vector<float3>& lowNormal, uint2 lowSize,
+    uint2 highPos, float highDepth, float3 highNormal);
@@ -0,0 +1,118 @@
+#include "HZB.h"
+#include <cstring>
+
+uint2 GetHZBSize(uint32_t renderWidth, uint32_t renderHeight, uint32_t& mipCount)
+{
+    uint32_t mipX = (uint32_t) eastl::max(ceilf(log2f((float) renderWidth)), 1.0f);
+    uint32_t mipY = (uint32_t) eastl::max(ceilf(log2f((float) renderHeight)), 1.0f);
+
+    mipCount = eastl::max(mipX, mipY);
+    return uint2(1 << (mipX - 1), 1 << (mipY - 1));
+}
+
+uint2 GetHZBMipSize(uint2 hzbSize, uint32_t mip)
+{
+    return uint2(eastl::max(hzbSize.x >> mip, 1u), eastl::max(hzbSize.y >> mip, 1u));
+}
+
+uint2 GetHZBFootprint(uint32_t texel, uint32_t srcSize, uint32_t dstSize)
+{
+    return uint2(texel * srcSize / dstSize, ((texel + 1) * srcSize + dstSize - 1) / dstSize);
+}
+
+void ReduceDepthToHZB(const eastl::vector<float>& depth, uint2 depthSize, uint2 hzbSize, eastl::vector<float2>& mip0)
+{
+    mip0.resize(hzbSize.x * hzbSize.y);
+
+    for (uint32_t y = 0; y < hzbSize.y; ++y)
+    {
+        uint2 footprintY = GetHZBFootprint(y, depthSize.y, hzbSize.y);
+
+        for (uint32_t x = 0; x < hzbSize.x; ++x)
+        {
+            uint2 footprintX = GetHZBFootprint(x, depthSize.x, hzbSize.x);
+
+            float2 minMax = float2(1.0f, 0.0f);
+            for (uint32_t j = footprintY.x; j < footprintY.y; ++j)
+            {
+                for (uint32_t i = footprintX.x; i < footprintX.y; ++i)
+                {
+                    float d = depth[j * depthSize.x + i];
+                    minMax = float2(min(minMax.x, d), max(minMax.y, d));
+                }
+            }
+            mip0[y * hzbSize.x + x] = minMax;
+        }
+    }
+}
+
+void ReduceHZBMip(const eastl::vector<float2>& src, uint2 srcSize, uint2 dstSize, eastl::vector<float2>& dst)
+{
+    dst.resize(dstSize.x * dstSize.y);
+
+    for (uint32_t y = 0; y < dstSize.y; ++y)
+    {
+        uint2 footprintY = GetHZBFootprint(y, srcSize.y, dstSize.y);
+
+        for (uint32_t x = 0; x < dstSize.x; ++x)
+        {
+            uint2 footprintX = GetHZBFootprint(x, srcSize.x, dstSize.x);
+
+            float2 minMax = float2(1.0f, 0.0f);
+            for (uint32_t j = footprintY.x; j < footprintY.y; ++j)
+            {
+                for (uint32_t i = footprintX.x; i < footprintX.y; ++i)
+                {
+                    const float2& v = src[j * srcSize.x + i];
+                    minMax = float2(min(minMax.x, v.x), max(minMax.y, v.y));
+                }
+            }
+            dst[y * dstSize.x + x] = minMax;
+        }
+    }
+}
+
+static float LoadReprojectedDepth(const eastl::vector<uint32_t>& reprojectedDepth, uint2 size, int2 pos)
+{
+    // Out of bounds loads are 0 on the GPU
+    if (pos.x < 0 || pos.y < 0 || pos.x >= (int32_t) size.x || pos.y >= (int32_t) size.y)
+    {
+        return 0.0f;
+    }
+
+    uint32_t value = reprojectedDepth[pos.y * size.x + pos.x];
+    if (value == HZB_REPROJECTION_EMPTY)
+    {
+        return 0.0f;
+    }
+
+    float depth;
+    memcpy(&depth, &value, sizeof(depth));
+    return depth;
+}
+
+float ResolveReprojectedDepth(const eastl::vector<uint32_t>& reprojectedDepth, uint2 size, int2 pos)
+{
+    float depth = LoadReprojectedDepth(reprojectedDepth, size, pos);
+    if (depth == 0.0f)
+    {
+        float minDepth = 1.0f;
+        for (int32_t y = -HZB_DILATION_RADIUS; y <= HZB_DILATION_RADIUS; ++y)
+        {
+            for (int32_t x = -HZB_DILATION_RADIUS; x <= HZB_DILATION_RADIUS; ++x)
+            {
+                float d = LoadReprojectedDepth(reprojectedDepth, size, pos + int2(x, y));
+                if (d > 0.0f && d < minDepth)
+                {
+                    minDepth = d;
+                }
+            }
+        }
+
+        if (minDepth != 1.0f)
+        {
+            depth = minDepth;
+        }
+    }
+    return depth;
+}
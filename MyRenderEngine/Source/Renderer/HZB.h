@@ -0,0 +1,21 @@
+#pragma once
+#include "Utils/math.h"
+#include "HZB/HZB.hlsli"
+#include "EASTL/vector.h"
+
+// CPU reference of the reductions of HZB.hlsl, the depth is reversed z so x of a texel is the farthest depth and y the nearest
+
+// Power of two HZB below the render size, as HZBPass uses
+uint2 GetHZBSize(uint32_t renderWidth, uint32_t renderHeight, uint32_t& mipCount);
+uint2 GetHZBMipSize(uint2 hzbSize, uint32_t mip);
+
+uint2 GetHZBFootprint(uint32_t texel, uint32_t srcSize, uint32_t dstSize);
+
+// Mip 0 of the fused min max build, sizes don't need to be powers of two
+void ReduceDepthToHZB(const eastl::vector<float>& depth, uint2 depthSize, uint2 hzbSize, eastl::vector<float2>& mip0);
+
+// SpdReduce4 of the power of two mips, odd sizes reduce the footprints of GetHZBFootprint instead of 2x2 texels
+void ReduceHZBMip(const eastl::vector<float2>& src, uint2 srcSize, uint2 dstSize, eastl::vector<float2>& dst);
+
+// The dilation of the fused reprojection build, reprojectedDepth has size.x * size.y texels
+float ResolveReprojectedDepth(const eastl::vector<uint32_t>& reprojectedDepth, uint2 size, int2 pos);
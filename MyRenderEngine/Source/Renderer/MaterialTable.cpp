@@ -0,0 +1,137 @@
+#include "MaterialTable.h"
+#include "Utils/assert.h"
+#include "xxHash/xxhash.h"
+#include "EASTL/sort.h"
+
+MaterialTable::MaterialTable()
+{
+    m_data.resize(MATERIAL_TABLE_MAX_COUNT);
+    m_hashes.resize(MATERIAL_TABLE_MAX_COUNT);
+    m_refCounts.resize(MATERIAL_TABLE_MAX_COUNT);
+
+    // Popped from the back, so the low slots are used first
+    m_freeSlots.reserve(MATERIAL_TABLE_MAX_COUNT);
+    for (uint32_t i = MATERIAL_TABLE_MAX_COUNT; i > 0; --i)
+    {
+        m_freeSlots.push_back(i - 1);
+    }
+}
+
+uint32_t MaterialTable::Update(uint32_t index, const ModelMaterialConstant& data, uint64_t frameID)
+{
+    if (index != MATERIAL_TABLE_INVALID_INDEX && memcmp(&m_data[index], &data, sizeof(ModelMaterialConstant)) == 0)
+    {
+        return index;
+    }
+
+    // Acquired before the release, so a slot shared with other materials isn't written with the new constants
+    uint32_t newIndex = Acquire(data);
+
+    if (index != MATERIAL_TABLE_INVALID_INDEX)
+    {
+        Release(index, frameID);
+    }
+
+    return newIndex;
+}
+
+void MaterialTable::Release(uint32_t index, uint64_t frameID)
+{
+    MY_ASSERT(index < MATERIAL_TABLE_MAX_COUNT && m_refCounts[index] > 0);
+
+    if (--m_refCounts[index] == 0)
+    {
+        auto iter = m_slotMap.find(m_hashes[index]);
+        if (iter != m_slotMap.end() && iter->second == index)
+        {
+            m_slotMap.erase(iter);
+        }
+
+        // Out of the map right away, so new materials don't share a slot which is going to be reused
+        m_pendingReleases.push_back({ index, frameID });
+    }
+}
+
+void MaterialTable::ProcessPendingReleases(uint64_t completedFrameID)
+{
+    // Released in order of frame ID, so the completed ones are at the front
+    size_t releasedCount = 0;
+    while (releasedCount < m_pendingReleases.size() && m_pendingReleases[releasedCount].m_frameID <= completedFrameID)
+    {
+        m_freeSlots.push_back(m_pendingReleases[releasedCount].m_index);
+        ++releasedCount;
+    }
+
+    if (releasedCount > 0)
+    {
+        m_pendingReleases.erase(m_pendingReleases.begin(), m_pendingReleases.begin() + releasedCount);
+    }
+}
+
+uint32_t MaterialTable::Acquire(const ModelMaterialConstant& data)
+{
+    uint64_t hash = XXH3_64bits(&data, sizeof(ModelMaterialConstant));
+
+    auto iter = m_slotMap.find(hash);
+    if (iter != m_slotMap.end() && memcmp(&m_data[iter->second], &data, sizeof(ModelMaterialConstant)) == 0)
+    {
+        ++m_refCounts[iter->second];
+        return iter->second;
+    }
+
+    if (m_freeSlots.empty())
+    {
+        MY_ASSERT(false);   //< Increase MATERIAL_TABLE_MAX_COUNT
+        return 0;
+    }
+
+    uint32_t index = m_freeSlots.back();
+    m_freeSlots.pop_back();
+
+    m_data[index] = data;
+    m_hashes[index] = hash;
+    m_refCounts[index] = 1;
+    m_dirtySlots.push_back(index);
+
+    // On a hash collision the slot isn't shared, the map keeps the first one
+    if (iter == m_slotMap.end())
+    {
+        m_slotMap.insert(eastl::make_pair(hash, index));
+    }
+
+    return index;
+}
+
+void MaterialTable::CollectDirtyRanges(eastl::vector<uint2>& ranges)
+{
+    ranges.clear();
+    if (m_dirtySlots.empty())
+    {
+        return;
+    }
+
+    eastl::sort(m_dirtySlots.begin(), m_dirtySlots.end());
+
+    uint2 range = uint2(m_dirtySlots[0], 1);
+    for (size_t i = 1; i < m_dirtySlots.size(); ++i)
+    {
+        uint32_t slot = m_dirtySlots[i];
+        if (slot < range.x + range.y)
+        {
+            continue;   //< Written more than once
+        }
+
+        if (slot == range.x + range.y)
+        {
+            ++range.y;
+        }
+        else
+        {
+            ranges.push_back(range);
+            range = uint2(slot, 1);
+        }
+    }
+    ranges.push_back(range);
+
+    m_dirtySlots.clear();
+}
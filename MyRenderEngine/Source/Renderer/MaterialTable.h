@@ -0,0 +1,51 @@
+#pragma once
+#include "Utils/math.h"
+#include "RHI/RHIDefines.h"
+#include "ModelConstants.hlsli"
+#include "EASTL/vector.h"
+#include "EASTL/hash_map.h"
+
+#define MATERIAL_TABLE_MAX_COUNT 8192               //< Slots of the table in the scene static buffer
+#define MATERIAL_TABLE_INVALID_INDEX UINT32_MAX
+
+// Persistent slots of the material constants, indexed by InstanceData::m_materialIndex.
+// Materials with the same constants share a slot, and only the slots written since the last upload are copied to the GPU
+class MaterialTable
+{
+public:
+    MaterialTable();
+
+    // Returns the slot of the constants, the previous slot of the material is released if it is valid.
+    // frameID is the frame which stops using the released slot
+    uint32_t Update(uint32_t index, const ModelMaterialConstant& data, uint64_t frameID);
+
+    // The slot is reused when ProcessPendingReleases is called with a completed frame ID >= frameID, the frames in flight may still read it
+    void Release(uint32_t index, uint64_t frameID);
+    void ProcessPendingReleases(uint64_t completedFrameID);
+
+    // Dirty slots merged into contiguous ranges, x : first slot, y : slot count. The dirty slots are cleared
+    void CollectDirtyRanges(eastl::vector<uint2>& ranges);
+
+    const ModelMaterialConstant* GetData(uint32_t index) const { return &m_data[index]; }
+    uint32_t GetUsedCount() const { return MATERIAL_TABLE_MAX_COUNT - (uint32_t) m_freeSlots.size(); }     //< Including the pending releases
+    uint32_t GetPendingCount() const { return (uint32_t) m_pendingReleases.size(); }
+    uint32_t GetRefCount(uint32_t index) const { return m_refCounts[index]; }
+
+private:
+    uint32_t Acquire(const ModelMaterialConstant& data);
+
+    struct PendingRelease
+    {
+        uint32_t m_index;
+        uint64_t m_frameID;
+    };
+
+private:
+    eastl::vector<ModelMaterialConstant> m_data;    //< CPU copy of the table
+    eastl::vector<uint64_t> m_hashes;
+    eastl::vector<uint32_t> m_refCounts;
+    eastl::vector<uint32_t> m_freeSlots;
+    eastl::vector<PendingRelease> m_pendingReleases;
+    eastl::vector<uint32_t> m_dirtySlots;
+    eastl::hash_map<uint64_t, uint32_t> m_slotMap;  //< Hash of the constants to the slot holding them
+};
@@ -78,6 +78,8 @@ public:
 
     void ReCreatePSO(IRHIShader* pShader);
 
+    uint32_t GetPipelineStateCount() const { return (uint32_t) (m_cachedGraphicsPSO.size() + m_cachedMeshShaderPSO.size() + m_cachedComputePSO.size()); }
+
 private:
     Renderer* m_pRenderer;
     eastl::hash_map<RHIGraphicsPipelineDesc, eastl::unique_ptr<IRHIPipelineState>> m_cachedGraphicsPSO;
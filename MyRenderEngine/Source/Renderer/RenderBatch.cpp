@@ -0,0 +1,13 @@
+#include "RenderBatch.h"
+#include "Core/Engine.h"
+#include "enkiTS/TaskScheduler.h"
+
+uint32_t GetRenderBatchThreadIndex()
+{
+    return Engine::GetInstance()->GetTaskScheduler()->GetThreadNum();
+}
+
+uint32_t GetRenderBatchThreadCount()
+{
+    return Engine::GetInstance()->GetTaskScheduler()->GetNumTaskThreads();
+}
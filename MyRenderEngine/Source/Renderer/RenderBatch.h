@@ -1,14 +1,55 @@
 #pragma once
 #include "RHI/RHI.h"
 #include "Utils/math.h"
-#include "Utils/linear_allocator.h"
+#include "Utils/frame_allocator.h"
+#include "EASTL/unique_ptr.h"
 
 #define MAX_RENDER_BATCH_CB_COUNT RHI_MAX_CBV_BINDINGS
 
+// Constants of a batch are a variable-length packet stream in the arena of the thread which built the batch,
+// newest packet first, the data follows the header directly
+struct RenderBatchConstantPacket
+{
+    const RenderBatchConstantPacket* m_pNext;
+    uint16_t m_slot;
+    uint16_t m_dataSize;
+
+    const void* GetData() const { return this + 1; }
+};
+
+inline const RenderBatchConstantPacket* AddConstantPacket(LinearAllocator* pAllocator, const RenderBatchConstantPacket* pNext, uint32_t slot, const void* pData, size_t dataSize)
+{
+    MY_ASSERT(slot < MAX_RENDER_BATCH_CB_COUNT);
+    MY_ASSERT(dataSize <= UINT16_MAX);
+
+    RenderBatchConstantPacket* pPacket = (RenderBatchConstantPacket*) pAllocator->Alloc(sizeof(RenderBatchConstantPacket) + (uint32_t) dataSize, alignof(RenderBatchConstantPacket));
+    pPacket->m_pNext = pNext;
+    pPacket->m_slot = (uint16_t) slot;
+    pPacket->m_dataSize = (uint16_t) dataSize;
+    memcpy(pPacket + 1, pData, dataSize);
+
+    return pPacket;
+}
+
+template<typename F>
+inline void ForEachConstantPacket(const RenderBatchConstantPacket* pPackets, F fun)
+{
+    uint32_t setSlots = 0;  //< Newer packets overwrite older ones in the same slot
+    for (const RenderBatchConstantPacket* pPacket = pPackets; pPacket != nullptr; pPacket = pPacket->m_pNext)
+    {
+        uint32_t slotBit = 1 << pPacket->m_slot;
+        if ((setSlots & slotBit) == 0)
+        {
+            setSlots |= slotBit;
+            fun(pPacket->m_slot, pPacket->GetData(), pPacket->m_dataSize);
+        }
+    }
+}
+
 struct RenderBatch
 {
 public:
-    RenderBatch(LinearAllocator& cbAllocator) : m_allocator(cbAllocator)
+    RenderBatch(LinearAllocator& cbAllocator) : m_pAllocator(&cbAllocator)
     {
         m_pIB = nullptr;
     }
@@ -25,15 +66,7 @@ public:
 
     void SetConstantBuffer(uint32_t slot, const void* pData, size_t dataSize)
     {
-        MY_ASSERT(slot < MAX_RENDER_BATCH_CB_COUNT);
-        
-        if (m_cb[slot].m_pData == nullptr || m_cb[slot].m_dataSize < dataSize)
-        {
-            m_cb[slot].m_pData = m_allocator.Alloc((uint32_t) dataSize);
-        }
-
-        m_cb[slot].m_dataSize = (uint32_t) dataSize;
-        memcpy(m_cb[slot].m_pData, pData, dataSize);
+        m_pConstants = AddConstantPacket(m_pAllocator, m_pConstants, slot, pData, dataSize);
     }
 
     void SetIndexBuffer(IRHIBuffer* pBuffer, uint32_t offset, RHIFormat format)
@@ -64,12 +97,7 @@ public:
     const char* m_label = "";
     IRHIPipelineState* m_pPSO = nullptr;
     IRHIPipelineState* m_pCustomPSO = nullptr; //< Something that can use for replace original PSO
-
-    struct
-    {
-        void* m_pData = nullptr;
-        uint32_t m_dataSize = 0;
-    } m_cb[MAX_RENDER_BATCH_CB_COUNT];
+    const RenderBatchConstantPacket* m_pConstants = nullptr;
 
     union
     {
@@ -96,7 +124,7 @@ public:
     uint32_t m_vertexCount = 0;
 
 private:
-    LinearAllocator& m_allocator;
+    LinearAllocator* m_pAllocator;
 };
 
 inline void DrawBatch(IRHICommandList* pCommandList, const RenderBatch& batch)
@@ -104,14 +132,11 @@ inline void DrawBatch(IRHICommandList* pCommandList, const RenderBatch& batch)
     GPU_EVENT_DEBUG(pCommandList, batch.m_label);
 
     pCommandList->SetPipelineState(batch.m_pPSO);
-    
-    for (int i = 0; i < MAX_RENDER_BATCH_CB_COUNT; ++i)
-    {
-        if (batch.m_cb[i].m_pData != nullptr)
+
+    ForEachConstantPacket(batch.m_pConstants, [&](uint32_t slot, const void* pData, uint32_t dataSize)
         {
-            pCommandList->SetGraphicsConstants(i, batch.m_cb[i].m_pData, batch.m_cb[i].m_dataSize);
-        }
-    }
+            pCommandList->SetGraphicsConstants(slot, pData, dataSize);
+        });
 
     if (batch.m_pPSO->GetType() == RHIPipelineType::MeshShading)
     {
@@ -132,7 +157,7 @@ inline void DrawBatch(IRHICommandList* pCommandList, const RenderBatch& batch)
 struct ComputeBatch
 {
 public:
-    ComputeBatch(LinearAllocator& cbAllocator) : m_allocator(cbAllocator)
+    ComputeBatch(LinearAllocator& cbAllocator) : m_pAllocator(&cbAllocator)
     {
 
     }
@@ -144,15 +169,7 @@ public:
 
     void SetConstantBuffer(uint32_t slot, const void* pData, size_t dataSize)
     {
-        MY_ASSERT(slot < MAX_RENDER_BATCH_CB_COUNT);
-        
-        if (m_cb[slot].m_pData == nullptr || m_cb[slot].m_dataSize < dataSize)
-        {
-            m_cb[slot].m_pData = m_allocator.Alloc((uint32_t) dataSize);
-        }
-
-        m_cb[slot].m_dataSize = (uint32_t) dataSize;
-        memcpy(m_cb[slot].m_pData, pData, dataSize);
+        m_pConstants = AddConstantPacket(m_pAllocator, m_pConstants, slot, pData, dataSize);
     }
 
     void Dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
@@ -164,18 +181,13 @@ public:
 public:
     const char* m_label = "";
     IRHIPipelineState* m_pPSO = nullptr;
-
-    struct
-    {
-        void* m_pData = nullptr;
-        uint32_t m_dataSize = 0;
-    } m_cb[MAX_RENDER_BATCH_CB_COUNT];
+    const RenderBatchConstantPacket* m_pConstants = nullptr;
 
     uint32_t m_dispatchX = 0;
     uint32_t m_dispatchY = 0;
     uint32_t m_dispatchZ = 0;
 private:
-    LinearAllocator& m_allocator;
+    LinearAllocator* m_pAllocator;
 };
 
 inline void DispatchBatch(IRHICommandList* pCommandList, const ComputeBatch& batch)
@@ -183,14 +195,71 @@ inline void DispatchBatch(IRHICommandList* pCommandList, const ComputeBatch& bat
     GPU_EVENT_DEBUG(pCommandList, batch.m_label);
 
     pCommandList->SetPipelineState(batch.m_pPSO);
-    
-    for (int i = 0; i < MAX_RENDER_BATCH_CB_COUNT; ++i)
+
+    ForEachConstantPacket(batch.m_pConstants, [&](uint32_t slot, const void* pData, uint32_t dataSize)
+        {
+            pCommandList->SetComputeConstants(slot, pData, dataSize);
+        });
+
+    pCommandList->Dispatch(batch.m_dispatchX, batch.m_dispatchY, batch.m_dispatchZ);
+}
+
+// Returns the task scheduler thread index of the caller, 0 is the main thread
+uint32_t GetRenderBatchThreadIndex();
+uint32_t GetRenderBatchThreadCount();
+
+// Batches are appended to the list of the calling thread and merged at submit
+template<typename T>
+class RenderBatchList
+{
+public:
+    RenderBatchList() : m_threadBatches(GetRenderBatchThreadCount())
+    {
+    }
+
+    // Must be called from the main thread or a task scheduler thread, other threads have no list and no arena
+    T& Add(FrameAllocator& allocator)
+    {
+        LinearAllocator* pArena = allocator.GetThreadArena();
+        MY_ASSERT(pArena != nullptr);
+
+        return m_threadBatches[GetRenderBatchThreadIndex()].emplace_back(*pArena);
+    }
+
+    // Must be called from one thread after all batches are built, keeps the per-thread order
+    const eastl::vector<T>& Merge()
     {
-        if (batch.m_cb[i].m_pData != nullptr)
+        m_mergedBatches.clear();
+        m_mergedBatches.reserve(GetCount());
+
+        for (size_t i = 0; i < m_threadBatches.size(); ++i)
         {
-            pCommandList->SetComputeConstants(i, batch.m_cb[i].m_pData, batch.m_cb[i].m_dataSize);
+            m_mergedBatches.insert(m_mergedBatches.end(), m_threadBatches[i].begin(), m_threadBatches[i].end());
         }
+
+        return m_mergedBatches;
     }
 
-    pCommandList->Dispatch(batch.m_dispatchX, batch.m_dispatchY, batch.m_dispatchZ);
-}
\ No newline at end of file
+    size_t GetCount() const
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < m_threadBatches.size(); ++i)
+        {
+            count += m_threadBatches[i].size();
+        }
+        return count;
+    }
+
+    void Clear()
+    {
+        for (size_t i = 0; i < m_threadBatches.size(); ++i)
+        {
+            m_threadBatches[i].clear();
+        }
+        m_mergedBatches.clear();
+    }
+
+private:
+    eastl::vector<eastl::vector<T>> m_threadBatches;
+    eastl::vector<T> m_mergedBatches;
+};
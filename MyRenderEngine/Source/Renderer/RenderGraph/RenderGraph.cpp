@@ -1,10 +1,14 @@
 #include "RenderGraph.h"
 #include "Core/Engine.h"
 #include "Utils/profiler.h"
+#include "EASTL/sort.h"
+#include "EASTL/hash_map.h"
 
 RenderGraph::RenderGraph(Renderer* pRenderer) :
     m_resourceAllocator(pRenderer->GetDevice())
 {
+    m_pRenderer = pRenderer;
+
     IRHIDevice* pDevice = pRenderer->GetDevice();
     m_pComputeQueueFence.reset(pDevice->CreateFence("RenderGraph::m_pComputeQueueFence"));
     m_pGraphicsQueueFence.reset(pDevice->CreateFence("RenderGraph::m_pGraphicsQueueFence"));
@@ -44,6 +48,9 @@ void RenderGraph::Clear()
     m_allocator.Reset();
     m_resourceAllocator.Reset();
 
+    MICROPROFILE_COUNTER_SET("RenderGraph/Allocator/LastFrameBytes", m_allocator.GetLastFrameSize());
+    MICROPROFILE_COUNTER_SET("RenderGraph/Allocator/HighWaterMark", m_allocator.GetHighWaterMark());
+
     m_outputResources.clear();
 }
 
@@ -53,6 +60,8 @@ void RenderGraph::Compile()
 
     m_graph.Cull();
 
+    ScheduleAsyncCompute();
+
     RenderGraphAsyncResolveContext context;
 
     for (size_t i = 0; i < m_passes.size(); ++i)
@@ -64,6 +73,8 @@ void RenderGraph::Compile()
         }
     }
 
+    MergeReadStates();
+
     eastl::vector<DAGEdge*> edges;
     for (size_t i = 0; i < m_resourceNodes.size(); ++i)
     {
@@ -108,12 +119,233 @@ void RenderGraph::Compile()
         }
     }
 
+    // Split barriers can't cross a fence, so passes are grouped by the command list submissions between them
+    uint32_t executeIndex = 0;
+    uint32_t submitSegment = 0;
+    for (size_t i = 0; i < m_passes.size(); ++i)
+    {
+        RenderGraphPassBase* pPass = m_passes[i];
+        if (pPass->IsCulled())
+        {
+            continue;
+        }
+
+        if (pPass->IsSubmittedBefore())
+        {
+            ++submitSegment;
+        }
+
+        pPass->ResolveBarriers(m_graph, executeIndex++, submitSegment);
+
+        if (pPass->IsSubmittedAfter())
+        {
+            ++submitSegment;
+        }
+    }
+
+    uint32_t transitionCount = 0;
+    uint32_t splitBarrierCount = 0;
+    uint32_t uavBarrierCount = 0;
+    uint32_t uavDependencyCount = 0;
+    uint32_t mergedReadCount = 0;
+    for (size_t i = 0; i < m_passes.size(); ++i)
+    {
+        const RenderGraphBarrierPlan& plan = m_passes[i]->GetBarrierPlan();
+        transitionCount += (uint32_t) plan.m_transitions.size();
+        splitBarrierCount += (uint32_t) plan.m_splitEndBarriers.size();
+        uavBarrierCount += plan.m_uavDependencyCount > 0 ? 1 : 0;
+        uavDependencyCount += plan.m_uavDependencyCount;
+        mergedReadCount += plan.m_mergedReadCount;
+    }
+
+    MICROPROFILE_COUNTER_SET("RenderGraph/Barriers/Transitions", transitionCount);
+    MICROPROFILE_COUNTER_SET("RenderGraph/Barriers/SplitBarriers", splitBarrierCount);
+    MICROPROFILE_COUNTER_SET("RenderGraph/Barriers/UAVBarriers", uavBarrierCount);
+    MICROPROFILE_COUNTER_SET("RenderGraph/Barriers/UAVDependencies", uavDependencyCount);
+    MICROPROFILE_COUNTER_SET("RenderGraph/Barriers/MergedReads", mergedReadCount);
+}
+
+void RenderGraph::ScheduleAsyncCompute()
+{
+    m_asyncSchedule = RenderGraphAsyncSchedule();
+
+    if (!m_bAsyncScheduling || !m_pRenderer->IsAsyncComputeEnabled())
+    {
+        return;
+    }
+
+    CPU_EVENT("Render", "RenderGraph::ScheduleAsyncCompute");
+
+    FrameTrace* pFrameTrace = m_pRenderer->GetFrameTrace();
+
+    eastl::vector<RenderGraphPassBase*> passes;
+    eastl::hash_map<DAGNodeID, uint32_t> passIndices;
     for (size_t i = 0; i < m_passes.size(); ++i)
     {
         RenderGraphPassBase* pPass = m_passes[i];
         if (!pPass->IsCulled())
         {
-            pPass->ResolveBarriers(m_graph);
+            passIndices[pPass->GetID()] = (uint32_t) passes.size();
+            passes.push_back(pPass);
+        }
+    }
+
+    eastl::vector<RenderGraphAsyncNode> nodes(passes.size());
+    eastl::vector<DAGEdge*> edges;
+    eastl::vector<DAGEdge*> resourceEdges;
+    eastl::vector<RenderGraphResource*> writtenResources;
+    for (size_t i = 0; i < passes.size(); ++i)
+    {
+        RenderGraphPassBase* pPass = passes[i];
+        RenderGraphAsyncNode& node = nodes[i];
+
+        node.m_costUs = pPass->GetCostHint() > 0.0f ? pPass->GetCostHint() : pFrameTrace->GetAverageGPUTime(pPass->GetName());
+        node.m_bComputeOnly = (pPass->GetType() == RenderPassType::Compute && pPass->IsAsyncComputeAllowed()) || pPass->GetType() == RenderPassType::AsyncCompute;
+        node.m_override = pPass->GetAsyncComputeOverride();
+        if (pPass->GetType() == RenderPassType::AsyncCompute && node.m_override == RenderGraphAsyncOverride::Auto)
+        {
+            node.m_override = RenderGraphAsyncOverride::Async;      //< Declared async by the pass
+        }
+
+        writtenResources.clear();
+        m_graph.GetOutgoingEdges(pPass, edges);
+        for (size_t j = 0; j < edges.size(); ++j)
+        {
+            writtenResources.push_back(((RenderGraphResourceNode*) m_graph.GetNode(edges[j]->GetToNode()))->GetResource());
+        }
+
+        // Depends on the writers of its inputs, and a writer also depends on the earlier readers of the overwritten version
+        m_graph.GetIncomingEdges(pPass, edges);
+        for (size_t j = 0; j < edges.size(); ++j)
+        {
+            RenderGraphResourceNode* pNode = (RenderGraphResourceNode*) m_graph.GetNode(edges[j]->GetFromNode());
+
+            m_graph.GetIncomingEdges(pNode, resourceEdges);
+            if (eastl::find(writtenResources.begin(), writtenResources.end(), pNode->GetResource()) != writtenResources.end())
+            {
+                eastl::vector<DAGEdge*> readerEdges;
+                m_graph.GetOutgoingEdges(pNode, readerEdges);
+                resourceEdges.insert(resourceEdges.end(), readerEdges.begin(), readerEdges.end());
+            }
+
+            for (size_t k = 0; k < resourceEdges.size(); ++k)
+            {
+                DAGNodeID passID = resourceEdges[k]->GetFromNode() == pNode->GetID() ? resourceEdges[k]->GetToNode() : resourceEdges[k]->GetFromNode();
+                auto iter = passIndices.find(passID);
+                if (iter != passIndices.end() && iter->second < i)
+                {
+                    node.m_dependencies.push_back(iter->second);
+                }
+            }
+        }
+    }
+
+    RenderGraphAsyncScheduler::Schedule(nodes, m_asyncSchedule);
+
+    for (size_t i = 0; i < passes.size(); ++i)
+    {
+        if (nodes[i].m_bComputeOnly)
+        {
+            passes[i]->SetAsyncCompute(m_asyncSchedule.m_async[i]);
+        }
+    }
+
+    MICROPROFILE_COUNTER_SET("RenderGraph/AsyncCompute/Passes", m_asyncSchedule.m_asyncPassCount);
+    MICROPROFILE_COUNTER_SET("RenderGraph/AsyncCompute/Fences", m_asyncSchedule.m_fenceCount);
+    MICROPROFILE_COUNTER_SET("RenderGraph/AsyncCompute/ExpectedOverlapUs", (int64_t) m_asyncSchedule.m_expectedOverlapUs);
+}
+
+// Consecutive readers of a resource version share one combined read state (eg. PS SRV + CS SRV),
+// so the resource transitions once before the first reader instead of once per reader
+void RenderGraph::MergeReadStates()
+{
+    struct Reader
+    {
+        RenderGraphEdge* m_pEdge;
+        RenderGraphPassBase* m_pPass;
+    };
+
+    eastl::vector<DAGEdge*> edges;
+    eastl::vector<Reader> readers;
+    for (size_t i = 0; i < m_resourceNodes.size(); ++i)
+    {
+        RenderGraphResourceNode* pNode = m_resourceNodes[i];
+        if (pNode->IsCulled())
+        {
+            continue;
+        }
+
+        RHIAccessFlags readStates = pNode->GetResource()->GetMergeableReadStates();
+        DAGNodeID writerID = UINT32_MAX;
+        bool asyncReader = false;
+        readers.clear();
+
+        m_graph.GetOutgoingEdges(pNode, edges);
+        for (size_t j = 0; j < edges.size(); ++j)
+        {
+            RenderGraphEdge* pEdge = (RenderGraphEdge*) edges[j];
+            RenderGraphPassBase* pPass = (RenderGraphPassBase*) m_graph.GetNode(pEdge->GetToNode());
+            if (pPass->IsCulled())
+            {
+                continue;
+            }
+
+            if ((pEdge->GetUsage() & ~readStates) != 0)
+            {
+                writerID = min(writerID, pPass->GetID());
+            }
+            else
+            {
+                asyncReader |= pPass->GetType() == RenderPassType::AsyncCompute;
+                readers.push_back({ pEdge, pPass });
+            }
+        }
+
+        // Async compute readers are transitioned on their own queue
+        if (asyncReader || readers.size() < 2)
+        {
+            continue;
+        }
+
+        eastl::sort(readers.begin(), readers.end(), [](const Reader& a, const Reader& b)
+            {
+                if (a.m_pEdge->GetSubResource() != b.m_pEdge->GetSubResource())
+                {
+                    return a.m_pEdge->GetSubResource() < b.m_pEdge->GetSubResource();
+                }
+                return a.m_pPass->GetID() < b.m_pPass->GetID();
+            });
+
+        for (size_t begin = 0; begin < readers.size();)
+        {
+            uint32_t subresource = readers[begin].m_pEdge->GetSubResource();
+            size_t end = begin;
+            RHIAccessFlags mergedState = 0;
+            while (end < readers.size() && readers[end].m_pEdge->GetSubResource() == subresource && readers[end].m_pPass->GetID() < writerID)
+            {
+                mergedState |= readers[end].m_pEdge->GetUsage();
+                ++end;
+            }
+
+            for (size_t j = begin; j < end; ++j)
+            {
+                if (j > begin && readers[j].m_pEdge->GetUsage() != readers[j - 1].m_pEdge->GetUsage())
+                {
+                    readers[j].m_pPass->GetBarrierPlan().m_mergedReadCount++;
+                }
+            }
+
+            for (size_t j = begin; j < end; ++j)
+            {
+                readers[j].m_pEdge->SetUsage(mergedState);
+            }
+
+            // Readers after the writer keep their own states
+            while (end < readers.size() && readers[end].m_pEdge->GetSubResource() == subresource)
+            {
+                ++end;
+            }
+            begin = end;
         }
     }
 }
@@ -36,6 +36,11 @@ public:
     RGTexture* GetTexture(const RGHandle& handle);
     RGBuffer* GetBuffer(const RGHandle& handle);
 
+    // Moves the compute passes which allow it to the compute queue by their recent GPU time, when async compute is enabled in the renderer
+    bool IsAsyncSchedulingEnabled() const { return m_bAsyncScheduling; }
+    void SetAsyncSchedulingEnabled(bool value) { m_bAsyncScheduling = value; }
+    const RenderGraphAsyncSchedule& GetAsyncSchedule() const { return m_asyncSchedule; }
+
     const DirectedAcyclicGraph& GetDAG() const { return m_graph; }
     eastl::string Export();
 
@@ -55,13 +60,20 @@ private:
     RGHandle WriteColor(RenderGraphPassBase* pPass, uint32_t colorIndex, const RGHandle& input, uint32_t subresource, RHIRenderPassLoadOp loadOp, const float4& clearColor);
     RGHandle WriteDepth(RenderGraphPassBase* pPass, const RGHandle& input, uint32_t subresource, RHIRenderPassLoadOp depthLoadOp, RHIRenderPassLoadOp stencilLoadOp, float clearDepth, uint32_t clearStencil);
     RGHandle ReadDepth(RenderGraphPassBase* pPass, const RGHandle& input, uint32_t subresource);
+
+    void ScheduleAsyncCompute();
+    void MergeReadStates();
    
 private:
-    LinearAllocator m_allocator { 512* 1024 };    //< 512 KByte
+    Renderer* m_pRenderer = nullptr;
+    LinearAllocator m_allocator { 512* 1024 };    //< 512 KByte, chains more chunks when it is full
     RenderGraphResourceAllocator m_resourceAllocator;
     DirectedAcyclicGraph m_graph;
 
     eastl::vector<eastl::string> m_eventNames;
+
+    bool m_bAsyncScheduling = false;
+    RenderGraphAsyncSchedule m_asyncSchedule;
     
     eastl::unique_ptr<IRHIFence> m_pComputeQueueFence;
     uint64_t m_computeQueueFenceValue = 0;
@@ -13,6 +13,7 @@ public:
     }
 
     RHIAccessFlags GetUsage() const { return m_usage; }
+    void SetUsage(RHIAccessFlags usage) { m_usage = usage; }     //< Only for merging read states in RenderGraph::Compile
     uint32_t GetSubResource() const { return m_subresource; }
 
 private:
@@ -120,7 +121,7 @@ void ClassFinalizer(void* p)
 template<typename T, typename... ArgsT>
 inline T* RenderGraph::Allocate(ArgsT&&... arguments)
 {
-    T* p = (T*) m_allocator.Alloc(sizeof(T));
+    T* p = (T*) m_allocator.Alloc(sizeof(T), alignof(T));
     new(p) T(eastl::forward<ArgsT>(arguments)...);
 
     ObjFinalizer finalizer;
@@ -134,7 +135,7 @@ inline T* RenderGraph::Allocate(ArgsT&&... arguments)
 template<typename T, typename... ArgsT>
 inline T* RenderGraph::AllocatePOD(ArgsT&&... arguments)
 {
-    T* p = (T*) m_allocator.Alloc(sizeof(T));
+    T* p = (T*) m_allocator.Alloc(sizeof(T), alignof(T));
     new (p) T(eastl::forward<ArgsT>(arguments)...);
 
     return p;
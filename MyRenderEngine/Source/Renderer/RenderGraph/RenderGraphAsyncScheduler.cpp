@@ -0,0 +1,164 @@
+#include "RenderGraphAsyncScheduler.h"
+#include "Utils/assert.h"
+#include "EASTL/algorithm.h"
+
+void RenderGraphAsyncScheduler::Schedule(const eastl::vector<RenderGraphAsyncNode>& nodes, RenderGraphAsyncSchedule& schedule)
+{
+    uint32_t nodeCount = (uint32_t) nodes.size();
+
+    schedule = RenderGraphAsyncSchedule();
+    schedule.m_async.resize(nodeCount, false);
+
+    eastl::vector<eastl::vector<uint32_t>> consumers(nodeCount);
+    for (uint32_t i = 0; i < nodeCount; ++i)
+    {
+        for (size_t j = 0; j < nodes[i].m_dependencies.size(); ++j)
+        {
+            uint32_t dependency = nodes[i].m_dependencies[j];
+            MY_ASSERT(dependency < i);
+            consumers[dependency].push_back(i);
+        }
+    }
+
+    // Graphics queue time which can still hide compute work, used up by the runs placed before
+    eastl::vector<float> hideableUs(nodeCount);
+    for (uint32_t i = 0; i < nodeCount; ++i)
+    {
+        hideableUs[i] = nodes[i].m_costUs;
+    }
+
+    uint32_t runFirst = UINT32_MAX;
+    uint32_t runLast = UINT32_MAX;
+    RunEstimate run = {};
+
+    auto closeRun = [&]()
+    {
+        if (runFirst == UINT32_MAX)
+        {
+            return;
+        }
+
+        float remainingUs = run.m_overlapUs;
+        for (uint32_t i = runLast + 1; i < run.m_signalNode && remainingUs > 0.0f; ++i)
+        {
+            float hiddenUs = eastl::min(hideableUs[i], remainingUs);
+            hideableUs[i] -= hiddenUs;
+            remainingUs -= hiddenUs;
+        }
+
+        for (uint32_t i = runFirst; i <= runLast; ++i)
+        {
+            hideableUs[i] = 0.0f;
+        }
+
+        schedule.m_asyncPassCount += runLast - runFirst + 1;
+        schedule.m_fenceCount += run.m_fenceCount;
+        schedule.m_computeQueueUs += run.m_computeUs;
+        schedule.m_expectedOverlapUs += run.m_overlapUs;
+
+        runFirst = runLast = UINT32_MAX;
+    };
+
+    for (uint32_t i = 0; i < nodeCount; ++i)
+    {
+        const RenderGraphAsyncNode& node = nodes[i];
+        if (!IsMovable(node))
+        {
+            closeRun();
+            continue;
+        }
+
+        bool bForced = node.m_override == RenderGraphAsyncOverride::Async;
+
+        // Joining the run ahead shares its fences, but may move its signal earlier
+        if (runFirst != UINT32_MAX)
+        {
+            RunEstimate joined = EstimateRun(nodes, consumers, hideableUs, runFirst, i);
+            if (bForced || joined.GetBenefit() > run.GetBenefit())
+            {
+                schedule.m_async[i] = true;
+                runLast = i;
+                run = joined;
+            }
+            else
+            {
+                closeRun();
+            }
+            continue;
+        }
+
+        // A new run takes the best span of the movable nodes ahead, so a producer moves along with its compute consumers
+        uint32_t bestLast = i;
+        RunEstimate best = EstimateRun(nodes, consumers, hideableUs, i, i);
+        for (uint32_t last = i + 1; last < nodeCount && IsMovable(nodes[last]); ++last)
+        {
+            RunEstimate estimate = EstimateRun(nodes, consumers, hideableUs, i, last);
+            if (estimate.GetBenefit() > best.GetBenefit())
+            {
+                bestLast = last;
+                best = estimate;
+            }
+        }
+
+        if (bForced || best.GetBenefit() > 0.0f)
+        {
+            for (uint32_t j = i; j <= bestLast; ++j)
+            {
+                schedule.m_async[j] = true;
+            }
+            runFirst = i;
+            runLast = bestLast;
+            run = best;
+            i = bestLast;
+        }
+    }
+    closeRun();
+
+    for (uint32_t i = 0; i < nodeCount; ++i)
+    {
+        if (!schedule.m_async[i])
+        {
+            schedule.m_graphicsQueueUs += nodes[i].m_costUs;
+        }
+    }
+}
+
+RenderGraphAsyncScheduler::RunEstimate RenderGraphAsyncScheduler::EstimateRun(const eastl::vector<RenderGraphAsyncNode>& nodes, const eastl::vector<eastl::vector<uint32_t>>& consumers,
+    const eastl::vector<float>& hideableUs, uint32_t first, uint32_t last)
+{
+    uint32_t nodeCount = (uint32_t) nodes.size();
+
+    RunEstimate estimate = {};
+    estimate.m_signalNode = nodeCount;
+
+    bool bWait = false;
+    for (uint32_t i = first; i <= last; ++i)
+    {
+        estimate.m_computeUs += nodes[i].m_costUs;
+
+        for (size_t j = 0; j < nodes[i].m_dependencies.size(); ++j)
+        {
+            bWait |= nodes[i].m_dependencies[j] < first;
+        }
+
+        for (size_t j = 0; j < consumers[i].size(); ++j)
+        {
+            if (consumers[i][j] > last)
+            {
+                estimate.m_signalNode = eastl::min(estimate.m_signalNode, consumers[i][j]);
+            }
+        }
+    }
+
+    estimate.m_fenceCount = (bWait ? 1 : 0) + (estimate.m_signalNode < nodeCount ? 1 : 0);
+
+    // Only the graphics passes between the run and its first consumer run alongside it
+    float windowUs = 0.0f;
+    for (uint32_t i = last + 1; i < estimate.m_signalNode; ++i)
+    {
+        windowUs += hideableUs[i];
+    }
+    estimate.m_overlapUs = eastl::min(estimate.m_computeUs, windowUs);
+
+    return estimate;
+}
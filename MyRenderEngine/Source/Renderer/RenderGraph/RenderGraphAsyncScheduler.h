@@ -0,0 +1,55 @@
+#pragma once
+#include "EASTL/vector.h"
+#include <stdint.h>
+
+#define RG_ASYNC_FENCE_COST_US 20.0f        //< Submit, signal and wait of one cross queue fence
+
+enum class RenderGraphAsyncOverride
+{
+    Auto,           //< Compute passes are moved when the overlap pays for the fences
+    Graphics,       //< Always on the graphics queue
+    Async,          //< Always on the compute queue
+};
+
+struct RenderGraphAsyncNode
+{
+    float m_costUs = 0.0f;                      //< Estimated GPU time, 0 when unknown
+    bool m_bComputeOnly = false;                //< Only compute passes can move to the compute queue
+    RenderGraphAsyncOverride m_override = RenderGraphAsyncOverride::Auto;
+    eastl::vector<uint32_t> m_dependencies;     //< Earlier nodes which must be complete before this one
+};
+
+struct RenderGraphAsyncSchedule
+{
+    eastl::vector<bool> m_async;                //< One per node
+    uint32_t m_asyncPassCount = 0;
+    uint32_t m_fenceCount = 0;
+    float m_graphicsQueueUs = 0.0f;
+    float m_computeQueueUs = 0.0f;
+    float m_expectedOverlapUs = 0.0f;           //< Compute queue time hidden behind graphics work
+};
+
+// Decides which compute passes run on the compute queue. Nodes are in execution order, consecutive async nodes
+// form one run which waits for the graphics queue once and signals it once before its first graphics consumer,
+// as RenderGraphPassBase::ResolveAsyncCompute places the fences. A run only grows while the graphics work
+// between it and its consumers hides more than the fences cost. Works on plain data, so it runs without a GPU
+class RenderGraphAsyncScheduler
+{
+public:
+    static void Schedule(const eastl::vector<RenderGraphAsyncNode>& nodes, RenderGraphAsyncSchedule& schedule);
+
+private:
+    struct RunEstimate
+    {
+        uint32_t m_signalNode;      //< First graphics consumer, node count when there is none
+        uint32_t m_fenceCount;
+        float m_computeUs;
+        float m_overlapUs;
+
+        float GetBenefit() const { return m_overlapUs - m_fenceCount * RG_ASYNC_FENCE_COST_US; }
+    };
+
+    static bool IsMovable(const RenderGraphAsyncNode& node) { return node.m_bComputeOnly && node.m_override != RenderGraphAsyncOverride::Graphics; }
+    static RunEstimate EstimateRun(const eastl::vector<RenderGraphAsyncNode>& nodes, const eastl::vector<eastl::vector<uint32_t>>& consumers,
+        const eastl::vector<float>& hideableUs, uint32_t first, uint32_t last);
+};
@@ -20,6 +20,9 @@ public:
     }
 
     void SkipCulling() { m_pPass->MakeTarget(); }
+
+    // The async compute scheduler may move this compute pass to the compute queue, the graph has to know all of its resources
+    void AllowAsyncCompute() { m_pPass->SetAsyncComputeAllowed(true); }
     
     template<typename Resource>
     RGHandle Create(const typename Resource::Desc& desc, const eastl::string& name)
@@ -9,9 +9,24 @@ RenderGraphPassBase::RenderGraphPassBase(const eastl::string& name, RenderPassTy
     m_type = type;
 }
 
+void RenderGraphPassBase::SetAsyncCompute(bool value)
+{
+    MY_ASSERT(m_type == RenderPassType::Compute || m_type == RenderPassType::AsyncCompute);
+    m_type = value ? RenderPassType::AsyncCompute : RenderPassType::Compute;
+}
+
+// ClearUAV shares the layout of the UAV states, compute passes write with both of them
+static bool IsUAVState(RHIAccessFlags state)
+{
+    return (state & RHIAccessBit::RHIAccessMaskUAV) != 0 && (state & ~(RHIAccessBit::RHIAccessMaskUAV | RHIAccessBit::RHIAccessClearUAV)) == 0;
+}
+
 // todo : https://docs.microsoft.com/en-us/windows/win32/direct3d12/executing-and-synchronizing-command-lists#accessing-resources-from-multiple-command-queues
-void RenderGraphPassBase::ResolveBarriers(const DirectedAcyclicGraph& graph)
+void RenderGraphPassBase::ResolveBarriers(const DirectedAcyclicGraph& graph, uint32_t executeIndex, uint32_t submitSegment)
 {
+    m_executeIndex = executeIndex;
+    m_submitSegment = submitSegment;
+
     // Async pass, the resource transition will be happend in transition point
     if (m_type == RenderPassType::AsyncCompute)
     {
@@ -45,11 +60,11 @@ void RenderGraphPassBase::ResolveBarriers(const DirectedAcyclicGraph& graph)
 
         RHIAccessFlags oldState = RHIAccessBit::RHIAccessPresent;
         RHIAccessFlags newState = pEdge->GetUsage();
+        DAGNodeID lastPassID = UINT32_MAX;      //< The last pass which accessed the subresource
 
         RenderPassTypeFlags renderPassType = (RenderPassTypeFlags) m_type;
 
-        // Try to find previous state from last pass which used this resource
-        // todo : should merge states if possible, eg. shader resource ps + reosurce resource non-ps -> shader resource all
+        // Try to find previous state from last pass which used this resource, read states are merged in RenderGraph::Compile already
         if (resourceOutgoing.size() > 1)
         {
             // resource outgoing should be sorted
@@ -64,6 +79,7 @@ void RenderGraphPassBase::ResolveBarriers(const DirectedAcyclicGraph& graph)
                     if (passID < this->GetID())
                     {
                         oldState = ((RenderGraphEdge*) resourceOutgoing[i])->GetUsage();
+                        lastPassID = passID;
                         break;
                     }
                 }
@@ -87,6 +103,7 @@ void RenderGraphPassBase::ResolveBarriers(const DirectedAcyclicGraph& graph)
             else
             {
                 oldState = ((RenderGraphEdge*) resourceIncoming[0])->GetUsage();
+                lastPassID = resourceIncoming[0]->GetFromNode();
             }
         }
         
@@ -103,21 +120,35 @@ void RenderGraphPassBase::ResolveBarriers(const DirectedAcyclicGraph& graph)
             }
         }
 
-        if (oldState != newState || isAliased)
+        RenderGraphBarrier barrier;
+        barrier.m_pResource = pResource;
+        barrier.m_subResource = pEdge->GetSubResource();
+        barrier.m_oldState = oldState;
+        barrier.m_newState = newState;
+
+        if (isAliased)
         {
-            // todo: if UAV to uav, can use simpe uav barrier for all uavs
-            ResourceBarrier barrier;
-            barrier.m_pResource = pResource;
-            barrier.m_subResource = pEdge->GetSubResource();
-            barrier.m_oldState = oldState;
-            barrier.m_newState = newState;
-
-            if (isAliased)
+            barrier.m_oldState |= aliasState | RHIAccessDiscard;
+            m_barrierPlan.m_transitions.push_back(barrier);
+        }
+        else if (IsUAVState(oldState) && IsUAVState(newState) && (oldState != newState || lastPassID != UINT32_MAX))
+        {
+            m_barrierPlan.m_uavAccessBefore |= oldState;
+            m_barrierPlan.m_uavAccessAfter |= newState;
+            ++m_barrierPlan.m_uavDependencyCount;
+        }
+        else if (oldState != newState)
+        {
+            RenderGraphPassBase* pSplitPass = GetSplitBarrierPass(graph, resourceOutgoing, lastPassID);
+            if (pSplitPass)
             {
-                barrier.m_oldState |= aliasState | RHIAccessDiscard;
+                pSplitPass->m_barrierPlan.m_splitBeginBarriers.push_back(barrier);
+                m_barrierPlan.m_splitEndBarriers.push_back(barrier);
+            }
+            else
+            {
+                m_barrierPlan.m_transitions.push_back(barrier);
             }
-
-            m_resourceBarriers.push_back(barrier);
         }
     }
 
@@ -214,7 +245,7 @@ void RenderGraphPassBase::ResolveAsyncCompute(const DirectedAcyclicGraph& graph,
                 if (oldState != newState)
                 {
                     // todo: if UAV to uav, can use simpe uav barrier for all uavs
-                    ResourceBarrier barrier;
+                    RenderGraphBarrier barrier;
                     barrier.m_pResource = pResource;
                     barrier.m_subResource = pEdge->GetSubResource();
                     barrier.m_oldState = oldState;
@@ -307,7 +338,7 @@ void RenderGraphPassBase::Execute(const RenderGraph& graph, RenderGraphPassExecu
     {
         for (size_t i = 0; i < m_asyncTrasitionContext.m_asyncTrasitionBarriers.size(); ++i)
         {
-            const ResourceBarrier& barrier = m_asyncTrasitionContext.m_asyncTrasitionBarriers[i];
+            const RenderGraphBarrier& barrier = m_asyncTrasitionContext.m_asyncTrasitionBarriers[i];
             barrier.m_pResource->Barrier(pCommandList, barrier.m_subResource, barrier.m_oldState, barrier.m_newState);
         }
 
@@ -357,9 +388,17 @@ void RenderGraphPassBase::Execute(const RenderGraph& graph, RenderGraphPassExecu
     {
         GPU_EVENT(pCommandList, m_name);
 
+        // Every pass is timed on its own queue, for the frame trace
+        FrameTrace* pFrameTrace = context.m_pRenderer->GetFrameTrace();
+        uint32_t cpuEvent = pFrameTrace->BeginCPUEvent(m_name);
+        uint32_t gpuEvent = pFrameTrace->BeginGPUEvent(pCommandList, m_name);
+
         Begin(graph, pCommandList);
         ExecuteImpl(pCommandList);
         End(pCommandList);      
+
+        pFrameTrace->EndGPUEvent(pCommandList, gpuEvent);
+        pFrameTrace->EndCPUEvent(cpuEvent);
     }
 
     for (uint32_t i = 0; i < m_endEventNum; ++i)
@@ -404,12 +443,23 @@ void RenderGraphPassBase::Begin(const RenderGraph& graph, IRHICommandList* pComm
         }
     }
 
-    for (size_t i = 0; i < m_resourceBarriers.size(); ++i)
+    for (size_t i = 0; i < m_barrierPlan.m_splitEndBarriers.size(); ++i)
+    {
+        const RenderGraphBarrier& barrier = m_barrierPlan.m_splitEndBarriers[i];
+        barrier.m_pResource->Barrier(pCommandList, barrier.m_subResource, barrier.m_oldState, barrier.m_newState, RHIBarrierSplit::End);
+    }
+
+    for (size_t i = 0; i < m_barrierPlan.m_transitions.size(); ++i)
     {
-        const ResourceBarrier& barrier = m_resourceBarriers[i];
+        const RenderGraphBarrier& barrier = m_barrierPlan.m_transitions[i];
         barrier.m_pResource->Barrier(pCommandList, barrier.m_subResource, barrier.m_oldState, barrier.m_newState);
     }
 
+    if (m_barrierPlan.m_uavDependencyCount > 0)
+    {
+        pCommandList->GlobalBarrier(m_barrierPlan.m_uavAccessBefore, m_barrierPlan.m_uavAccessAfter);
+    }
+
     if (HasRHIRenderPass())
     {
         RHIRenderPassDesc desc;
@@ -462,6 +512,12 @@ void RenderGraphPassBase::End(IRHICommandList* pCommandList)
     {
         pCommandList->EndRenderPass();
     }
+
+    for (size_t i = 0; i < m_barrierPlan.m_splitBeginBarriers.size(); ++i)
+    {
+        const RenderGraphBarrier& barrier = m_barrierPlan.m_splitBeginBarriers[i];
+        barrier.m_pResource->Barrier(pCommandList, barrier.m_subResource, barrier.m_oldState, barrier.m_newState, RHIBarrierSplit::Begin);
+    }
 }
 
 bool RenderGraphPassBase::HasRHIRenderPass() const
@@ -475,4 +531,31 @@ bool RenderGraphPassBase::HasRHIRenderPass() const
     }
 
     return m_pDepthRT != nullptr;
+}
+
+RenderGraphPassBase* RenderGraphPassBase::GetSplitBarrierPass(const DirectedAcyclicGraph& graph, const eastl::vector<DAGEdge*>& resourceOutgoing, DAGNodeID lastPassID) const
+{
+    if (lastPassID == UINT32_MAX)
+    {
+        return nullptr;
+    }
+
+    // Both halves must be in one command list, and at least one pass between them hides the transition
+    RenderGraphPassBase* pLastPass = (RenderGraphPassBase*) graph.GetNode(lastPassID);
+    if (pLastPass->GetType() == RenderPassType::AsyncCompute || pLastPass->m_submitSegment != m_submitSegment || m_executeIndex - pLastPass->m_executeIndex < 2)
+    {
+        return nullptr;
+    }
+
+    // The other subresources must not be accessed in between
+    for (size_t i = 0; i < resourceOutgoing.size(); ++i)
+    {
+        DAGNodeID passID = resourceOutgoing[i]->GetToNode();
+        if (passID > lastPassID && passID < GetID() && !graph.GetNode(passID)->IsCulled())
+        {
+            return nullptr;
+        }
+    }
+
+    return pLastPass;
 }
\ No newline at end of file
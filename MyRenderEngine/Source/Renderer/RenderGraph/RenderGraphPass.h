@@ -1,6 +1,7 @@
 #pragma once
 
 #include "DirectedAcyclicGraph.h"
+#include "RenderGraphAsyncScheduler.h"
 #include "RHI/RHI.h"
 #include "EASTL/functional.h"
 
@@ -43,12 +44,36 @@ struct RenderGraphPassExecuteContext
     uint64_t m_lastSignaledGraphicsValue;
 };
 
+struct RenderGraphBarrier
+{
+    RenderGraphResource* m_pResource;
+    uint32_t m_subResource;
+    RHIAccessFlags m_oldState;
+    RHIAccessFlags m_newState;
+};
+
+// Barriers of a pass resolved at compile time. Plain data, so the plan of a graph can be checked without a GPU
+struct RenderGraphBarrierPlan
+{
+    eastl::vector<RenderGraphBarrier> m_transitions;            //< Before the pass
+    eastl::vector<RenderGraphBarrier> m_splitEndBarriers;       //< Before the pass, begun after an earlier pass
+    eastl::vector<RenderGraphBarrier> m_splitBeginBarriers;     //< After the pass, ended before a later pass
+
+    // UAV to UAV dependencies keep their layout, they are collapsed into one global barrier before the pass
+    RHIAccessFlags m_uavAccessBefore = 0;
+    RHIAccessFlags m_uavAccessAfter = 0;
+    uint32_t m_uavDependencyCount = 0;
+
+    uint32_t m_mergedReadCount = 0;                             //< Transitions saved by merging the read states of consecutive readers
+};
+
 class RenderGraphPassBase : public DAGNode
 {
 public:
     RenderGraphPassBase(const eastl::string& name, RenderPassType type, DirectedAcyclicGraph& graph);
     
-    void ResolveBarriers(const DirectedAcyclicGraph& graph);
+    // executeIndex counts the non culled passes, submitSegment the command list submissions before this pass
+    void ResolveBarriers(const DirectedAcyclicGraph& graph, uint32_t executeIndex, uint32_t submitSegment);
     void ResolveAsyncCompute(const DirectedAcyclicGraph& graph, RenderGraphAsyncResolveContext& context);
     void Execute(const RenderGraph& graph, RenderGraphPassExecuteContext& context);
 
@@ -58,15 +83,37 @@ public:
     void BeginEvent(const eastl::string& name) { return m_eventNames.push_back(name); }
     void EndEvent() { ++ m_endEventNum; }
     
+    const eastl::string& GetName() const { return m_name; }
     RenderPassType GetType() const { return m_type; }
     DAGNodeID GetWaitGraphicsPassID() const { return m_waitGraphicsPass; }
     DAGNodeID GetSignalGraphicsPassID() const { return m_signalGraphicsPass; }
 
+    // Execute submits the command list before a pass which waits, and after a pass which signals
+    bool IsSubmittedBefore() const { return m_waitValue != -1 || m_asyncTrasitionContext.m_bIsAsyncTrasitionPoint; }
+    bool IsSubmittedAfter() const { return m_signalValue != -1; }
+
+    // Manual override of the async compute scheduler, and the cost of passes which were never timed
+    void SetAsyncComputeOverride(RenderGraphAsyncOverride value) { m_asyncOverride = value; }
+    RenderGraphAsyncOverride GetAsyncComputeOverride() const { return m_asyncOverride; }
+    void SetCostHint(float costUs) { m_costHintUs = costUs; }
+
+    // Only compute passes which declare every resource they touch to the graph may be moved to the compute queue
+    void SetAsyncComputeAllowed(bool value) { m_bAsyncComputeAllowed = value; }
+    bool IsAsyncComputeAllowed() const { return m_bAsyncComputeAllowed; }
+    float GetCostHint() const { return m_costHintUs; }
+
+    // Moves a compute pass between the graphics and the compute queue, before ResolveAsyncCompute
+    void SetAsyncCompute(bool value);
+
+    const RenderGraphBarrierPlan& GetBarrierPlan() const { return m_barrierPlan; }
+    RenderGraphBarrierPlan& GetBarrierPlan() { return m_barrierPlan; }
+
 private:
     void Begin(const RenderGraph& graph, IRHICommandList* pCommandList);
     void End(IRHICommandList* pCommandList);
     
     bool HasRHIRenderPass() const;
+    RenderGraphPassBase* GetSplitBarrierPass(const DirectedAcyclicGraph& graph, const eastl::vector<DAGEdge*>& resourceOutgoing, DAGNodeID lastPassID) const;
     
     virtual void ExecuteImpl(IRHICommandList* pCommandList) = 0;
 
@@ -77,14 +124,13 @@ protected:
     eastl::vector<eastl::string> m_eventNames;
     uint32_t m_endEventNum = 0;
 
-    struct ResourceBarrier
-    {
-        RenderGraphResource* m_pResource;
-        uint32_t m_subResource;
-        RHIAccessFlags m_oldState;
-        RHIAccessFlags m_newState;
-    };
-    eastl::vector<ResourceBarrier> m_resourceBarriers;
+    RenderGraphAsyncOverride m_asyncOverride = RenderGraphAsyncOverride::Auto;
+    float m_costHintUs = 0.0f;
+    bool m_bAsyncComputeAllowed = false;
+
+    RenderGraphBarrierPlan m_barrierPlan;
+    uint32_t m_executeIndex = 0;
+    uint32_t m_submitSegment = 0;
 
     struct AliasDiscardBarrier
     {
@@ -100,7 +146,7 @@ protected:
         uint64_t m_signalValue = UINT32_MAX;
         uint64_t m_waitValue = UINT32_MAX;
         DAGNodeID m_passToWait = UINT32_MAX;
-        eastl::vector<ResourceBarrier> m_asyncTrasitionBarriers;
+        eastl::vector<RenderGraphBarrier> m_asyncTrasitionBarriers;
         
     };
     AsyncTrasitionContext m_asyncTrasitionContext;                  //< Will do a resource trasition before this pass
@@ -119,9 +119,9 @@ void RGTexture::Realize()
     }
 }
 
-void RGTexture::Barrier(IRHICommandList* pCommandList, uint32_t subresource, RHIAccessFlags accessBefore, RHIAccessFlags accessAfter)
+void RGTexture::Barrier(IRHICommandList* pCommandList, uint32_t subresource, RHIAccessFlags accessBefore, RHIAccessFlags accessAfter, RHIBarrierSplit split)
 {
-    pCommandList->TextureBarrier(m_pTexture, subresource, accessBefore, accessAfter);
+    pCommandList->TextureBarrier(m_pTexture, subresource, accessBefore, accessAfter, split);
 }
 
 IRHIResource* RGTexture::GetAliasedPrevResource(RHIAccessFlags& lastUsedState)
@@ -226,9 +226,9 @@ void RGBuffer::Realize()
     }
 }
 
-void RGBuffer::Barrier(IRHICommandList* pCommandList, uint32_t subresource, RHIAccessFlags accessBefore, RHIAccessFlags accessAfter)
+void RGBuffer::Barrier(IRHICommandList* pCommandList, uint32_t subresource, RHIAccessFlags accessBefore, RHIAccessFlags accessAfter, RHIBarrierSplit split)
 {
-    pCommandList->BufferBarrier(m_pBuffer, accessBefore, accessAfter);
+    pCommandList->BufferBarrier(m_pBuffer, accessBefore, accessAfter, split);
 }
 
 IRHIResource* RGBuffer::GetAliasedPrevResource(RHIAccessFlags& lastUsedState)
@@ -38,7 +38,8 @@ public:
     bool IsOverlapping() const { return !IsOutput() && !IsImported(); }
 
     virtual IRHIResource* GetAliasedPrevResource(RHIAccessFlags& lastUsedState) = 0;
-    virtual void Barrier(IRHICommandList* pCommandList, uint32_t subResource, RHIAccessFlags accessBefore, RHIAccessFlags accessAfter) = 0;
+    virtual void Barrier(IRHICommandList* pCommandList, uint32_t subResource, RHIAccessFlags accessBefore, RHIAccessFlags accessAfter, RHIBarrierSplit split = RHIBarrierSplit::None) = 0;
+    virtual RHIAccessFlags GetMergeableReadStates() const = 0;     //< Read states which can be combined in one state, so consecutive readers share one transition
 
 protected:
     eastl::string m_name;
@@ -67,7 +68,8 @@ public:
     virtual void Realize() override;
     virtual IRHIResource* GetResource() override { return m_pTexture; }
     virtual RHIAccessFlags GetInitialState() override { return m_initialState; }
-    virtual void Barrier(IRHICommandList* pCommandList, uint32_t subresource, RHIAccessFlags accessBefore, RHIAccessFlags accessAfter) override;
+    virtual void Barrier(IRHICommandList* pCommandList, uint32_t subresource, RHIAccessFlags accessBefore, RHIAccessFlags accessAfter, RHIBarrierSplit split = RHIBarrierSplit::None) override;
+    virtual RHIAccessFlags GetMergeableReadStates() const override { return RHIAccessBit::RHIAccessMaskSRV; }    //< Must share one layout
     virtual IRHIResource* GetAliasedPrevResource(RHIAccessFlags& lastUsedState) override;
 
 private:
@@ -94,7 +96,11 @@ public:
     virtual void Realize() override;
     virtual IRHIResource* GetResource() override { return m_pBuffer; }
     virtual RHIAccessFlags GetInitialState() override { return m_initialState; }
-    virtual void Barrier(IRHICommandList* pCommandList, uint32_t subresource, RHIAccessFlags accessBefore, RHIAccessFlags accessAfter) override;
+    virtual void Barrier(IRHICommandList* pCommandList, uint32_t subresource, RHIAccessFlags accessBefore, RHIAccessFlags accessAfter, RHIBarrierSplit split = RHIBarrierSplit::None) override;
+    virtual RHIAccessFlags GetMergeableReadStates() const override
+    {
+        return RHIAccessBit::RHIAccessMaskSRV | RHIAccessBit::RHIAccessCopySrc | RHIAccessBit::RHIAccessIndexBuffer | RHIAccessBit::RHIAccessIndirectArgs;
+    }
     virtual IRHIResource* GetAliasedPrevResource(RHIAccessFlags& lastUsedState) override;
     
 private:
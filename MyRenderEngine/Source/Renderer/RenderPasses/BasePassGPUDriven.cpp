@@ -3,10 +3,14 @@
 #include <fmt/core.h>
 
 #include "Renderer/Renderer.h"
+#include "Renderer/MaterialTable.h"
 #include "HierarchicalDepthBufferPass.h"
+#include "VisibilityBuffer.hlsli"
 #include "Utils/profiler.h"
 #include "EASTL/map.h"
 
+static_assert(VISIBILITY_BUFFER_BIN_COUNT == MATERIAL_TABLE_MAX_COUNT, "Visibility buffer pixels are binned by material table entry");
+
 struct FirstPhaseInstanceCullingData
 {
     RGHandle m_objectListBuffer;
@@ -36,6 +40,10 @@ struct BasePassData
     RGHandle m_outEmissiveRT;   //< r11g11b10 : emissive
     RGHandle m_outCustomRT;     //< rgba8norm : custom data
     RGHandle m_outDepthRT;  
+
+    RGHandle m_outVisibilityBufferRT;           //< rg32ui : visibility ID + depth, instead of the G-buffer targets
+    RGHandle m_visibleMeshletListBuffer;        //< Only used by the visibility buffer
+    RGHandle m_visibleMeshletCounterBuffer;
 };
 
 static inline uint32_t roundup(uint32_t a, uint32_t b)
@@ -62,21 +70,52 @@ BasePassGPUDriven::BasePassGPUDriven(Renderer* pRenderer)
 
     desc.m_pCS = pRenderer->GetShader("InstanceCulling.hlsl", "BuildIndirectCommand", RHIShaderType::CS);
     m_pBuildIndirectCommandPSO = pRenderer->GetPipelineState(desc, "Build indirect command PSO");
+
+    desc.m_pCS = pRenderer->GetShader("VisibilityBufferResolve.hlsl", "cs_classify", RHIShaderType::CS);
+    m_pVisibilityBufferClassifyPSO = pRenderer->GetPipelineState(desc, "Visibility buffer classify PSO");
+
+    desc.m_pCS = pRenderer->GetShader("VisibilityBufferResolve.hlsl", "cs_build_bins", RHIShaderType::CS);
+    m_pVisibilityBufferBuildBinsPSO = pRenderer->GetPipelineState(desc, "Visibility buffer build bins PSO");
+
+    desc.m_pCS = pRenderer->GetShader("VisibilityBufferResolve.hlsl", "cs_scatter", RHIShaderType::CS);
+    m_pVisibilityBufferScatterPSO = pRenderer->GetPipelineState(desc, "Visibility buffer scatter PSO");
+
+    desc.m_pCS = pRenderer->GetShader("VisibilityBufferResolve.hlsl", "cs_resolve", RHIShaderType::CS, {"UBER_MATERIAL=1", "VISIBILITY_BUFFER_RESOLVE=1"});
+    m_pVisibilityBufferResolvePSO = pRenderer->GetPipelineState(desc, "Visibility buffer resolve PSO");
+
+    desc.m_pCS = pRenderer->GetShader("SoftwareRaster.hlsl", "cs_raster", RHIShaderType::CS);
+    m_pSoftwareRasterPSO = pRenderer->GetPipelineState(desc, "Software raster PSO");
+
+    desc.m_pCS = pRenderer->GetShader("SoftwareRaster.hlsl", "cs_build_command", RHIShaderType::CS);
+    m_pSoftwareRasterBuildCommandPSO = pRenderer->GetPipelineState(desc, "Software raster build command PSO");
+
+    RHIGraphicsPipelineDesc graphicsDesc;
+    graphicsDesc.m_pVS = pRenderer->GetShader("Copy.hlsl", "vs_main", RHIShaderType::VS);
+    graphicsDesc.m_pPS = pRenderer->GetShader("SoftwareRaster.hlsl", "ps_depth_merge", RHIShaderType::PS);
+    graphicsDesc.m_depthStencilState.m_depthTest = true;
+    graphicsDesc.m_depthStencilState.m_depthFunc = RHICompareFunc::Always;
+    graphicsDesc.m_depthStencilFromat = RHIFormat::D32F;
+    m_pDepthMergePSO = pRenderer->GetPipelineState(graphicsDesc, "Depth merge PSO");
 }
 
 RenderBatch& BasePassGPUDriven::AddBatch()
 {
-    LinearAllocator* pAllocator = m_pRenderer->GetConstantAllocator();
-    return m_instances.emplace_back(*pAllocator);
+    return m_instances.Add(*m_pRenderer->GetBatchAllocator());
 }
 
 void BasePassGPUDriven::Render1stPhase(RenderGraph* pRenderGraph)
 {
     RENDER_GRAPH_EVENT(pRenderGraph, "Base Pass 1st phase");
 
+    m_bMeshletListReadback = m_meshletListReadbackCallback && !m_pMeshletListReadbackBuffer;
+
     // Merge is depending on the PSO
     MergeBatch();
 
+    // StaticMesh::Render picked the PSOs of this mode, the editor changes it before the world is ticked
+    m_bVisibilityBuffer = m_pRenderer->IsVisibilityBufferEnabled();
+    m_bSoftwareRaster = m_bVisibilityBuffer && m_pRenderer->IsSoftwareRasterEnabled();
+
     uint32_t maxDispatchNum = roundup((uint32_t) m_indirectBatches.size(), 65536 / sizeof(uint32_t));
     uint32_t maxInstanceNum = roundup(m_pRenderer->GetInstanceCount(), 65536 / sizeof(uint8_t));
     uint32_t maxMeshletsNum = roundup(m_totalMeshletCount, 65536/ sizeof(uint2));
@@ -88,6 +127,7 @@ void BasePassGPUDriven::Render1stPhase(RenderGraph* pRenderGraph)
         RGHandle m_firstPhaseMeshletListCounterBuffer;
         RGHandle m_secondPhaseObjectListCounterBuffer;
         RGHandle m_secondPhaseMeshletListCounterBuffer;
+        RGHandle m_visibleMeshletCounterBuffer;
     };
 
     auto clearCounterPass = pRenderGraph->AddPass<ClearCounterPassData>("Clear Counter", RenderPassType::Compute,
@@ -108,13 +148,21 @@ void BasePassGPUDriven::Render1stPhase(RenderGraph* pRenderGraph)
             
             data.m_secondPhaseMeshletListCounterBuffer = builder.Create<RGBuffer>(bufferDesc, "2nd phase meshlet list counter");
             data.m_secondPhaseMeshletListCounterBuffer = builder.Write(data.m_secondPhaseMeshletListCounterBuffer);
+
+            if (m_bVisibilityBuffer)
+            {
+                bufferDesc.m_size = bufferDesc.m_stride * 3;   //< Hardware meshlets, software meshlets of the 1st and the 2nd phase
+                data.m_visibleMeshletCounterBuffer = builder.Create<RGBuffer>(bufferDesc, "Visible meshlet counter");
+                data.m_visibleMeshletCounterBuffer = builder.Write(data.m_visibleMeshletCounterBuffer);
+            }
         },
         [=](const ClearCounterPassData& data, IRHICommandList* pCommandList)
         {
             ResetCounter(pCommandList,
                 pRenderGraph->GetBuffer(data.m_firstPhaseMeshletListCounterBuffer),
                 pRenderGraph->GetBuffer(data.m_secondPhaseObjectListCounterBuffer),
-                pRenderGraph->GetBuffer(data.m_secondPhaseMeshletListCounterBuffer));
+                pRenderGraph->GetBuffer(data.m_secondPhaseMeshletListCounterBuffer),
+                data.m_visibleMeshletCounterBuffer.IsValid() ? pRenderGraph->GetBuffer(data.m_visibleMeshletCounterBuffer) : nullptr);
         });
 
     struct InstanceCullingData
@@ -184,6 +232,11 @@ void BasePassGPUDriven::Render1stPhase(RenderGraph* pRenderGraph)
                 pRenderGraph->GetBuffer(data.m_meshletListCounterBuffer));
         });
 
+    if (m_bMeshletListReadback)
+    {
+        ReadbackMeshletList(pRenderGraph, instanceCullingPass->m_cullingResultBuffer, buildMeshletListPass->m_meshletListBuffer, buildMeshletListPass->m_meshletListCounterBuffer);
+    }
+
     struct BuildIndirectCommandPassData
     {
         RGHandle m_meshletListCounterBuffer;
@@ -209,31 +262,50 @@ void BasePassGPUDriven::Render1stPhase(RenderGraph* pRenderGraph)
                 pRenderGraph->GetBuffer(data.m_indirectCommandBuffer));
         });
 
-    auto gBufferPass = pRenderGraph->AddPass<BasePassData>("Base Pass", RenderPassType::Graphics,
+    auto gBufferPass = pRenderGraph->AddPass<BasePassData>(m_bVisibilityBuffer ? "Visibility Buffer 1st Phase" : "Base Pass", RenderPassType::Graphics,
         [&](BasePassData& data, RGBuilder& builder)
         {
             RGTexture::Desc desc;
             desc.m_width = m_pRenderer->GetRenderWidth();
             desc.m_height = m_pRenderer->GetRenderHeight();
-            desc.m_format = RHIFormat::RGBA8SRGB;
-            data.m_outDiffuseRT = builder.Create<RGTexture>(desc, "Diffuse RT");
-            data.m_outSpecularRT = builder.Create<RGTexture>(desc, "Specular RT");
+
+            if (m_bVisibilityBuffer)
+            {
+                // The G-buffer is created by the resolve
+                desc.m_format = RHIFormat::RG32UI;
+                data.m_outVisibilityBufferRT = builder.Create<RGTexture>(desc, "Visibility Buffer RT");
+                data.m_outVisibilityBufferRT = builder.WriteColor(0, data.m_outVisibilityBufferRT, 0, RHIRenderPassLoadOp::Clear, float4(0.0f));
+
+                RGBuffer::Desc bufferDesc;
+                bufferDesc.m_stride = sizeof(uint2);
+                bufferDesc.m_size = bufferDesc.m_stride * maxMeshletsNum;   //< The meshlets rendered by the two phases are disjoint
+                bufferDesc.m_usage = RHIBufferUsageBit::RHIBufferUsageStructedBuffer;
+                data.m_visibleMeshletListBuffer = builder.Create<RGBuffer>(bufferDesc, "Visible meshlet list");
+                data.m_visibleMeshletListBuffer = builder.Write(data.m_visibleMeshletListBuffer, 0, RGBuilderFlag::ShaderStageNonPS);
+                data.m_visibleMeshletCounterBuffer = builder.Write(clearCounterPass->m_visibleMeshletCounterBuffer, 0, RGBuilderFlag::ShaderStageNonPS);
+            }
+            else
+            {
+                desc.m_format = RHIFormat::RGBA8SRGB;
+                data.m_outDiffuseRT = builder.Create<RGTexture>(desc, "Diffuse RT");
+                data.m_outSpecularRT = builder.Create<RGTexture>(desc, "Specular RT");
             
-            desc.m_format = RHIFormat::RGBA8UNORM;
-            data.m_outNormalRT = builder.Create<RGTexture>(desc, "Normal RT");
-            data.m_outCustomRT = builder.Create<RGTexture>(desc, "CustomData RT");
+                desc.m_format = RHIFormat::RGBA8UNORM;
+                data.m_outNormalRT = builder.Create<RGTexture>(desc, "Normal RT");
+                data.m_outCustomRT = builder.Create<RGTexture>(desc, "CustomData RT");
             
-            desc.m_format = RHIFormat::R11G11B10F;
-            data.m_outEmissiveRT = builder.Create<RGTexture>(desc, "Emissive RT");
+                desc.m_format = RHIFormat::R11G11B10F;
+                data.m_outEmissiveRT = builder.Create<RGTexture>(desc, "Emissive RT");
+
+                data.m_outDiffuseRT = builder.WriteColor(0, data.m_outDiffuseRT, 0, RHIRenderPassLoadOp::Clear, float4(0.0f));
+                data.m_outSpecularRT = builder.WriteColor(1, data.m_outSpecularRT, 0, RHIRenderPassLoadOp::Clear, float4(0.0f));
+                data.m_outNormalRT = builder.WriteColor(2, data.m_outNormalRT, 0, RHIRenderPassLoadOp::Clear, float4(0.0f));
+                data.m_outEmissiveRT = builder.WriteColor(3, data.m_outEmissiveRT, 0, RHIRenderPassLoadOp::Clear, float4(0.0f));
+                data.m_outCustomRT = builder.WriteColor(4, data.m_outCustomRT, 0, RHIRenderPassLoadOp::Clear, float4(0.0));
+            }
 
             desc.m_format = RHIFormat::D32F;
             data.m_outDepthRT = builder.Create<RGTexture>(desc, "Scene Depth RT");
-
-            data.m_outDiffuseRT = builder.WriteColor(0, data.m_outDiffuseRT, 0, RHIRenderPassLoadOp::Clear, float4(0.0f));
-            data.m_outSpecularRT = builder.WriteColor(1, data.m_outSpecularRT, 0, RHIRenderPassLoadOp::Clear, float4(0.0f));
-            data.m_outNormalRT = builder.WriteColor(2, data.m_outNormalRT, 0, RHIRenderPassLoadOp::Clear, float4(0.0f));
-            data.m_outEmissiveRT = builder.WriteColor(3, data.m_outEmissiveRT, 0, RHIRenderPassLoadOp::Clear, float4(0.0f));
-            data.m_outCustomRT = builder.WriteColor(4, data.m_outCustomRT, 0, RHIRenderPassLoadOp::Clear, float4(0.0));
             data.m_outDepthRT = builder.WriteDepth(data.m_outDepthRT, 0, RHIRenderPassLoadOp::Clear, RHIRenderPassLoadOp::Clear);
 
             
@@ -259,7 +331,9 @@ void BasePassGPUDriven::Render1stPhase(RenderGraph* pRenderGraph)
             Flush1stPhaseBatches(pCommandList,
                 pRenderGraph->GetBuffer(data.m_indirectCommandBuffer),
                 pRenderGraph->GetBuffer(data.m_meshletListBuffer),
-                pRenderGraph->GetBuffer(data.m_meshletListCounterBuffer));
+                pRenderGraph->GetBuffer(data.m_meshletListCounterBuffer),
+                data.m_visibleMeshletListBuffer.IsValid() ? pRenderGraph->GetBuffer(data.m_visibleMeshletListBuffer) : nullptr,
+                data.m_visibleMeshletCounterBuffer.IsValid() ? pRenderGraph->GetBuffer(data.m_visibleMeshletCounterBuffer) : nullptr);
         });
 
     struct ShowCulledInstancePassData
@@ -309,6 +383,15 @@ void BasePassGPUDriven::Render1stPhase(RenderGraph* pRenderGraph)
     m_customDataRT = gBufferPass->m_outCustomRT;
     m_depthRT = gBufferPass->m_outDepthRT;
 
+    m_visibilityBufferRT = gBufferPass->m_outVisibilityBufferRT;
+    m_visibleMeshletListBuffer = gBufferPass->m_visibleMeshletListBuffer;
+    m_visibleMeshletCounterBuffer = gBufferPass->m_visibleMeshletCounterBuffer;
+
+    if (m_bSoftwareRaster)
+    {
+        SoftwareRaster(pRenderGraph, true);
+    }
+
     m_2ndPhaseObjectListBuffer = instanceCullingPass->m_secondPhaseObjectListBuffer;
     m_2ndPhaseObjectListCounterBuffer = instanceCullingPass->m_secondPhaseObjectListCounterBuffer;
 
@@ -444,14 +527,23 @@ void BasePassGPUDriven::Render2ndPhase(RenderGraph* pRenderGraph)
                 pRenderGraph->GetBuffer(data.m_indirectCommandBuffer));
         });
 
-    auto gBufferPass = pRenderGraph->AddPass<BasePassData>("GBuffer Pass", RenderPassType::Graphics,
+    auto gBufferPass = pRenderGraph->AddPass<BasePassData>(m_bVisibilityBuffer ? "Visibility Buffer 2nd Phase" : "GBuffer Pass", RenderPassType::Graphics,
         [&](BasePassData& data, RGBuilder& builder)
         {
-            data.m_outDiffuseRT = builder.WriteColor(0, m_diffuseRT, 0, RHIRenderPassLoadOp::Load);
-            data.m_outSpecularRT = builder.WriteColor(1, m_specularRT, 0, RHIRenderPassLoadOp::Load);
-            data.m_outNormalRT = builder.WriteColor(2, m_normalRT, 0,RHIRenderPassLoadOp::Load);
-            data.m_outEmissiveRT = builder.WriteColor(3, m_emissiveRT, 0, RHIRenderPassLoadOp::Load);
-            data.m_outCustomRT = builder.WriteColor(4, m_customDataRT, 0, RHIRenderPassLoadOp::Load);
+            if (m_bVisibilityBuffer)
+            {
+                data.m_outVisibilityBufferRT = builder.WriteColor(0, m_visibilityBufferRT, 0, RHIRenderPassLoadOp::Load);
+                data.m_visibleMeshletListBuffer = builder.Write(m_visibleMeshletListBuffer, 0, RGBuilderFlag::ShaderStageNonPS);
+                data.m_visibleMeshletCounterBuffer = builder.Write(m_visibleMeshletCounterBuffer, 0, RGBuilderFlag::ShaderStageNonPS);
+            }
+            else
+            {
+                data.m_outDiffuseRT = builder.WriteColor(0, m_diffuseRT, 0, RHIRenderPassLoadOp::Load);
+                data.m_outSpecularRT = builder.WriteColor(1, m_specularRT, 0, RHIRenderPassLoadOp::Load);
+                data.m_outNormalRT = builder.WriteColor(2, m_normalRT, 0,RHIRenderPassLoadOp::Load);
+                data.m_outEmissiveRT = builder.WriteColor(3, m_emissiveRT, 0, RHIRenderPassLoadOp::Load);
+                data.m_outCustomRT = builder.WriteColor(4, m_customDataRT, 0, RHIRenderPassLoadOp::Load);
+            }
             data.m_outDepthRT = builder.WriteDepth(m_depthRT, 0, RHIRenderPassLoadOp::Load, RHIRenderPassLoadOp::Load);
 
             for (uint32_t i = 0; i < pHZBPass->GetHZBMipCount(); ++ i)
@@ -468,25 +560,341 @@ void BasePassGPUDriven::Render2ndPhase(RenderGraph* pRenderGraph)
             Flush2ndPhaseBatches(pCommandList,
                 pRenderGraph->GetBuffer(data.m_indirectCommandBuffer),
                 pRenderGraph->GetBuffer(data.m_meshletListBuffer),
-                pRenderGraph->GetBuffer(data.m_meshletListCounterBuffer));
+                pRenderGraph->GetBuffer(data.m_meshletListCounterBuffer),
+                data.m_visibleMeshletListBuffer.IsValid() ? pRenderGraph->GetBuffer(data.m_visibleMeshletListBuffer) : nullptr,
+                data.m_visibleMeshletCounterBuffer.IsValid() ? pRenderGraph->GetBuffer(data.m_visibleMeshletCounterBuffer) : nullptr);
         });
 
-    m_diffuseRT = gBufferPass->m_outDiffuseRT;
-    m_specularRT = gBufferPass->m_outSpecularRT;
-    m_normalRT = gBufferPass->m_outNormalRT;
-    m_emissiveRT = gBufferPass->m_outEmissiveRT;
-    m_customDataRT = gBufferPass->m_outCustomRT;
     m_depthRT = gBufferPass->m_outDepthRT;
+
+    if (m_bVisibilityBuffer)
+    {
+        m_visibilityBufferRT = gBufferPass->m_outVisibilityBufferRT;
+        m_visibleMeshletListBuffer = gBufferPass->m_visibleMeshletListBuffer;
+        m_visibleMeshletCounterBuffer = gBufferPass->m_visibleMeshletCounterBuffer;
+
+        if (m_bSoftwareRaster)
+        {
+            SoftwareRaster(pRenderGraph, false);
+        }
+
+        ResolveVisibilityBuffer(pRenderGraph);
+    }
+    else
+    {
+        m_diffuseRT = gBufferPass->m_outDiffuseRT;
+        m_specularRT = gBufferPass->m_outSpecularRT;
+        m_normalRT = gBufferPass->m_outNormalRT;
+        m_emissiveRT = gBufferPass->m_outEmissiveRT;
+        m_customDataRT = gBufferPass->m_outCustomRT;
+    }
+}
+
+void BasePassGPUDriven::SoftwareRaster(RenderGraph* pRenderGraph, bool bFirstPhase)
+{
+    struct BuildCommandPassData
+    {
+        RGHandle m_visibleMeshletCounterBuffer;
+        RGHandle m_commandBuffer;
+    };
+
+    auto buildCommandPass = pRenderGraph->AddPass<BuildCommandPassData>("Build Software Raster Command", RenderPassType::Compute,
+        [&](BuildCommandPassData& data, RGBuilder& builder)
+        {
+            RGBuffer::Desc bufferDesc;
+            bufferDesc.m_stride = sizeof(uint3);
+            bufferDesc.m_size = bufferDesc.m_stride;
+            bufferDesc.m_usage = RHIBufferUsageBit::RHIBufferUsageStructedBuffer;
+            data.m_commandBuffer = builder.Create<RGBuffer>(bufferDesc, "Software raster command");
+            data.m_commandBuffer = builder.Write(data.m_commandBuffer);
+
+            data.m_visibleMeshletCounterBuffer = builder.Read(m_visibleMeshletCounterBuffer);
+        },
+        [=](const BuildCommandPassData& data, IRHICommandList* pCommandList)
+        {
+            pCommandList->SetPipelineState(m_pSoftwareRasterBuildCommandPSO);
+
+            uint32_t rootConstants[3] = {
+                pRenderGraph->GetBuffer(data.m_visibleMeshletCounterBuffer)->GetSRV()->GetHeapIndex(),
+                pRenderGraph->GetBuffer(data.m_commandBuffer)->GetUAV()->GetHeapIndex(),
+                bFirstPhase
+            };
+            pCommandList->SetComputeConstants(0, rootConstants, sizeof(rootConstants));
+            pCommandList->Dispatch(1, 1, 1);
+        });
+
+    struct SoftwareRasterPassData
+    {
+        RGHandle m_commandBuffer;
+        RGHandle m_visibleMeshletListBuffer;
+        RGHandle m_visibleMeshletCounterBuffer;
+        RGHandle m_outVisibilityBufferRT;
+    };
+
+    auto rasterPass = pRenderGraph->AddPass<SoftwareRasterPassData>(bFirstPhase ? "Software Raster 1st Phase" : "Software Raster 2nd Phase", RenderPassType::Compute,
+        [&](SoftwareRasterPassData& data, RGBuilder& builder)
+        {
+            data.m_commandBuffer = builder.ReadIndirectArg(buildCommandPass->m_commandBuffer);
+            data.m_visibleMeshletListBuffer = builder.Read(m_visibleMeshletListBuffer);
+            data.m_visibleMeshletCounterBuffer = builder.Read(m_visibleMeshletCounterBuffer);
+            data.m_outVisibilityBufferRT = builder.Write(m_visibilityBufferRT);
+        },
+        [=](const SoftwareRasterPassData& data, IRHICommandList* pCommandList)
+        {
+            pCommandList->SetPipelineState(m_pSoftwareRasterPSO);
+
+            uint32_t rootConstants[4] = {
+                pRenderGraph->GetBuffer(data.m_visibleMeshletListBuffer)->GetSRV()->GetHeapIndex(),
+                pRenderGraph->GetBuffer(data.m_visibleMeshletCounterBuffer)->GetSRV()->GetHeapIndex(),
+                pRenderGraph->GetTexture(data.m_outVisibilityBufferRT)->GetUAV()->GetHeapIndex(),
+                bFirstPhase
+            };
+            pCommandList->SetComputeConstants(0, rootConstants, sizeof(rootConstants));
+            pCommandList->DispatchIndirect(pRenderGraph->GetBuffer(data.m_commandBuffer)->GetBuffer(), 0);
+        });
+
+    struct DepthMergePassData
+    {
+        RGHandle m_visibilityBufferRT;
+        RGHandle m_outDepthRT;
+    };
+
+    auto depthMergePass = pRenderGraph->AddPass<DepthMergePassData>(bFirstPhase ? "Depth Merge 1st Phase" : "Depth Merge 2nd Phase", RenderPassType::Graphics,
+        [&](DepthMergePassData& data, RGBuilder& builder)
+        {
+            data.m_visibilityBufferRT = builder.Read(rasterPass->m_outVisibilityBufferRT);
+            data.m_outDepthRT = builder.WriteDepth(m_depthRT, 0, RHIRenderPassLoadOp::Load, RHIRenderPassLoadOp::Load);
+        },
+        [=](const DepthMergePassData& data, IRHICommandList* pCommandList)
+        {
+            uint32_t visibilityBufferSRV = pRenderGraph->GetTexture(data.m_visibilityBufferRT)->GetSRV()->GetHeapIndex();
+            pCommandList->SetGraphicsConstants(0, &visibilityBufferSRV, sizeof(visibilityBufferSRV));
+            pCommandList->SetPipelineState(m_pDepthMergePSO);
+            pCommandList->Draw(3);
+        });
+
+    m_visibilityBufferRT = depthMergePass->m_visibilityBufferRT;
+    m_depthRT = depthMergePass->m_outDepthRT;
+}
+
+void BasePassGPUDriven::ResolveVisibilityBuffer(RenderGraph* pRenderGraph)
+{
+    RENDER_GRAPH_EVENT(pRenderGraph, "Visibility Buffer Resolve");
+
+    uint32_t width = m_pRenderer->GetRenderWidth();
+    uint32_t height = m_pRenderer->GetRenderHeight();
+
+    struct ClassifyPassData
+    {
+        RGHandle m_visibilityBufferRT;
+        RGHandle m_visibleMeshletListBuffer;
+        RGHandle m_binCounterBuffer;
+    };
+
+    auto classifyPass = pRenderGraph->AddPass<ClassifyPassData>("Visibility Buffer Classify", RenderPassType::Compute,
+        [&](ClassifyPassData& data, RGBuilder& builder)
+        {
+            RGBuffer::Desc bufferDesc;
+            bufferDesc.m_stride = 4;
+            bufferDesc.m_size = bufferDesc.m_stride * VISIBILITY_BUFFER_BIN_COUNT;
+            bufferDesc.m_format = RHIFormat::R32UI;
+            bufferDesc.m_usage = RHIBufferUsageBit::RHIBufferUsageTypedBuffer;
+            data.m_binCounterBuffer = builder.Create<RGBuffer>(bufferDesc, "Visibility buffer bin counter");
+            data.m_binCounterBuffer = builder.Write(data.m_binCounterBuffer);
+
+            data.m_visibilityBufferRT = builder.Read(m_visibilityBufferRT);
+            data.m_visibleMeshletListBuffer = builder.Read(m_visibleMeshletListBuffer);
+        },
+        [=](const ClassifyPassData& data, IRHICommandList* pCommandList)
+        {
+            RGBuffer* pBinCounter = pRenderGraph->GetBuffer(data.m_binCounterBuffer);
+
+            uint32_t clearValue[4] = {0, 0, 0, 0};
+            pCommandList->ClearUAV(pBinCounter->GetBuffer(), pBinCounter->GetUAV(), clearValue);
+            pCommandList->BufferBarrier(pBinCounter->GetBuffer(), RHIAccessBit::RHIAccessClearUAV, RHIAccessBit::RHIAccessComputeShaderUAV);
+
+            pCommandList->SetPipelineState(m_pVisibilityBufferClassifyPSO);
+
+            uint32_t rootConstants[3] = {
+                pRenderGraph->GetTexture(data.m_visibilityBufferRT)->GetSRV()->GetHeapIndex(),
+                pRenderGraph->GetBuffer(data.m_visibleMeshletListBuffer)->GetSRV()->GetHeapIndex(),
+                pBinCounter->GetUAV()->GetHeapIndex()
+            };
+            pCommandList->SetComputeConstants(0, rootConstants, sizeof(rootConstants));
+            pCommandList->Dispatch(DivideRoundingUp(width, 8), DivideRoundingUp(height, 8), 1);
+        });
+
+    struct BuildBinsPassData
+    {
+        RGHandle m_binCounterBuffer;
+        RGHandle m_binCursorBuffer;
+        RGHandle m_indirectCommandBuffer;
+    };
+
+    auto buildBinsPass = pRenderGraph->AddPass<BuildBinsPassData>("Visibility Buffer Build Bins", RenderPassType::Compute,
+        [&](BuildBinsPassData& data, RGBuilder& builder)
+        {
+            RGBuffer::Desc bufferDesc;
+            bufferDesc.m_stride = 4;
+            bufferDesc.m_size = bufferDesc.m_stride * VISIBILITY_BUFFER_BIN_COUNT;
+            bufferDesc.m_format = RHIFormat::R32UI;
+            bufferDesc.m_usage = RHIBufferUsageBit::RHIBufferUsageTypedBuffer;
+            data.m_binCursorBuffer = builder.Create<RGBuffer>(bufferDesc, "Visibility buffer bin cursor");
+            data.m_binCursorBuffer = builder.Write(data.m_binCursorBuffer);
+
+            bufferDesc.m_stride = sizeof(uint3);
+            bufferDesc.m_size = bufferDesc.m_stride;
+            bufferDesc.m_format = RHIFormat::Unknown;
+            bufferDesc.m_usage = RHIBufferUsageBit::RHIBufferUsageStructedBuffer;
+            data.m_indirectCommandBuffer = builder.Create<RGBuffer>(bufferDesc, "Visibility buffer resolve command");
+            data.m_indirectCommandBuffer = builder.Write(data.m_indirectCommandBuffer);
+
+            data.m_binCounterBuffer = builder.Read(classifyPass->m_binCounterBuffer);
+        },
+        [=](const BuildBinsPassData& data, IRHICommandList* pCommandList)
+        {
+            pCommandList->SetPipelineState(m_pVisibilityBufferBuildBinsPSO);
+
+            uint32_t rootConstants[3] = {
+                pRenderGraph->GetBuffer(data.m_binCounterBuffer)->GetSRV()->GetHeapIndex(),
+                pRenderGraph->GetBuffer(data.m_binCursorBuffer)->GetUAV()->GetHeapIndex(),
+                pRenderGraph->GetBuffer(data.m_indirectCommandBuffer)->GetUAV()->GetHeapIndex()
+            };
+            pCommandList->SetComputeConstants(0, rootConstants, sizeof(rootConstants));
+            pCommandList->Dispatch(1, 1, 1);
+        });
+
+    struct ScatterPassData
+    {
+        RGHandle m_visibilityBufferRT;
+        RGHandle m_visibleMeshletListBuffer;
+        RGHandle m_binCursorBuffer;
+        RGHandle m_pixelListBuffer;
+    };
+
+    auto scatterPass = pRenderGraph->AddPass<ScatterPassData>("Visibility Buffer Scatter", RenderPassType::Compute,
+        [&](ScatterPassData& data, RGBuilder& builder)
+        {
+            RGBuffer::Desc bufferDesc;
+            bufferDesc.m_stride = sizeof(uint2);
+            bufferDesc.m_size = bufferDesc.m_stride * width * height;
+            bufferDesc.m_usage = RHIBufferUsageBit::RHIBufferUsageStructedBuffer;
+            data.m_pixelListBuffer = builder.Create<RGBuffer>(bufferDesc, "Visibility buffer pixel list");
+            data.m_pixelListBuffer = builder.Write(data.m_pixelListBuffer);
+
+            data.m_binCursorBuffer = builder.Write(buildBinsPass->m_binCursorBuffer);
+            data.m_visibilityBufferRT = builder.Read(m_visibilityBufferRT);
+            data.m_visibleMeshletListBuffer = builder.Read(m_visibleMeshletListBuffer);
+        },
+        [=](const ScatterPassData& data, IRHICommandList* pCommandList)
+        {
+            pCommandList->SetPipelineState(m_pVisibilityBufferScatterPSO);
+
+            uint32_t rootConstants[5] = {
+                pRenderGraph->GetTexture(data.m_visibilityBufferRT)->GetSRV()->GetHeapIndex(),
+                pRenderGraph->GetBuffer(data.m_visibleMeshletListBuffer)->GetSRV()->GetHeapIndex(),
+                0,
+                pRenderGraph->GetBuffer(data.m_binCursorBuffer)->GetUAV()->GetHeapIndex(),
+                pRenderGraph->GetBuffer(data.m_pixelListBuffer)->GetUAV()->GetHeapIndex()
+            };
+            pCommandList->SetComputeConstants(0, rootConstants, sizeof(rootConstants));
+            pCommandList->Dispatch(DivideRoundingUp(width, 8), DivideRoundingUp(height, 8), 1);
+        });
+
+    struct ResolvePassData
+    {
+        RGHandle m_indirectCommandBuffer;
+        RGHandle m_visibleMeshletListBuffer;
+        RGHandle m_binCursorBuffer;
+        RGHandle m_pixelListBuffer;
+
+        RGHandle m_outDiffuseRT;
+        RGHandle m_outSpecularRT;
+        RGHandle m_outNormalRT;
+        RGHandle m_outEmissiveRT;
+        RGHandle m_outCustomRT;
+    };
+
+    auto resolvePass = pRenderGraph->AddPass<ResolvePassData>("Visibility Buffer Resolve", RenderPassType::Compute,
+        [&](ResolvePassData& data, RGBuilder& builder)
+        {
+            RGTexture::Desc desc;
+            desc.m_width = width;
+            desc.m_height = height;
+            desc.m_format = RHIFormat::RGBA8SRGB;
+            data.m_outDiffuseRT = builder.Create<RGTexture>(desc, "Diffuse RT");
+            data.m_outSpecularRT = builder.Create<RGTexture>(desc, "Specular RT");
+
+            desc.m_format = RHIFormat::RGBA8UNORM;
+            data.m_outNormalRT = builder.Create<RGTexture>(desc, "Normal RT");
+            data.m_outCustomRT = builder.Create<RGTexture>(desc, "CustomData RT");
+
+            desc.m_format = RHIFormat::R11G11B10F;
+            data.m_outEmissiveRT = builder.Create<RGTexture>(desc, "Emissive RT");
+
+            data.m_outDiffuseRT = builder.Write(data.m_outDiffuseRT);
+            data.m_outSpecularRT = builder.Write(data.m_outSpecularRT);
+            data.m_outNormalRT = builder.Write(data.m_outNormalRT);
+            data.m_outEmissiveRT = builder.Write(data.m_outEmissiveRT);
+            data.m_outCustomRT = builder.Write(data.m_outCustomRT);
+
+            data.m_indirectCommandBuffer = builder.ReadIndirectArg(buildBinsPass->m_indirectCommandBuffer);
+            data.m_binCursorBuffer = builder.Read(scatterPass->m_binCursorBuffer);
+            data.m_pixelListBuffer = builder.Read(scatterPass->m_pixelListBuffer);
+            data.m_visibleMeshletListBuffer = builder.Read(m_visibleMeshletListBuffer);
+        },
+        [=](const ResolvePassData& data, IRHICommandList* pCommandList)
+        {
+            RGTexture* pTargets[5] = {
+                pRenderGraph->GetTexture(data.m_outDiffuseRT),
+                pRenderGraph->GetTexture(data.m_outSpecularRT),
+                pRenderGraph->GetTexture(data.m_outNormalRT),
+                pRenderGraph->GetTexture(data.m_outEmissiveRT),
+                pRenderGraph->GetTexture(data.m_outCustomRT)
+            };
+
+            // Only the covered pixels are resolved, the sky keeps the clear value of the G-buffer pass
+            float clearValue[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            for (uint32_t i = 0; i < 5; ++i)
+            {
+                pCommandList->ClearUAV(pTargets[i]->GetTexture(), pTargets[i]->GetUAV(), clearValue);
+                pCommandList->TextureBarrier(pTargets[i]->GetTexture(), RHI_ALL_SUB_RESOURCE, RHIAccessBit::RHIAccessClearUAV, RHIAccessBit::RHIAccessComputeShaderUAV);
+            }
+
+            pCommandList->SetPipelineState(m_pVisibilityBufferResolvePSO);
+
+            uint32_t rootConstants[8] = {
+                pRenderGraph->GetBuffer(data.m_visibleMeshletListBuffer)->GetSRV()->GetHeapIndex(),
+                pRenderGraph->GetBuffer(data.m_binCursorBuffer)->GetSRV()->GetHeapIndex(),
+                pRenderGraph->GetBuffer(data.m_pixelListBuffer)->GetSRV()->GetHeapIndex(),
+                pTargets[0]->GetUAV()->GetHeapIndex(),
+                pTargets[1]->GetUAV()->GetHeapIndex(),
+                pTargets[2]->GetUAV()->GetHeapIndex(),
+                pTargets[3]->GetUAV()->GetHeapIndex(),
+                pTargets[4]->GetUAV()->GetHeapIndex()
+            };
+            pCommandList->SetComputeConstants(0, rootConstants, sizeof(rootConstants));
+            pCommandList->DispatchIndirect(pRenderGraph->GetBuffer(data.m_indirectCommandBuffer)->GetBuffer(), 0);
+        });
+
+    m_diffuseRT = resolvePass->m_outDiffuseRT;
+    m_specularRT = resolvePass->m_outSpecularRT;
+    m_normalRT = resolvePass->m_outNormalRT;
+    m_emissiveRT = resolvePass->m_outEmissiveRT;
+    m_customDataRT = resolvePass->m_outCustomRT;
 }
 
 void BasePassGPUDriven::MergeBatch()
 {
-    m_totalInstanceCount = (uint32_t) m_instances.size();
+    CPU_EVENT("Render", "BasePassGPUDriven::MergeBatch");
+
+    const eastl::vector<RenderBatch>& instances = m_instances.Merge();
+    m_totalInstanceCount = (uint32_t) instances.size();
 
     eastl::vector<uint32_t> instanceIndices(m_totalInstanceCount);
     for (uint32_t i = 0; i < m_totalInstanceCount; ++i)
     {
-        instanceIndices[i] = m_instances[i].m_instaceIndex;
+        instanceIndices[i] = instances[i].m_instaceIndex;
     }
     m_instanceIndexAddress = m_pRenderer->AllocateSceneConstant(instanceIndices.data(), sizeof(uint32_t) * m_totalInstanceCount);
 
@@ -494,33 +902,34 @@ void BasePassGPUDriven::MergeBatch()
     m_indirectBatches.clear();
     m_nonGPUDrivenBatches.clear();
 
+    if (m_bMeshletListReadback)
+    {
+        m_meshletListReadback = MeshletListReadback();
+    }
+
+    // Only per-instance records (instance index, meshlet count) are uploaded, meshlets are expanded on the GPU in BuildMeshletList
     struct MergedBatch
     {
-        eastl::vector<RenderBatch> m_batches;
+        eastl::vector<uint2> m_instanceRecords;
         uint32_t m_meshletCount;
     };
     eastl::map<IRHIPipelineState*, MergedBatch> mergedBatches;
 
-    for (size_t i = 0; i < m_instances.size(); ++i)
+    for (size_t i = 0; i < instances.size(); ++i)
     {
-        const RenderBatch& batch = m_instances[i];
+        const RenderBatch& batch = instances[i];
         if (batch.m_pPSO->GetType() == RHIPipelineType::MeshShading)
         {
             m_totalMeshletCount += batch.m_meshletCount;
 
-            auto iter = mergedBatches.find(batch.m_pPSO);
-            if (iter != mergedBatches.end())
+            MergedBatch& mergedBatch = mergedBatches[batch.m_pPSO];
+            if (mergedBatch.m_instanceRecords.empty())
             {
-                iter->second.m_meshletCount += batch.m_meshletCount;
-                iter->second.m_batches.push_back(batch);                //< Copy happen
-            }
-            else
-            {
-                MergedBatch mergedBatch;
-                mergedBatch.m_batches.push_back(batch);
-                mergedBatch.m_meshletCount = batch.m_meshletCount;
-                mergedBatches.insert(eastl::make_pair(batch.m_pPSO, mergedBatch));
+                mergedBatch.m_meshletCount = 0;
             }
+
+            mergedBatch.m_meshletCount += batch.m_meshletCount;
+            mergedBatch.m_instanceRecords.emplace_back(batch.m_instaceIndex, batch.m_meshletCount);
         }
         else
         {
@@ -529,32 +938,39 @@ void BasePassGPUDriven::MergeBatch()
     }
 
     uint32_t meshletListOffset = 0;
+    uint32_t instanceRecordCount = 0;
     for (auto iter = mergedBatches.begin(); iter != mergedBatches.end(); ++iter) //< iterate every different PSO
     {
         const MergedBatch& batch = iter->second;
-        
-        eastl::vector<uint2> meshletList;
-        meshletList.reserve(batch.m_meshletCount);
+        uint32_t recordCount = (uint32_t) batch.m_instanceRecords.size();
 
-        for (size_t i = 0; i < batch.m_batches.size(); ++i)
+        IndirectBatch indirectBatch;
+        indirectBatch.m_pPSO = iter->first;
+        indirectBatch.m_instanceRecordAddress = m_pRenderer->AllocateSceneConstant(batch.m_instanceRecords.data(), sizeof(uint2) * recordCount);
+        indirectBatch.m_instanceRecordCount = recordCount;
+        indirectBatch.m_originMeshletCount = batch.m_meshletCount;
+        indirectBatch.m_meshletListBufferOffset = meshletListOffset;
+        m_indirectBatches.push_back(indirectBatch);
+
+        if (m_bMeshletListReadback)
         {
-            uint32_t instanceIndex = batch.m_batches[i].m_instaceIndex;
-            for (size_t m = 0; m < batch.m_batches[i].m_meshletCount; ++m)
-            {
-                meshletList.emplace_back(instanceIndex, (uint32_t) m);
-            }
+            m_meshletListReadback.m_batches.push_back({ batch.m_instanceRecords, {} });
         }
 
-        uint32_t meshletListAddress = m_pRenderer->AllocateSceneConstant(meshletList.data(), sizeof(uint2) * (uint32_t) meshletList.size());
-        m_indirectBatches.push_back({iter->first, meshletListAddress, batch.m_meshletCount, meshletListOffset});
-
         meshletListOffset += batch.m_meshletCount;
+        instanceRecordCount += recordCount;
     }
 
-    m_instances.clear();
+    MICROPROFILE_COUNTER_SET("Renderer/BasePassGPUDriven/InstanceRecordBytes", sizeof(uint2) * instanceRecordCount);
+    MICROPROFILE_COUNTER_SET("Renderer/BasePassGPUDriven/MeshletListBytesSaved", sizeof(uint2) * (m_totalMeshletCount - instanceRecordCount));
+    MICROPROFILE_COUNTER_SET("Renderer/BasePassGPUDriven/PSOCount", m_indirectBatches.size());
+    MICROPROFILE_COUNTER_SET("Renderer/BasePassGPUDriven/IndirectDispatchCount", m_indirectBatches.size() * 2);     //< One per PSO in each phase
+
+    m_instances.Clear();
 }
 
-void BasePassGPUDriven::ResetCounter(IRHICommandList* pCommandList, RGBuffer* pFirstPhaseMeshletCounter, RGBuffer* pSecondPhaseObjectCounter, RGBuffer* pSecondPhaseMeshletCounter)
+void BasePassGPUDriven::ResetCounter(IRHICommandList* pCommandList, RGBuffer* pFirstPhaseMeshletCounter, RGBuffer* pSecondPhaseObjectCounter, RGBuffer* pSecondPhaseMeshletCounter,
+    RGBuffer* pVisibleMeshletCounter)
 {
     uint32_t clearValue[4] = {0, 0, 0, 0};
     pCommandList->ClearUAV(pFirstPhaseMeshletCounter->GetBuffer(), pFirstPhaseMeshletCounter->GetUAV(), clearValue);
@@ -564,6 +980,12 @@ void BasePassGPUDriven::ResetCounter(IRHICommandList* pCommandList, RGBuffer* pF
     pCommandList->BufferBarrier(pFirstPhaseMeshletCounter->GetBuffer(), RHIAccessBit::RHIAccessClearUAV, RHIAccessBit::RHIAccessComputeShaderUAV);
     pCommandList->BufferBarrier(pSecondPhaseObjectCounter->GetBuffer(), RHIAccessBit::RHIAccessClearUAV, RHIAccessBit::RHIAccessComputeShaderUAV);
     pCommandList->BufferBarrier(pSecondPhaseMeshletCounter->GetBuffer(), RHIAccessBit::RHIAccessClearUAV, RHIAccessBit::RHIAccessComputeShaderUAV);
+
+    if (pVisibleMeshletCounter)
+    {
+        pCommandList->ClearUAV(pVisibleMeshletCounter->GetBuffer(), pVisibleMeshletCounter->GetUAV(), clearValue);
+        pCommandList->BufferBarrier(pVisibleMeshletCounter->GetBuffer(), RHIAccessBit::RHIAccessClearUAV, RHIAccessBit::RHIAccessComputeShaderUAV);
+    }
 }
 
 void BasePassGPUDriven::InstanceCulling1stPhase(IRHICommandList* pCommandList, RGBuffer* pCullingResultUAV, RGBuffer* pSecondPhaseObjectListUAV, RGBuffer* pSecondPhaseIbjectListCounterUAV)
@@ -603,19 +1025,23 @@ void BasePassGPUDriven::InstanceCulling2ndPhase(IRHICommandList* pCommandList, R
     pCommandList->DispatchIndirect(pIndirectDispatchCommandBuffer->GetBuffer(), 0);
 }
 
-void BasePassGPUDriven::Flush1stPhaseBatches(IRHICommandList* pCommandList, RGBuffer* pIndirectCommandBuffer, RGBuffer* pMeshletListSRV, RGBuffer* pMeshletListCounterSRV)
+void BasePassGPUDriven::Flush1stPhaseBatches(IRHICommandList* pCommandList, RGBuffer* pIndirectCommandBuffer, RGBuffer* pMeshletListSRV, RGBuffer* pMeshletListCounterSRV,
+    RGBuffer* pVisibleMeshletListUAV, RGBuffer* pVisibleMeshletCounterUAV)
 {
     for (size_t i = 0; i < m_indirectBatches.size(); ++i)
     {
         const IndirectBatch& batch = m_indirectBatches[i];
         pCommandList->SetPipelineState(batch.m_pPSO);
 
-        uint32_t rootConstants[5] = {
+        uint32_t rootConstants[8] = {
             pMeshletListSRV->GetSRV()->GetHeapIndex(),
             pMeshletListCounterSRV->GetSRV()->GetHeapIndex(),
             batch.m_meshletListBufferOffset,
             (uint32_t) i,
-            1
+            1,
+            pVisibleMeshletListUAV ? pVisibleMeshletListUAV->GetUAV()->GetHeapIndex() : RHI_INVALID_RESOURCE,
+            pVisibleMeshletCounterUAV ? pVisibleMeshletCounterUAV->GetUAV()->GetHeapIndex() : RHI_INVALID_RESOURCE,
+            m_bSoftwareRaster
         };
         pCommandList->SetGraphicsConstants(0, rootConstants, sizeof(rootConstants));
 
@@ -623,28 +1049,36 @@ void BasePassGPUDriven::Flush1stPhaseBatches(IRHICommandList* pCommandList, RGBu
     }
 }
 
-void BasePassGPUDriven::Flush2ndPhaseBatches(IRHICommandList* pCommandList, RGBuffer* pIndirectCommandBuffer, RGBuffer* pMeshletListSRV, RGBuffer* pMeshletListCounterSRV)
+void BasePassGPUDriven::Flush2ndPhaseBatches(IRHICommandList* pCommandList, RGBuffer* pIndirectCommandBuffer, RGBuffer* pMeshletListSRV, RGBuffer* pMeshletListCounterSRV,
+    RGBuffer* pVisibleMeshletListUAV, RGBuffer* pVisibleMeshletCounterUAV)
 {
     for (size_t i = 0; i < m_indirectBatches.size(); ++i)
     {
         const IndirectBatch& batch = m_indirectBatches[i];
         pCommandList->SetPipelineState(batch.m_pPSO);
 
-        uint32_t rootConstants[5] = {
+        uint32_t rootConstants[8] = {
             pMeshletListSRV->GetSRV()->GetHeapIndex(),
             pMeshletListCounterSRV->GetSRV()->GetHeapIndex(),
             batch.m_meshletListBufferOffset,
             (uint32_t)i,
-            1
+            1,
+            pVisibleMeshletListUAV ? pVisibleMeshletListUAV->GetUAV()->GetHeapIndex() : RHI_INVALID_RESOURCE,
+            pVisibleMeshletCounterUAV ? pVisibleMeshletCounterUAV->GetUAV()->GetHeapIndex() : RHI_INVALID_RESOURCE,
+            m_bSoftwareRaster
         };
         pCommandList->SetGraphicsConstants(0, rootConstants, sizeof(rootConstants));
 
         pCommandList->DispatchMeshIndirect(pIndirectCommandBuffer->GetBuffer(), sizeof(uint3) * (uint32_t) i);
     }
 
-    for (size_t i = 0; i < m_nonGPUDrivenBatches.size(); ++i)
+    // They have no visibility buffer PSO, StaticMesh only adds meshlet batches with GPU_DRIVEN_BASE_PASS
+    if (pVisibleMeshletListUAV == nullptr)
     {
-        DrawBatch(pCommandList, m_nonGPUDrivenBatches[i]);
+        for (size_t i = 0; i < m_nonGPUDrivenBatches.size(); ++i)
+        {
+            DrawBatch(pCommandList, m_nonGPUDrivenBatches[i]);
+        }
     }
 }
 
@@ -657,18 +1091,133 @@ void BasePassGPUDriven::BuildMeshletList(IRHICommandList* pCommandList, RGBuffer
         uint32_t rootConstants[7] = {
             (uint32_t) i,
             pCullingResultSRV->GetSRV()->GetHeapIndex(),
-            m_indirectBatches[i].m_originMeshletListAddress,
-            m_indirectBatches[i].m_originMeshletCount,
+            m_indirectBatches[i].m_instanceRecordAddress,
+            m_indirectBatches[i].m_instanceRecordCount,
             m_indirectBatches[i].m_meshletListBufferOffset,
             pMeshletListBufferUAV->GetUAV()->GetHeapIndex(),
             pMeshletListCounterBufferUAV->GetUAV()->GetHeapIndex()
         };
 
         pCommandList->SetComputeConstants(0, rootConstants, sizeof(rootConstants));
-        pCommandList->Dispatch(DivideRoundingUp(m_indirectBatches[i].m_originMeshletCount, 64), 1, 1);
+        pCommandList->Dispatch(DivideRoundingUp(m_indirectBatches[i].m_instanceRecordCount, 64), 1, 1);
+    }
+}
+
+void BasePassGPUDriven::ExpandMeshletList(const uint2* pInstanceRecords, uint32_t recordCount, const uint8_t* pCullingResult, eastl::vector<uint2>& meshletList)
+{
+    for (uint32_t i = 0; i < recordCount; ++i)
+    {
+        uint32_t instanceIndex = pInstanceRecords[i].x;
+        if (pCullingResult[instanceIndex] == 1)
+        {
+            for (uint32_t m = 0; m < pInstanceRecords[i].y; ++m)
+            {
+                meshletList.emplace_back(instanceIndex, m);
+            }
+        }
     }
 }
 
+void BasePassGPUDriven::ReadbackMeshletList(RenderGraph* pRenderGraph, const RGHandle& cullingResultBuffer, const RGHandle& meshletListBuffer, const RGHandle& meshletListCounterBuffer)
+{
+    MY_ASSERT(!m_pMeshletListReadbackBuffer);   //< Only the 1st phase is read back, once per request
+
+    // The counters and the meshlet list are kept 8 bytes aligned
+    uint32_t cullingResultSize = RoundUpPow2(m_pRenderer->GetInstanceCount(), 8);
+    uint32_t counterSize = RoundUpPow2((uint32_t) sizeof(uint32_t) * (uint32_t) m_indirectBatches.size(), 8);
+    uint32_t meshletListSize = (uint32_t) sizeof(uint2) * m_totalMeshletCount;
+
+    RHIBufferDesc desc;
+    desc.m_size = max(cullingResultSize + counterSize + meshletListSize, 4u);
+    desc.m_memoryType = RHIMemoryType::GPUToCPU;
+    m_pMeshletListReadbackBuffer.reset(m_pRenderer->GetDevice()->CreateBuffer(desc, "BasePassGPUDriven::MeshletListReadback"));
+    m_meshletListReadbackFrameID = m_pRenderer->GetDevice()->GetFrameID();
+    m_meshletListReadback.m_cullingResult.resize(m_pRenderer->GetInstanceCount());
+
+    m_pendingMeshletListReadbackCallback = m_meshletListReadbackCallback;
+    m_meshletListReadbackCallback = nullptr;
+
+    IRHIBuffer* pReadbackBuffer = m_pMeshletListReadbackBuffer.get();
+
+    struct MeshletListReadbackPassData
+    {
+        RGHandle m_cullingResultBuffer;
+        RGHandle m_meshletListBuffer;
+        RGHandle m_meshletListCounterBuffer;
+    };
+
+    pRenderGraph->AddPass<MeshletListReadbackPassData>("Meshlet List Readback", RenderPassType::Copy,
+        [&](MeshletListReadbackPassData& data, RGBuilder& builder)
+        {
+            data.m_cullingResultBuffer = builder.Read(cullingResultBuffer);
+            data.m_meshletListBuffer = builder.Read(meshletListBuffer);
+            data.m_meshletListCounterBuffer = builder.Read(meshletListCounterBuffer);
+            builder.SkipCulling();
+        },
+        [=](const MeshletListReadbackPassData& data, IRHICommandList* pCommandList)
+        {
+            if (cullingResultSize > 0)
+            {
+                pCommandList->CopyBuffer(pReadbackBuffer, 0, pRenderGraph->GetBuffer(data.m_cullingResultBuffer)->GetBuffer(), 0, cullingResultSize);
+            }
+
+            if (counterSize > 0)
+            {
+                pCommandList->CopyBuffer(pReadbackBuffer, cullingResultSize, pRenderGraph->GetBuffer(data.m_meshletListCounterBuffer)->GetBuffer(), 0, counterSize);
+            }
+
+            if (meshletListSize > 0)
+            {
+                pCommandList->CopyBuffer(pReadbackBuffer, cullingResultSize + counterSize, pRenderGraph->GetBuffer(data.m_meshletListBuffer)->GetBuffer(), 0, meshletListSize);
+            }
+        });
+}
+
+void BasePassGPUDriven::ProcessMeshletListReadback(uint64_t completedFrameID)
+{
+    if (!m_pMeshletListReadbackBuffer || m_meshletListReadbackFrameID > completedFrameID)
+    {
+        return;
+    }
+
+    uint32_t cullingResultSize = (uint32_t) m_meshletListReadback.m_cullingResult.size();
+    uint32_t batchCount = (uint32_t) m_meshletListReadback.m_batches.size();
+
+    const char* pData = (const char*) m_pMeshletListReadbackBuffer->GetCPUAddress();
+    const char* pCounters = pData + RoundUpPow2(cullingResultSize, 8);
+    const char* pMeshletList = pCounters + RoundUpPow2((uint32_t) sizeof(uint32_t) * batchCount, 8);
+
+    memcpy(m_meshletListReadback.m_cullingResult.data(), pData, cullingResultSize);
+
+    // The meshlets of a batch start at the sum of the meshlet counts of the batches before it, as MergeBatch placed them
+    uint32_t meshletListOffset = 0;
+    for (uint32_t i = 0; i < batchCount; ++i)
+    {
+        MeshletListReadback::Batch& batch = m_meshletListReadback.m_batches[i];
+
+        uint32_t meshletCount = 0;
+        for (size_t j = 0; j < batch.m_instanceRecords.size(); ++j)
+        {
+            meshletCount += batch.m_instanceRecords[j].y;
+        }
+
+        uint32_t counter;
+        memcpy(&counter, pCounters + sizeof(uint32_t) * i, sizeof(uint32_t));
+
+        batch.m_meshletList.resize(min(counter, meshletCount));
+        memcpy(batch.m_meshletList.data(), pMeshletList + sizeof(uint2) * meshletListOffset, sizeof(uint2) * batch.m_meshletList.size());
+
+        meshletListOffset += meshletCount;
+    }
+
+    // Moved out first, the callback may request a new readback
+    eastl::function<void(const MeshletListReadback&)> callback = eastl::move(m_pendingMeshletListReadbackCallback);
+    m_pendingMeshletListReadbackCallback = nullptr;
+    m_pMeshletListReadbackBuffer.reset();
+
+    callback(m_meshletListReadback);
+}
+
 void BasePassGPUDriven::BuildIndirectCommand(IRHICommandList* pCommandList, RGBuffer* pCounterBufferSRV, RGBuffer* pCommandBufferUAV)
 {
     pCommandList->SetPipelineState(m_pBuildIndirectCommandPSO);
@@ -5,6 +5,19 @@
 
 class Renderer;
 
+// The 1st phase meshlet list of one frame as the GPU wrote it, with the instance records and the culling result it was built from
+struct MeshletListReadback
+{
+    struct Batch
+    {
+        eastl::vector<uint2> m_instanceRecords;     //< uint2(instance index, meshlet count)
+        eastl::vector<uint2> m_meshletList;         //< uint2(instance index, meshlet index), in the order of the GPU waves
+    };
+
+    eastl::vector<Batch> m_batches;                 //< One per PSO
+    eastl::vector<uint8_t> m_cullingResult;         //< Per instance, 1 if it is visible in the 1st phase
+};
+
 class BasePassGPUDriven
 {
 public:
@@ -21,22 +34,39 @@ public:
     RGHandle GetCustomDataRT() const { return m_customDataRT; }
     RGHandle GetDepthRT() const { return m_depthRT; }
     RGHandle GetCulledObjectsDiffuseRT() const { return m_culledObjectsDiffuseRT; }
+    RGHandle GetVisibilityBufferRT() const { return m_visibilityBufferRT; }    //< Only valid with Renderer::IsVisibilityBufferEnabled
 
     RGHandle GetSecondPhaseMeshletListBuffer() const { return m_2ndPhaseMeshletListBuffer; }
     RGHandle GetSecondPhaseMeshletListCounterBuffer() const { return m_2ndPhaseMeshletListCounterBuffer; }
     
+    // CPU reference of BuildMeshletList in InstanceCulling.hlsl, the GPU writes the same items but the order of waves is not defined
+    static void ExpandMeshletList(const uint2* pInstanceRecords, uint32_t recordCount, const uint8_t* pCullingResult, eastl::vector<uint2>& meshletList);
+
+    // The callback gets the meshlet list of the next frame once the GPU has finished it, for comparing it with ExpandMeshletList
+    void RequestMeshletListReadback(const eastl::function<void(const MeshletListReadback&)>& callback) { m_meshletListReadbackCallback = callback; }
+    void ProcessMeshletListReadback(uint64_t completedFrameID);
 
 private:
     void MergeBatch();
 
-    void ResetCounter(IRHICommandList* pCommandList, RGBuffer* p1stPhaseMeshletCounter, RGBuffer* p2ndPhaseObjectCounter, RGBuffer* p2ndPhaseMeshletCounter);
+    void ResetCounter(IRHICommandList* pCommandList, RGBuffer* p1stPhaseMeshletCounter, RGBuffer* p2ndPhaseObjectCounter, RGBuffer* p2ndPhaseMeshletCounter, RGBuffer* pVisibleMeshletCounter);
     void InstanceCulling1stPhase(IRHICommandList* pCommandList, RGBuffer* pCullingResultUAV, RGBuffer* p2ndPhaseObjectListUAV, RGBuffer* p2ndPhaseObjectListCounterUAV);
     void InstanceCulling2ndPhase(IRHICommandList* pCommandList, RGBuffer* pIndirectCommandBuffer, RGBuffer* pCullingResultUAV, RGBuffer* pObjectListBufferSRV, RGBuffer* pObjectListCounterBufferUAV);
 
-    void Flush1stPhaseBatches(IRHICommandList* pCommandList, RGBuffer* pIndirectCommandBuffer, RGBuffer* pMeshletListSRV, RGBuffer* pMeshletListCounterSRV);
-    void Flush2ndPhaseBatches(IRHICommandList* pCommandList, RGBuffer* pIndirectCommandBuffer, RGBuffer* pMeshletListSRV, RGBuffer* pMeshletListCounterSRV);
+    // The visible meshlet buffers are only used by the visibility buffer, nullptr for the G-buffer
+    void Flush1stPhaseBatches(IRHICommandList* pCommandList, RGBuffer* pIndirectCommandBuffer, RGBuffer* pMeshletListSRV, RGBuffer* pMeshletListCounterSRV,
+        RGBuffer* pVisibleMeshletListUAV, RGBuffer* pVisibleMeshletCounterUAV);
+    void Flush2ndPhaseBatches(IRHICommandList* pCommandList, RGBuffer* pIndirectCommandBuffer, RGBuffer* pMeshletListSRV, RGBuffer* pMeshletListCounterSRV,
+        RGBuffer* pVisibleMeshletListUAV, RGBuffer* pVisibleMeshletCounterUAV);
+
+    // Rasterizes the meshlets which the 1st or the 2nd phase sent to the software rasterizer and merges their depth
+    void SoftwareRaster(RenderGraph* pRenderGraph, bool bFirstPhase);
+
+    // Writes the G-buffer from the visibility buffer, the pixels are sorted by material first
+    void ResolveVisibilityBuffer(RenderGraph* pRenderGraph);
 
     void BuildMeshletList(IRHICommandList* pCommandList, RGBuffer* pCullingResultSRV, RGBuffer* pMeshletBufferUAV, RGBuffer* pMeshListCounterBufferUAV);
+    void ReadbackMeshletList(RenderGraph* pRenderGraph, const RGHandle& cullingResultBuffer, const RGHandle& meshletListBuffer, const RGHandle& meshletListCounterBuffer);
     void BuildIndirectCommand(IRHICommandList* pCommandList, RGBuffer* pCounterBufferSRV, RGBuffer* pCommandBufferUAV);
 private:
     Renderer* m_pRenderer;
@@ -48,12 +78,22 @@ private:
     IRHIPipelineState* m_pBuildInstanceCullingCommandPSO = nullptr;
     IRHIPipelineState* m_pBuildIndirectCommandPSO = nullptr;
 
-    eastl::vector<RenderBatch> m_instances;
+    IRHIPipelineState* m_pVisibilityBufferClassifyPSO = nullptr;
+    IRHIPipelineState* m_pVisibilityBufferBuildBinsPSO = nullptr;
+    IRHIPipelineState* m_pVisibilityBufferScatterPSO = nullptr;
+    IRHIPipelineState* m_pVisibilityBufferResolvePSO = nullptr;
+
+    IRHIPipelineState* m_pSoftwareRasterPSO = nullptr;
+    IRHIPipelineState* m_pSoftwareRasterBuildCommandPSO = nullptr;
+    IRHIPipelineState* m_pDepthMergePSO = nullptr;
+
+    RenderBatchList<RenderBatch> m_instances;
 
     struct IndirectBatch
     {
         IRHIPipelineState* m_pPSO;
-        uint32_t m_originMeshletListAddress;
+        uint32_t m_instanceRecordAddress;     //< uint2(instance index, meshlet count) per instance
+        uint32_t m_instanceRecordCount;
         uint32_t m_originMeshletCount;
         uint32_t m_meshletListBufferOffset;
     };
@@ -81,4 +121,18 @@ private:
 
     RGHandle m_2ndPhaseMeshletListBuffer;
     RGHandle m_2ndPhaseMeshletListCounterBuffer;
+
+    bool m_bVisibilityBuffer = false;   //< Renderer::IsVisibilityBufferEnabled of this frame
+    bool m_bSoftwareRaster = false;
+    RGHandle m_visibilityBufferRT;
+    RGHandle m_visibleMeshletListBuffer;
+    RGHandle m_visibleMeshletCounterBuffer;
+
+    // A requested readback is copied in the next frame once the previous one is processed
+    eastl::function<void(const MeshletListReadback&)> m_meshletListReadbackCallback;
+    eastl::function<void(const MeshletListReadback&)> m_pendingMeshletListReadbackCallback;
+    eastl::unique_ptr<IRHIBuffer> m_pMeshletListReadbackBuffer;     //< Culling result, counters, then the meshlet list
+    MeshletListReadback m_meshletListReadback;
+    uint64_t m_meshletListReadbackFrameID = 0;
+    bool m_bMeshletListReadback = false;    //< Copied in this frame
 };
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "HierarchicalDepthBufferPass.h"
 #include "../Renderer.h"
+#include "../HZB.h"
+#include "Utils/profiler.h"
 
 #define A_CPU
 #include "FFX/ffx_a.h"
@@ -23,8 +25,17 @@ HZBPass::HZBPass(Renderer* pRenderer) : m_pRenderer(pRenderer)
     desc.m_pCS = pRenderer->GetShader("HZB/HZB.hlsl", "BuildHZB", RHIShaderType::CS);
     m_pDepthMipFilterPSO = pRenderer->GetPipelineState(desc, "HZB generate mips PSO");
 
-    desc.m_pCS = pRenderer->GetShader("HZB/HZB.hlsl", "BuildHZB", RHIShaderType::CS, {"MAX_MIN_FILTER=1"});
+    desc.m_pCS = pRenderer->GetShader("HZB/HZB.hlsl", "BuildHZB", RHIShaderType::CS, {"MIN_MAX_FILTER=1"});
     m_pDepthMipFilterMinMaxPSO = pRenderer->GetPipelineState(desc, "HZB generate min max mips PSO");
+
+    desc.m_pCS = pRenderer->GetShader("HZB/HZBReprojection.hlsl", "DepthReprojectionAtomic", RHIShaderType::CS);
+    m_pDepthReprojectionAtomicPSO = pRenderer->GetPipelineState(desc, "HZB atomic depth reprojection PSO");
+
+    desc.m_pCS = pRenderer->GetShader("HZB/HZB.hlsl", "BuildHZB", RHIShaderType::CS, {"HZB_FUSED_REPROJECTION=1"});
+    m_pFusedReprojectionHZBPSO = pRenderer->GetPipelineState(desc, "HZB fused reprojection PSO");
+
+    desc.m_pCS = pRenderer->GetShader("HZB/HZB.hlsl", "BuildHZB", RHIShaderType::CS, {"HZB_FUSED_DEPTH=1", "MIN_MAX_FILTER=1"});
+    m_pFusedMinMaxHZBPSO = pRenderer->GetPipelineState(desc, "HZB fused min max PSO");
 }
 
 void HZBPass::Generate1stPhaseCullingHZB(RenderGraph* pGraph)
@@ -32,6 +43,13 @@ void HZBPass::Generate1stPhaseCullingHZB(RenderGraph* pGraph)
     RENDER_GRAPH_EVENT(pGraph, "HZB Pass");
 
     CalcHZBSize();
+    m_passCount = 0;
+
+    if (m_pRenderer->IsFusedHZBEnabled())
+    {
+        GenerateFused1stPhaseCullingHZB(pGraph);
+        return;
+    }
 
     struct DepthReprojectionData
     {
@@ -101,14 +119,26 @@ void HZBPass::Generate1stPhaseCullingHZB(RenderGraph* pGraph)
         [=](const BuildHZBData& data, IRHICommandList* pCommandList)
         {
             RGTexture* hzb = pGraph->GetTexture(data.m_hzb);
-            BuildHZB(pCommandList, hzb);
+            BuildHZB(pCommandList, m_pDepthMipFilterPSO, hzb);
         });
+
+    m_passCount += 3;
+    MICROPROFILE_COUNTER_SET("Renderer/HZB/Passes", m_passCount);
 }
 
 void HZBPass::Generate2ndPhaseCullingHZB(RenderGraph* pGraph, RGHandle depthRT)
 {
     RENDER_GRAPH_EVENT(pGraph, "HZB Pass");
 
+    if (m_pRenderer->IsFusedHZBEnabled())
+    {
+        // The culling reads the min channel, the max channel makes it the scene HZB of the same depth
+        GenerateFusedMinMaxHZB(pGraph, depthRT, "2nd Phase HZB", m_2ndPhaseCullingHZBMips);
+        m_2ndPhaseDepthRT = depthRT;
+        return;
+    }
+    m_2ndPhaseDepthRT = RGHandle();
+
     struct InitHZBData
     {
         RGHandle m_inputDepthRT;
@@ -155,14 +185,33 @@ void HZBPass::Generate2ndPhaseCullingHZB(RenderGraph* pGraph, RGHandle depthRT)
         [=](const BuildHZBData& data, IRHICommandList* pCommandList)
         {
             RGTexture* pHZB = pGraph->GetTexture(data.m_hzb);
-            BuildHZB(pCommandList, pHZB);
+            BuildHZB(pCommandList, m_pDepthMipFilterPSO, pHZB);
         });
+
+    m_passCount += 2;
+    MICROPROFILE_COUNTER_SET("Renderer/HZB/Passes", m_passCount);
 }
 
 void HZBPass::GenerateSceneHZB(RenderGraph* pGraph, RGHandle depthRT)
 {
     RENDER_GRAPH_EVENT(pGraph, "HZB Pass");
 
+    if (m_pRenderer->IsFusedHZBEnabled())
+    {
+        if (depthRT.m_index == m_2ndPhaseDepthRT.m_index && depthRT.m_node == m_2ndPhaseDepthRT.m_node)
+        {
+            for (uint32_t i = 0; i < m_hzbMipCount; ++i)
+            {
+                m_sceneHZBMips[i] = m_2ndPhaseCullingHZBMips[i];
+            }
+        }
+        else
+        {
+            GenerateFusedMinMaxHZB(pGraph, depthRT, "Scene HZB", m_sceneHZBMips);
+        }
+        return;
+    }
+
     struct InitHZBData
     {
         RGHandle m_inputDepthRT;
@@ -209,8 +258,105 @@ void HZBPass::GenerateSceneHZB(RenderGraph* pGraph, RGHandle depthRT)
         [=](const BuildHZBData& data, IRHICommandList* pCommandList)
         {
             RGTexture* pHZB = pGraph->GetTexture(data.m_hzb);
-            BuildHZB(pCommandList, pHZB, true);
+            BuildHZB(pCommandList, m_pDepthMipFilterMinMaxPSO, pHZB);
         });
+
+    m_passCount += 2;
+    MICROPROFILE_COUNTER_SET("Renderer/HZB/Passes", m_passCount);
+}
+
+void HZBPass::GenerateFused1stPhaseCullingHZB(RenderGraph* pGraph)
+{
+    struct DepthReprojectionData
+    {
+        RGHandle m_prevDepth;
+        RGHandle m_reprojectedDepth;
+    };
+
+    auto reprojectionPass = pGraph->AddPass<DepthReprojectionData>("HZB Reprojection", RenderPassType::Compute,
+        [&](DepthReprojectionData& data, RGBuilder& builder)
+        {
+            data.m_prevDepth = builder.Read(m_pRenderer->GetPrevSceneDepthHandle());
+
+            RGTexture::Desc desc;
+            desc.m_width = m_hzbSize.x;
+            desc.m_height = m_hzbSize.y;
+            desc.m_format = RHIFormat::R32UI;
+            data.m_reprojectedDepth = builder.Create<RGTexture>(desc, "Reprojected Depth RT");
+
+            data.m_reprojectedDepth = builder.Write(data.m_reprojectedDepth);
+        },
+        [=](const DepthReprojectionData& data, IRHICommandList* pCommandList)
+        {
+            ReprojectDepth(pCommandList, pGraph->GetTexture(data.m_reprojectedDepth), true);
+        });
+
+    struct BuildHZBData
+    {
+        RGHandle m_reprojectedDepth;
+        RGHandle m_hzb;
+    };
+
+    pGraph->AddPass<BuildHZBData>("Build 1st Phase HZB", RenderPassType::Compute,
+        [&](BuildHZBData& data, RGBuilder& builder)
+        {
+            data.m_reprojectedDepth = builder.Read(reprojectionPass->m_reprojectedDepth);
+
+            RGTexture::Desc desc;
+            desc.m_width = m_hzbSize.x;
+            desc.m_height = m_hzbSize.y;
+            desc.m_mipLevels = m_hzbMipCount;
+            desc.m_format = RHIFormat::R16F;
+            RGHandle hzb = builder.Create<RGTexture>(desc, "1st phase HZB");
+
+            for (uint32_t i = 0; i < m_hzbMipCount; ++i)
+            {
+                m_1stPhaseCullingHZBMips[i] = builder.Write(hzb, i);
+            }
+            data.m_hzb = m_1stPhaseCullingHZBMips[0];
+        },
+        [=](const BuildHZBData& data, IRHICommandList* pCommandList)
+        {
+            BuildHZB(pCommandList, m_pFusedReprojectionHZBPSO, pGraph->GetTexture(data.m_hzb), pGraph->GetTexture(data.m_reprojectedDepth));
+        });
+
+    m_passCount += 2;
+    MICROPROFILE_COUNTER_SET("Renderer/HZB/Passes", m_passCount);
+}
+
+void HZBPass::GenerateFusedMinMaxHZB(RenderGraph* pGraph, RGHandle depthRT, const eastl::string& name, RGHandle* pMips)
+{
+    struct BuildHZBData
+    {
+        RGHandle m_inputDepthRT;
+        RGHandle m_hzb;
+    };
+
+    pGraph->AddPass<BuildHZBData>("Build " + name, RenderPassType::Compute,
+        [&](BuildHZBData& data, RGBuilder& builder)
+        {
+            data.m_inputDepthRT = builder.Read(depthRT);
+
+            RGTexture::Desc desc;
+            desc.m_width = m_hzbSize.x;
+            desc.m_height = m_hzbSize.y;
+            desc.m_mipLevels = m_hzbMipCount;
+            desc.m_format = RHIFormat::RG16F;
+            RGHandle hzb = builder.Create<RGTexture>(desc, name);
+
+            for (uint32_t i = 0; i < m_hzbMipCount; ++i)
+            {
+                pMips[i] = builder.Write(hzb, i);
+            }
+            data.m_hzb = pMips[0];
+        },
+        [=](const BuildHZBData& data, IRHICommandList* pCommandList)
+        {
+            BuildHZB(pCommandList, m_pFusedMinMaxHZBPSO, pGraph->GetTexture(data.m_hzb), pGraph->GetTexture(data.m_inputDepthRT));
+        });
+
+    m_passCount += 1;
+    MICROPROFILE_COUNTER_SET("Renderer/HZB/Passes", m_passCount);
 }
 
 RGHandle HZBPass::Get1stPhaseCullingHZBMip(uint32_t mip) const
@@ -233,23 +379,25 @@ RGHandle HZBPass::GetSceneHZBMip(uint32_t mip) const
 
 void HZBPass::CalcHZBSize()
 {
-    uint32_t mipX = (uint32_t)eastl::max(ceilf(log2f((float) m_pRenderer->GetRenderWidth())), 1.0f);
-    uint32_t mipY = (uint32_t)eastl::max(ceilf(log2f((float) m_pRenderer->GetRenderHeight())), 1.0f);
-
-    m_hzbMipCount = eastl::max(mipX, mipY);
+    m_hzbSize = GetHZBSize(m_pRenderer->GetRenderWidth(), m_pRenderer->GetRenderHeight(), m_hzbMipCount);
     MY_ASSERT(m_hzbMipCount <= MAX_HZB_MIP_COUNT);
-
-    m_hzbSize.x = 1 << (mipX - 1);
-    m_hzbSize.y = 1 << (mipY - 1);
 }
 
-void HZBPass::ReprojectDepth(IRHICommandList* pCommandList, RGTexture* pReprojectedDepthTexture)
+void HZBPass::ReprojectDepth(IRHICommandList* pCommandList, RGTexture* pReprojectedDepthTexture, bool bAtomic)
 {
-    float clearValue[4] = {0.0f, 0.0f, 0.0f, 0.0f};
-    pCommandList->ClearUAV(pReprojectedDepthTexture->GetTexture(), pReprojectedDepthTexture->GetUAV(), clearValue);
+    if (bAtomic)
+    {
+        uint32_t clearValue[4] = {HZB_REPROJECTION_EMPTY, 0, 0, 0};
+        pCommandList->ClearUAV(pReprojectedDepthTexture->GetTexture(), pReprojectedDepthTexture->GetUAV(), clearValue);
+    }
+    else
+    {
+        float clearValue[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        pCommandList->ClearUAV(pReprojectedDepthTexture->GetTexture(), pReprojectedDepthTexture->GetUAV(), clearValue);
+    }
     pCommandList->TextureBarrier(pReprojectedDepthTexture->GetTexture(), RHI_ALL_SUB_RESOURCE, RHIAccessBit::RHIAccessClearUAV, RHIAccessBit::RHIAccessComputeShaderUAV);
 
-    pCommandList->SetPipelineState(m_pDepthReprojectionPSO);
+    pCommandList->SetPipelineState(bAtomic ? m_pDepthReprojectionAtomicPSO : m_pDepthReprojectionPSO);
 
     uint32_t rootConsts[4] = {
         0,
@@ -270,9 +418,9 @@ void HZBPass::DilateDepth(IRHICommandList* pCommandList, RGTexture* pReprojected
     pCommandList->Dispatch(DivideRoundingUp(m_hzbSize.x, 8), DivideRoundingUp(m_hzbSize.y, 8), 1);
 }
 
-void HZBPass::BuildHZB(IRHICommandList* pCommandList, RGTexture* pTexture, bool bMinMax)
+void HZBPass::BuildHZB(IRHICommandList* pCommandList, IRHIPipelineState* pPSO, RGTexture* pTexture, RGTexture* pSource)
 {
-    pCommandList->SetPipelineState(bMinMax ? m_pDepthMipFilterMinMaxPSO : m_pDepthMipFilterPSO);
+    pCommandList->SetPipelineState(pPSO);
 
     const RHITextureDesc& textureDesc = pTexture->GetTexture()->GetDesc();
 
@@ -292,6 +440,10 @@ void HZBPass::BuildHZB(IRHICommandList* pCommandList, RGTexture* pTexture, bool
         uint m_imgSrc;
         uint m_spdGlobalAtomicUAV;
 
+        uint m_imgMip0;
+        uint2 m_srcSize;
+        uint m_padding;
+
         // HLSL packing rule : every element in an array is stored in a four-component vector
         uint4 m_imgDst[12]; // Do not access mip 5, that use for spd
     };
@@ -306,6 +458,15 @@ void HZBPass::BuildHZB(IRHICommandList* pCommandList, RGTexture* pTexture, bool
 
     constants.m_imgSrc = pTexture->GetSRV()->GetHeapIndex();
     constants.m_spdGlobalAtomicUAV = m_pRenderer->GetSPDCounterBuffer()->GetUAV()->GetHeapIndex();
+    constants.m_imgMip0 = RHI_INVALID_RESOURCE;
+
+    if (pSource)
+    {
+        const RHITextureDesc& sourceDesc = pSource->GetTexture()->GetDesc();
+        constants.m_imgSrc = pSource->GetSRV()->GetHeapIndex();
+        constants.m_imgMip0 = pTexture->GetUAV(0, 0)->GetHeapIndex();
+        constants.m_srcSize = uint2(sourceDesc.m_width, sourceDesc.m_height);
+    }
 
     for (uint32_t i = 0; i < textureDesc.m_mipLevels - 1; ++i)
     {
@@ -21,13 +21,19 @@ public:
     RGHandle Get2ndPhaseCullingHZBMip(uint32_t mip) const;
     RGHandle GetSceneHZBMip(uint32_t mip) const;
 
+    uint32_t GetPassCount() const { return m_passCount; }     //< HZB passes added to the render graph this frame
 
 private:
     void CalcHZBSize();
     
-    void ReprojectDepth(IRHICommandList* pCommandList, RGTexture* pReprojectedDepthTexture);
+    // Fused builds : the reprojection scatters into an atomic texture and one SPD pass dilates it into mip 0 and builds the mips,
+    // the min and max HZB of a depth buffer are built by one SPD pass which reduces the depth into mip 0 as well
+    void GenerateFused1stPhaseCullingHZB(RenderGraph* pGraph);
+    void GenerateFusedMinMaxHZB(RenderGraph* pGraph, RGHandle depthRT, const eastl::string& name, RGHandle* pMips);
+
+    void ReprojectDepth(IRHICommandList* pCommandList, RGTexture* pReprojectedDepthTexture, bool bAtomic = false);
     void DilateDepth(IRHICommandList* pCommandList, RGTexture* pReprojectedDepthSRV, RGTexture* pHZBMip0UAV);
-    void BuildHZB(IRHICommandList* pCommandList, RGTexture* pTexture, bool bMinMax = false);
+    void BuildHZB(IRHICommandList* pCommandList, IRHIPipelineState* pPSO, RGTexture* pTexture, RGTexture* pSource = nullptr);   //< pSource of the fused builds
     void InitHZB(IRHICommandList* pCommandList, RGTexture* pInputDepthSRV, RGTexture* pHZBMip0UAV, bool bMinMax = false);
 private:
     Renderer* m_pRenderer = nullptr;
@@ -40,6 +46,10 @@ private:
     IRHIPipelineState* m_pInitSceneHZBPSO = nullptr;
     IRHIPipelineState* m_pDepthMipFilterMinMaxPSO = nullptr;
 
+    IRHIPipelineState* m_pDepthReprojectionAtomicPSO = nullptr;
+    IRHIPipelineState* m_pFusedReprojectionHZBPSO = nullptr;
+    IRHIPipelineState* m_pFusedMinMaxHZBPSO = nullptr;
+
     uint32_t m_hzbMipCount = 0;
     uint2 m_hzbSize;
 
@@ -47,4 +57,7 @@ private:
     RGHandle m_1stPhaseCullingHZBMips[MAX_HZB_MIP_COUNT] = {};
     RGHandle m_2ndPhaseCullingHZBMips[MAX_HZB_MIP_COUNT] = {};
     RGHandle m_sceneHZBMips[MAX_HZB_MIP_COUNT] = {};
+
+    RGHandle m_2ndPhaseDepthRT;     //< The fused scene HZB of the same depth is the 2nd phase one
+    uint32_t m_passCount = 0;
 };
\ No newline at end of file
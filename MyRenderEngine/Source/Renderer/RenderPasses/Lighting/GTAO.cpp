@@ -19,6 +19,15 @@ GTAO::GTAO(Renderer* pRenderer)
     desc.m_pCS = pRenderer->GetShader("GTAO/GTAO.hlsl", "GTAODenoise", RHIShaderType::CS, defines);
     m_pDenoisePSO = pRenderer->GetPipelineState(desc, "GTAO denoise PSO");
 
+    desc.m_pCS = pRenderer->GetShader("GTAO/GTAO.hlsl", "GTAODownsampleCS", RHIShaderType::CS, defines);
+    m_pDownsamplePSO = pRenderer->GetPipelineState(desc, "GTAO downsample PSO");
+
+    desc.m_pCS = pRenderer->GetShader("GTAO/GTAO.hlsl", "GTAOTemporal", RHIShaderType::CS, defines);
+    m_pTemporalPSO = pRenderer->GetPipelineState(desc, "GTAO temporal PSO");
+
+    desc.m_pCS = pRenderer->GetShader("GTAO/GTAO.hlsl", "GTAOUpsample", RHIShaderType::CS, defines);
+    m_pUpsamplePSO = pRenderer->GetPipelineState(desc, "GTAO upsample PSO");
+
     defines.push_back("QUALITY_LEVEL=0");
     desc.m_pCS = pRenderer->GetShader("GTAO/GTAO.hlsl", "GTAOMain", RHIShaderType::CS, defines);
     m_pGTAOLowPSO = pRenderer->GetPipelineState(desc, "GTAO low PSO");
@@ -71,6 +80,17 @@ RGHandle GTAO::AddPasse(RenderGraph* pRenderGraph, RGHandle depthRT, RGHandle no
     }
 
     RENDER_GRAPH_EVENT(pRenderGraph, "GTAO");
+
+    // The history only keeps the visibility, so GTSO always runs at full resolution
+    if (m_pRenderer->IsHalfResGTAOEnabled() && !m_bEnableGTSO)
+    {
+        return AddHalfResPasses(pRenderGraph, depthRT, normalRT, width, height);
+    }
+    return AddAOPasses(pRenderGraph, depthRT, normalRT, width, height, false);
+}
+
+RGHandle GTAO::AddAOPasses(RenderGraph* pRenderGraph, RGHandle depthRT, RGHandle normalRT, uint32_t width, uint32_t height, bool bHalfRes)
+{
     // Depth prefilter
     
     struct PrefilterDepthPassData
@@ -83,9 +103,11 @@ RGHandle GTAO::AddPasse(RenderGraph* pRenderGraph, RGHandle depthRT, RGHandle no
         RGHandle m_outputDepthMip4;
     };
 
-    auto gtaoPrefilterDepthDepthPass = pRenderGraph->AddPass<PrefilterDepthPassData>("GTAO prefilter depth pass", RenderPassType::Compute,
+    auto gtaoPrefilterDepthDepthPass = pRenderGraph->AddPass<PrefilterDepthPassData>(bHalfRes ? "GTAO half res prefilter depth pass" : "GTAO prefilter depth pass", RenderPassType::Compute,
         [&](PrefilterDepthPassData& data, RGBuilder& builder)
         {
+            builder.AllowAsyncCompute();
+
             data.m_inputDepth = builder.Read(depthRT);
 
             RGTexture::Desc desc;
@@ -117,9 +139,11 @@ RGHandle GTAO::AddPasse(RenderGraph* pRenderGraph, RGHandle depthRT, RGHandle no
         RGHandle m_outputEdge;
     };
 
-    auto gtaoPass = pRenderGraph->AddPass<GTAOPassData>("GTAO Main", RenderPassType::Compute,
+    auto gtaoPass = pRenderGraph->AddPass<GTAOPassData>(bHalfRes ? "GTAO Half Res Main" : "GTAO Main", RenderPassType::Compute,
         [&](GTAOPassData& data, RGBuilder& builder)
         {
+            builder.AllowAsyncCompute();
+
             // Have to tell graph which mip need transition
             data.m_inputPrefilteredDepth = builder.Read(gtaoPrefilterDepthDepthPass->m_outputDepthMip0, 0);
             data.m_inputPrefilteredDepth = builder.Read(gtaoPrefilterDepthDepthPass->m_outputDepthMip1, 1);
@@ -157,9 +181,11 @@ RGHandle GTAO::AddPasse(RenderGraph* pRenderGraph, RGHandle depthRT, RGHandle no
         RGHandle m_outputAO;
     };
 
-    auto gtaoDenoisePass = pRenderGraph->AddPass<DenoisePassData>("GTAO Denoise Pass", RenderPassType::Compute,
+    auto gtaoDenoisePass = pRenderGraph->AddPass<DenoisePassData>(bHalfRes ? "GTAO Half Res Denoise Pass" : "GTAO Denoise Pass", RenderPassType::Compute,
         [&](DenoisePassData& data, RGBuilder& builder)
         {
+            builder.AllowAsyncCompute();
+
             data.m_inputAO = builder.Read(gtaoPass->m_outputAO);
             data.m_inputEdge = builder.Read(gtaoPass->m_outputEdge);
 
@@ -181,6 +207,163 @@ RGHandle GTAO::AddPasse(RenderGraph* pRenderGraph, RGHandle depthRT, RGHandle no
     return gtaoDenoisePass->m_outputAO;
 }
 
+RGHandle GTAO::AddHalfResPasses(RenderGraph* pRenderGraph, RGHandle depthRT, RGHandle normalRT, uint32_t width, uint32_t height)
+{
+    uint32_t halfWidth = (width + 1) / 2;
+    uint32_t halfHeight = (height + 1) / 2;
+
+    struct DownsamplePassData
+    {
+        RGHandle m_inputDepth;
+        RGHandle m_inputNormal;
+        RGHandle m_outputDepth;
+        RGHandle m_outputNormal;
+    };
+
+    auto downsamplePass = pRenderGraph->AddPass<DownsamplePassData>("GTAO Downsample Pass", RenderPassType::Compute,
+        [&](DownsamplePassData& data, RGBuilder& builder)
+        {
+            builder.AllowAsyncCompute();
+
+            data.m_inputDepth = builder.Read(depthRT);
+            data.m_inputNormal = builder.Read(normalRT);
+
+            RGTexture::Desc desc;
+            desc.m_width = halfWidth;
+            desc.m_height = halfHeight;
+            desc.m_format = RHIFormat::R32F;
+            data.m_outputDepth = builder.Create<RGTexture>(desc, "GTAO Half Res Depth");
+            data.m_outputDepth = builder.Write(data.m_outputDepth);
+
+            desc.m_format = RHIFormat::RGBA8UNORM;
+            data.m_outputNormal = builder.Create<RGTexture>(desc, "GTAO Half Res Normal");
+            data.m_outputNormal = builder.Write(data.m_outputNormal);
+        },
+        [=](const DownsamplePassData& data, IRHICommandList* pCommandList)
+        {
+            Downsample(pCommandList,
+                pRenderGraph->GetTexture(data.m_inputDepth),
+                pRenderGraph->GetTexture(data.m_inputNormal),
+                pRenderGraph->GetTexture(data.m_outputDepth),
+                pRenderGraph->GetTexture(data.m_outputNormal),
+                halfWidth, halfHeight);
+        });
+
+    RGHandle halfAO = AddAOPasses(pRenderGraph, downsamplePass->m_outputDepth, downsamplePass->m_outputNormal, halfWidth, halfHeight, true);
+
+    // History
+    bool bHistoryValid = true;
+    if (m_pHistory[0] == nullptr ||
+        m_pHistory[0]->GetTexture()->GetDesc().m_width != halfWidth ||
+        m_pHistory[0]->GetTexture()->GetDesc().m_height != halfHeight)
+    {
+        m_pHistory[0].reset(m_pRenderer->CreateTexture2D(halfWidth, halfHeight, 1, RHIFormat::RG16F, RHITextureUsageBit::RHITextureUsageUnorderedAccess, "GTAO::m_pHistory[0]"));
+        m_pHistory[1].reset(m_pRenderer->CreateTexture2D(halfWidth, halfHeight, 1, RHIFormat::RG16F, RHITextureUsageBit::RHITextureUsageUnorderedAccess, "GTAO::m_pHistory[1]"));
+        m_historyIndex = 0;
+        bHistoryValid = false;
+    }
+
+    // The history written last is still in the UAV state of its temporal pass, the other one in the SRV state of its read. New textures are in the UAV state
+    Texture2D* pPrevHistory = m_pHistory[m_historyIndex].get();
+    Texture2D* pHistory = m_pHistory[1 - m_historyIndex].get();
+    RGHandle prevHistoryHandle = pRenderGraph->Import(pPrevHistory->GetTexture(), RHIAccessBit::RHIAccessComputeShaderUAV);
+    RGHandle historyHandle = pRenderGraph->Import(pHistory->GetTexture(), bHistoryValid ? RHIAccessBit::RHIAccessComputeShaderSRV : RHIAccessBit::RHIAccessComputeShaderUAV);
+
+    uint64_t frameID = m_pRenderer->GetFrameID();
+    if (!bHistoryValid || m_historyFrameID + 1 != frameID)
+    {
+        struct ClearHistoryPassData
+        {
+            RGHandle m_history;
+        };
+
+        auto clearPass = pRenderGraph->AddPass<ClearHistoryPassData>("GTAO Clear History", RenderPassType::Compute,
+            [&](ClearHistoryPassData& data, RGBuilder& builder)
+            {
+                data.m_history = builder.Write(prevHistoryHandle);
+            },
+            [=](const ClearHistoryPassData& data, IRHICommandList* pCommandList)
+            {
+                // A frame count of 0 is no history
+                float clearValue[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                pCommandList->ClearUAV(pPrevHistory->GetTexture(), pPrevHistory->GetUAV(), clearValue);
+                pCommandList->TextureBarrier(pPrevHistory->GetTexture(), RHI_ALL_SUB_RESOURCE, RHIAccessBit::RHIAccessClearUAV, RHIAccessBit::RHIAccessComputeShaderUAV);
+            });
+
+        prevHistoryHandle = clearPass->m_history;
+    }
+
+    m_historyIndex = 1 - m_historyIndex;
+    m_historyFrameID = frameID;
+
+    struct TemporalPassData
+    {
+        RGHandle m_inputAO;
+        RGHandle m_inputDepth;
+        RGHandle m_inputHistory;
+        RGHandle m_outputHistory;
+    };
+
+    auto temporalPass = pRenderGraph->AddPass<TemporalPassData>("GTAO Temporal Pass", RenderPassType::Compute,
+        [&](TemporalPassData& data, RGBuilder& builder)
+        {
+            data.m_inputAO = builder.Read(halfAO);
+            data.m_inputDepth = builder.Read(downsamplePass->m_outputDepth);
+            data.m_inputHistory = builder.Read(prevHistoryHandle);
+            data.m_outputHistory = builder.Write(historyHandle);
+
+            // The states of the imported histories have to be the same every frame
+            builder.SkipCulling();
+        },
+        [=](const TemporalPassData& data, IRHICommandList* pCommandList)
+        {
+            TemporalAccumulate(pCommandList,
+                pRenderGraph->GetTexture(data.m_inputAO),
+                pRenderGraph->GetTexture(data.m_inputDepth),
+                pPrevHistory, pHistory,
+                halfWidth, halfHeight);
+        });
+
+    struct UpsamplePassData
+    {
+        RGHandle m_inputHistory;
+        RGHandle m_inputHalfDepth;
+        RGHandle m_inputHalfNormal;
+        RGHandle m_inputDepth;
+        RGHandle m_inputNormal;
+        RGHandle m_outputAO;
+    };
+
+    auto upsamplePass = pRenderGraph->AddPass<UpsamplePassData>("GTAO Upsample Pass", RenderPassType::Compute,
+        [&](UpsamplePassData& data, RGBuilder& builder)
+        {
+            data.m_inputHistory = builder.Read(temporalPass->m_outputHistory);
+            data.m_inputHalfDepth = builder.Read(downsamplePass->m_outputDepth);
+            data.m_inputHalfNormal = builder.Read(downsamplePass->m_outputNormal);
+            data.m_inputDepth = builder.Read(depthRT);
+            data.m_inputNormal = builder.Read(normalRT);
+
+            RGTexture::Desc desc;
+            desc.m_width = width;
+            desc.m_height = height;
+            desc.m_format = RHIFormat::R8UI;
+            data.m_outputAO = builder.Create<RGTexture>(desc, "GTAO Upsampled AO");
+            data.m_outputAO = builder.Write(data.m_outputAO);
+        },
+        [=](const UpsamplePassData& data, IRHICommandList* pCommandList)
+        {
+            Upsample(pCommandList, pHistory,
+                pRenderGraph->GetTexture(data.m_inputHalfDepth),
+                pRenderGraph->GetTexture(data.m_inputHalfNormal),
+                pRenderGraph->GetTexture(data.m_inputDepth),
+                pRenderGraph->GetTexture(data.m_inputNormal),
+                pRenderGraph->GetTexture(data.m_outputAO),
+                width, height);
+        });
+
+    return upsamplePass->m_outputAO;
+}
+
 
 void GTAO::CreateHilbertLUT()
 {
@@ -299,5 +482,59 @@ void GTAO::Denoise(IRHICommandList* pCommandList, RGTexture* pInputAO, RGTexture
     pCommandList->Dispatch(DivideRoundingUp(width, XE_GTAO_NUMTHREADS_X * 2), DivideRoundingUp(height, XE_GTAO_NUMTHREADS_Y), 1); //< look at shader, it handle 2 horizon pixel 
 }
 
+void GTAO::Downsample(IRHICommandList* pCommandList, RGTexture* pDepth, RGTexture* pNormal, RGTexture* pHalfDepth, RGTexture* pHalfNormal, uint32_t halfWidth, uint32_t halfHeight)
+{
+    pCommandList->SetPipelineState(m_pDownsamplePSO);
+
+    uint32_t cb[6]
+    {
+        pDepth->GetSRV()->GetHeapIndex(),
+        pNormal->GetSRV()->GetHeapIndex(),
+        pHalfDepth->GetUAV()->GetHeapIndex(),
+        pHalfNormal->GetUAV()->GetHeapIndex(),
+        halfWidth,
+        halfHeight
+    };
+
+    pCommandList->SetComputeConstants(0, cb, sizeof(cb));
+    pCommandList->Dispatch(DivideRoundingUp(halfWidth, 8), DivideRoundingUp(halfHeight, 8), 1);
+}
+
+void GTAO::TemporalAccumulate(IRHICommandList* pCommandList, RGTexture* pHalfAO, RGTexture* pHalfDepth, Texture2D* pPrevHistory, Texture2D* pHistory, uint32_t halfWidth, uint32_t halfHeight)
+{
+    pCommandList->SetPipelineState(m_pTemporalPSO);
+
+    uint32_t cb[6]
+    {
+        pHalfAO->GetSRV()->GetHeapIndex(),
+        pHalfDepth->GetSRV()->GetHeapIndex(),
+        pPrevHistory->GetSRV()->GetHeapIndex(),
+        pHistory->GetUAV()->GetHeapIndex(),
+        halfWidth,
+        halfHeight
+    };
+
+    pCommandList->SetComputeConstants(0, cb, sizeof(cb));
+    pCommandList->Dispatch(DivideRoundingUp(halfWidth, 8), DivideRoundingUp(halfHeight, 8), 1);
+}
+
+void GTAO::Upsample(IRHICommandList* pCommandList, Texture2D* pHistory, RGTexture* pHalfDepth, RGTexture* pHalfNormal, RGTexture* pDepth, RGTexture* pNormal, RGTexture* pOutputAO,
+    uint32_t width, uint32_t height)
+{
+    pCommandList->SetPipelineState(m_pUpsamplePSO);
 
+    uint32_t cb[8]
+    {
+        pHistory->GetSRV()->GetHeapIndex(),
+        pHalfDepth->GetSRV()->GetHeapIndex(),
+        pHalfNormal->GetSRV()->GetHeapIndex(),
+        pDepth->GetSRV()->GetHeapIndex(),
+        pNormal->GetSRV()->GetHeapIndex(),
+        pOutputAO->GetUAV()->GetHeapIndex(),
+        pHistory->GetTexture()->GetDesc().m_width,
+        pHistory->GetTexture()->GetDesc().m_height
+    };
 
+    pCommandList->SetComputeConstants(0, cb, sizeof(cb));
+    pCommandList->Dispatch(DivideRoundingUp(width, 8), DivideRoundingUp(height, 8), 1);
+}
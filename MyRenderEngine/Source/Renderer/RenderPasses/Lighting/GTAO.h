@@ -9,12 +9,22 @@ public:
     RGHandle AddPasse(RenderGraph* pRenderGraph, RGHandle depthRT, RGHandle normalRT, uint32_t width, uint32_t height);
 
 private:
+    RGHandle AddAOPasses(RenderGraph* pRenderGraph, RGHandle depthRT, RGHandle normalRT, uint32_t width, uint32_t height, bool bHalfRes);
+
+    // Prefilter depth, main and denoise at half resolution, accumulated in a reprojected history and upsampled with the depth and the normal
+    RGHandle AddHalfResPasses(RenderGraph* pRenderGraph, RGHandle depthRT, RGHandle normalRT, uint32_t width, uint32_t height);
+
     void CreateHilbertLUT();
     void UpdateGTAOConstants(IRHICommandList* pCommandList, uint32_t width, uint32_t height);
 
     void FilterDepth(IRHICommandList* pCommandList, RGTexture* pDepthTexture, RGTexture* pHZB, uint32_t width, uint32_t height);
     void RenderAO(IRHICommandList* pCommandList, RGTexture* pHZB, RGTexture* pNormal, RGTexture* pOutputAO, RGTexture* pOutputEdge, uint32_t width, uint32_t height);
     void Denoise(IRHICommandList* pCommandList, RGTexture* pInputAO, RGTexture* pEdge, RGTexture* pOutputAO, uint32_t width, uint32_t height);
+
+    void Downsample(IRHICommandList* pCommandList, RGTexture* pDepth, RGTexture* pNormal, RGTexture* pHalfDepth, RGTexture* pHalfNormal, uint32_t halfWidth, uint32_t halfHeight);
+    void TemporalAccumulate(IRHICommandList* pCommandList, RGTexture* pHalfAO, RGTexture* pHalfDepth, Texture2D* pPrevHistory, Texture2D* pHistory, uint32_t halfWidth, uint32_t halfHeight);
+    void Upsample(IRHICommandList* pCommandList, Texture2D* pHistory, RGTexture* pHalfDepth, RGTexture* pHalfNormal, RGTexture* pDepth, RGTexture* pNormal, RGTexture* pOutputAO,
+        uint32_t width, uint32_t height);
     
 private:
     Renderer* m_pRenderer;
@@ -32,8 +42,17 @@ private:
     IRHIPipelineState* m_pGTAOSOUltraPSO = nullptr;
     IRHIPipelineState* m_pSODenoisePSO = nullptr;
 
+    IRHIPipelineState* m_pDownsamplePSO = nullptr;
+    IRHIPipelineState* m_pTemporalPSO = nullptr;
+    IRHIPipelineState* m_pUpsamplePSO = nullptr;
+
     eastl::unique_ptr<Texture2D> m_pHilbertLUT;
 
+    // RG16F of the accumulated AO and frame count at half resolution, ping-ponged every frame
+    eastl::unique_ptr<Texture2D> m_pHistory[2];
+    uint32_t m_historyIndex = 0;            //< Of the history written last
+    uint64_t m_historyFrameID = 0;          //< Frame of the last accumulation, the history is cleared when a frame was skipped
+
     bool m_bEnable = true;
     bool m_bEnableGTSO = false;
     int m_qualityLevel  = 2;
@@ -2,6 +2,7 @@
 #include "Renderer/Renderer.h"
 #include "Renderer/RenderPasses/BasePassGPUDriven.h"
 #include "GTAO.h"
+#include "VirtualShadowMap.h"
 #include "ClusteredLighting/ClusteredLightCulling.h"
 
 LightingPasses::LightingPasses(Renderer* pRenderer)
@@ -10,6 +11,7 @@ LightingPasses::LightingPasses(Renderer* pRenderer)
 
     m_pClusteredLightCulling = eastl::make_unique<ClusteredLightCulling>(m_pRenderer);
     m_pGTAO = eastl::make_unique<GTAO>(m_pRenderer);
+    m_pVirtualShadowMap = eastl::make_unique<VirtualShadowMap>(m_pRenderer);
 }
 
 LightingPasses::~LightingPasses() = default;
@@ -28,6 +30,9 @@ RGHandle LightingPasses::AddPass(RenderGraph* pRenderGraph, RGHandle depthRT, RG
     // AO pass
     RGHandle gtao = m_pGTAO->AddPasse(pRenderGraph, depthRT, normal, width, height);
 
+    // Shadow pass
+    m_shadowMaskRT = m_pVirtualShadowMap->AddPass(pRenderGraph, depthRT, width, height);
+
     // Light culling pass
     
 
@@ -10,9 +10,15 @@ public:
 
     RGHandle AddPass(RenderGraph* pRenderGraph, RGHandle depthRT, RGHandle linearDepthRT, RGHandle velocityRT, uint32_t width, uint32_t height);
 
+    class VirtualShadowMap* GetVirtualShadowMap() const { return m_pVirtualShadowMap.get(); }
+    RGHandle GetShadowMaskRT() const { return m_shadowMaskRT; }
+
 private:
     Renderer* m_pRenderer;
     
     eastl::unique_ptr<class ClusteredLightCulling> m_pClusteredLightCulling;
     eastl::unique_ptr<class GTAO> m_pGTAO;
+    eastl::unique_ptr<class VirtualShadowMap> m_pVirtualShadowMap;
+
+    RGHandle m_shadowMaskRT;
 };
\ No newline at end of file
@@ -0,0 +1,579 @@
+#include "VirtualShadowMap.h"
+#include "Renderer/Renderer.h"
+#include "Renderer/GPUScene.h"
+#include "Core/Engine.h"
+#include "World/DirectionalLight.h"
+#include "Utils/profiler.h"
+#include "EASTL/sort.h"
+
+VirtualShadowMap::VirtualShadowMap(Renderer* pRenderer) : m_cache(VSM_POOL_PAGES * VSM_POOL_PAGES)
+{
+    m_pRenderer = pRenderer;
+
+    RHIGraphicsPipelineDesc clearDesc;
+    clearDesc.m_pVS = pRenderer->GetShader("VirtualShadowMap.hlsl", "vs_clear_page", RHIShaderType::VS);
+    clearDesc.m_depthStencilState.m_depthTest = true;
+    clearDesc.m_depthStencilState.m_depthWrite = true;
+    clearDesc.m_depthStencilState.m_depthFunc = RHICompareFunc::Always;
+    clearDesc.m_depthStencilFromat = RHIFormat::D32F;
+    m_pClearPagePSO = pRenderer->GetPipelineState(clearDesc, "VSM clear page PSO");
+
+    RHIComputePipelineDesc desc;
+    desc.m_pCS = pRenderer->GetShader("VirtualShadowMap.hlsl", "cs_mark_pages", RHIShaderType::CS);
+    m_pMarkPagesPSO = pRenderer->GetPipelineState(desc, "VSM mark pages PSO");
+
+    desc.m_pCS = pRenderer->GetShader("VirtualShadowMap.hlsl", "cs_shadow_mask", RHIShaderType::CS);
+    m_pShadowMaskPSO = pRenderer->GetPipelineState(desc, "VSM shadow mask PSO");
+
+    m_pPhysicalPages.reset(pRenderer->CreateTexture2D(VSM_POOL_PAGES * VSM_PAGE_SIZE, VSM_POOL_PAGES * VSM_PAGE_SIZE, 1, RHIFormat::D32F,
+        RHITextureUsageDepthStencil, "VirtualShadowMap::m_pPhysicalPages"));
+
+    RHIBufferDesc readbackDesc;
+    readbackDesc.m_size = sizeof(uint32_t) * VSM_PAGE_TABLE_SIZE;
+    readbackDesc.m_memoryType = RHIMemoryType::GPUToCPU;
+    for (int i = 0; i < RHI_MAX_INFLIGHT_FRAMES; ++i)
+    {
+        m_pRequestReadbackBuffers[i].reset(pRenderer->GetDevice()->CreateBuffer(readbackDesc, "VirtualShadowMap::m_pRequestReadbackBuffers"));
+    }
+
+    m_pageTable.resize(VSM_PAGE_TABLE_SIZE);
+    m_requestMask.resize(VSM_LEVEL_PAGES * VSM_LEVEL_PAGES);
+    memset(m_views, 0, sizeof(m_views));
+}
+
+RenderBatch& VirtualShadowMap::AddBatch()
+{
+    return m_batches.Add(*m_pRenderer->GetBatchAllocator());
+}
+
+void VirtualShadowMap::Update()
+{
+    CPU_EVENT("Render", "VirtualShadowMap::Update");
+
+    const eastl::vector<RenderBatch>& batches = m_batches.Merge();
+    m_casterBatches.assign(batches.begin(), batches.end());
+    m_batches.Clear();
+
+    m_cache.BeginFrame();
+
+    World* pWorld = Engine::GetInstance()->GetWorld();
+    Camera* pCamera = pWorld->GetCamera();
+    GPUScene* pGPUScene = m_pRenderer->GetGPUScene();
+
+    UpdateDirectionalLight(pCamera->GetPosition());
+    UpdateLocalLights(pCamera->GetPosition(), pCamera->GetFrustumPlanes());
+
+    // Pages under both the old and the new bounds of moved objects are rendered again
+    const eastl::vector<float4>& dirtyBounds = pGPUScene->GetDirtyBounds();
+    InvalidatePages(dirtyBounds);
+    InvalidatePages(m_prevDirtyBounds);
+    m_prevDirtyBounds = dirtyBounds;
+
+    uint32_t frameIndex = m_pRenderer->GetFrameID() % RHI_MAX_INFLIGHT_FRAMES;
+    RequestPages(frameIndex);
+    UploadPageTable(frameIndex);
+    BuildPageDraws();
+
+    MICROPROFILE_COUNTER_SET("Renderer/VirtualShadowMap/RenderedPages", m_cache.GetRenderedPageCount());
+    MICROPROFILE_COUNTER_SET("Renderer/VirtualShadowMap/CachedPages", m_cache.GetResidentPageCount() - m_cache.GetRenderedPageCount());
+    MICROPROFILE_COUNTER_SET("Renderer/VirtualShadowMap/FreePages", m_cache.GetFreePageCount());
+    MICROPROFILE_COUNTER_SET("Renderer/VirtualShadowMap/DirtyPages", m_cache.GetDirtyPageCount());
+    MICROPROFILE_COUNTER_SET("Renderer/VirtualShadowMap/PageDrawBatches", m_pageBatches.size());
+}
+
+void VirtualShadowMap::UpdateDirectionalLight(const float3& cameraPos)
+{
+    DirectionalLight* pLight = dynamic_cast<DirectionalLight*>(Engine::GetInstance()->GetWorld()->GetPrimaryLight());
+    bool bDirectionalLight = m_bEnable && pLight != nullptr;
+
+    float3 lightDir = bDirectionalLight ? -pLight->GetLightDirection() : float3(0.0f, -1.0f, 0.0f);
+    if (m_bDirectionalLight && (!bDirectionalLight || !nearly_equal(lightDir, m_lightDir)))
+    {
+        // Rotating the light changes every page of the clipmap
+        for (uint32_t level = 0; level < VSM_CLIPMAP_LEVELS; ++level)
+        {
+            m_cache.ReleaseView(level);
+        }
+    }
+
+    m_bDirectionalLight = bDirectionalLight;
+    m_lightDir = lightDir;
+
+    for (uint32_t level = 0; level < VSM_CLIPMAP_LEVELS; ++level)
+    {
+        VirtualShadowMapView& view = m_views[level];
+        view.m_mtxPage = GetClipmapPageMatrix(m_lightDir, level);
+        view.m_pageOrigin = GetClipmapPageOrigin(view.m_mtxPage, cameraPos);
+        view.m_pageTableOffset = level * VSM_LEVEL_PAGES * VSM_LEVEL_PAGES;
+        view.m_pageCount = VSM_LEVEL_PAGES;
+    }
+}
+
+void VirtualShadowMap::UpdateLocalLights(const float3& cameraPos, const float4* pFrustumPlanes)
+{
+    const eastl::vector<LocalLightData>& lights = m_pRenderer->GetGPUScene()->GetLocalLights();
+
+    // Nearest lights touching the camera frustum get the slots
+    eastl::vector<eastl::pair<float, uint32_t>> candidates;
+    for (uint32_t i = 0; m_bEnable && i < (uint32_t) lights.size(); ++i)
+    {
+        const LocalLightData& light = lights[i];
+
+        bool bVisible = true;
+        for (uint32_t p = 0; p < 6 && bVisible; ++p)
+        {
+            bVisible = dot(pFrustumPlanes[p].xyz(), light.m_position) + pFrustumPlanes[p].w + light.m_radius >= 0.0f;
+        }
+
+        if (bVisible)
+        {
+            candidates.emplace_back(length(light.m_position - cameraPos), i);
+        }
+    }
+
+    eastl::sort(candidates.begin(), candidates.end());
+    if (candidates.size() > VSM_MAX_LOCAL_LIGHTS)
+    {
+        candidates.resize(VSM_MAX_LOCAL_LIGHTS);
+    }
+
+    auto isCandidate = [&](uint32_t lightIndex)
+    {
+        for (size_t i = 0; i < candidates.size(); ++i)
+        {
+            if (candidates[i].second == lightIndex)
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // Lights keep their slots so their pages stay cached, pages of moved or dropped lights are freed
+    for (uint32_t slot = 0; slot < VSM_MAX_LOCAL_LIGHTS; ++slot)
+    {
+        LocalLightSlot& lightSlot = m_localLightSlots[slot];
+        if (lightSlot.m_lightIndex == VSM_INVALID_LIGHT)
+        {
+            continue;
+        }
+
+        bool bKeep = isCandidate(lightSlot.m_lightIndex);
+        bool bChanged = !bKeep ||
+            !nearly_equal(lights[lightSlot.m_lightIndex].m_position, lightSlot.m_position) ||
+            !nearly_equal(lights[lightSlot.m_lightIndex].m_radius, lightSlot.m_radius);
+
+        if (bChanged)
+        {
+            for (uint32_t face = 0; face < 6; ++face)
+            {
+                m_cache.ReleaseView(VSM_CLIPMAP_LEVELS + slot * 6 + face);
+            }
+        }
+
+        if (!bKeep)
+        {
+            lightSlot.m_lightIndex = VSM_INVALID_LIGHT;
+        }
+    }
+
+    for (size_t i = 0; i < candidates.size(); ++i)
+    {
+        uint32_t lightIndex = candidates[i].second;
+
+        uint32_t freeSlot = VSM_INVALID_LIGHT;
+        bool bAssigned = false;
+        for (uint32_t slot = 0; slot < VSM_MAX_LOCAL_LIGHTS && !bAssigned; ++slot)
+        {
+            bAssigned = m_localLightSlots[slot].m_lightIndex == lightIndex;
+            if (freeSlot == VSM_INVALID_LIGHT && m_localLightSlots[slot].m_lightIndex == VSM_INVALID_LIGHT)
+            {
+                freeSlot = slot;
+            }
+        }
+
+        if (!bAssigned)
+        {
+            MY_ASSERT(freeSlot != VSM_INVALID_LIGHT);
+            m_localLightSlots[freeSlot].m_lightIndex = lightIndex;
+        }
+    }
+
+    for (uint32_t slot = 0; slot < VSM_MAX_LOCAL_LIGHTS; ++slot)
+    {
+        LocalLightSlot& lightSlot = m_localLightSlots[slot];
+        if (lightSlot.m_lightIndex == VSM_INVALID_LIGHT)
+        {
+            continue;
+        }
+
+        lightSlot.m_position = lights[lightSlot.m_lightIndex].m_position;
+        lightSlot.m_radius = lights[lightSlot.m_lightIndex].m_radius;
+
+        for (uint32_t face = 0; face < 6; ++face)
+        {
+            uint32_t viewIndex = slot * 6 + face;
+
+            VirtualShadowMapView& view = m_views[VSM_CLIPMAP_LEVELS + viewIndex];
+            view.m_mtxPage = GetLocalLightPageMatrix(lightSlot.m_position, face);
+            view.m_pageOrigin = int2(0, 0);
+            view.m_pageTableOffset = VSM_LOCAL_LIGHT_PAGE_TABLE_OFFSET + viewIndex * VSM_LOCAL_LIGHT_PAGES * VSM_LOCAL_LIGHT_PAGES;
+            view.m_pageCount = VSM_LOCAL_LIGHT_PAGES;
+        }
+    }
+}
+
+void VirtualShadowMap::InvalidatePages(const eastl::vector<float4>& dirtyBounds)
+{
+    for (size_t i = 0; i < dirtyBounds.size(); ++i)
+    {
+        float3 center = dirtyBounds[i].xyz();
+        float radius = dirtyBounds[i].w;
+
+        int2 pageMin, pageMax;
+        if (m_bDirectionalLight)
+        {
+            for (uint32_t level = 0; level < VSM_CLIPMAP_LEVELS; ++level)
+            {
+                if (GetSpherePageRect(m_views[level].m_mtxPage, m_views[level], false, center, radius, pageMin, pageMax))
+                {
+                    m_cache.InvalidatePages(level, pageMin, pageMax);
+                }
+            }
+        }
+
+        for (uint32_t slot = 0; slot < VSM_MAX_LOCAL_LIGHTS; ++slot)
+        {
+            const LocalLightSlot& lightSlot = m_localLightSlots[slot];
+            if (lightSlot.m_lightIndex == VSM_INVALID_LIGHT || length(center - lightSlot.m_position) > lightSlot.m_radius + radius)
+            {
+                continue;
+            }
+
+            for (uint32_t face = 0; face < 6; ++face)
+            {
+                uint32_t view = VSM_CLIPMAP_LEVELS + slot * 6 + face;
+                if (GetSpherePageRect(m_views[view].m_mtxPage, m_views[view], true, center, radius, pageMin, pageMax))
+                {
+                    m_cache.InvalidatePages(view, pageMin, pageMax);
+                }
+            }
+        }
+    }
+}
+
+void VirtualShadowMap::RequestPages(uint32_t frameIndex)
+{
+    // The GPU is done with the frame which used this slot, it was waited in Renderer::BeginFrame
+    const RequestFrame& requestFrame = m_requestFrames[frameIndex];
+    if (!requestFrame.m_bValid)
+    {
+        return;
+    }
+
+    const uint32_t* pRequests = (const uint32_t*) m_pRequestReadbackBuffers[frameIndex]->GetCPUAddress();
+
+    // Coarse levels first, so a level is there to fall back to when the budget runs out
+    if (m_bDirectionalLight && requestFrame.m_bDirectionalLight && nearly_equal(requestFrame.m_lightDir, m_lightDir))
+    {
+        for (int32_t level = VSM_CLIPMAP_LEVELS - 1; level >= 0; --level)
+        {
+            const VirtualShadowMapView& view = m_views[level];
+            const uint32_t* pLevelRequests = pRequests + level * VSM_LEVEL_PAGES * VSM_LEVEL_PAGES;
+            int2 offset = requestFrame.m_clipmapOrigins[level] - view.m_pageOrigin;
+
+            // Requests are some frames old, the neighbours are requested too for the camera movement since then
+            memset(m_requestMask.data(), 0, m_requestMask.size());
+            for (int32_t y = 0; y < VSM_LEVEL_PAGES; ++y)
+            {
+                for (int32_t x = 0; x < VSM_LEVEL_PAGES; ++x)
+                {
+                    if (pLevelRequests[y * VSM_LEVEL_PAGES + x] == 0)
+                    {
+                        continue;
+                    }
+
+                    for (int32_t dy = -1; dy <= 1; ++dy)
+                    {
+                        for (int32_t dx = -1; dx <= 1; ++dx)
+                        {
+                            int2 page = int2(x + dx, y + dy) + offset;
+                            if (page.x >= 0 && page.y >= 0 && page.x < VSM_LEVEL_PAGES && page.y < VSM_LEVEL_PAGES)
+                            {
+                                m_requestMask[page.y * VSM_LEVEL_PAGES + page.x] = 1;
+                            }
+                        }
+                    }
+                }
+            }
+
+            for (int32_t i = 0; i < VSM_LEVEL_PAGES * VSM_LEVEL_PAGES; ++i)
+            {
+                if (m_requestMask[i])
+                {
+                    m_cache.RequestPage(level, view.m_pageOrigin + int2(i % VSM_LEVEL_PAGES, i / VSM_LEVEL_PAGES));
+                }
+            }
+        }
+    }
+
+    for (uint32_t slot = 0; slot < VSM_MAX_LOCAL_LIGHTS; ++slot)
+    {
+        // Pages of the slot were freed if its light changed since the requests
+        if (m_localLightSlots[slot].m_lightIndex == VSM_INVALID_LIGHT || requestFrame.m_localLights[slot] != m_localLightSlots[slot].m_lightIndex)
+        {
+            continue;
+        }
+
+        for (uint32_t face = 0; face < 6; ++face)
+        {
+            uint32_t view = VSM_CLIPMAP_LEVELS + slot * 6 + face;
+            const uint32_t* pFaceRequests = pRequests + m_views[view].m_pageTableOffset;
+
+            for (int32_t i = 0; i < VSM_LOCAL_LIGHT_PAGES * VSM_LOCAL_LIGHT_PAGES; ++i)
+            {
+                if (pFaceRequests[i])
+                {
+                    m_cache.RequestPage(view, int2(i % VSM_LOCAL_LIGHT_PAGES, i / VSM_LOCAL_LIGHT_PAGES));
+                }
+            }
+        }
+    }
+}
+
+void VirtualShadowMap::UploadPageTable(uint32_t frameIndex)
+{
+    // Every resident page in the windows is mapped, including the ones requested by earlier frames
+    eastl::fill(m_pageTable.begin(), m_pageTable.end(), VSM_INVALID_PAGE);
+
+    if (m_bDirectionalLight)
+    {
+        for (uint32_t level = 0; level < VSM_CLIPMAP_LEVELS; ++level)
+        {
+            const VirtualShadowMapView& view = m_views[level];
+            for (int32_t i = 0; i < VSM_LEVEL_PAGES * VSM_LEVEL_PAGES; ++i)
+            {
+                m_pageTable[view.m_pageTableOffset + i] = m_cache.FindPage(level, view.m_pageOrigin + int2(i % VSM_LEVEL_PAGES, i / VSM_LEVEL_PAGES));
+            }
+        }
+    }
+
+    VirtualShadowMapData data = {};
+    data.m_bDirectionalLight = m_bDirectionalLight;
+    data.m_physicalPagesSRV = m_pPhysicalPages->GetSRV()->GetHeapIndex();
+
+    for (uint32_t slot = 0; slot < VSM_MAX_LOCAL_LIGHTS; ++slot)
+    {
+        uint32_t lightIndex = m_localLightSlots[slot].m_lightIndex;
+        data.m_localLightIndices[slot / 4][slot % 4] = lightIndex;
+
+        if (lightIndex == VSM_INVALID_LIGHT)
+        {
+            continue;
+        }
+
+        data.m_localLightCount = slot + 1;
+
+        for (uint32_t face = 0; face < 6; ++face)
+        {
+            uint32_t view = VSM_CLIPMAP_LEVELS + slot * 6 + face;
+            for (int32_t i = 0; i < VSM_LOCAL_LIGHT_PAGES * VSM_LOCAL_LIGHT_PAGES; ++i)
+            {
+                m_pageTable[m_views[view].m_pageTableOffset + i] = m_cache.FindPage(view, int2(i % VSM_LOCAL_LIGHT_PAGES, i / VSM_LOCAL_LIGHT_PAGES));
+            }
+        }
+    }
+
+    data.m_pageTableAddress = m_pRenderer->AllocateSceneConstant(m_pageTable.data(), sizeof(uint32_t) * VSM_PAGE_TABLE_SIZE);
+    data.m_viewAddress = m_pRenderer->AllocateSceneConstant(m_views, sizeof(m_views));
+    m_dataAddress = m_pRenderer->AllocateSceneConstant(&data, sizeof(data));
+
+    // The requests marked by this frame are read back when the slot comes around again
+    RequestFrame& requestFrame = m_requestFrames[frameIndex];
+    requestFrame.m_bValid = m_bEnable;
+    requestFrame.m_bDirectionalLight = m_bDirectionalLight;
+    requestFrame.m_lightDir = m_lightDir;
+    for (uint32_t level = 0; level < VSM_CLIPMAP_LEVELS; ++level)
+    {
+        requestFrame.m_clipmapOrigins[level] = m_views[level].m_pageOrigin;
+    }
+    for (uint32_t slot = 0; slot < VSM_MAX_LOCAL_LIGHTS; ++slot)
+    {
+        requestFrame.m_localLights[slot] = m_localLightSlots[slot].m_lightIndex;
+    }
+}
+
+void VirtualShadowMap::BuildPageDraws()
+{
+    m_pageDraws.clear();
+    m_pageBatches.clear();
+
+    const eastl::vector<VirtualShadowMapPageRender>& renderList = m_cache.GetRenderList();
+    for (size_t i = 0; i < renderList.size(); ++i)
+    {
+        const VirtualShadowMapPageRender& page = renderList[i];
+
+        PageDraw draw;
+        draw.m_physicalPage = page.m_physicalPage;
+        draw.m_constant.m_mtxViewProjection = GetPageViewProjectionMatrix(m_views[page.m_view].m_mtxPage, page.m_page);
+        GetFrustumPlanes(draw.m_constant.m_mtxViewProjection, draw.m_constant.m_planes);
+        draw.m_firstBatch = (uint32_t) m_pageBatches.size();
+
+        // Local lights have no far plane, casters out of their range are skipped
+        bool bLocalLight = page.m_view >= VSM_CLIPMAP_LEVELS;
+        const LocalLightSlot& lightSlot = m_localLightSlots[bLocalLight ? (page.m_view - VSM_CLIPMAP_LEVELS) / 6 : 0];
+
+        for (uint32_t b = 0; b < (uint32_t) m_casterBatches.size(); ++b)
+        {
+            const RenderBatch& batch = m_casterBatches[b];
+
+            bool bVisible = !bLocalLight || length(batch.m_center - lightSlot.m_position) <= lightSlot.m_radius + batch.m_radius;
+            for (uint32_t p = 0; p < 6 && bVisible; ++p)
+            {
+                bVisible = dot(draw.m_constant.m_planes[p].xyz(), batch.m_center) + draw.m_constant.m_planes[p].w + batch.m_radius >= 0.0f;
+            }
+
+            if (bVisible)
+            {
+                m_pageBatches.push_back(b);
+            }
+        }
+
+        draw.m_batchCount = (uint32_t) m_pageBatches.size() - draw.m_firstBatch;
+        m_pageDraws.push_back(draw);
+    }
+}
+
+RGHandle VirtualShadowMap::AddPass(RenderGraph* pRenderGraph, RGHandle depthRT, uint32_t width, uint32_t height)
+{
+    RENDER_GRAPH_EVENT(pRenderGraph, "Virtual Shadow Map");
+
+    struct RenderPagesPassData
+    {
+        RGHandle m_outPhysicalPages;
+    };
+
+    RGHandle physicalPages = pRenderGraph->Import(m_pPhysicalPages->GetTexture(), RHIAccessDSV);
+
+    auto renderPagesPass = pRenderGraph->AddPass<RenderPagesPassData>("VSM Render Pages", RenderPassType::Graphics,
+        [&](RenderPagesPassData& data, RGBuilder& builder)
+        {
+            // Cached pages are kept, only the pages in the render list are cleared
+            data.m_outPhysicalPages = builder.WriteDepth(physicalPages, 0, RHIRenderPassLoadOp::Load);
+            builder.SkipCulling();
+        },
+        [=](const RenderPagesPassData& data, IRHICommandList* pCommandList)
+        {
+            RenderPages(pCommandList);
+        });
+
+    struct MarkPagesPassData
+    {
+        RGHandle m_inDepthRT;
+        RGHandle m_outRequestBuffer;
+    };
+
+    pRenderGraph->AddPass<MarkPagesPassData>("VSM Mark Pages", RenderPassType::Compute,
+        [&](MarkPagesPassData& data, RGBuilder& builder)
+        {
+            data.m_inDepthRT = builder.Read(depthRT);
+
+            RGBuffer::Desc desc;
+            desc.m_stride = 4;
+            desc.m_size = desc.m_stride * VSM_PAGE_TABLE_SIZE;
+            desc.m_format = RHIFormat::R32UI;
+            desc.m_usage = RHIBufferUsageBit::RHIBufferUsageTypedBuffer;
+            data.m_outRequestBuffer = builder.Create<RGBuffer>(desc, "VSM page requests");
+            data.m_outRequestBuffer = builder.Write(data.m_outRequestBuffer);
+
+            builder.SkipCulling();  //< Consumed by the CPU
+        },
+        [=](const MarkPagesPassData& data, IRHICommandList* pCommandList)
+        {
+            MarkPages(pCommandList, pRenderGraph->GetTexture(data.m_inDepthRT), pRenderGraph->GetBuffer(data.m_outRequestBuffer), width, height);
+        });
+
+    struct ShadowMaskPassData
+    {
+        RGHandle m_inDepthRT;
+        RGHandle m_inPhysicalPages;
+        RGHandle m_outShadowMaskRT;
+    };
+
+    auto shadowMaskPass = pRenderGraph->AddPass<ShadowMaskPassData>("VSM Shadow Mask", RenderPassType::Compute,
+        [&](ShadowMaskPassData& data, RGBuilder& builder)
+        {
+            data.m_inDepthRT = builder.Read(depthRT);
+            data.m_inPhysicalPages = builder.Read(renderPagesPass->m_outPhysicalPages);
+
+            RGTexture::Desc desc;
+            desc.m_width = width;
+            desc.m_height = height;
+            desc.m_format = RHIFormat::R8UNORM;
+            data.m_outShadowMaskRT = builder.Create<RGTexture>(desc, "VSM Shadow Mask");
+            data.m_outShadowMaskRT = builder.Write(data.m_outShadowMaskRT);
+        },
+        [=](const ShadowMaskPassData& data, IRHICommandList* pCommandList)
+        {
+            ShadowMask(pCommandList, pRenderGraph->GetTexture(data.m_inDepthRT), pRenderGraph->GetTexture(data.m_outShadowMaskRT), width, height);
+        });
+
+    // The pool is imported as a depth target every frame
+    pRenderGraph->Present(renderPagesPass->m_outPhysicalPages, RHIAccessDSV);
+
+    return shadowMaskPass->m_outShadowMaskRT;
+}
+
+void VirtualShadowMap::RenderPages(IRHICommandList* pCommandList)
+{
+    for (size_t i = 0; i < m_pageDraws.size(); ++i)
+    {
+        const PageDraw& draw = m_pageDraws[i];
+
+        uint32_t x = draw.m_physicalPage % VSM_POOL_PAGES * VSM_PAGE_SIZE;
+        uint32_t y = draw.m_physicalPage / VSM_POOL_PAGES * VSM_PAGE_SIZE;
+        pCommandList->SetViewport(x, y, VSM_PAGE_SIZE, VSM_PAGE_SIZE);
+        pCommandList->SetScissorRect(x, y, VSM_PAGE_SIZE, VSM_PAGE_SIZE);
+
+        pCommandList->SetPipelineState(m_pClearPagePSO);
+        pCommandList->Draw(3);
+
+        if (draw.m_batchCount == 0)
+        {
+            continue;
+        }
+
+        pCommandList->SetGraphicsConstants(1, &draw.m_constant, sizeof(draw.m_constant));
+
+        for (uint32_t b = 0; b < draw.m_batchCount; ++b)
+        {
+            DrawBatch(pCommandList, m_casterBatches[m_pageBatches[draw.m_firstBatch + b]]);
+        }
+    }
+}
+
+void VirtualShadowMap::MarkPages(IRHICommandList* pCommandList, RGTexture* pDepthRT, RGBuffer* pRequestBuffer, uint32_t width, uint32_t height)
+{
+    uint32_t clearValue[4] = {0, 0, 0, 0};
+    pCommandList->BufferBarrier(pRequestBuffer->GetBuffer(), RHIAccessComputeShaderUAV, RHIAccessClearUAV);
+    pCommandList->ClearUAV(pRequestBuffer->GetBuffer(), pRequestBuffer->GetUAV(), clearValue);
+    pCommandList->BufferBarrier(pRequestBuffer->GetBuffer(), RHIAccessClearUAV, RHIAccessComputeShaderUAV);
+
+    uint32_t cb[2] = {pDepthRT->GetSRV()->GetHeapIndex(), pRequestBuffer->GetUAV()->GetHeapIndex()};
+    pCommandList->SetPipelineState(m_pMarkPagesPSO);
+    pCommandList->SetComputeConstants(0, cb, sizeof(cb));
+    pCommandList->Dispatch(DivideRoundingUp(width, 8), DivideRoundingUp(height, 8), 1);
+
+    uint32_t frameIndex = m_pRenderer->GetFrameID() % RHI_MAX_INFLIGHT_FRAMES;
+    pCommandList->BufferBarrier(pRequestBuffer->GetBuffer(), RHIAccessComputeShaderUAV, RHIAccessCopySrc);
+    pCommandList->CopyBuffer(m_pRequestReadbackBuffers[frameIndex].get(), 0, pRequestBuffer->GetBuffer(), 0, sizeof(uint32_t) * VSM_PAGE_TABLE_SIZE);
+    pCommandList->BufferBarrier(pRequestBuffer->GetBuffer(), RHIAccessCopySrc, RHIAccessComputeShaderUAV);
+}
+
+void VirtualShadowMap::ShadowMask(IRHICommandList* pCommandList, RGTexture* pDepthRT, RGTexture* pOutputRT, uint32_t width, uint32_t height)
+{
+    uint32_t cb[2] = {pDepthRT->GetSRV()->GetHeapIndex(), pOutputRT->GetUAV()->GetHeapIndex()};
+    pCommandList->SetPipelineState(m_pShadowMaskPSO);
+    pCommandList->SetComputeConstants(0, cb, sizeof(cb));
+    pCommandList->Dispatch(DivideRoundingUp(width, 8), DivideRoundingUp(height, 8), 1);
+}
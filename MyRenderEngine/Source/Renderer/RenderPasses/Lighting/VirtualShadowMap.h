@@ -0,0 +1,91 @@
+#pragma once
+#include "../../RenderGraph/RenderGraph.h"
+#include "../../Resource/Texture2D.h"
+#include "../../RenderBatch.h"
+#include "../../VirtualShadowMapCache.h"
+
+// Clipmap of the primary directional light and cube maps of the nearest local lights, paged into one depth pool.
+// Pages are requested by the depth buffer, read back and allocated on CPU, and stay cached until geometry moves over them
+class VirtualShadowMap
+{
+public:
+    VirtualShadowMap(Renderer* pRenderer);
+
+    // Shadow casters, can be added from any task scheduler thread
+    RenderBatch& AddBatch();
+
+    // Allocates the requested pages and uploads the page table, before the render graph is built
+    void Update();
+
+    // Renders the allocated pages and returns the shadow mask of the primary directional light
+    RGHandle AddPass(RenderGraph* pRenderGraph, RGHandle depthRT, uint32_t width, uint32_t height);
+
+    uint32_t GetDataAddress() const { return m_dataAddress; }
+    const VirtualShadowMapCache& GetCache() const { return m_cache; }
+
+private:
+    void UpdateDirectionalLight(const float3& cameraPos);
+    void UpdateLocalLights(const float3& cameraPos, const float4* pFrustumPlanes);
+    void InvalidatePages(const eastl::vector<float4>& dirtyBounds);
+    void RequestPages(uint32_t frameIndex);
+    void UploadPageTable(uint32_t frameIndex);
+    void BuildPageDraws();
+
+    void RenderPages(IRHICommandList* pCommandList);
+    void MarkPages(IRHICommandList* pCommandList, RGTexture* pDepthRT, RGBuffer* pRequestBuffer, uint32_t width, uint32_t height);
+    void ShadowMask(IRHICommandList* pCommandList, RGTexture* pDepthRT, RGTexture* pOutputRT, uint32_t width, uint32_t height);
+
+private:
+    struct LocalLightSlot
+    {
+        uint32_t m_lightIndex = VSM_INVALID_LIGHT;
+        float3 m_position;
+        float m_radius = 0.0f;
+    };
+
+    // What the page requests of a frame were marked against, they are read back RHI_MAX_INFLIGHT_FRAMES frames later
+    struct RequestFrame
+    {
+        bool m_bValid = false;
+        bool m_bDirectionalLight = false;
+        float3 m_lightDir;
+        int2 m_clipmapOrigins[VSM_CLIPMAP_LEVELS];
+        uint32_t m_localLights[VSM_MAX_LOCAL_LIGHTS];
+    };
+
+    struct PageDraw
+    {
+        uint32_t m_physicalPage;
+        VirtualShadowMapPageConstant m_constant;
+        uint32_t m_firstBatch;  //< In m_pageBatches
+        uint32_t m_batchCount;
+    };
+
+    Renderer* m_pRenderer;
+
+    IRHIPipelineState* m_pClearPagePSO = nullptr;
+    IRHIPipelineState* m_pMarkPagesPSO = nullptr;
+    IRHIPipelineState* m_pShadowMaskPSO = nullptr;
+
+    VirtualShadowMapCache m_cache;
+    eastl::unique_ptr<Texture2D> m_pPhysicalPages;
+    eastl::unique_ptr<IRHIBuffer> m_pRequestReadbackBuffers[RHI_MAX_INFLIGHT_FRAMES];
+    RequestFrame m_requestFrames[RHI_MAX_INFLIGHT_FRAMES];
+
+    RenderBatchList<RenderBatch> m_batches;
+    eastl::vector<RenderBatch> m_casterBatches;
+    eastl::vector<PageDraw> m_pageDraws;
+    eastl::vector<uint32_t> m_pageBatches;
+
+    VirtualShadowMapView m_views[VSM_MAX_VIEWS];
+    bool m_bDirectionalLight = false;
+    float3 m_lightDir;      //< Direction the light travels
+    LocalLightSlot m_localLightSlots[VSM_MAX_LOCAL_LIGHTS];
+
+    eastl::vector<float4> m_prevDirtyBounds;    //< Where the moved objects were in the last frame
+    eastl::vector<uint32_t> m_pageTable;
+    eastl::vector<uint8_t> m_requestMask;
+    uint32_t m_dataAddress = 0;
+
+    bool m_bEnable = true;
+};
@@ -7,10 +7,13 @@
 #include "RenderPasses/HierarchicalDepthBufferPass.h"
 #include "RenderPasses/BasePassGPUDriven.h"
 #include "RenderPasses/Lighting/LightingPasses.h"
+#include "RenderPasses/Lighting/VirtualShadowMap.h"
 #include "PipelineCache.h"
 #include "Core/Engine.h"
 #include "Utils/profiler.h"
 #include "Utils/log.h"
+#include "sokol/sokol_time.h"
+#include <thread>
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb/stb_image_write.h"
@@ -21,7 +24,7 @@ Renderer::Renderer()
     m_pShaderCache = eastl::make_unique<ShaderCache>(this);
     m_pShaderCompiler = eastl::make_unique<ShaderCompiler>(this);
     m_pPipelineCache = eastl::make_unique<PipelineStateCache>(this);
-    m_pCBAllocator = eastl::make_unique<LinearAllocator>(8 * 1024 * 1024); // 8 MB for constant buffer
+    m_pBatchAllocator = eastl::make_unique<FrameAllocator>(Engine::GetInstance()->GetTaskScheduler(), 1 * 1024 * 1024); // 1 MB packet arena per thread
 
     Engine::GetInstance()->WindowResizeSignal.connect(&Renderer::OnWindowResize, this);
 }
@@ -53,6 +56,8 @@ bool Renderer::CreateDevice(void* windowHandle, uint32_t windowWidth, uint32_t w
         return false;
     }
 
+    m_pResourcePool = eastl::make_unique<ResourcePool>(m_pDevice.get());
+
     RHISwapChainDesc swapChainDesc = {};
     swapChainDesc.m_windowHandle = windowHandle;
     swapChainDesc.m_width = windowWidth;
@@ -82,6 +87,9 @@ bool Renderer::CreateDevice(void* windowHandle, uint32_t windowWidth, uint32_t w
     }
 
 
+    m_pFrameTrace = eastl::make_unique<FrameTrace>(m_pDevice.get());
+    m_pFramePacer = eastl::make_unique<FramePacer>();
+
     CreateCommonResources();
     m_pRenderGraph = eastl::make_unique<RenderGraph>(this);   
     m_pGPUScene = eastl::make_unique<GPUScene>(this);
@@ -97,8 +105,14 @@ void Renderer::RenderFrame()
 {
     CPU_EVENT("Render", "Renderer::RenderFrame");
     BeginFrame();
-    UploadResources();
-    Render();
+    {
+        FrameTraceScope scope(m_pFrameTrace.get(), "Renderer::UploadResources");
+        UploadResources();
+    }
+    {
+        FrameTraceScope scope(m_pFrameTrace.get(), "Renderer::Render");
+        Render();
+    }
     EndFrame();
 
     // MouseHitTest();
@@ -109,6 +123,46 @@ void Renderer::WaitGPUFinished()
     m_pFrameFence->Wait(m_currentFrameFenceValue);
 }
 
+void Renderer::PaceFrame()
+{
+    CPU_EVENT("Render", "Renderer::PaceFrame");
+
+    uint64_t frameID = m_pDevice->GetFrameID();
+    uint64_t startTime = stm_now();
+
+    // The slot of frame N - m_framesInFlight, its fence value is still there as slots are reused every RHI_MAX_INFLIGHT_FRAMES frames
+    if (frameID >= m_framesInFlight)
+    {
+        CPU_EVENT("Render", "IRHIFence::Wait");
+        m_pFrameFence->Wait(m_frameFenceValue[(frameID - m_framesInFlight) % RHI_MAX_INFLIGHT_FRAMES]);
+    }
+    double fenceWaitUs = stm_us(stm_since(startTime));
+
+    double delayUs = m_pFramePacer->GetDelay(stm_us(stm_now()));
+    if (delayUs > 0.0)
+    {
+        CPU_EVENT("Render", "FramePacer::Delay");
+
+        // Sleeping overshoots by up to a scheduler tick, the last millisecond is spun
+        uint64_t endTime = stm_now() + (uint64_t) (delayUs * 1000.0);
+        if (delayUs > 1000.0)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds((int64_t) delayUs - 1000));
+        }
+        while (stm_now() < endTime)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    m_pFramePacer->BeginFrame(frameID, stm_us(stm_now()), delayUs, fenceWaitUs);
+}
+
+void Renderer::SetFramesInFlight(uint32_t count)
+{
+    m_framesInFlight = clamp(count, 1u, RHI_MAX_INFLIGHT_FRAMES);
+}
+
 void Renderer::SetTemporalUpscaleRatio(float ratio)
 {
     if (!nearly_equal(m_upscaleRatio, ratio))
@@ -172,7 +226,7 @@ IndexBuffer* Renderer::CreateIndexBuffer(const void* pData, uint32_t stride, uin
 
     if (pData)
     {
-        UploadBuffer(pBuffer->GetBuffer(), 0, pData, stride * indexCount);
+        UploadBuffer(pBuffer->GetBuffer(), pBuffer->GetBufferOffset(), pData, stride * indexCount);
     }
 
     return pBuffer;
@@ -189,7 +243,7 @@ StructedBuffer* Renderer::CreateStructedBuffer(const void* pData, uint32_t strid
 
     if (pData)
     {
-        UploadBuffer(pBuffer->GetBuffer(), 0, pData, stride * elementCount);
+        UploadBuffer(pBuffer->GetBuffer(), pBuffer->GetBufferOffset(), pData, stride * elementCount);
     }
 
     return pBuffer;
@@ -206,7 +260,7 @@ TypedBuffer* Renderer::CreateTypedBuffer(const void* pData, RHIFormat format, ui
 
     if (pData)
     {
-        UploadBuffer(pBuffer->GetBuffer(), 0, pData, GetFormatRowPitch(format, 1) * elementCount);
+        UploadBuffer(pBuffer->GetBuffer(), pBuffer->GetBufferOffset(), pData, GetFormatRowPitch(format, 1) * elementCount);
     }
 
     return pBuffer;
@@ -223,7 +277,7 @@ RawBuffer* Renderer::CreateRawBuffer(const void* pData, uint32_t size, const eas
 
     if (pData)
     {
-        UploadBuffer(pBuffer->GetBuffer(), 0, pData, size);
+        UploadBuffer(pBuffer->GetBuffer(), pBuffer->GetBufferOffset(), pData, size);
     }
 
     return pBuffer;
@@ -232,7 +286,8 @@ RawBuffer* Renderer::CreateRawBuffer(const void* pData, uint32_t size, const eas
 Texture2D* Renderer::CreateTexture2D(const eastl::string& file, bool srgb)
 {
     TextureLoader loader;
-    if (!loader.Load(file, srgb))
+    bool bStreamed = loader.LoadHeader(file, srgb);
+    if (!bStreamed && !loader.Load(file, srgb))
     {
         return nullptr;
     }
@@ -244,7 +299,18 @@ Texture2D* Renderer::CreateTexture2D(const eastl::string& file, bool srgb)
         return nullptr;
     }
 
-    UploadTexture(pTexture->GetTexture(), loader.GetData());
+    if (bStreamed)
+    {
+        if (UploadTexture(pTexture->GetTexture(), file, loader.GetDataOffset()) == 0)
+        {
+            delete pTexture;
+            return nullptr;
+        }
+    }
+    else
+    {
+        UploadTexture(pTexture->GetTexture(), loader.GetData());
+    }
     return pTexture;
 }
 
@@ -263,7 +329,8 @@ Texture2D* Renderer::CreateTexture2D(uint32_t width, uint32_t height, uint32_t l
 Texture3D* Renderer::CreateTexture3D(const eastl::string& file, bool srgb)
 {
     TextureLoader loader;
-    if (!loader.Load(file, srgb))
+    bool bStreamed = loader.LoadHeader(file, srgb);
+    if (!bStreamed && !loader.Load(file, srgb))
     {
         return nullptr;
     }
@@ -275,7 +342,18 @@ Texture3D* Renderer::CreateTexture3D(const eastl::string& file, bool srgb)
         return nullptr;
     }
 
-    UploadTexture(pTexture->GetTexture(), loader.GetData());
+    if (bStreamed)
+    {
+        if (UploadTexture(pTexture->GetTexture(), file, loader.GetDataOffset()) == 0)
+        {
+            delete pTexture;
+            return nullptr;
+        }
+    }
+    else
+    {
+        UploadTexture(pTexture->GetTexture(), loader.GetData());
+    }
     return pTexture;
 }
 
@@ -294,7 +372,8 @@ Texture3D* Renderer::CreateTexture3D(uint32_t width, uint32_t height, uint32_t d
 TextureCube* Renderer::CreateTextureCube(const eastl::string& file, bool srgb)
 {
     TextureLoader loader;
-    if (!loader.Load(file, srgb))
+    bool bStreamed = loader.LoadHeader(file, srgb);
+    if (!bStreamed && !loader.Load(file, srgb))
     {
         return nullptr;
     }
@@ -306,7 +385,18 @@ TextureCube* Renderer::CreateTextureCube(const eastl::string& file, bool srgb)
         return nullptr;
     }
 
-    UploadTexture(pTexture->GetTexture(), loader.GetData());
+    if (bStreamed)
+    {
+        if (UploadTexture(pTexture->GetTexture(), file, loader.GetDataOffset()) == 0)
+        {
+            delete pTexture;
+            return nullptr;
+        }
+    }
+    else
+    {
+        UploadTexture(pTexture->GetTexture(), loader.GetData());
+    }
     return pTexture;
 }
 
@@ -434,6 +524,16 @@ uint32_t Renderer::AddLocalLight(const LocalLightData& data)
     return m_pGPUScene->AddLocalLight(data);
 }
 
+uint32_t Renderer::UpdateMaterial(uint32_t index, const ModelMaterialConstant& data)
+{
+    return m_pGPUScene->UpdateMaterial(index, data);
+}
+
+void Renderer::ReleaseMaterial(uint32_t index)
+{
+    m_pGPUScene->ReleaseMaterial(index);
+}
+
 void Renderer::RequestMouseHitTest(uint32_t x, uint32_t y)
 {
     m_mouseX = x;
@@ -441,24 +541,72 @@ void Renderer::RequestMouseHitTest(uint32_t x, uint32_t y)
     m_enableObjectIDRendering = true;
 }
 
-inline void ImageCopy(char* pDstData, uint32_t dstRowPitch, char* pSrcData, uint32_t srcRowPitch, uint32_t rowNum, uint32_t d)
+#define UPLOAD_BUFFER_ROW_SIZE (64 * 1024)    //< Buffers are split into rows, so large ones are filled by several tasks
+
+uint64_t Renderer::UploadTexture(IRHITexture* pTexture, const void* pData)
+{
+    eastl::vector<StagingFillRegion> regions;
+    AllocateTextureUpload(pTexture, 0, regions);
+
+    StagingFill::FromMemory(Engine::GetInstance()->GetTaskScheduler(), regions, pData);
+    return m_currentUploadFenceValue + 1;
+}
+
+uint64_t Renderer::UploadTexture(IRHITexture* pTexture, const eastl::string& file, uint64_t fileOffset)
 {
-    uint32_t srcSliceSize = srcRowPitch * rowNum;
-    uint32_t dstSliceSize = dstRowPitch * rowNum;
+    size_t uploadCount = m_pendingTextureUploads.size();
 
-    for (uint32_t z = 0; z < d; ++z)
+    eastl::vector<StagingFillRegion> regions;
+    AllocateTextureUpload(pTexture, fileOffset, regions);
+
+    if (!StagingFill::FromFile(Engine::GetInstance()->GetTaskScheduler(), regions, file))
     {
-        char* pDstSlice = pDstData + dstSliceSize * z;
-        char* pSrcSlice = pSrcData + srcSliceSize * z;
+        MY_ERROR("[Renderer::UploadTexture] failed to read {}", file);
 
-        for (uint32_t row = 0; row < rowNum; ++row)
-        {
-            memcpy(pDstSlice + dstRowPitch * row, pSrcSlice + srcRowPitch * row, srcRowPitch);
-        }
+        // Nothing is copied from the partly filled staging memory, it is recycled with the frame
+        m_pendingTextureUploads.resize(uploadCount);
+        return 0;
     }
+    return m_currentUploadFenceValue + 1;
+}
+
+uint64_t Renderer::UploadTexture(IRHITexture* pTexture, const StagingFillDecoder& decoder)
+{
+    eastl::vector<StagingFillRegion> regions;
+    AllocateTextureUpload(pTexture, 0, regions);
+
+    StagingFill::FromDecoder(Engine::GetInstance()->GetTaskScheduler(), regions, decoder);
+    return m_currentUploadFenceValue + 1;
 }
 
-void Renderer::UploadTexture(IRHITexture* pTexture, const void* pData)
+uint64_t Renderer::UploadBuffer(IRHIBuffer* pBuffer, uint32_t offset, const void* pData, uint32_t dataSize)
+{
+    eastl::vector<StagingFillRegion> regions;
+    AllocateBufferUpload(pBuffer, offset, 0, dataSize, regions);
+
+    StagingFill::FromMemory(Engine::GetInstance()->GetTaskScheduler(), regions, pData);
+    return m_currentUploadFenceValue + 1;
+}
+
+uint64_t Renderer::UploadBuffer(IRHIBuffer* pBuffer, uint32_t offset, const eastl::string& file, uint64_t fileOffset, uint32_t dataSize)
+{
+    size_t uploadCount = m_pendingBufferUploads.size();
+
+    eastl::vector<StagingFillRegion> regions;
+    AllocateBufferUpload(pBuffer, offset, fileOffset, dataSize, regions);
+
+    if (!StagingFill::FromFile(Engine::GetInstance()->GetTaskScheduler(), regions, file))
+    {
+        MY_ERROR("[Renderer::UploadBuffer] failed to read {}", file);
+
+        // Nothing is copied from the partly filled staging memory, it is recycled with the frame
+        m_pendingBufferUploads.resize(uploadCount);
+        return 0;
+    }
+    return m_currentUploadFenceValue + 1;
+}
+
+void Renderer::AllocateTextureUpload(IRHITexture* pTexture, uint64_t srcOffset, eastl::vector<StagingFillRegion>& regions)
 {
     uint32_t frameIndex = m_pDevice->GetFrameID() % RHI_MAX_INFLIGHT_FRAMES;
     StagingBufferAllocator* pAllocator = m_pStagingBufferAllocator[frameIndex].get();
@@ -469,7 +617,6 @@ void Renderer::UploadTexture(IRHITexture* pTexture, const void* pData)
     const RHITextureDesc& desc = pTexture->GetDesc();
     char* pDstData = (char*)buffer.m_pBuffer->GetCPUAddress() + buffer.m_offset;
     uint32_t dstOffset = 0;
-    uint32_t srcOffset = 0;
 
     for (uint32_t slice = 0; slice < desc.m_arraySize; ++slice)
     {
@@ -486,7 +633,13 @@ void Renderer::UploadTexture(IRHITexture* pTexture, const void* pData)
             uint32_t dstRowPitch = pTexture->GetRowPitch(mip);
             uint32_t rowNum = h / GetFormatBlockHeight(desc.m_format);
 
-            ImageCopy(pDstData + dstOffset, dstRowPitch, (char*)pData + srcOffset, srcRowPitch, rowNum, d);
+            StagingFillRegion region;
+            region.m_pDstData = pDstData + dstOffset;
+            region.m_dstRowPitch = dstRowPitch;
+            region.m_srcRowPitch = srcRowPitch;
+            region.m_rowNum = rowNum * d;
+            region.m_srcOffset = srcOffset;
+            regions.push_back(region);
 
             TextureUpload upload;
             upload.m_pTexture = pTexture;
@@ -499,18 +652,28 @@ void Renderer::UploadTexture(IRHITexture* pTexture, const void* pData)
             dstOffset += RoundUpPow2(dstRowPitch * rowNum, 512);    //< 512 : D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT
             srcOffset += srcRowPitch * rowNum;
         }
-    }   
+    }
 }
 
-void Renderer::UploadBuffer(IRHIBuffer* pBuffer, uint32_t offset, const void* pData, uint32_t dataSize)
+void Renderer::AllocateBufferUpload(IRHIBuffer* pBuffer, uint32_t offset, uint64_t srcOffset, uint32_t dataSize, eastl::vector<StagingFillRegion>& regions)
 {
     uint32_t frameIndex = m_pDevice->GetFrameID() % RHI_MAX_INFLIGHT_FRAMES;
     StagingBufferAllocator* pAllocator = m_pStagingBufferAllocator[frameIndex].get();
 
     StagingBuffer stagingBuffer = pAllocator->Allocate(dataSize);
-
     char* pDstData = (char*) stagingBuffer.m_pBuffer->GetCPUAddress() + stagingBuffer.m_offset;
-    memcpy(pDstData, pData, dataSize);
+
+    uint32_t rowNum = dataSize / UPLOAD_BUFFER_ROW_SIZE;
+    uint32_t tailSize = dataSize % UPLOAD_BUFFER_ROW_SIZE;
+    if (rowNum > 0)
+    {
+        regions.push_back({ pDstData, UPLOAD_BUFFER_ROW_SIZE, UPLOAD_BUFFER_ROW_SIZE, rowNum, srcOffset });
+    }
+    if (tailSize > 0)
+    {
+        uint32_t tailOffset = rowNum * UPLOAD_BUFFER_ROW_SIZE;
+        regions.push_back({ pDstData + tailOffset, tailSize, tailSize, 1, srcOffset + tailOffset });
+    }
 
     BufferUpload upload;
     upload.m_pBuffer = pBuffer;
@@ -534,6 +697,11 @@ RenderBatch& Renderer::AddGPUDrivenBasePassBatch()
     return m_pBasePassGPUDriven->AddBatch();
 }
 
+RenderBatch& Renderer::AddShadowPassBatch()
+{
+    return m_pLightingPasses->GetVirtualShadowMap()->AddBatch();
+}
+
 void Renderer::SetupGlobalConstants(IRHICommandList* pCommandList)
 {
     World* pWorld = Engine::GetInstance()->GetWorld();
@@ -569,6 +737,11 @@ void Renderer::SetupGlobalConstants(IRHICommandList* pCommandList)
     sceneCB.m_secondPhaseMeshletsCounterUAV = RHI_INVALID_RESOURCE;//pOcclusionCulledMeshletCounterBuffer->GetUAV()->GetHeapIndex();
     sceneCB.m_lightDir = float3(0.0f, -1.0f, 0.0f);
     sceneCB.m_lightColor = float3(1.0f, 1.0f, 1.0f);
+    if (ILight* pPrimaryLight = pWorld->GetPrimaryLight())
+    {
+        sceneCB.m_lightDir = pPrimaryLight->GetLightDirection();
+        sceneCB.m_lightColor = pPrimaryLight->GetLightColor() * pPrimaryLight->GetLightIntensity();
+    }
     sceneCB.m_lightRadius = 1.0f;
     sceneCB.m_renderSize = uint2(m_renderWidth, m_renderHeight);
     sceneCB.m_rcpRenderSize = float2(1.0f/ m_renderWidth, 1.0f / m_renderHeight);
@@ -620,6 +793,8 @@ void Renderer::SetupGlobalConstants(IRHICommandList* pCommandList)
     sceneCB.m_marschnerTextureN = RHI_INVALID_RESOURCE;
     sceneCB.m_localLightDataAddress = m_pGPUScene->GetLocalLightsDataAddress();
     sceneCB.m_localLightCount = m_pGPUScene->GetLocalLightCount();
+    sceneCB.m_materialDataAddress = m_pGPUScene->GetMaterialDataAddress();
+    sceneCB.m_virtualShadowMapDataAddress = m_pLightingPasses->GetVirtualShadowMap()->GetDataAddress();
 
     if (pCommandList->GetQueue() == RHICommandQueue::Graphics)
     {
@@ -749,12 +924,43 @@ void Renderer::BeginFrame()
 {
     CPU_EVENT("Render", "Renderer::BeginFrame");
 
+    // Resources of the frame slot are reused, usually waited in PaceFrame already
     uint32_t frameIndex = m_pDevice->GetFrameID() % RHI_MAX_INFLIGHT_FRAMES;
     {
         CPU_EVENT("Render", "IRHIFence::Wait");
         m_pFrameFence->Wait(m_frameFenceValue[frameIndex]);
     }
     m_pDevice->BeginFrame();
+    m_pFrameTrace->BeginFrame();     //< Before the command lists of the frame are reset, their timestamps are read back
+
+    const FrameTraceGPUSpan& gpuSpan = m_pFrameTrace->GetResolvedGPUSpan();
+    FrameLatency latency;
+    if (gpuSpan.m_bValid && m_pFramePacer->ResolveFrame(gpuSpan.m_frameID, gpuSpan.m_beginUs, gpuSpan.m_endUs, latency))
+    {
+        MICROPROFILE_COUNTER_SET("Renderer/FramePacing/DelayUs", (int64_t) latency.m_delayUs);
+        MICROPROFILE_COUNTER_SET("Renderer/FramePacing/FenceWaitUs", (int64_t) latency.m_fenceWaitUs);
+        MICROPROFILE_COUNTER_SET("Renderer/FramePacing/CPUUs", (int64_t) latency.m_cpuUs);
+        MICROPROFILE_COUNTER_SET("Renderer/FramePacing/QueueUs", (int64_t) latency.m_queueUs);
+        MICROPROFILE_COUNTER_SET("Renderer/FramePacing/GPUUs", (int64_t) latency.m_gpuUs);
+        MICROPROFILE_COUNTER_SET("Renderer/FramePacing/StarvedUs", (int64_t) latency.m_starvedUs);
+        MICROPROFILE_COUNTER_SET("Renderer/FramePacing/LatencyUs", (int64_t) latency.m_totalUs);
+
+        if (m_bLogFrameLatency)
+        {
+            MY_INFO("Frame {} latency {:.2f} ms : delay {:.2f}, fence wait {:.2f}, cpu {:.2f}, queue {:.2f}, gpu {:.2f}, gpu starved {:.2f}",
+                latency.m_frameID, latency.m_totalUs / 1000.0f, latency.m_delayUs / 1000.0f, latency.m_fenceWaitUs / 1000.0f,
+                latency.m_cpuUs / 1000.0f, latency.m_queueUs / 1000.0f, latency.m_gpuUs / 1000.0f, latency.m_starvedUs / 1000.0f);
+        }
+    }
+
+    // Pooled ranges freed in frame N are recycled when frame N + RHI_MAX_INFLIGHT_FRAMES begins, as the RHI deletions
+    uint64_t frameID = m_pDevice->GetFrameID();
+    if (frameID >= RHI_MAX_INFLIGHT_FRAMES)
+    {
+        m_pResourcePool->ProcessDeferredFrees(frameID - RHI_MAX_INFLIGHT_FRAMES);
+        ProcessAnimationReadbacks(frameID - RHI_MAX_INFLIGHT_FRAMES);
+        m_pBasePassGPUDriven->ProcessMeshletListReadback(frameID - RHI_MAX_INFLIGHT_FRAMES);
+    }
 
     IRHICommandList* pCommandList = m_pCommandLists[frameIndex].get();
     pCommandList->ResetAllocator();
@@ -771,6 +977,9 @@ void Renderer::UploadResources()
 {
     CPU_EVENT("Render", "Renderer::UploadResources");
 
+    // Materials changed in this frame are copied with the other uploads, before the frame reads them
+    m_pGPUScene->UploadMaterials();
+
     if (m_pendingTextureUploads.empty() && m_pendingBufferUploads.empty())
     {
         return;
@@ -780,6 +989,7 @@ void Renderer::UploadResources()
     IRHICommandList* pUploadCommandList = m_pUploadCommandLists[frameIndex].get();
     pUploadCommandList->ResetAllocator();
     pUploadCommandList->Begin();
+    uint32_t gpuEvent = m_pFrameTrace->BeginGPUEvent(pUploadCommandList, "Renderer::UploadResources");
 
     {
         GPU_EVENT_DEBUG(pUploadCommandList, "Renderer::UplaodResources");
@@ -800,6 +1010,7 @@ void Renderer::UploadResources()
         m_pendingBufferUploads.clear();
     }
 
+    m_pFrameTrace->EndGPUEvent(pUploadCommandList, gpuEvent);
     pUploadCommandList->End();
     pUploadCommandList->Signal(m_pUploadFence.get(), ++ m_currentUploadFenceValue);
     pUploadCommandList->Submit();
@@ -829,6 +1040,7 @@ void Renderer::Render()
 
     m_pRenderGraph->Clear();
     m_pGPUScene->Update();
+    m_pLightingPasses->GetVirtualShadowMap()->Update();
 
     // ImportPrevFrameTextures();
 
@@ -842,6 +1054,7 @@ void Renderer::Render()
 
     SetupGlobalConstants(pCommandList);
     //FlushComputePass(pCommandList);
+    AnimationPass(pCommandList);
     BuildRayTracingAS(pCommandList, pComputeCommandList);
 
     // m_pSkyyCubeMap->Update();
@@ -884,7 +1097,7 @@ void Renderer::BuildRenderGraph(RGHandle& outColor, RGHandle& outDepth)
 
 
 
-    RGHandle sceneDiffuseRT = gtao;//m_pBasePassGPUDriven->GetNormalRT();
+    RGHandle sceneDiffuseRT = m_outputType == RendererOutput::Shadow ? m_pLightingPasses->GetShadowMaskRT() : gtao;//m_pBasePassGPUDriven->GetNormalRT();
     RGHandle showCulledDiffuseRT = m_pBasePassGPUDriven->GetCulledObjectsDiffuseRT();
     
     
@@ -919,20 +1132,38 @@ void Renderer::EndFrame()
     pCommandList->Signal(m_pFrameFence.get(), m_currentFrameFenceValue);
     pCommandList->Submit();
     pCommandList->EndProfiling(); 
+    m_pFramePacer->SubmitFrame(m_pDevice->GetFrameID(), stm_us(stm_now()));
     /* {
         CPU_EVENT("Render", "IRHISwapchain::Present");
         m_pSwapChain->Present();
     }*/
 
+    MICROPROFILE_COUNTER_SET("Renderer/RenderBatch/PacketBytes", m_pBatchAllocator->GetAllocatedSize());
+    MICROPROFILE_COUNTER_SET("Renderer/RenderBatch/BatchBytes", sizeof(RenderBatch) * (m_BaseBatchs.GetCount() + m_forwardPassBatchs.GetCount() +
+        m_velocityPassBatchs.GetCount() + m_idPassBatchs.GetCount() + m_guiBatchs.GetCount()) + sizeof(ComputeBatch) * m_animationBatchs.GetCount());
+
     m_pStagingBufferAllocator[frameIndex]->Reset();
-    m_pCBAllocator->Reset();
+    m_pBatchAllocator->Reset();
     m_pGPUScene->ResetFrameData();
 
-    m_BaseBatchs.clear();
-    m_animationBatchs.clear();
-    m_velocityPassBatchs.clear();
-    m_idPassBatchs.clear();
-    m_guiBatchs.clear();
+    MICROPROFILE_COUNTER_SET("Renderer/RenderBatch/PacketHighWaterMark", m_pBatchAllocator->GetHighWaterMark());
+    MICROPROFILE_COUNTER_SET("Renderer/RenderBatch/SharedArenaContention", m_pBatchAllocator->GetContentionCount());
+
+    eastl::vector<ResourcePoolStats> poolStats;
+    m_pResourcePool->GetStats(poolStats);
+    MICROPROFILE_COUNTER_SET("Renderer/ResourcePool/BufferCount", poolStats[0].m_resourceCount);
+    MICROPROFILE_COUNTER_SET("Renderer/ResourcePool/BufferSavedBytes", poolStats[0].GetSavedBytes());
+    MICROPROFILE_COUNTER_SET("Renderer/ResourcePool/TextureCount", poolStats[1].m_resourceCount);
+    MICROPROFILE_COUNTER_SET("Renderer/ResourcePool/TextureSavedBytes", poolStats[1].GetSavedBytes());
+
+    m_BaseBatchs.Clear();
+    m_animationBatchs.Clear();
+    m_forwardPassBatchs.Clear();
+    m_velocityPassBatchs.Clear();
+    m_idPassBatchs.Clear();
+    m_guiBatchs.Clear();
+
+    m_pFrameTrace->EndFrame();
     m_pDevice->EndFrame();
 }
 
@@ -995,9 +1226,10 @@ void Renderer::BasePass(RGHandle& outColor, RGHandle& outDepth)
         },
         [&](const BasePassData& data, IRHICommandList* pCommandList)
         {
-            for (size_t i = 0; i < m_BaseBatchs.size(); ++i)
+            const eastl::vector<RenderBatch>& batches = m_BaseBatchs.Merge();
+            for (size_t i = 0; i < batches.size(); ++i)
             {
-                DrawBatch(pCommandList, m_BaseBatchs[i]);
+                DrawBatch(pCommandList, batches[i]);
             }
         });
 
@@ -1156,10 +1388,11 @@ void Renderer::RenderBackBufferPass(IRHICommandList* pCommandList, RGHandle colo
 
     CopyToBackBuffer(pCommandList, color, depth, false);
 
-	for (size_t i = 0; i < m_guiBatchs.size(); ++i)
-	{
-		DrawBatch(pCommandList, m_guiBatchs[i]);;
-	}
+    const eastl::vector<RenderBatch>& guiBatches = m_guiBatchs.Merge();
+    for (size_t i = 0; i < guiBatches.size(); ++i)
+    {
+        DrawBatch(pCommandList, guiBatches[i]);
+    }
 
     Engine::GetInstance()->GetEditor()->Render(pCommandList);
     
@@ -1238,6 +1471,117 @@ void Renderer::CopyHistoryPass(RGHandle sceneDepth, RGHandle sceneColor, RGHandl
 }
 
 
+void Renderer::AnimationPass(IRHICommandList* pCommandList)
+{
+    const eastl::vector<ComputeBatch>& batches = m_animationBatchs.Merge();
+    MICROPROFILE_COUNTER_SET("Renderer/Animation/SkinningDispatches", batches.size());
+
+    if (batches.empty())
+    {
+        return;
+    }
+
+    GPU_EVENT(pCommandList, "AnimationPass");
+
+    // All skinned meshes write disjoint ranges, so one barrier before and after the pass instead of one per mesh
+    m_pGPUScene->BeginAnimationUpdate(pCommandList);
+
+    for (size_t i = 0; i < batches.size(); ++i)
+    {
+        DispatchBatch(pCommandList, batches[i]);
+    }
+
+    m_pGPUScene->EndAnimationUpdate(pCommandList);
+
+    CopyAnimationReadbacks(pCommandList);
+}
+
+void Renderer::ReadbackAfterAnimationPass(const eastl::vector<RendererReadbackRange>& ranges, const RendererReadbackCallback& callback)
+{
+    AnimationReadback readback;
+    readback.m_ranges = ranges;
+    readback.m_callback = callback;
+    m_animationReadbacks.push_back(eastl::move(readback));
+}
+
+void Renderer::CopyAnimationReadbacks(IRHICommandList* pCommandList)
+{
+    IRHIBuffer* pAnimationBuffer = m_pGPUScene->GetSceneAnimationBuffer();
+    bool bCopied = false;
+
+    for (size_t i = 0; i < m_animationReadbacks.size(); ++i)
+    {
+        AnimationReadback& readback = m_animationReadbacks[i];
+        if (readback.m_pBuffer)
+        {
+            continue;   //< Recorded in an earlier frame
+        }
+
+        if (!bCopied)
+        {
+            pCommandList->BufferBarrier(pAnimationBuffer, RHIAccessBit::RHIAccessVertexShaderSRV | RHIAccessBit::RHIAccessASRead, RHIAccessBit::RHIAccessCopySrc);
+            bCopied = true;
+        }
+
+        RHIBufferDesc desc;
+        desc.m_size = 0;
+        desc.m_memoryType = RHIMemoryType::GPUToCPU;
+        for (size_t j = 0; j < readback.m_ranges.size(); ++j)
+        {
+            desc.m_size += readback.m_ranges[j].m_size;
+        }
+        readback.m_pBuffer.reset(m_pDevice->CreateBuffer(desc, "Renderer::AnimationReadback"));
+        readback.m_frameID = m_pDevice->GetFrameID();
+
+        // The static buffer is only written by the copy queue, it is promoted to the copy source state
+        uint32_t offset = 0;
+        for (size_t j = 0; j < readback.m_ranges.size(); ++j)
+        {
+            const RendererReadbackRange& range = readback.m_ranges[j];
+            pCommandList->CopyBuffer(readback.m_pBuffer.get(), offset, range.m_pBuffer, range.m_offset, range.m_size);
+            offset += range.m_size;
+        }
+    }
+
+    if (bCopied)
+    {
+        pCommandList->BufferBarrier(pAnimationBuffer, RHIAccessBit::RHIAccessCopySrc, RHIAccessBit::RHIAccessVertexShaderSRV | RHIAccessBit::RHIAccessASRead);
+    }
+}
+
+void Renderer::ProcessAnimationReadbacks(uint64_t completedFrameID)
+{
+    // Moved out first, the callbacks may request new readbacks
+    eastl::vector<AnimationReadback> completed;
+    for (size_t i = 0; i < m_animationReadbacks.size();)
+    {
+        if (m_animationReadbacks[i].m_pBuffer && m_animationReadbacks[i].m_frameID <= completedFrameID)
+        {
+            completed.push_back(eastl::move(m_animationReadbacks[i]));
+            m_animationReadbacks.erase(m_animationReadbacks.begin() + i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    eastl::vector<const void*> data;
+    for (size_t i = 0; i < completed.size(); ++i)
+    {
+        const char* pData = (const char*) completed[i].m_pBuffer->GetCPUAddress();
+
+        data.clear();
+        for (size_t j = 0; j < completed[i].m_ranges.size(); ++j)
+        {
+            data.push_back(pData);
+            pData += completed[i].m_ranges[j].m_size;
+        }
+
+        completed[i].m_callback(data);
+    }
+}
+
 void Renderer::BuildRayTracingAS(IRHICommandList* pGraphicsCommandList, IRHICommandList* pComputeCommandList)
 {
     if (m_enableAsyncCompute)
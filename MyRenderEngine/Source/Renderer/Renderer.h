@@ -13,6 +13,10 @@
 #include "EASTL/unique_ptr.h"
 #include "Utils/linear_allocator.h"
 #include "StagingBufferAllocator.h"
+#include "StagingFill.h"
+#include "ResourcePool.h"
+#include "FrameTrace.h"
+#include "FramePacer.h"
 
 class ShaderCompiler;
 class ShaderCache;
@@ -30,6 +34,7 @@ enum class RendererOutput
     ShadingModel,
     CustomData,
     AO,
+    Shadow,
     DirectLighting,
     IndirectSpecular,
     IndirectDiffuse,
@@ -39,6 +44,16 @@ enum class RendererOutput
     Max
 };
 
+// A buffer range copied to the CPU, see Renderer::ReadbackAfterAnimationPass
+struct RendererReadbackRange
+{
+    IRHIBuffer* m_pBuffer;
+    uint32_t m_offset;
+    uint32_t m_size;
+};
+
+using RendererReadbackCallback = eastl::function<void(const eastl::vector<const void*>& data)>;
+
 enum class TemporalSuperResolution
 {
     None,
@@ -59,11 +74,22 @@ public:
     void RenderFrame();
     void WaitGPUFinished();
 
+    // Waits until the next frame may begin, called before its input is sampled
+    void PaceFrame();
+
+    // Frames the CPU may run ahead of the GPU, at most RHI_MAX_INFLIGHT_FRAMES which the per frame resources are sized for
+    uint32_t GetFramesInFlight() const { return m_framesInFlight; }
+    void SetFramesInFlight(uint32_t count);
+    FramePacer* GetFramePacer() const { return m_pFramePacer.get(); }
+    bool IsFrameLatencyLogEnabled() const { return m_bLogFrameLatency; }
+    void SetFrameLatencyLogEnabled(bool value) { m_bLogFrameLatency = value; }
+
     uint64_t GetFrameID() const { return m_pDevice->GetFrameID(); }
     ShaderCompiler* GetShaderCompiler() const { return m_pShaderCompiler.get(); }
     ShaderCache* GetShaderCache() const { return m_pShaderCache.get(); }
     PipelineStateCache* GetPipelineStateCache() const { return m_pPipelineCache.get(); }
     RenderGraph* GetRenderGraph() const { return m_pRenderGraph.get(); }
+    FrameTrace* GetFrameTrace() const { return m_pFrameTrace.get(); }
 
     RendererOutput GetOutputType() const { return m_outputType; }   
     void SetOutputType(RendererOutput output) { m_outputType = output; }
@@ -79,6 +105,7 @@ public:
     uint32_t GetRenderHeight() const { return m_renderHeight; }
 
     IRHIDevice* GetDevice() const { return m_pDevice.get(); }
+    ResourcePool* GetResourcePool() const { return m_pResourcePool.get(); }
     IRHISwapChain* GetSwapChain() const { return m_pSwapChain.get(); }
     IRHIShader* GetShader(const eastl::string& file, const eastl::string& entryPoint, RHIShaderType type, const eastl::vector<eastl::string>& defines = {}, RHIShaderCompilerFlags flags = 0);
     IRHIPipelineState* GetPipelineState(const RHIGraphicsPipelineDesc& desc, const eastl::string& name);
@@ -115,37 +142,76 @@ public:
 
     uint32_t AddInstance(const InstanceData& data, IRHIRayTracingBLAS* pBLAS, RHIRayTracingInstanceFlags flags);
     uint32_t GetInstanceCount() const { return m_pGPUScene->GetInstanceCount(); }
+    GPUScene* GetGPUScene() const { return m_pGPUScene.get(); }
 
     uint32_t AddLocalLight(const LocalLightData& data);
 
+    uint32_t UpdateMaterial(uint32_t index, const ModelMaterialConstant& data);    //< Returns the slot in the material table
+    void ReleaseMaterial(uint32_t index);
+
     void RequestMouseHitTest(uint32_t x, uint32_t y);
     bool IsEnableMouseHitTest() const { return m_enableObjectIDRendering; }
     uint32_t GetMouseHitObjectID() const { return m_mouseHitObjectID; }
 
     void SetGPUDrivenStatsEnabled(bool value) { m_gpuDrivenStatsEnabled = value; }
     void SetShowMeshletsEnabled(bool value) { m_showMeshlets = value; }
+
+    // Materials use one uber shader with the features read from the material table instead of a permutation each,
+    // the PSOs of the current mode are created by StaticMesh::Tick.
+    // The shading model is only written to the G-buffer, nothing shades by it yet, so there is no GPU binning of the shading models
+    bool IsUberMaterialEnabled() const { return m_bUberMaterial; }
+    void SetUberMaterialEnabled(bool value) { m_bUberMaterial = value; }
+
+    // The base pass rasterizes only the visibility buffer, the G-buffer is written by a compute resolve binned by material
+    bool IsVisibilityBufferEnabled() const { return m_bVisibilityBuffer; }
+    void SetVisibilityBufferEnabled(bool value) { m_bVisibilityBuffer = value; }
+
+    // Small meshlets of the visibility buffer are rasterized by a compute shader
+    bool IsSoftwareRasterEnabled() const { return m_bSoftwareRaster; }
+    void SetSoftwareRasterEnabled(bool value) { m_bSoftwareRaster = value; }
+
+    // The culling HZBs are built with the reprojection, the dilation and the mip 0 reduction fused into the SPD passes
+    bool IsFusedHZBEnabled() const { return m_bFusedHZB; }
+    void SetFusedHZBEnabled(bool value) { m_bFusedHZB = value; }
+
+    // GTAO runs at half resolution with a reprojected history and a depth and normal aware upsample
+    bool IsHalfResGTAOEnabled() const { return m_bHalfResGTAO; }
+    void SetHalfResGTAOEnabled(bool value) { m_bHalfResGTAO = value; }
     
     bool IsAsyncComputeEnabled() const { return m_enableAsyncCompute; }
     void SetAsyncComputeEnabled(bool value) { m_enableAsyncCompute = value; }
   
-    void UploadTexture(IRHITexture* pTexture, const void* pData);
-    void UploadBuffer(IRHIBuffer* pBuffer, uint32_t offset, const void* pData, uint32_t detaSize);
+    // Staging memory is filled from task threads now, the copies are submitted in next UploadResources.
+    // The returned upload fence value is completed when the GPU copies are done, it is 0 if the file can't be read and nothing is uploaded
+    uint64_t UploadTexture(IRHITexture* pTexture, const void* pData);
+    uint64_t UploadTexture(IRHITexture* pTexture, const eastl::string& file, uint64_t fileOffset);    //< Tightly packed subresources in the file
+    uint64_t UploadTexture(IRHITexture* pTexture, const StagingFillDecoder& decoder);                   //< One region per subresource
+    uint64_t UploadBuffer(IRHIBuffer* pBuffer, uint32_t offset, const void* pData, uint32_t detaSize);
+    uint64_t UploadBuffer(IRHIBuffer* pBuffer, uint32_t offset, const eastl::string& file, uint64_t fileOffset, uint32_t dataSize);
+    bool IsUploadCompleted(uint64_t fenceValue) const { return m_pUploadFence->GetCompletedValue() >= fenceValue; }
     void BuildRayTracingBLAS(IRHIRayTracingBLAS* pBLAS);
     void UpdateRayTracingBLAS(IRHIRayTracingBLAS* pBLAS, IRHIBuffer* vertexBuffer, uint32_t vertexBufferOffset);
 
-    LinearAllocator* GetConstantAllocator() const { return m_pCBAllocator.get(); }
+    // Batches can be added from any task scheduler thread
+    FrameAllocator* GetBatchAllocator() const { return m_pBatchAllocator.get(); }
     RenderBatch& AddGPUDrivenBasePassBatch();
-    RenderBatch& AddBasePassBatch() { return m_BaseBatchs.emplace_back(*m_pCBAllocator); }
-    RenderBatch& AddForwardPassBatch() { return m_forwardPassBatchs.emplace_back(*m_pCBAllocator); }
-    RenderBatch& AddVelocityPassBatch() { return m_velocityPassBatchs.emplace_back(*m_pCBAllocator); }
-    RenderBatch& AddObjectIDPassBatch() { return m_idPassBatchs.emplace_back(*m_pCBAllocator); }
-    RenderBatch& AddGUIPassBatch() { return m_guiBatchs.emplace_back(*m_pCBAllocator); }
-    ComputeBatch& AddAnimationBatch() { return m_animationBatchs.emplace_back(*m_pCBAllocator); }
+    RenderBatch& AddShadowPassBatch();
+    RenderBatch& AddBasePassBatch() { return m_BaseBatchs.Add(*m_pBatchAllocator); }
+    RenderBatch& AddForwardPassBatch() { return m_forwardPassBatchs.Add(*m_pBatchAllocator); }
+    RenderBatch& AddVelocityPassBatch() { return m_velocityPassBatchs.Add(*m_pBatchAllocator); }
+    RenderBatch& AddObjectIDPassBatch() { return m_idPassBatchs.Add(*m_pBatchAllocator); }
+    RenderBatch& AddGUIPassBatch() { return m_guiBatchs.Add(*m_pBatchAllocator); }
+    ComputeBatch& AddAnimationBatch() { return m_animationBatchs.Add(*m_pBatchAllocator); }
+
+    // Copies the ranges after the animation pass of this frame, the callback gets their data in the same order
+    // once the GPU has finished the frame. For comparing the GPU results with the CPU references
+    void ReadbackAfterAnimationPass(const eastl::vector<RendererReadbackRange>& ranges, const RendererReadbackCallback& callback);
 
     void SetupGlobalConstants(IRHICommandList* pCommandList);
 
     class HZBPass* GetHZBPass() const { return m_pHZBPass.get(); }
     class BasePassGPUDriven* GetBasePassGPUDriven() const { return m_pBasePassGPUDriven.get(); }
+    class LightingPasses* GetLightingPasses() const { return m_pLightingPasses.get(); }
 
     bool IsHistoryTextureValid() const { return m_bHistoryValid; };
     RGHandle GetPrevSceneDepthHandle() const { return m_prevSceneDepthHandle; }
@@ -160,6 +226,8 @@ private:
 
     void BeginFrame();
     void UploadResources();
+    void AllocateTextureUpload(IRHITexture* pTexture, uint64_t srcOffset, eastl::vector<StagingFillRegion>& regions);
+    void AllocateBufferUpload(IRHIBuffer* pBuffer, uint32_t offset, uint64_t srcOffset, uint32_t dataSize, eastl::vector<StagingFillRegion>& regions);
     void Render();
     void BuildRenderGraph(RGHandle& outColor, RGHandle& outDepth);
     void EndFrame();
@@ -174,18 +242,24 @@ private:
     void RenderBackBufferPass(IRHICommandList* pCommandList, RGHandle color, RGHandle depth);
     void CopyToBackBuffer(IRHICommandList* pCommandList, RGHandle color, RGHandle depth, bool needUpscaleDepth);    
     void CopyHistoryPass(RGHandle sceneDepth, RGHandle sceneColor, RGHandle sceneNormal);
+    void AnimationPass(IRHICommandList* pCommandList);     //< Skins the vertices of this frame, before the BLAS refits and culling
+    void CopyAnimationReadbacks(IRHICommandList* pCommandList);
+    void ProcessAnimationReadbacks(uint64_t completedFrameID);
     void BuildRayTracingAS(IRHICommandList* pGraphicsCommandList, IRHICommandList* pComputeCommandList);
     void ImportPrevFrameTextures();
    
 private:
     // Render resource
     eastl::unique_ptr<IRHIDevice> m_pDevice;
+    eastl::unique_ptr<ResourcePool> m_pResourcePool;    //< Destroyed after the resources pooled in it
     eastl::unique_ptr<IRHISwapChain> m_pSwapChain;
     eastl::unique_ptr<RenderGraph> m_pRenderGraph;
     eastl::unique_ptr<ShaderCompiler> m_pShaderCompiler;
     eastl::unique_ptr<ShaderCache> m_pShaderCache;
     eastl::unique_ptr<PipelineStateCache> m_pPipelineCache;
     eastl::unique_ptr<GPUScene> m_pGPUScene;
+    eastl::unique_ptr<FrameTrace> m_pFrameTrace;
+    eastl::unique_ptr<FramePacer> m_pFramePacer;
 
     RendererOutput m_outputType = RendererOutput::Default;
     TemporalSuperResolution m_upscaleMode = TemporalSuperResolution::None;
@@ -197,11 +271,13 @@ private:
     float m_upscaleRatio = 1.0f;
     float m_mipBias = 0.0f;
 
-    eastl::unique_ptr<LinearAllocator> m_pCBAllocator;
+    eastl::unique_ptr<FrameAllocator> m_pBatchAllocator;
 
     uint64_t m_currentFrameFenceValue = 0;
     eastl::unique_ptr<IRHIFence> m_pFrameFence;
     uint64_t m_frameFenceValue[RHI_MAX_INFLIGHT_FRAMES] = {};
+    uint32_t m_framesInFlight = RHI_MAX_INFLIGHT_FRAMES;
+    bool m_bLogFrameLatency = false;
     eastl::unique_ptr<IRHICommandList> m_pCommandLists[RHI_MAX_INFLIGHT_FRAMES];
 
     eastl::unique_ptr<IRHIFence> m_pAsyncComputeFence;
@@ -269,6 +345,11 @@ private:
 
     bool m_gpuDrivenStatsEnabled = false;
     bool m_showMeshlets = false;
+    bool m_bUberMaterial = false;
+    bool m_bVisibilityBuffer = false;
+    bool m_bSoftwareRaster = true;
+    bool m_bFusedHZB = true;
+    bool m_bHalfResGTAO = true;
     bool m_enableAsyncCompute = false;
 
     bool m_enableObjectIDRendering = false;
@@ -278,12 +359,21 @@ private:
     eastl::unique_ptr<IRHIBuffer> m_pObjectIDBuffer;
     uint32_t m_objectIDRowPitch = 0;
 
-    eastl::vector<RenderBatch> m_BaseBatchs;             //< not mesh let
-    eastl::vector<ComputeBatch> m_animationBatchs;
-    eastl::vector<RenderBatch> m_forwardPassBatchs;
-    eastl::vector<RenderBatch> m_velocityPassBatchs;
-    eastl::vector<RenderBatch> m_idPassBatchs;
-    eastl::vector<RenderBatch> m_guiBatchs;
+    RenderBatchList<RenderBatch> m_BaseBatchs;             //< not mesh let
+    RenderBatchList<ComputeBatch> m_animationBatchs;
+
+    struct AnimationReadback
+    {
+        eastl::vector<RendererReadbackRange> m_ranges;
+        RendererReadbackCallback m_callback;
+        eastl::unique_ptr<IRHIBuffer> m_pBuffer;    //< Created when the copies are recorded
+        uint64_t m_frameID = 0;
+    };
+    eastl::vector<AnimationReadback> m_animationReadbacks;
+    RenderBatchList<RenderBatch> m_forwardPassBatchs;
+    RenderBatchList<RenderBatch> m_velocityPassBatchs;
+    RenderBatchList<RenderBatch> m_idPassBatchs;
+    RenderBatchList<RenderBatch> m_guiBatchs;
 
     IRHIPipelineState* m_pCopyColorPSO = nullptr;
     IRHIPipelineState* m_pCopyDepthPSO = nullptr;
@@ -7,24 +7,43 @@ IndexBuffer::IndexBuffer(const eastl::string& name)
     m_name = name;
 }
 
+IndexBuffer::~IndexBuffer()
+{
+    if (m_poolAllocation.IsValid())
+    {
+        m_pPool->FreeBuffer(m_poolAllocation);
+    }
+}
+
 bool IndexBuffer::Create(uint32_t stride, uint32_t indexCount, RHIMemoryType memoryType)
 {
     MY_ASSERT(stride == 2 || stride == 4);
     m_indexCount = indexCount;
+    m_format = stride == 2 ? RHIFormat::R16UI : RHIFormat::R32UI;
 
     Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
     IRHIDevice* pDevice = pRenderer->GetDevice();
 
-    RHIBufferDesc desc;
-    desc.m_stride = stride;
-    desc.m_size = stride * indexCount;
-    desc.m_format = stride == 2 ? RHIFormat::R16UI : RHIFormat::R32UI;
-    desc.m_memoryType = memoryType;
+    if (memoryType == RHIMemoryType::GPUOnly)
+    {
+        m_pPool = pRenderer->GetResourcePool();
+        m_pBuffer = m_pPool->AllocateBuffer(stride * indexCount, stride, m_poolAllocation);
+    }
 
-    m_pBuffer.reset(pDevice->CreateBuffer(desc, m_name));
     if (m_pBuffer == nullptr)
     {
-        return false;
+        RHIBufferDesc desc;
+        desc.m_stride = stride;
+        desc.m_size = stride * indexCount;
+        desc.m_format = m_format;
+        desc.m_memoryType = memoryType;
+
+        m_pDedicatedBuffer.reset(pDevice->CreateBuffer(desc, m_name));
+        m_pBuffer = m_pDedicatedBuffer.get();
+        if (m_pBuffer == nullptr)
+        {
+            return false;
+        }
     }
 
     return true;
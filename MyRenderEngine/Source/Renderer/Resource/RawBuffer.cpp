@@ -7,6 +7,14 @@ RawBuffer::RawBuffer(const eastl::string& name)
     m_name = name;
 }
 
+RawBuffer::~RawBuffer()
+{
+    if (m_poolAllocation.IsValid())
+    {
+        m_pPool->FreeBuffer(m_poolAllocation);
+    }
+}
+
 bool RawBuffer::Create(uint32_t size, RHIMemoryType memoryType, bool uav)
 {
     Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
@@ -14,28 +22,39 @@ bool RawBuffer::Create(uint32_t size, RHIMemoryType memoryType, bool uav)
 
     MY_ASSERT(size % 4 == 0);       //< Raw buffer is byte address buffer, 32bits values
 
-    RHIBufferDesc desc;
-    desc.m_stride = 4;
-    desc.m_size = size;
-    desc.m_format = RHIFormat::R32F;
-    desc.m_memoryType = memoryType;
-    desc.m_usage = RHIBufferUsageBit::RHIBufferUsageRawBuffer;
-
-    if (uav)
+    if (memoryType == RHIMemoryType::GPUOnly && !uav)
     {
-        desc.m_usage |= RHIBufferUsageBit::RHIBufferUsageUnorderedAccess;
+        m_pPool = pRenderer->GetResourcePool();
+        m_pBuffer = m_pPool->AllocateBuffer(size, 16, m_poolAllocation);
     }
 
-    m_pBuffer.reset(pDevice->CreateBuffer(desc, m_name));
     if (m_pBuffer == nullptr)
     {
-        return false;
+        RHIBufferDesc desc;
+        desc.m_stride = 4;
+        desc.m_size = size;
+        desc.m_format = RHIFormat::R32F;
+        desc.m_memoryType = memoryType;
+        desc.m_usage = RHIBufferUsageBit::RHIBufferUsageRawBuffer;
+
+        if (uav)
+        {
+            desc.m_usage |= RHIBufferUsageBit::RHIBufferUsageUnorderedAccess;
+        }
+
+        m_pDedicatedBuffer.reset(pDevice->CreateBuffer(desc, m_name));
+        m_pBuffer = m_pDedicatedBuffer.get();
+        if (m_pBuffer == nullptr)
+        {
+            return false;
+        }
     }
 
     RHIShaderResourceViewDesc srvDesc;
     srvDesc.m_type = RHIShaderResourceViewType::RawBuffer;
     srvDesc.m_buffer.m_size = size;
-    m_pSRV.reset(pDevice->CreateShaderResourceView(m_pBuffer.get(), srvDesc, m_name));
+    srvDesc.m_buffer.m_offset = m_poolAllocation.m_offset;
+    m_pSRV.reset(pDevice->CreateShaderResourceView(m_pBuffer, srvDesc, m_name));
     if (m_pSRV == nullptr)
     {
         return false;
@@ -46,7 +65,7 @@ bool RawBuffer::Create(uint32_t size, RHIMemoryType memoryType, bool uav)
         RHIUnorderedAccessViewDesc uavDesc;
         uavDesc.m_type = RHIUnorderedAccessViewType::RawBuffer;
         uavDesc.m_buffer.m_size = size;
-        m_pUAV.reset(pDevice->CreateUnorderedAccessView(m_pBuffer.get(), uavDesc, m_name));
+        m_pUAV.reset(pDevice->CreateUnorderedAccessView(m_pBuffer, uavDesc, m_name));
         if (m_pUAV == nullptr)
         {
             return false;
@@ -1,21 +1,27 @@
 #pragma once
 #include "RHI/RHI.h"
 #include "EASTL/unique_ptr.h"
+#include "../ResourcePool.h"
 
 class RawBuffer
 {
 public:
     RawBuffer(const eastl::string& name);
+    ~RawBuffer();
 
     bool Create(uint32_t size, RHIMemoryType memoryType, bool uav);
     
-    IRHIBuffer* GetBuffer() const { return m_pBuffer.get(); }
+    IRHIBuffer* GetBuffer() const { return m_pBuffer; }
+    uint32_t GetBufferOffset() const { return m_poolAllocation.m_offset; }     //< Not 0 when the data is in a shared buffer
     IRHIDescriptor* GetSRV() const { return m_pSRV.get(); }
     IRHIDescriptor* GetUAV() const { return m_pUAV.get(); }
 
 protected:
     eastl::string m_name;
-    eastl::unique_ptr<IRHIBuffer> m_pBuffer;
+    IRHIBuffer* m_pBuffer = nullptr;                    //< The dedicated buffer, or a shared one of the resource pool
+    eastl::unique_ptr<IRHIBuffer> m_pDedicatedBuffer;
+    ResourcePool* m_pPool = nullptr;
+    ResourcePoolAllocation m_poolAllocation;
     eastl::unique_ptr<IRHIDescriptor> m_pSRV;
     eastl::unique_ptr<IRHIDescriptor> m_pUAV;
 };
\ No newline at end of file
@@ -7,33 +7,53 @@ StructedBuffer::StructedBuffer(const eastl::string& name)
     m_name = name;
 }
 
+StructedBuffer::~StructedBuffer()
+{
+    if (m_poolAllocation.IsValid())
+    {
+        m_pPool->FreeBuffer(m_poolAllocation);
+    }
+}
+
 bool StructedBuffer::Create(uint32_t stride, uint32_t elementCount, RHIMemoryType memoryType, bool uav)
 {
     Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
     IRHIDevice* pDevice = pRenderer->GetDevice();
 
-    RHIBufferDesc desc;
-    desc.m_stride = stride;
-    desc.m_size = stride * elementCount;
-    desc.m_format = RHIFormat::Unknown;
-    desc.m_memoryType = memoryType;
-    desc.m_usage = RHIBufferUsageBit::RHIBufferUsageStructedBuffer;
-
-    if (uav)
+    if (memoryType == RHIMemoryType::GPUOnly && !uav)
     {
-        desc.m_usage |= RHIBufferUsageBit::RHIBufferUsageUnorderedAccess;
+        m_pPool = pRenderer->GetResourcePool();
+        m_pBuffer = m_pPool->AllocateBuffer(stride * elementCount, stride, m_poolAllocation);
     }
 
-    m_pBuffer.reset(pDevice->CreateBuffer(desc, m_name));
     if (m_pBuffer == nullptr)
     {
-        return false;
+        RHIBufferDesc desc;
+        desc.m_stride = stride;
+        desc.m_size = stride * elementCount;
+        desc.m_format = RHIFormat::Unknown;
+        desc.m_memoryType = memoryType;
+        desc.m_usage = RHIBufferUsageBit::RHIBufferUsageStructedBuffer;
+
+        if (uav)
+        {
+            desc.m_usage |= RHIBufferUsageBit::RHIBufferUsageUnorderedAccess;
+        }
+
+        m_pDedicatedBuffer.reset(pDevice->CreateBuffer(desc, m_name));
+        m_pBuffer = m_pDedicatedBuffer.get();
+        if (m_pBuffer == nullptr)
+        {
+            return false;
+        }
     }
 
     RHIShaderResourceViewDesc srvDesc;
     srvDesc.m_type = RHIShaderResourceViewType::StructuredBuffer;
     srvDesc.m_buffer.m_size = stride * elementCount;
-    m_pSRV.reset(pDevice->CreateShaderResourceView(m_pBuffer.get(), srvDesc, m_name));
+    srvDesc.m_buffer.m_offset = m_poolAllocation.m_offset;
+    srvDesc.m_buffer.m_stride = stride;
+    m_pSRV.reset(pDevice->CreateShaderResourceView(m_pBuffer, srvDesc, m_name));
     if (m_pSRV == nullptr)
     {
         return false;
@@ -44,7 +64,7 @@ bool StructedBuffer::Create(uint32_t stride, uint32_t elementCount, RHIMemoryTyp
         RHIUnorderedAccessViewDesc uavDesc;
         uavDesc.m_type = RHIUnorderedAccessViewType::StructuredBuffer;
         uavDesc.m_buffer.m_size = stride * elementCount;
-        m_pUAV.reset(pDevice->CreateUnorderedAccessView(m_pBuffer.get(), uavDesc, m_name));
+        m_pUAV.reset(pDevice->CreateUnorderedAccessView(m_pBuffer, uavDesc, m_name));
         if (m_pUAV == nullptr)
         {
             return false;
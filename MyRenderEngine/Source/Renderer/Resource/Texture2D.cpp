@@ -8,6 +8,14 @@ Texture2D::Texture2D(const eastl::string& name)
     m_name = name;
 }
 
+Texture2D::~Texture2D()
+{
+    if (m_poolAllocation.IsValid())
+    {
+        m_pPool->FreeTexture(m_poolAllocation);
+    }
+}
+
 bool Texture2D::Create(uint32_t width, uint32_t height, uint32_t levels, RHIFormat format, RHITextureUsageFlags flags)
 {
     Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
@@ -24,6 +32,12 @@ bool Texture2D::Create(uint32_t width, uint32_t height, uint32_t levels, RHIForm
     {
         desc.m_allocationType = RHIAllocationType::Comitted;
     }
+    else
+    {
+        m_pPool = pRenderer->GetResourcePool();
+        desc.m_heap = m_pPool->AllocateTexture(desc, m_poolAllocation);
+        desc.m_heapOffset = m_poolAllocation.m_offset;
+    }
 
     m_pTexture.reset(pDevice->CreateTexture(desc, m_name));
     if (m_pTexture == nullptr)
@@ -1,6 +1,7 @@
 #pragma once
 #include "RHI/RHI.h"
 #include "EASTL/unique_ptr.h"
+#include "../ResourcePool.h"
 
 class Renderer;
 
@@ -8,6 +9,7 @@ class Texture2D
 {
 public:
     Texture2D(const eastl::string& name);
+    ~Texture2D();
     
     bool Create(uint32_t width, uint32_t height, uint32_t levels, RHIFormat format, RHITextureUsageFlags flags);
     
@@ -23,4 +25,7 @@ protected:
     eastl::unique_ptr<IRHITexture> m_pTexture;
     eastl::unique_ptr<IRHIDescriptor> m_pSRV;
     eastl::vector<eastl::unique_ptr<IRHIDescriptor>> m_pUAVs;
+
+    ResourcePool* m_pPool = nullptr;
+    ResourcePoolAllocation m_poolAllocation;    //< Small textures are placed in a heap of the resource pool
 };
\ No newline at end of file
@@ -7,36 +7,56 @@ TypedBuffer::TypedBuffer(const eastl::string& name)
     m_name = name;
 }
 
+TypedBuffer::~TypedBuffer()
+{
+    if (m_poolAllocation.IsValid())
+    {
+        m_pPool->FreeBuffer(m_poolAllocation);
+    }
+}
+
 bool TypedBuffer::Create(RHIFormat format, uint32_t elementCount, RHIMemoryType memoryType, bool uav)
 {
     Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
     IRHIDevice* pDevice = pRenderer->GetDevice();
 
     uint32_t stride = GetFormatRowPitch(format, 1);
-    RHIBufferDesc desc;
-    desc.m_stride = stride;
-    desc.m_size = stride * elementCount;
-    desc.m_format = format;
-    desc.m_memoryType = memoryType;
-    desc.m_usage = RHIBufferUsageBit::RHIBufferUsageTypedBuffer;
-    
-    if (uav)
+
+    if (memoryType == RHIMemoryType::GPUOnly && !uav)
     {
-        desc.m_usage |= RHIBufferUsageBit::RHIBufferUsageUnorderedAccess;
+        m_pPool = pRenderer->GetResourcePool();
+        m_pBuffer = m_pPool->AllocateBuffer(stride * elementCount, stride, m_poolAllocation);
     }
 
-    m_pBuffer.reset(pDevice->CreateBuffer(desc, m_name));
-    if(m_pBuffer == nullptr)
+    if (m_pBuffer == nullptr)
     {
-        return false;
+        RHIBufferDesc desc;
+        desc.m_stride = stride;
+        desc.m_size = stride * elementCount;
+        desc.m_format = format;
+        desc.m_memoryType = memoryType;
+        desc.m_usage = RHIBufferUsageBit::RHIBufferUsageTypedBuffer;
+        
+        if (uav)
+        {
+            desc.m_usage |= RHIBufferUsageBit::RHIBufferUsageUnorderedAccess;
+        }
+
+        m_pDedicatedBuffer.reset(pDevice->CreateBuffer(desc, m_name));
+        m_pBuffer = m_pDedicatedBuffer.get();
+        if(m_pBuffer == nullptr)
+        {
+            return false;
+        }
     }
-    
 
     RHIShaderResourceViewDesc srvDesc;
     srvDesc.m_type = RHIShaderResourceViewType::TypedBuffer;
     srvDesc.m_format = format;
     srvDesc.m_buffer.m_size = stride * elementCount;
-    m_pSRV.reset(pDevice->CreateShaderResourceView(m_pBuffer.get(), srvDesc, m_name));
+    srvDesc.m_buffer.m_offset = m_poolAllocation.m_offset;
+    srvDesc.m_buffer.m_stride = stride;
+    m_pSRV.reset(pDevice->CreateShaderResourceView(m_pBuffer, srvDesc, m_name));
     if (m_pSRV == nullptr)
     {
         return false;
@@ -48,7 +68,7 @@ bool TypedBuffer::Create(RHIFormat format, uint32_t elementCount, RHIMemoryType
         uavDesc.m_type = RHIUnorderedAccessViewType::TypedBuffer;
         uavDesc.m_format = format;
         uavDesc.m_buffer.m_size = stride * elementCount;
-        m_pUAV.reset(pDevice->CreateUnorderedAccessView(m_pBuffer.get(), uavDesc, m_name));
+        m_pUAV.reset(pDevice->CreateUnorderedAccessView(m_pBuffer, uavDesc, m_name));
         if (m_pUAV == nullptr)
         {
             return false;
@@ -1,20 +1,27 @@
 #pragma once
 #include "RHI/RHI.h"
 #include "EASTL/unique_ptr.h"
+#include "../ResourcePool.h"
 
 class IndexBuffer
 {
 public:
     IndexBuffer(const eastl::string& name);
+    ~IndexBuffer();
 
     bool Create(uint32_t stride, uint32_t indexCount, RHIMemoryType memoryType);
     
-    IRHIBuffer* GetBuffer() const { return m_pBuffer.get(); }
+    IRHIBuffer* GetBuffer() const { return m_pBuffer; }
+    uint32_t GetBufferOffset() const { return m_poolAllocation.m_offset; }     //< Not 0 when the indices are in a shared buffer
     uint32_t GetIndexCount() const { return m_indexCount; }
-    RHIFormat GetFormat() const { return m_pBuffer->GetDesc().m_format; }
+    RHIFormat GetFormat() const { return m_format; }
 private:
     eastl::string m_name;
 
-    eastl::unique_ptr<IRHIBuffer> m_pBuffer;
+    IRHIBuffer* m_pBuffer = nullptr;                    //< The dedicated buffer, or a shared one of the resource pool
+    eastl::unique_ptr<IRHIBuffer> m_pDedicatedBuffer;
+    ResourcePool* m_pPool = nullptr;
+    ResourcePoolAllocation m_poolAllocation;
     uint32_t m_indexCount = 0;
+    RHIFormat m_format = RHIFormat::Unknown;
 };
\ No newline at end of file
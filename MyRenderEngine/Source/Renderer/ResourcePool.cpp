@@ -0,0 +1,219 @@
+#include "ResourcePool.h"
+#include "Utils/assert.h"
+#include "Utils/math.h"
+#include "Utils/fmt.h"
+
+ResourcePoolAllocator::ResourcePoolAllocator(uint32_t blockSize, uint32_t granularity, const eastl::string& name)
+{
+    MY_ASSERT(blockSize % granularity == 0);
+
+    m_blockSize = blockSize;
+    m_granularity = granularity;
+    m_name = name;
+}
+
+ResourcePoolAllocation ResourcePoolAllocator::Allocate(uint32_t size, uint32_t alignment, uint32_t dedicatedSize)
+{
+    MY_ASSERT(size > 0 && alignment > 0);
+
+    // Offsets are multiples of the granularity, other alignments need room to move the offset up
+    uint32_t paddedSize = m_granularity % alignment == 0 ? size : size + alignment - 1;
+    uint32_t unitCount = (paddedSize + m_granularity - 1) / m_granularity;
+
+    ResourcePoolAllocation allocation;
+    if (unitCount * m_granularity > m_blockSize)
+    {
+        return allocation;
+    }
+
+    for (uint32_t i = 0; i <= (uint32_t) m_blocks.size(); ++i)
+    {
+        if (i == (uint32_t) m_blocks.size())
+        {
+            uint32_t unitsPerBlock = m_blockSize / m_granularity;
+            m_blocks.push_back(eastl::make_unique<OffsetAllocator::Allocator>(unitsPerBlock, unitsPerBlock + 2)); //< Enough nodes even when every unit is allocated alone
+        }
+
+        OffsetAllocator::Allocation unitAllocation = m_blocks[i]->allocate(unitCount);
+        if (unitAllocation.offset == OffsetAllocator::Allocation::NO_SPACE)
+        {
+            continue;
+        }
+
+        uint32_t offset = unitAllocation.offset * m_granularity;
+
+        allocation.m_block = i;
+        allocation.m_offset = (offset + alignment - 1) / alignment * alignment;
+        allocation.m_dedicatedSize = dedicatedSize;
+        allocation.m_allocation = unitAllocation;
+
+        ++m_resourceCount;
+        m_usedBytes += (uint64_t) m_blocks[i]->allocationSize(unitAllocation) * m_granularity;
+        m_dedicatedBytes += dedicatedSize;
+        break;
+    }
+
+    return allocation;
+}
+
+void ResourcePoolAllocator::Free(const ResourcePoolAllocation& allocation)
+{
+    MY_ASSERT(allocation.IsValid() && allocation.m_block < (uint32_t) m_blocks.size());
+
+    OffsetAllocator::Allocator* pBlock = m_blocks[allocation.m_block].get();
+
+    --m_resourceCount;
+    m_usedBytes -= (uint64_t) pBlock->allocationSize(allocation.m_allocation) * m_granularity;
+    m_dedicatedBytes -= allocation.m_dedicatedSize;
+
+    pBlock->free(allocation.m_allocation);
+}
+
+void ResourcePoolAllocator::DeferredFree(const ResourcePoolAllocation& allocation, uint64_t frameID)
+{
+    MY_ASSERT(allocation.IsValid());
+    m_deferredFrees.push_back({ allocation, frameID });
+}
+
+void ResourcePoolAllocator::ProcessDeferredFrees(uint64_t completedFrameID)
+{
+    // Freed in order of frame ID, so the completed ones are at the front
+    size_t freedCount = 0;
+    while (freedCount < m_deferredFrees.size() && m_deferredFrees[freedCount].m_frameID <= completedFrameID)
+    {
+        Free(m_deferredFrees[freedCount].m_allocation);
+        ++freedCount;
+    }
+
+    if (freedCount > 0)
+    {
+        m_deferredFrees.erase(m_deferredFrees.begin(), m_deferredFrees.begin() + freedCount);
+    }
+}
+
+ResourcePoolStats ResourcePoolAllocator::GetStats() const
+{
+    ResourcePoolStats stats;
+    stats.m_name = m_name;
+    stats.m_resourceCount = m_resourceCount;
+    stats.m_blockCount = (uint32_t) m_blocks.size();
+    stats.m_pendingFreeCount = (uint32_t) m_deferredFrees.size();
+    stats.m_usedBytes = m_usedBytes;
+    stats.m_reservedBytes = (uint64_t) m_blocks.size() * m_blockSize;
+    stats.m_dedicatedBytes = m_dedicatedBytes;
+    return stats;
+}
+
+ResourcePool::ResourcePool(IRHIDevice* pDevice) :
+    m_bufferAllocator(RESOURCE_POOL_BUFFER_BLOCK_SIZE, 256, "Buffer Pool"),
+    m_textureAllocator(RESOURCE_POOL_TEXTURE_BLOCK_SIZE, 4 * 1024, "Texture Pool")    //< The small placement alignment of textures
+{
+    m_pDevice = pDevice;
+}
+
+IRHIBuffer* ResourcePool::AllocateBuffer(uint32_t size, uint32_t alignment, ResourcePoolAllocation& allocation)
+{
+    if (size > RESOURCE_POOL_MAX_BUFFER_SIZE)
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    allocation = m_bufferAllocator.Allocate(size, alignment, RoundUpPow2(size, RESOURCE_POOL_DEDICATED_ALIGNMENT));
+    if (!allocation.IsValid())
+    {
+        return nullptr;
+    }
+
+    while (m_buffers.size() < m_bufferAllocator.GetBlockCount())
+    {
+        // Views into the buffer set their own stride, 4 is for the raw buffer views
+        RHIBufferDesc desc;
+        desc.m_stride = 4;
+        desc.m_size = RESOURCE_POOL_BUFFER_BLOCK_SIZE;
+        desc.m_memoryType = RHIMemoryType::GPUOnly;
+        desc.m_usage = RHIBufferUsageBit::RHIBufferUsageStructedBuffer | RHIBufferUsageBit::RHIBufferUsageTypedBuffer | RHIBufferUsageBit::RHIBufferUsageRawBuffer;
+
+        m_buffers.emplace_back(m_pDevice->CreateBuffer(desc, fmt::format("ResourcePool::m_buffers {}", m_buffers.size()).c_str()));
+    }
+
+    IRHIBuffer* pBuffer = m_buffers[allocation.m_block].get();
+    if (pBuffer == nullptr)
+    {
+        m_bufferAllocator.Free(allocation);
+        allocation = ResourcePoolAllocation();
+    }
+
+    return pBuffer;
+}
+
+void ResourcePool::FreeBuffer(const ResourcePoolAllocation& allocation)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bufferAllocator.DeferredFree(allocation, m_pDevice->GetFrameID());
+}
+
+IRHIHeap* ResourcePool::AllocateTexture(const RHITextureDesc& desc, ResourcePoolAllocation& allocation)
+{
+    if (desc.m_usage != 0 || desc.m_memoryType != RHIMemoryType::GPUOnly || desc.m_allocationType != RHIAllocationType::Placed)
+    {
+        return nullptr;
+    }
+
+    uint32_t size = m_pDevice->GetSmallAllocationSize(desc);
+    if (size > RESOURCE_POOL_MAX_TEXTURE_SIZE)
+    {
+        return nullptr;
+    }
+
+    // Textures the device can't place with the small alignment come back with a multiple of the dedicated one
+    uint32_t alignment = size % RESOURCE_POOL_DEDICATED_ALIGNMENT == 0 ? RESOURCE_POOL_DEDICATED_ALIGNMENT : 4 * 1024;
+    uint32_t dedicatedSize = m_pDevice->GetAllocationSize(desc);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    allocation = m_textureAllocator.Allocate(size, alignment, dedicatedSize);
+    if (!allocation.IsValid())
+    {
+        return nullptr;
+    }
+
+    while (m_heaps.size() < m_textureAllocator.GetBlockCount())
+    {
+        RHIHeapDesc heapDesc;
+        heapDesc.m_size = RESOURCE_POOL_TEXTURE_BLOCK_SIZE;
+        heapDesc.m_memoryType = RHIMemoryType::GPUOnly;
+
+        m_heaps.emplace_back(m_pDevice->CreatHeap(heapDesc, fmt::format("ResourcePool::m_heaps {}", m_heaps.size()).c_str()));
+    }
+
+    IRHIHeap* pHeap = m_heaps[allocation.m_block].get();
+    if (pHeap == nullptr)
+    {
+        m_textureAllocator.Free(allocation);
+        allocation = ResourcePoolAllocation();
+    }
+
+    return pHeap;
+}
+
+void ResourcePool::FreeTexture(const ResourcePoolAllocation& allocation)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_textureAllocator.DeferredFree(allocation, m_pDevice->GetFrameID());
+}
+
+void ResourcePool::ProcessDeferredFrees(uint64_t completedFrameID)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bufferAllocator.ProcessDeferredFrees(completedFrameID);
+    m_textureAllocator.ProcessDeferredFrees(completedFrameID);
+}
+
+void ResourcePool::GetStats(eastl::vector<ResourcePoolStats>& stats)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    stats.push_back(m_bufferAllocator.GetStats());
+    stats.push_back(m_textureAllocator.GetStats());
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "RHI/RHI.h"
+#include "OffsetAllocator/offsetAllocator.hpp"
+#include "EASTL/unique_ptr.h"
+#include "EASTL/vector.h"
+#include <mutex>
+
+#define RESOURCE_POOL_DEDICATED_ALIGNMENT (64 * 1024)        //< Placement alignment of a buffer or a texture of its own
+#define RESOURCE_POOL_BUFFER_BLOCK_SIZE (4 * 1024 * 1024)
+#define RESOURCE_POOL_MAX_BUFFER_SIZE (64 * 1024)            //< Larger buffers waste little of the dedicated alignment
+#define RESOURCE_POOL_TEXTURE_BLOCK_SIZE (16 * 1024 * 1024)
+#define RESOURCE_POOL_MAX_TEXTURE_SIZE (256 * 1024)
+
+struct ResourcePoolAllocation
+{
+    uint32_t m_block = UINT32_MAX;      //< UINT32_MAX when the resource is not pooled
+    uint32_t m_offset = 0;              //< Aligned offset in the block
+    uint32_t m_dedicatedSize = 0;
+    OffsetAllocator::Allocation m_allocation;
+
+    bool IsValid() const { return m_block != UINT32_MAX; }
+};
+
+struct ResourcePoolStats
+{
+    eastl::string m_name;
+    uint32_t m_resourceCount = 0;       //< Live sub-allocations
+    uint32_t m_blockCount = 0;          //< Shared resources holding them
+    uint32_t m_pendingFreeCount = 0;
+    uint64_t m_usedBytes = 0;           //< Including the alignment padding
+    uint64_t m_reservedBytes = 0;       //< Size of all blocks
+    uint64_t m_dedicatedBytes = 0;      //< Memory the same resources would take on their own
+
+    int64_t GetSavedBytes() const { return (int64_t) m_dedicatedBytes - (int64_t) m_reservedBytes; }
+};
+
+// Sub-allocates aligned ranges from fixed size blocks, one OffsetAllocator (TLSF) per block, in units of the granularity.
+// Only bookkeeping, the caller creates a shared resource for each new block, so it works without a device.
+// Not thread safe
+class ResourcePoolAllocator
+{
+public:
+    ResourcePoolAllocator(uint32_t blockSize, uint32_t granularity, const eastl::string& name);
+
+    // Adds a block when none has room, the caller checks GetBlockCount afterwards
+    ResourcePoolAllocation Allocate(uint32_t size, uint32_t alignment, uint32_t dedicatedSize);
+    void Free(const ResourcePoolAllocation& allocation);
+
+    // The range is recycled when ProcessDeferredFrees is called with a completed frame ID >= frameID
+    void DeferredFree(const ResourcePoolAllocation& allocation, uint64_t frameID);
+    void ProcessDeferredFrees(uint64_t completedFrameID);
+
+    uint32_t GetBlockCount() const { return (uint32_t) m_blocks.size(); }
+    uint32_t GetBlockSize() const { return m_blockSize; }
+    ResourcePoolStats GetStats() const;
+
+private:
+    struct DeferredFreeItem
+    {
+        ResourcePoolAllocation m_allocation;
+        uint64_t m_frameID;
+    };
+
+    uint32_t m_blockSize = 0;
+    uint32_t m_granularity = 0;
+    eastl::string m_name;
+
+    eastl::vector<eastl::unique_ptr<OffsetAllocator::Allocator>> m_blocks;
+    eastl::vector<DeferredFreeItem> m_deferredFrees;
+
+    uint32_t m_resourceCount = 0;
+    uint64_t m_usedBytes = 0;
+    uint64_t m_dedicatedBytes = 0;
+};
+
+// Small GPU only resources of the renderer, buffers are ranges of shared buffers and textures are placed in shared heaps.
+// Thread safe, ranges are recycled RHI_MAX_INFLIGHT_FRAMES frames after they are freed
+class ResourcePool
+{
+public:
+    ResourcePool(IRHIDevice* pDevice);
+
+    // Returns nullptr when the buffer should be a dedicated one. Pooled buffers are read only, UAV buffers are never pooled
+    IRHIBuffer* AllocateBuffer(uint32_t size, uint32_t alignment, ResourcePoolAllocation& allocation);
+    void FreeBuffer(const ResourcePoolAllocation& allocation);
+
+    // Returns nullptr when the texture should be a dedicated one, otherwise the heap to place it at allocation.m_offset
+    IRHIHeap* AllocateTexture(const RHITextureDesc& desc, ResourcePoolAllocation& allocation);
+    void FreeTexture(const ResourcePoolAllocation& allocation);
+
+    void ProcessDeferredFrees(uint64_t completedFrameID);
+    void GetStats(eastl::vector<ResourcePoolStats>& stats);
+
+private:
+    IRHIDevice* m_pDevice = nullptr;
+
+    std::mutex m_mutex;
+    ResourcePoolAllocator m_bufferAllocator;
+    ResourcePoolAllocator m_textureAllocator;
+    eastl::vector<eastl::unique_ptr<IRHIBuffer>> m_buffers;     //< One per block of m_bufferAllocator
+    eastl::vector<eastl::unique_ptr<IRHIHeap>> m_heaps;         //< One per block of m_textureAllocator
+};
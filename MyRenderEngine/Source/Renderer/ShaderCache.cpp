@@ -4,6 +4,7 @@
 #include "PipelineCache.h"
 #include "Utils/log.h"
 #include "Core/Engine.h"
+#include "sokol/sokol_time.h"
 #include <fstream>
 #include <filesystem>
 #include <regex>
@@ -122,13 +123,18 @@ void ShaderCache::ReloadShaders()
 
 IRHIShader* ShaderCache::CreateShader(const eastl::string& file, const eastl::string& entryPoint, RHIShaderType type, const eastl::vector<eastl::string>& defines, RHIShaderCompilerFlags flags)
 {
+    uint64_t startTime = stm_now();
     eastl::string source = GetCachedFileContent(file);
     
     eastl::vector<uint8_t> shaderBlob;
-    if(!m_pRenderer->GetShaderCompiler()->Compile(source, file, entryPoint, type, defines, flags, shaderBlob))
+    bool bCompiled = m_pRenderer->GetShaderCompiler()->Compile(source, file, entryPoint, type, defines, flags, shaderBlob);
+
+    m_compileTime += stm_ms(stm_since(startTime));
+    if (!bCompiled)
     {
         return nullptr;
     }
+    ++m_compiledShaderCount;
 
     RHIShaderDesc desc;
     desc.m_type = type;
@@ -32,6 +32,9 @@ public:
     IRHIShader* GetShader(const eastl::string& file, const eastl::string& entryPoint, RHIShaderType type, const eastl::vector<eastl::string>& defines, RHIShaderCompilerFlags flags);
     eastl::string GetCachedFileContent(const eastl::string& file);
     void ReloadShaders();
+
+    uint32_t GetCompiledShaderCount() const { return m_compiledShaderCount; }
+    double GetCompileTime() const { return m_compileTime; }     //< Milliseconds spent in CreateShader
 private:
     IRHIShader* CreateShader(const eastl::string& file, const eastl::string& entryPoint, RHIShaderType type, const eastl::vector<eastl::string>& defines, RHIShaderCompilerFlags flags);
     void RecompileShader(IRHIShader* pShader);
@@ -42,4 +45,7 @@ private:
     Renderer* m_pRenderer;
     eastl::hash_map<RHIShaderDesc, eastl::unique_ptr<IRHIShader>> m_cachedShaders;
     eastl::hash_map<eastl::string, eastl::string> m_cachedFiles;
+
+    uint32_t m_compiledShaderCount = 0;
+    double m_compileTime = 0.0;
 };
\ No newline at end of file
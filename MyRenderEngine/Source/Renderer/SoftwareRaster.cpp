@@ -0,0 +1,101 @@
+#include "SoftwareRaster.h"
+#include <cstring>
+
+static int32_t EdgeFunction(const int2& a, const int2& b, const int2& p)
+{
+    return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+}
+
+static int32_t GetEdgeBias(const int2& a, const int2& b)
+{
+    int2 edge = b - a;
+    bool bTopLeft = edge.y < 0 || (edge.y == 0 && edge.x > 0);
+    return bTopLeft ? 0 : -1;
+}
+
+static int2 SnapToSubpixel(const float3& p)
+{
+    return int2((int32_t) floorf(p.x * SW_RASTER_SUBPIXEL_SCALE + 0.5f), (int32_t) floorf(p.y * SW_RASTER_SUBPIXEL_SCALE + 0.5f));
+}
+
+bool IsSoftwareRasterMeshlet(const float4& aabb, const float2& renderSize)
+{
+    float2 size = float2(aabb.z - aabb.x, aabb.w - aabb.y) * renderSize;
+    return max(size.x, size.y) <= SW_RASTER_MAX_MESHLET_PIXELS;
+}
+
+uint64_t PackVisibilityTexel(uint32_t visibilityID, float depth)
+{
+    uint32_t depthBits;
+    memcpy(&depthBits, &depth, sizeof(depthBits));
+    return ((uint64_t) depthBits << 32) | visibilityID;
+}
+
+float3 ClipToScreen(const float4& clipPos, const float2& renderSize)
+{
+    float3 ndc = clipPos.xyz() / clipPos.w;
+    float2 screen = (ndc.xy() * float2(0.5f, -0.5f) + 0.5f) * renderSize;
+    return float3(screen.x, screen.y, ndc.z);
+}
+
+RasterTriangle SetupRasterTriangle(const float3& p0, const float3& p1, const float3& p2, uint2 renderSize, bool bDoubleSided, bool bFrontFaceCCW)
+{
+    RasterTriangle tri;
+    tri.m_v0 = SnapToSubpixel(p0);
+    tri.m_v1 = SnapToSubpixel(p1);
+    tri.m_v2 = SnapToSubpixel(p2);
+    tri.m_depth = float3(p0.z, p1.z, p2.z);
+
+    // Positive area is clockwise on the screen, y is down
+    int32_t area = EdgeFunction(tri.m_v0, tri.m_v1, tri.m_v2);
+    tri.m_bFrontFace = bFrontFaceCCW ? area < 0 : area > 0;
+    tri.m_bVisible = area != 0 && (bDoubleSided || tri.m_bFrontFace);
+
+    if (area < 0)
+    {
+        eastl::swap(tri.m_v1, tri.m_v2);
+        eastl::swap(tri.m_depth.y, tri.m_depth.z);
+        area = -area;
+    }
+    tri.m_rcpArea = 1.0f / (float) area;
+
+    tri.m_bias = int3(GetEdgeBias(tri.m_v1, tri.m_v2), GetEdgeBias(tri.m_v2, tri.m_v0), GetEdgeBias(tri.m_v0, tri.m_v1));
+
+    int2 minPos = min(tri.m_v0, min(tri.m_v1, tri.m_v2));
+    int2 maxPos = max(tri.m_v0, max(tri.m_v1, tri.m_v2));
+    const int32_t halfPixel = SW_RASTER_SUBPIXEL_SCALE / 2;
+    tri.m_minPixel = max((minPos - halfPixel + SW_RASTER_SUBPIXEL_SCALE - 1) >> SW_RASTER_SUBPIXEL_BITS, int2(0, 0));
+    tri.m_maxPixel = min((maxPos - halfPixel) >> SW_RASTER_SUBPIXEL_BITS, int2(renderSize) - 1);
+    tri.m_maxPixel = min(tri.m_maxPixel, tri.m_minPixel + SW_RASTER_MAX_MESHLET_PIXELS);
+    return tri;
+}
+
+bool RasterizePixel(const RasterTriangle& tri, int2 pixel, float& depth)
+{
+    int2 center = pixel * SW_RASTER_SUBPIXEL_SCALE + SW_RASTER_SUBPIXEL_SCALE / 2;
+    int3 w = int3(EdgeFunction(tri.m_v1, tri.m_v2, center), EdgeFunction(tri.m_v2, tri.m_v0, center), EdgeFunction(tri.m_v0, tri.m_v1, center));
+
+    depth = dot(float3(w), tri.m_depth) * tri.m_rcpArea;
+    return w.x + tri.m_bias.x >= 0 && w.y + tri.m_bias.y >= 0 && w.z + tri.m_bias.z >= 0;
+}
+
+void RasterizeTriangle(const RasterTriangle& tri, uint32_t visibilityID, uint2 renderSize, eastl::vector<uint64_t>& visibilityBuffer)
+{
+    if (!tri.m_bVisible)
+    {
+        return;
+    }
+
+    for (int32_t y = tri.m_minPixel.y; y <= tri.m_maxPixel.y; ++y)
+    {
+        for (int32_t x = tri.m_minPixel.x; x <= tri.m_maxPixel.x; ++x)
+        {
+            float depth;
+            if (RasterizePixel(tri, int2(x, y), depth))
+            {
+                uint64_t& texel = visibilityBuffer[y * renderSize.x + x];
+                texel = max(texel, PackVisibilityTexel(visibilityID, depth));
+            }
+        }
+    }
+}
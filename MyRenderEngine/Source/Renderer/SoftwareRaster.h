@@ -0,0 +1,30 @@
+#pragma once
+#include "Utils/math.h"
+#include "SoftwareRaster.hlsli"
+#include "EASTL/vector.h"
+
+// CPU reference of the coverage and depth rules of SoftwareRaster.hlsli
+
+struct RasterTriangle
+{
+    int2 m_v0;              //< Fixed point pixel positions, clockwise on the screen
+    int2 m_v1;
+    int2 m_v2;
+    float3 m_depth;
+    float m_rcpArea;
+    int3 m_bias;            //< Top-left rule
+    int2 m_minPixel;
+    int2 m_maxPixel;
+    bool m_bVisible;
+    bool m_bFrontFace;
+};
+
+bool IsSoftwareRasterMeshlet(const float4& aabb, const float2& renderSize);
+uint64_t PackVisibilityTexel(uint32_t visibilityID, float depth);
+float3 ClipToScreen(const float4& clipPos, const float2& renderSize);
+
+RasterTriangle SetupRasterTriangle(const float3& p0, const float3& p1, const float3& p2, uint2 renderSize, bool bDoubleSided, bool bFrontFaceCCW);
+bool RasterizePixel(const RasterTriangle& tri, int2 pixel, float& depth);
+
+// The loop of a thread of cs_raster, visibilityBuffer has renderSize.x * renderSize.y texels
+void RasterizeTriangle(const RasterTriangle& tri, uint32_t visibilityID, uint2 renderSize, eastl::vector<uint64_t>& visibilityBuffer);
@@ -0,0 +1,270 @@
+#include "StagingFill.h"
+#include "Utils/assert.h"
+#include "Utils/math.h"
+#include "enkiTS/TaskScheduler.h"
+#include "sokol/sokol_time.h"
+#include "EASTL/atomic.h"
+#include "EASTL/algorithm.h"
+#include <fstream>
+#include <Windows.h>
+
+#define STAGING_FILL_SECTOR_SIZE 4096       //< Unbuffered reads are aligned to it, a multiple of the sector size of the disks
+
+static void CopyRows(char* pDstData, uint32_t dstRowPitch, const char* pSrcData, uint32_t srcRowPitch, uint32_t rowCount)
+{
+    if (dstRowPitch == srcRowPitch)
+    {
+        memcpy(pDstData, pSrcData, (size_t) rowCount * srcRowPitch);
+        return;
+    }
+
+    for (uint32_t row = 0; row < rowCount; ++row)
+    {
+        memcpy(pDstData + (size_t) dstRowPitch * row, pSrcData + (size_t) srcRowPitch * row, srcRowPitch);
+    }
+}
+
+// Reads the range with FILE_FLAG_NO_BUFFERING, so the file cache is neither used nor filled. The read is widened to sector
+// boundaries, the returned memory must be released with VirtualFree, *ppData points to the requested range in it
+static char* ReadUnbuffered(const eastl::string& file, uint64_t offset, uint64_t size, const char** ppData)
+{
+    HANDLE hFile = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        return nullptr;
+    }
+
+    uint64_t alignedOffset = offset & ~((uint64_t) STAGING_FILL_SECTOR_SIZE - 1);
+    uint64_t alignedSize = (offset + size - alignedOffset + STAGING_FILL_SECTOR_SIZE - 1) & ~((uint64_t) STAGING_FILL_SECTOR_SIZE - 1);
+
+    // Page aligned, which is a multiple of the sector size
+    char* pBuffer = (char*) VirtualAlloc(nullptr, (SIZE_T) alignedSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+
+    uint64_t readSize = 0;
+    while (pBuffer != nullptr && readSize < alignedSize)
+    {
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = (DWORD) (alignedOffset + readSize);
+        overlapped.OffsetHigh = (DWORD) ((alignedOffset + readSize) >> 32);
+
+        DWORD requestSize = (DWORD) eastl::min(alignedSize - readSize, (uint64_t) 64 * 1024 * 1024);
+        DWORD bytesRead = 0;
+        if (!ReadFile(hFile, pBuffer + readSize, requestSize, &bytesRead, &overlapped))
+        {
+            break;
+        }
+
+        readSize += bytesRead;
+        if (bytesRead < requestSize)
+        {
+            break;  //< The end of the file is within the last sector
+        }
+    }
+
+    CloseHandle(hFile);
+
+    if (readSize < offset + size - alignedOffset)
+    {
+        if (pBuffer != nullptr)
+        {
+            VirtualFree(pBuffer, 0, MEM_RELEASE);
+        }
+        return nullptr;
+    }
+
+    *ppData = pBuffer + (offset - alignedOffset);
+    return pBuffer;
+}
+
+void StagingFill::FromMemory(enki::TaskScheduler* pTS, const eastl::vector<StagingFillRegion>& regions, const void* pSrcData)
+{
+    eastl::vector<Chunk> chunks;
+    BuildChunks(regions, chunks);
+
+    Execute(pTS, (uint32_t) chunks.size(), [&](uint32_t i)
+        {
+            const Chunk& chunk = chunks[i];
+            const StagingFillRegion& region = regions[chunk.m_region];
+
+            char* pDstData = region.m_pDstData + (uint64_t) chunk.m_firstRow * region.m_dstRowPitch;
+            const char* pSrc = (const char*) pSrcData + region.m_srcOffset + (uint64_t) chunk.m_firstRow * region.m_srcRowPitch;
+
+            CopyRows(pDstData, region.m_dstRowPitch, pSrc, region.m_srcRowPitch, chunk.m_rowCount);
+        });
+}
+
+bool StagingFill::FromFile(enki::TaskScheduler* pTS, const eastl::vector<StagingFillRegion>& regions, const eastl::string& file, bool bUnbuffered)
+{
+    eastl::vector<Chunk> chunks;
+    BuildChunks(regions, chunks);
+
+    eastl::atomic<bool> bFailed{ false };
+
+    Execute(pTS, (uint32_t) chunks.size(), [&](uint32_t i)
+        {
+            const Chunk& chunk = chunks[i];
+            const StagingFillRegion& region = regions[chunk.m_region];
+
+            char* pDstData = region.m_pDstData + (uint64_t) chunk.m_firstRow * region.m_dstRowPitch;
+            uint64_t srcOffset = region.m_srcOffset + (uint64_t) chunk.m_firstRow * region.m_srcRowPitch;
+
+            if (bUnbuffered)
+            {
+                const char* pSrc = nullptr;
+                char* pBuffer = ReadUnbuffered(file, srcOffset, (uint64_t) chunk.m_rowCount * region.m_srcRowPitch, &pSrc);
+                if (pBuffer == nullptr)
+                {
+                    bFailed = true;
+                    return;
+                }
+
+                CopyRows(pDstData, region.m_dstRowPitch, pSrc, region.m_srcRowPitch, chunk.m_rowCount);
+                VirtualFree(pBuffer, 0, MEM_RELEASE);
+                return;
+            }
+
+            std::ifstream is;
+            is.open(file.c_str(), std::ios::binary);
+            if (is.fail())
+            {
+                bFailed = true;
+                return;
+            }
+
+            is.seekg(srcOffset);
+
+            if (region.m_dstRowPitch == region.m_srcRowPitch)
+            {
+                is.read(pDstData, (std::streamsize) chunk.m_rowCount * region.m_srcRowPitch);
+            }
+            else
+            {
+                for (uint32_t row = 0; row < chunk.m_rowCount; ++row)
+                {
+                    is.read(pDstData + (size_t) region.m_dstRowPitch * row, region.m_srcRowPitch);
+                }
+            }
+
+            if (is.fail())
+            {
+                bFailed = true;
+            }
+        });
+
+    return !bFailed;
+}
+
+void StagingFill::FromDecoder(enki::TaskScheduler* pTS, const eastl::vector<StagingFillRegion>& regions, const StagingFillDecoder& decoder)
+{
+    eastl::vector<Chunk> chunks;
+    BuildChunks(regions, chunks);
+
+    Execute(pTS, (uint32_t) chunks.size(), [&](uint32_t i)
+        {
+            const Chunk& chunk = chunks[i];
+            const StagingFillRegion& region = regions[chunk.m_region];
+
+            char* pDstData = region.m_pDstData + (uint64_t) chunk.m_firstRow * region.m_dstRowPitch;
+            decoder(chunk.m_region, chunk.m_firstRow, chunk.m_rowCount, pDstData, region.m_dstRowPitch);
+        });
+}
+
+bool StagingFill::RunBenchmark(enki::TaskScheduler* pTS, const eastl::string& file, StagingFillBenchmarkResult& result)
+{
+    std::ifstream is;
+    is.open(file.c_str(), std::ios::binary);
+    if (is.fail())
+    {
+        return false;
+    }
+
+    is.seekg(0, std::ios::end);
+    result.m_fileSize = (uint64_t) is.tellg();
+    is.close();
+
+    // Rows of a 1000 pixels wide RGBA8 texture, padded to the 256 bytes row pitch alignment of D3D12 staging memory
+    const uint32_t srcRowPitch = 4000;
+    const uint32_t dstRowPitch = RoundUpPow2(srcRowPitch, 256);
+    const uint32_t rowNum = (uint32_t) (result.m_fileSize / srcRowPitch);
+    if (rowNum == 0)
+    {
+        return false;
+    }
+
+    eastl::vector<char> stagingMemory((size_t) rowNum * dstRowPitch);
+
+    StagingFillRegion region;
+    region.m_pDstData = stagingMemory.data();
+    region.m_dstRowPitch = dstRowPitch;
+    region.m_srcRowPitch = srcRowPitch;
+    region.m_rowNum = rowNum;
+    region.m_srcOffset = 0;
+
+    eastl::vector<StagingFillRegion> regions;
+    regions.push_back(region);
+
+    // Both paths read without the file cache, so they are measured from the disk every run
+    auto singleThreadFill = [&]()
+    {
+        const char* pFileData = nullptr;
+        char* pBuffer = ReadUnbuffered(file, 0, (uint64_t) rowNum * srcRowPitch, &pFileData);
+        if (pBuffer == nullptr)
+        {
+            return false;
+        }
+
+        CopyRows(stagingMemory.data(), dstRowPitch, pFileData, srcRowPitch, rowNum);
+        VirtualFree(pBuffer, 0, MEM_RELEASE);
+        return true;
+    };
+
+    double megaBytes = (double) rowNum * srcRowPitch / (1024.0 * 1024.0);
+
+    uint64_t startTime = stm_now();
+    bool bSucceeded = singleThreadFill();
+    result.m_singleThreadMBps = megaBytes / (stm_sec(stm_since(startTime)) + 1e-9);
+
+    startTime = stm_now();
+    bSucceeded &= FromFile(pTS, regions, file, true);
+    result.m_parallelMBps = megaBytes / (stm_sec(stm_since(startTime)) + 1e-9);
+
+    return bSucceeded;
+}
+
+void StagingFill::BuildChunks(const eastl::vector<StagingFillRegion>& regions, eastl::vector<Chunk>& chunks)
+{
+    for (uint32_t i = 0; i < (uint32_t) regions.size(); ++i)
+    {
+        const StagingFillRegion& region = regions[i];
+        MY_ASSERT(region.m_dstRowPitch >= region.m_srcRowPitch);
+
+        uint32_t rowsPerChunk = max(STAGING_FILL_CHUNK_SIZE / max(region.m_srcRowPitch, 1u), 1u);
+        for (uint32_t row = 0; row < region.m_rowNum; row += rowsPerChunk)
+        {
+            chunks.push_back({ i, row, min(rowsPerChunk, region.m_rowNum - row) });
+        }
+    }
+}
+
+void StagingFill::Execute(enki::TaskScheduler* pTS, uint32_t chunkCount, const eastl::function<void(uint32_t)>& task)
+{
+    if (chunkCount <= 1 || pTS == nullptr)
+    {
+        for (uint32_t i = 0; i < chunkCount; ++i)
+        {
+            task(i);
+        }
+        return;
+    }
+
+    enki::TaskSet taskSet(chunkCount, [&](enki::TaskSetPartition range, uint32_t threadNum)
+        {
+            for (uint32_t i = range.start; i != range.end; ++i)
+            {
+                task(i);
+            }
+        });
+
+    pTS->AddTaskSetToPipe(&taskSet);
+    pTS->WaitforTask(&taskSet);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "EASTL/vector.h"
+#include "EASTL/string.h"
+#include "EASTL/functional.h"
+
+namespace enki
+{
+    class TaskScheduler;
+}
+
+#define STAGING_FILL_CHUNK_SIZE (1024 * 1024)       //< 1 mb, the copies are split into tasks of about this size
+
+// A subresource or a buffer range in staging memory. Source rows are tightly packed, depth slices are just more rows
+struct StagingFillRegion
+{
+    char* m_pDstData;
+    uint32_t m_dstRowPitch;
+    uint32_t m_srcRowPitch;
+    uint32_t m_rowNum;
+    uint64_t m_srcOffset;       //< In the source memory or file
+};
+
+// Writes rowCount rows of the region, starting at firstRow. Called from task threads
+using StagingFillDecoder = eastl::function<void(uint32_t region, uint32_t firstRow, uint32_t rowCount, char* pDstData, uint32_t dstRowPitch)>;
+
+struct StagingFillBenchmarkResult
+{
+    uint64_t m_fileSize = 0;
+    double m_singleThreadMBps = 0.0;    //< Whole file read into heap memory, then copied to staging on one thread
+    double m_parallelMBps = 0.0;        //< File ranges read into staging memory from task threads, both are cold unbuffered reads
+};
+
+// Fills staging memory from task threads, regions are split into row aligned chunks so a single large mip is filled in parallel too
+class StagingFill
+{
+public:
+    static void FromMemory(enki::TaskScheduler* pTS, const eastl::vector<StagingFillRegion>& regions, const void* pSrcData);
+
+    // Each task reads its rows with its own file handle, without a copy of the file in heap memory.
+    // Unbuffered reads bypass the file cache, they go through a sector aligned buffer of the chunk
+    static bool FromFile(enki::TaskScheduler* pTS, const eastl::vector<StagingFillRegion>& regions, const eastl::string& file, bool bUnbuffered = false);
+
+    static void FromDecoder(enki::TaskScheduler* pTS, const eastl::vector<StagingFillRegion>& regions, const StagingFillDecoder& decoder);
+
+    // Needs no device or window, CPU memory laid out like a staging buffer stands in for it
+    static bool RunBenchmark(enki::TaskScheduler* pTS, const eastl::string& file, StagingFillBenchmarkResult& result);
+
+private:
+    struct Chunk
+    {
+        uint32_t m_region;
+        uint32_t m_firstRow;
+        uint32_t m_rowCount;
+    };
+
+    static void BuildChunks(const eastl::vector<StagingFillRegion>& regions, eastl::vector<Chunk>& chunks);
+    static void Execute(enki::TaskScheduler* pTS, uint32_t chunkCount, const eastl::function<void(uint32_t)>& task);
+};
@@ -185,6 +185,38 @@ bool TextureLoader::Load(const eastl::string& file, bool srgb)
     }
 }
 
+bool TextureLoader::LoadHeader(const eastl::string& file, bool srgb)
+{
+    if (file.find(".dds") == eastl::string::npos)
+    {
+        return false;
+    }
+
+    std::ifstream is;
+    is.open(file.c_str(), std::ios::binary);
+    if (is.fail())
+    {
+        return false;
+    }
+
+    is.seekg(0, std::ios::end);
+    uint32_t length = (uint32_t)is.tellg();
+    is.seekg(0, std::ios::beg);
+
+    m_fileData.resize(eastl::min(length, (uint32_t) ddspp::MAX_HEADER_SIZE));
+    is.read((char*) m_fileData.data(), m_fileData.size());
+    is.close();
+
+    if (!LoadDDS(srgb))
+    {
+        return false;
+    }
+
+    m_pTextureData = nullptr;
+    m_textureSize = length - m_dataOffset;
+    return true;
+}
+
 bool TextureLoader::LoadDDS(bool srgb)
 {
     uint8_t* pData = m_fileData.data();
@@ -204,6 +236,7 @@ bool TextureLoader::LoadDDS(bool srgb)
     m_type = GetTextureType(desc.type, desc.arraySize > 1);
     m_format = GetTextureFormat(desc.format, srgb);
 
+    m_dataOffset = desc.headerSize;
     m_pTextureData = pData + desc.headerSize;
     m_textureSize = (uint32_t) m_fileData.size() - desc.headerSize;
 
@@ -9,6 +9,10 @@ public:
 
     bool Load(const eastl::string& file, bool srgb);
 
+    // Reads only the header of a dds file, the subresources can be uploaded straight from the file at GetDataOffset.
+    // Returns false for other formats, which have to be decoded by Load
+    bool LoadHeader(const eastl::string& file, bool srgb);
+
     uint32_t GetWidth() const { return m_width; }
     uint32_t GetHeight() const { return m_height; }
     uint32_t GetDepth() const { return m_depth; }
@@ -17,6 +21,7 @@ public:
 
     void* GetData() const { return m_pDecompressedData != nullptr ? m_pDecompressedData : m_pTextureData; }
     uint32_t GetDataSize() const { return m_textureSize; }
+    uint32_t GetDataOffset() const { return m_dataOffset; }
     bool Resize(uint32_t width, uint32_t height);
 
 private:
@@ -35,6 +40,7 @@ private:
     void* m_pTextureData = nullptr;
     void* m_pDecompressedData = nullptr;
     uint32_t m_textureSize = 0;
+    uint32_t m_dataOffset = 0;
     
     eastl::vector<uint8_t> m_fileData;
 };
\ No newline at end of file
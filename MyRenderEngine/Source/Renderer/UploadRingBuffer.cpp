@@ -0,0 +1,140 @@
+#include "UploadRingBuffer.h"
+#include "Utils/assert.h"
+#include "Utils/math.h"
+#include "Utils/fmt.h"
+
+UploadRingBuffer::UploadRingBuffer(IRHIDevice* pDevice, const eastl::string& name, uint32_t initialSize)
+{
+    m_pDevice = pDevice;
+    m_name = name;
+    m_frameID = pDevice->GetFrameID();
+
+    CreateBuffer(initialSize);
+}
+
+UploadRingAllocation UploadRingBuffer::Allocate(uint32_t size, uint32_t alignment)
+{
+    MY_ASSERT(size > 0 && alignment > 0 && alignment % 4 == 0);     //< Offsets stay usable with the raw buffer view
+
+    BeginFrame(m_pDevice->GetFrameID());
+
+    UploadRingAllocation allocation;
+
+    while (true)
+    {
+        // Wraps to the start when the range doesn't fit before the end, the rest of the ring is taken by this frame
+        uint32_t offset = (m_head + alignment - 1) / alignment * alignment;
+        uint64_t consumedBytes = (uint64_t) offset - m_head + size;
+        if ((uint64_t) offset + size > m_size)
+        {
+            offset = 0;
+            consumedBytes = (uint64_t) m_size - m_head + size;
+        }
+
+        if (m_pBuffer != nullptr && m_usedBytes + consumedBytes <= m_size)
+        {
+            m_head = offset + size;
+            m_usedBytes += (uint32_t) consumedBytes;
+            m_frameBytes += (uint32_t) consumedBytes;
+            m_uploadBytes += (uint32_t) consumedBytes;
+
+            allocation.m_pBuffer = m_pBuffer.get();
+            allocation.m_pSRV = m_pSRV.get();
+            allocation.m_pCPUAddress = (char*) m_pBuffer->GetCPUAddress() + offset;
+            allocation.m_offset = offset;
+            return allocation;
+        }
+
+        uint32_t newSize = max(m_size * 2, UPLOAD_RING_BUFFER_INITIAL_SIZE);
+        while (newSize < size * 2)
+        {
+            newSize *= 2;
+        }
+
+        ++m_growCount;
+        if (!CreateBuffer(newSize))
+        {
+            return allocation;
+        }
+    }
+}
+
+void UploadRingBuffer::BeginFrame(uint64_t frameID)
+{
+    if (frameID == m_frameID)
+    {
+        return;
+    }
+
+    if (m_frameBytes > 0)
+    {
+        m_frames.push_back({ m_frameID, m_frameBytes });
+    }
+    m_frameID = frameID;
+    m_frameBytes = 0;
+    m_uploadBytes = 0;
+
+    // Frames are recycled in order, the GPU is done with them once the frame RHI_MAX_INFLIGHT_FRAMES later begins
+    size_t retiredCount = 0;
+    while (retiredCount < m_frames.size() && m_frames[retiredCount].m_frameID + RHI_MAX_INFLIGHT_FRAMES <= frameID)
+    {
+        m_usedBytes -= m_frames[retiredCount].m_bytes;
+        ++retiredCount;
+    }
+
+    if (retiredCount > 0)
+    {
+        m_frames.erase(m_frames.begin(), m_frames.begin() + retiredCount);
+    }
+
+    for (size_t i = 0; i < m_retiredBuffers.size();)
+    {
+        if (m_retiredBuffers[i].m_frameID + RHI_MAX_INFLIGHT_FRAMES <= frameID)
+        {
+            m_retiredBuffers.erase(m_retiredBuffers.begin() + i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+bool UploadRingBuffer::CreateBuffer(uint32_t size)
+{
+    RHIBufferDesc desc;
+    desc.m_stride = 4;
+    desc.m_size = size;
+    desc.m_memoryType = RHIMemoryType::CPUToGPU;
+    desc.m_usage = RHIBufferUsageBit::RHIBufferUsageRawBuffer;
+
+    // The old buffer and its view may still be used by allocations of this frame and by the frames in flight
+    if (m_pBuffer != nullptr)
+    {
+        RetiredBuffer retired;
+        retired.m_frameID = m_frameID;
+        retired.m_pBuffer = eastl::move(m_pBuffer);
+        retired.m_pSRV = eastl::move(m_pSRV);
+        m_retiredBuffers.push_back(eastl::move(retired));
+    }
+
+    eastl::string name = fmt::format("{} {}", m_name, m_growCount).c_str();
+    m_pBuffer.reset(m_pDevice->CreateBuffer(desc, name));
+    if (m_pBuffer == nullptr)
+    {
+        m_pSRV.reset();
+        return false;
+    }
+
+    RHIShaderResourceViewDesc srvDesc;
+    srvDesc.m_type = RHIShaderResourceViewType::RawBuffer;
+    srvDesc.m_buffer.m_size = size;
+    m_pSRV.reset(m_pDevice->CreateShaderResourceView(m_pBuffer.get(), srvDesc, name));
+
+    m_size = size;
+    m_head = 0;
+    m_usedBytes = 0;
+    m_frameBytes = 0;
+    m_frames.clear();
+    return m_pSRV != nullptr;
+}
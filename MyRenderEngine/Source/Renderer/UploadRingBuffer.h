@@ -0,0 +1,65 @@
+#pragma once
+#include "RHI/RHI.h"
+#include "EASTL/unique_ptr.h"
+#include "EASTL/vector.h"
+#include "EASTL/string.h"
+
+#define UPLOAD_RING_BUFFER_INITIAL_SIZE (1024 * 1024)
+
+struct UploadRingAllocation
+{
+    IRHIBuffer* m_pBuffer = nullptr;
+    IRHIDescriptor* m_pSRV = nullptr;   //< Raw buffer view of the whole ring, m_offset is in bytes
+    char* m_pCPUAddress = nullptr;      //< Already offset
+    uint32_t m_offset = 0;
+};
+
+// Persistently mapped CPU to GPU memory for data rewritten every frame. Ranges of a frame are recycled RHI_MAX_INFLIGHT_FRAMES frames later,
+// when the frames in flight don't fit the ring is replaced with one twice the size, and the old one is deleted after its frames are done.
+// Allocations made before a grow keep pointing to the old ring, which stays alive for RHI_MAX_INFLIGHT_FRAMES frames.
+// Not thread safe
+class UploadRingBuffer
+{
+public:
+    UploadRingBuffer(IRHIDevice* pDevice, const eastl::string& name, uint32_t initialSize = UPLOAD_RING_BUFFER_INITIAL_SIZE);
+
+    UploadRingAllocation Allocate(uint32_t size, uint32_t alignment = 4);
+
+    uint32_t GetSize() const { return m_size; }
+    uint32_t GetFrameBytes() const { return m_uploadBytes; }    //< Of the newest frame which allocated, including the padding
+    uint32_t GetGrowCount() const { return m_growCount; }
+
+private:
+    struct FrameUsage
+    {
+        uint64_t m_frameID;
+        uint32_t m_bytes;
+    };
+
+    struct RetiredBuffer
+    {
+        uint64_t m_frameID;     //< Last frame which allocated from it
+        eastl::unique_ptr<IRHIBuffer> m_pBuffer;
+        eastl::unique_ptr<IRHIDescriptor> m_pSRV;
+    };
+
+    void BeginFrame(uint64_t frameID);
+    bool CreateBuffer(uint32_t size);
+
+private:
+    IRHIDevice* m_pDevice = nullptr;
+    eastl::string m_name;
+
+    eastl::unique_ptr<IRHIBuffer> m_pBuffer;
+    eastl::unique_ptr<IRHIDescriptor> m_pSRV;
+    uint32_t m_size = 0;
+    uint32_t m_head = 0;
+    uint32_t m_usedBytes = 0;       //< Of the frames in flight, they lie in one piece ending at m_head
+
+    uint64_t m_frameID = 0;
+    uint32_t m_frameBytes = 0;      //< Of the current frame in the current buffer
+    uint32_t m_uploadBytes = 0;     //< Of the current frame in any buffer
+    eastl::vector<FrameUsage> m_frames;
+    eastl::vector<RetiredBuffer> m_retiredBuffers;
+    uint32_t m_growCount = 0;
+};
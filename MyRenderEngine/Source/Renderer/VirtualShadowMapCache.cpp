@@ -0,0 +1,346 @@
+#include "VirtualShadowMapCache.h"
+#include "Utils/assert.h"
+#include "EASTL/sort.h"
+#include "EASTL/algorithm.h"
+#include <float.h>
+
+#define VSM_KEY_VIEW_MASK 0xFFF0000000000000ull
+
+// Sign extended from the 26 bits of the key
+inline int2 GetPageFromKey(uint64_t key)
+{
+    int32_t x = (int32_t) ((uint32_t) (key >> 26) << 6) >> 6;
+    int32_t y = (int32_t) ((uint32_t) key << 6) >> 6;
+    return int2(x, y);
+}
+
+VirtualShadowMapCache::VirtualShadowMapCache(uint32_t physicalPageCount, uint32_t maxRenderedPages)
+{
+    m_pages.resize(physicalPageCount);
+    m_maxRenderedPages = maxRenderedPages;
+
+    // Popped from the back, so the pool is filled from the first page
+    m_freePages.reserve(physicalPageCount);
+    for (uint32_t i = physicalPageCount; i > 0; --i)
+    {
+        m_freePages.push_back(i - 1);
+    }
+}
+
+void VirtualShadowMapCache::BeginFrame()
+{
+    ++m_frame;
+    m_renderList.clear();
+    m_evictionList.clear();
+    m_bEvictionListValid = false;
+}
+
+uint32_t VirtualShadowMapCache::RequestPage(uint32_t view, int2 page)
+{
+    uint64_t key = GetVirtualShadowMapPageKey(view, page);
+
+    uint32_t physicalPage = VSM_INVALID_PAGE;
+
+    auto iter = m_pageMap.find(key);
+    if (iter != m_pageMap.end())
+    {
+        physicalPage = iter->second;
+        m_pages[physicalPage].m_lastUsedFrame = m_frame;
+
+        if (!m_pages[physicalPage].m_bDirty)
+        {
+            return physicalPage;
+        }
+
+        if (m_renderList.size() >= m_maxRenderedPages)
+        {
+            return VSM_INVALID_PAGE;    //< Stays dirty, the coarser levels are used until it is rendered
+        }
+    }
+    else
+    {
+        if (m_renderList.size() >= m_maxRenderedPages)
+        {
+            return VSM_INVALID_PAGE;
+        }
+
+        physicalPage = AllocatePage();
+        if (physicalPage == VSM_INVALID_PAGE)
+        {
+            return VSM_INVALID_PAGE;
+        }
+
+        PhysicalPage& newPage = m_pages[physicalPage];
+        newPage.m_key = key;
+        newPage.m_lastUsedFrame = m_frame;
+        newPage.m_bResident = true;
+        m_pageMap.insert(eastl::make_pair(key, physicalPage));
+    }
+
+    m_pages[physicalPage].m_bDirty = false;
+    m_renderList.push_back({ view, page, physicalPage });
+
+    return physicalPage;
+}
+
+uint32_t VirtualShadowMapCache::FindPage(uint32_t view, int2 page) const
+{
+    auto iter = m_pageMap.find(GetVirtualShadowMapPageKey(view, page));
+    if (iter == m_pageMap.end() || m_pages[iter->second].m_bDirty)
+    {
+        return VSM_INVALID_PAGE;
+    }
+
+    return iter->second;
+}
+
+void VirtualShadowMapCache::InvalidatePages(uint32_t view, int2 pageMin, int2 pageMax)
+{
+    if (pageMin.x > pageMax.x || pageMin.y > pageMax.y)
+    {
+        return;
+    }
+
+    // Large rectangles test the resident pages instead of looking up every page in them
+    uint64_t area = (uint64_t) (pageMax.x - pageMin.x + 1) * (uint64_t) (pageMax.y - pageMin.y + 1);
+    if (area > m_pageMap.size())
+    {
+        uint64_t viewKey = GetVirtualShadowMapPageKey(view, int2(0, 0)) & VSM_KEY_VIEW_MASK;
+        for (size_t i = 0; i < m_pages.size(); ++i)
+        {
+            PhysicalPage& physicalPage = m_pages[i];
+            if (!physicalPage.m_bResident || (physicalPage.m_key & VSM_KEY_VIEW_MASK) != viewKey)
+            {
+                continue;
+            }
+
+            int2 page = GetPageFromKey(physicalPage.m_key);
+            if (page.x >= pageMin.x && page.x <= pageMax.x && page.y >= pageMin.y && page.y <= pageMax.y)
+            {
+                physicalPage.m_bDirty = true;
+            }
+        }
+        return;
+    }
+
+    for (int32_t y = pageMin.y; y <= pageMax.y; ++y)
+    {
+        for (int32_t x = pageMin.x; x <= pageMax.x; ++x)
+        {
+            auto iter = m_pageMap.find(GetVirtualShadowMapPageKey(view, int2(x, y)));
+            if (iter != m_pageMap.end())
+            {
+                m_pages[iter->second].m_bDirty = true;
+            }
+        }
+    }
+}
+
+void VirtualShadowMapCache::ReleaseView(uint32_t view)
+{
+    uint64_t viewKey = GetVirtualShadowMapPageKey(view, int2(0, 0)) & VSM_KEY_VIEW_MASK;
+
+    for (uint32_t i = 0; i < (uint32_t) m_pages.size(); ++i)
+    {
+        if (m_pages[i].m_bResident && (m_pages[i].m_key & VSM_KEY_VIEW_MASK) == viewKey)
+        {
+            FreePage(i);
+        }
+    }
+
+    // Released pages may still be in the render list of this frame
+    m_renderList.erase(eastl::remove_if(m_renderList.begin(), m_renderList.end(), [&](const VirtualShadowMapPageRender& page) { return page.m_view == view; }), m_renderList.end());
+}
+
+uint32_t VirtualShadowMapCache::GetDirtyPageCount() const
+{
+    uint32_t count = 0;
+    for (size_t i = 0; i < m_pages.size(); ++i)
+    {
+        count += m_pages[i].m_bResident && m_pages[i].m_bDirty ? 1 : 0;
+    }
+    return count;
+}
+
+uint32_t VirtualShadowMapCache::AllocatePage()
+{
+    if (!m_freePages.empty())
+    {
+        uint32_t physicalPage = m_freePages.back();
+        m_freePages.pop_back();
+        return physicalPage;
+    }
+
+    // Pages requested in this frame are in use, the others are evicted from the least recently requested one
+    if (!m_bEvictionListValid)
+    {
+        for (uint32_t i = 0; i < (uint32_t) m_pages.size(); ++i)
+        {
+            if (m_pages[i].m_bResident && m_pages[i].m_lastUsedFrame < m_frame)
+            {
+                m_evictionList.push_back(i);
+            }
+        }
+
+        eastl::sort(m_evictionList.begin(), m_evictionList.end(), [&](uint32_t a, uint32_t b) { return m_pages[a].m_lastUsedFrame > m_pages[b].m_lastUsedFrame; });
+        m_bEvictionListValid = true;
+    }
+
+    while (!m_evictionList.empty())
+    {
+        uint32_t physicalPage = m_evictionList.back();
+        m_evictionList.pop_back();
+
+        if (m_pages[physicalPage].m_bResident && m_pages[physicalPage].m_lastUsedFrame < m_frame)
+        {
+            m_pageMap.erase(m_pages[physicalPage].m_key);
+            m_pages[physicalPage] = PhysicalPage();
+            return physicalPage;
+        }
+    }
+
+    return VSM_INVALID_PAGE;
+}
+
+void VirtualShadowMapCache::FreePage(uint32_t physicalPage)
+{
+    MY_ASSERT(m_pages[physicalPage].m_bResident);
+
+    m_pageMap.erase(m_pages[physicalPage].m_key);
+    m_pages[physicalPage] = PhysicalPage();
+    m_freePages.push_back(physicalPage);
+}
+
+uint64_t GetVirtualShadowMapPageKey(uint32_t view, int2 page)
+{
+    MY_ASSERT(view < 4096);
+
+    // 12 bits of view, 26 bits of x and y each
+    return ((uint64_t) view << 52) | ((uint64_t) ((uint32_t) page.x & 0x3FFFFFF) << 26) | (uint64_t) ((uint32_t) page.y & 0x3FFFFFF);
+}
+
+inline void GetLightBasis(const float3& lightDir, float3& right, float3& up)
+{
+    float3 upRef = fabsf(lightDir.y) > 0.99f ? float3(1.0f, 0.0f, 0.0f) : float3(0.0f, 1.0f, 0.0f);
+    right = normalize(cross(upRef, lightDir));
+    up = cross(lightDir, right);
+}
+
+inline float4x4 MatrixFromRows(const float4& row0, const float4& row1, const float4& row2, const float4& row3)
+{
+    return transpose(float4x4(row0, row1, row2, row3));
+}
+
+float4x4 GetClipmapPageMatrix(const float3& lightDir, uint32_t level)
+{
+    float3 direction = normalize(lightDir);
+    float3 right, up;
+    GetLightBasis(direction, right, up);
+
+    float pageWorldSize = VSM_CLIPMAP_BASE_EXTENT * (float) (1 << level) / VSM_LEVEL_PAGES;
+
+    // v goes down as the textures, depth is 0.5 at the origin and larger towards the light
+    return MatrixFromRows(
+        float4(right / pageWorldSize, 0.0f),
+        float4(-up / pageWorldSize, 0.0f),
+        float4(-direction / (2.0f * VSM_DIRECTIONAL_DEPTH_RANGE), 0.5f),
+        float4(0.0f, 0.0f, 0.0f, 1.0f));
+}
+
+int2 GetClipmapPageOrigin(const float4x4& mtxPage, const float3& cameraPos)
+{
+    float4 pos = mul(mtxPage, float4(cameraPos, 1.0f));
+    return int2((int32_t) floorf(pos.x), (int32_t) floorf(pos.y)) - int2(VSM_LEVEL_PAGES / 2, VSM_LEVEL_PAGES / 2);
+}
+
+float4x4 GetLocalLightPageMatrix(const float3& lightPos, uint32_t face)
+{
+    MY_ASSERT(face < 6);
+
+    static const float3 forwards[6] = { {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1} };
+    static const float3 ups[6] = { {0, 1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}, {0, 1, 0}, {0, 1, 0} };
+
+    float3 forward = forwards[face];
+    float3 up = ups[face];
+    float3 right = cross(up, forward);
+
+    // uv = 0.5 + 0.5 * (x, -y) / z in pages, depth = near / z
+    float n = (float) VSM_LOCAL_LIGHT_PAGES * 0.5f;
+    float3 row0 = (right + forward) * n;
+    float3 row1 = (forward - up) * n;
+
+    return MatrixFromRows(
+        float4(row0, -dot(row0, lightPos)),
+        float4(row1, -dot(row1, lightPos)),
+        float4(0.0f, 0.0f, 0.0f, VSM_LOCAL_LIGHT_NEAR),
+        float4(forward, -dot(forward, lightPos)));
+}
+
+float4x4 GetPageViewProjectionMatrix(const float4x4& mtxPage, int2 page)
+{
+    // x' = 2 * (x - page.x) - 1, y' = 1 - 2 * (y - page.y), in homogeneous coordinates
+    float4x4 mtxPageToClip = MatrixFromRows(
+        float4(2.0f, 0.0f, 0.0f, -(2.0f * page.x + 1.0f)),
+        float4(0.0f, -2.0f, 0.0f, 2.0f * page.y + 1.0f),
+        float4(0.0f, 0.0f, 1.0f, 0.0f),
+        float4(0.0f, 0.0f, 0.0f, 1.0f));
+
+    return mul(mtxPageToClip, mtxPage);
+}
+
+bool GetSpherePageRect(const float4x4& mtxPage, const VirtualShadowMapView& view, bool bPerspective, const float3& center, float radius, int2& pageMin, int2& pageMax)
+{
+    float2 rectMin, rectMax;
+
+    if (!bPerspective)
+    {
+        // Page units are uniform in x and y
+        float4 pos = mul(mtxPage, float4(center, 1.0f));
+        float pageRadius = radius * length(float3(mtxPage[0][0], mtxPage[1][0], mtxPage[2][0]));
+
+        rectMin = pos.xy() - pageRadius;
+        rectMax = pos.xy() + pageRadius;
+    }
+    else
+    {
+        // Row 3 is the unit forward axis of the face
+        float4 centerPos = mul(mtxPage, float4(center, 1.0f));
+        if (centerPos.w + radius <= VSM_LOCAL_LIGHT_NEAR)
+        {
+            return false;   //< Behind the face
+        }
+
+        rectMin = float2(FLT_MAX, FLT_MAX);
+        rectMax = float2(-FLT_MAX, -FLT_MAX);
+
+        for (uint32_t i = 0; i < 8; ++i)
+        {
+            float3 corner = center + float3(i & 1 ? radius : -radius, i & 2 ? radius : -radius, i & 4 ? radius : -radius);
+            float4 pos = mul(mtxPage, float4(corner, 1.0f));
+            if (pos.w <= VSM_LOCAL_LIGHT_NEAR)
+            {
+                // Boxes crossing the near plane cover the whole face
+                rectMin = float2((float) view.m_pageOrigin.x, (float) view.m_pageOrigin.y);
+                rectMax = rectMin + (float) view.m_pageCount;
+                break;
+            }
+
+            rectMin = min(rectMin, pos.xy() / pos.w);
+            rectMax = max(rectMax, pos.xy() / pos.w);
+        }
+    }
+
+    pageMin = int2((int32_t) floorf(rectMin.x), (int32_t) floorf(rectMin.y));
+    pageMax = int2((int32_t) floorf(rectMax.x), (int32_t) floorf(rectMax.y));
+
+    if (bPerspective)
+    {
+        int2 tableMin = view.m_pageOrigin;
+        int2 tableMax = view.m_pageOrigin + int2((int32_t) view.m_pageCount - 1, (int32_t) view.m_pageCount - 1);
+
+        pageMin = max(pageMin, tableMin);
+        pageMax = min(pageMax, tableMax);
+    }
+
+    return pageMin.x <= pageMax.x && pageMin.y <= pageMax.y;
+}
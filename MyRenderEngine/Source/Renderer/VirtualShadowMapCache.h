@@ -0,0 +1,91 @@
+#pragma once
+#include "Utils/math.h"
+#include "RHI/RHIDefines.h"
+#include "VirtualShadowMap.hlsli"
+#include "EASTL/vector.h"
+#include "EASTL/hash_map.h"
+
+#define VSM_MAX_RENDERED_PAGES 128      //< Pages rendered in a frame, the other requests are served in the next frames
+
+struct VirtualShadowMapPageRender
+{
+    uint32_t m_view;
+    int2 m_page;
+    uint32_t m_physicalPage;
+};
+
+// Virtual pages of the shadow map views mapped to the physical pages of the pool. Pages stay resident until they are evicted for
+// new requests, least recently requested first, and are rendered again only when they are invalidated by moving geometry.
+// Pages of the clipmap levels are in absolute light space, so panning the camera only requests the uncovered pages
+class VirtualShadowMapCache
+{
+public:
+    VirtualShadowMapCache(uint32_t physicalPageCount, uint32_t maxRenderedPages = VSM_MAX_RENDERED_PAGES);
+
+    // Clears the render list of the last frame
+    void BeginFrame();
+
+    // Returns the physical page holding the virtual page, which is allocated and added to the render list if it is not resident or dirty.
+    // VSM_INVALID_PAGE if no physical page can be evicted or the pages rendered in this frame reached the budget
+    uint32_t RequestPage(uint32_t view, int2 page);
+
+    // Physical page if the virtual page is resident and up to date, without touching it
+    uint32_t FindPage(uint32_t view, int2 page) const;
+
+    // Resident pages in the inclusive rectangle are rendered again when they are requested next time
+    void InvalidatePages(uint32_t view, int2 pageMin, int2 pageMax);
+
+    // Frees all pages of the view, for lights which are moved or replaced
+    void ReleaseView(uint32_t view);
+
+    const eastl::vector<VirtualShadowMapPageRender>& GetRenderList() const { return m_renderList; }
+    uint32_t GetPhysicalPageCount() const { return (uint32_t) m_pages.size(); }
+    uint32_t GetResidentPageCount() const { return (uint32_t) m_pageMap.size(); }
+    uint32_t GetFreePageCount() const { return (uint32_t) m_freePages.size(); }
+    uint32_t GetRenderedPageCount() const { return (uint32_t) m_renderList.size(); }
+    uint32_t GetDirtyPageCount() const;
+    uint64_t GetFrame() const { return m_frame; }
+
+private:
+    uint32_t AllocatePage();
+    void FreePage(uint32_t physicalPage);
+
+private:
+    struct PhysicalPage
+    {
+        uint64_t m_key = 0;
+        uint64_t m_lastUsedFrame = 0;
+        bool m_bResident = false;
+        bool m_bDirty = false;
+    };
+
+    eastl::vector<PhysicalPage> m_pages;
+    eastl::vector<uint32_t> m_freePages;
+    eastl::hash_map<uint64_t, uint32_t> m_pageMap;  //< Key of the virtual page to its physical page
+
+    // Pages not requested in this frame, oldest last, built at the first eviction of a frame
+    eastl::vector<uint32_t> m_evictionList;
+    bool m_bEvictionListValid = false;
+
+    eastl::vector<VirtualShadowMapPageRender> m_renderList;
+    uint32_t m_maxRenderedPages;
+    uint64_t m_frame = 0;
+};
+
+uint64_t GetVirtualShadowMapPageKey(uint32_t view, int2 page);
+
+// Light space of the clipmap levels, page units of the level in x and y, reversed z depth along the light
+float4x4 GetClipmapPageMatrix(const float3& lightDir, uint32_t level);
+
+// First page of the window of the level, which is centered at the page of the camera
+int2 GetClipmapPageOrigin(const float4x4& mtxPage, const float3& cameraPos);
+
+// Perspective cube face of a local light in page units, reversed z with an infinite far plane
+float4x4 GetLocalLightPageMatrix(const float3& lightPos, uint32_t face);
+
+// Clip space of one page of the view, the page covers the whole viewport
+float4x4 GetPageViewProjectionMatrix(const float4x4& mtxPage, int2 page);
+
+// Pages touched by a sphere. Clipmap pages are not clamped to the window, pages outside it may still be resident.
+// Cube faces are clamped to their page table, false if the sphere is outside it
+bool GetSpherePageRect(const float4x4& mtxPage, const VirtualShadowMapView& view, bool bPerspective, const float3& center, float radius, int2& pageMin, int2& pageMax);
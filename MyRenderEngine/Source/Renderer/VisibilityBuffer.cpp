@@ -0,0 +1,56 @@
+#include "VisibilityBuffer.h"
+
+uint32_t PackVisibilityID(uint32_t visibleMeshletIndex, uint32_t triangleIndex, bool bFrontFace)
+{
+    return (visibleMeshletIndex << VISIBILITY_BUFFER_MESHLET_SHIFT) | (bFrontFace ? VISIBILITY_BUFFER_FRONT_FACE_BIT : 0) | triangleIndex;
+}
+
+void UnpackVisibilityID(uint32_t id, uint32_t& visibleMeshletIndex, uint32_t& triangleIndex, bool& bFrontFace)
+{
+    visibleMeshletIndex = id >> VISIBILITY_BUFFER_MESHLET_SHIFT;
+    triangleIndex = id & VISIBILITY_BUFFER_TRIANGLE_MASK;
+    bFrontFace = (id & VISIBILITY_BUFFER_FRONT_FACE_BIT) != 0;
+}
+
+Barycentrics ComputeBarycentrics(const float4& clipPos0, const float4& clipPos1, const float4& clipPos2, const float2& ndcPos, const float2& renderSize)
+{
+    float3 invW = 1.0f / float3(clipPos0.w, clipPos1.w, clipPos2.w);
+
+    float2 ndc0 = clipPos0.xy() * invW.x;
+    float2 ndc1 = clipPos1.xy() * invW.y;
+    float2 ndc2 = clipPos2.xy() * invW.z;
+
+    // Weights divided by w are linear in screen space
+    float2 edge0 = ndc2 - ndc1;
+    float2 edge1 = ndc0 - ndc1;
+    float invDet = 1.0f / (edge0.x * edge1.y - edge0.y * edge1.x);
+    float3 ddxOverW = float3(ndc1.y - ndc2.y, ndc2.y - ndc0.y, ndc0.y - ndc1.y) * invDet * invW;
+    float3 ddyOverW = float3(ndc2.x - ndc1.x, ndc0.x - ndc2.x, ndc1.x - ndc0.x) * invDet * invW;
+    float ddxInvW = ddxOverW.x + ddxOverW.y + ddxOverW.z;
+    float ddyInvW = ddyOverW.x + ddyOverW.y + ddyOverW.z;
+
+    float2 delta = ndcPos - ndc0;
+    float interpInvW = invW.x + delta.x * ddxInvW + delta.y * ddyInvW;
+    float interpW = 1.0f / interpInvW;
+
+    Barycentrics result;
+    result.m_lambda = interpW * (float3(invW.x, 0.0f, 0.0f) + delta.x * ddxOverW + delta.y * ddyOverW);
+
+    // One pixel step in ndc, y of the screen is down
+    float2 pixelSize = 2.0f / renderSize;
+    ddxOverW *= pixelSize.x;
+    ddyOverW *= -pixelSize.y;
+    ddxInvW *= pixelSize.x;
+    ddyInvW *= -pixelSize.y;
+
+    result.m_ddx = (result.m_lambda * interpInvW + ddxOverW) / (interpInvW + ddxInvW) - result.m_lambda;
+    result.m_ddy = (result.m_lambda * interpInvW + ddyOverW) / (interpInvW + ddyInvW) - result.m_lambda;
+
+    return result;
+}
+
+float2 GetPixelNdcPosition(uint2 pos, const float2& renderSize)
+{
+    float2 screenUV = (float2((float) pos.x, (float) pos.y) + 0.5f) / renderSize;
+    return (screenUV * 2.0f - 1.0f) * float2(1.0f, -1.0f);
+}
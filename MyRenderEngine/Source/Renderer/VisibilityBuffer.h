@@ -0,0 +1,39 @@
+#pragma once
+#include "Utils/math.h"
+#include "VisibilityBuffer.hlsli"
+
+// CPU reference of the visibility buffer encoding and of the attribute reconstruction in VisibilityBufferResolve.hlsl
+
+struct Barycentrics
+{
+    float3 m_lambda;    //< Perspective correct weights of the 3 vertices
+    float3 m_ddx;       //< Change of the weights to the next pixel in x
+    float3 m_ddy;
+};
+
+uint32_t PackVisibilityID(uint32_t visibleMeshletIndex, uint32_t triangleIndex, bool bFrontFace);
+void UnpackVisibilityID(uint32_t id, uint32_t& visibleMeshletIndex, uint32_t& triangleIndex, bool& bFrontFace);
+
+// Weights of a pixel in a triangle and their screen space derivatives, from the clip positions of the vertices. ndcPos is the pixel center
+Barycentrics ComputeBarycentrics(const float4& clipPos0, const float4& clipPos1, const float4& clipPos2, const float2& ndcPos, const float2& renderSize);
+
+// Center of the pixel in ndc, y is up
+float2 GetPixelNdcPosition(uint2 pos, const float2& renderSize);
+
+template<typename T>
+T InterpolateAttribute(const Barycentrics& barycentrics, const T& a0, const T& a1, const T& a2)
+{
+    return a0 * barycentrics.m_lambda.x + a1 * barycentrics.m_lambda.y + a2 * barycentrics.m_lambda.z;
+}
+
+template<typename T>
+T InterpolateAttributeDDX(const Barycentrics& barycentrics, const T& a0, const T& a1, const T& a2)
+{
+    return a0 * barycentrics.m_ddx.x + a1 * barycentrics.m_ddx.y + a2 * barycentrics.m_ddx.z;
+}
+
+template<typename T>
+T InterpolateAttributeDDY(const Barycentrics& barycentrics, const T& a0, const T& a1, const T& a2)
+{
+    return a0 * barycentrics.m_ddy.x + a1 * barycentrics.m_ddy.y + a2 * barycentrics.m_ddy.z;
+}
@@ -0,0 +1,75 @@
+#include "Tests.h"
+#include "RHI/RHIDescriptorAllocator.h"
+#include "Core/Engine.h"
+#include "Utils/log.h"
+#include "Utils/parallel_for.h"
+#include "sokol/sokol_time.h"
+#include "EASTL/atomic.h"
+
+// Allocates and frees from all task threads with a standalone allocator, which needs no descriptor heap or GPU
+void RunDescriptorAllocatorBenchmark(TestContext& context)
+{
+    const uint32_t taskCount = Engine::GetInstance()->GetTaskScheduler()->GetNumTaskThreads() * 4;
+    const uint32_t iterationCount = 100000;
+
+    RHIDescriptorAllocator allocator(65536, "Benchmark");
+    eastl::atomic<uint64_t> frameID{ 0 };
+
+    uint64_t startTime = stm_now();
+
+    ParallelFor(taskCount, [&](uint32_t taskIndex)
+        {
+            struct Range
+            {
+                uint32_t m_index;
+                uint32_t m_count;
+            };
+            eastl::vector<Range> ranges;
+            uint32_t seed = taskIndex * 7919 + 1;
+
+            for (uint32_t i = 0; i < iterationCount; ++i)
+            {
+                seed = seed * 1664525 + 1013904223;
+                uint32_t random = seed >> 16;
+
+                if (ranges.size() < 256 && (random & 3) != 0)
+                {
+                    uint32_t count = (random & 15) == 0 ? 2 + (random >> 4) % 31 : 1; //< Mostly single descriptors, sometimes a table
+                    ranges.push_back({ allocator.Allocate(count), count });
+                }
+                else if (!ranges.empty())
+                {
+                    Range range = ranges.back();
+                    ranges.pop_back();
+
+                    if (random & 8)
+                    {
+                        allocator.Free(range.m_index, range.m_count);
+                    }
+                    else
+                    {
+                        allocator.DeferredFree(range.m_index, range.m_count, frameID.load());
+                    }
+                }
+
+                if (i % 1024 == 0)
+                {
+                    allocator.ProcessDeferredFrees(frameID.fetch_add(1));
+                }
+            }
+
+            for (size_t i = 0; i < ranges.size(); ++i)
+            {
+                allocator.Free(ranges[i].m_index, ranges[i].m_count);
+            }
+        });
+
+    double time = stm_ms(stm_since(startTime));
+
+    allocator.ProcessDeferredFrees(UINT64_MAX);
+    RHIDescriptorAllocatorStats stats = allocator.GetStats();
+    context.Check("Every descriptor is freed", stats.m_allocatedCount == stats.m_cachedCount);
+
+    MY_INFO("Descriptor allocator benchmark : {} tasks, {} operations in {:.2f} ms, fragmentation {:.1f}%",
+        taskCount, taskCount * iterationCount, time, stats.m_fragmentation * 100.0f);
+}
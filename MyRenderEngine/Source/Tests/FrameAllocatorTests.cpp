@@ -0,0 +1,117 @@
+#include "Tests.h"
+#include "Utils/frame_allocator.h"
+#include "Core/Engine.h"
+#include "Utils/log.h"
+#include "Utils/parallel_for.h"
+#include "sokol/sokol_time.h"
+#include "EASTL/atomic.h"
+
+// Allocates from all task threads with small chunks, so the arenas chain often, and checks which threads get an arena
+void RunFrameAllocatorTests(TestContext& context)
+{
+    enki::TaskScheduler* pTaskScheduler = Engine::GetInstance()->GetTaskScheduler();
+    const uint32_t taskCount = pTaskScheduler->GetNumTaskThreads() * 4;
+    const uint32_t allocationCount = 10000;
+    const size_t allocationSize = 48;
+
+    FrameAllocator allocator(pTaskScheduler, 4096);
+    eastl::atomic<uint32_t> missingArenaCount{ 0 };
+    eastl::atomic<uint32_t> overlapCount{ 0 };
+
+    ParallelFor(taskCount, [&](uint32_t taskIndex)
+        {
+            if (allocator.GetThreadArena() == nullptr)
+            {
+                missingArenaCount.fetch_add(1);
+            }
+
+            // Every allocation is filled with the task index, another task writing to it would overwrite the pattern
+            eastl::vector<uint32_t*> allocations(allocationCount);
+            for (uint32_t i = 0; i < allocationCount; ++i)
+            {
+                allocations[i] = (uint32_t*) allocator.Alloc(allocationSize, 16);
+                for (size_t j = 0; j < allocationSize / sizeof(uint32_t); ++j)
+                {
+                    allocations[i][j] = taskIndex;
+                }
+            }
+
+            for (uint32_t i = 0; i < allocationCount; ++i)
+            {
+                if (allocations[i][0] != taskIndex || allocations[i][allocationSize / sizeof(uint32_t) - 1] != taskIndex)
+                {
+                    overlapCount.fetch_add(1);
+                }
+            }
+        });
+
+    context.Check("Every task thread gets an arena", missingArenaCount.load() == 0);
+    context.Check("Allocations don't overlap", overlapCount.load() == 0);
+    context.Check("Full arenas chain new chunks", allocator.GetAllocatedSize() >= (size_t) taskCount * allocationCount * allocationSize);
+
+    size_t frameSize = allocator.GetAllocatedSize();
+    allocator.Reset();
+    context.Check("Reset reports the high water mark", allocator.GetAllocatedSize() == 0 && allocator.GetLastFrameSize() == frameSize && allocator.GetHighWaterMark() == frameSize);
+
+    // A thread which isn't registered in the task scheduler shares the lock-free chunk
+    LinearAllocator* pThreadArena = nullptr;
+    void* pThreadAllocation = nullptr;
+    std::thread thread([&]()
+        {
+            pThreadArena = allocator.GetThreadArena();
+            pThreadAllocation = allocator.Alloc(allocationSize);
+        });
+    thread.join();
+    context.Check("Unregistered thread falls back to the shared chunk", pThreadArena == nullptr && pThreadAllocation != nullptr && allocator.GetAllocatedSize() == allocationSize);
+}
+
+// Allocates the same sizes from all task threads once with the per thread arenas and once with only the shared lock-free chunk
+void RunFrameAllocatorBenchmark(TestContext& context)
+{
+    enki::TaskScheduler* pTaskScheduler = Engine::GetInstance()->GetTaskScheduler();
+    const uint32_t taskCount = pTaskScheduler->GetNumTaskThreads() * 4;
+    const uint32_t allocationCount = 10000;    //< About 1 MB per task and allocator each frame, as many small batches of a busy frame
+    const uint32_t frameCount = 10;
+    const size_t arenaSize = 1024 * 1024;
+
+    FrameAllocator allocator(pTaskScheduler, arenaSize);
+    ConcurrentLinearAllocator sharedAllocator(arenaSize);
+
+    auto allocSize = [](uint32_t taskIndex, uint32_t i)
+    {
+        return (size_t) 16 + ((taskIndex * 31 + i * 7) & 127);
+    };
+
+    double arenaTime = 0.0;
+    double sharedTime = 0.0;
+
+    for (uint32_t frame = 0; frame < frameCount; ++frame)
+    {
+        uint64_t startTime = stm_now();
+        ParallelFor(taskCount, [&](uint32_t taskIndex)
+            {
+                for (uint32_t i = 0; i < allocationCount; ++i)
+                {
+                    allocator.Alloc(allocSize(taskIndex, i), 16);
+                }
+            });
+        arenaTime += stm_ms(stm_since(startTime));
+
+        startTime = stm_now();
+        ParallelFor(taskCount, [&](uint32_t taskIndex)
+            {
+                for (uint32_t i = 0; i < allocationCount; ++i)
+                {
+                    sharedAllocator.Alloc(allocSize(taskIndex, i), 16);
+                }
+            });
+        sharedTime += stm_ms(stm_since(startTime));
+
+        allocator.Reset();
+        sharedAllocator.Reset();
+    }
+
+    MY_INFO("Frame allocator benchmark : {} tasks, {} allocations per frame, per thread arenas {:.2f} ms, shared chunk {:.2f} ms ({} times found full), high water mark {} KB / {} KB",
+        taskCount, taskCount * allocationCount, arenaTime / frameCount, sharedTime / frameCount, sharedAllocator.GetContentionCount(),
+        allocator.GetHighWaterMark() / 1024, sharedAllocator.GetHighWaterMark() / 1024);
+}
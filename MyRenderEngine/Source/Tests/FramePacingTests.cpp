@@ -0,0 +1,49 @@
+#include "Tests.h"
+#include "Renderer/FramePacer.h"
+#include "RHI/RHIDefines.h"
+#include "Utils/log.h"
+
+// Runs the pacing controller against simulated CPU and GPU timings, which needs no device
+void RunFramePacingTests(TestContext& context)
+{
+    auto simulate = [](uint32_t framesInFlight, bool bPacing, float cpuUs, float gpuUs)
+    {
+        FramePacerSimulationDesc desc;
+        desc.m_framesInFlight = framesInFlight;
+        desc.m_bPacing = bPacing;
+        desc.m_cpuUs = cpuUs;
+        desc.m_gpuUs = gpuUs;
+
+        FramePacerSimulationResult result;
+        FramePacer::Simulate(desc, result);
+
+        MY_INFO("Frame pacing simulation : {} frames in flight, pacing {}, cpu {:.1f} ms, gpu {:.1f} ms : latency {:.2f} ms, frame {:.2f} ms, gpu idle {:.1f}%",
+            framesInFlight, bPacing ? "on" : "off", cpuUs / 1000.0f, gpuUs / 1000.0f,
+            result.m_averageLatencyUs / 1000.0f, result.m_averageFrameUs / 1000.0f, result.m_gpuIdleRatio * 100.0f);
+        return result;
+    };
+
+    for (uint32_t framesInFlight = 2; framesInFlight <= RHI_MAX_INFLIGHT_FRAMES; ++framesInFlight)
+    {
+        FramePacerSimulationResult unpaced = simulate(framesInFlight, false, 4000.0f, 10000.0f);
+        FramePacerSimulationResult paced = simulate(framesInFlight, true, 4000.0f, 10000.0f);
+
+        context.Check(fmt::format("GPU bound, {} frames in flight, lower latency", framesInFlight).c_str(), paced.m_averageLatencyUs < unpaced.m_averageLatencyUs * 0.8f);
+        context.Check(fmt::format("GPU bound, {} frames in flight, GPU kept busy", framesInFlight).c_str(),
+            paced.m_averageFrameUs < unpaced.m_averageFrameUs * 1.02f && paced.m_gpuIdleRatio < 0.02f);
+    }
+
+    {
+        FramePacerSimulationResult unpaced = simulate(RHI_MAX_INFLIGHT_FRAMES, false, 10000.0f, 4000.0f);
+        FramePacerSimulationResult paced = simulate(RHI_MAX_INFLIGHT_FRAMES, true, 10000.0f, 4000.0f);
+
+        context.Check("CPU bound, no delay", paced.m_averageFrameUs < unpaced.m_averageFrameUs * 1.01f && paced.m_averageLatencyUs < unpaced.m_averageLatencyUs * 1.01f);
+    }
+
+    {
+        FramePacerSimulationResult single = simulate(1, false, 4000.0f, 10000.0f);
+        FramePacerSimulationResult paced = simulate(RHI_MAX_INFLIGHT_FRAMES, true, 4000.0f, 10000.0f);
+
+        context.Check("Paced queue outruns a single frame in flight", paced.m_averageFrameUs < single.m_averageFrameUs * 0.8f);
+    }
+}
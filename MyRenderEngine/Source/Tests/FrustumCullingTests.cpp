@@ -0,0 +1,79 @@
+#include "Tests.h"
+#include "World/WorldObjectData.h"
+#include "World/WorldObjectBVH.h"
+#include "Utils/math.h"
+#include "EASTL/sort.h"
+
+// Culls random spheres against the frustums of random cameras with the SIMD, scalar and BVH culling
+void RunFrustumCullingTests(TestContext& context)
+{
+    const uint32_t objectCount = 10003;    //< Not a multiple of the SIMD width, so the tail is culled too
+    const uint32_t frustumCount = 32;
+
+    WorldObjectData objectData;
+    for (uint32_t i = 0; i < objectCount; ++i)
+    {
+        uint32_t id = objectData.Add(WORLD_OBJECT_INVALID_PARENT, i % 3 != 0);
+        objectData.SetLocalTransform(id, float3(context.Random(-200.0f, 200.0f), context.Random(-50.0f, 50.0f), context.Random(-200.0f, 200.0f)), quaternion(0.0f, 0.0f, 0.0f, 1.0f), float3(1.0f, 1.0f, 1.0f));
+        objectData.SetLocalBounds(id, float3(0.0f, 0.0f, 0.0f), context.Random(0.1f, 10.0f));
+    }
+    objectData.Update();
+
+    const float* pCenterX = objectData.GetCenterX();
+    const float* pCenterY = objectData.GetCenterY();
+    const float* pCenterZ = objectData.GetCenterZ();
+    const float* pRadius = objectData.GetRadius();
+
+    WorldObjectBVH bvh;
+    bvh.Build(objectData);
+
+    eastl::vector<uint32_t> visibleObjects(objectCount);
+    eastl::vector<uint32_t> scalarVisibleObjects(objectCount);
+    eastl::vector<uint32_t> bvhVisibleObjects;
+
+    bool bSIMDMatches = true;
+    bool bTailMatches = true;
+    bool bBVHMatches = true;
+    uint32_t visibleCountSum = 0;
+
+    for (uint32_t frustum = 0; frustum < frustumCount; ++frustum)
+    {
+        // As Camera::UpdateCamera, with a finite far plane so all 6 planes cull
+        float3 pos = float3(context.Random(-100.0f, 100.0f), context.Random(-20.0f, 20.0f), context.Random(-100.0f, 100.0f));
+        float3 rotation = float3(context.Random(-60.0f, 60.0f), context.Random(-180.0f, 180.0f), context.Random(-30.0f, 30.0f));
+        float4x4 mtxView = inverse(mul(translation_matrix(pos), rotation_matrix(rotation_quat(rotation))));
+        float4x4 mtxProjection = linalg::perspective_matrix(degree_to_radian(context.Random(30.0f, 90.0f)), context.Random(1.0f, 2.0f), 0.1f, context.Random(50.0f, 300.0f), linalg::pos_z, linalg::zero_to_one);
+
+        float4 planes[6];
+        GetFrustumPlanes(mul(mtxProjection, mtxView), planes);
+
+        uint32_t visibleCount = FrustumCull(planes, 6, pCenterX, pCenterY, pCenterZ, pRadius, objectCount, visibleObjects.data());
+        uint32_t scalarVisibleCount = FrustumCullScalar(planes, 6, pCenterX, pCenterY, pCenterZ, pRadius, objectCount, scalarVisibleObjects.data());
+        bSIMDMatches &= visibleCount == scalarVisibleCount && eastl::equal(visibleObjects.begin(), visibleObjects.begin() + visibleCount, scalarVisibleObjects.begin());
+        visibleCountSum += visibleCount;
+
+        // Counts below and around the SIMD width, starting at an unaligned object
+        for (uint32_t count = 0; count <= 17; ++count)
+        {
+            uint32_t first = frustum + 1;
+            visibleCount = FrustumCull(planes, 6, pCenterX + first, pCenterY + first, pCenterZ + first, pRadius + first, count, visibleObjects.data());
+            scalarVisibleCount = FrustumCullScalar(planes, 6, pCenterX + first, pCenterY + first, pCenterZ + first, pRadius + first, count, scalarVisibleObjects.data());
+            bTailMatches &= visibleCount == scalarVisibleCount && eastl::equal(visibleObjects.begin(), visibleObjects.begin() + visibleCount, scalarVisibleObjects.begin());
+        }
+
+        // The BVH only holds the static objects and returns them in tree order
+        bvhVisibleObjects.clear();
+        bvh.Cull(planes, 6, bvhVisibleObjects);
+        eastl::sort(bvhVisibleObjects.begin(), bvhVisibleObjects.end());
+
+        scalarVisibleCount = FrustumCullScalar(planes, 6, pCenterX, pCenterY, pCenterZ, pRadius, objectCount, scalarVisibleObjects.data());
+        scalarVisibleObjects.erase(eastl::remove_if(scalarVisibleObjects.begin(), scalarVisibleObjects.begin() + scalarVisibleCount, [&](uint32_t id) { return !objectData.IsStatic(id); }), scalarVisibleObjects.end());
+        bBVHMatches &= bvhVisibleObjects == scalarVisibleObjects;
+        scalarVisibleObjects.resize(objectCount);
+    }
+
+    context.Check("Frustums see some of the objects", visibleCountSum > 0 && visibleCountSum < objectCount * frustumCount);
+    context.Check("SIMD culling matches the scalar culling", bSIMDMatches);
+    context.Check("SIMD culling matches the scalar culling for short and unaligned ranges", bTailMatches);
+    context.Check("BVH culling matches the scalar culling of the static objects", bBVHMatches);
+}
@@ -0,0 +1,169 @@
+#include "Tests.h"
+#include "Renderer/GTAOHalfRes.h"
+#include "Core/Engine.h"
+#include "Utils/log.h"
+
+// Checks the upsampling and the temporal accumulation of the half resolution GTAO on random G-buffers on the CPU, which needs no GPU
+void RunGTAOTests(TestContext& context)
+{
+    auto randomNormal = [&]()
+    {
+        return normalize(float3(context.Random(-1.0f, 1.0f), context.Random(-1.0f, 1.0f), context.Random(0.1f, 1.0f)));
+    };
+
+    bool bWeightsSumToOne = GetGTAOUpsampleBilinearWeights(float2(0.0f, 0.0f)) == float4(1.0f, 0.0f, 0.0f, 0.0f);
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        float4 weights = GetGTAOUpsampleBilinearWeights(float2(context.Random(0.0f, 1.0f), context.Random(0.0f, 1.0f)));
+        bWeightsSumToOne = bWeightsSumToOne && fabsf(weights.x + weights.y + weights.z + weights.w - 1.0f) < 1e-5f && weights.x >= 0.0f && weights.w >= 0.0f;
+    }
+    context.Check("bilinear weights sum to one", bWeightsSumToOne);
+
+    const uint2 lowSize = uint2(37, 19);
+    const uint2 highSize = uint2(73, 38);     //< (width + 1) / 2 of the half resolution passes, an odd width clamps the last column
+    const uint32_t lowCount = lowSize.x * lowSize.y;
+
+    eastl::vector<float> lowAO(lowCount);
+    eastl::vector<float> lowDepth(lowCount);
+    eastl::vector<float3> lowNormal(lowCount);
+    for (uint32_t i = 0; i < lowCount; ++i)
+    {
+        lowAO[i] = context.Random(0.0f, 1.0f);
+        lowDepth[i] = context.Random(0.5f, 100.0f);
+        lowNormal[i] = randomNormal();
+    }
+
+    // The half resolution texels are the top left pixels of every 2x2 pixels, so with their own depth and normal even pixels get exactly their texel
+    bool bEvenPixelsExact = true;
+    for (uint32_t y = 0; y < lowSize.y; ++y)
+    {
+        for (uint32_t x = 0; x < lowSize.x; ++x)
+        {
+            uint32_t index = y * lowSize.x + x;
+            float ao = UpsampleGTAO(lowAO, lowDepth, lowNormal, lowSize, uint2(x, y) * 2u, lowDepth[index], lowNormal[index]);
+            bEvenPixelsExact = bEvenPixelsExact && fabsf(ao - lowAO[index]) < 1e-5f;
+        }
+    }
+    context.Check("even pixels take their own texel", bEvenPixelsExact);
+
+    // On a single surface the depth and normal weights are 1, the upsample is bilinear
+    eastl::vector<float> flatDepth(lowCount, 10.0f);
+    eastl::vector<float3> flatNormal(lowCount, float3(0.0f, 0.0f, 1.0f));
+    bool bFlatIsBilinear = true;
+    for (uint32_t y = 0; y < highSize.y; ++y)
+    {
+        for (uint32_t x = 0; x < highSize.x; ++x)
+        {
+            auto load = [&](uint32_t i, uint32_t j) { return lowAO[eastl::min(j, lowSize.y - 1) * lowSize.x + eastl::min(i, lowSize.x - 1)]; };
+            float fx = (x % 2) * 0.5f;
+            float fy = (y % 2) * 0.5f;
+            float top = load(x / 2, y / 2) * (1.0f - fx) + load(x / 2 + 1, y / 2) * fx;
+            float bottom = load(x / 2, y / 2 + 1) * (1.0f - fx) + load(x / 2 + 1, y / 2 + 1) * fx;
+            float bilinear = top * (1.0f - fy) + bottom * fy;
+
+            float ao = UpsampleGTAO(lowAO, flatDepth, flatNormal, lowSize, uint2(x, y), 10.0f, float3(0.0f, 0.0f, 1.0f));
+            bFlatIsBilinear = bFlatIsBilinear && fabsf(ao - bilinear) < 1e-5f;
+        }
+    }
+    context.Check("upsample of a flat surface is bilinear", bFlatIsBilinear);
+
+    // Occluded foreground at depth 1 on the left of texel column edgeX, unoccluded background at depth 10 on the right.
+    // The pixels next to the edge keep the AO of their own surface, a plain bilinear upsample would take half of the other one
+    const uint32_t edgeX = 18;
+    eastl::vector<float> edgeAO(lowCount);
+    eastl::vector<float> edgeDepth(lowCount);
+    for (uint32_t i = 0; i < lowCount; ++i)
+    {
+        bool bForeground = i % lowSize.x < edgeX;
+        edgeAO[i] = bForeground ? 0.0f : 1.0f;
+        edgeDepth[i] = bForeground ? 1.0f : 10.0f;
+    }
+
+    float maxDepthBleeding = 0.0f;
+    for (uint32_t y = 0; y < highSize.y; ++y)
+    {
+        for (uint32_t x = edgeX * 2 - 2; x < edgeX * 2 + 2; ++x)
+        {
+            bool bForeground = x < edgeX * 2;
+            float ao = UpsampleGTAO(edgeAO, edgeDepth, flatNormal, lowSize, uint2(x, y), bForeground ? 1.0f : 10.0f, float3(0.0f, 0.0f, 1.0f));
+            maxDepthBleeding = eastl::max(maxDepthBleeding, bForeground ? ao : 1.0f - ao);
+        }
+    }
+    context.Check("no AO bleeding across depth edges", maxDepthBleeding < 0.01f);
+
+    // Same with a crease of the normals at one depth
+    eastl::vector<float3> creaseNormal(lowCount);
+    for (uint32_t i = 0; i < lowCount; ++i)
+    {
+        creaseNormal[i] = i % lowSize.x < edgeX ? float3(0.0f, 0.0f, 1.0f) : float3(1.0f, 0.0f, 0.0f);
+    }
+
+    float maxNormalBleeding = 0.0f;
+    for (uint32_t y = 0; y < highSize.y; ++y)
+    {
+        for (uint32_t x = edgeX * 2 - 2; x < edgeX * 2 + 2; ++x)
+        {
+            bool bLeft = x < edgeX * 2;
+            float ao = UpsampleGTAO(edgeAO, flatDepth, creaseNormal, lowSize, uint2(x, y), 10.0f, bLeft ? float3(0.0f, 0.0f, 1.0f) : float3(1.0f, 0.0f, 0.0f));
+            maxNormalBleeding = eastl::max(maxNormalBleeding, bLeft ? ao : 1.0f - ao);
+        }
+    }
+    context.Check("no AO bleeding across normal edges", maxNormalBleeding < 0.01f);
+
+    // A pixel facing away from all the texels around it has no weight on any of them, it takes the texel of the closest depth instead of 0 / 0
+    float fallbackAO = UpsampleGTAO(edgeAO, edgeDepth, flatNormal, lowSize, uint2(edgeX * 2 - 1, 4), 9.0f, float3(0.0f, 0.0f, -1.0f));
+    context.Check("closest depth without weights", fallbackAO == 1.0f);
+
+    // The history converges to a constant AO with the frame count capped, a step moves 1 / GTAO_TEMPORAL_MAX_FRAMES of the way and a rejected history restarts
+    float2 history = float2(0.0f, 0.0f);   //< Cleared
+    for (uint32_t i = 0; i < 64; ++i)
+    {
+        history = AccumulateGTAOHistory(history, 0.3f, true);
+    }
+    bool bHistoryConverges = fabsf(history.x - 0.3f) < 1e-5f && history.y == (float) GTAO_TEMPORAL_MAX_FRAMES;
+
+    float2 stepHistory = AccumulateGTAOHistory(float2(0.0f, (float) GTAO_TEMPORAL_MAX_FRAMES), 1.0f, true);
+    bool bStepResponse = fabsf(stepHistory.x - 1.0f / GTAO_TEMPORAL_MAX_FRAMES) < 1e-6f;
+
+    float2 rejectedHistory = AccumulateGTAOHistory(float2(0.9f, (float) GTAO_TEMPORAL_MAX_FRAMES), 0.2f, false);
+    context.Check("history accumulation", bHistoryConverges && bStepResponse && rejectedHistory == float2(0.2f, 1.0f));
+
+    const uint32_t renderWidth = 1920;
+    const uint32_t renderHeight = 1080;
+    uint32_t halfPixelCount = ((renderWidth + 1) / 2) * ((renderHeight + 1) / 2);
+
+    MY_INFO("GTAO test : the main pass shades {} of {} pixels at {}x{} in half resolution",
+        halfPixelCount, renderWidth * renderHeight, renderWidth, renderHeight);
+}
+
+// GPU time of the GTAO passes, rendered in full and in half resolution until the smoothed times settle
+void RunGTAOGPUTimeBenchmark(TestContext& context)
+{
+    Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+    bool bHalfResGTAO = pRenderer->IsHalfResGTAOEnabled();
+
+    const char* fullResPasses[] = {
+        "GTAO prefilter depth pass",
+        "GTAO Main",
+        "GTAO Denoise Pass",
+    };
+
+    const char* halfResPasses[] = {
+        "GTAO Downsample Pass",
+        "GTAO half res prefilter depth pass",
+        "GTAO Half Res Main",
+        "GTAO Half Res Denoise Pass",
+        "GTAO Temporal Pass",
+        "GTAO Upsample Pass",
+    };
+
+    pRenderer->SetHalfResGTAOEnabled(false);
+    float fullResTotal = MeasureGPUTime(fullResPasses, (uint32_t)eastl::size(fullResPasses));
+
+    pRenderer->SetHalfResGTAOEnabled(true);
+    float halfResTotal = MeasureGPUTime(halfResPasses, (uint32_t)eastl::size(halfResPasses));
+
+    pRenderer->SetHalfResGTAOEnabled(bHalfResGTAO);
+
+    MY_INFO("GTAO : full resolution {:.1f} us, half resolution {:.1f} us", fullResTotal, halfResTotal);
+}
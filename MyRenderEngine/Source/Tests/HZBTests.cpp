@@ -0,0 +1,249 @@
+#include "Tests.h"
+#include "Renderer/HZB.h"
+#include "Renderer/RenderPasses/HierarchicalDepthBufferPass.h"
+#include "Core/Engine.h"
+#include "Utils/log.h"
+
+// Checks the footprints, the reductions and the reprojection of the HZB on the CPU, which needs no GPU
+void RunHZBTests(TestContext& context)
+{
+    // A footprint has every source texel the area of the texel overlaps and no other, neighbour footprints share at most the border texels
+    const uint2 footprintSizes[] = { uint2(1920, 1024), uint2(1080, 1024), uint2(1366, 1024), uint2(720, 512), uint2(37, 16), uint2(7, 3), uint2(5, 2), uint2(1, 1) };
+    bool bFootprintCovered = true;
+    for (const uint2& size : footprintSizes)
+    {
+        uint32_t end = 0;
+        for (uint32_t i = 0; i < size.y; ++i)
+        {
+            uint2 footprint = GetHZBFootprint(i, size.x, size.y);
+            double areaBegin = (double) i * size.x / size.y;
+            double areaEnd = (double) (i + 1) * size.x / size.y;
+            bFootprintCovered = bFootprintCovered && footprint.x == (uint32_t) floor(areaBegin) && footprint.y == (uint32_t) ceil(areaEnd) &&
+                footprint.x <= end && footprint.x + 1 >= end;
+            end = footprint.y;
+        }
+        bFootprintCovered = bFootprintCovered && end == size.x;
+    }
+    context.Check("footprints cover the area of the texels", bFootprintCovered);
+
+    // The fused builds reduce the power of two mips with the 2x2 texels of SPD
+    bool bPowerOfTwoMips = true;
+    const uint2 renderSizes[] = { uint2(1920, 1080), uint2(1366, 768), uint2(1280, 720), uint2(37, 23) };
+    for (const uint2& renderSize : renderSizes)
+    {
+        uint32_t mipCount;
+        uint2 hzbSize = GetHZBSize(renderSize.x, renderSize.y, mipCount);
+        for (uint32_t mip = 1; mip < mipCount; ++mip)
+        {
+            uint2 srcSize = GetHZBMipSize(hzbSize, mip - 1);
+            uint2 dstSize = GetHZBMipSize(hzbSize, mip);
+            for (uint32_t axis = 0; axis < 2; ++axis)
+            {
+                for (uint32_t i = 0; i < dstSize[axis] && srcSize[axis] == dstSize[axis] * 2; ++i)
+                {
+                    bPowerOfTwoMips = bPowerOfTwoMips && GetHZBFootprint(i, srcSize[axis], dstSize[axis]) == uint2(i * 2, i * 2 + 2);
+                }
+            }
+        }
+    }
+    context.Check("power of two mips reduce 2x2 texels", bPowerOfTwoMips);
+
+    // Every texel of the chain is the min and the max of all the depth texels under it, for the HZB sizes of the render sizes and a chain of odd sizes
+    auto checkChain = [&](uint2 depthSize, const eastl::vector<uint2>& mipSizes)
+    {
+        eastl::vector<float> depth(depthSize.x * depthSize.y);
+        for (uint32_t y = 0; y < depthSize.y; ++y)
+        {
+            for (uint32_t x = 0; x < depthSize.x; ++x)
+            {
+                // Mostly smooth surfaces with some sky and a few edges
+                float d = (x / 16 + y / 16) % 7 == 0 ? 0.0f : 0.1f + 0.3f * sinf(x * 0.01f) * cosf(y * 0.013f) + 0.3f;
+                depth[y * depthSize.x + x] = context.Random(0.0f, 1.0f) < 0.01f ? context.Random(0.0f, 1.0f) : d;
+            }
+        }
+
+        eastl::vector<eastl::vector<float2>> mips(mipSizes.size());
+        ReduceDepthToHZB(depth, depthSize, mipSizes[0], mips[0]);
+        for (size_t mip = 1; mip < mipSizes.size(); ++mip)
+        {
+            ReduceHZBMip(mips[mip - 1], mipSizes[mip - 1], mipSizes[mip], mips[mip]);
+        }
+
+        // Range of the depth texels under a texel range of a mip
+        auto depthRange = [&](uint2 range, size_t mip, uint32_t axis)
+        {
+            for (size_t i = mip; i > 0; --i)
+            {
+                range = uint2(GetHZBFootprint(range.x, mipSizes[i - 1][axis], mipSizes[i][axis]).x, GetHZBFootprint(range.y - 1, mipSizes[i - 1][axis], mipSizes[i][axis]).y);
+            }
+            return uint2(GetHZBFootprint(range.x, depthSize[axis], mipSizes[0][axis]).x, GetHZBFootprint(range.y - 1, depthSize[axis], mipSizes[0][axis]).y);
+        };
+
+        bool bExact = true;
+        for (size_t mip = 0; mip < mipSizes.size() && bExact; ++mip)
+        {
+            for (uint32_t y = 0; y < mipSizes[mip].y && bExact; ++y)
+            {
+                uint2 rangeY = depthRange(uint2(y, y + 1), mip, 1);
+                for (uint32_t x = 0; x < mipSizes[mip].x && bExact; ++x)
+                {
+                    uint2 rangeX = depthRange(uint2(x, x + 1), mip, 0);
+
+                    float2 minMax = float2(1.0f, 0.0f);
+                    for (uint32_t j = rangeY.x; j < rangeY.y; ++j)
+                    {
+                        for (uint32_t i = rangeX.x; i < rangeX.y; ++i)
+                        {
+                            minMax = float2(min(minMax.x, depth[j * depthSize.x + i]), max(minMax.y, depth[j * depthSize.x + i]));
+                        }
+                    }
+                    bExact = mips[mip][y * mipSizes[mip].x + x] == minMax;
+                }
+            }
+        }
+        return bExact;
+    };
+
+    bool bExactChain = true;
+    for (const uint2& renderSize : renderSizes)
+    {
+        uint32_t mipCount;
+        uint2 hzbSize = GetHZBSize(renderSize.x, renderSize.y, mipCount);
+
+        eastl::vector<uint2> mipSizes;
+        for (uint32_t mip = 0; mip < mipCount; ++mip)
+        {
+            mipSizes.push_back(GetHZBMipSize(hzbSize, mip));
+        }
+        bExactChain = bExactChain && checkChain(renderSize, mipSizes);
+    }
+    context.Check("texels are the min and max of the depth under them", bExactChain);
+    context.Check("odd mip sizes are reduced conservatively", checkChain(uint2(37, 23), { uint2(19, 12), uint2(9, 6), uint2(4, 3), uint2(2, 1), uint2(1, 1) }));
+
+    // The min reduction sampler of the separate init pass reads the 2x2 depth texels around the center of a HZB texel, which miss some of the texels under it
+    uint32_t mipCount;
+    uint2 depthSize = uint2(1920, 1080);
+    uint2 hzbSize = GetHZBSize(depthSize.x, depthSize.y, mipCount);
+    uint2 missedCount = uint2(0, 0);
+    for (uint32_t axis = 0; axis < 2; ++axis)
+    {
+        for (uint32_t i = 0; i < hzbSize[axis]; ++i)
+        {
+            uint32_t texel = (uint32_t) floorf((i + 0.5f) * depthSize[axis] / hzbSize[axis] - 0.5f);
+            uint2 footprint = GetHZBFootprint(i, depthSize[axis], hzbSize[axis]);
+            missedCount[axis] += footprint.x < texel || footprint.y > texel + 2 ? 1 : 0;
+        }
+    }
+    uint32_t missedTexelCount = missedCount.x * hzbSize.y + missedCount.y * hzbSize.x - missedCount.x * missedCount.y;
+
+    // The atomic reprojection keeps the farthest depth by comparing the bits of positive floats
+    bool bFarthestWins = true;
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        float a = i % 10 == 0 ? 0.0f : context.Random(0.0f, 1.0f);
+        float b = context.Random(0.0f, 1.0f);
+        uint32_t bitsA, bitsB;
+        memcpy(&bitsA, &a, sizeof(bitsA));
+        memcpy(&bitsB, &b, sizeof(bitsB));
+        bFarthestWins = bFarthestWins && (min(bitsA, bitsB) == bitsA) == (a <= b);
+    }
+    context.Check("atomic reprojection keeps the farthest depth", bFarthestWins);
+
+    auto asDepthBits = [](float depth)
+    {
+        uint32_t bits;
+        memcpy(&bits, &depth, sizeof(bits));
+        return bits;
+    };
+
+    // Holes take the farthest neighbour as the separate dilation pass, which read 0 for the empty texels
+    const uint2 size = uint2(8, 8);
+    eastl::vector<uint32_t> reprojected(size.x * size.y, HZB_REPROJECTION_EMPTY);
+    reprojected[3 * size.x + 3] = asDepthBits(0.5f);
+    reprojected[3 * size.x + 4] = asDepthBits(0.3f);
+    reprojected[6 * size.x + 6] = asDepthBits(0.0f);    //< Sky
+    reprojected[7 * size.x + 7] = asDepthBits(0.8f);
+    context.Check("dilation fills the holes with the farthest neighbour",
+        ResolveReprojectedDepth(reprojected, size, int2(3, 3)) == 0.5f &&
+        ResolveReprojectedDepth(reprojected, size, int2(4, 4)) == 0.3f &&
+        ResolveReprojectedDepth(reprojected, size, int2(2, 2)) == 0.5f &&
+        ResolveReprojectedDepth(reprojected, size, int2(0, 0)) == 0.0f &&
+        ResolveReprojectedDepth(reprojected, size, int2(6, 6)) == 0.8f);
+
+    bool bSameAsDilationPass = true;
+    for (uint32_t i = 0; i < reprojected.size(); ++i)
+    {
+        reprojected[i] = context.Random(0.0f, 1.0f) < 0.3f ? HZB_REPROJECTION_EMPTY : asDepthBits(context.Random(0.0f, 1.0f) < 0.1f ? 0.0f : context.Random(0.0f, 1.0f));
+    }
+    for (int32_t y = 0; y < (int32_t) size.y; ++y)
+    {
+        for (int32_t x = 0; x < (int32_t) size.x; ++x)
+        {
+            auto load = [&](int32_t i, int32_t j)
+            {
+                if (i < 0 || j < 0 || i >= (int32_t) size.x || j >= (int32_t) size.y || reprojected[j * size.x + i] == HZB_REPROJECTION_EMPTY)
+                {
+                    return 0.0f;
+                }
+                float d;
+                memcpy(&d, &reprojected[j * size.x + i], sizeof(d));
+                return d;
+            };
+
+            // DepthDilation of HZBReprojection.hlsl
+            float depth = load(x, y);
+            if (depth == 0.0f)
+            {
+                const int2 offsets[8] = { int2(-1, -1), int2(-1, 0), int2(-1, 1), int2(0, -1), int2(0, 1), int2(1, -1), int2(1, 0), int2(1, 1) };
+                float minDepth = 1.0f;
+                for (const int2& offset : offsets)
+                {
+                    float d = load(x + offset.x, y + offset.y);
+                    if (d > 0.0f && d < minDepth)
+                    {
+                        minDepth = d;
+                    }
+                }
+                depth = minDepth != 1.0f ? minDepth : depth;
+            }
+            bSameAsDilationPass = bSameAsDilationPass && ResolveReprojectedDepth(reprojected, size, int2(x, y)) == depth;
+        }
+    }
+    context.Check("fused dilation matches the dilation pass", bSameAsDilationPass);
+
+    MY_INFO("HZB test : the sampler of the separate init pass misses depth under {} of {} HZB texels at {}x{}",
+        missedTexelCount, hzbSize.x * hzbSize.y, depthSize.x, depthSize.y);
+}
+
+// GPU time of the HZB passes, rendered with the separate and the fused passes until the smoothed times settle
+void RunHZBGPUTimeBenchmark(TestContext& context)
+{
+    Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+    bool bFusedHZB = pRenderer->IsFusedHZBEnabled();
+
+    const char* separatePasses[] = {
+        "Depth Reprojection",
+        "Depth Dilation Pass",
+        "Build HZB",
+        "Init HZB pass",
+        "Build HZB Pass",
+    };
+
+    const char* fusedPasses[] = {
+        "HZB Reprojection",
+        "Build 1st Phase HZB",
+        "Build 2nd Phase HZB",
+    };
+
+    pRenderer->SetFusedHZBEnabled(false);
+    float separateTotal = MeasureGPUTime(separatePasses, (uint32_t)eastl::size(separatePasses));
+    uint32_t separatePassCount = pRenderer->GetHZBPass()->GetPassCount();
+
+    pRenderer->SetFusedHZBEnabled(true);
+    float fusedTotal = MeasureGPUTime(fusedPasses, (uint32_t)eastl::size(fusedPasses));
+    uint32_t fusedPassCount = pRenderer->GetHZBPass()->GetPassCount();
+
+    pRenderer->SetFusedHZBEnabled(bFusedHZB);
+
+    MY_INFO("HZB : separate {} passes {:.1f} us, fused {} passes {:.1f} us", separatePassCount, separateTotal, fusedPassCount, fusedTotal);
+}
@@ -0,0 +1,93 @@
+#include "Tests.h"
+#include "Renderer/MaterialTable.h"
+
+// Ticks a static scene on a standalone material table, as GPUScene does every frame, which needs no GPU
+void RunMaterialTableTests(TestContext& context)
+{
+    const uint32_t meshCount = 1000;
+    const uint32_t uniqueCount = 10;
+
+    eastl::vector<ModelMaterialConstant> materials(uniqueCount);
+    for (uint32_t i = 0; i < uniqueCount; ++i)
+    {
+        materials[i] = {};
+        materials[i].m_albedo = float3((float) i / uniqueCount, 0.5f, 0.5f);
+        materials[i].m_roughness = 0.5f;
+    }
+
+    MaterialTable table;
+    eastl::vector<uint2> ranges;
+
+    // Bytes uploaded by a frame, as GPUScene::UploadMaterials
+    auto uploadFrame = [&]()
+    {
+        table.CollectDirtyRanges(ranges);
+
+        uint32_t bytes = 0;
+        for (size_t i = 0; i < ranges.size(); ++i)
+        {
+            bytes += sizeof(ModelMaterialConstant) * ranges[i].y;
+        }
+        return bytes;
+    };
+
+    // Every mesh owns its material, as the loaders create them
+    eastl::vector<uint32_t> meshMaterials(meshCount, MATERIAL_TABLE_INVALID_INDEX);
+    for (uint32_t i = 0; i < meshCount; ++i)
+    {
+        meshMaterials[i] = table.Update(meshMaterials[i], materials[i % uniqueCount], 0);
+    }
+
+    context.Check("Identical materials share a slot", table.GetUsedCount() == uniqueCount && table.GetRefCount(meshMaterials[0]) == meshCount / uniqueCount);
+
+    uint32_t firstFrameBytes = uploadFrame();
+    context.Check("First frame uploads every unique material once", firstFrameBytes == sizeof(ModelMaterialConstant) * uniqueCount && ranges.size() == 1);
+
+    uint32_t staticBytes = 0;
+    for (uint32_t frame = 1; frame < 100; ++frame)
+    {
+        staticBytes += uploadFrame();
+    }
+    context.Check("Static scene uploads none after the first frame", staticBytes == 0);
+
+    // Edited in the GUI, only this mesh gets the new constants
+    ModelMaterialConstant edited = materials[3];
+    edited.m_metallic = 1.0f;
+
+    uint32_t sharedSlot = meshMaterials[3];
+    meshMaterials[3] = table.Update(meshMaterials[3], edited, 100);
+    context.Check("Edited material moves to a new slot", meshMaterials[3] != sharedSlot && table.GetRefCount(sharedSlot) == meshCount / uniqueCount - 1);
+    context.Check("Edit uploads one material", uploadFrame() == sizeof(ModelMaterialConstant));
+
+    uint32_t unchangedSlot = table.Update(meshMaterials[3], edited, 101);
+    context.Check("Unchanged constants are not uploaded again", unchangedSlot == meshMaterials[3] && uploadFrame() == 0);
+
+    // Edited back to the shared constants, the slot of the edit is freed once the frames reading it are done
+    uint32_t editedSlot = meshMaterials[3];
+    meshMaterials[3] = table.Update(meshMaterials[3], materials[3], 102);
+    context.Check("Reverted material shares the slot again", meshMaterials[3] == sharedSlot && table.GetPendingCount() == 1 && uploadFrame() == 0);
+
+    // Frames up to 101 are done, frame 102 may still read the released slot
+    table.ProcessPendingReleases(101);
+    ModelMaterialConstant other = materials[0];
+    other.m_roughness = 0.9f;
+    uint32_t otherSlot = table.Update(MATERIAL_TABLE_INVALID_INDEX, other, 103);
+    context.Check("Released slot isn't reused while in flight", otherSlot != editedSlot && table.GetPendingCount() == 1);
+
+    table.ProcessPendingReleases(102);
+    other.m_roughness = 0.8f;
+    uint32_t reusedSlot = table.Update(MATERIAL_TABLE_INVALID_INDEX, other, 103);
+    context.Check("Released slot is reused after its frame", reusedSlot == editedSlot && table.GetPendingCount() == 0);
+
+    table.Release(otherSlot, 103);
+    table.Release(reusedSlot, 103);
+    table.ProcessPendingReleases(103);
+
+    for (uint32_t i = 0; i < meshCount; ++i)
+    {
+        table.Release(meshMaterials[i], 104);
+    }
+    bool bPending = table.GetUsedCount() == uniqueCount;
+    table.ProcessPendingReleases(104);
+    context.Check("Released materials free the slots", bPending && table.GetUsedCount() == 0);
+}
@@ -0,0 +1,53 @@
+#include "Tests.h"
+#include "Renderer/Renderer.h"
+#include "Renderer/RenderPasses/BasePassGPUDriven.h"
+#include "Core/Engine.h"
+#include "Utils/log.h"
+#include "EASTL/sort.h"
+
+// The waves of BuildMeshletList append in any order, so both lists are sorted before they are compared
+static void CheckGPUMeshletList(const MeshletListReadback& readback)
+{
+    bool bMatched = true;
+    size_t meshletCount = 0;
+    eastl::vector<uint2> expected;
+    eastl::vector<uint2> meshletList;
+
+    for (const MeshletListReadback::Batch& batch : readback.m_batches)
+    {
+        expected.clear();
+        BasePassGPUDriven::ExpandMeshletList(batch.m_instanceRecords.data(), (uint32_t) batch.m_instanceRecords.size(), readback.m_cullingResult.data(), expected);
+
+        meshletList = batch.m_meshletList;
+        eastl::sort(expected.begin(), expected.end());
+        eastl::sort(meshletList.begin(), meshletList.end());
+
+        bMatched &= meshletList == expected;
+        meshletCount += meshletList.size();
+    }
+
+    TestContext context("GPU meshlet list test");
+    context.Check("1st phase meshlet list matches the CPU expansion", bMatched);
+
+    MY_INFO("GPU meshlet list test : {} PSOs, {} visible meshlets", readback.m_batches.size(), meshletCount);
+    LogGPUTestResults(context);
+}
+
+void RunMeshletListTests(TestContext& context)
+{
+    // Records of three instances, the second is culled
+    const uint2 records[3] = { uint2(0, 3), uint2(2, 1), uint2(5, 2) };
+    const uint8_t cullingResult[6] = { 1, 0, 0, 0, 0, 1 };
+
+    eastl::vector<uint2> meshletList;
+    BasePassGPUDriven::ExpandMeshletList(records, 3, cullingResult, meshletList);
+    context.Check("Visible instances are expanded to their meshlets", meshletList == eastl::vector<uint2>{ uint2(0, 0), uint2(0, 1), uint2(0, 2), uint2(5, 0), uint2(5, 1) });
+
+    meshletList.clear();
+    BasePassGPUDriven::ExpandMeshletList(records, 0, cullingResult, meshletList);
+    context.Check("No records expand to no meshlets", meshletList.empty());
+
+    // The 1st phase of the next frame is read back and compared with the CPU expansion of the records it was built from
+    Engine::GetInstance()->GetRenderer()->GetBasePassGPUDriven()->RequestMeshletListReadback(CheckGPUMeshletList);
+    MY_INFO("Meshlet list test : the GPU meshlet list is checked when the next frames are finished");
+}
@@ -0,0 +1,253 @@
+#include "Tests.h"
+#include "World/OcclusionCulling.h"
+#include "Utils/log.h"
+#include "Utils/parallel_for.h"
+#include "sokol/sokol_time.h"
+
+// Occluders and spheres in view space, the view matrix is the identity
+void RunOcclusionCullingTests(TestContext& context)
+{
+    // The LH reversed z infinite projection of Camera::SetPerspective
+    const float zNear = 0.1f;
+    const float h = 1.0f / tan(0.5f * degree_to_radian(60.0f));
+    float4x4 mtxProjection = float4x4(0.0f);
+    mtxProjection[0][0] = h * 0.5f;
+    mtxProjection[1][1] = h;
+    mtxProjection[2][3] = 1.0f;
+    mtxProjection[3][2] = zNear;
+    const float4x4 mtxView = linalg::identity;
+
+    OcclusionBuffer buffer;
+    buffer.Resize(256, 128);
+
+    auto quad = [](const float3& p0, const float3& p1, const float3& p2, const float3& p3)
+    {
+        OccluderMesh mesh;
+        mesh.m_vertices = { p0, p1, p2, p3 };
+        mesh.m_indices = { 0, 1, 2, 0, 2, 3 };
+        return mesh;
+    };
+
+    auto rasterize = [&](const eastl::vector<OccluderMesh>& occluders, bool bSIMD)
+    {
+        buffer.Begin(mtxView, mtxProjection, (uint32_t) occluders.size());
+        for (uint32_t i = 0; i < (uint32_t) occluders.size(); ++i)
+        {
+            buffer.SetupOccluder(i, linalg::identity, occluders[i]);
+        }
+
+        if (bSIMD)
+        {
+            buffer.Rasterize();
+        }
+        else
+        {
+            buffer.RasterizeScalar();
+        }
+    };
+
+    rasterize({}, true);
+    context.Check("Empty buffer occludes nothing", !buffer.IsOccluded(float3(0.0f, 0.0f, 10.0f), 1.0f) && !buffer.IsOccluded(float3(0.0f, 0.0f, 1000.0f), 0.01f));
+
+    eastl::vector<OccluderMesh> wall = { quad(float3(-100.0f, -100.0f, 10.0f), float3(100.0f, -100.0f, 10.0f), float3(100.0f, 100.0f, 10.0f), float3(-100.0f, 100.0f, 10.0f)) };
+    rasterize(wall, true);
+    context.Check("Wall hides the spheres behind it", buffer.IsOccluded(float3(0.0f, 0.0f, 20.0f), 1.0f) && buffer.IsOccluded(float3(5.0f, -3.0f, 50.0f), 4.0f));
+    context.Check("Wall doesn't hide the spheres in front of or crossing it", !buffer.IsOccluded(float3(0.0f, 0.0f, 5.0f), 1.0f) && !buffer.IsOccluded(float3(0.0f, 0.0f, 10.5f), 1.0f));
+
+    eastl::vector<OccluderMesh> halfWall = { quad(float3(-100.0f, -100.0f, 10.0f), float3(0.0f, -100.0f, 10.0f), float3(0.0f, 100.0f, 10.0f), float3(-100.0f, 100.0f, 10.0f)) };
+    rasterize(halfWall, true);
+    context.Check("Half wall only hides the spheres fully behind it",
+        buffer.IsOccluded(float3(-8.0f, 0.0f, 20.0f), 1.0f) && !buffer.IsOccluded(float3(8.0f, 0.0f, 20.0f), 1.0f) && !buffer.IsOccluded(float3(0.0f, 0.0f, 20.0f), 1.0f));
+
+    eastl::vector<OccluderMesh> nearFloor = { quad(float3(-100.0f, -100.0f, -1.0f), float3(100.0f, -100.0f, -1.0f), float3(100.0f, 100.0f, 20.0f), float3(-100.0f, 100.0f, 20.0f)) };
+    rasterize(nearFloor, true);
+    context.Check("Triangles crossing the near plane are skipped", buffer.GetTriangleCount() == 0 && !buffer.IsOccluded(float3(0.0f, 0.0f, 50.0f), 1.0f));
+
+    // Random triangles for the SIMD and the conservative tests
+    eastl::vector<OccluderMesh> occluders(16);
+    for (OccluderMesh& occluder : occluders)
+    {
+        for (uint32_t i = 0; i < 32; ++i)
+        {
+            float3 center = float3(context.Random(-15.0f, 15.0f), context.Random(-8.0f, 8.0f), context.Random(5.0f, 30.0f));
+            for (uint32_t j = 0; j < 3; ++j)
+            {
+                occluder.m_vertices.push_back(center + float3(context.Random(-4.0f, 4.0f), context.Random(-4.0f, 4.0f), context.Random(-2.0f, 2.0f)));
+                occluder.m_indices.push_back((uint16_t) (i * 3 + j));
+            }
+        }
+    }
+
+    rasterize(occluders, false);
+    eastl::vector<uint32_t> scalarMasks = buffer.GetMasks();
+    eastl::vector<float> scalarReferenceDepths = buffer.GetReferenceDepths();
+    eastl::vector<float> scalarWorkingDepths = buffer.GetWorkingDepths();
+
+    rasterize(occluders, true);
+    context.Check("SIMD matches scalar", buffer.GetMasks() == scalarMasks && buffer.GetReferenceDepths() == scalarReferenceDepths && buffer.GetWorkingDepths() == scalarWorkingDepths);
+
+    // Per pixel depth of the occluders, pixel centers on the edges are covered
+    const uint32_t width = buffer.GetWidth();
+    const uint32_t height = buffer.GetHeight();
+    eastl::vector<double> pixelDepths(width * height, 0.0);
+
+    auto toScreen = [&](const float3& p)
+    {
+        float4 clipPos = mul(mtxProjection, float4(p, 1.0f));
+        return double3((clipPos.x / clipPos.w * 0.5 + 0.5) * width, (0.5 - clipPos.y / clipPos.w * 0.5) * height, clipPos.z / clipPos.w);
+    };
+
+    for (const OccluderMesh& occluder : occluders)
+    {
+        for (size_t i = 0; i < occluder.m_indices.size(); i += 3)
+        {
+            double3 v0 = toScreen(occluder.m_vertices[occluder.m_indices[i]]);
+            double3 v1 = toScreen(occluder.m_vertices[occluder.m_indices[i + 1]]);
+            double3 v2 = toScreen(occluder.m_vertices[occluder.m_indices[i + 2]]);
+            double area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+
+            for (uint32_t y = 0; y < height; ++y)
+            {
+                for (uint32_t x = 0; x < width; ++x)
+                {
+                    double2 p = double2(x + 0.5, y + 0.5);
+                    double w0 = ((v2.x - v1.x) * (p.y - v1.y) - (v2.y - v1.y) * (p.x - v1.x)) / area;
+                    double w1 = ((v0.x - v2.x) * (p.y - v2.y) - (v0.y - v2.y) * (p.x - v2.x)) / area;
+                    double w2 = 1.0 - w0 - w1;
+                    if (w0 >= 0.0 && w1 >= 0.0 && w2 >= 0.0)
+                    {
+                        double& depth = pixelDepths[y * width + x];
+                        depth = max(depth, w0 * v0.z + w1 * v1.z + w2 * v2.z);
+                    }
+                }
+            }
+        }
+    }
+
+    // An occluded sphere is behind the occluders at every pixel it covers
+    uint32_t occludedCount = 0;
+    uint32_t falseOccludedCount = 0;
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        float3 center = float3(context.Random(-20.0f, 20.0f), context.Random(-10.0f, 10.0f), context.Random(10.0f, 60.0f));
+        float radius = context.Random(0.2f, 2.0f);
+        if (!buffer.IsOccluded(center, radius))
+        {
+            continue;
+        }
+        ++occludedCount;
+
+        double nearestDepth = zNear / (center.z - radius);
+        bool bFalseOccluded = false;
+        for (uint32_t y = 0; y < height && !bFalseOccluded; ++y)
+        {
+            for (uint32_t x = 0; x < width && !bFalseOccluded; ++x)
+            {
+                // Ray through the pixel center in view space
+                double2 ndc = double2((x + 0.5) / width * 2.0 - 1.0, 1.0 - (y + 0.5) / height * 2.0);
+                double3 dir = normalize(double3(ndc.x / mtxProjection[0][0], ndc.y / mtxProjection[1][1], 1.0));
+                double3 c = double3(center.x, center.y, center.z);
+                double distance = length(c - dir * dot(c, dir));
+                bFalseOccluded = distance <= radius && pixelDepths[y * width + x] < nearestDepth;
+            }
+        }
+        falseOccludedCount += bFalseOccluded ? 1 : 0;
+    }
+    context.Check("Occluded spheres are behind the occluders", occludedCount > 0 && falseOccludedCount == 0);
+
+    MY_INFO("Occlusion culling test : {} of 1000 random spheres occluded", occludedCount);
+}
+
+// Walls of 16x8 quads and random spheres in front of the camera, the live reduction of World::Tick is in the World/Culling counters
+void RunOcclusionCullingBenchmark(TestContext& context)
+{
+    const uint32_t occluderCount = OCCLUSION_MAX_OCCLUDERS;
+    const uint32_t objectCount = 100000;
+    const uint32_t iterationCount = 16;
+
+    OccluderMesh wall;
+    for (uint32_t y = 0; y <= 8; ++y)
+    {
+        for (uint32_t x = 0; x <= 16; ++x)
+        {
+            wall.m_vertices.push_back(float3(x / 16.0f - 0.5f, y / 8.0f - 0.5f, 0.0f));
+        }
+    }
+    for (uint32_t y = 0; y < 8; ++y)
+    {
+        for (uint32_t x = 0; x < 16; ++x)
+        {
+            uint16_t i = (uint16_t) (y * 17 + x);
+            wall.m_indices.insert(wall.m_indices.end(), { i, (uint16_t) (i + 1), (uint16_t) (i + 18), i, (uint16_t) (i + 18), (uint16_t) (i + 17) });
+        }
+    }
+
+    eastl::vector<float4x4> occluderMatrices(occluderCount);
+    for (float4x4& matrix : occluderMatrices)
+    {
+        float3 pos = float3(context.Random(-60.0f, 60.0f), context.Random(-5.0f, 5.0f), context.Random(20.0f, 120.0f));
+        quaternion rotation = rotation_quat(float3(0.0f, 1.0f, 0.0f), degree_to_radian(context.Random(-45.0f, 45.0f)));
+        matrix = mul(translation_matrix(pos), mul(rotation_matrix(rotation), scaling_matrix(float3(context.Random(10.0f, 40.0f), context.Random(5.0f, 15.0f), 1.0f))));
+    }
+
+    eastl::vector<float4> spheres(objectCount);
+    for (float4& sphere : spheres)
+    {
+        sphere = float4(context.Random(-100.0f, 100.0f), context.Random(-10.0f, 10.0f), context.Random(30.0f, 200.0f), context.Random(0.5f, 3.0f));
+    }
+
+    Camera* pCamera = Engine::GetInstance()->GetWorld()->GetCamera();
+    float4x4 mtxProjection = pCamera->GetNonJitterProjectionMatrix();
+
+    OcclusionBuffer buffer;
+    buffer.Resize(OCCLUSION_BUFFER_WIDTH, (uint32_t) (OCCLUSION_BUFFER_WIDTH * mtxProjection[0][0] / mtxProjection[1][1]));
+
+    double setupTime = 0.0;
+    double rasterTime = 0.0;
+    double scalarRasterTime = 0.0;
+    double testTime = 0.0;
+    uint32_t occludedCount = 0;
+    eastl::vector<uint8_t> occluded(objectCount);
+
+    for (uint32_t iteration = 0; iteration < iterationCount; ++iteration)
+    {
+        uint64_t startTime = stm_now();
+        buffer.Begin(linalg::identity, mtxProjection, occluderCount);
+        ParallelFor(occluderCount, [&](uint32_t i)
+            {
+                buffer.SetupOccluder(i, occluderMatrices[i], wall);
+            });
+        setupTime += stm_ms(stm_since(startTime));
+
+        startTime = stm_now();
+        buffer.RasterizeScalar();
+        scalarRasterTime += stm_ms(stm_since(startTime));
+
+        startTime = stm_now();
+        buffer.Rasterize();
+        rasterTime += stm_ms(stm_since(startTime));
+
+        startTime = stm_now();
+        ParallelFor(DivideRoundingUp(objectCount, WORLD_OBJECT_CHUNK_SIZE), [&](uint32_t chunk)
+            {
+                uint32_t begin = chunk * WORLD_OBJECT_CHUNK_SIZE;
+                uint32_t end = min(begin + WORLD_OBJECT_CHUNK_SIZE, objectCount);
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    occluded[i] = buffer.IsOccluded(spheres[i].xyz(), spheres[i].w);
+                }
+            });
+        testTime += stm_ms(stm_since(startTime));
+    }
+
+    for (uint32_t i = 0; i < objectCount; ++i)
+    {
+        occludedCount += occluded[i];
+    }
+
+    MY_INFO("Occlusion culling benchmark : {} occluders ({} triangles), {}x{} buffer, setup {:.3f} ms, raster {:.3f} ms (scalar {:.3f} ms, {:.1f}x)",
+        occluderCount, buffer.GetTriangleCount(), buffer.GetWidth(), buffer.GetHeight(), setupTime / iterationCount, rasterTime / iterationCount,
+        scalarRasterTime / iterationCount, rasterTime > 0.0 ? scalarRasterTime / rasterTime : 0.0);
+    MY_INFO("Occlusion culling benchmark : {} of {} objects occluded ({:.1f}%), tests {:.3f} ms",
+        occludedCount, objectCount, 100.0f * occludedCount / objectCount, testTime / iterationCount);
+}
@@ -0,0 +1,91 @@
+#include "Tests.h"
+#include "Renderer/RenderBatch.h"
+#include "Core/Engine.h"
+#include "Utils/log.h"
+#include "Utils/parallel_for.h"
+#include "sokol/sokol_time.h"
+
+#define RENDER_BATCH_BENCHMARK_CHUNK_SIZE 256   //< Batches per task, as World::Tick renders its culling chunks
+
+// Builds the batches of a large scene once on the main thread and once from all task threads, as StaticMesh::Render
+// with its root constants and its per-instance constants, and compares the memory with the fixed constant array layout
+void RunRenderBatchBenchmark(TestContext& context)
+{
+    enki::TaskScheduler* pTaskScheduler = Engine::GetInstance()->GetTaskScheduler();
+    const uint32_t batchCount = 100000;
+    const uint32_t iterationCount = 10;
+
+    FrameAllocator allocator(pTaskScheduler, 1024 * 1024);
+    RenderBatchList<RenderBatch> batches;
+
+    uint32_t rootConstants[4] = {};
+    float4x4 instanceConstants = linalg::identity;
+
+    auto buildBatch = [&](uint32_t i)
+    {
+        RenderBatch& batch = batches.Add(allocator);
+        batch.m_label = "RenderBatchBenchmark";
+        batch.SetConstantBuffer(0, rootConstants, sizeof(rootConstants));
+        batch.SetConstantBuffer(1, &instanceConstants, sizeof(instanceConstants));
+        batch.DispatchMesh(i, 1, 1);
+    };
+
+    double serialTime = 0.0;
+    double parallelTime = 0.0;
+    double mergeTime = 0.0;
+    size_t constantSize = 0;
+    bool bMatched = true;
+
+    for (uint32_t iteration = 0; iteration < iterationCount; ++iteration)
+    {
+        uint64_t startTime = stm_now();
+        for (uint32_t i = 0; i < batchCount; ++i)
+        {
+            buildBatch(i);
+        }
+        serialTime += stm_ms(stm_since(startTime));
+
+        constantSize = allocator.GetAllocatedSize();
+        batches.Clear();
+        allocator.Reset();
+
+        startTime = stm_now();
+        ParallelFor(DivideRoundingUp(batchCount, RENDER_BATCH_BENCHMARK_CHUNK_SIZE), [&](uint32_t chunk)
+            {
+                uint32_t first = chunk * RENDER_BATCH_BENCHMARK_CHUNK_SIZE;
+                uint32_t last = min(first + RENDER_BATCH_BENCHMARK_CHUNK_SIZE, batchCount);
+                for (uint32_t i = first; i < last; ++i)
+                {
+                    buildBatch(i);
+                }
+            });
+        parallelTime += stm_ms(stm_since(startTime));
+
+        startTime = stm_now();
+        const eastl::vector<RenderBatch>& mergedBatches = batches.Merge();
+        mergeTime += stm_ms(stm_since(startTime));
+
+        bMatched &= mergedBatches.size() == batchCount;
+        for (const RenderBatch& batch : mergedBatches)
+        {
+            uint32_t constantCount = 0;
+            ForEachConstantPacket(batch.m_pConstants, [&](uint32_t slot, const void* pData, uint32_t dataSize)
+                {
+                    constantCount += dataSize == (slot == 0 ? sizeof(rootConstants) : sizeof(instanceConstants)) ? 1 : 0;
+                });
+            bMatched &= constantCount == 2;
+        }
+
+        batches.Clear();
+        allocator.Reset();
+    }
+
+    context.Check("Batches built on task threads keep their constants", bMatched);
+
+    // The layout before the packet streams had a pointer and a padded size for each slot, and the same data in one shared allocator
+    size_t packetBatchSize = sizeof(RenderBatch) + constantSize / batchCount;
+    size_t fixedBatchSize = sizeof(RenderBatch) - sizeof(const RenderBatchConstantPacket*) + MAX_RENDER_BATCH_CB_COUNT * 2 * sizeof(void*) + sizeof(rootConstants) + sizeof(instanceConstants);
+
+    MY_INFO("Render batch benchmark : {} batches, main thread {:.2f} ms, {} task threads {:.2f} ms, merge {:.2f} ms, {} bytes per batch (fixed constant arrays {} bytes)",
+        batchCount, serialTime / iterationCount, pTaskScheduler->GetNumTaskThreads(), parallelTime / iterationCount, mergeTime / iterationCount, packetBatchSize, fixedBatchSize);
+}
@@ -0,0 +1,154 @@
+#include "Tests.h"
+#include "Renderer/RenderGraph/RenderGraph.h"
+#include "Renderer/RenderGraph/RenderGraphAsyncScheduler.h"
+#include "Core/Engine.h"
+#include "Utils/log.h"
+
+// Schedules a few synthetic graphs, which needs no GPU, and checks the placement of the compute passes
+void RunAsyncSchedulerTests(TestContext& context)
+{
+    struct TestCase
+    {
+        const char* m_name;
+        eastl::vector<RenderGraphAsyncNode> m_nodes;
+        eastl::vector<bool> m_expectedAsync;
+        uint32_t m_expectedFenceCount;
+    };
+
+    auto node = [](float costUs, bool bComputeOnly, std::initializer_list<uint32_t> dependencies, RenderGraphAsyncOverride value = RenderGraphAsyncOverride::Auto)
+    {
+        RenderGraphAsyncNode result;
+        result.m_costUs = costUs;
+        result.m_bComputeOnly = bComputeOnly;
+        result.m_override = value;
+        result.m_dependencies.assign(dependencies.begin(), dependencies.end());
+        return result;
+    };
+
+    eastl::vector<TestCase> testCases;
+    testCases.push_back({ "Hidden by independent graphics work",
+        { node(500, false, {}), node(300, true, { 0 }), node(800, false, { 0 }), node(200, false, { 1, 2 }) },
+        { false, true, false, false }, 2 });
+    testCases.push_back({ "Consumed right away",
+        { node(500, false, {}), node(300, true, { 0 }), node(800, false, { 1 }) },
+        { false, false, false }, 0 });
+    testCases.push_back({ "Never timed",
+        { node(500, false, {}), node(0, true, { 0 }), node(800, false, { 0 }), node(200, false, { 1, 2 }) },
+        { false, false, false, false }, 0 });
+    testCases.push_back({ "Run shares its fences",
+        { node(500, false, {}), node(200, true, { 0 }), node(200, true, { 1 }), node(1000, false, { 0 }), node(100, false, { 2, 3 }) },
+        { false, true, true, false, false }, 2 });
+    testCases.push_back({ "Graphics override",
+        { node(500, false, {}), node(300, true, { 0 }, RenderGraphAsyncOverride::Graphics), node(800, false, { 0 }), node(200, false, { 1, 2 }) },
+        { false, false, false, false }, 0 });
+    testCases.push_back({ "Async override",
+        { node(500, false, {}), node(300, true, { 0 }, RenderGraphAsyncOverride::Async), node(800, false, { 1 }) },
+        { false, true, false }, 2 });
+
+    for (size_t i = 0; i < testCases.size(); ++i)
+    {
+        const TestCase& testCase = testCases[i];
+
+        RenderGraphAsyncSchedule schedule;
+        RenderGraphAsyncScheduler::Schedule(testCase.m_nodes, schedule);
+
+        MY_INFO("Async scheduler test \"{}\" : {} async passes, {} fences, {:.0f} us overlap",
+            testCase.m_name, schedule.m_asyncPassCount, schedule.m_fenceCount, schedule.m_expectedOverlapUs);
+        context.Check(testCase.m_name, schedule.m_async == testCase.m_expectedAsync && schedule.m_fenceCount == testCase.m_expectedFenceCount);
+    }
+}
+
+// Compiles small graphs of passes on imported buffers and counts the barriers of their plans, the passes are never executed
+void RunRenderGraphBarrierTests(TestContext& context)
+{
+    Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+
+    RHIBufferDesc desc;
+    desc.m_stride = 4;
+    desc.m_size = 256;
+    desc.m_usage = RHIBufferUsageStructedBuffer | RHIBufferUsageUnorderedAccess;
+
+    eastl::unique_ptr<IRHIBuffer> pBuffer0(pRenderer->GetDevice()->CreateBuffer(desc, "RenderGraphBarrierTests::m_pBuffer0"));
+    eastl::unique_ptr<IRHIBuffer> pBuffer1(pRenderer->GetDevice()->CreateBuffer(desc, "RenderGraphBarrierTests::m_pBuffer1"));
+
+    // The state of RGBuilder::Write in compute passes, so the first writer needs no transition
+    const RHIAccessFlags uavState = RHIAccessBit::RHIAccessComputeShaderUAV | RHIAccessBit::RHIAccessClearUAV;
+
+    struct PassData
+    {
+        RGHandle buffer;
+    };
+
+    struct BarrierCount
+    {
+        uint32_t m_transitions = 0;
+        uint32_t m_splitBeginBarriers = 0;
+        uint32_t m_splitEndBarriers = 0;
+        uint32_t m_uavBarriers = 0;
+        uint32_t m_mergedReads = 0;
+    };
+
+    RenderGraph graph(pRenderer);
+    eastl::vector<RenderGraphPassBase*> passes;
+
+    auto addPass = [&](const char* name, RenderPassType type, const RGHandle& input, bool bWrite)
+    {
+        auto& pass = graph.AddPass<PassData>(name, type,
+            [&](PassData& data, RGBuilder& builder)
+            {
+                data.buffer = bWrite ? builder.Write(input) : builder.Read(input);
+                builder.SkipCulling();
+            },
+            [](const PassData& data, IRHICommandList* pCommandList)
+            {
+            });
+
+        passes.push_back(&pass);
+        return pass->buffer;
+    };
+
+    auto compile = [&]()
+    {
+        graph.Compile();
+
+        BarrierCount count;
+        for (size_t i = 0; i < passes.size(); ++i)
+        {
+            const RenderGraphBarrierPlan& plan = passes[i]->GetBarrierPlan();
+            count.m_transitions += (uint32_t) plan.m_transitions.size();
+            count.m_splitBeginBarriers += (uint32_t) plan.m_splitBeginBarriers.size();
+            count.m_splitEndBarriers += (uint32_t) plan.m_splitEndBarriers.size();
+            count.m_uavBarriers += plan.m_uavDependencyCount > 0 ? 1 : 0;
+            count.m_mergedReads += plan.m_mergedReadCount;
+        }
+
+        graph.Clear();
+        passes.clear();
+        return count;
+    };
+
+    RGHandle buffer = addPass("Writer", RenderPassType::Compute, graph.Import(pBuffer0.get(), uavState), true);
+    addPass("Reader", RenderPassType::Compute, buffer, false);
+    BarrierCount count = compile();
+    context.Check("Read after write transitions once", count.m_transitions == 1 && count.m_splitEndBarriers == 0 && count.m_uavBarriers == 0);
+
+    buffer = addPass("Writer", RenderPassType::Compute, graph.Import(pBuffer0.get(), uavState), true);
+    addPass("Writer 2", RenderPassType::Compute, buffer, true);
+    count = compile();
+    context.Check("Write after write is a UAV barrier", count.m_transitions == 0 && count.m_uavBarriers == 1);
+
+    // The compute and the graphics readers share one state which combines their SRV states
+    buffer = addPass("Writer", RenderPassType::Compute, graph.Import(pBuffer0.get(), uavState), true);
+    addPass("Reader", RenderPassType::Compute, buffer, false);
+    addPass("Graphics reader", RenderPassType::Graphics, buffer, false);
+    addPass("Reader 2", RenderPassType::Compute, buffer, false);
+    count = compile();
+    context.Check("Multiple readers transition once", count.m_transitions == 1 && count.m_mergedReads == 2 && count.m_splitEndBarriers == 0);
+
+    // A pass on another buffer between the writer and the reader hides the transition
+    buffer = addPass("Writer", RenderPassType::Compute, graph.Import(pBuffer0.get(), uavState), true);
+    addPass("Other writer", RenderPassType::Compute, graph.Import(pBuffer1.get(), uavState), true);
+    addPass("Reader", RenderPassType::Compute, buffer, false);
+    count = compile();
+    context.Check("Transition over an idle pass is split", count.m_transitions == 0 && count.m_splitBeginBarriers == 1 && count.m_splitEndBarriers == 1);
+}
@@ -0,0 +1,69 @@
+#include "Tests.h"
+#include "Renderer/ResourcePool.h"
+#include "Utils/math.h"
+#include "EASTL/vector.h"
+
+// Runs the pool bookkeeping with a standalone allocator, which needs no device
+void RunResourcePoolTests(TestContext& context)
+{
+    const uint32_t blockSize = 64 * 1024;
+    const uint32_t granularity = 256;
+
+    {
+        ResourcePoolAllocator allocator(blockSize, granularity, "Test");
+
+        const uint32_t sizes[] = { 100, 4000, 36, 512, 12 * 17 };
+        const uint32_t alignments[] = { 4, 16, 12, 256, 48 };
+
+        eastl::vector<ResourcePoolAllocation> allocations;
+        bool bAligned = true;
+        for (uint32_t i = 0; i < 5; ++i)
+        {
+            allocations.push_back(allocator.Allocate(sizes[i], alignments[i], RoundUpPow2(sizes[i], RESOURCE_POOL_DEDICATED_ALIGNMENT)));
+            bAligned &= allocations.back().IsValid() && allocations.back().m_offset % alignments[i] == 0;
+        }
+
+        bool bDisjoint = true;
+        for (uint32_t i = 0; i < 5; ++i)
+        {
+            for (uint32_t j = i + 1; j < 5; ++j)
+            {
+                bDisjoint &= allocations[i].m_offset + sizes[i] <= allocations[j].m_offset || allocations[j].m_offset + sizes[j] <= allocations[i].m_offset;
+            }
+        }
+
+        context.Check("Aligned offsets", bAligned);
+        context.Check("Disjoint ranges", bDisjoint && allocator.GetBlockCount() == 1);
+        context.Check("Saves memory", allocator.GetStats().GetSavedBytes() == 5 * RESOURCE_POOL_DEDICATED_ALIGNMENT - blockSize);
+    }
+
+    {
+        ResourcePoolAllocator allocator(blockSize, granularity, "Test");
+
+        eastl::vector<ResourcePoolAllocation> allocations;
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            allocations.push_back(allocator.Allocate(blockSize / 2, 4, RESOURCE_POOL_DEDICATED_ALIGNMENT));
+        }
+
+        context.Check("Grows by a block", allocator.GetBlockCount() == 2 && allocations[2].m_block == 1);
+        context.Check("Too large for a block", !allocator.Allocate(blockSize + 1, 4, 0).IsValid());
+
+        allocator.DeferredFree(allocations[0], 5);
+        allocator.DeferredFree(allocations[1], 6);
+        allocator.ProcessDeferredFrees(4);
+        bool bKept = allocator.GetStats().m_resourceCount == 3;
+        allocator.ProcessDeferredFrees(5);
+        bool bFreedInOrder = allocator.GetStats().m_resourceCount == 2 && allocator.GetStats().m_pendingFreeCount == 1;
+        context.Check("Deferred free waits for its frame", bKept && bFreedInOrder);
+
+        allocator.ProcessDeferredFrees(6);
+        ResourcePoolAllocation whole = allocator.Allocate(blockSize, granularity, 0);
+        context.Check("Freed block is reused", whole.IsValid() && whole.m_block == 0 && whole.m_offset == 0);
+
+        allocator.Free(whole);
+        allocator.Free(allocations[2]);
+        ResourcePoolStats stats = allocator.GetStats();
+        context.Check("Everything freed", stats.m_resourceCount == 0 && stats.m_usedBytes == 0 && stats.m_dedicatedBytes == 0);
+    }
+}
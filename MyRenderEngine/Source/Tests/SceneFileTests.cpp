@@ -0,0 +1,164 @@
+#include "Tests.h"
+#include "World/SceneFile.h"
+#include "Core/Engine.h"
+#include "Utils/log.h"
+#include "sokol/sokol_time.h"
+#include <fstream>
+
+static bool IsSceneDescEqual(const SceneDesc& a, const SceneDesc& b)
+{
+    return memcmp(&a.m_camera, &b.m_camera, sizeof(SceneCameraDesc)) == 0 &&
+        a.m_objects.size() == b.m_objects.size() && memcmp(a.m_objects.data(), b.m_objects.data(), sizeof(SceneObjectDesc) * a.m_objects.size()) == 0 &&
+        a.m_instances.size() == b.m_instances.size() && memcmp(a.m_instances.data(), b.m_instances.data(), sizeof(SceneInstanceDesc) * a.m_instances.size()) == 0 &&
+        a.m_strings == b.m_strings &&
+        a.m_worldObjectCount == b.m_worldObjectCount;
+}
+
+// Round trips scene descriptions in memory and through files, which needs no assets or GPU
+void RunSceneFileTests(TestContext& context)
+{
+    const char* xml = R"(<scene>
+    <camera position="1.5,2,-3" rotation="10,45,0" fov="60" znear="0.1"/>
+    <light type="directional" rotation="45,30,0" intensity="3" primary="true"/>
+    <light type="point" position="0.1,0.2,0.3" color="1,0.5,0.25" intensity="2.5" radius="7" falloff="0.5" bounds="0.1,0.2,0.3,7"/>
+    <model file="models/a.gltf" position="1,2,3" rotation="0,90,0" scale="0.01,0.01,0.01"/>
+    <model file="models/b.gltf">
+        <instance position="10,0,0"/>
+        <instance position="-10,0,0" rotation="0,180,0" scale="2,2,2"/>
+    </model>
+    <model file="models/a.gltf" position="0.333333343,1e-07,-123456.789" bounds="0.5,0.5,0.5,1234.5"/>
+</scene>)";
+
+    SceneDesc desc;
+    bool bParsed = ParseSceneXML(xml, strlen(xml), desc);
+    context.Check("Xml is parsed", bParsed && desc.m_objects.size() == 5 && desc.m_instances.size() == 2 &&
+        desc.m_objects[3].m_instanceCount == 2 && desc.m_objects[0].m_bPrimary && desc.m_objects[1].m_radius == 7.0f);
+    context.Check("String table shares the file names", desc.m_objects[2].m_file == desc.m_objects[4].m_file &&
+        desc.m_strings.size() == sizeof("models/a.gltf") + sizeof("models/b.gltf"));
+
+    eastl::vector<uint8_t> binary;
+    WriteSceneBinary(desc, binary);
+
+    SceneDesc binaryDesc;
+    bool bBinaryParsed = ParseSceneBinary(binary.data(), binary.size(), binaryDesc);
+    context.Check("Xml to binary keeps every record", bBinaryParsed && IsSceneDescEqual(desc, binaryDesc));
+
+    eastl::string xmlOutput = WriteSceneXML(binaryDesc);
+
+    SceneDesc xmlDesc;
+    bool bXmlParsed = ParseSceneXML(xmlOutput.c_str(), xmlOutput.size(), xmlDesc);
+    context.Check("Xml to binary to xml keeps every record", bXmlParsed && IsSceneDescEqual(desc, xmlDesc));
+
+    eastl::vector<uint8_t> binaryOutput;
+    WriteSceneBinary(xmlDesc, binaryOutput);
+    context.Check("Binary is written the same after the round trip", binary == binaryOutput);
+
+    SceneDesc invalidDesc;
+    context.Check("Truncated file is rejected", !ParseSceneBinary(binary.data(), binary.size() - 1, invalidDesc) && invalidDesc.m_objects.empty());
+
+    eastl::vector<uint8_t> corrupted = binary;
+    corrupted[0] ^= 0xFF;
+    context.Check("Wrong magic is rejected", !ParseSceneBinary(corrupted.data(), corrupted.size(), invalidDesc));
+
+    corrupted = binary;
+    SceneObjectDesc* pObjects = (SceneObjectDesc*) (corrupted.data() + sizeof(SceneFileHeader));
+    pObjects[2].m_file = (uint32_t) desc.m_strings.size();
+    context.Check("String offset out of the table is rejected", !ParseSceneBinary(corrupted.data(), corrupted.size(), invalidDesc));
+
+    // Through the files, as World::LoadScene and World::SaveScene do
+    desc.m_worldObjectCount = 42;
+
+    eastl::string binaryFile = Engine::GetInstance()->GetWorkPath() + "scene_file_test" SCENE_FILE_EXTENSION;
+    eastl::string xmlFile = Engine::GetInstance()->GetWorkPath() + "scene_file_test.xml";
+
+    SceneDesc fileDesc;
+    bool bBinaryFile = SaveSceneFile(binaryFile, desc) && LoadSceneFile(binaryFile, fileDesc) && IsSceneDescEqual(desc, fileDesc);
+    context.Check("Binary file is loaded back", bBinaryFile);
+
+    bool bXmlFile = SaveSceneFile(xmlFile, desc) && LoadSceneFile(xmlFile, fileDesc) && fileDesc.m_worldObjectCount == 0;
+    fileDesc.m_worldObjectCount = desc.m_worldObjectCount;  //< Not in the xml
+    context.Check("Xml file is loaded back", bXmlFile && IsSceneDescEqual(desc, fileDesc));
+
+    remove(binaryFile.c_str());
+    remove(xmlFile.c_str());
+}
+
+// Parses a generated 100k object scene from both formats, the objects aren't created because the models would dominate the time
+void RunSceneFileBenchmark(TestContext& context)
+{
+    const uint32_t objectCount = 100000;
+    const uint32_t fileCount = 64;
+
+    SceneDesc desc;
+    desc.m_camera.m_position = float3(0.0f, 10.0f, -50.0f);
+
+    for (uint32_t i = 0; i < objectCount; ++i)
+    {
+        SceneObjectDesc object;
+        object.m_type = i % 8 == 0 ? SceneObjectType::PointLight : SceneObjectType::Model;
+        object.m_position = float3(context.Random(-1000.0f, 1000.0f), context.Random(0.0f, 100.0f), context.Random(-1000.0f, 1000.0f));
+        object.m_rotation = float3(0.0f, context.Random(0.0f, 360.0f), 0.0f);
+        object.m_bounds = float4(object.m_position, context.Random(1.0f, 10.0f));
+
+        if (object.m_type == SceneObjectType::Model)
+        {
+            object.m_file = desc.AddString(fmt::format("models/prop_{}/prop_{}.gltf", i % fileCount, i % fileCount).c_str());
+            object.m_scale = float3(context.Random(0.5f, 2.0f));
+
+            // Every 16th model is a small group of instances
+            if (i % 16 == 1)
+            {
+                object.m_firstInstance = (uint32_t) desc.m_instances.size();
+                object.m_instanceCount = 4;
+                for (uint32_t j = 0; j < object.m_instanceCount; ++j)
+                {
+                    SceneInstanceDesc instance;
+                    instance.m_position = float3(context.Random(-10.0f, 10.0f), 0.0f, context.Random(-10.0f, 10.0f));
+                    desc.m_instances.push_back(instance);
+                }
+            }
+        }
+        else
+        {
+            object.m_color = float3(context.Random(0.0f, 1.0f), context.Random(0.0f, 1.0f), context.Random(0.0f, 1.0f));
+            object.m_intensity = context.Random(1.0f, 10.0f);
+            object.m_radius = object.m_bounds.w;
+        }
+
+        desc.m_objects.push_back(object);
+    }
+
+    eastl::string binaryFile = Engine::GetInstance()->GetWorkPath() + "scene_file_benchmark" SCENE_FILE_EXTENSION;
+    eastl::string xmlFile = Engine::GetInstance()->GetWorkPath() + "scene_file_benchmark.xml";
+
+    if (!SaveSceneFile(binaryFile, desc) || !SaveSceneFile(xmlFile, desc))
+    {
+        MY_ERROR("Scene file benchmark : failed to write the files");
+        return;
+    }
+
+    SceneDesc xmlDesc;
+    uint64_t startTime = stm_now();
+    bool bXmlLoaded = LoadSceneFile(xmlFile, xmlDesc);
+    double xmlTime = stm_ms(stm_since(startTime));
+
+    SceneDesc binaryDesc;
+    startTime = stm_now();
+    bool bBinaryLoaded = LoadSceneFile(binaryFile, binaryDesc);
+    double binaryTime = stm_ms(stm_since(startTime));
+
+    std::ifstream xmlStream(xmlFile.c_str(), std::ios::binary | std::ios::ate);
+    std::ifstream binaryStream(binaryFile.c_str(), std::ios::binary | std::ios::ate);
+    uint64_t xmlSize = (uint64_t) xmlStream.tellg();
+    uint64_t binarySize = (uint64_t) binaryStream.tellg();
+    xmlStream.close();
+    binaryStream.close();
+
+    remove(binaryFile.c_str());
+    remove(xmlFile.c_str());
+
+    context.Check("Both formats load the same scene", bXmlLoaded && bBinaryLoaded && IsSceneDescEqual(xmlDesc, binaryDesc));
+
+    MY_INFO("Scene file benchmark : {} objects, xml {:.2f} ms ({} KB), binary {:.2f} ms ({} KB), {:.1f}x faster",
+        objectCount, xmlTime, xmlSize / 1024, binaryTime, binarySize / 1024, binaryTime > 0.0 ? xmlTime / binaryTime : 0.0);
+}
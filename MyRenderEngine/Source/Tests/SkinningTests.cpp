@@ -0,0 +1,171 @@
+#include "Tests.h"
+#include "World/Animation.h"
+#include "World/StaticMesh.h"
+#include "World/MeshMaterial.h"
+#include "World/World.h"
+#include "Core/Engine.h"
+#include "Utils/parallel_for.h"
+#include "Utils/log.h"
+
+#define SKINNING_GPU_POS_TOLERANCE 1e-4f      //< Relative to the distance from the origin, GPUs may fuse the multiply adds
+#define SKINNING_GPU_NORMAL_TOLERANCE 1e-3f
+
+static void CheckGPUSkinning(const eastl::string& name, const SkinningReadback& readback)
+{
+    eastl::vector<float3> pos(readback.m_vertexCount);
+    eastl::vector<float3> normal(readback.m_vertexCount);
+    SkinVertices(readback.m_pPalette, readback.m_input, readback.m_vertexCount, pos.data(), normal.data(), nullptr);
+
+    float maxPosError = 0.0f;
+    float maxNormalError = 0.0f;
+    bool bPosMatched = true;
+    bool bNormalMatched = true;
+    for (uint32_t i = 0; i < readback.m_vertexCount; ++i)
+    {
+        float posError = length(readback.m_pSkinnedPos[i] - pos[i]);
+        maxPosError = max(maxPosError, posError);
+        bPosMatched &= posError <= SKINNING_GPU_POS_TOLERANCE * max(length(pos[i]), 1.0f);
+
+        if (readback.m_pSkinnedNormal)
+        {
+            float normalError = length(readback.m_pSkinnedNormal[i] - normal[i]);
+            maxNormalError = max(maxNormalError, normalError);
+            bNormalMatched &= normalError <= SKINNING_GPU_NORMAL_TOLERANCE;
+        }
+    }
+
+    TestContext context("GPU skinning test");
+    context.Check(fmt::format("{} positions match the CPU reference", name).c_str(), bPosMatched);
+    context.Check(fmt::format("{} normals match the CPU reference", name).c_str(), bNormalMatched);
+
+    MY_INFO("GPU skinning test : {}, {} vertices, max position error {:.7f}, max normal error {:.7f}", name, readback.m_vertexCount, maxPosError, maxNormalError);
+    LogGPUTestResults(context);
+}
+
+void RunSkinningTests(TestContext& context)
+{
+    auto nearlyEqual = [](const float3& a, const float3& b) { return length(a - b) < 1e-4f; };
+
+    // Arm of 2 bones along y, listed child first to exercise the evaluation order
+    Joint child;
+    child.m_name = "child";
+    child.m_parent = 1;
+    child.m_restPose.m_translation = float3(0.0f, 1.0f, 0.0f);
+    child.m_mtxInverseBind = translation_matrix(float3(-2.0f, -1.0f, 0.0f));
+
+    Joint root;
+    root.m_name = "root";
+    root.m_mtxRootParent = translation_matrix(float3(2.0f, 0.0f, 0.0f));
+    root.m_mtxInverseBind = translation_matrix(float3(-2.0f, 0.0f, 0.0f));
+
+    Skeleton skeleton;
+    skeleton.AddJoint(child);
+    skeleton.AddJoint(root);
+    skeleton.Finalize();
+
+    AnimationChannel bend;
+    bend.m_joint = 0;
+    bend.m_path = AnimationPath::Rotation;
+    bend.m_times = { 0.0f, 1.0f };
+    bend.m_values = { quaternion(0.0f, 0.0f, 0.0f, 1.0f), rotation_quat(float3(0.0f, 0.0f, 1.0f), M_PI * 0.5f) };
+
+    AnimationChannel lift;
+    lift.m_joint = 1;
+    lift.m_path = AnimationPath::Translation;
+    lift.m_interpolation = AnimationInterpolation::CubicSpline;
+    lift.m_times = { 0.0f, 1.0f };
+    lift.m_values = { float4(0.0f), float4(0.0f), float4(0.0f), float4(0.0f), float4(0.0f, 2.0f, 0.0f, 0.0f), float4(0.0f) };
+
+    AnimationClip clip("test");
+    clip.AddChannel(bend);
+    clip.AddChannel(lift);
+
+    auto evaluate = [&](float time, eastl::vector<float4x4>& palette)
+    {
+        eastl::vector<JointTransform> pose(skeleton.GetJointCount());
+        eastl::vector<float4x4> global(skeleton.GetJointCount());
+        palette.resize(skeleton.GetJointCount());
+
+        skeleton.GetRestPose(pose.data());
+        clip.Sample(time, pose.data());
+        skeleton.ComputeGlobalMatrices(pose.data(), global.data());
+        skeleton.ComputeSkinningPalette(global.data(), palette.data());
+        return pose;
+    };
+
+    // Vertices in the bind pose mesh space: on the root, on the tip, and blended at the elbow
+    float3 positions[3] = { float3(2.0f, 0.5f, 0.0f), float3(2.0f, 2.0f, 0.0f), float3(2.0f, 1.0f, 0.0f) };
+    float3 normals[3] = { float3(1.0f, 0.0f, 0.0f), float3(1.0f, 0.0f, 0.0f), float3(1.0f, 0.0f, 0.0f) };
+    uint16_t joints[3 * SKINNING_MAX_INFLUENCES] = { 1, 0, 0, 0,  0, 1, 0, 0,  0, 1, 0, 0 };
+    float4 weights[3] = { float4(1.0f, 0.0f, 0.0f, 0.0f), float4(1.0f, 0.0f, 0.0f, 0.0f), float4(0.5f, 0.5f, 0.0f, 0.0f) };
+
+    SkinnedVertexStreams input;
+    input.m_pPos = positions;
+    input.m_pNormal = normals;
+    input.m_pJoints = joints;
+    input.m_pWeights = weights;
+
+    float3 skinnedPos[3];
+    float3 skinnedNormal[3];
+    eastl::vector<float4x4> palette;
+
+    evaluate(0.0f, palette);
+    SkinVertices(palette.data(), input, 3, skinnedPos, skinnedNormal, nullptr);
+    context.Check("Bind pose keeps the vertices", nearlyEqual(skinnedPos[0], positions[0]) && nearlyEqual(skinnedPos[1], positions[1]) && nearlyEqual(skinnedPos[2], positions[2]));
+
+    eastl::vector<JointTransform> pose = evaluate(0.5f, palette);
+    context.Check("Linear rotation is slerped", fabsf(dot(pose[0].m_rotation, rotation_quat(float3(0.0f, 0.0f, 1.0f), M_PI * 0.25f))) > 0.9999f);
+    context.Check("Cubic spline with flat tangents is smooth", nearlyEqual(pose[1].m_translation, float3(0.0f, 1.0f, 0.0f)));
+
+    evaluate(1.0f, palette);
+    SkinVertices(palette.data(), input, 3, skinnedPos, skinnedNormal, nullptr);
+    context.Check("Root vertex follows the root", nearlyEqual(skinnedPos[0], float3(2.0f, 2.5f, 0.0f)));
+    context.Check("Tip vertex is bent around the elbow", nearlyEqual(skinnedPos[1], float3(1.0f, 3.0f, 0.0f)) && nearlyEqual(skinnedNormal[1], float3(0.0f, 1.0f, 0.0f)));
+    context.Check("Elbow vertex is blended", nearlyEqual(skinnedPos[2], float3(2.0f, 3.0f, 0.0f)));
+
+    float3 center;
+    float radius;
+    uint32_t meshletVertices[3] = { 0, 1, 2 };
+    ComputeSkinnedMeshletBound(skinnedPos, meshletVertices, 3, center, radius);
+
+    bool bBounded = true;
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        bBounded &= length(skinnedPos[i] - center) <= radius + 1e-4f;
+    }
+    context.Check("Skinned meshlet bound contains its vertices", bBounded);
+
+    // Poses are sampled on the task scheduler, which has to match sampling them one by one
+    const uint32_t instanceCount = 256;
+    eastl::vector<eastl::vector<float4x4>> parallelPalettes(instanceCount);
+    ParallelFor(instanceCount, [&](uint32_t i)
+        {
+            evaluate((float) i / instanceCount, parallelPalettes[i]);
+        });
+
+    bool bMatched = true;
+    for (uint32_t i = 0; i < instanceCount; ++i)
+    {
+        evaluate((float) i / instanceCount, palette);
+        bMatched &= memcmp(palette.data(), parallelPalettes[i].data(), sizeof(float4x4) * palette.size()) == 0;
+    }
+    context.Check("Parallel pose sampling matches serial", bMatched);
+
+    // The skinning pass of the next frame is read back for every skinned mesh in the world
+    World* pWorld = Engine::GetInstance()->GetWorld();
+    uint32_t skinnedMeshCount = 0;
+    for (uint32_t i = 0; i < pWorld->GetVisibleObjectCount(); ++i)
+    {
+        StaticMesh* pMesh = dynamic_cast<StaticMesh*>(pWorld->GetVisibleObject(i));
+        if (pMesh && pMesh->IsSkinned())
+        {
+            eastl::string name = pMesh->GetName();
+            pMesh->RequestSkinningReadback([name](const SkinningReadback& readback)
+                {
+                    CheckGPUSkinning(name, readback);
+                });
+            ++skinnedMeshCount;
+        }
+    }
+    MY_INFO("Skinning test : the GPU skinning of {} meshes is checked when the next frames are finished", skinnedMeshCount);
+}
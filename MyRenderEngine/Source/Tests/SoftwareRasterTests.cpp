@@ -0,0 +1,139 @@
+#include "Tests.h"
+#include "Renderer/SoftwareRaster.h"
+
+// Rasterizes triangles on the CPU with the setup and the edge functions of the software raster, which needs no GPU
+void RunSoftwareRasterTests(TestContext& context)
+{
+    const uint2 renderSize = uint2(64, 64);
+
+    // Times each pixel is covered by a list of triangles
+    auto coverageCount = [&](const eastl::vector<float3>& vertices, bool bDoubleSided)
+    {
+        eastl::vector<uint32_t> count(renderSize.x * renderSize.y, 0);
+        for (size_t i = 0; i + 2 < vertices.size(); i += 3)
+        {
+            RasterTriangle tri = SetupRasterTriangle(vertices[i], vertices[i + 1], vertices[i + 2], renderSize, bDoubleSided, false);
+            if (!tri.m_bVisible)
+            {
+                continue;
+            }
+
+            for (int32_t y = tri.m_minPixel.y; y <= tri.m_maxPixel.y; ++y)
+            {
+                for (int32_t x = tri.m_minPixel.x; x <= tri.m_maxPixel.x; ++x)
+                {
+                    float depth;
+                    count[y * renderSize.x + x] += RasterizePixel(tri, int2(x, y), depth) ? 1 : 0;
+                }
+            }
+        }
+        return count;
+    };
+
+    // Edges through pixel centers, only the left and the top ones cover them
+    eastl::vector<float3> square = {
+        float3(2.5f, 2.5f, 0.5f), float3(6.5f, 2.5f, 0.5f), float3(6.5f, 6.5f, 0.5f),
+        float3(2.5f, 2.5f, 0.5f), float3(6.5f, 6.5f, 0.5f), float3(2.5f, 6.5f, 0.5f),
+    };
+    eastl::vector<uint32_t> count = coverageCount(square, false);
+    bool bTopLeft = true;
+    for (uint32_t y = 0; y < 8; ++y)
+    {
+        for (uint32_t x = 0; x < 8; ++x)
+        {
+            bool bInside = x >= 2 && x < 6 && y >= 2 && y < 6;
+            bTopLeft = bTopLeft && count[y * renderSize.x + x] == (bInside ? 1u : 0u);
+        }
+    }
+    context.Check("Top-left rule covers shared edges once", bTopLeft);
+
+    // A fan with subpixel vertices, no pixel may be covered twice or missed inside it
+    eastl::vector<float3> fan;
+    const float3 center = float3(20.3f, 21.7f, 0.5f);
+    const uint32_t fanCount = 7;
+    for (uint32_t i = 0; i < fanCount; ++i)
+    {
+        float a0 = 2.0f * M_PI * i / fanCount;
+        float a1 = 2.0f * M_PI * (i + 1) / fanCount;
+        fan.push_back(center);
+        fan.push_back(center + float3(cosf(a0), sinf(a0), 0.0f) * 13.37f);
+        fan.push_back(center + float3(cosf(a1), sinf(a1), 0.0f) * 13.37f);
+    }
+    count = coverageCount(fan, true);
+    uint32_t maxCount = 0;
+    bool bNoHoles = true;
+    for (uint32_t y = 0; y < renderSize.y; ++y)
+    {
+        for (uint32_t x = 0; x < renderSize.x; ++x)
+        {
+            maxCount = max(maxCount, count[y * renderSize.x + x]);
+            float2 offset = float2(x + 0.5f, y + 0.5f) - center.xy();
+            if (length(offset) < 13.37f * cosf(M_PI / fanCount) - 0.01f)
+            {
+                bNoHoles = bNoHoles && count[y * renderSize.x + x] == 1;
+            }
+        }
+    }
+    context.Check("Triangle fan has no overlap and no hole", maxCount == 1 && bNoHoles);
+
+    // Away from the edges, the fixed point coverage is the same as a float one
+    const float3 p0 = float3(3.2f, 4.9f, 0.2f);
+    const float3 p1 = float3(30.7f, 10.1f, 0.8f);
+    const float3 p2 = float3(12.4f, 28.6f, 0.5f);
+    RasterTriangle tri = SetupRasterTriangle(p0, p1, p2, renderSize, false, false);
+    bool bMatchesFloat = tri.m_bVisible && tri.m_bFrontFace;
+    bool bDepthInRange = true;
+    float area = (p1.x - p0.x) * (p2.y - p0.y) - (p1.y - p0.y) * (p2.x - p0.x);
+    for (int32_t y = 0; y < 32; ++y)
+    {
+        for (int32_t x = 0; x < 32; ++x)
+        {
+            float2 p = float2(x + 0.5f, y + 0.5f);
+            float3 w = float3(
+                (p2.x - p1.x) * (p.y - p1.y) - (p2.y - p1.y) * (p.x - p1.x),
+                (p0.x - p2.x) * (p.y - p2.y) - (p0.y - p2.y) * (p.x - p2.x),
+                (p1.x - p0.x) * (p.y - p0.y) - (p1.y - p0.y) * (p.x - p0.x)) / area;
+
+            float depth;
+            bool bCovered = RasterizePixel(tri, int2(x, y), depth);
+            if (minelem(abs(w)) > 0.01f)
+            {
+                bMatchesFloat = bMatchesFloat && bCovered == (minelem(w) > 0.0f);
+            }
+            if (bCovered)
+            {
+                bDepthInRange = bDepthInRange && depth >= 0.2f - 1e-5f && depth <= 0.8f + 1e-5f && fabs(depth - dot(w, float3(p0.z, p1.z, p2.z))) < 1e-3f;
+            }
+        }
+    }
+    context.Check("Coverage matches floating point edges", bMatchesFloat);
+    context.Check("Depth is interpolated linearly in screen space", bDepthInRange);
+
+    float vertexDepth;
+    RasterTriangle vertexTri = SetupRasterTriangle(float3(4.5f, 4.5f, 0.3f), float3(20.5f, 4.5f, 0.6f), float3(4.5f, 20.5f, 0.9f), renderSize, false, false);
+    context.Check("Depth at a vertex is the vertex depth", RasterizePixel(vertexTri, int2(4, 4), vertexDepth) && fabs(vertexDepth - 0.3f) < 1e-6f);
+
+    // The winding of the screen, y is down
+    RasterTriangle clockwise = SetupRasterTriangle(p0, p1, p2, renderSize, false, false);
+    RasterTriangle counterClockwise = SetupRasterTriangle(p0, p2, p1, renderSize, false, false);
+    RasterTriangle doubleSided = SetupRasterTriangle(p0, p2, p1, renderSize, true, false);
+    RasterTriangle frontCCW = SetupRasterTriangle(p0, p2, p1, renderSize, false, true);
+    context.Check("Back faces are culled unless double sided", clockwise.m_bVisible && !counterClockwise.m_bVisible &&
+        doubleSided.m_bVisible && !doubleSided.m_bFrontFace && frontCCW.m_bVisible && frontCCW.m_bFrontFace);
+
+    // Atomic max of the packed texels keeps the closest triangle whatever the order of the threads
+    RasterTriangle nearTri = SetupRasterTriangle(float3(5.0f, 5.0f, 0.6f), float3(28.0f, 8.0f, 0.6f), float3(8.0f, 28.0f, 0.6f), renderSize, false, false);
+    RasterTriangle farTri = SetupRasterTriangle(float3(2.0f, 2.0f, 0.1f), float3(30.0f, 3.0f, 0.1f), float3(3.0f, 30.0f, 0.1f), renderSize, false, false);
+    eastl::vector<uint64_t> nearFirst(renderSize.x * renderSize.y, 0);
+    eastl::vector<uint64_t> farFirst(renderSize.x * renderSize.y, 0);
+    RasterizeTriangle(nearTri, 1, renderSize, nearFirst);
+    RasterizeTriangle(farTri, 2, renderSize, nearFirst);
+    RasterizeTriangle(farTri, 2, renderSize, farFirst);
+    RasterizeTriangle(nearTri, 1, renderSize, farFirst);
+    context.Check("Closest triangle wins in any order", nearFirst == farFirst && (uint32_t) nearFirst[10 * renderSize.x + 10] == 1 && (uint32_t) nearFirst[3 * renderSize.x + 20] == 2);
+
+    const float2 screenSize = float2(1920.0f, 1080.0f);
+    context.Check("Meshlets up to the size limit are software rasterized",
+        IsSoftwareRasterMeshlet(float4(0.5f, 0.5f, 0.5f + 32.0f / screenSize.x, 0.5f + 20.0f / screenSize.y), screenSize) &&
+        !IsSoftwareRasterMeshlet(float4(0.5f, 0.5f, 0.5f + 10.0f / screenSize.x, 0.5f + 40.0f / screenSize.y), screenSize));
+}
@@ -0,0 +1,141 @@
+#include "Tests.h"
+#include "Core/Engine.h"
+#include "Renderer/Renderer.h"
+#include "Utils/log.h"
+#include "EASTL/iterator.h"
+
+// The newest frame weighs 0.1 in the average, the frames before the mode switch weigh 0.9^64 < 0.1%
+#define GPU_TIME_BENCHMARK_FRAMES (64 + RHI_MAX_INFLIGHT_FRAMES)
+
+// Suites of the test translation units
+void RunResourcePoolTests(TestContext& context);
+void RunFramePacingTests(TestContext& context);
+void RunSkinningTests(TestContext& context);
+void RunSceneFileTests(TestContext& context);
+void RunSceneFileBenchmark(TestContext& context);
+void RunMaterialTableTests(TestContext& context);
+void RunVirtualShadowMapTests(TestContext& context);
+void RunUberMaterialBenchmark(TestContext& context);
+void RunVisibilityBufferTests(TestContext& context);
+void RunBasePassGPUTimeBenchmark(TestContext& context);
+void RunSoftwareRasterTests(TestContext& context);
+void RunOcclusionCullingTests(TestContext& context);
+void RunOcclusionCullingBenchmark(TestContext& context);
+void RunHZBTests(TestContext& context);
+void RunHZBGPUTimeBenchmark(TestContext& context);
+void RunGTAOTests(TestContext& context);
+void RunGTAOGPUTimeBenchmark(TestContext& context);
+void RunDescriptorAllocatorBenchmark(TestContext& context);
+void RunAsyncSchedulerTests(TestContext& context);
+void RunFrameAllocatorTests(TestContext& context);
+void RunFrameAllocatorBenchmark(TestContext& context);
+void RunRenderGraphBarrierTests(TestContext& context);
+void RunFrustumCullingTests(TestContext& context);
+void RunMeshletListTests(TestContext& context);
+void RunRenderBatchBenchmark(TestContext& context);
+void RunWorldBenchmark(TestContext& context);
+
+struct TestSuite
+{
+    const char* m_name;
+    void (*m_func)(TestContext& context);
+};
+
+static const TestSuite s_testSuites[] =
+{
+    { "Resource pool test", RunResourcePoolTests },
+    { "Frame pacing test", RunFramePacingTests },
+    { "Skinning test", RunSkinningTests },
+    { "Scene file test", RunSceneFileTests },
+    { "Scene file benchmark", RunSceneFileBenchmark },
+    { "Material table test", RunMaterialTableTests },
+    { "Virtual shadow map test", RunVirtualShadowMapTests },
+    { "Uber material benchmark", RunUberMaterialBenchmark },
+    { "Visibility buffer test", RunVisibilityBufferTests },
+    { "Base pass GPU time", RunBasePassGPUTimeBenchmark },
+    { "Software raster test", RunSoftwareRasterTests },
+    { "Occlusion culling test", RunOcclusionCullingTests },
+    { "Occlusion culling benchmark", RunOcclusionCullingBenchmark },
+    { "HZB test", RunHZBTests },
+    { "HZB GPU time", RunHZBGPUTimeBenchmark },
+    { "GTAO test", RunGTAOTests },
+    { "GTAO GPU time", RunGTAOGPUTimeBenchmark },
+    { "Descriptor allocator benchmark", RunDescriptorAllocatorBenchmark },
+    { "Async scheduler test", RunAsyncSchedulerTests },
+    { "Frame allocator test", RunFrameAllocatorTests },
+    { "Frame allocator benchmark", RunFrameAllocatorBenchmark },
+    { "Render graph barrier test", RunRenderGraphBarrierTests },
+    { "Frustum culling test", RunFrustumCullingTests },
+    { "Meshlet list test", RunMeshletListTests },
+    { "Render batch benchmark", RunRenderBatchBenchmark },
+    { "World benchmark", RunWorldBenchmark },
+};
+
+static uint32_t s_failedGPUCheckCount = 0;
+
+void TestContext::Check(const char* name, bool bPassed)
+{
+    ++m_testCount;
+    m_passedCount += bPassed ? 1 : 0;
+    MY_INFO("{} \"{}\" : {}", m_suiteName, name, bPassed ? "passed" : "FAILED");
+}
+
+float TestContext::Random(float minValue, float maxValue)
+{
+    m_seed = m_seed * 1664525 + 1013904223;
+    return minValue + (maxValue - minValue) * (float) (m_seed >> 8) / (float) (1 << 24);
+}
+
+uint32_t RunTests()
+{
+    uint32_t testCount = 0;
+    uint32_t failedCount = 0;
+
+    for (size_t i = 0; i < eastl::size(s_testSuites); ++i)
+    {
+        TestContext context(s_testSuites[i].m_name);
+        s_testSuites[i].m_func(context);
+
+        // Benchmarks only log their timings
+        if (context.GetTestCount() > 0)
+        {
+            MY_INFO("{} : {}/{} passed", context.GetSuiteName(), context.GetPassedCount(), context.GetTestCount());
+        }
+
+        testCount += context.GetTestCount();
+        failedCount += context.GetTestCount() - context.GetPassedCount();
+    }
+
+    MY_INFO("Tests : {}/{} passed", testCount - failedCount, testCount);
+    return failedCount;
+}
+
+void LogGPUTestResults(const TestContext& context)
+{
+    MY_INFO("{} : {}/{} passed", context.GetSuiteName(), context.GetPassedCount(), context.GetTestCount());
+    s_failedGPUCheckCount += context.GetTestCount() - context.GetPassedCount();
+}
+
+uint32_t GetFailedGPUCheckCount()
+{
+    return s_failedGPUCheckCount;
+}
+
+float MeasureGPUTime(const char* const* passNames, uint32_t passCount)
+{
+    Engine* pEngine = Engine::GetInstance();
+    for (uint32_t i = 0; i < GPU_TIME_BENCHMARK_FRAMES; ++i)
+    {
+        pEngine->Tick();
+    }
+
+    FrameTrace* pFrameTrace = pEngine->GetRenderer()->GetFrameTrace();
+    float total = 0.0f;
+    for (uint32_t i = 0; i < passCount; ++i)
+    {
+        float time = pFrameTrace->GetAverageGPUTime(passNames[i]);
+        total += time;
+        MY_INFO("{} : {:.1f} us", passNames[i], time);
+    }
+    return total;
+}
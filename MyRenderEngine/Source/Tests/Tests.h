@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+
+// Shared harness of the CPU reference tests and the benchmarks, which run from the editor or with the -test argument.
+// Every suite gets its own context, so its checks are counted on their own and its random numbers
+// don't depend on the suites which ran before
+class TestContext
+{
+public:
+    TestContext(const char* suiteName) : m_suiteName(suiteName)
+    {
+    }
+
+    void Check(const char* name, bool bPassed);
+
+    // Deterministic LCG, the same sequence on every run
+    float Random(float minValue, float maxValue);
+
+    const char* GetSuiteName() const { return m_suiteName; }
+    uint32_t GetTestCount() const { return m_testCount; }
+    uint32_t GetPassedCount() const { return m_passedCount; }
+
+private:
+    const char* m_suiteName;
+    uint32_t m_testCount = 0;
+    uint32_t m_passedCount = 0;
+    uint32_t m_seed = 12345;
+};
+
+// Runs every suite and logs the results, returns the number of failed checks. Must be called outside of a frame,
+// the GPU time benchmarks tick the engine. Checks of GPU results are made when their frames are finished, see LogGPUTestResults
+uint32_t RunTests();
+
+// Logs the results of a context of checks on data read back from the GPU, and counts its failures
+void LogGPUTestResults(const TestContext& context);
+uint32_t GetFailedGPUCheckCount();
+
+// Ticks the engine until the smoothed GPU times of the passes only hold frames of the current mode,
+// then logs them and returns their sum in microseconds. The passes which were not timed count as 0
+float MeasureGPUTime(const char* const* passNames, uint32_t passCount);
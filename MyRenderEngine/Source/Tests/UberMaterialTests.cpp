@@ -0,0 +1,53 @@
+#include "Tests.h"
+#include "Core/Engine.h"
+#include "World/StaticMesh.h"
+#include "World/MeshMaterial.h"
+#include "Renderer/ShaderCache.h"
+#include "Renderer/PipelineCache.h"
+#include "Utils/log.h"
+#include "EASTL/hash_set.h"
+
+// Creates the base pass and shadow PSOs of every mesh in the loaded scene in both material modes.
+// Shaders already in the cache aren't compiled again, so the compile time of a mode is only measured the first time
+void RunUberMaterialBenchmark(TestContext& context)
+{
+    World* pWorld = Engine::GetInstance()->GetWorld();
+    Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+    ShaderCache* pShaderCache = pRenderer->GetShaderCache();
+    PipelineStateCache* pPipelineCache = pRenderer->GetPipelineStateCache();
+    bool bUberMaterial = pRenderer->IsUberMaterialEnabled();
+
+    for (uint32_t mode = 0; mode < 2; ++mode)
+    {
+        pRenderer->SetUberMaterialEnabled(mode == 1);
+
+        uint32_t shaderCount = pShaderCache->GetCompiledShaderCount();
+        double compileTime = pShaderCache->GetCompileTime();
+        uint32_t psoCount = pPipelineCache->GetPipelineStateCount();
+
+        eastl::hash_set<IRHIPipelineState*> basePassPSOs;
+        eastl::hash_set<IRHIPipelineState*> shadowPSOs;
+        uint32_t meshCount = 0;
+
+        for (uint32_t i = 0; i < pWorld->GetVisibleObjectCount(); ++i)
+        {
+            StaticMesh* pMesh = dynamic_cast<StaticMesh*>(pWorld->GetVisibleObject(i));
+            if (pMesh == nullptr)
+            {
+                continue;
+            }
+
+            MeshMaterial* pMaterial = pMesh->GetMaterial();
+            basePassPSOs.insert(pMaterial->GetMeshletGPUDrivenPSO());
+            shadowPSOs.insert(pMaterial->GetShadowPSO());
+            ++meshCount;
+        }
+
+        // BasePassGPUDriven issues one indirect dispatch per PSO in each of its two phases
+        MY_INFO("Uber material benchmark : {} mode, {} meshes, {} base pass PSOs ({} indirect dispatches), {} shadow PSOs, {} PSOs created, {} shaders compiled in {:.2f} ms",
+            mode == 1 ? "uber" : "permutation", meshCount, basePassPSOs.size(), basePassPSOs.size() * 2, shadowPSOs.size(),
+            pPipelineCache->GetPipelineStateCount() - psoCount, pShaderCache->GetCompiledShaderCount() - shaderCount, pShaderCache->GetCompileTime() - compileTime);
+    }
+
+    pRenderer->SetUberMaterialEnabled(bUberMaterial);
+}
@@ -0,0 +1,106 @@
+#include "Tests.h"
+#include "Renderer/VirtualShadowMapCache.h"
+
+// Requests pages of a moving camera and of local lights on standalone caches, which needs no GPU
+void RunVirtualShadowMapTests(TestContext& context)
+{
+    const float3 lightDir = normalize(float3(0.3f, -1.0f, 0.2f));
+    const float4x4 mtxPage = GetClipmapPageMatrix(lightDir, 0);
+    const int32_t blockSize = 6;
+
+    // Pages around the camera which the depth buffer would request, as VirtualShadowMap::RequestPages
+    auto requestBlock = [&](VirtualShadowMapCache& cache, const float3& cameraPos)
+    {
+        int2 center = GetClipmapPageOrigin(mtxPage, cameraPos) + VSM_LEVEL_PAGES / 2;
+
+        cache.BeginFrame();
+        for (int32_t y = 0; y < blockSize; ++y)
+        {
+            for (int32_t x = 0; x < blockSize; ++x)
+            {
+                cache.RequestPage(0, center + int2(x - blockSize / 2, y - blockSize / 2));
+            }
+        }
+        return cache.GetRenderedPageCount();
+    };
+
+    VirtualShadowMapCache cache(256, 64);
+    float3 cameraPos = float3(0.1f, 1.7f, 0.3f);
+
+    context.Check("First frame renders every requested page", requestBlock(cache, cameraPos) == blockSize * blockSize);
+
+    uint32_t staticRendered = 0;
+    for (uint32_t frame = 1; frame < 100; ++frame)
+    {
+        staticRendered += requestBlock(cache, cameraPos);
+    }
+    context.Check("Static scene renders no page after the first frame", staticRendered == 0 && cache.GetResidentPageCount() == blockSize * blockSize);
+
+    // An object moved under the camera, only the pages its bounds touch are rendered again
+    int2 pageMin, pageMax;
+    VirtualShadowMapView view = {};
+    view.m_mtxPage = mtxPage;
+    view.m_pageOrigin = GetClipmapPageOrigin(mtxPage, cameraPos);
+    view.m_pageCount = VSM_LEVEL_PAGES;
+    GetSpherePageRect(mtxPage, view, false, cameraPos, 0.2f, pageMin, pageMax);
+    cache.InvalidatePages(0, pageMin, pageMax);
+
+    uint32_t dirtyCount = cache.GetDirtyPageCount();
+    uint32_t invalidatedRendered = requestBlock(cache, cameraPos);
+    context.Check("Moved object re-renders only the pages under it", dirtyCount > 0 && dirtyCount < blockSize * blockSize && invalidatedRendered == dirtyCount);
+
+    // Panned by two pages along the light space x axis
+    float3 pageAxis = float3(mtxPage[0][0], mtxPage[1][0], mtxPage[2][0]);
+    float3 pannedPos = cameraPos + pageAxis * (2.0f / dot(pageAxis, pageAxis));
+    context.Check("Camera pan renders only the uncovered pages", requestBlock(cache, pannedPos) == blockSize * 2);
+
+    // More new pages than the budget, the rest are served by the next frames
+    VirtualShadowMapCache budgetCache(256, 16);
+    context.Check("Rendered pages are limited by the budget", requestBlock(budgetCache, cameraPos) == 16 && budgetCache.GetResidentPageCount() == 16);
+    context.Check("Pages over the budget are rendered in the next frame", requestBlock(budgetCache, cameraPos) == 16 && requestBlock(budgetCache, cameraPos) == 4);
+
+    // The least recently requested pages are evicted for new ones
+    VirtualShadowMapCache lruCache(8);
+    lruCache.BeginFrame();
+    for (int32_t i = 0; i < 8; ++i)
+    {
+        lruCache.RequestPage(1, int2(i, 0));
+    }
+    lruCache.BeginFrame();
+    for (int32_t i = 0; i < 4; ++i)
+    {
+        lruCache.RequestPage(1, int2(i, 0));
+    }
+    lruCache.BeginFrame();
+    for (int32_t i = 0; i < 4; ++i)
+    {
+        lruCache.RequestPage(1, int2(i, 1));
+    }
+    bool bRecentKept = true;
+    bool bOldEvicted = true;
+    for (int32_t i = 0; i < 4; ++i)
+    {
+        bRecentKept = bRecentKept && lruCache.FindPage(1, int2(i, 0)) != VSM_INVALID_PAGE;
+        bOldEvicted = bOldEvicted && lruCache.FindPage(1, int2(i + 4, 0)) == VSM_INVALID_PAGE;
+    }
+    context.Check("Least recently requested pages are evicted first", bRecentKept && bOldEvicted && lruCache.GetRenderedPageCount() == 4);
+
+    lruCache.BeginFrame();
+    uint32_t lastPage = VSM_INVALID_PAGE;
+    for (int32_t i = 0; i < 9; ++i)
+    {
+        lastPage = lruCache.RequestPage(2, int2(i, 0));
+    }
+    context.Check("Pages requested in the same frame are never evicted", lastPage == VSM_INVALID_PAGE && lruCache.GetRenderedPageCount() == 8);
+
+    // Moved local lights free the pages of their faces
+    float4x4 mtxFace = GetLocalLightPageMatrix(float3(0.0f, 0.0f, 0.0f), 0);
+    VirtualShadowMapView faceView = {};
+    faceView.m_mtxPage = mtxFace;
+    faceView.m_pageCount = VSM_LOCAL_LIGHT_PAGES;
+    context.Check("Bounds behind a cube face touch none of its pages", !GetSpherePageRect(mtxFace, faceView, true, float3(-5.0f, 0.0f, 0.0f), 1.0f, pageMin, pageMax));
+    context.Check("Bounds in front of a cube face touch its pages", GetSpherePageRect(mtxFace, faceView, true, float3(5.0f, 0.0f, 0.0f), 1.0f, pageMin, pageMax));
+
+    lruCache.ReleaseView(2);
+    context.Check("Released view frees its pages", lruCache.GetFreePageCount() == 8 && lruCache.GetRenderedPageCount() == 0);
+}
@@ -0,0 +1,136 @@
+#include "Tests.h"
+#include "Renderer/VisibilityBuffer.h"
+#include "Core/Engine.h"
+#include "Utils/log.h"
+
+// Packs visibility IDs and computes barycentrics and their derivatives of a projected triangle, which needs no GPU
+void RunVisibilityBufferTests(TestContext& context)
+{
+    bool bRoundTrip = true;
+    const uint32_t meshletIndices[] = { 0, 1, 12345, (1u << (32 - VISIBILITY_BUFFER_MESHLET_SHIFT)) - 1 };
+    for (uint32_t meshlet : meshletIndices)
+    {
+        for (uint32_t triangle : { 0u, 63u, 123u })
+        {
+            for (bool bFrontFace : { false, true })
+            {
+                uint32_t unpackedMeshlet, unpackedTriangle;
+                bool bUnpackedFrontFace;
+                UnpackVisibilityID(PackVisibilityID(meshlet, triangle, bFrontFace), unpackedMeshlet, unpackedTriangle, bUnpackedFrontFace);
+                bRoundTrip = bRoundTrip && unpackedMeshlet == meshlet && unpackedTriangle == triangle && bUnpackedFrontFace == bFrontFace;
+            }
+        }
+    }
+    context.Check("Visibility ID round trip", bRoundTrip);
+
+    // A triangle at different depths, with the LH reversed z infinite projection of Camera::SetPerspective
+    const float2 renderSize = float2(1920.0f, 1080.0f);
+    const float h = 1.0f / tan(0.5f * degree_to_radian(60.0f));
+    float4x4 mtxProjection = float4x4(0.0f);
+    mtxProjection[0][0] = h * renderSize.y / renderSize.x;
+    mtxProjection[1][1] = h;
+    mtxProjection[2][3] = 1.0f;
+    mtxProjection[3][2] = 0.1f;
+    const float3 viewPos[3] = { float3(-2.0f, -1.0f, 3.0f), float3(3.0f, -0.5f, 12.0f), float3(0.5f, 2.5f, 6.0f) };
+    const float2 uvs[3] = { float2(0.0f, 0.0f), float2(4.0f, 0.0f), float2(0.0f, 2.0f) };
+
+    float4 clipPos[3];
+    uint2 pixelPos[3];
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        clipPos[i] = mul(mtxProjection, float4(viewPos[i], 1.0f));
+        float2 ndc = clipPos[i].xy() / clipPos[i].w;
+        float2 screen = (ndc * float2(0.5f, -0.5f) + 0.5f) * renderSize;
+        pixelPos[i] = uint2((uint32_t) screen.x, (uint32_t) screen.y);
+    }
+
+    // Pixels inside the triangle, on lines from the centroid to the vertices
+    float2 centroid = (float2(pixelPos[0]) + float2(pixelPos[1]) + float2(pixelPos[2])) / 3.0f;
+    eastl::vector<uint2> pixels;
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        for (float t : { 0.0f, 0.3f, 0.6f, 0.85f })
+        {
+            float2 p = lerp(centroid, float2(pixelPos[i]), t);
+            pixels.push_back(uint2((uint32_t) p.x, (uint32_t) p.y));
+        }
+    }
+
+    bool bSumToOne = true;
+    bool bPositionMatches = true;
+    bool bDerivativesMatch = true;
+    float maxDerivativeError = 0.0f;
+    for (const uint2& pixel : pixels)
+    {
+        float2 ndcPos = GetPixelNdcPosition(pixel, renderSize);
+        Barycentrics barycentrics = ComputeBarycentrics(clipPos[0], clipPos[1], clipPos[2], ndcPos, renderSize);
+
+        float sum = barycentrics.m_lambda.x + barycentrics.m_lambda.y + barycentrics.m_lambda.z;
+        bSumToOne = bSumToOne && fabs(sum - 1.0f) < 1e-4f;
+
+        // The interpolated clip position projects to the pixel center
+        float4 clip = InterpolateAttribute(barycentrics, clipPos[0], clipPos[1], clipPos[2]);
+        bPositionMatches = bPositionMatches && length(clip.xy() / clip.w - ndcPos) < 1e-4f;
+
+        // Derivatives of the uv, as the texture sampling of the resolve uses them, against the neighbour pixels
+        float2 uv = InterpolateAttribute(barycentrics, uvs[0], uvs[1], uvs[2]);
+        Barycentrics right = ComputeBarycentrics(clipPos[0], clipPos[1], clipPos[2], GetPixelNdcPosition(pixel + uint2(1, 0), renderSize), renderSize);
+        Barycentrics down = ComputeBarycentrics(clipPos[0], clipPos[1], clipPos[2], GetPixelNdcPosition(pixel + uint2(0, 1), renderSize), renderSize);
+        float2 uvDDX = InterpolateAttribute(right, uvs[0], uvs[1], uvs[2]) - uv;
+        float2 uvDDY = InterpolateAttribute(down, uvs[0], uvs[1], uvs[2]) - uv;
+
+        float errorX = length(InterpolateAttributeDDX(barycentrics, uvs[0], uvs[1], uvs[2]) - uvDDX);
+        float errorY = length(InterpolateAttributeDDY(barycentrics, uvs[0], uvs[1], uvs[2]) - uvDDY);
+        maxDerivativeError = max(maxDerivativeError, max(errorX, errorY));
+        bDerivativesMatch = bDerivativesMatch && errorX < 1e-3f * length(uvDDX) + 1e-6f && errorY < 1e-3f * length(uvDDY) + 1e-6f;
+    }
+    context.Check("Weights sum to one", bSumToOne);
+    context.Check("Interpolated position matches the pixel", bPositionMatches);
+    context.Check("Derivatives match the neighbour pixels", bDerivativesMatch);
+
+    bool bVertexWeights = true;
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        float2 ndc = clipPos[i].xy() / clipPos[i].w;
+        Barycentrics barycentrics = ComputeBarycentrics(clipPos[0], clipPos[1], clipPos[2], ndc, renderSize);
+        bVertexWeights = bVertexWeights && fabs(barycentrics.m_lambda[i] - 1.0f) < 1e-4f;
+    }
+    context.Check("Weight of a vertex is one at its position", bVertexWeights);
+
+    MY_INFO("Visibility buffer test : max uv derivative error {:.7f}", maxDerivativeError);
+}
+
+// GPU time of the passes which write the G-buffer, rendered in each mode until the smoothed times settle
+void RunBasePassGPUTimeBenchmark(TestContext& context)
+{
+    Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+    bool bVisibilityBuffer = pRenderer->IsVisibilityBufferEnabled();
+
+    const char* gbufferPasses[] = {
+        "Base Pass",
+        "GBuffer Pass",
+    };
+
+    const char* visibilityBufferPasses[] = {
+        "Visibility Buffer 1st Phase",
+        "Software Raster 1st Phase",
+        "Depth Merge 1st Phase",
+        "Visibility Buffer 2nd Phase",
+        "Software Raster 2nd Phase",
+        "Depth Merge 2nd Phase",
+        "Visibility Buffer Classify",
+        "Visibility Buffer Build Bins",
+        "Visibility Buffer Scatter",
+        "Visibility Buffer Resolve",
+    };
+
+    pRenderer->SetVisibilityBufferEnabled(false);
+    float gbufferTotal = MeasureGPUTime(gbufferPasses, (uint32_t)eastl::size(gbufferPasses));
+
+    pRenderer->SetVisibilityBufferEnabled(true);
+    float visibilityBufferTotal = MeasureGPUTime(visibilityBufferPasses, (uint32_t)eastl::size(visibilityBufferPasses));
+
+    pRenderer->SetVisibilityBufferEnabled(bVisibilityBuffer);
+
+    MY_INFO("Base pass : G-buffer {:.1f} us, visibility buffer {:.1f} us", gbufferTotal, visibilityBufferTotal);
+}
@@ -0,0 +1,109 @@
+#include "Tests.h"
+#include "World/WorldObjectData.h"
+#include "World/WorldObjectBVH.h"
+#include "Utils/math.h"
+#include "Utils/log.h"
+#include "EASTL/sort.h"
+#include "sokol/sokol_time.h"
+
+// The CPU side of World::Tick for growing object counts : the parallel transform update, then the culling of World::CullObjects.
+// A quarter of the objects are dynamic and move every frame, half of them are children of another dynamic object
+void RunWorldBenchmark(TestContext& context)
+{
+    const uint32_t objectCounts[] = { 1000, 10000, 100000, 1000000 };
+    const uint32_t frameCount = 16;
+
+    float4x4 mtxView = inverse(translation_matrix(float3(0.0f, 10.0f, -500.0f)));
+    float4x4 mtxProjection = linalg::perspective_matrix(degree_to_radian(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f, linalg::pos_z, linalg::zero_to_one);
+    float4 planes[6];
+    GetFrustumPlanes(mul(mtxProjection, mtxView), planes);
+
+    for (uint32_t objectCount : objectCounts)
+    {
+        WorldObjectData objectData;
+        objectData.Reserve(objectCount);
+
+        eastl::vector<uint32_t> dynamicObjects;
+        eastl::vector<uint32_t> movingObjects;
+        for (uint32_t i = 0; i < objectCount; ++i)
+        {
+            bool bStatic = i % 4 != 0;
+            bool bChild = !bStatic && i % 8 == 4;
+            uint32_t id = objectData.Add(bChild ? i - 4 : WORLD_OBJECT_INVALID_PARENT, bStatic);
+
+            float3 pos = bChild ? float3(2.0f, 0.0f, 0.0f) : float3(context.Random(-1000.0f, 1000.0f), context.Random(-50.0f, 50.0f), context.Random(-1000.0f, 1000.0f));
+            objectData.SetLocalTransform(id, pos, quaternion(0.0f, 0.0f, 0.0f, 1.0f), float3(1.0f, 1.0f, 1.0f));
+            objectData.SetLocalBounds(id, float3(0.0f, 0.0f, 0.0f), context.Random(0.5f, 5.0f));
+
+            if (!bStatic)
+            {
+                dynamicObjects.push_back(id);
+                if (!bChild)
+                {
+                    movingObjects.push_back(id);
+                }
+            }
+        }
+
+        uint64_t startTime = stm_now();
+        objectData.Update();
+        double firstUpdateTime = stm_ms(stm_since(startTime));
+
+        WorldObjectBVH bvh;
+        startTime = stm_now();
+        bvh.Build(objectData);
+        double buildTime = stm_ms(stm_since(startTime));
+
+        const float* pCenterX = objectData.GetCenterX();
+        const float* pCenterY = objectData.GetCenterY();
+        const float* pCenterZ = objectData.GetCenterZ();
+        const float* pRadius = objectData.GetRadius();
+
+        eastl::vector<uint32_t> visibleObjects;
+        visibleObjects.reserve(objectCount);
+        eastl::vector<uint32_t> bruteForceVisibleObjects(objectCount);
+
+        double updateTime = 0.0;
+        double cullingTime = 0.0;
+        double bruteForceTime = 0.0;
+        bool bMatched = true;
+
+        for (uint32_t frame = 0; frame < frameCount; ++frame)
+        {
+            for (uint32_t id : movingObjects)
+            {
+                float3 pos = float3(pCenterX[id], pCenterY[id], pCenterZ[id]) + float3(1.0f, 0.0f, 0.5f);
+                objectData.SetLocalTransform(id, pos, rotation_quat(float3(0.0f, 10.0f * frame, 0.0f)), float3(1.0f, 1.0f, 1.0f));
+            }
+
+            startTime = stm_now();
+            objectData.Update();
+            updateTime += stm_ms(stm_since(startTime));
+
+            startTime = stm_now();
+            visibleObjects.clear();
+            bvh.Cull(planes, 6, visibleObjects);
+            for (uint32_t id : dynamicObjects)
+            {
+                if (FrustumCull(planes, 6, float3(pCenterX[id], pCenterY[id], pCenterZ[id]), pRadius[id]))
+                {
+                    visibleObjects.push_back(id);
+                }
+            }
+            cullingTime += stm_ms(stm_since(startTime));
+
+            startTime = stm_now();
+            uint32_t bruteForceVisibleCount = FrustumCull(planes, 6, pCenterX, pCenterY, pCenterZ, pRadius, objectCount, bruteForceVisibleObjects.data());
+            bruteForceTime += stm_ms(stm_since(startTime));
+
+            // The BVH returns the static objects in tree order, the brute force culling returns all of them in id order
+            eastl::sort(visibleObjects.begin(), visibleObjects.end());
+            bMatched &= visibleObjects.size() == bruteForceVisibleCount && eastl::equal(visibleObjects.begin(), visibleObjects.end(), bruteForceVisibleObjects.begin());
+        }
+
+        context.Check(fmt::format("{} objects : BVH and dynamic culling sees the same objects as the brute force culling", objectCount).c_str(), bMatched && !objectData.IsStaticObjectMoved());
+
+        MY_INFO("World benchmark : {} objects, first update {:.2f} ms, BVH build {:.2f} ms, per frame : update {:.3f} ms, BVH culling {:.3f} ms, SIMD brute force culling {:.3f} ms, {} visible",
+            objectCount, firstUpdateTime, buildTime, updateTime / frameCount, cullingTime / frameCount, bruteForceTime / frameCount, visibleObjects.size());
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "linear_allocator.h"
+#include "enkiTS/TaskScheduler.h"
+#include "EASTL/unique_ptr.h"
+#include "EASTL/vector.h"
+#include <thread>
+
+// Per frame allocator which can be used in ParallelFor bodies, every task scheduler thread bumps its own arena.
+// Threads which are not registered in the task scheduler fall back to a shared lock-free chunk
+class FrameAllocator
+{
+public:
+    FrameAllocator(enki::TaskScheduler* pTaskScheduler, size_t arenaSize) :
+        m_pTaskScheduler(pTaskScheduler),
+        m_sharedArena(arenaSize),
+        m_mainThreadID(std::this_thread::get_id())
+    {
+        uint32_t threadCount = pTaskScheduler->GetNumTaskThreads();
+        m_arenas.reserve(threadCount);
+
+        for (uint32_t i = 0; i < threadCount; ++i)
+        {
+            m_arenas.push_back(eastl::make_unique<LinearAllocator>(arenaSize));
+        }
+    }
+
+    void* Alloc(size_t size, size_t alignment = 1)
+    {
+        LinearAllocator* pArena = GetThreadArena();
+        return pArena ? pArena->Alloc(size, alignment) : m_sharedArena.Alloc(size, alignment);
+    }
+
+    LinearAllocator& GetArena(uint32_t threadIndex) { return *m_arenas[threadIndex]; }
+
+    // Returns nullptr for threads which are not registered in the task scheduler
+    LinearAllocator* GetThreadArena()
+    {
+        // enkiTS returns 0 for unregistered threads as well as for the thread which created the scheduler
+        uint32_t threadIndex = m_pTaskScheduler->GetThreadNum();
+        if (threadIndex == 0 && std::this_thread::get_id() != m_mainThreadID)
+        {
+            return nullptr;
+        }
+
+        return m_arenas[threadIndex].get();
+    }
+
+    // Must be called when no thread allocates, usually at the end of frame
+    void Reset()
+    {
+        m_lastFrameSize = GetAllocatedSize();
+        m_highWaterMark = max(m_highWaterMark, m_lastFrameSize);
+
+        for (size_t i = 0; i < m_arenas.size(); ++i)
+        {
+            m_arenas[i]->Reset();
+        }
+        m_sharedArena.Reset();
+    }
+
+    size_t GetAllocatedSize() const
+    {
+        size_t size = m_sharedArena.GetAllocatedSize();
+        for (size_t i = 0; i < m_arenas.size(); ++i)
+        {
+            size += m_arenas[i]->GetAllocatedSize();
+        }
+        return size;
+    }
+
+    size_t GetLastFrameSize() const { return m_lastFrameSize; }
+    size_t GetHighWaterMark() const { return m_highWaterMark; }
+    uint64_t GetContentionCount() const { return m_sharedArena.GetContentionCount(); }
+
+private:
+    enki::TaskScheduler* m_pTaskScheduler;
+    eastl::vector<eastl::unique_ptr<LinearAllocator>> m_arenas;
+    ConcurrentLinearAllocator m_sharedArena;
+    std::thread::id m_mainThreadID;
+
+    size_t m_lastFrameSize = 0;
+    size_t m_highWaterMark = 0;
+};
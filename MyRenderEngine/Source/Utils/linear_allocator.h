@@ -2,38 +2,207 @@
 #include "memory.h"
 #include "assert.h"
 #include "math.h"
+#include "EASTL/atomic.h"
 
+inline char* AlignPointer(char* p, size_t alignment)
+{
+    MY_ASSERT((alignment & (alignment - 1)) == 0);
+    return (char*) (((uintptr_t) p + alignment - 1) & ~(uintptr_t) (alignment - 1));
+}
+
+// Bump allocator for one thread. A new chunk is chained when the current one is full,
+// Reset merges the chunks into one which fits the high water mark
 class LinearAllocator
 {
 public:
-    LinearAllocator(uint32_t size)
+    LinearAllocator(size_t chunkSize) : m_chunkSize(chunkSize)
     {
-        m_pMemory = MY_ALLOC(size);
-        m_memorySize = size;       
+        m_pChunk = CreateChunk(chunkSize, nullptr);
     }
 
     ~LinearAllocator()
     {
-        MY_FREE(m_pMemory);
+        DestroyChunks(m_pChunk);
     }
 
-    void* Alloc(uint32_t size, uint32_t alignment = 1)
+    void* Alloc(size_t size, size_t alignment = 1)
     {
-        uint32_t address = RoundUpPow2(m_pointerOffset, alignment);
-        MY_ASSERT(address + size <= m_memorySize);
-        m_pointerOffset = address + size;
-        return (char*)m_pMemory + address;
+        char* pAddress = AlignPointer(m_pChunk->GetData() + m_pointerOffset, alignment);
+        if (pAddress + size > m_pChunk->GetData() + m_pChunk->m_size)
+        {
+            m_chainedSize += m_pointerOffset;
+            m_pChunk = CreateChunk(max(m_chunkSize, size + alignment), m_pChunk);
+            pAddress = AlignPointer(m_pChunk->GetData(), alignment);
+        }
+
+        m_pointerOffset = (size_t) (pAddress + size - m_pChunk->GetData());
+        return pAddress;
     }
 
     void Reset()
     {
+        m_lastFrameSize = GetAllocatedSize();
+        m_highWaterMark = max(m_highWaterMark, m_lastFrameSize);
+
+        if (m_pChunk->m_pNext != nullptr)
+        {
+            DestroyChunks(m_pChunk);
+            m_chunkSize = max(m_chunkSize, m_highWaterMark);
+            m_pChunk = CreateChunk(m_chunkSize, nullptr);
+        }
+
         m_pointerOffset = 0;
+        m_chainedSize = 0;
+    }
+
+    size_t GetAllocatedSize() const { return m_chainedSize + m_pointerOffset; }
+    size_t GetLastFrameSize() const { return m_lastFrameSize; }   //< Allocated size before the last Reset
+    size_t GetHighWaterMark() const { return m_highWaterMark; }
+
+private:
+    struct Chunk
+    {
+        Chunk* m_pNext;
+        size_t m_size;
+
+        char* GetData() { return (char*) (this + 1); }
+    };
+
+    static Chunk* CreateChunk(size_t size, Chunk* pNext)
+    {
+        Chunk* pChunk = (Chunk*) MY_ALLOC(sizeof(Chunk) + size, 64);
+        pChunk->m_pNext = pNext;
+        pChunk->m_size = size;
+        return pChunk;
+    }
+
+    static void DestroyChunks(Chunk* pChunk)
+    {
+        while (pChunk != nullptr)
+        {
+            Chunk* pNext = pChunk->m_pNext;
+            MY_FREE(pChunk);
+            pChunk = pNext;
+        }
     }
 
 private:
-    void* m_pMemory = nullptr;
-    uint32_t m_memorySize = 0;
-    uint32_t m_pointerOffset = 0;
+    Chunk* m_pChunk = nullptr;      //< Current chunk, older ones are linked by m_pNext
+    size_t m_chunkSize = 0;
+    size_t m_pointerOffset = 0;
+    size_t m_chainedSize = 0;       //< Allocated size in the older chunks
+    size_t m_lastFrameSize = 0;
+    size_t m_highWaterMark = 0;
 };
 
+// Lock-free bump allocator which can be used from any thread, Reset must be called when no thread allocates.
+// The first thread which finds the chunk full swaps in a new chunk, others retry on it
+class ConcurrentLinearAllocator
+{
+public:
+    ConcurrentLinearAllocator(size_t chunkSize) : m_chunkSize(chunkSize)
+    {
+        m_pChunk.store(CreateChunk(chunkSize, nullptr));
+    }
+
+    ~ConcurrentLinearAllocator()
+    {
+        DestroyChunks(m_pChunk.load());
+    }
+
+    void* Alloc(size_t size, size_t alignment = 1)
+    {
+        size_t reserveSize = size + alignment - 1;
+
+        while (true)
+        {
+            Chunk* pChunk = m_pChunk.load();
+            size_t offset = pChunk->m_offset.fetch_add(reserveSize);
+            if (offset + reserveSize <= pChunk->m_size)
+            {
+                return AlignPointer(pChunk->GetData() + offset, alignment);
+            }
 
+            m_contentionCount.fetch_add(1);
+
+            if (m_pChunk.load() != pChunk)
+            {
+                continue;   //< Another thread has chained a new chunk already
+            }
+
+            Chunk* pNewChunk = CreateChunk(max(m_chunkSize, reserveSize), pChunk);
+            if (!m_pChunk.compare_exchange_strong(pChunk, pNewChunk))
+            {
+                pNewChunk->m_pNext = nullptr;
+                DestroyChunks(pNewChunk);
+            }
+        }
+    }
+
+    void Reset()
+    {
+        m_lastFrameSize = GetAllocatedSize();
+        m_highWaterMark = max(m_highWaterMark, m_lastFrameSize);
+
+        Chunk* pChunk = m_pChunk.load();
+        if (pChunk->m_pNext != nullptr)
+        {
+            DestroyChunks(pChunk);
+            m_chunkSize = max(m_chunkSize, m_highWaterMark);
+            pChunk = CreateChunk(m_chunkSize, nullptr);
+            m_pChunk.store(pChunk);
+        }
+
+        pChunk->m_offset.store(0);
+    }
+
+    size_t GetAllocatedSize() const
+    {
+        size_t size = 0;
+        for (Chunk* pChunk = m_pChunk.load(); pChunk != nullptr; pChunk = pChunk->m_pNext)
+        {
+            size += min(pChunk->m_offset.load(), pChunk->m_size);
+        }
+        return size;
+    }
+
+    size_t GetLastFrameSize() const { return m_lastFrameSize; }
+    size_t GetHighWaterMark() const { return m_highWaterMark; }
+    uint64_t GetContentionCount() const { return m_contentionCount.load(); }   //< How many times the chunk was found full
+
+private:
+    struct Chunk
+    {
+        Chunk* m_pNext;
+        size_t m_size;
+        eastl::atomic<size_t> m_offset;
+
+        char* GetData() { return (char*) (this + 1); }
+    };
+
+    static Chunk* CreateChunk(size_t size, Chunk* pNext)
+    {
+        Chunk* pChunk = (Chunk*) MY_ALLOC(sizeof(Chunk) + size, 64);
+        pChunk->m_pNext = pNext;
+        pChunk->m_size = size;
+        new (&pChunk->m_offset) eastl::atomic<size_t>(0);
+        return pChunk;
+    }
+
+    static void DestroyChunks(Chunk* pChunk)
+    {
+        while (pChunk != nullptr)
+        {
+            Chunk* pNext = pChunk->m_pNext;
+            MY_FREE(pChunk);
+            pChunk = pNext;
+        }
+    }
+
+private:
+    eastl::atomic<Chunk*> m_pChunk;
+    size_t m_chunkSize = 0;
+    size_t m_lastFrameSize = 0;
+    size_t m_highWaterMark = 0;
+    eastl::atomic<uint64_t> m_contentionCount{ 0 };
+};
@@ -2,6 +2,17 @@
 #include "assert.h"
 #include "linalg/linalg.h"
 
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define MATH_SIMD_AVX2 1
+#elif defined(_M_X64) || defined(__SSE2__)
+    #include <emmintrin.h>
+    #define MATH_SIMD_SSE 1
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>
+    #define MATH_SIMD_NEON 1
+#endif
+
 using namespace linalg;
 using namespace linalg::aliases;
 
@@ -120,6 +131,29 @@ inline float4 normalize_plane(const float4& plane)
     return plane * (1.0f / length);
 }
 
+// Planes of a view projection matrix pointing inside, in the order left, right, top, bottom, near, far
+inline void GetFrustumPlanes(const float4x4& matrix, float4* planes)
+{
+    // Same as Camera::UpdateFrustumPlanes, matrix[column][row]
+    float4 row0 = float4(matrix[0][0], matrix[1][0], matrix[2][0], matrix[3][0]);
+    float4 row1 = float4(matrix[0][1], matrix[1][1], matrix[2][1], matrix[3][1]);
+    float4 row2 = float4(matrix[0][2], matrix[1][2], matrix[2][2], matrix[3][2]);
+    float4 row3 = float4(matrix[0][3], matrix[1][3], matrix[2][3], matrix[3][3]);
+
+    planes[0] = row3 + row0;
+    planes[1] = row3 - row0;
+    planes[2] = row3 - row1;
+    planes[3] = row3 + row1;
+    planes[4] = row2;
+    planes[5] = row3 - row2;
+
+    for (uint32_t i = 0; i < 6; ++i)
+    {
+        // The far plane of the infinite perspective has no normal, nothing is outside of it
+        planes[i] = length(planes[i].xyz()) > 0.0f ? normalize_plane(planes[i]) : float4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+}
+
 inline bool FrustumCull(const float4* plane, uint32_t planeCount, float3 center, float radius)
 {
     for (int i = 0; i < planeCount; ++i)
@@ -133,12 +167,160 @@ inline bool FrustumCull(const float4* plane, uint32_t planeCount, float3 center,
     return true;
 }
 
+// Returns false if the box is outside, bFullyInside tells whether the whole box is inside of all planes
+inline bool FrustumCull(const float4* plane, uint32_t planeCount, const float3& boxMin, const float3& boxMax, bool& bFullyInside)
+{
+    bFullyInside = true;
+    for (uint32_t i = 0; i < planeCount; ++i)
+    {
+        float3 n = plane[i].xyz();
+        float3 positive = float3(n.x >= 0.0f ? boxMax.x : boxMin.x, n.y >= 0.0f ? boxMax.y : boxMin.y, n.z >= 0.0f ? boxMax.z : boxMin.z);
+        float3 negative = float3(n.x >= 0.0f ? boxMin.x : boxMax.x, n.y >= 0.0f ? boxMin.y : boxMax.y, n.z >= 0.0f ? boxMin.z : boxMax.z);
+
+        if (dot(positive, n) + plane[i].w < 0.0f)
+        {
+            bFullyInside = false;
+            return false;
+        }
+
+        if (dot(negative, n) + plane[i].w < 0.0f)
+        {
+            bFullyInside = false;
+        }
+    }
+
+    return true;
+}
+
+// Culls spheres stored in SoA arrays, writes the indices of the visible ones and returns the visible count
+inline uint32_t FrustumCullScalar(const float4* plane, uint32_t planeCount, const float* centerX, const float* centerY, const float* centerZ, const float* radius, uint32_t count, uint32_t* pVisibleIndices)
+{
+    uint32_t visibleCount = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (FrustumCull(plane, planeCount, float3(centerX[i], centerY[i], centerZ[i]), radius[i]))
+        {
+            pVisibleIndices[visibleCount++] = i;
+        }
+    }
+
+    return visibleCount;
+}
+
+// SIMD version of FrustumCullScalar, 8 (AVX2) or 4 (SSE, NEON) spheres per iteration.
+// No FMA and the same operation order as FrustumCull, so both produce identical results
+inline uint32_t FrustumCull(const float4* plane, uint32_t planeCount, const float* centerX, const float* centerY, const float* centerZ, const float* radius, uint32_t count, uint32_t* pVisibleIndices)
+{
+    uint32_t visibleCount = 0;
+    uint32_t i = 0;
+
+#if MATH_SIMD_AVX2
+    const __m256 zero = _mm256_setzero_ps();
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(centerX + i);
+        __m256 y = _mm256_loadu_ps(centerY + i);
+        __m256 z = _mm256_loadu_ps(centerZ + i);
+        __m256 r = _mm256_loadu_ps(radius + i);
+        __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        for (uint32_t p = 0; p < planeCount; ++p)
+        {
+            __m256 d = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(plane[p].x)), _mm256_mul_ps(y, _mm256_set1_ps(plane[p].y)));
+            d = _mm256_add_ps(d, _mm256_mul_ps(z, _mm256_set1_ps(plane[p].z)));
+            d = _mm256_add_ps(_mm256_add_ps(d, _mm256_set1_ps(plane[p].w)), r);
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(d, zero, _CMP_NLT_UQ));
+        }
+
+        uint32_t mask = (uint32_t) _mm256_movemask_ps(visible);
+        for (uint32_t j = 0; j < 8; ++j)
+        {
+            if (mask & (1 << j))
+            {
+                pVisibleIndices[visibleCount++] = i + j;
+            }
+        }
+    }
+#elif MATH_SIMD_SSE
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(centerX + i);
+        __m128 y = _mm_loadu_ps(centerY + i);
+        __m128 z = _mm_loadu_ps(centerZ + i);
+        __m128 r = _mm_loadu_ps(radius + i);
+        __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+        for (uint32_t p = 0; p < planeCount; ++p)
+        {
+            __m128 d = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane[p].x)), _mm_mul_ps(y, _mm_set1_ps(plane[p].y)));
+            d = _mm_add_ps(d, _mm_mul_ps(z, _mm_set1_ps(plane[p].z)));
+            d = _mm_add_ps(_mm_add_ps(d, _mm_set1_ps(plane[p].w)), r);
+            visible = _mm_and_ps(visible, _mm_cmpnlt_ps(d, zero));
+        }
+
+        uint32_t mask = (uint32_t) _mm_movemask_ps(visible);
+        for (uint32_t j = 0; j < 4; ++j)
+        {
+            if (mask & (1 << j))
+            {
+                pVisibleIndices[visibleCount++] = i + j;
+            }
+        }
+    }
+#elif MATH_SIMD_NEON
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+        float32x4_t x = vld1q_f32(centerX + i);
+        float32x4_t y = vld1q_f32(centerY + i);
+        float32x4_t z = vld1q_f32(centerZ + i);
+        float32x4_t r = vld1q_f32(radius + i);
+        uint32x4_t visible = vdupq_n_u32(0xFFFFFFFF);
+
+        for (uint32_t p = 0; p < planeCount; ++p)
+        {
+            float32x4_t d = vaddq_f32(vmulq_n_f32(x, plane[p].x), vmulq_n_f32(y, plane[p].y));
+            d = vaddq_f32(d, vmulq_n_f32(z, plane[p].z));
+            d = vaddq_f32(vaddq_f32(d, vdupq_n_f32(plane[p].w)), r);
+            visible = vbicq_u32(visible, vcltq_f32(d, zero));
+        }
+
+        uint32_t lanes[4];
+        vst1q_u32(lanes, visible);
+        for (uint32_t j = 0; j < 4; ++j)
+        {
+            if (lanes[j])
+            {
+                pVisibleIndices[visibleCount++] = i + j;
+            }
+        }
+    }
+#endif
+
+    // Remaining spheres
+    for (; i < count; ++i)
+    {
+        if (FrustumCull(plane, planeCount, float3(centerX[i], centerY[i], centerZ[i]), radius[i]))
+        {
+            pVisibleIndices[visibleCount++] = i;
+        }
+    }
+
+    return visibleCount;
+}
+
 template<class T>
 inline bool nearly_equal(const T& a, const T& b)
 {
     return nearly_equal(a.x, b.x) && nearly_equal(a.y, b.y) && nearly_equal(a.z, b.z) && nearly_equal(a.w, b.w);
 }
 
+inline bool nearly_equal(const float3& a, const float3& b)
+{
+    return nearly_equal(a.x, b.x) && nearly_equal(a.y, b.y) && nearly_equal(a.z, b.z);
+}
+
 inline uint32_t DivideRoundingUp(uint32_t a, uint32_t b)
 {
     return (a + b - 1) / b;
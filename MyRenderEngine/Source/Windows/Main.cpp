@@ -1,8 +1,15 @@
 #include "Core/Engine.h"
+#include "Renderer/StagingFill.h"
+#include "Tests/Tests.h"
+#include "Utils/fmt.h"
+#include "enkiTS/TaskScheduler.h"
+#include "sokol/sokol_time.h"
 #include "imgui/imgui_impl_win32.h"
 #include "rpmalloc/rpmalloc.h"
 #include "resource.h"
 #include <windows.h>
+#include <shellapi.h>
+#include <fstream>
 
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
 
@@ -49,11 +56,85 @@ static eastl::string GetWorkPath()
     return workPath.substr(0, lastSlash + 1);   //< include '\'
 }
 
+static eastl::string ToString(const wchar_t* text)
+{
+    int size = WideCharToMultiByte(CP_ACP, 0, text, -1, NULL, 0, NULL, false);
+
+    eastl::string result;
+    result.resize(size);
+    WideCharToMultiByte(CP_ACP, 0, text, -1, (LPSTR)result.c_str(), size, NULL, false);
+    return result.c_str();  //< Drops the null terminator
+}
+
+// Index of a whole argument, -1 when it isn't on the command line
+static int FindArgument(int argc, LPWSTR* argv, const wchar_t* name)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (wcscmp(argv[i], name) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Headless, no window or device is created. The result is written to upload_benchmark.txt in the work path
+static int RunUploadBenchmark(const wchar_t* pFile)
+{
+    eastl::string file = pFile != nullptr ? ToString(pFile) : "";
+
+    enki::TaskSchedulerConfig config;
+    config.profilerCallbacks.threadStart = [](uint32_t i)
+    {
+        rpmalloc_thread_initialize();
+    };
+
+    config.profilerCallbacks.threadStop = [](uint32_t i)
+    {
+        rpmalloc_thread_finalize(1);
+    };
+
+    enki::TaskScheduler taskScheduler;
+    taskScheduler.Initialize(config);
+    stm_setup();
+
+    StagingFillBenchmarkResult result;
+    bool bSucceeded = StagingFill::RunBenchmark(&taskScheduler, file, result);
+    taskScheduler.WaitforAllAndShutdown();
+
+    eastl::string report = bSucceeded ?
+        fmt::format("{} : {:.1f} MB, single thread {:.0f} MB/s, {} task threads {:.0f} MB/s\n", file, result.m_fileSize / (1024.0 * 1024.0),
+            result.m_singleThreadMBps, config.numTaskThreadsToCreate + 1, result.m_parallelMBps).c_str() :
+        fmt::format("{} : failed to read the file\n", file).c_str();
+
+    std::ofstream stream;
+    stream.open((GetWorkPath() + "upload_benchmark.txt").c_str());
+    stream << report.c_str();
+    stream.close();
+
+    OutputDebugStringA(report.c_str());
+    return bSucceeded ? 0 : 1;
+}
+
 int APIENTRY wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPWSTR cmdLine, _In_ int cmdShow)
 {
     rpmalloc_initialize();
     ImGui_ImplWin32_EnableDpiAwareness();
 
+    // Whole arguments, so -trace doesn't match -traceFoo. CommandLineToArgvW also strips the quotes of paths
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+
+    // -upload_benchmark <file> measures the throughput from disk to staging memory
+    int benchmarkArg = FindArgument(argc, argv, L"-upload_benchmark");
+    if (benchmarkArg >= 0)
+    {
+        int result = RunUploadBenchmark(benchmarkArg + 1 < argc ? argv[benchmarkArg + 1] : nullptr);
+        LocalFree(argv);
+        return result;
+    }
+
     /*
     // Better icon load method 
     HICON hIcon = static_cast<HICON>(::LoadImage(hInstance,
@@ -107,6 +188,31 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance
     MessageBox(hWnd, L"Wait for debuger", L"Caution", MB_OK);
 
     Engine::GetInstance()->Init(GetWorkPath(), hWnd, windowWidth, windowHeight);
+
+    // -test runs the tests of the editor menu and exits, the exit code is the number of failed checks
+    if (FindArgument(argc, argv, L"-test") >= 0)
+    {
+        LocalFree(argv);
+
+        uint32_t failedCount = RunTests();
+
+        // Checks of GPU results are made when the frames they read back are finished
+        for (uint32_t i = 0; i < RHI_MAX_INFLIGHT_FRAMES + 2; ++i)
+        {
+            Engine::GetInstance()->Tick();
+        }
+        failedCount += GetFailedGPUCheckCount();
+
+        Engine::GetInstance()->Shutdown();
+        return (int) failedCount;
+    }
+
+    // -trace exports the first frames to a Chrome trace json, same as F11 in the editor
+    if (FindArgument(argc, argv, L"-trace") >= 0)
+    {
+        Engine::GetInstance()->GetRenderer()->GetFrameTrace()->Capture();
+    }
+    LocalFree(argv);
     
     // Main loop
     MSG msg = {};
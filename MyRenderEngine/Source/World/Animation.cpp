@@ -0,0 +1,221 @@
+#include "Animation.h"
+#include "EASTL/algorithm.h"
+#include "EASTL/sort.h"
+#include <float.h>
+
+float4x4 JointTransform::GetMatrix() const
+{
+    float4x4 T = translation_matrix(m_translation);
+    float4x4 R = rotation_matrix(m_rotation);
+    float4x4 S = scaling_matrix(m_scale);
+
+    return mul(T, mul(R, S));
+}
+
+uint32_t Skeleton::AddJoint(const Joint& joint)
+{
+    MY_ASSERT(m_joints.size() < SKELETON_MAX_JOINTS);
+
+    m_joints.push_back(joint);
+    return (uint32_t) m_joints.size() - 1;
+}
+
+void Skeleton::Finalize()
+{
+    uint32_t jointCount = GetJointCount();
+
+    // Skins list their joints in any order, evaluate by depth
+    eastl::vector<uint32_t> depth(jointCount);
+    for (uint32_t i = 0; i < jointCount; ++i)
+    {
+        uint32_t count = 0;
+        for (uint32_t parent = m_joints[i].m_parent; parent != SKELETON_INVALID_JOINT && count <= jointCount; parent = m_joints[parent].m_parent)
+        {
+            ++count;
+        }
+
+        MY_ASSERT(count <= jointCount);     //< Cycle in the hierarchy
+        depth[i] = count;
+    }
+
+    m_evaluationOrder.resize(jointCount);
+    for (uint32_t i = 0; i < jointCount; ++i)
+    {
+        m_evaluationOrder[i] = i;
+    }
+
+    eastl::stable_sort(m_evaluationOrder.begin(), m_evaluationOrder.end(), [&](uint32_t a, uint32_t b) { return depth[a] < depth[b]; });
+}
+
+void Skeleton::GetRestPose(JointTransform* pPose) const
+{
+    for (size_t i = 0; i < m_joints.size(); ++i)
+    {
+        pPose[i] = m_joints[i].m_restPose;
+    }
+}
+
+void Skeleton::ComputeGlobalMatrices(const JointTransform* pPose, float4x4* pGlobal) const
+{
+    MY_ASSERT(m_evaluationOrder.size() == m_joints.size());
+
+    for (size_t i = 0; i < m_evaluationOrder.size(); ++i)
+    {
+        uint32_t joint = m_evaluationOrder[i];
+        uint32_t parent = m_joints[joint].m_parent;
+
+        const float4x4& mtxParent = parent == SKELETON_INVALID_JOINT ? m_joints[joint].m_mtxRootParent : pGlobal[parent];
+        pGlobal[joint] = mul(mtxParent, pPose[joint].GetMatrix());
+    }
+}
+
+void Skeleton::ComputeSkinningPalette(const float4x4* pGlobal, float4x4* pPalette) const
+{
+    for (size_t i = 0; i < m_joints.size(); ++i)
+    {
+        pPalette[i] = mul(pGlobal[i], m_joints[i].m_mtxInverseBind);
+    }
+}
+
+void AnimationClip::AddChannel(const AnimationChannel& channel)
+{
+    MY_ASSERT(!channel.m_times.empty());
+    MY_ASSERT(channel.m_values.size() == channel.m_times.size() * (channel.m_interpolation == AnimationInterpolation::CubicSpline ? 3 : 1));
+
+    m_channels.push_back(channel);
+    m_duration = max(m_duration, channel.m_times.back());
+}
+
+inline float4 SampleChannel(const AnimationChannel& channel, float time)
+{
+    const eastl::vector<float>& times = channel.m_times;
+    uint32_t keyCount = (uint32_t) times.size();
+    bool bCubic = channel.m_interpolation == AnimationInterpolation::CubicSpline;
+
+    auto value = [&](uint32_t key) { return bCubic ? channel.m_values[key * 3 + 1] : channel.m_values[key]; };
+
+    if (keyCount == 1 || time <= times.front())
+    {
+        return value(0);
+    }
+
+    if (time >= times.back())
+    {
+        return value(keyCount - 1);
+    }
+
+    // First key after the time
+    uint32_t next = (uint32_t) (eastl::upper_bound(times.begin(), times.end(), time) - times.begin());
+    uint32_t prev = next - 1;
+
+    float dt = times[next] - times[prev];
+    float t = (time - times[prev]) / dt;
+
+    switch (channel.m_interpolation)
+    {
+        case AnimationInterpolation::Step:
+            return value(prev);
+
+        case AnimationInterpolation::Linear:
+        {
+            if (channel.m_path == AnimationPath::Rotation)
+            {
+                return qslerp(value(prev), value(next), t);
+            }
+            return lerp(value(prev), value(next), t);
+        }
+
+        case AnimationInterpolation::CubicSpline:
+        {
+            // glTF 2.0 spec appendix C, tangents are scaled by the key interval
+            float t2 = t * t;
+            float t3 = t2 * t;
+
+            float4 p0 = value(prev);
+            float4 m0 = channel.m_values[prev * 3 + 2] * dt;
+            float4 p1 = value(next);
+            float4 m1 = channel.m_values[next * 3] * dt;
+
+            float4 result = (2.0f * t3 - 3.0f * t2 + 1.0f) * p0 + (t3 - 2.0f * t2 + t) * m0 + (-2.0f * t3 + 3.0f * t2) * p1 + (t3 - t2) * m1;
+            return channel.m_path == AnimationPath::Rotation ? normalize(result) : result;
+        }
+
+        default:
+            MY_ASSERT(false);
+            return value(prev);
+    }
+}
+
+void AnimationClip::Sample(float time, JointTransform* pPose) const
+{
+    for (size_t i = 0; i < m_channels.size(); ++i)
+    {
+        const AnimationChannel& channel = m_channels[i];
+        float4 value = SampleChannel(channel, time);
+
+        JointTransform& transform = pPose[channel.m_joint];
+        switch (channel.m_path)
+        {
+            case AnimationPath::Translation:
+                transform.m_translation = value.xyz();
+                break;
+            case AnimationPath::Rotation:
+                transform.m_rotation = value;
+                break;
+            case AnimationPath::Scale:
+                transform.m_scale = value.xyz();
+                break;
+            default:
+                MY_ASSERT(false);
+                break;
+        }
+    }
+}
+
+void SkinVertices(const float4x4* pPalette, const SkinnedVertexStreams& input, uint32_t vertexCount,
+    float3* pOutPos, float3* pOutNormal, float4* pOutTangent)
+{
+    for (uint32_t v = 0; v < vertexCount; ++v)
+    {
+        const uint16_t* pJoints = input.m_pJoints + v * SKINNING_MAX_INFLUENCES;
+        float4 weights = input.m_pWeights[v];
+
+        float4x4 mtxSkin = pPalette[pJoints[0]] * weights.x + pPalette[pJoints[1]] * weights.y +
+            pPalette[pJoints[2]] * weights.z + pPalette[pJoints[3]] * weights.w;
+
+        pOutPos[v] = mul(mtxSkin, float4(input.m_pPos[v], 1.0f)).xyz();
+
+        // Palettes without non uniform scale, the normal doesn't need the inverse transpose
+        if (input.m_pNormal && pOutNormal)
+        {
+            pOutNormal[v] = normalize(mul(mtxSkin, float4(input.m_pNormal[v], 0.0f)).xyz());
+        }
+
+        if (input.m_pTangent && pOutTangent)
+        {
+            float4 tangent = input.m_pTangent[v];
+            pOutTangent[v] = float4(normalize(mul(mtxSkin, float4(tangent.xyz(), 0.0f)).xyz()), tangent.w);
+        }
+    }
+}
+
+void ComputeSkinnedMeshletBound(const float3* pPos, const uint32_t* pMeshletVertices, uint32_t vertexCount, float3& center, float& radius)
+{
+    float3 boundsMin = float3(FLT_MAX, FLT_MAX, FLT_MAX);
+    float3 boundsMax = float3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+    for (uint32_t i = 0; i < vertexCount; ++i)
+    {
+        boundsMin = min(boundsMin, pPos[pMeshletVertices[i]]);
+        boundsMax = max(boundsMax, pPos[pMeshletVertices[i]]);
+    }
+
+    center = (boundsMin + boundsMax) * 0.5f;
+
+    float radiusSq = 0.0f;
+    for (uint32_t i = 0; i < vertexCount; ++i)
+    {
+        radiusSq = max(radiusSq, length2(pPos[pMeshletVertices[i]] - center));
+    }
+    radius = sqrt(radiusSq);
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include "Utils/math.h"
+#include "EASTL/vector.h"
+#include "EASTL/string.h"
+
+#define SKELETON_MAX_JOINTS 256             //< Palette entries of a skinned mesh
+#define SKELETON_INVALID_JOINT 0xFFFFFFFF
+#define SKINNING_MAX_INFLUENCES 4           //< Joints per vertex, as JOINTS_0 and WEIGHTS_0 of glTF
+
+struct JointTransform
+{
+    float3 m_translation = {0.0f, 0.0f, 0.0f};
+    quaternion m_rotation = {0.0f, 0.0f, 0.0f, 1.0f};
+    float3 m_scale = {1.0f, 1.0f, 1.0f};
+
+    float4x4 GetMatrix() const;
+};
+
+struct Joint
+{
+    eastl::string m_name;
+    uint32_t m_parent = SKELETON_INVALID_JOINT;
+    float4x4 m_mtxInverseBind = linalg::identity;
+    float4x4 m_mtxRootParent = linalg::identity;    //< Scene transform of the node above a root joint
+    JointTransform m_restPose;
+};
+
+// Joints of a skin, in the order the vertices index them
+class Skeleton
+{
+public:
+    uint32_t AddJoint(const Joint& joint);
+    void Finalize();    //< After all joints are added, sorts the evaluation order so parents come before their children
+
+    uint32_t GetJointCount() const { return (uint32_t) m_joints.size(); }
+    const Joint& GetJoint(uint32_t index) const { return m_joints[index]; }
+
+    void GetRestPose(JointTransform* pPose) const;
+
+    // Scene space matrices of the joints from their local transforms
+    void ComputeGlobalMatrices(const JointTransform* pPose, float4x4* pGlobal) const;
+
+    // Bind pose mesh space to posed mesh space, what the vertices are skinned with
+    void ComputeSkinningPalette(const float4x4* pGlobal, float4x4* pPalette) const;
+
+private:
+    eastl::vector<Joint> m_joints;
+    eastl::vector<uint32_t> m_evaluationOrder;
+};
+
+enum class AnimationPath
+{
+    Translation,
+    Rotation,
+    Scale,
+};
+
+enum class AnimationInterpolation
+{
+    Step,
+    Linear,
+    CubicSpline,
+};
+
+struct AnimationChannel
+{
+    uint32_t m_joint = SKELETON_INVALID_JOINT;
+    AnimationPath m_path = AnimationPath::Translation;
+    AnimationInterpolation m_interpolation = AnimationInterpolation::Linear;
+
+    eastl::vector<float> m_times;
+    eastl::vector<float4> m_values;     //< Cubic spline keys are in tangent, value, out tangent
+};
+
+class AnimationClip
+{
+public:
+    AnimationClip(const eastl::string& name) : m_name(name) {}
+
+    void AddChannel(const AnimationChannel& channel);
+
+    const eastl::string& GetName() const { return m_name; }
+    float GetDuration() const { return m_duration; }
+    uint32_t GetChannelCount() const { return (uint32_t) m_channels.size(); }
+
+    // Overwrites the animated components of the pose, the others keep their values
+    void Sample(float time, JointTransform* pPose) const;
+
+private:
+    eastl::string m_name;
+    eastl::vector<AnimationChannel> m_channels;
+    float m_duration = 0.0f;
+};
+
+struct SkinnedVertexStreams
+{
+    const float3* m_pPos = nullptr;
+    const float3* m_pNormal = nullptr;      //< Optional
+    const float4* m_pTangent = nullptr;     //< Optional
+    const uint16_t* m_pJoints = nullptr;    //< SKINNING_MAX_INFLUENCES per vertex
+    const float4* m_pWeights = nullptr;     //< Sum to 1
+};
+
+// CPU reference of VertexSkining.hlsl, same math in the same order
+void SkinVertices(const float4x4* pPalette, const SkinnedVertexStreams& input, uint32_t vertexCount,
+    float3* pOutPos, float3* pOutNormal, float4* pOutTangent);
+
+// Bounding sphere of a meshlet after skinning, as VertexSkining.hlsl refreshes it
+void ComputeSkinnedMeshletBound(const float3* pPos, const uint32_t* pMeshletVertices, uint32_t vertexCount, float3& center, float& radius);
@@ -5,6 +5,7 @@
 BillboardSpriteRenderer::BillboardSpriteRenderer(Renderer* pRenderer)
 {
     m_pRenderer = pRenderer;
+    m_threadSprites.resize(GetRenderBatchThreadCount());
 
     RHIMeshShaderPipelineDesc desc;
     desc.m_pMS = pRenderer->GetShader("BillboardSprite.hlsl", "ms_main", RHIShaderType::MS);
@@ -43,11 +44,17 @@ void BillboardSpriteRenderer::AddSprite(const float3& position, float size, Text
     sprite.m_texture = pTexture->GetSRV()->GetHeapIndex();
     sprite.m_objectID = objectID;
 
-    m_sprites.push_back(sprite);
+    m_threadSprites[GetRenderBatchThreadIndex()].push_back(sprite);
 }
 
 void BillboardSpriteRenderer::Render()
 {
+    for (size_t i = 0; i < m_threadSprites.size(); ++i)
+    {
+        m_sprites.insert(m_sprites.end(), m_threadSprites[i].begin(), m_threadSprites[i].end());
+        m_threadSprites[i].clear();
+    }
+
     if (m_sprites.empty())
     {
         return;
@@ -7,7 +7,7 @@ public:
     BillboardSpriteRenderer(Renderer* pRenderer);
     ~BillboardSpriteRenderer();
 
-    void AddSprite(const float3& position, float size, Texture2D* pTexture, const float4& color, uint32_t objectID);
+    void AddSprite(const float3& position, float size, Texture2D* pTexture, const float4& color, uint32_t objectID); //< Can be called from worker threads
     void Render();
 private:
     Renderer* m_pRenderer;
@@ -24,5 +24,6 @@ private:
         uint32_t m_objectID;
         float m_distance;
     };
+    eastl::vector<eastl::vector<Sprite>> m_threadSprites;   //< Per task scheduler thread
     eastl::vector<Sprite> m_sprites;
 };
\ No newline at end of file
@@ -0,0 +1,32 @@
+#include "DirectionalLight.h"
+#include "ResourceCache.h"
+#include "Core/Engine.h"
+#include "Utils/guiUtil.h"
+
+bool DirectionalLight::Create()
+{
+    eastl::string assetPath = Engine::GetInstance()->GetAssetPath();
+    m_pIconTexture = ResourceCache::GetInstance()->GetTexture2D(assetPath + "ui/directional_light.png");
+    return true;
+}
+
+void DirectionalLight::Tick(float deltaTime)
+{
+    // Towards the light
+    m_lightDir = normalize(qrot(m_rotation, float3(0.0f, 1.0f, 0.0f)));
+}
+
+void DirectionalLight::OnGUI()
+{
+    IVisibleObject::OnGUI();
+
+    if (ImGui::CollapsingHeader("DirectionalLight"))
+    {
+        ImGui::ColorEdit3("Color##Light", (float*)&m_lightColor, ImGuiColorEditFlags_HDR | ImGuiColorEditFlags_Float);
+        ImGui::SliderFloat("Intensity##Light", &m_lightIntensity, 0.0f, 100.0f);
+    }
+
+    Im3d::PushSize(3.0f);
+    Im3d::DrawArrow(m_pos, m_pos - m_lightDir * 2.0f);
+    Im3d::PopSize();
+}
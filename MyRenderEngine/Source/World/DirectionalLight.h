@@ -0,0 +1,11 @@
+#pragma once
+#include "light.h"
+
+// Sun of the scene, it is lighting from its rotation and casts the clipmap shadows of the renderer when it is the primary light
+class DirectionalLight : public ILight
+{
+public:
+    virtual bool Create() override;
+    virtual void Tick(float deltaTime) override;
+    virtual void OnGUI() override;
+};
@@ -1,30 +1,19 @@
 #include "GLTFLoader.h"
 #include "StaticMesh.h"
+#include "SkeletalMesh.h"
 #include "MeshMaterial.h"
 #include "ResourceCache.h"
 #include "Core/Engine.h"
 #include "Utils/string.h"
 #include "Utils/fmt.h"
-#include "tinyxml2/tinyxml2.h"
+#include "Utils/log.h"
 #include "meshoptimizer/meshoptimizer.h"
 
 #define CGLTF_IMPLEMENTATION
 #include "cgltf/cgltf.h"
 
-inline float3 str_to_float3(const eastl::string& str)
+inline void GetTransform(const cgltf_node* pNode, float3& translation, float4& rotation, float3& scale)
 {
-    eastl::vector<float> v;
-    v.reserve(3);
-    string_to_float_array(str, v);
-    return float3(v[0], v[1], v[2]);
-}
-
-inline void GetTransform(const cgltf_node* pNode, float4x4& matrix)
-{
-    float3 translation;
-    float4 rotation;
-    float3 scale;
-
     if (pNode->has_matrix)
     {
         float4x4 matrix = float4x4(pNode->matrix);
@@ -41,6 +30,14 @@ inline void GetTransform(const cgltf_node* pNode, float4x4& matrix)
     translation.z *= -1;
     rotation.z *= -1;
     rotation.w *= -1;  
+}
+
+inline void GetTransform(const cgltf_node* pNode, float4x4& matrix)
+{
+    float3 translation;
+    float4 rotation;
+    float3 scale;
+    GetTransform(pNode, translation, rotation, scale);
 
     float4x4 T = translation_matrix(translation);
     float4x4 R = rotation_matrix(rotation);
@@ -49,6 +46,34 @@ inline void GetTransform(const cgltf_node* pNode, float4x4& matrix)
     matrix = mul(T, mul(R, S));
 }
 
+// Scene space transform of a node, the transforms of the nodes above it included
+inline float4x4 GetSceneTransform(const cgltf_node* pNode)
+{
+    float4x4 matrix = linalg::identity;
+    for (; pNode != nullptr; pNode = pNode->parent)
+    {
+        float4x4 mtxLocal;
+        GetTransform(pNode, mtxLocal);
+        matrix = mul(mtxLocal, matrix);
+    }
+    return matrix;
+}
+
+// right hand to left hand, mirrors z on both sides of the matrix
+inline float4x4 ConvertMatrixToLH(const float4x4& matrix)
+{
+    float4x4 result = matrix;
+    for (int i = 0; i < 4; ++i)
+    {
+        if (i != 2)
+        {
+            result[2][i] = -result[2][i];
+            result[i][2] = -result[i][2];
+        }
+    }
+    return result;
+}
+
 inline bool IsFrontFaceCCW(const cgltf_node* pNode)
 {
     //gltf 2.0 spec : If the determinant is a positive value, the winding order triangle faces is counterclockwise; in the opposite case, the winding order is clockwise.
@@ -90,39 +115,17 @@ inline uint32_t GetNodeIndex(const cgltf_data* pData, const cgltf_node* pNode)
 GLTFLoader::GLTFLoader(World* pWorld)
 {
     m_pWorld = pWorld;
-
-    float4x4 T = translation_matrix(m_position);
-    float4x4 R = rotation_matrix(m_rotation);
-    float4x4 S = scaling_matrix(m_scale);
-    m_mtxWorld = mul(T, mul(R, S));
 }
 
-void GLTFLoader::LoadSetting(tinyxml2::XMLElement* pElement)
+void GLTFLoader::LoadSetting(const eastl::string& file, const float4x4& mtxWorld)
 {
-    m_file = pElement->FindAttribute("file")->Value();
-
-    const tinyxml2::XMLAttribute* pPositionAttr = pElement->FindAttribute("position");
-    if (pPositionAttr)
-    {
-        m_position = str_to_float3(pPositionAttr->Value());
-    }
-
-    const tinyxml2::XMLAttribute* pRotationAttr = pElement->FindAttribute("rotation");
-    if (pRotationAttr)
-    {
-        m_rotation = rotation_quat(str_to_float3(pRotationAttr->Value()));
-    }
-
-    const tinyxml2::XMLAttribute* pScaleAttr = pElement->FindAttribute("scale");
-    if (pScaleAttr)
-    {
-        m_scale = str_to_float3(pScaleAttr->Value());
-    }
+    m_file = file;
+    m_mtxWorld = mtxWorld;
+}
 
-    float4x4 T = translation_matrix(m_position);
-    float4x4 R = rotation_matrix(m_rotation);
-    float4x4 S = scaling_matrix(m_scale);
-    m_mtxWorld = mul(T, mul(R, S));
+void GLTFLoader::AddInstance(const float4x4& mtxInstance)
+{
+    m_instances.push_back(mtxInstance);
 }
 
 void GLTFLoader::Load(const char* pGLTFFile)
@@ -140,19 +143,24 @@ void GLTFLoader::Load(const char* pGLTFFile)
 
     cgltf_load_buffers(&options, pData, file.c_str());
 
-    // todo: load animation objects
-    if (pData->animations_count)
-    {
-
-    }
+    // Every instance loads the nodes again from the parsed data, m_mtxWorld is the placement being loaded
+    float4x4 mtxModel = m_mtxWorld;
+    uint32_t placementCount = max((uint32_t) m_instances.size(), 1u);
 
-    for (cgltf_size i = 0; i < pData->scenes_count; ++i)
+    for (uint32_t placement = 0; placement < placementCount; ++placement)
     {
-        for (cgltf_size node = 0; node < pData->scenes[i].nodes_count; ++ node)
+        m_mtxWorld = m_instances.empty() ? mtxModel : mul(mtxModel, m_instances[placement]);
+
+        // Animations are loaded with the skins they animate, see LoadSkeletalMesh
+        for (cgltf_size i = 0; i < pData->scenes_count; ++i)
         {
-            LoadStaticMeshNode(pData, pData->scenes[i].nodes[node], m_mtxWorld);
+            for (cgltf_size node = 0; node < pData->scenes[i].nodes_count; ++ node)
+            {
+                LoadStaticMeshNode(pData, pData->scenes[i].nodes[node], m_mtxWorld);
+            }
         }
     }
+    m_mtxWorld = mtxModel;
     
     cgltf_free(pData);
 }
@@ -164,7 +172,26 @@ void GLTFLoader::LoadStaticMeshNode(const cgltf_data* pData, const cgltf_node* p
 
     float4x4 mtxLocalToWorld = mul(mtxParentToWorld, mtxLocalToParent);
 
-    if (pNode->mesh)
+    if (pNode->mesh && pNode->skin)
+    {
+        uint32_t meshIndex = GetMeshIndex(pData, pNode->mesh);
+        bool bFrontFaceCCW = IsFrontFaceCCW(pNode);
+
+        eastl::string skinName = fmt::format("skin_{}_{}", meshIndex, (pNode->mesh->name ? pNode->mesh->name : "")).c_str();
+        SkeletalMesh* pSkeletalMesh = LoadSkeletalMesh(pData, pNode, skinName);
+
+        if (pSkeletalMesh)
+        {
+            for (cgltf_size i = 0; i < pNode->mesh->primitives_count; ++i)
+            {
+                eastl::string name = fmt::format("mesh_{}_{}_{}", meshIndex, i, (pNode->mesh->name ? pNode->mesh->name : "")).c_str();
+
+                StaticMesh* pMesh = LoadStaticMesh(&pNode->mesh->primitives[i], name, bFrontFaceCCW, pSkeletalMesh);
+                pMesh->m_pMaterial->m_bFrontFaceCCW = bFrontFaceCCW;
+            }
+        }
+    }
+    else if (pNode->mesh)
     {
         float3 position;
         float4 rotation;
@@ -313,6 +340,43 @@ MeshMaterial* GLTFLoader::LoadMaterial(const cgltf_material* pGLTFMaterial)
 
     return pMaterial;
 }
+// Joints are converted to uint16 and weights to float whatever the accessor types are, as VertexSkining.hlsl reads them
+meshopt_Stream LoadSkinStream(const cgltf_accessor* pAccessor, bool bJoints, size_t& count)
+{
+    uint32_t stride = bJoints ? sizeof(uint16_t) * SKINNING_MAX_INFLUENCES : sizeof(float4);
+
+    meshopt_Stream stream;
+    stream.data = MY_ALLOC(stride * pAccessor->count);
+    stream.size = stride;
+    stream.stride = stride;
+
+    for (cgltf_size i = 0; i < pAccessor->count; ++i)
+    {
+        if (bJoints)
+        {
+            cgltf_uint joints[SKINNING_MAX_INFLUENCES] = {};
+            cgltf_accessor_read_uint(pAccessor, i, joints, SKINNING_MAX_INFLUENCES);
+
+            uint16_t* pJoints = (uint16_t*) stream.data + i * SKINNING_MAX_INFLUENCES;
+            for (uint32_t k = 0; k < SKINNING_MAX_INFLUENCES; ++k)
+            {
+                pJoints[k] = (uint16_t) joints[k];
+            }
+        }
+        else
+        {
+            float4 weights = float4(0.0f, 0.0f, 0.0f, 0.0f);
+            cgltf_accessor_read_float(pAccessor, i, &weights.x, SKINNING_MAX_INFLUENCES);
+
+            float sum = weights.x + weights.y + weights.z + weights.w;
+            ((float4*) stream.data)[i] = sum > 0.0f ? weights / sum : float4(1.0f, 0.0f, 0.0f, 0.0f);
+        }
+    }
+
+    count = pAccessor->count;
+    return stream;
+}
+
 meshopt_Stream LoadBufferStream(const cgltf_accessor* pAccessor, bool convertToLH, size_t& count)
 {
     uint32_t stride = (uint32_t) pAccessor->stride;
@@ -338,7 +402,203 @@ meshopt_Stream LoadBufferStream(const cgltf_accessor* pAccessor, bool convertToL
     return stream;
 }
 
-StaticMesh* GLTFLoader::LoadStaticMesh(const cgltf_primitive* pPrimitive, const eastl::string& name, bool bFrontFaceCCW)
+// Simplified to at most OCCLUSION_OCCLUDER_MAX_TRIANGLES, the simplifier only collapses to existing vertices so the proxy stays in the bounds of the mesh
+void LoadOccluder(OccluderMesh& occluder, const void* pIndices, size_t indexStride, size_t indexCount, const float* pPositions, size_t vertexCount, size_t positionStride)
+{
+    eastl::vector<unsigned int> indices(indexCount);
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        switch (indexStride)
+        {
+            case 4:
+                indices[i] = ((const uint32_t*) pIndices)[i];
+                break;
+            case 2:
+                indices[i] = ((const uint16_t*) pIndices)[i];
+                break;
+            default:
+                indices[i] = ((const uint8_t*) pIndices)[i];
+                break;
+        }
+    }
+
+    const size_t targetIndexCount = OCCLUSION_OCCLUDER_MAX_TRIANGLES * 3;
+    const float targetError = 0.01f;    //< Relative to the extents of the mesh
+
+    if (indexCount > targetIndexCount)
+    {
+        eastl::vector<unsigned int> simplifiedIndices(indexCount);
+        size_t simplifiedIndexCount = meshopt_simplify(simplifiedIndices.data(), indices.data(), indexCount, pPositions, vertexCount, positionStride, targetIndexCount, targetError);
+        if (simplifiedIndexCount > targetIndexCount)
+        {
+            return;
+        }
+
+        simplifiedIndices.resize(simplifiedIndexCount);
+        indices.swap(simplifiedIndices);
+    }
+
+    eastl::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+    occluder.m_indices.reserve(indices.size());
+
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        uint32_t vertex = indices[i];
+        if (remap[vertex] == UINT32_MAX)
+        {
+            remap[vertex] = (uint32_t) occluder.m_vertices.size();
+            occluder.m_vertices.push_back(*(const float3*) ((const char*) pPositions + positionStride * vertex));
+        }
+        occluder.m_indices.push_back((uint16_t) remap[vertex]);
+    }
+}
+
+SkeletalMesh* GLTFLoader::LoadSkeletalMesh(const cgltf_data* pData, const cgltf_node* pNode, const eastl::string& name)
+{
+    const cgltf_skin* pSkin = pNode->skin;
+    if (pSkin->joints_count == 0 || pSkin->joints_count > SKELETON_MAX_JOINTS)
+    {
+        MY_ERROR("[GLTFLoader] {} {} : unsupported joint count {}", m_file, name, pSkin->joints_count);
+        return nullptr;
+    }
+
+    auto findJoint = [&](const cgltf_node* pJointNode)
+    {
+        for (cgltf_size i = 0; i < pSkin->joints_count; ++i)
+        {
+            if (pSkin->joints[i] == pJointNode)
+            {
+                return (uint32_t) i;
+            }
+        }
+        return (uint32_t) SKELETON_INVALID_JOINT;
+    };
+
+    SkeletalMesh* pSkeletalMesh = new SkeletalMesh(m_file + " " + name);
+    pSkeletalMesh->m_pRenderer = Engine::GetInstance()->GetRenderer();
+
+    for (cgltf_size i = 0; i < pSkin->joints_count; ++i)
+    {
+        const cgltf_node* pJointNode = pSkin->joints[i];
+
+        Joint joint;
+        joint.m_name = pJointNode->name ? pJointNode->name : "";
+        joint.m_parent = pJointNode->parent ? findJoint(pJointNode->parent) : SKELETON_INVALID_JOINT;
+        if (joint.m_parent == SKELETON_INVALID_JOINT && pJointNode->parent)
+        {
+            joint.m_mtxRootParent = GetSceneTransform(pJointNode->parent);
+        }
+
+        GetTransform(pJointNode, joint.m_restPose.m_translation, joint.m_restPose.m_rotation, joint.m_restPose.m_scale);
+
+        if (pSkin->inverse_bind_matrices)
+        {
+            float matrix[16];
+            cgltf_accessor_read_float(pSkin->inverse_bind_matrices, i, matrix, 16);
+            joint.m_mtxInverseBind = ConvertMatrixToLH(float4x4(matrix));
+        }
+
+        pSkeletalMesh->m_skeleton.AddJoint(joint);
+    }
+
+    for (cgltf_size i = 0; i < pData->animations_count; ++i)
+    {
+        const cgltf_animation& animation = pData->animations[i];
+        AnimationClip clip(animation.name ? animation.name : fmt::format("animation_{}", i).c_str());
+
+        for (cgltf_size c = 0; c < animation.channels_count; ++c)
+        {
+            const cgltf_animation_channel& gltfChannel = animation.channels[c];
+            const cgltf_animation_sampler* pSampler = gltfChannel.sampler;
+
+            // Nodes outside of the skin and morph target weights are not animated
+            AnimationChannel channel;
+            channel.m_joint = findJoint(gltfChannel.target_node);
+            if (channel.m_joint == SKELETON_INVALID_JOINT || pSampler == nullptr)
+            {
+                continue;
+            }
+
+            switch (gltfChannel.target_path)
+            {
+                case cgltf_animation_path_type_translation:
+                    channel.m_path = AnimationPath::Translation;
+                    break;
+                case cgltf_animation_path_type_rotation:
+                    channel.m_path = AnimationPath::Rotation;
+                    break;
+                case cgltf_animation_path_type_scale:
+                    channel.m_path = AnimationPath::Scale;
+                    break;
+                default:
+                    continue;
+            }
+
+            switch (pSampler->interpolation)
+            {
+                case cgltf_interpolation_type_step:
+                    channel.m_interpolation = AnimationInterpolation::Step;
+                    break;
+                case cgltf_interpolation_type_cubic_spline:
+                    channel.m_interpolation = AnimationInterpolation::CubicSpline;
+                    break;
+                default:
+                    channel.m_interpolation = AnimationInterpolation::Linear;
+                    break;
+            }
+
+            channel.m_times.resize(pSampler->input->count);
+            for (cgltf_size k = 0; k < pSampler->input->count; ++k)
+            {
+                cgltf_accessor_read_float(pSampler->input, k, &channel.m_times[k], 1);
+            }
+
+            // right hand to left hand, as GetTransform, cubic spline tangents are converted the same way
+            cgltf_size componentCount = channel.m_path == AnimationPath::Rotation ? 4 : 3;
+            channel.m_values.resize(pSampler->output->count);
+            for (cgltf_size k = 0; k < pSampler->output->count; ++k)
+            {
+                float4 value = float4(0.0f, 0.0f, 0.0f, 0.0f);
+                cgltf_accessor_read_float(pSampler->output, k, &value.x, componentCount);
+
+                if (channel.m_path == AnimationPath::Translation)
+                {
+                    value.z *= -1;
+                }
+                else if (channel.m_path == AnimationPath::Rotation)
+                {
+                    value.z *= -1;
+                    value.w *= -1;
+                }
+                channel.m_values[k] = value;
+            }
+
+            clip.AddChannel(channel);
+        }
+
+        if (clip.GetChannelCount() > 0)
+        {
+            pSkeletalMesh->m_clips.push_back(clip);
+        }
+    }
+
+    // Skinned vertices are placed by the joints, the transform of the mesh node is ignored as the glTF spec requires
+    float3 position;
+    float4 rotation;
+    float3 scale;
+    decompose(m_mtxWorld, position, rotation, scale);
+
+    pSkeletalMesh->SetPosition(position);
+    pSkeletalMesh->SetRotation(rotation);
+    pSkeletalMesh->SetScale(scale);
+
+    pSkeletalMesh->Create();
+    m_pWorld->AddObject(pSkeletalMesh);
+
+    return pSkeletalMesh;
+}
+
+StaticMesh* GLTFLoader::LoadStaticMesh(const cgltf_primitive* pPrimitive, const eastl::string& name, bool bFrontFaceCCW, SkeletalMesh* pSkeletalMesh)
 {
     StaticMesh* pMesh = new StaticMesh(m_file + " " + name);
     pMesh->m_pMaterial.reset(LoadMaterial(pPrimitive->material));
@@ -397,6 +657,17 @@ StaticMesh* GLTFLoader::LoadStaticMesh(const cgltf_primitive* pPrimitive, const
                 vertexTypes.push_back(pPrimitive->attributes[i].type);
                 break;
             }
+
+            case cgltf_attribute_type_joints:
+            case cgltf_attribute_type_weights:
+            {
+                if (pSkeletalMesh && pPrimitive->attributes[i].index == 0)     //< Only support 4 influences
+                {
+                    vertexStreams.push_back(LoadSkinStream(pPrimitive->attributes[i].data, pPrimitive->attributes[i].type == cgltf_attribute_type_joints, vertexCount));
+                    vertexTypes.push_back(pPrimitive->attributes[i].type);
+                }
+                break;
+            }
         }
     }
 
@@ -430,6 +701,8 @@ StaticMesh* GLTFLoader::LoadStaticMesh(const cgltf_primitive* pPrimitive, const
 
     void* pPosVertices = nullptr;
     size_t posStride = 0;
+    const uint16_t* pJointVertices = nullptr;
+    const float4* pWeightVertices = nullptr;
 
     for (size_t i = 0; i < vertexStreams.size(); ++i)
     {
@@ -443,6 +716,66 @@ StaticMesh* GLTFLoader::LoadStaticMesh(const cgltf_primitive* pPrimitive, const
             pPosVertices = pVertices;
             posStride = vertexStreams[i].stride;
         }
+        else if (vertexTypes[i] == cgltf_attribute_type_joints)
+        {
+            pJointVertices = (const uint16_t*) pVertices;
+        }
+        else if (vertexTypes[i] == cgltf_attribute_type_weights)
+        {
+            pWeightVertices = (const float4*) pVertices;
+        }
+    }
+
+    if (pSkeletalMesh)
+    {
+        MY_ASSERT(pJointVertices != nullptr && pWeightVertices != nullptr);
+
+        // Bind pose spheres of the vertices each joint moves, the palette poses them for the bounds of the skinned mesh
+        uint32_t jointCount = pSkeletalMesh->GetSkeleton().GetJointCount();
+        eastl::vector<float3> jointMin(jointCount, float3(FLT_MAX, FLT_MAX, FLT_MAX));
+        eastl::vector<float3> jointMax(jointCount, float3(-FLT_MAX, -FLT_MAX, -FLT_MAX));
+
+        auto forEachInfluence = [&](auto fun)
+        {
+            for (size_t v = 0; v < remappedVertexCount; ++v)
+            {
+                const float3& pos = *(const float3*) ((const char*) pPosVertices + posStride * v);
+                for (uint32_t k = 0; k < SKINNING_MAX_INFLUENCES; ++k)
+                {
+                    uint32_t joint = pJointVertices[v * SKINNING_MAX_INFLUENCES + k];
+                    if (pWeightVertices[v][k] > 0.0f && joint < jointCount)
+                    {
+                        fun(joint, pos);
+                    }
+                }
+            }
+        };
+
+        forEachInfluence([&](uint32_t joint, const float3& pos)
+            {
+                jointMin[joint] = min(jointMin[joint], pos);
+                jointMax[joint] = max(jointMax[joint], pos);
+            });
+
+        pMesh->m_jointBounds.resize(jointCount, float4(0.0f, 0.0f, 0.0f, -1.0f));
+        for (uint32_t i = 0; i < jointCount; ++i)
+        {
+            if (jointMin[i].x <= jointMax[i].x)
+            {
+                pMesh->m_jointBounds[i] = float4((jointMin[i] + jointMax[i]) * 0.5f, 0.0f);
+            }
+        }
+
+        forEachInfluence([&](uint32_t joint, const float3& pos)
+            {
+                float4& bounds = pMesh->m_jointBounds[joint];
+                bounds.w = max(bounds.w, length(pos - bounds.xyz()));
+            });
+    }
+
+    if (pSkeletalMesh == nullptr && !pMesh->m_pMaterial->IsAlphaTest() && !pMesh->m_pMaterial->IsAlphaBlend())
+    {
+        LoadOccluder(pMesh->m_occluder, remappedIndices, indices.stride, indexCount, (const float*) pPosVertices, remappedVertexCount, posStride);
     }
 
     size_t maxVertices = 64;
@@ -590,6 +923,14 @@ StaticMesh* GLTFLoader::LoadStaticMesh(const cgltf_primitive* pPrimitive, const
             case cgltf_attribute_type_tangent:
                 pMesh->m_tangentBuffer = pCache->GetSceneBuffer("model(" + m_file + " " + name + ") Tangent", remappedVertices[i], (uint32_t) vertexStreams[i].stride * (uint32_t) remappedVertexCount);
                 break;
+
+            case cgltf_attribute_type_joints:
+                pMesh->m_jointBuffer = pCache->GetSceneBuffer("model(" + m_file + " " + name + ") Joints", remappedVertices[i], (uint32_t) vertexStreams[i].stride * (uint32_t) remappedVertexCount);
+                break;
+
+            case cgltf_attribute_type_weights:
+                pMesh->m_weightBuffer = pCache->GetSceneBuffer("model(" + m_file + " " + name + ") Weights", remappedVertices[i], (uint32_t) vertexStreams[i].stride * (uint32_t) remappedVertexCount);
+                break;
             default:
                 MY_ASSERT(false);
                 break;
@@ -601,8 +942,20 @@ StaticMesh* GLTFLoader::LoadStaticMesh(const cgltf_primitive* pPrimitive, const
     pMesh->m_meshletVerticesBuffer = pCache->GetSceneBuffer("model(" + m_file + " " + name + ") Meshlet Vertices", meshletVertices.data(), sizeof(unsigned int) * (uint32_t) meshletVertices.size());
     pMesh->m_meshletIndicesBuffer = pCache->GetSceneBuffer("model(" + m_file + " " + name + ") Meshlet Indices", meshletTriangles16.data(), sizeof(unsigned short) * (uint32_t) meshletTriangles16.size());
 
+    if (pSkeletalMesh)
+    {
+        pMesh->m_pSkeletalMesh = pSkeletalMesh;
+        pMesh->m_pMaterial->m_bSkeletalAnim = true;
+        pSkeletalMesh->m_primitives.push_back(pMesh);
+    }
+
     pMesh->Create();
-    m_pWorld->AddObject(pMesh);
+    m_pWorld->AddObject(pMesh, pSkeletalMesh);
+
+    if (pSkeletalMesh)
+    {
+        pMesh->UpdateSkinnedBounds(pSkeletalMesh->GetPalette());
+    }
 
     MY_FREE((void*) indices.data);
     for (size_t i = 0; i < vertexStreams.size(); ++i)
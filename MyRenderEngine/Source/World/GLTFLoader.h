@@ -1,9 +1,11 @@
 #pragma once
 #include "Utils/math.h"
 #include "EASTL/string.h"
+#include "EASTL/vector.h"
 
 class World;
 class StaticMesh;
+class SkeletalMesh;
 class MeshMaterial;
 class Texture2D;
 
@@ -15,22 +17,19 @@ struct cgltf_texture_view;
 struct cgltf_animation;
 struct cgltf_skin;
 
-namespace tinyxml2
-{
-    class XMLElement;
-}
-
 class GLTFLoader
 {
 public:
     GLTFLoader(World* pWorld);
     
-    void LoadSetting(tinyxml2::XMLElement* pElement);
+    void LoadSetting(const eastl::string& file, const float4x4& mtxWorld);
+    void AddInstance(const float4x4& mtxInstance);      //< Relative to the transform of the setting, the file is parsed once for all of them
     void Load(const char* file = nullptr);
 
 private:
     void LoadStaticMeshNode(const cgltf_data* pData, const cgltf_node* pNode, const float4x4& mtxPresentWorld);
-    StaticMesh* LoadStaticMesh(const cgltf_primitive* pPrimitive, const eastl::string& name, bool bFrontFaceCCW);
+    StaticMesh* LoadStaticMesh(const cgltf_primitive* pPrimitive, const eastl::string& name, bool bFrontFaceCCW, SkeletalMesh* pSkeletalMesh = nullptr);
+    SkeletalMesh* LoadSkeletalMesh(const cgltf_data* pData, const cgltf_node* pNode, const eastl::string& name);   //< Skeleton and the clips animating it
 
     MeshMaterial* LoadMaterial(const cgltf_material* pMaterial);
     Texture2D* LoadTexture(const cgltf_texture_view& textureView, bool srgb);
@@ -39,8 +38,6 @@ private:
     World* m_pWorld = nullptr;
     eastl::string m_file;
     
-    float3 m_position = float3(0.0f, 0.0f, 0.0f);
-    quaternion m_rotation = quaternion(0.0f, 0.0f, 0.0f, 1.0f);
-    float3 m_scale = float3(1.0f, 1.0f, 1.0f);
-    float4x4 m_mtxWorld;
+    float4x4 m_mtxWorld = linalg::identity;     //< Of the placement being loaded
+    eastl::vector<float4x4> m_instances;
 };
\ No newline at end of file
@@ -19,6 +19,11 @@ MeshMaterial::~MeshMaterial()
     pCache->ReleaseTexture2D(m_pClearCoatTexture);
     pCache->ReleaseTexture2D(m_pClearCoatNormalTexture);
     pCache->ReleaseTexture2D(m_pClearCoatRoughnessTexture);
+
+    if (m_materialIndex != MATERIAL_TABLE_INVALID_INDEX)
+    {
+        Engine::GetInstance()->GetRenderer()->ReleaseMaterial(m_materialIndex);
+    }
 }
 
 IRHIPipelineState* MeshMaterial::GetPSO()
@@ -54,12 +59,14 @@ IRHIPipelineState* MeshMaterial::GetPSO()
 
 IRHIPipelineState* MeshMaterial::GetMeshletGPUDrivenPSO()
 {
-    if (m_pMeshletPSO == nullptr)
-    {
-        Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+    Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+    bool bUberMaterial = pRenderer->IsUberMaterialEnabled();
 
+    IRHIPipelineState*& pPSO = bUberMaterial ? m_pUberMeshletPSO : m_pMeshletPSO;
+    if (pPSO == nullptr)
+    {
         eastl::vector<eastl::string> defines;
-        AddMaterialDefines(defines);
+        AddMaterialDefines(defines, bUberMaterial);
 
         RHIMeshShaderPipelineDesc psoDesc;
         psoDesc.m_pAS = pRenderer->GetShader("MeshletCulling.hlsl", "as_main", RHIShaderType::AS, defines);
@@ -76,20 +83,22 @@ IRHIPipelineState* MeshMaterial::GetMeshletGPUDrivenPSO()
         psoDesc.m_rtFormat[4] = RHIFormat::RGBA8UNORM;
         psoDesc.m_depthStencilFromat = RHIFormat::D32F;
 
-        m_pMeshletPSO = pRenderer->GetPipelineState(psoDesc, "Model meshlet PSO");
+        pPSO = pRenderer->GetPipelineState(psoDesc, bUberMaterial ? "Model meshlet uber PSO" : "Model meshlet PSO");
     }
 
-    return m_pMeshletPSO;
+    return pPSO;
 }
 
 IRHIPipelineState* MeshMaterial::GetShowCulledMeshletGPUDrivenPSO()
 {
-    if (m_pShowCulledMeshletGPUDrivenPSO == nullptr)
-    {
-        Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+    Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+    bool bUberMaterial = pRenderer->IsUberMaterialEnabled();
 
+    IRHIPipelineState*& pPSO = bUberMaterial ? m_pUberShowCulledMeshletGPUDrivenPSO : m_pShowCulledMeshletGPUDrivenPSO;
+    if (pPSO == nullptr)
+    {
         eastl::vector<eastl::string> defines;
-        AddMaterialDefines(defines);
+        AddMaterialDefines(defines, bUberMaterial);
 
         RHIMeshShaderPipelineDesc psoDesc;
         psoDesc.m_pAS = pRenderer->GetShader("ModelShowCulledInstance.hlsl", "as_main", RHIShaderType::AS, defines);
@@ -106,10 +115,38 @@ IRHIPipelineState* MeshMaterial::GetShowCulledMeshletGPUDrivenPSO()
         psoDesc.m_rtFormat[4] = RHIFormat::RGBA8UNORM;
         psoDesc.m_depthStencilFromat = RHIFormat::D32F;
 
-        m_pShowCulledMeshletGPUDrivenPSO = pRenderer->GetPipelineState(psoDesc, "Show Culled Meshlet PSO");
+        pPSO = pRenderer->GetPipelineState(psoDesc, bUberMaterial ? "Show Culled Meshlet uber PSO" : "Show Culled Meshlet PSO");
     }
 
-    return m_pShowCulledMeshletGPUDrivenPSO;
+    return pPSO;
+}
+
+IRHIPipelineState* MeshMaterial::GetVisibilityBufferPSO()
+{
+    if (m_pVisibilityBufferPSO == nullptr)
+    {
+        Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+
+        // Materials are evaluated by the resolve, so the raster PSO is always the uber one
+        eastl::vector<eastl::string> defines;
+        AddMaterialDefines(defines, true);
+        defines.push_back("VISIBILITY_BUFFER=1");
+
+        RHIMeshShaderPipelineDesc psoDesc;
+        psoDesc.m_pAS = pRenderer->GetShader("MeshletCulling.hlsl", "as_main", RHIShaderType::AS, defines);
+        psoDesc.m_pMS = pRenderer->GetShader("VisibilityBuffer.hlsl", "ms_main", RHIShaderType::MS, defines);
+        psoDesc.m_pPS = pRenderer->GetShader("VisibilityBuffer.hlsl", "ps_main", RHIShaderType::PS, defines);
+        psoDesc.m_rasterizerState.m_cullMode = m_bDoubleSided ? RHICullMode::None : RHICullMode::Back;
+        psoDesc.m_rasterizerState.m_frontCCW = m_bFrontFaceCCW;
+        psoDesc.m_depthStencilState.m_depthTest = true;
+        psoDesc.m_depthStencilState.m_depthFunc = RHICompareFunc::GreaterEqual;
+        psoDesc.m_rtFormat[0] = RHIFormat::RG32UI;
+        psoDesc.m_depthStencilFromat = RHIFormat::D32F;
+
+        m_pVisibilityBufferPSO = pRenderer->GetPipelineState(psoDesc, "Model visibility buffer PSO");
+    }
+
+    return m_pVisibilityBufferPSO;
 }
 
 
@@ -145,41 +182,41 @@ IRHIPipelineState* MeshMaterial::GetMeshletPSO()
 
 IRHIPipelineState* MeshMaterial::GetShadowPSO()
 {
-    if (m_pShadowPSO == nullptr)
-    {
-        Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+    Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+    bool bUberMaterial = pRenderer->IsUberMaterialEnabled();
 
+    IRHIPipelineState*& pPSO = bUberMaterial ? m_pUberShadowPSO : m_pShadowPSO;
+    if (pPSO == nullptr)
+    {
         eastl::vector<eastl::string> defines;
-        defines.push_back("UNIFORM_RESOURCE=1");
-
-        if(m_pAlbedoTexture) defines.push_back("ALBEDO_TEXTURE=1");
-        if(m_pDiffuseTexture) defines.push_back("DIFFUSE_TEXTURE=1");
-        if(m_bAlphaTest) defines.push_back("ALPHA_TEST=1");
+        AddMaterialDefines(defines, bUberMaterial);
 
-        RHIGraphicsPipelineDesc psoDesc;
-        psoDesc.m_pVS = pRenderer->GetShader("ModelShadow.hlsl", "vs_main", RHIShaderType::VS, defines);
-        if (m_pAlbedoTexture && m_bAlphaTest)
+        // Depth only, rendered into the pages of the virtual shadow map
+        RHIMeshShaderPipelineDesc psoDesc;
+        psoDesc.m_pAS = pRenderer->GetShader("ModelShadow.hlsl", "as_main", RHIShaderType::AS, defines);
+        psoDesc.m_pMS = pRenderer->GetShader("ModelShadow.hlsl", "ms_main", RHIShaderType::MS, defines);
+        if (m_bAlphaTest)
         {
             psoDesc.m_pPS = pRenderer->GetShader("ModelShadow.hlsl", "ps_main", RHIShaderType::PS, defines);
         }
 
         psoDesc.m_rasterizerState.m_cullMode = m_bDoubleSided ? RHICullMode::None : RHICullMode::Back;
         psoDesc.m_rasterizerState.m_frontCCW = m_bFrontFaceCCW;
-        psoDesc.m_rasterizerState.m_depthBias = 5.0f;
-        psoDesc.m_rasterizerState.m_depthSlopeScale = 1.0f;
+        psoDesc.m_rasterizerState.m_depthBias = -5.0f;          //< Reversed depth, biased away from the light
+        psoDesc.m_rasterizerState.m_depthSlopeScale = -1.0f;
         psoDesc.m_depthStencilState.m_depthTest = true;
         psoDesc.m_depthStencilState.m_depthFunc = RHICompareFunc::GreaterEqual;
-        psoDesc.m_depthStencilFromat = RHIFormat::D16;
+        psoDesc.m_depthStencilFromat = RHIFormat::D32F;
 
-        m_pShadowPSO = pRenderer->GetPipelineState(psoDesc, "Model shadoe PSO");       
+        pPSO = pRenderer->GetPipelineState(psoDesc, bUberMaterial ? "Model shadow uber PSO" : "Model shadow PSO");
     }
 
-    return m_pShadowPSO;
+    return pPSO;
 }
 
 IRHIPipelineState* MeshMaterial::GetVelocityPSO()
 {
-    if (m_pVelocityPSO = nullptr)
+    if (m_pVelocityPSO == nullptr)
     {
         Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
 
@@ -304,6 +341,9 @@ void MeshMaterial::UpdateConstants()
     m_materialCB.m_bRGNormalTexture = m_pNormalTexture && (m_pNormalTexture->GetTexture()->GetDesc().m_format == RHIFormat::BC5UNORM);
     m_materialCB.m_bRGClearCoatNormalTexture = m_pClearCoatNormalTexture && (m_pClearCoatNormalTexture->GetTexture()->GetDesc().m_format == RHIFormat::BC5UNORM);
     m_materialCB.m_bDoubleSided = m_bDoubleSided;
+    m_materialCB.m_bFrontFaceCCW = m_bFrontFaceCCW;
+
+    m_materialIndex = Engine::GetInstance()->GetRenderer()->UpdateMaterial(m_materialIndex, m_materialCB);
 }
 
 void MeshMaterial::OnGUI()
@@ -312,40 +352,42 @@ void MeshMaterial::OnGUI()
     {
         bool resetPSO = ImGui::Combo("Shading Model##Material", (int*)&m_shadingModel, "Default\0Anisotropy\0Sheen\0ClearCoat\0Hair\0\0", (int)ShadingModel::Max);
 
+        bool bChanged = resetPSO;
+
         // todo: material textures
         
         if (m_bPBRMetallicRoughness)
         {
-            ImGui::ColorEdit3("Albedo##Material", (float*)&m_albedoColor);
-            ImGui::SliderFloat("Metallic##Material", &m_metallic, 0.0f, 1.0f);
-            ImGui::SliderFloat("Roughness##Material", &m_roughness, 0.0f, 1.0f);
+            bChanged |= ImGui::ColorEdit3("Albedo##Material", (float*)&m_albedoColor);
+            bChanged |= ImGui::SliderFloat("Metallic##Material", &m_metallic, 0.0f, 1.0f);
+            bChanged |= ImGui::SliderFloat("Roughness##Material", &m_roughness, 0.0f, 1.0f);
         }
         else if (m_bPBRSpecularGlossiness)
         {
-            ImGui::ColorEdit3("Diffuse##Material", (float*)&m_diffuseColor);
-            ImGui::ColorEdit3("Specular(F0)##Material", (float*)&m_specularColor);
-            ImGui::SliderFloat("Glossness##Material", &m_glossiness, 0.0f, 1.0f);
+            bChanged |= ImGui::ColorEdit3("Diffuse##Material", (float*)&m_diffuseColor);
+            bChanged |= ImGui::ColorEdit3("Specular(F0)##Material", (float*)&m_specularColor);
+            bChanged |= ImGui::SliderFloat("Glossness##Material", &m_glossiness, 0.0f, 1.0f);
         }
 
         if (m_bAlphaTest)
         {
-            ImGui::SliderFloat("Alpha Cutoff##Material", &m_alphaCutoff, 0.0f, 1.0f);
+            bChanged |= ImGui::SliderFloat("Alpha Cutoff##Material", &m_alphaCutoff, 0.0f, 1.0f);
         }
 
-        ImGui::ColorEdit3("Emissive##Material", (float*)&m_emissiveColor);
+        bChanged |= ImGui::ColorEdit3("Emissive##Material", (float*)&m_emissiveColor);
 
         switch (m_shadingModel)
         {
             case ShadingModel::Anisotropy:
-                ImGui::SliderFloat("Anisotropy##Material", &m_anisotropy, -1.0f, 1.0f);
+                bChanged |= ImGui::SliderFloat("Anisotropy##Material", &m_anisotropy, -1.0f, 1.0f);
                 break;
             case ShadingModel::Sheen:
-                ImGui::ColorEdit3("Sheen Color#Material", (float*)&m_sheenColor);
-                ImGui::SliderFloat("Sheen Roughness#Material", &m_sheenRoughness, 0.0f, 1.0f);
+                bChanged |= ImGui::ColorEdit3("Sheen Color#Material", (float*)&m_sheenColor);
+                bChanged |= ImGui::SliderFloat("Sheen Roughness#Material", &m_sheenRoughness, 0.0f, 1.0f);
                 break;
             case ShadingModel::ClearCoat:
-                ImGui::SliderFloat("ClearCoat##Material", &m_clearCoat, 0.0f, 1.0f);
-                ImGui::SliderFloat("ClearCoat Roughness##Material", &m_clearCoatRoughness, 0.0f, 1.0f);
+                bChanged |= ImGui::SliderFloat("ClearCoat##Material", &m_clearCoat, 0.0f, 1.0f);
+                bChanged |= ImGui::SliderFloat("ClearCoat Roughness##Material", &m_clearCoatRoughness, 0.0f, 1.0f);
                 break;
             default:
                 break;
@@ -356,11 +398,26 @@ void MeshMaterial::OnGUI()
             m_pPSO = nullptr;
             m_pMeshletPSO = nullptr;
         }
+
+        if (bChanged)
+        {
+            UpdateConstants();
+        }
     };
 }
 
-void MeshMaterial::AddMaterialDefines(eastl::vector<eastl::string>& defines)
+void MeshMaterial::AddMaterialDefines(eastl::vector<eastl::string>& defines, bool bUberMaterial)
 {
+    if (bUberMaterial)
+    {
+        // Texture presence and the PBR model are read from the material table, only the defines changing the PSO states
+        // or the culling are kept, so all materials with the same raster states share one PSO
+        defines.push_back("UBER_MATERIAL=1");
+        if(m_bAlphaTest) defines.push_back("ALPHA_TEST=1");
+        if(m_bDoubleSided) defines.push_back("DOUBLE_SIDED=1");
+        return;
+    }
+
     switch (m_shadingModel)
     {
         case ShadingModel::Anisotropy:
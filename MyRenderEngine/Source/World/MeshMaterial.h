@@ -18,11 +18,13 @@ public:
     IRHIPipelineState* GetOutlinePSO();
     IRHIPipelineState* GetMeshletGPUDrivenPSO();
     IRHIPipelineState* GetShowCulledMeshletGPUDrivenPSO();
+    IRHIPipelineState* GetVisibilityBufferPSO();
     IRHIPipelineState* GetMeshletPSO();
     IRHIPipelineState* GetVertexSkinningPSO();
 
-    void UpdateConstants();
+    void UpdateConstants();     //< After the material is changed, uploads the constants to the material table if they are new
     const ModelMaterialConstant* GetConstants() const { return &m_materialCB; }
+    uint32_t GetMaterialIndex() const { return m_materialIndex; }
     void OnGUI();
 
     bool IsFrontFaceCCW() const { return m_bFrontFaceCCW; }
@@ -31,11 +33,12 @@ public:
     bool IsVertexSkinned() const { return m_bSkeletalAnim; } 
 
 private:
-    void AddMaterialDefines(eastl::vector<eastl::string>& defines);
+    void AddMaterialDefines(eastl::vector<eastl::string>& defines, bool bUberMaterial = false);
 
 private:
     eastl::string m_name;
     ModelMaterialConstant m_materialCB = {};
+    uint32_t m_materialIndex = MATERIAL_TABLE_INVALID_INDEX;
     
     IRHIPipelineState* m_pPSO = nullptr;
     IRHIPipelineState* m_pShadowPSO = nullptr;
@@ -47,6 +50,12 @@ private:
     IRHIPipelineState* m_pMeshletDirectPSO = nullptr;
     IRHIPipelineState* m_pVertexSkinningPSO = nullptr;
 
+    // Shared by every material with the same raster states, see Renderer::IsUberMaterialEnabled
+    IRHIPipelineState* m_pUberMeshletPSO = nullptr;
+    IRHIPipelineState* m_pUberShowCulledMeshletGPUDrivenPSO = nullptr;
+    IRHIPipelineState* m_pUberShadowPSO = nullptr;
+    IRHIPipelineState* m_pVisibilityBufferPSO = nullptr;
+
     ShadingModel m_shadingModel = ShadingModel::Default;
 
     // PBR specular glossiness
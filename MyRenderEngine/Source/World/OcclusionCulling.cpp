@@ -0,0 +1,573 @@
+#include "OcclusionCulling.h"
+#include "Utils/parallel_for.h"
+#include <float.h>
+
+// Subtiles of a SIMD iteration, the rows of subtiles are a multiple of them.
+// No FMA and the same operation order as the scalar version, so both produce identical results
+#if MATH_SIMD_AVX2
+    #define OCCLUSION_SIMD_LANES 8
+
+    typedef __m256 SimdFloat;
+    typedef __m256i SimdInt;
+
+    inline SimdFloat SimdSet(float value) { return _mm256_set1_ps(value); }
+    inline SimdInt SimdSetInt(uint32_t value) { return _mm256_set1_epi32((int) value); }
+    inline SimdFloat SimdLoad(const float* p) { return _mm256_loadu_ps(p); }
+    inline SimdInt SimdLoadInt(const uint32_t* p) { return _mm256_loadu_si256((const __m256i*) p); }
+    inline void SimdStore(float* p, SimdFloat value) { _mm256_storeu_ps(p, value); }
+    inline void SimdStoreInt(uint32_t* p, SimdInt value) { _mm256_storeu_si256((__m256i*) p, value); }
+    inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b) { return _mm256_add_ps(a, b); }
+    inline SimdFloat SimdSub(SimdFloat a, SimdFloat b) { return _mm256_sub_ps(a, b); }
+    inline SimdFloat SimdMul(SimdFloat a, SimdFloat b) { return _mm256_mul_ps(a, b); }
+    inline SimdFloat SimdMin(SimdFloat a, SimdFloat b) { return _mm256_min_ps(a, b); }
+    inline SimdFloat SimdMax(SimdFloat a, SimdFloat b) { return _mm256_max_ps(a, b); }
+    inline SimdInt SimdLess(SimdFloat a, SimdFloat b) { return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_LT_OQ)); }
+    inline SimdInt SimdEqual(SimdInt a, SimdInt b) { return _mm256_cmpeq_epi32(a, b); }
+    inline SimdInt SimdAnd(SimdInt a, SimdInt b) { return _mm256_and_si256(a, b); }
+    inline SimdInt SimdOr(SimdInt a, SimdInt b) { return _mm256_or_si256(a, b); }
+    inline SimdInt SimdAndNot(SimdInt a, SimdInt b) { return _mm256_andnot_si256(b, a); }     //< a & ~b
+    inline SimdFloat SimdSelect(SimdInt mask, SimdFloat a, SimdFloat b) { return _mm256_blendv_ps(b, a, _mm256_castsi256_ps(mask)); }
+    inline SimdInt SimdSelectInt(SimdInt mask, SimdInt a, SimdInt b) { return _mm256_blendv_epi8(b, a, mask); }
+    inline bool SimdAny(SimdInt mask) { return _mm256_movemask_epi8(mask) != 0; }
+#elif MATH_SIMD_SSE
+    #define OCCLUSION_SIMD_LANES 4
+
+    typedef __m128 SimdFloat;
+    typedef __m128i SimdInt;
+
+    inline SimdFloat SimdSet(float value) { return _mm_set1_ps(value); }
+    inline SimdInt SimdSetInt(uint32_t value) { return _mm_set1_epi32((int) value); }
+    inline SimdFloat SimdLoad(const float* p) { return _mm_loadu_ps(p); }
+    inline SimdInt SimdLoadInt(const uint32_t* p) { return _mm_loadu_si128((const __m128i*) p); }
+    inline void SimdStore(float* p, SimdFloat value) { _mm_storeu_ps(p, value); }
+    inline void SimdStoreInt(uint32_t* p, SimdInt value) { _mm_storeu_si128((__m128i*) p, value); }
+    inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b) { return _mm_add_ps(a, b); }
+    inline SimdFloat SimdSub(SimdFloat a, SimdFloat b) { return _mm_sub_ps(a, b); }
+    inline SimdFloat SimdMul(SimdFloat a, SimdFloat b) { return _mm_mul_ps(a, b); }
+    inline SimdFloat SimdMin(SimdFloat a, SimdFloat b) { return _mm_min_ps(a, b); }
+    inline SimdFloat SimdMax(SimdFloat a, SimdFloat b) { return _mm_max_ps(a, b); }
+    inline SimdInt SimdLess(SimdFloat a, SimdFloat b) { return _mm_castps_si128(_mm_cmplt_ps(a, b)); }
+    inline SimdInt SimdEqual(SimdInt a, SimdInt b) { return _mm_cmpeq_epi32(a, b); }
+    inline SimdInt SimdAnd(SimdInt a, SimdInt b) { return _mm_and_si128(a, b); }
+    inline SimdInt SimdOr(SimdInt a, SimdInt b) { return _mm_or_si128(a, b); }
+    inline SimdInt SimdAndNot(SimdInt a, SimdInt b) { return _mm_andnot_si128(b, a); }
+    inline SimdFloat SimdSelect(SimdInt mask, SimdFloat a, SimdFloat b)
+    {
+        __m128 m = _mm_castsi128_ps(mask);
+        return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+    }
+    inline SimdInt SimdSelectInt(SimdInt mask, SimdInt a, SimdInt b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+    inline bool SimdAny(SimdInt mask) { return _mm_movemask_epi8(mask) != 0; }
+#elif MATH_SIMD_NEON
+    #define OCCLUSION_SIMD_LANES 4
+
+    typedef float32x4_t SimdFloat;
+    typedef uint32x4_t SimdInt;
+
+    inline SimdFloat SimdSet(float value) { return vdupq_n_f32(value); }
+    inline SimdInt SimdSetInt(uint32_t value) { return vdupq_n_u32(value); }
+    inline SimdFloat SimdLoad(const float* p) { return vld1q_f32(p); }
+    inline SimdInt SimdLoadInt(const uint32_t* p) { return vld1q_u32(p); }
+    inline void SimdStore(float* p, SimdFloat value) { vst1q_f32(p, value); }
+    inline void SimdStoreInt(uint32_t* p, SimdInt value) { vst1q_u32(p, value); }
+    inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b) { return vaddq_f32(a, b); }
+    inline SimdFloat SimdSub(SimdFloat a, SimdFloat b) { return vsubq_f32(a, b); }
+    inline SimdFloat SimdMul(SimdFloat a, SimdFloat b) { return vmulq_f32(a, b); }
+    inline SimdFloat SimdMin(SimdFloat a, SimdFloat b) { return vminq_f32(a, b); }
+    inline SimdFloat SimdMax(SimdFloat a, SimdFloat b) { return vmaxq_f32(a, b); }
+    inline SimdInt SimdLess(SimdFloat a, SimdFloat b) { return vcltq_f32(a, b); }
+    inline SimdInt SimdEqual(SimdInt a, SimdInt b) { return vceqq_u32(a, b); }
+    inline SimdInt SimdAnd(SimdInt a, SimdInt b) { return vandq_u32(a, b); }
+    inline SimdInt SimdOr(SimdInt a, SimdInt b) { return vorrq_u32(a, b); }
+    inline SimdInt SimdAndNot(SimdInt a, SimdInt b) { return vbicq_u32(a, b); }
+    inline SimdFloat SimdSelect(SimdInt mask, SimdFloat a, SimdFloat b) { return vbslq_f32(mask, a, b); }
+    inline SimdInt SimdSelectInt(SimdInt mask, SimdInt a, SimdInt b) { return vbslq_u32(mask, a, b); }
+    inline bool SimdAny(SimdInt mask) { return vmaxvq_u32(mask) != 0; }
+#endif
+
+static_assert(OCCLUSION_BUFFER_ALIGNMENT % (OCCLUSION_SUBTILE_WIDTH * 8) == 0, "a row of subtiles must be a multiple of the SIMD lanes");
+
+// 2D Polyhedral Bounds of a Clipped, Perspective-Projected 3D Sphere, Michal Mara, Morgan McGuire. 2013, same as ProjectSphere of Common.hlsli
+static float4 ProjectSphere(const float3& center, float radius, float p00, float p11)
+{
+    float2 cx = float2(-center.x, -center.z);
+    float2 vx = float2(sqrtf(dot(cx, cx) - radius * radius), radius);
+    float2 minx = float2(cx.x * vx.x - cx.y * vx.y, cx.x * vx.y + cx.y * vx.x);
+    float2 maxx = float2(cx.x * vx.x + cx.y * vx.y, -cx.x * vx.y + cx.y * vx.x);
+
+    float2 cy = float2(-center.y, -center.z);
+    float2 vy = float2(sqrtf(dot(cy, cy) - radius * radius), radius);
+    float2 miny = float2(cy.x * vy.x - cy.y * vy.y, cy.x * vy.y + cy.y * vy.x);
+    float2 maxy = float2(cy.x * vy.x + cy.y * vy.y, -cy.x * vy.y + cy.y * vy.x);
+
+    float4 aabb = float4(minx.x / minx.y * p00, miny.x / miny.y * p11, maxx.x / maxx.y * p00, maxy.x / maxy.y * p11);
+    return float4(aabb.x, aabb.w, aabb.z, aabb.y) * float4(0.5f, -0.5f, 0.5f, -0.5f) + 0.5f;     //< Clip space -> UV space
+}
+
+static uint32_t ComputeCoverage(const OcclusionTriangle& tri, float x0, float y0)
+{
+    // Subtiles with the corner pixel centers inside or outside of an edge are classified without the other pixels
+    bool bInside = true;
+    bool bOutside = false;
+    for (uint32_t e = 0; e < 3; ++e)
+    {
+        float left = tri.m_edgeA[e] * (x0 + 0.5f);
+        float right = tri.m_edgeA[e] * (x0 + ((float) OCCLUSION_SUBTILE_WIDTH - 0.5f));
+        float top = tri.m_edgeB[e] * (y0 + 0.5f) + tri.m_edgeC[e];
+        float bottom = tri.m_edgeB[e] * (y0 + ((float) OCCLUSION_SUBTILE_HEIGHT - 0.5f)) + tri.m_edgeC[e];
+
+        float minValue = min(min(left + top, right + top), min(left + bottom, right + bottom));
+        float maxValue = max(max(left + top, right + top), max(left + bottom, right + bottom));
+        bInside = bInside && 0.0f < minValue;
+        bOutside = bOutside || !(0.0f < maxValue);
+    }
+
+    if (bOutside)
+    {
+        return 0;
+    }
+    else if (bInside)
+    {
+        return 0xFFFFFFFF;
+    }
+
+    uint32_t coverage = 0;
+    for (uint32_t j = 0; j < OCCLUSION_SUBTILE_HEIGHT; ++j)
+    {
+        float y = y0 + ((float) j + 0.5f);
+        float row0 = tri.m_edgeB[0] * y + tri.m_edgeC[0];
+        float row1 = tri.m_edgeB[1] * y + tri.m_edgeC[1];
+        float row2 = tri.m_edgeB[2] * y + tri.m_edgeC[2];
+
+        for (uint32_t i = 0; i < OCCLUSION_SUBTILE_WIDTH; ++i)
+        {
+            float x = x0 + ((float) i + 0.5f);
+            if (0.0f < tri.m_edgeA[0] * x + row0 && 0.0f < tri.m_edgeA[1] * x + row1 && 0.0f < tri.m_edgeA[2] * x + row2)
+            {
+                coverage |= 1u << (j * OCCLUSION_SUBTILE_WIDTH + i);
+            }
+        }
+    }
+    return coverage;
+}
+
+// The depth plane is linear, its farthest value in a subtile is at a corner
+static float ComputeFarthestDepth(const OcclusionTriangle& tri, float x0, float y0)
+{
+    float x1 = x0 + (float) OCCLUSION_SUBTILE_WIDTH;
+    float row0 = tri.m_depthB * y0 + tri.m_depthC;
+    float row1 = tri.m_depthB * (y0 + (float) OCCLUSION_SUBTILE_HEIGHT) + tri.m_depthC;
+
+    float depth = min(min(tri.m_depthA * x0 + row0, tri.m_depthA * x1 + row0), min(tri.m_depthA * x0 + row1, tri.m_depthA * x1 + row1));
+    return max(depth, tri.m_minDepth);
+}
+
+void OcclusionBuffer::Resize(uint32_t width, uint32_t height)
+{
+    m_width = (max(width, 1u) + OCCLUSION_BUFFER_ALIGNMENT - 1) / OCCLUSION_BUFFER_ALIGNMENT * OCCLUSION_BUFFER_ALIGNMENT;
+    m_height = (max(height, 1u) + OCCLUSION_SUBTILE_HEIGHT - 1) / OCCLUSION_SUBTILE_HEIGHT * OCCLUSION_SUBTILE_HEIGHT;
+    m_subtileCountX = m_width / OCCLUSION_SUBTILE_WIDTH;
+    m_subtileCountY = m_height / OCCLUSION_SUBTILE_HEIGHT;
+    m_hizCountX = DivideRoundingUp(m_subtileCountX, OCCLUSION_HIZ_SIZE);
+    m_hizCountY = DivideRoundingUp(m_subtileCountY, OCCLUSION_HIZ_SIZE);
+
+    uint32_t subtileCount = m_subtileCountX * m_subtileCountY;
+    m_masks.resize(subtileCount);
+    m_referenceDepths.resize(subtileCount);
+    m_workingDepths.resize(subtileCount);
+    m_hiz.resize(m_hizCountX * m_hizCountY);
+}
+
+void OcclusionBuffer::Begin(const float4x4& mtxView, const float4x4& mtxProjection, uint32_t occluderCount)
+{
+    MY_ASSERT(m_width > 0 && m_height > 0);
+
+    m_mtxView = mtxView;
+    m_mtxViewProjection = mul(mtxProjection, mtxView);
+    m_zNear = mtxProjection[3][2];
+    m_p00 = mtxProjection[0][0];
+    m_p11 = mtxProjection[1][1];
+
+    // Nothing covered, the reference layer is at the infinite far plane
+    eastl::fill(m_masks.begin(), m_masks.end(), 0u);
+    eastl::fill(m_referenceDepths.begin(), m_referenceDepths.end(), 0.0f);
+    eastl::fill(m_workingDepths.begin(), m_workingDepths.end(), FLT_MAX);
+    eastl::fill(m_hiz.begin(), m_hiz.end(), 0.0f);
+
+    m_occluders.resize(occluderCount);
+    for (uint32_t i = 0; i < occluderCount; ++i)
+    {
+        m_occluders[i].m_triangles.clear();
+    }
+}
+
+void OcclusionBuffer::SetupOccluder(uint32_t index, const float4x4& mtxWorld, const OccluderMesh& mesh)
+{
+    Occluder& occluder = m_occluders[index];
+    occluder.m_triangles.clear();
+    occluder.m_screenPos.resize(mesh.m_vertices.size());
+
+    float4x4 mtxWorldViewProjection = mul(m_mtxViewProjection, mtxWorld);
+    float2 size = float2((float) m_width, (float) m_height);
+
+    for (size_t i = 0; i < mesh.m_vertices.size(); ++i)
+    {
+        float4 clipPos = mul(mtxWorldViewProjection, float4(mesh.m_vertices[i], 1.0f));
+        float3 ndc = clipPos.w >= m_zNear ? clipPos.xyz() / clipPos.w : float3(0.0f, 0.0f, 0.0f);
+        bool bValid = clipPos.w >= m_zNear && abs(ndc.x) <= OCCLUSION_GUARD_BAND && abs(ndc.y) <= OCCLUSION_GUARD_BAND;
+
+        float2 screen = (ndc.xy() * float2(0.5f, -0.5f) + 0.5f) * size;
+        occluder.m_screenPos[i] = float4(screen.x, screen.y, ndc.z, bValid ? clipPos.w : -1.0f);
+    }
+
+    for (size_t i = 0; i + 2 < mesh.m_indices.size(); i += 3)
+    {
+        float4 v0 = occluder.m_screenPos[mesh.m_indices[i]];
+        float4 v1 = occluder.m_screenPos[mesh.m_indices[i + 1]];
+        float4 v2 = occluder.m_screenPos[mesh.m_indices[i + 2]];
+        if (v0.w < 0.0f || v1.w < 0.0f || v2.w < 0.0f)
+        {
+            continue;
+        }
+
+        // Both windings are rasterized, either side of an opaque surface occludes.
+        // Positive area is clockwise on the screen, y is down
+        float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+        if (area < 0.0f)
+        {
+            eastl::swap(v1, v2);
+            area = -area;
+        }
+
+        // Slivers cover hardly any pixel center, and their depth planes are not stable
+        if (area < 1.0f / 256.0f)
+        {
+            continue;
+        }
+
+        float2 minPos = min(v0.xy(), min(v1.xy(), v2.xy()));
+        float2 maxPos = max(v0.xy(), max(v1.xy(), v2.xy()));
+        if (maxPos.x < 0.0f || maxPos.y < 0.0f || minPos.x >= size.x || minPos.y >= size.y)
+        {
+            continue;
+        }
+
+        int2 minPixel = max(int2((int32_t) floorf(minPos.x), (int32_t) floorf(minPos.y)), int2(0, 0));
+        int2 maxPixel = min(int2((int32_t) ceilf(maxPos.x), (int32_t) ceilf(maxPos.y)), int2(m_width - 1, m_height - 1));
+
+        OcclusionTriangle tri;
+        const float4* vertices[3] = { &v0, &v1, &v2 };
+        for (uint32_t e = 0; e < 3; ++e)
+        {
+            // Edge between the other two vertices, positive on the side of vertex e
+            const float4& a = *vertices[(e + 1) % 3];
+            const float4& b = *vertices[(e + 2) % 3];
+            tri.m_edgeA[e] = a.y - b.y;
+            tri.m_edgeB[e] = b.x - a.x;
+            tri.m_edgeC[e] = -(tri.m_edgeA[e] * a.x + tri.m_edgeB[e] * a.y);
+        }
+
+        tri.m_depthA = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+        tri.m_depthB = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+        tri.m_depthC = v0.z - tri.m_depthA * v0.x - tri.m_depthB * v0.y;
+        tri.m_minDepth = min(v0.z, min(v1.z, v2.z));
+
+        tri.m_minSubtileX = (uint16_t) (minPixel.x / OCCLUSION_SUBTILE_WIDTH);
+        tri.m_minSubtileY = (uint16_t) (minPixel.y / OCCLUSION_SUBTILE_HEIGHT);
+        tri.m_maxSubtileX = (uint16_t) (maxPixel.x / OCCLUSION_SUBTILE_WIDTH);
+        tri.m_maxSubtileY = (uint16_t) (maxPixel.y / OCCLUSION_SUBTILE_HEIGHT);
+
+        occluder.m_triangles.push_back(tri);
+    }
+}
+
+uint32_t OcclusionBuffer::GetTriangleCount() const
+{
+    uint32_t count = 0;
+    for (size_t i = 0; i < m_occluders.size(); ++i)
+    {
+        count += (uint32_t) m_occluders[i].m_triangles.size();
+    }
+    return count;
+}
+
+void OcclusionBuffer::Rasterize()
+{
+    BinTriangles();
+
+    ParallelFor(m_subtileCountY, [&](uint32_t row)
+        {
+            RasterizeRow(row);
+        });
+
+    BuildHiZ();
+}
+
+void OcclusionBuffer::RasterizeScalar()
+{
+    BinTriangles();
+
+    ParallelFor(m_subtileCountY, [&](uint32_t row)
+        {
+            RasterizeRowScalar(row);
+        });
+
+    BuildHiZ();
+}
+
+// Counting sort of the triangles by the rows of subtiles they overlap, in the order they were added
+void OcclusionBuffer::BinTriangles()
+{
+    m_rowOffsets.assign(m_subtileCountY + 1, 0);
+    for (size_t o = 0; o < m_occluders.size(); ++o)
+    {
+        for (const OcclusionTriangle& tri : m_occluders[o].m_triangles)
+        {
+            for (uint32_t row = tri.m_minSubtileY; row <= tri.m_maxSubtileY; ++row)
+            {
+                ++m_rowOffsets[row + 1];
+            }
+        }
+    }
+
+    for (uint32_t row = 0; row < m_subtileCountY; ++row)
+    {
+        m_rowOffsets[row + 1] += m_rowOffsets[row];
+    }
+
+    m_rowTriangles.resize(m_rowOffsets[m_subtileCountY]);
+    eastl::vector<uint32_t> rowCounts(m_rowOffsets.begin(), m_rowOffsets.end() - 1);
+    for (size_t o = 0; o < m_occluders.size(); ++o)
+    {
+        for (const OcclusionTriangle& tri : m_occluders[o].m_triangles)
+        {
+            for (uint32_t row = tri.m_minSubtileY; row <= tri.m_maxSubtileY; ++row)
+            {
+                m_rowTriangles[rowCounts[row]++] = &tri;
+            }
+        }
+    }
+}
+
+void OcclusionBuffer::RasterizeRow(uint32_t row)
+{
+#ifndef OCCLUSION_SIMD_LANES
+    RasterizeRowScalar(row);
+#else
+    float laneOffsets[OCCLUSION_SIMD_LANES];
+    for (uint32_t k = 0; k < OCCLUSION_SIMD_LANES; ++k)
+    {
+        laneOffsets[k] = (float) (k * OCCLUSION_SUBTILE_WIDTH);
+    }
+
+    const SimdFloat laneOffset = SimdLoad(laneOffsets);
+    const SimdFloat zero = SimdSet(0.0f);
+    const SimdInt zeroMask = SimdSetInt(0);
+    const SimdInt fullMask = SimdSetInt(0xFFFFFFFF);
+    const float y0 = (float) (row * OCCLUSION_SUBTILE_HEIGHT);
+
+    for (uint32_t t = m_rowOffsets[row]; t < m_rowOffsets[row + 1]; ++t)
+    {
+        const OcclusionTriangle& tri = *m_rowTriangles[t];
+
+        uint32_t firstSubtile = tri.m_minSubtileX / OCCLUSION_SIMD_LANES * OCCLUSION_SIMD_LANES;
+        for (uint32_t s = firstSubtile; s <= tri.m_maxSubtileX; s += OCCLUSION_SIMD_LANES)
+        {
+            SimdFloat x0 = SimdAdd(SimdSet((float) (s * OCCLUSION_SUBTILE_WIDTH)), laneOffset);
+
+            // Same classification as ComputeCoverage
+            SimdInt inside = fullMask;
+            SimdInt outside = zeroMask;
+            for (uint32_t e = 0; e < 3; ++e)
+            {
+                SimdFloat edgeA = SimdSet(tri.m_edgeA[e]);
+                SimdFloat left = SimdMul(edgeA, SimdAdd(x0, SimdSet(0.5f)));
+                SimdFloat right = SimdMul(edgeA, SimdAdd(x0, SimdSet((float) OCCLUSION_SUBTILE_WIDTH - 0.5f)));
+                SimdFloat top = SimdSet(tri.m_edgeB[e] * (y0 + 0.5f) + tri.m_edgeC[e]);
+                SimdFloat bottom = SimdSet(tri.m_edgeB[e] * (y0 + ((float) OCCLUSION_SUBTILE_HEIGHT - 0.5f)) + tri.m_edgeC[e]);
+
+                SimdFloat minValue = SimdMin(SimdMin(SimdAdd(left, top), SimdAdd(right, top)), SimdMin(SimdAdd(left, bottom), SimdAdd(right, bottom)));
+                SimdFloat maxValue = SimdMax(SimdMax(SimdAdd(left, top), SimdAdd(right, top)), SimdMax(SimdAdd(left, bottom), SimdAdd(right, bottom)));
+                inside = SimdAnd(inside, SimdLess(zero, minValue));
+                outside = SimdOr(outside, SimdAndNot(fullMask, SimdLess(zero, maxValue)));
+            }
+
+            inside = SimdAndNot(inside, outside);
+            SimdInt partial = SimdAndNot(SimdAndNot(fullMask, inside), outside);
+            if (!SimdAny(SimdOr(inside, partial)))
+            {
+                continue;
+            }
+
+            SimdInt coverage = zeroMask;
+            if (SimdAny(partial))
+            {
+                for (uint32_t j = 0; j < OCCLUSION_SUBTILE_HEIGHT; ++j)
+                {
+                    float y = y0 + ((float) j + 0.5f);
+                    SimdFloat row0 = SimdSet(tri.m_edgeB[0] * y + tri.m_edgeC[0]);
+                    SimdFloat row1 = SimdSet(tri.m_edgeB[1] * y + tri.m_edgeC[1]);
+                    SimdFloat row2 = SimdSet(tri.m_edgeB[2] * y + tri.m_edgeC[2]);
+
+                    for (uint32_t i = 0; i < OCCLUSION_SUBTILE_WIDTH; ++i)
+                    {
+                        SimdFloat x = SimdAdd(x0, SimdSet((float) i + 0.5f));
+                        SimdInt pixel = SimdLess(zero, SimdAdd(SimdMul(SimdSet(tri.m_edgeA[0]), x), row0));
+                        pixel = SimdAnd(pixel, SimdLess(zero, SimdAdd(SimdMul(SimdSet(tri.m_edgeA[1]), x), row1)));
+                        pixel = SimdAnd(pixel, SimdLess(zero, SimdAdd(SimdMul(SimdSet(tri.m_edgeA[2]), x), row2)));
+                        coverage = SimdOr(coverage, SimdAnd(pixel, SimdSetInt(1u << (j * OCCLUSION_SUBTILE_WIDTH + i))));
+                    }
+                }
+            }
+            coverage = SimdSelectInt(inside, fullMask, SimdAnd(coverage, partial));
+
+            SimdFloat x1 = SimdAdd(x0, SimdSet((float) OCCLUSION_SUBTILE_WIDTH));
+            SimdFloat depthRow0 = SimdSet(tri.m_depthB * y0 + tri.m_depthC);
+            SimdFloat depthRow1 = SimdSet(tri.m_depthB * (y0 + (float) OCCLUSION_SUBTILE_HEIGHT) + tri.m_depthC);
+            SimdFloat depthA = SimdSet(tri.m_depthA);
+            SimdFloat depth = SimdMin(
+                SimdMin(SimdAdd(SimdMul(depthA, x0), depthRow0), SimdAdd(SimdMul(depthA, x1), depthRow0)),
+                SimdMin(SimdAdd(SimdMul(depthA, x0), depthRow1), SimdAdd(SimdMul(depthA, x1), depthRow1)));
+            depth = SimdMax(depth, SimdSet(tri.m_minDepth));
+
+            // Same as UpdateSubtile
+            uint32_t subtile = row * m_subtileCountX + s;
+            SimdInt mask = SimdLoadInt(&m_masks[subtile]);
+            SimdFloat referenceDepth = SimdLoad(&m_referenceDepths[subtile]);
+            SimdFloat workingDepth = SimdLoad(&m_workingDepths[subtile]);
+
+            SimdInt dead = SimdOr(SimdEqual(coverage, zeroMask), SimdLess(depth, referenceDepth));
+            coverage = SimdAndNot(coverage, dead);
+
+            SimdFloat distance = SimdSub(SimdMul(workingDepth, SimdSet(2.0f)), SimdAdd(depth, referenceDepth));
+            SimdInt discard = SimdAndNot(SimdOr(SimdLess(distance, zero), SimdEqual(coverage, fullMask)), dead);
+
+            mask = SimdOr(SimdAndNot(mask, discard), coverage);
+            SimdInt full = SimdEqual(mask, fullMask);
+
+            SimdFloat mergedDepth = SimdMin(SimdSelect(dead, workingDepth, depth), SimdSelect(discard, depth, workingDepth));
+            SimdStore(&m_workingDepths[subtile], SimdSelect(full, SimdSet(FLT_MAX), mergedDepth));
+            SimdStore(&m_referenceDepths[subtile], SimdSelect(full, mergedDepth, referenceDepth));
+            SimdStoreInt(&m_masks[subtile], SimdAndNot(mask, full));
+        }
+    }
+#endif
+}
+
+void OcclusionBuffer::RasterizeRowScalar(uint32_t row)
+{
+    const float y0 = (float) (row * OCCLUSION_SUBTILE_HEIGHT);
+
+    for (uint32_t t = m_rowOffsets[row]; t < m_rowOffsets[row + 1]; ++t)
+    {
+        const OcclusionTriangle& tri = *m_rowTriangles[t];
+
+        for (uint32_t s = tri.m_minSubtileX; s <= tri.m_maxSubtileX; ++s)
+        {
+            float x0 = (float) (s * OCCLUSION_SUBTILE_WIDTH);
+            UpdateSubtile(row * m_subtileCountX + s, ComputeCoverage(tri, x0, y0), ComputeFarthestDepth(tri, x0, y0));
+        }
+    }
+}
+
+void OcclusionBuffer::UpdateSubtile(uint32_t subtile, uint32_t coverage, float depth)
+{
+    uint32_t& mask = m_masks[subtile];
+    float& referenceDepth = m_referenceDepths[subtile];
+    float& workingDepth = m_workingDepths[subtile];
+
+    // Nothing covered, or the triangle is behind the whole subtile
+    bool bDead = coverage == 0 || depth < referenceDepth;
+    if (bDead)
+    {
+        return;
+    }
+
+    // The working layer is discarded if the triangle is much nearer than it, or covers the whole subtile
+    bool bDiscard = workingDepth * 2.0f - (depth + referenceDepth) < 0.0f || coverage == 0xFFFFFFFF;
+
+    mask = (bDiscard ? 0 : mask) | coverage;
+    float mergedDepth = bDiscard ? depth : min(depth, workingDepth);
+
+    if (mask == 0xFFFFFFFF)
+    {
+        referenceDepth = mergedDepth;
+        workingDepth = FLT_MAX;
+        mask = 0;
+    }
+    else
+    {
+        workingDepth = mergedDepth;
+    }
+}
+
+void OcclusionBuffer::BuildHiZ()
+{
+    for (uint32_t y = 0; y < m_hizCountY; ++y)
+    {
+        for (uint32_t x = 0; x < m_hizCountX; ++x)
+        {
+            float depth = FLT_MAX;
+            for (uint32_t sy = y * OCCLUSION_HIZ_SIZE; sy < min((y + 1) * OCCLUSION_HIZ_SIZE, m_subtileCountY); ++sy)
+            {
+                for (uint32_t sx = x * OCCLUSION_HIZ_SIZE; sx < min((x + 1) * OCCLUSION_HIZ_SIZE, m_subtileCountX); ++sx)
+                {
+                    depth = min(depth, m_referenceDepths[sy * m_subtileCountX + sx]);
+                }
+            }
+            m_hiz[y * m_hizCountX + x] = depth;
+        }
+    }
+}
+
+bool OcclusionBuffer::IsOccluded(const float3& center, float radius) const
+{
+    float3 viewCenter = mul(m_mtxView, float4(center, 1.0f)).xyz();
+    if (viewCenter.z < radius + m_zNear)
+    {
+        return false;
+    }
+
+    float4 rect = clamp(ProjectSphere(viewCenter, radius, m_p00, m_p11), 0.0f, 1.0f);
+    uint32_t minX = min((uint32_t) (rect.x * m_width), m_width - 1);
+    uint32_t minY = min((uint32_t) (rect.y * m_height), m_height - 1);
+    uint32_t maxX = min((uint32_t) (rect.z * m_width), m_width - 1);
+    uint32_t maxY = min((uint32_t) (rect.w * m_height), m_height - 1);
+
+    uint32_t minSubtileX = minX / OCCLUSION_SUBTILE_WIDTH;
+    uint32_t minSubtileY = minY / OCCLUSION_SUBTILE_HEIGHT;
+    uint32_t maxSubtileX = maxX / OCCLUSION_SUBTILE_WIDTH;
+    uint32_t maxSubtileY = maxY / OCCLUSION_SUBTILE_HEIGHT;
+
+    // Nearest point of the sphere, occluded if it is behind the reference layer of all the subtiles of its rect
+    float depth = m_zNear / (viewCenter.z - radius);
+
+    for (uint32_t y = minSubtileY / OCCLUSION_HIZ_SIZE; y <= maxSubtileY / OCCLUSION_HIZ_SIZE; ++y)
+    {
+        for (uint32_t x = minSubtileX / OCCLUSION_HIZ_SIZE; x <= maxSubtileX / OCCLUSION_HIZ_SIZE; ++x)
+        {
+            if (depth < m_hiz[y * m_hizCountX + x])
+            {
+                continue;
+            }
+
+            uint32_t beginY = max(minSubtileY, y * OCCLUSION_HIZ_SIZE);
+            uint32_t endY = min(maxSubtileY, y * OCCLUSION_HIZ_SIZE + OCCLUSION_HIZ_SIZE - 1);
+            uint32_t beginX = max(minSubtileX, x * OCCLUSION_HIZ_SIZE);
+            uint32_t endX = min(maxSubtileX, x * OCCLUSION_HIZ_SIZE + OCCLUSION_HIZ_SIZE - 1);
+
+            for (uint32_t sy = beginY; sy <= endY; ++sy)
+            {
+                for (uint32_t sx = beginX; sx <= endX; ++sx)
+                {
+                    if (depth >= m_referenceDepths[sy * m_subtileCountX + sx])
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
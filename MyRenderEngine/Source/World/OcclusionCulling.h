@@ -0,0 +1,106 @@
+#pragma once
+#include "Utils/math.h"
+#include "EASTL/vector.h"
+
+#define OCCLUSION_SUBTILE_WIDTH 8               //< The coverage mask of a subtile has 32 bits
+#define OCCLUSION_SUBTILE_HEIGHT 4
+#define OCCLUSION_BUFFER_ALIGNMENT 64           //< Width alignment in pixels, a multiple of the subtiles of a SIMD iteration
+#define OCCLUSION_HIZ_SIZE 4                    //< Subtiles per side of a texel of the coarse level
+#define OCCLUSION_GUARD_BAND 1024.0f            //< Triangles with vertices farther out in NDC are skipped for the precision of the edge functions
+#define OCCLUSION_BUFFER_WIDTH 256
+#define OCCLUSION_MAX_OCCLUDERS 32              //< Largest ones on the screen
+#define OCCLUSION_OCCLUDER_MIN_SIZE 0.1f        //< Radius / distance of occluders
+#define OCCLUSION_OCCLUDER_MAX_TRIANGLES 256    //< Of the simplified proxies, meshes which can't be simplified to it are no occluders
+
+// Simplified opaque surface of a static mesh in its local space
+struct OccluderMesh
+{
+    eastl::vector<float3> m_vertices;
+    eastl::vector<uint16_t> m_indices;
+};
+
+// Screen space setup of an occluder triangle in pixels of the occlusion buffer
+struct OcclusionTriangle
+{
+    float m_edgeA[3];       //< a * x + b * y + c of the edges, positive inside
+    float m_edgeB[3];
+    float m_edgeC[3];
+    float m_depthA;         //< Plane of the depth, a * x + b * y + c
+    float m_depthB;
+    float m_depthC;
+    float m_minDepth;       //< Farthest vertex
+    uint16_t m_minSubtileX;
+    uint16_t m_minSubtileY;
+    uint16_t m_maxSubtileX;
+    uint16_t m_maxSubtileY;
+};
+
+// Masked software occlusion culling, Andersson et al. 2015. The depth is reversed z, every 8x4 subtile has a coverage mask and two depth layers
+// instead of per pixel depth : the reference layer is the farthest depth of the whole subtile, the working layer the farthest depth of the covered pixels.
+// The working layer is merged into the reference layer when its mask is full, the reference layer is conservative for the tests of the object bounds
+class OcclusionBuffer
+{
+public:
+    void Resize(uint32_t width, uint32_t height);   //< The width is aligned to OCCLUSION_BUFFER_ALIGNMENT and the height to OCCLUSION_SUBTILE_HEIGHT
+    uint32_t GetWidth() const { return m_width; }
+    uint32_t GetHeight() const { return m_height; }
+
+    // Clears the buffer for a new view, the projection is left-handed with reversed z and an infinite far plane
+    void Begin(const float4x4& mtxView, const float4x4& mtxProjection, uint32_t occluderCount);
+
+    // Transforms and sets up the triangles of an occluder, thread safe for different indices.
+    // Triangles crossing the near plane are skipped, which only makes the buffer more conservative
+    void SetupOccluder(uint32_t index, const float4x4& mtxWorld, const OccluderMesh& mesh);
+    uint32_t GetTriangleCount() const;
+
+    // One task per row of subtiles with the triangles binned to it, the rows are independent so the result doesn't depend on the thread count
+    void Rasterize();
+    void RasterizeScalar();     //< Same result as Rasterize without SIMD
+
+    // Bounding sphere in world space, thread safe after Rasterize
+    bool IsOccluded(const float3& center, float radius) const;
+
+    uint32_t GetSubtileCount() const { return (uint32_t) m_masks.size(); }
+    const eastl::vector<uint32_t>& GetMasks() const { return m_masks; }
+    const eastl::vector<float>& GetReferenceDepths() const { return m_referenceDepths; }
+    const eastl::vector<float>& GetWorkingDepths() const { return m_workingDepths; }
+
+private:
+    void BinTriangles();
+    void RasterizeRow(uint32_t row);
+    void RasterizeRowScalar(uint32_t row);
+    void UpdateSubtile(uint32_t subtile, uint32_t coverage, float depth);
+    void BuildHiZ();
+
+private:
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    uint32_t m_subtileCountX = 0;
+    uint32_t m_subtileCountY = 0;
+
+    float4x4 m_mtxView;
+    float4x4 m_mtxViewProjection;
+    float m_zNear = 0.0f;
+    float m_p00 = 0.0f;
+    float m_p11 = 0.0f;
+
+    // Subtiles in rows
+    eastl::vector<uint32_t> m_masks;
+    eastl::vector<float> m_referenceDepths;
+    eastl::vector<float> m_workingDepths;
+
+    // Farthest reference depth of OCCLUSION_HIZ_SIZE x OCCLUSION_HIZ_SIZE subtiles, rejects most of the tested bounds without the subtiles
+    eastl::vector<float> m_hiz;
+    uint32_t m_hizCountX = 0;
+    uint32_t m_hizCountY = 0;
+
+    struct Occluder
+    {
+        eastl::vector<float4> m_screenPos;      //< xy : pixels, z : depth, w : view z
+        eastl::vector<OcclusionTriangle> m_triangles;
+    };
+    eastl::vector<Occluder> m_occluders;
+
+    eastl::vector<uint32_t> m_rowOffsets;   //< Of every row of subtiles in m_rowTriangles
+    eastl::vector<const OcclusionTriangle*> m_rowTriangles;
+};
@@ -23,11 +23,15 @@ void PointLight::Tick(float deltaTime)
 
     Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
     pRenderer->AddLocalLight(data);
+
+    UpdateObjectBounds();   //< Radius can be changed in GUI
 }
 
-bool PointLight::FrustumCull(const float4* pPlanes, uint32_t planeCount) const
+bool PointLight::GetLocalBounds(float3& center, float& radius) const
 {
-    return ::FrustumCull(pPlanes, planeCount, m_pos, m_lightRadius);
+    center = float3(0.0f, 0.0f, 0.0f);
+    radius = m_lightRadius;
+    return true;
 }
 
 void PointLight::OnGUI()
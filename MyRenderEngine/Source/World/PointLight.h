@@ -6,6 +6,6 @@ class PointLight : public ILight
 public:
     virtual bool Create() override;
     virtual void Tick(float deltaTime) override;
-    virtual bool FrustumCull(const float4* pPlanes, uint32_t planeCount) const override;
+    virtual bool GetLocalBounds(float3& center, float& radius) const override;
     virtual void OnGUI() override;
 };
\ No newline at end of file
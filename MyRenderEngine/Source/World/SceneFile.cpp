@@ -0,0 +1,409 @@
+#include "SceneFile.h"
+#include "Utils/assert.h"
+#include "Utils/string.h"
+#include "Utils/fmt.h"
+#include "Utils/log.h"
+#include "tinyxml2/tinyxml2.h"
+#include <fstream>
+
+static_assert(sizeof(SceneCameraDesc) == sizeof(float) * 8, "Scene records are written without padding");
+static_assert(sizeof(SceneObjectDesc) == sizeof(uint32_t) * 24, "Scene records are written without padding");
+static_assert(sizeof(SceneInstanceDesc) == sizeof(float) * 9, "Scene records are written without padding");
+
+uint32_t SceneDesc::AddString(const eastl::string& str)
+{
+    auto iter = m_stringOffsets.find(str);
+    if (iter != m_stringOffsets.end())
+    {
+        return iter->second;
+    }
+
+    uint32_t offset = (uint32_t) m_strings.size();
+    m_strings.append(str.c_str(), str.size() + 1);   //< With the null terminator
+    m_stringOffsets.insert(eastl::make_pair(str, offset));
+
+    return offset;
+}
+
+void SceneDesc::Clear()
+{
+    m_camera = SceneCameraDesc();
+    m_objects.clear();
+    m_instances.clear();
+    m_strings.clear();
+    m_stringOffsets.clear();
+    m_worldObjectCount = 0;
+}
+
+inline float3 str_to_float3(const char* str)
+{
+    eastl::vector<float> v;
+    v.reserve(3);
+    string_to_float_array(str, v);
+    return v.size() == 3 ? float3(v[0], v[1], v[2]) : float3(0.0f, 0.0f, 0.0f);
+}
+
+inline eastl::string float3_to_str(const float3& v)
+{
+    // Shortest representation which reads back to the same floats
+    return fmt::format("{},{},{}", v.x, v.y, v.z).c_str();
+}
+
+inline void ReadFloat3(const tinyxml2::XMLElement* pElement, const char* name, float3& value)
+{
+    const tinyxml2::XMLAttribute* pAttribute = pElement->FindAttribute(name);
+    if (pAttribute)
+    {
+        value = str_to_float3(pAttribute->Value());
+    }
+}
+
+inline void ReadTransform(const tinyxml2::XMLElement* pElement, float3& position, float3& rotation, float3& scale)
+{
+    ReadFloat3(pElement, "position", position);
+    ReadFloat3(pElement, "rotation", rotation);
+    ReadFloat3(pElement, "scale", scale);
+}
+
+inline void ReadBounds(const tinyxml2::XMLElement* pElement, float4& bounds)
+{
+    const tinyxml2::XMLAttribute* pAttribute = pElement->FindAttribute("bounds");
+    if (pAttribute)
+    {
+        eastl::vector<float> v;
+        v.reserve(4);
+        string_to_float_array(pAttribute->Value(), v);
+        bounds = v.size() == 4 ? float4(v[0], v[1], v[2], v[3]) : float4(0.0f, 0.0f, 0.0f, 0.0f);
+    }
+}
+
+inline void ReadModel(const tinyxml2::XMLElement* pElement, SceneDesc& desc)
+{
+    const tinyxml2::XMLAttribute* pFile = pElement->FindAttribute("file");
+    if (pFile == nullptr)
+    {
+        MY_ERROR("[SceneFile] model without file");
+        return;
+    }
+
+    SceneObjectDesc object;
+    object.m_type = SceneObjectType::Model;
+    object.m_file = desc.AddString(pFile->Value());
+    object.m_firstInstance = (uint32_t) desc.m_instances.size();
+    ReadTransform(pElement, object.m_position, object.m_rotation, object.m_scale);
+    ReadBounds(pElement, object.m_bounds);
+
+    for (const tinyxml2::XMLElement* pInstance = pElement->FirstChildElement("instance"); pInstance != nullptr; pInstance = pInstance->NextSiblingElement("instance"))
+    {
+        SceneInstanceDesc instance;
+        ReadTransform(pInstance, instance.m_position, instance.m_rotation, instance.m_scale);
+        desc.m_instances.push_back(instance);
+    }
+    object.m_instanceCount = (uint32_t) desc.m_instances.size() - object.m_firstInstance;
+    object.m_firstInstance = object.m_instanceCount > 0 ? object.m_firstInstance : 0;
+
+    desc.m_objects.push_back(object);
+}
+
+inline void ReadLight(const tinyxml2::XMLElement* pElement, SceneDesc& desc)
+{
+    SceneObjectDesc object;
+
+    const char* pType = pElement->Attribute("type");
+    if (pType && strcmp(pType, "point") == 0)
+    {
+        object.m_type = SceneObjectType::PointLight;
+    }
+    else if (pType && strcmp(pType, "directional") == 0)
+    {
+        object.m_type = SceneObjectType::DirectionalLight;
+    }
+    else
+    {
+        MY_ERROR("[SceneFile] unknown light type : {}", pType ? pType : "");
+        return;
+    }
+
+    ReadTransform(pElement, object.m_position, object.m_rotation, object.m_scale);
+    ReadBounds(pElement, object.m_bounds);
+    ReadFloat3(pElement, "color", object.m_color);
+    pElement->QueryFloatAttribute("intensity", &object.m_intensity);
+    pElement->QueryFloatAttribute("radius", &object.m_radius);
+    pElement->QueryFloatAttribute("falloff", &object.m_falloff);
+
+    bool bPrimary = false;
+    pElement->QueryBoolAttribute("primary", &bPrimary);
+    object.m_bPrimary = bPrimary ? 1 : 0;
+
+    desc.m_objects.push_back(object);
+}
+
+bool ParseSceneXML(const char* pText, size_t size, SceneDesc& desc)
+{
+    desc.Clear();
+
+    tinyxml2::XMLDocument doc;
+    if (tinyxml2::XML_SUCCESS != doc.Parse(pText, size))
+    {
+        MY_ERROR("[SceneFile] invalid xml : {}", doc.ErrorStr());
+        return false;
+    }
+
+    const tinyxml2::XMLElement* pRoot = doc.FirstChildElement("scene");
+    if (pRoot == nullptr)
+    {
+        MY_ERROR("[SceneFile] no scene element");
+        return false;
+    }
+
+    for (const tinyxml2::XMLElement* pElement = pRoot->FirstChildElement(); pElement != nullptr; pElement = pElement->NextSiblingElement())
+    {
+        if (strcmp(pElement->Value(), "camera") == 0)
+        {
+            ReadFloat3(pElement, "position", desc.m_camera.m_position);
+            ReadFloat3(pElement, "rotation", desc.m_camera.m_rotation);
+            pElement->QueryFloatAttribute("fov", &desc.m_camera.m_fov);
+            pElement->QueryFloatAttribute("znear", &desc.m_camera.m_znear);
+        }
+        else if (strcmp(pElement->Value(), "model") == 0)
+        {
+            ReadModel(pElement, desc);
+        }
+        else if (strcmp(pElement->Value(), "light") == 0)
+        {
+            ReadLight(pElement, desc);
+        }
+    }
+
+    return true;
+}
+
+inline void WriteTransform(tinyxml2::XMLElement* pElement, const float3& position, const float3& rotation, const float3& scale)
+{
+    pElement->SetAttribute("position", float3_to_str(position).c_str());
+    pElement->SetAttribute("rotation", float3_to_str(rotation).c_str());
+    pElement->SetAttribute("scale", float3_to_str(scale).c_str());
+}
+
+inline void WriteBounds(tinyxml2::XMLElement* pElement, const float4& bounds)
+{
+    if (bounds.w > 0.0f)
+    {
+        pElement->SetAttribute("bounds", fmt::format("{},{},{},{}", bounds.x, bounds.y, bounds.z, bounds.w).c_str());
+    }
+}
+
+eastl::string WriteSceneXML(const SceneDesc& desc)
+{
+    tinyxml2::XMLDocument doc;
+    tinyxml2::XMLElement* pRoot = doc.NewElement("scene");
+    doc.InsertEndChild(pRoot);
+
+    tinyxml2::XMLElement* pCamera = doc.NewElement("camera");
+    pCamera->SetAttribute("position", float3_to_str(desc.m_camera.m_position).c_str());
+    pCamera->SetAttribute("rotation", float3_to_str(desc.m_camera.m_rotation).c_str());
+    pCamera->SetAttribute("fov", desc.m_camera.m_fov);
+    pCamera->SetAttribute("znear", desc.m_camera.m_znear);
+    pRoot->InsertEndChild(pCamera);
+
+    for (size_t i = 0; i < desc.m_objects.size(); ++i)
+    {
+        const SceneObjectDesc& object = desc.m_objects[i];
+
+        if (object.m_type == SceneObjectType::Model)
+        {
+            tinyxml2::XMLElement* pModel = doc.NewElement("model");
+            pModel->SetAttribute("file", desc.GetString(object.m_file));
+            WriteTransform(pModel, object.m_position, object.m_rotation, object.m_scale);
+            WriteBounds(pModel, object.m_bounds);
+
+            for (uint32_t j = 0; j < object.m_instanceCount; ++j)
+            {
+                const SceneInstanceDesc& instance = desc.m_instances[object.m_firstInstance + j];
+
+                tinyxml2::XMLElement* pInstance = doc.NewElement("instance");
+                WriteTransform(pInstance, instance.m_position, instance.m_rotation, instance.m_scale);
+                pModel->InsertEndChild(pInstance);
+            }
+
+            pRoot->InsertEndChild(pModel);
+        }
+        else
+        {
+            tinyxml2::XMLElement* pLight = doc.NewElement("light");
+            pLight->SetAttribute("type", object.m_type == SceneObjectType::PointLight ? "point" : "directional");
+            WriteTransform(pLight, object.m_position, object.m_rotation, object.m_scale);
+            WriteBounds(pLight, object.m_bounds);
+            pLight->SetAttribute("color", float3_to_str(object.m_color).c_str());
+            pLight->SetAttribute("intensity", object.m_intensity);
+            pLight->SetAttribute("radius", object.m_radius);
+            pLight->SetAttribute("falloff", object.m_falloff);
+            if (object.m_bPrimary)
+            {
+                pLight->SetAttribute("primary", true);
+            }
+
+            pRoot->InsertEndChild(pLight);
+        }
+    }
+
+    tinyxml2::XMLPrinter printer;
+    doc.Print(&printer);
+
+    return eastl::string(printer.CStr(), printer.CStrSize() - 1);
+}
+
+bool ParseSceneBinary(const void* pData, size_t size, SceneDesc& desc)
+{
+    desc.Clear();
+
+    if (size < sizeof(SceneFileHeader))
+    {
+        MY_ERROR("[SceneFile] truncated header");
+        return false;
+    }
+
+    SceneFileHeader header;
+    memcpy(&header, pData, sizeof(SceneFileHeader));
+
+    if (header.m_magic != SCENE_FILE_MAGIC || header.m_version != SCENE_FILE_VERSION)
+    {
+        MY_ERROR("[SceneFile] not a scene file of version {}", SCENE_FILE_VERSION);
+        return false;
+    }
+
+    // 64 bits so the counts of a corrupted file can't overflow the size
+    uint64_t objectSize = (uint64_t) sizeof(SceneObjectDesc) * header.m_objectCount;
+    uint64_t instanceSize = (uint64_t) sizeof(SceneInstanceDesc) * header.m_instanceCount;
+    uint64_t expectedSize = sizeof(SceneFileHeader) + objectSize + instanceSize + header.m_stringTableSize;
+
+    if (header.m_fileSize != size || expectedSize != size)
+    {
+        MY_ERROR("[SceneFile] size mismatch, {} bytes but the header expects {}", size, expectedSize);
+        return false;
+    }
+
+    const uint8_t* pBytes = (const uint8_t*) pData + sizeof(SceneFileHeader);
+
+    desc.m_camera = header.m_camera;
+    desc.m_worldObjectCount = header.m_worldObjectCount;
+
+    desc.m_objects.resize(header.m_objectCount);
+    memcpy(desc.m_objects.data(), pBytes, objectSize);
+    pBytes += objectSize;
+
+    desc.m_instances.resize(header.m_instanceCount);
+    memcpy(desc.m_instances.data(), pBytes, instanceSize);
+    pBytes += instanceSize;
+
+    desc.m_strings.assign((const char*) pBytes, header.m_stringTableSize);
+
+    if (header.m_stringTableSize > 0 && desc.m_strings.back() != '\0')
+    {
+        MY_ERROR("[SceneFile] string table isn't terminated");
+        desc.Clear();
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header.m_objectCount; ++i)
+    {
+        const SceneObjectDesc& object = desc.m_objects[i];
+        if (object.m_type == SceneObjectType::Model &&
+            (object.m_file >= header.m_stringTableSize || (uint64_t) object.m_firstInstance + object.m_instanceCount > header.m_instanceCount))
+        {
+            MY_ERROR("[SceneFile] object {} is out of the tables", i);
+            desc.Clear();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void WriteSceneBinary(const SceneDesc& desc, eastl::vector<uint8_t>& data)
+{
+    uint32_t objectSize = sizeof(SceneObjectDesc) * (uint32_t) desc.m_objects.size();
+    uint32_t instanceSize = sizeof(SceneInstanceDesc) * (uint32_t) desc.m_instances.size();
+    uint32_t stringTableSize = (uint32_t) desc.m_strings.size();
+
+    SceneFileHeader header = {};
+    header.m_magic = SCENE_FILE_MAGIC;
+    header.m_version = SCENE_FILE_VERSION;
+    header.m_fileSize = sizeof(SceneFileHeader) + objectSize + instanceSize + stringTableSize;
+    header.m_objectCount = (uint32_t) desc.m_objects.size();
+    header.m_instanceCount = (uint32_t) desc.m_instances.size();
+    header.m_stringTableSize = stringTableSize;
+    header.m_worldObjectCount = desc.m_worldObjectCount;
+    header.m_camera = desc.m_camera;
+
+    data.resize(header.m_fileSize);
+    uint8_t* pBytes = data.data();
+
+    memcpy(pBytes, &header, sizeof(SceneFileHeader));
+    pBytes += sizeof(SceneFileHeader);
+
+    memcpy(pBytes, desc.m_objects.data(), objectSize);
+    pBytes += objectSize;
+
+    memcpy(pBytes, desc.m_instances.data(), instanceSize);
+    pBytes += instanceSize;
+
+    memcpy(pBytes, desc.m_strings.data(), stringTableSize);
+}
+
+bool IsBinarySceneFile(const eastl::string& file)
+{
+    const size_t extensionLength = strlen(SCENE_FILE_EXTENSION);
+    return file.size() >= extensionLength && file.compare(file.size() - extensionLength, extensionLength, SCENE_FILE_EXTENSION) == 0;
+}
+
+bool LoadSceneFile(const eastl::string& file, SceneDesc& desc)
+{
+    std::ifstream is;
+    is.open(file.c_str(), std::ios::binary);
+    if (is.fail())
+    {
+        MY_ERROR("[SceneFile] failed to open {}", file);
+        return false;
+    }
+
+    is.seekg(0, std::ios::end);
+    uint32_t length = (uint32_t) is.tellg();
+    is.seekg(0, std::ios::beg);
+
+    eastl::vector<uint8_t> data(length);
+    is.read((char*) data.data(), length);
+    is.close();
+
+    if (IsBinarySceneFile(file))
+    {
+        return ParseSceneBinary(data.data(), data.size(), desc);
+    }
+
+    return ParseSceneXML((const char*) data.data(), data.size(), desc);
+}
+
+bool SaveSceneFile(const eastl::string& file, const SceneDesc& desc)
+{
+    std::ofstream os;
+    os.open(file.c_str(), std::ios::binary);
+    if (os.fail())
+    {
+        MY_ERROR("[SceneFile] failed to open {}", file);
+        return false;
+    }
+
+    if (IsBinarySceneFile(file))
+    {
+        eastl::vector<uint8_t> data;
+        WriteSceneBinary(desc, data);
+        os.write((const char*) data.data(), data.size());
+    }
+    else
+    {
+        eastl::string xml = WriteSceneXML(desc);
+        os.write(xml.c_str(), xml.size());
+    }
+
+    return !os.fail();
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include "Utils/math.h"
+#include "EASTL/vector.h"
+#include "EASTL/string.h"
+#include "EASTL/hash_map.h"
+
+#define SCENE_FILE_MAGIC 0x4353594D     //< "MYSC"
+#define SCENE_FILE_VERSION 1
+#define SCENE_FILE_EXTENSION ".scene"   //< Binary scenes, the others are loaded as xml
+#define SCENE_INVALID_STRING UINT32_MAX
+
+enum class SceneObjectType : uint32_t
+{
+    Model,
+    PointLight,
+    DirectionalLight,
+};
+
+// Records are written to the binary file as they are, members are kept 4 bytes wide so there is no padding in them
+struct SceneCameraDesc
+{
+    float3 m_position = {0.0f, 0.0f, 0.0f};
+    float3 m_rotation = {0.0f, 0.0f, 0.0f};     //< Euler angles in degree
+    float m_fov = 60.0f;
+    float m_znear = 0.1f;
+};
+
+struct SceneObjectDesc
+{
+    SceneObjectType m_type = SceneObjectType::Model;
+    float3 m_position = {0.0f, 0.0f, 0.0f};
+    float3 m_rotation = {0.0f, 0.0f, 0.0f};     //< Euler angles in degree, as the xml
+    float3 m_scale = {1.0f, 1.0f, 1.0f};
+    float4 m_bounds = {0.0f, 0.0f, 0.0f, 0.0f}; //< World space sphere of the loaded object, w : radius, 0 if not known yet
+
+    // Lights
+    float3 m_color = {1.0f, 1.0f, 1.0f};
+    float m_intensity = 1.0f;
+    float m_radius = 5.0f;
+    float m_falloff = 1.0f;
+    uint32_t m_bPrimary = 0;
+
+    // Models
+    uint32_t m_file = SCENE_INVALID_STRING;     //< Offset in the string table
+    uint32_t m_firstInstance = 0;
+    uint32_t m_instanceCount = 0;               //< 0 : placed once at the transform of the model
+};
+
+// Placement of a model, relative to the transform of the model
+struct SceneInstanceDesc
+{
+    float3 m_position = {0.0f, 0.0f, 0.0f};
+    float3 m_rotation = {0.0f, 0.0f, 0.0f};
+    float3 m_scale = {1.0f, 1.0f, 1.0f};
+};
+
+struct SceneFileHeader
+{
+    uint32_t m_magic;
+    uint32_t m_version;
+    uint32_t m_fileSize;
+    uint32_t m_objectCount;
+    uint32_t m_instanceCount;
+    uint32_t m_stringTableSize;     //< Bytes of the null terminated strings
+    uint32_t m_worldObjectCount;    //< Objects the world has after loading the scene, 0 if not known
+    SceneCameraDesc m_camera;
+};
+
+// Everything a scene file holds, the xml and the binary file are loaded into it before any object is created
+struct SceneDesc
+{
+    SceneCameraDesc m_camera;
+    eastl::vector<SceneObjectDesc> m_objects;
+    eastl::vector<SceneInstanceDesc> m_instances;
+    eastl::string m_strings;            //< String table
+    uint32_t m_worldObjectCount = 0;
+
+    uint32_t AddString(const eastl::string& str);
+    const char* GetString(uint32_t offset) const { return offset < m_strings.size() ? m_strings.c_str() + offset : ""; }
+    void Clear();
+
+private:
+    eastl::hash_map<eastl::string, uint32_t> m_stringOffsets;   //< Only for the strings added with AddString
+};
+
+bool ParseSceneXML(const char* pText, size_t size, SceneDesc& desc);
+eastl::string WriteSceneXML(const SceneDesc& desc);
+
+bool ParseSceneBinary(const void* pData, size_t size, SceneDesc& desc);
+void WriteSceneBinary(const SceneDesc& desc, eastl::vector<uint8_t>& data);
+
+bool IsBinarySceneFile(const eastl::string& file);
+
+// Both read the whole file with one read, then parse it from memory
+bool LoadSceneFile(const eastl::string& file, SceneDesc& desc);
+bool SaveSceneFile(const eastl::string& file, const SceneDesc& desc);
@@ -0,0 +1,112 @@
+#include "SkeletalMesh.h"
+#include "StaticMesh.h"
+#include "MeshMaterial.h"
+#include "WorldObjectData.h"
+#include "Utils/guiUtil.h"
+
+SkeletalMesh::SkeletalMesh(const eastl::string& name)
+{
+    m_name = name;
+}
+
+bool SkeletalMesh::Create()
+{
+    m_skeleton.Finalize();
+
+    uint32_t jointCount = m_skeleton.GetJointCount();
+    m_pose.resize(jointCount);
+    m_globalMatrices.resize(jointCount);
+    m_palette.resize(jointCount);
+
+    // Primitives loaded after this take their bounds from the palette of the first pose
+    UpdateAnimation(0.0f);
+
+    return jointCount > 0;
+}
+
+void SkeletalMesh::Play(uint32_t clip, float time)
+{
+    MY_ASSERT(clip < m_clips.size());
+
+    m_currentClip = clip;
+    m_time = time;
+    m_bPlaying = true;
+}
+
+void SkeletalMesh::UpdateAnimation(float deltaTime)
+{
+    m_skeleton.GetRestPose(m_pose.data());
+
+    if (m_currentClip < m_clips.size())
+    {
+        const AnimationClip& clip = m_clips[m_currentClip];
+        if (m_bPlaying && clip.GetDuration() > 0.0f)
+        {
+            m_time = fmodf(m_time + deltaTime * m_speed, clip.GetDuration());
+            m_time = m_time < 0.0f ? m_time + clip.GetDuration() : m_time;
+        }
+
+        clip.Sample(m_time, m_pose.data());
+    }
+
+    m_skeleton.ComputeGlobalMatrices(m_pose.data(), m_globalMatrices.data());
+    m_skeleton.ComputeSkinningPalette(m_globalMatrices.data(), m_palette.data());
+
+    for (size_t i = 0; i < m_primitives.size(); ++i)
+    {
+        m_primitives[i]->UpdateSkinnedBounds(m_palette.data());
+    }
+}
+
+void SkeletalMesh::Tick(float deltaTime)
+{
+    m_paletteAddress = m_pRenderer->AllocateSceneConstant(m_palette.data(), sizeof(float4x4) * (uint32_t) m_palette.size());
+
+    if (m_bShowSkeleton)
+    {
+        const float4x4& mtxWorld = m_pObjectData->GetWorldMatrix(m_id);
+
+        Im3d::PushMatrix(mtxWorld);
+        for (uint32_t i = 0; i < m_skeleton.GetJointCount(); ++i)
+        {
+            uint32_t parent = m_skeleton.GetJoint(i).m_parent;
+            if (parent != SKELETON_INVALID_JOINT)
+            {
+                Im3d::DrawLine(m_globalMatrices[parent][3].xyz(), m_globalMatrices[i][3].xyz(), 2.0f, Im3d::Color_Yellow);
+            }
+        }
+        Im3d::PopMatrix();
+    }
+}
+
+void SkeletalMesh::OnGUI()
+{
+    IVisibleObject::OnGUI();
+
+    if (ImGui::CollapsingHeader("SkeletalMesh"))
+    {
+        ImGui::Text("%s", m_name.c_str());
+        ImGui::Text("%u joints, %u primitives", m_skeleton.GetJointCount(), (uint32_t) m_primitives.size());
+
+        if (!m_clips.empty())
+        {
+            if (ImGui::BeginCombo("Clip##SkeletalMesh", m_clips[m_currentClip].GetName().c_str()))
+            {
+                for (uint32_t i = 0; i < (uint32_t) m_clips.size(); ++i)
+                {
+                    if (ImGui::Selectable(m_clips[i].GetName().c_str(), i == m_currentClip))
+                    {
+                        Play(i);
+                    }
+                }
+                ImGui::EndCombo();
+            }
+
+            ImGui::SliderFloat("Time##SkeletalMesh", &m_time, 0.0f, m_clips[m_currentClip].GetDuration());
+        }
+
+        ImGui::Checkbox("Playing##SkeletalMesh", &m_bPlaying);
+        ImGui::SliderFloat("Speed##SkeletalMesh", &m_speed, -2.0f, 2.0f);
+        ImGui::Checkbox("Show Skeleton##SkeletalMesh", &m_bShowSkeleton);
+    }
+}
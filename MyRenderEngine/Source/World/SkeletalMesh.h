@@ -0,0 +1,51 @@
+#pragma once
+#include "VisibleObject.h"
+#include "Animation.h"
+
+class StaticMesh;
+
+// Skeleton and animation clips of a glTF skin. Its primitives are child StaticMesh objects skinned with the palette of it,
+// the pose is sampled on worker threads by World::UpdateAnimations and the vertices are skinned by a compute pass before culling
+class SkeletalMesh : public IVisibleObject
+{
+    friend class GLTFLoader;
+public:
+    SkeletalMesh(const eastl::string& name);
+
+    virtual bool Create() override;
+    virtual void Tick(float deltaTime) override;
+    virtual void UpdateAnimation(float deltaTime) override;
+    virtual bool IsAnimated() const override { return true; }
+    virtual void OnGUI() override;
+
+    const Skeleton& GetSkeleton() const { return m_skeleton; }
+    uint32_t GetClipCount() const { return (uint32_t) m_clips.size(); }
+    const AnimationClip& GetClip(uint32_t index) const { return m_clips[index]; }
+
+    void Play(uint32_t clip, float time = 0.0f);
+    void SetPlaying(bool value) { m_bPlaying = value; }
+    void SetSpeed(float value) { m_speed = value; }
+
+    const float4x4* GetPalette() const { return m_palette.data(); }
+    uint32_t GetPaletteAddress() const { return m_paletteAddress; }     //< In the scene constant buffer of this frame
+
+private:
+    Renderer* m_pRenderer = nullptr;
+    eastl::string m_name;
+
+    Skeleton m_skeleton;
+    eastl::vector<AnimationClip> m_clips;
+    eastl::vector<StaticMesh*> m_primitives;    //< Owned by the world
+
+    uint32_t m_currentClip = 0;
+    float m_time = 0.0f;
+    float m_speed = 1.0f;
+    bool m_bPlaying = true;
+
+    eastl::vector<JointTransform> m_pose;
+    eastl::vector<float4x4> m_globalMatrices;
+    eastl::vector<float4x4> m_palette;
+    uint32_t m_paletteAddress = 0;
+
+    bool m_bShowSkeleton = false;
+};
@@ -1,11 +1,15 @@
 #include "StaticMesh.h"
 #include "MeshMaterial.h"
 #include "ResourceCache.h"
+#include "WorldObjectData.h"
+#include "SkeletalMesh.h"
 #include "Core/Engine.h"
 #include "Utils/guiUtil.h"
+#include "Utils/log.h"
 
 #define GPU_DRIVEN_BASE_PASS 1
 #define MESHLET_BASE_PASS 0
+#define MESHLET_SIZE 36     //< Meshlet of Meshlet.hlsli
 
 StaticMesh::StaticMesh(const eastl::string& name)
 {
@@ -27,6 +31,21 @@ StaticMesh::~StaticMesh()
 
     pCache->ReleaseSceneBuffer(m_indexBuffer);
 
+    if (m_pSkeletalMesh)
+    {
+        pCache->ReleaseSceneBuffer(m_jointBuffer);
+        pCache->ReleaseSceneBuffer(m_weightBuffer);
+
+        OffsetAllocator::Allocation animationBuffers[] = { m_animPosBuffer, m_animNormalBuffer, m_animTangentBuffer, m_animMeshletBuffer };
+        for (size_t i = 0; i < eastl::size(animationBuffers); ++i)
+        {
+            if (animationBuffers[i].offset != OffsetAllocator::Allocation::NO_SPACE)
+            {
+                m_pRenderer->FreeSceneAnimationBuffer(animationBuffers[i]);
+            }
+        }
+    }
+
     // todo:
 }
 
@@ -34,9 +53,31 @@ bool StaticMesh::Create()
 {
     // todo: need to cache BLAS for same modules
 
+    bool bSkinned = m_pSkeletalMesh != nullptr;
+    if (bSkinned)
+    {
+        m_animPosBuffer = m_pRenderer->AllocateSceneAnimationBuffer(sizeof(float3) * m_vertexCount);
+        m_animMeshletBuffer = m_pRenderer->AllocateSceneAnimationBuffer(MESHLET_SIZE * m_meshletCount);
+        if (m_normalBuffer.offset != OffsetAllocator::Allocation::NO_SPACE)
+        {
+            m_animNormalBuffer = m_pRenderer->AllocateSceneAnimationBuffer(sizeof(float3) * m_vertexCount);
+        }
+        if (m_tangentBuffer.offset != OffsetAllocator::Allocation::NO_SPACE)
+        {
+            m_animTangentBuffer = m_pRenderer->AllocateSceneAnimationBuffer(sizeof(float4) * m_vertexCount);
+        }
+
+        if (m_animPosBuffer.offset == OffsetAllocator::Allocation::NO_SPACE || m_animMeshletBuffer.offset == OffsetAllocator::Allocation::NO_SPACE)
+        {
+            MY_ERROR("[StaticMesh::Create] {} : out of scene animation buffer", m_name);
+            return false;
+        }
+    }
+
+    // Skinned BLASes are refit every frame from the skinned positions
     RHIRayTracingGeometry geometry;
-    geometry.m_vertexBuffer = m_pRenderer->GetSceneStaticBuffer();
-    geometry.m_vertexBufferOffset = m_posBuffer.offset;
+    geometry.m_vertexBuffer = bSkinned ? m_pRenderer->GetAScenenimationBuffer() : m_pRenderer->GetSceneStaticBuffer();
+    geometry.m_vertexBufferOffset = bSkinned ? m_animPosBuffer.offset : m_posBuffer.offset;
     geometry.m_vertexCount = m_vertexCount;
     geometry.m_vertexStride = sizeof(float3);
     geometry.m_vertexFormat = RHIFormat::RGB32F;
@@ -48,12 +89,33 @@ bool StaticMesh::Create()
 
     RHIRayTracingBLASDesc desc;
     desc.m_geometries.push_back(geometry);
-    desc.m_flags = RHIRayTracingASFlagAllowCompaction | RHIRayTracingASFlagPreferFastTrace;
+    desc.m_flags = bSkinned ? RHIRayTracingASFlagAllowUpdate | RHIRayTracingASFlagPreferFastBuild : RHIRayTracingASFlagAllowCompaction | RHIRayTracingASFlagPreferFastTrace;
 
     IRHIDevice* pDevice = m_pRenderer->GetDevice();
     m_pBLAS.reset(pDevice->CreateRayTracingBLAS(desc, "BLAS : " + m_name));
     m_pRenderer->BuildRayTracingBLAS(m_pBLAS.get());
 
+    // Constants are uploaded to the material table once, and again only when the material is edited
+    m_pMaterial->UpdateConstants();
+
+    // Render is called from worker threads, so the PSOs are created here
+#if GPU_DRIVEN_BASE_PASS
+    m_pMaterial->GetMeshletGPUDrivenPSO();
+    m_pMaterial->GetShowCulledMeshletGPUDrivenPSO();
+#elif MESHLET_BASE_PASS
+    m_pMaterial->GetMeshletPSO();
+#else
+    m_pMaterial->GetPSO();
+#endif
+    m_pMaterial->GetShadowPSO();
+    m_pMaterial->GetVelocityPSO();
+    m_pMaterial->GetIDPSO();
+    m_pMaterial->GetOutlinePSO();
+    if (bSkinned)
+    {
+        m_pMaterial->GetVertexSkinningPSO();
+    }
+
     return true;
 }
 
@@ -63,14 +125,35 @@ void StaticMesh::Tick(float deltaTime)
 
     UpdateConstants();
 
+    // The palette of this frame is uploaded by the skeletal mesh, which is ticked before its children
+    if (m_pSkeletalMesh)
+    {
+        AddSkinningBatch();
+        if (m_skinningReadbackCallback)
+        {
+            ReadbackSkinning();
+        }
+        m_pRenderer->UpdateRayTracingBLAS(m_pBLAS.get(), m_pRenderer->GetAScenenimationBuffer(), m_animPosBuffer.offset);
+    }
+
     RHIRayTracingInstanceFlags flags = m_pMaterial->IsFrontFaceCCW() ? RHIRayTracingInstanceFlagFrontFaceCCW : 0;
     m_instanceIndex = m_pRenderer->AddInstance(m_instanceData, m_pBLAS.get(), flags);
+
+    // Render is called from worker threads, the PSOs of a switched material mode are created here
+#if GPU_DRIVEN_BASE_PASS
+    if (m_pRenderer->IsVisibilityBufferEnabled())
+    {
+        m_pMaterial->GetVisibilityBufferPSO();
+    }
+    m_pMaterial->GetMeshletGPUDrivenPSO();
+    m_pMaterial->GetShowCulledMeshletGPUDrivenPSO();
+#endif
+
+    AddShadowBatch();
 }
 
 void StaticMesh::UpdateConstants()
 {
-    m_pMaterial->UpdateConstants();
-
     m_instanceData.m_instanceType = (uint) InstanceType::Model;
     m_instanceData.m_indexBufferAddress = m_indexBuffer.offset;
     m_instanceData.m_indexStride = m_indexBufferFormat == RHIFormat::R32UI ? 4 : 2;
@@ -87,17 +170,24 @@ void StaticMesh::UpdateConstants()
     m_instanceData.m_tangentBufferAddress = m_tangentBuffer.offset;
 
     m_instanceData.m_bVertexAnimation = false;
-    m_instanceData.m_materialDataAddress = m_pRenderer->AllocateSceneConstant((void*)m_pMaterial->GetConstants(), sizeof(ModelMaterialConstant));
+    if (m_pSkeletalMesh)
+    {
+        m_instanceData.m_meshletBufferAddress = m_animMeshletBuffer.offset;
+        m_instanceData.m_posBufferAddress = m_animPosBuffer.offset;
+        m_instanceData.m_normalBufferAddress = m_animNormalBuffer.offset;
+        m_instanceData.m_tangentBufferAddress = m_animTangentBuffer.offset;
+        m_instanceData.m_bVertexAnimation = true;
+    }
+
+    m_instanceData.m_materialIndex = m_pMaterial->GetMaterialIndex();    //< Changes only when the material is edited
     m_instanceData.m_objectID = m_id;
-    m_instanceData.m_scale = max(max(abs(m_scale.x), abs(m_scale.y)), abs(m_scale.z));
 
-    float4x4 t = translation_matrix(m_pos);
-    float4x4 r = rotation_matrix(m_rotation);
-    float4x4 s = scaling_matrix(m_scale);
-    float4x4 mtxWorld = mul(t, mul(r, s)); //< Scale -> Rotate -> Trasnlate
+    // World matrix and bounds are updated by WorldObjectData::Update in parallel before the tick
+    const float4x4& mtxWorld = m_pObjectData->GetWorldMatrix(m_id);
 
-    m_instanceData.m_center = mul(mtxWorld, float4(m_center, 1.0f)).xyz();
-    m_instanceData.m_radius = m_radius * m_instanceData.m_scale;
+    m_instanceData.m_scale = max(max(length(mtxWorld[0].xyz()), length(mtxWorld[1].xyz())), length(mtxWorld[2].xyz()));
+    m_instanceData.m_center = float3(m_pObjectData->GetCenterX()[m_id], m_pObjectData->GetCenterY()[m_id], m_pObjectData->GetCenterZ()[m_id]);
+    m_instanceData.m_radius = m_pObjectData->GetRadius()[m_id];
     
     m_instanceData.m_bShowBoundingSphere = m_bShowBoundingSphere;
     m_instanceData.m_bShowTangent = m_bShowTangent;
@@ -105,8 +195,142 @@ void StaticMesh::UpdateConstants()
     m_instanceData.m_bShowNormal = m_bShowNormal;
 
     m_instanceData.m_mtxPrevWorld = m_instanceData.m_mtxWorld;
-    m_instanceData.m_mtxWorld = mtxWorld;
-    m_instanceData.m_mtxWorldInverseTranspose = transpose(inverse(mtxWorld));
+    if (m_pObjectData->IsMoved(m_id))
+    {
+        m_instanceData.m_mtxWorld = mtxWorld;
+        m_instanceData.m_mtxWorldInverseTranspose = transpose(inverse(mtxWorld));
+    }
+}
+
+void StaticMesh::UpdateSkinnedBounds(const float4x4* pPalette)
+{
+    // A skinned vertex is a blend of its positions under the joints moving it, which lie in the posed spheres of these joints
+    float3 boundsMin = float3(FLT_MAX, FLT_MAX, FLT_MAX);
+    float3 boundsMax = float3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+    uint32_t jointCount = (uint32_t) m_jointBounds.size();
+    eastl::vector<float4> spheres;
+    spheres.reserve(jointCount);
+
+    for (uint32_t i = 0; i < jointCount; ++i)
+    {
+        if (m_jointBounds[i].w < 0.0f)
+        {
+            continue;
+        }
+
+        const float4x4& mtx = pPalette[i];
+        float scale = max(max(length(mtx[0].xyz()), length(mtx[1].xyz())), length(mtx[2].xyz()));
+        float3 center = mul(mtx, float4(m_jointBounds[i].xyz(), 1.0f)).xyz();
+        float radius = m_jointBounds[i].w * scale;
+
+        boundsMin = min(boundsMin, center - radius);
+        boundsMax = max(boundsMax, center + radius);
+        spheres.push_back(float4(center, radius));
+    }
+
+    if (spheres.empty())
+    {
+        return;
+    }
+
+    m_center = (boundsMin + boundsMax) * 0.5f;
+    m_radius = 0.0f;
+    for (size_t i = 0; i < spheres.size(); ++i)
+    {
+        m_radius = max(m_radius, length(spheres[i].xyz() - m_center) + spheres[i].w);
+    }
+
+    UpdateObjectBounds();
+}
+
+void StaticMesh::AddSkinningBatch()
+{
+    // SkinningConstants of VertexSkining.hlsl
+    uint32_t constants[12] =
+    {
+        m_meshletBuffer.offset,
+        m_meshletVerticesBuffer.offset,
+        m_pSkeletalMesh->GetPaletteAddress(),
+        m_posBuffer.offset,
+
+        m_normalBuffer.offset,
+        m_tangentBuffer.offset,
+        m_jointBuffer.offset,
+        m_weightBuffer.offset,
+
+        m_animPosBuffer.offset,
+        m_animNormalBuffer.offset,
+        m_animTangentBuffer.offset,
+        m_animMeshletBuffer.offset,
+    };
+
+    ComputeBatch& batch = m_pRenderer->AddAnimationBatch();
+    batch.m_label = m_name.c_str();
+    batch.SetPipelineState(m_pMaterial->GetVertexSkinningPSO());
+    batch.SetConstantBuffer(1, constants, sizeof(constants));
+    batch.Dispatch(m_meshletCount, 1, 1);     //< One group per meshlet
+}
+
+void StaticMesh::ReadbackSkinning()
+{
+    // The palette of this frame stays until the next World::Tick, the vertex streams are read from the buffers the skinning pass used
+    uint32_t jointCount = m_pSkeletalMesh->GetSkeleton().GetJointCount();
+    eastl::vector<float4x4> palette(m_pSkeletalMesh->GetPalette(), m_pSkeletalMesh->GetPalette() + jointCount);
+    bool bNormal = m_normalBuffer.offset != OffsetAllocator::Allocation::NO_SPACE;
+
+    IRHIBuffer* pStaticBuffer = m_pRenderer->GetSceneStaticBuffer();
+    IRHIBuffer* pAnimationBuffer = m_pRenderer->GetAScenenimationBuffer();
+
+    eastl::vector<RendererReadbackRange> ranges;
+    ranges.push_back({ pStaticBuffer, m_posBuffer.offset, (uint32_t) sizeof(float3) * m_vertexCount });
+    ranges.push_back({ pStaticBuffer, m_jointBuffer.offset, (uint32_t) sizeof(uint16_t) * SKINNING_MAX_INFLUENCES * m_vertexCount });
+    ranges.push_back({ pStaticBuffer, m_weightBuffer.offset, (uint32_t) sizeof(float4) * m_vertexCount });
+    ranges.push_back({ pAnimationBuffer, m_animPosBuffer.offset, (uint32_t) sizeof(float3) * m_vertexCount });
+    if (bNormal)
+    {
+        ranges.push_back({ pStaticBuffer, m_normalBuffer.offset, (uint32_t) sizeof(float3) * m_vertexCount });
+        ranges.push_back({ pAnimationBuffer, m_animNormalBuffer.offset, (uint32_t) sizeof(float3) * m_vertexCount });
+    }
+
+    uint32_t vertexCount = m_vertexCount;
+    eastl::function<void(const SkinningReadback&)> callback = m_skinningReadbackCallback;
+    m_skinningReadbackCallback = nullptr;
+
+    m_pRenderer->ReadbackAfterAnimationPass(ranges, [=](const eastl::vector<const void*>& data)
+        {
+            SkinningReadback readback;
+            readback.m_vertexCount = vertexCount;
+            readback.m_pPalette = palette.data();
+            readback.m_input.m_pPos = (const float3*) data[0];
+            readback.m_input.m_pJoints = (const uint16_t*) data[1];
+            readback.m_input.m_pWeights = (const float4*) data[2];
+            readback.m_pSkinnedPos = (const float3*) data[3];
+            if (bNormal)
+            {
+                readback.m_input.m_pNormal = (const float3*) data[4];
+                readback.m_pSkinnedNormal = (const float3*) data[5];
+            }
+
+            callback(readback);
+        });
+}
+
+// Casters out of the camera frustum still shadow it, so they are added from Tick for every object
+void StaticMesh::AddShadowBatch()
+{
+    uint32_t rootConsts[2] = {m_instanceIndex, m_meshletCount};
+
+    RenderBatch& batch = m_pRenderer->AddShadowPassBatch();
+    batch.m_label = m_name.c_str();
+    batch.SetPipelineState(m_pMaterial->GetShadowPSO());
+    batch.SetConstantBuffer(0, rootConsts, sizeof(rootConsts));
+
+    batch.m_center = m_instanceData.m_center;
+    batch.m_radius = m_instanceData.m_radius;
+    batch.m_meshletCount = m_meshletCount;
+    batch.m_instaceIndex = m_instanceIndex;
+    batch.DispatchMesh(DivideRoundingUp(m_meshletCount, 32), 1, 1);     //< 32 meshlets per amplification group
 }
 
 void StaticMesh::Render(Renderer* pRenderer)
@@ -114,7 +338,8 @@ void StaticMesh::Render(Renderer* pRenderer)
 #if GPU_DRIVEN_BASE_PASS
     RenderBatch& basePassBatch = pRenderer->AddGPUDrivenBasePassBatch();
     //DispatchGPUDriven(basePassBatch, m_pMaterial->GetMeshletGPUDrivenPSO());
-    DisptachGPUDrivenWithCustomPSO(basePassBatch, m_pMaterial->GetMeshletGPUDrivenPSO(), m_pMaterial->GetShowCulledMeshletGPUDrivenPSO());
+    IRHIPipelineState* pPSO = pRenderer->IsVisibilityBufferEnabled() ? m_pMaterial->GetVisibilityBufferPSO() : m_pMaterial->GetMeshletGPUDrivenPSO();
+    DisptachGPUDrivenWithCustomPSO(basePassBatch, pPSO, m_pMaterial->GetShowCulledMeshletGPUDrivenPSO());
 #elif MESHLET_BASE_PASS
     RenderBatch& basePassBatch = pRenderer->AddBasePassBatch();
     Dispatch(basePassBatch, m_pMaterial->GetMeshletPSO());
@@ -142,9 +367,11 @@ void StaticMesh::Render(Renderer* pRenderer)
     }
 }
 
-bool StaticMesh::FrustumCull(const float4* planes, uint32_t planeCount) const
+bool StaticMesh::GetLocalBounds(float3& center, float& radius) const
 {
-    return ::FrustumCull(planes, planeCount, m_center, m_radius);
+    center = m_center;
+    radius = m_radius;
+    return true;
 }
 
 void StaticMesh::Draw(RenderBatch& batch, IRHIPipelineState* pPSO)
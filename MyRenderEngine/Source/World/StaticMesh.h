@@ -1,15 +1,29 @@
 #pragma once
 #include "Renderer/Renderer.h"
 #include "VisibleObject.h"
+#include "OcclusionCulling.h"
+#include "Animation.h"
 #include "ModelConstants.hlsli"
 
 class MeshMaterial;
+class SkeletalMesh;
 class IPhysicsShape;
 class IPhysicsRigidBody;
 
+// Inputs and outputs of the skinning pass of one frame, as the GPU read and wrote them
+struct SkinningReadback
+{
+    uint32_t m_vertexCount = 0;
+    const float4x4* m_pPalette = nullptr;
+    SkinnedVertexStreams m_input;
+    const float3* m_pSkinnedPos = nullptr;
+    const float3* m_pSkinnedNormal = nullptr;   //< Optional
+};
+
 class StaticMesh : public IVisibleObject
 {
     friend class GLTFLoader;
+    friend class SkeletalMesh;
 public:
     StaticMesh(const eastl::string& name);
     ~StaticMesh();
@@ -17,7 +31,9 @@ public:
     virtual bool Create() override;
     virtual void Tick(float deltaTime) override;
     virtual void Render(Renderer* pRenderer) override;
-    virtual bool FrustumCull(const float4* planes, uint32_t planeCount) const override;
+    virtual bool GetLocalBounds(float3& center, float& radius) const override;
+    virtual bool IsStatic() const override { return m_pSkeletalMesh == nullptr; }
+    virtual const OccluderMesh* GetOccluder() const override { return m_occluder.m_indices.empty() ? nullptr : &m_occluder; }
     virtual void OnGUI() override;
 
     virtual void SetPosition(const float3& pos) override;
@@ -28,9 +44,18 @@ public:
     //void SetPhysicRigidBody(IPhysicsRigidBody* pBody);
     
     MeshMaterial* GetMaterial() const { return m_pMaterial.get(); }
+    bool IsSkinned() const { return m_pSkeletalMesh != nullptr; }
+    const eastl::string& GetName() const { return m_name; }
+
+    // The callback gets the skinning of the next frame once the GPU has finished it, for comparing it with SkinVertices
+    void RequestSkinningReadback(const eastl::function<void(const SkinningReadback&)>& callback) { m_skinningReadbackCallback = callback; }
     
 private:
     void UpdateConstants();
+    void UpdateSkinnedBounds(const float4x4* pPalette);     //< Called from worker threads by SkeletalMesh::UpdateAnimation
+    void AddSkinningBatch();
+    void ReadbackSkinning();
+    void AddShadowBatch();
     void Draw(RenderBatch& batch, IRHIPipelineState* pPSO);
     void Dispatch(RenderBatch& batch, IRHIPipelineState* pPSO);
     void DispatchGPUDriven(RenderBatch& batch, IRHIPipelineState* pPSO);
@@ -53,6 +78,17 @@ private:
     OffsetAllocator::Allocation m_meshletIndicesBuffer;
     uint32_t m_meshletCount = 0;
 
+    // Skinned meshes only, the vertices and meshlets are skinned into the animation buffer every frame
+    SkeletalMesh* m_pSkeletalMesh = nullptr;    //< Parent object, owns the skeleton and the palette
+    OffsetAllocator::Allocation m_jointBuffer;
+    OffsetAllocator::Allocation m_weightBuffer;
+    OffsetAllocator::Allocation m_animPosBuffer;
+    OffsetAllocator::Allocation m_animNormalBuffer;
+    OffsetAllocator::Allocation m_animTangentBuffer;
+    OffsetAllocator::Allocation m_animMeshletBuffer;
+    eastl::vector<float4> m_jointBounds;    //< Bind pose sphere of the vertices each joint moves, negative radius for joints without vertices
+    eastl::function<void(const SkinningReadback&)> m_skinningReadbackCallback;
+
     OffsetAllocator::Allocation m_indexBuffer;
     RHIFormat m_indexBufferFormat;
     uint32_t m_indexCount = 0;
@@ -64,6 +100,8 @@ private:
     float3 m_center = {0.0f, 0.0f, 0.0f};
     float m_radius = 0.0f;
 
+    OccluderMesh m_occluder;    //< Empty for skinned, alpha tested or alpha blended meshes
+
     bool m_bShowBoundingSphere = false;
     bool m_bShowTangent = false;
     bool m_bShowBiTangent = false;
@@ -1,7 +1,34 @@
 #include "VisibleObject.h"
+#include "WorldObjectData.h"
 #include "Utils/guiUtil.h"
 
+void IVisibleObject::SetObjectData(WorldObjectData* pObjectData)
+{
+    m_pObjectData = pObjectData;
+
+    UpdateObjectTransform();
+    UpdateObjectBounds();
+}
+
 void IVisibleObject::OnGUI()
 {
 
+}
+
+void IVisibleObject::UpdateObjectTransform()
+{
+    if (m_pObjectData)
+    {
+        m_pObjectData->SetLocalTransform(m_id, m_pos, m_rotation, m_scale);
+    }
+}
+
+void IVisibleObject::UpdateObjectBounds()
+{
+    float3 center;
+    float radius;
+    if (m_pObjectData && GetLocalBounds(center, radius))
+    {
+        m_pObjectData->SetLocalBounds(m_id, center, radius);
+    }
 }
\ No newline at end of file
@@ -2,6 +2,9 @@
 #include "Renderer/Renderer.h"
 #include "Utils/math.h"
 
+class WorldObjectData;
+struct OccluderMesh;
+
 class IVisibleObject
 {
 public:
@@ -9,21 +12,33 @@ public:
 
     virtual bool Create() = 0;
     virtual void Tick(float DeltaTime) = 0;
-    virtual void Render(Renderer* pRenderer) {}
-    virtual bool FrustumCull(const float4* planes, uint32_t planeCount) const { return true; }
+    virtual void UpdateAnimation(float deltaTime) {}    //< Called from worker threads for animated objects, before the transforms are updated
+    virtual bool IsAnimated() const { return false; }
+    virtual void Render(Renderer* pRenderer) {}     //< Called from worker threads for visible objects
+    virtual bool GetLocalBounds(float3& center, float& radius) const { return false; }
+    virtual bool IsStatic() const { return false; }   //< Static objects are culled with the BVH of the world
+    virtual const OccluderMesh* GetOccluder() const { return nullptr; }    //< Proxy for the CPU occlusion culling, in local space
     virtual void OnGUI();
 
     virtual float3 GetPosition() const { return m_pos; }
-    virtual void SetPosition(const float3& pos) { m_pos = pos; }
+    virtual void SetPosition(const float3& pos) { m_pos = pos; UpdateObjectTransform(); }
     
     virtual quaternion GetRotation() const { return m_rotation; }
-    virtual void SetRotation(const quaternion& rotation) { m_rotation = rotation; }
+    virtual void SetRotation(const quaternion& rotation) { m_rotation = rotation; UpdateObjectTransform(); }
 
     virtual float3 GetScale() const { return m_scale; }
-    virtual void SetScale(const float3& scale) { m_scale = scale; }
+    virtual void SetScale(const float3& scale) { m_scale = scale; UpdateObjectTransform(); }
 
     void SetID(uint32_t id) { m_id = id; }
+    void SetObjectData(WorldObjectData* pObjectData);
+
+protected:
+    // Copy the transform and bounds to the SoA data of the world after they are changed
+    void UpdateObjectTransform();
+    void UpdateObjectBounds();
+
 protected:
+    WorldObjectData* m_pObjectData = nullptr;
     uint32_t m_id = 0;
     float3 m_pos = {0.0f, 0.0f, 0.0f};
     quaternion m_rotation = {0.0f, 0.0f, 0.0f, 1.0f};
@@ -1,5 +1,6 @@
 #include "World.h"
 #include "PointLight.h"
+#include "DirectionalLight.h"
 #include "GLTFLoader.h"
 #include "StaticMesh.h"
 #include "MeshMaterial.h"
@@ -9,9 +10,11 @@
 #include "Utils/log.h"
 #include "Utils/guiUtil.h"
 #include "Utils/parallel_for.h"
-#include "tinyxml2/tinyxml2.h"
 #include "EASTL/atomic.h"
+#include "EASTL/algorithm.h"
+#include "EASTL/sort.h"
 #include "BillboardSprite.h"
+#include "sokol/sokol_time.h"
 
 World::World()
 {
@@ -27,8 +30,10 @@ void World::LoadScene(const eastl::string& file)
 {
     MY_INFO("Loading Scene : {}", file);
 
-    tinyxml2::XMLDocument doc;
-    if(tinyxml2::XML_SUCCESS != doc.LoadFile(file.c_str()))
+    uint64_t startTime = stm_now();
+
+    SceneDesc desc;
+    if (!LoadSceneFile(file, desc))
     {
         MY_ASSERT(false);
         return;
@@ -36,26 +41,47 @@ void World::LoadScene(const eastl::string& file)
 
     ClearScene();
 
-    tinyxml2::XMLNode* pRootNode = doc.FirstChild();
-    MY_ASSERT(pRootNode != nullptr && strcmp(pRootNode->Value(), "scene") == 0);
+    m_sceneDesc = eastl::move(desc);
+    CreateScene();
 
-    for (tinyxml2::XMLElement* pElement = pRootNode->FirstChildElement(); pElement != nullptr; pElement = (tinyxml2::XMLElement*)pElement->NextSibling())
-    {
-        CreateVisibleObject(pElement);
-    }
+    MY_INFO("Scene loaded : {} scene objects, {} world objects in {:.2f} ms", m_sceneDesc.m_objects.size(), m_objects.size(), stm_ms(stm_since(startTime)));
 }
 
 void World::SaveScene(const eastl::string& file)
 {
+    UpdateSceneDesc();
 
+    if (SaveSceneFile(file, m_sceneDesc))
+    {
+        MY_INFO("Scene saved : {}", file);
+    }
 }
 
-void World::AddObject(IVisibleObject* pObject)
+void World::AddObject(IVisibleObject* pObject, IVisibleObject* pParent)
 {
     MY_ASSERT(pObject != nullptr);
 
-    pObject->SetID((uint32_t) m_objects.size());
+    uint32_t parent = WORLD_OBJECT_INVALID_PARENT;
+    if (pParent)
+    {
+        auto iter = eastl::find_if(m_objects.begin(), m_objects.end(), [&](const eastl::unique_ptr<IVisibleObject>& object) { return object.get() == pParent; });
+        MY_ASSERT(iter != m_objects.end());
+        parent = (uint32_t) (iter - m_objects.begin());
+    }
+
+    uint32_t id = m_objectData.Add(parent, pObject->IsStatic());
+    MY_ASSERT(id == m_objects.size());
+
+    pObject->SetID(id);
+    pObject->SetObjectData(&m_objectData);
     m_objects.push_back(eastl::unique_ptr<IVisibleObject>(pObject));
+
+    if (pObject->IsAnimated())
+    {
+        m_animatedObjects.push_back(id);
+    }
+
+    m_bStaticObjectBVHDirty = true;
 }
 
 void World::Tick(float deltaTime)
@@ -66,40 +92,66 @@ void World::Tick(float deltaTime)
 
     m_pCamera->Tick(deltaTime);
 
-    for (auto iter = m_objects.begin(); iter != m_objects.end(); ++iter)
+    // Animated bounds are set before the transforms are updated
+    UpdateAnimations(deltaTime);
+
+    m_objectData.Update();
+
     {
-        (*iter)->Tick(deltaTime);
+        // Objects add their instances to the GPU scene in Tick, which is not thread safe
+        CPU_EVENT("Tick", "World::TickObjects");
+
+        for (auto iter = m_objects.begin(); iter != m_objects.end(); ++iter)
+        {
+            (*iter)->Tick(deltaTime);
+        }
     }
 
-    if (pRenderer->GetOutputType() != RendererOutput::Physics)
+    uint32_t objectCount = (uint32_t) m_objects.size();
+
+    if (pRenderer->GetOutputType() != RendererOutput::Physics && objectCount > 0)
     {
-        eastl::vector<IVisibleObject*> visibleObjects(m_objects.size());
-        eastl::atomic<uint32_t> visibleCount{ 0 };
+        CullObjects();
 
-        ParallelFor((uint32_t)m_objects.size(), [&](uint32_t i)
-            {
-                if (m_objects[i]->FrustumCull(m_pCamera->GetFrustumPlanes(), 6))
-                {                   
-                    // Maybe I should use a temporal vector to store objects every thread 
-                    uint32_t index = visibleCount.fetch_add(1);
-                    visibleObjects[index] = m_objects[i].get();
-                }
-            });
+        if (m_bOcclusionCulling)
+        {
+            CullOccludedObjects();
+        }
+
+        CPU_EVENT("Tick", "World::RenderObjects");
 
-        visibleObjects.resize(visibleCount);
+        uint64_t renderStartTime = stm_now();
+        uint32_t visibleCount = (uint32_t) m_visibleObjects.size();
+        uint32_t chunkCount = DivideRoundingUp(visibleCount, WORLD_OBJECT_CHUNK_SIZE);
 
-        for (auto* iter = visibleObjects.begin(); iter != visibleObjects.end(); ++iter)
+        // Batches are recorded into the lists of the worker threads, see RenderBatchList
+        if (chunkCount > 0)
         {
-            (*iter)->Render(pRenderer);
+            ParallelFor(chunkCount, [&](uint32_t chunk)
+                {
+                    uint32_t begin = chunk * WORLD_OBJECT_CHUNK_SIZE;
+                    uint32_t end = min(begin + WORLD_OBJECT_CHUNK_SIZE, visibleCount);
+
+                    for (uint32_t i = begin; i < end; ++i)
+                    {
+                        m_objects[m_visibleObjects[i]]->Render(pRenderer);
+                    }
+                });
         }
+
+        // Batch recording cost, compare with World/Culling/OcclusionCullingUs when toggling the occlusion culling
+        MICROPROFILE_COUNTER_SET("World/VisibleObjectCount", visibleCount);
+        MICROPROFILE_COUNTER_SET("World/RenderObjectsUs", (int64_t) stm_us(stm_since(renderStartTime)));
     }
 
+    MICROPROFILE_COUNTER_SET("World/ObjectCount", objectCount);
+
     m_pBillboardSpriteRenderer->Render();
 }
 
 IVisibleObject* World::GetVisibleObject(uint32_t index) const
 {
-    if (index > m_objects.size())
+    if (index >= m_objects.size())
     {
         MY_ASSERT(false);
         return nullptr;
@@ -108,107 +160,250 @@ IVisibleObject* World::GetVisibleObject(uint32_t index) const
     return m_objects[index].get();
 }
 
-void World::ClearScene()
+void World::UpdateAnimations(float deltaTime)
 {
-    m_objects.clear();
-}
+    CPU_EVENT("Tick", "World::UpdateAnimations");
 
-inline float3 str_to_float3(const eastl::string& str)
-{
-    eastl::vector<float> v;
-    v.reserve(3);
-    string_to_float_array(str, v);
-    return float3(v[0], v[1], v[2]);
+    uint32_t animatedCount = (uint32_t) m_animatedObjects.size();
+    if (animatedCount > 0)
+    {
+        // Poses and palettes of the objects are independent, one task per object
+        ParallelFor(animatedCount, [&](uint32_t i)
+            {
+                m_objects[m_animatedObjects[i]]->UpdateAnimation(deltaTime);
+            });
+    }
+
+    MICROPROFILE_COUNTER_SET("World/AnimatedObjectCount", animatedCount);
 }
 
-inline void LoadVisibleObject(tinyxml2::XMLElement* pElement, IVisibleObject* pObject)
+void World::CullObjects()
 {
-    const tinyxml2::XMLAttribute* pPosition = pElement->FindAttribute("position");
-    if (pPosition)
-    {
-        pObject->SetPosition(str_to_float3(pPosition->Value()));
-    }
+    CPU_EVENT("Tick", "World::CullObjects");
+
+    uint64_t startTime = stm_now();
+
+    const float4* pPlanes = m_pCamera->GetFrustumPlanes();
+    const float* pCenterX = m_objectData.GetCenterX();
+    const float* pCenterY = m_objectData.GetCenterY();
+    const float* pCenterZ = m_objectData.GetCenterZ();
+    const float* pRadius = m_objectData.GetRadius();
 
-    const tinyxml2::XMLAttribute* pRotation = pElement->FindAttribute("rotation");
-    if (pRotation)
+    uint32_t objectCount = (uint32_t) m_objects.size();
+    uint32_t testedCount = 0;
+
+    m_visibleObjects.clear();
+
+    if (m_bBVHCulling)
     {
-        pObject->SetRotation(rotation_quat(str_to_float3(pRotation->Value())));
-    }
+        if (m_bStaticObjectBVHDirty || m_objectData.IsStaticObjectMoved())
+        {
+            m_staticObjectBVH.Build(m_objectData);
+            m_bStaticObjectBVHDirty = false;
 
-    const tinyxml2::XMLAttribute* pScale = pElement->FindAttribute("scale");
-    if (pScale)
+            m_dynamicObjects.clear();
+            for (uint32_t i = 0; i < objectCount; ++i)
+            {
+                if (!m_objectData.IsStatic(i) || !m_objectData.IsBounded(i))
+                {
+                    m_dynamicObjects.push_back(i);
+                }
+            }
+        }
+
+        testedCount = m_staticObjectBVH.Cull(pPlanes, 6, m_visibleObjects);
+
+        for (size_t i = 0; i < m_dynamicObjects.size(); ++i)
+        {
+            uint32_t id = m_dynamicObjects[i];
+            if (FrustumCull(pPlanes, 6, float3(pCenterX[id], pCenterY[id], pCenterZ[id]), pRadius[id]))
+            {
+                m_visibleObjects.push_back(id);
+            }
+        }
+        testedCount += (uint32_t) m_dynamicObjects.size();
+    }
+    else
     {
-        pObject->SetScale(str_to_float3(pScale->Value()));
+        m_visibleObjects.resize(objectCount);
+        uint32_t visibleCount = FrustumCull(pPlanes, 6, pCenterX, pCenterY, pCenterZ, pRadius, objectCount, m_visibleObjects.data());
+        m_visibleObjects.resize(visibleCount);
+        testedCount = objectCount;
     }
+
+    double cullingTime = stm_us(stm_since(startTime));
+
+    MICROPROFILE_COUNTER_SET("World/Culling/TestedObjects", testedCount);
+    MICROPROFILE_COUNTER_SET("World/Culling/ObjectsPerMicrosecond", cullingTime > 0.0 ? (int64_t) (objectCount / cullingTime) : 0);
 }
 
-void World::CreateVisibleObject(tinyxml2::XMLElement* pElement)
+void World::CullOccludedObjects()
 {
-    if (strcmp(pElement->Value(), "camera") == 0)
+    CPU_EVENT("Tick", "World::CullOccludedObjects");
+
+    uint64_t startTime = stm_now();
+
+    const float* pCenterX = m_objectData.GetCenterX();
+    const float* pCenterY = m_objectData.GetCenterY();
+    const float* pCenterZ = m_objectData.GetCenterZ();
+    const float* pRadius = m_objectData.GetRadius();
+
+    float3 cameraPos = m_pCamera->GetPosition();
+    auto screenSize = [&](uint32_t id)
+    {
+        return pRadius[id] / max(length(float3(pCenterX[id], pCenterY[id], pCenterZ[id]) - cameraPos), m_pCamera->GetZNear());
+    };
+
+    // The largest visible occluders on the screen
+    m_occluders.clear();
+    for (size_t i = 0; i < m_visibleObjects.size(); ++i)
     {
-        CreateCamera(pElement);
+        uint32_t id = m_visibleObjects[i];
+        if (m_objectData.IsBounded(id) && m_objects[id]->GetOccluder() != nullptr && screenSize(id) > OCCLUSION_OCCLUDER_MIN_SIZE)
+        {
+            m_occluders.push_back(id);
+        }
     }
-    else if (strcmp(pElement->Value(), "model") == 0)
+
+    if (m_occluders.size() > OCCLUSION_MAX_OCCLUDERS)
     {
-        CreateModel(pElement);
+        eastl::partial_sort(m_occluders.begin(), m_occluders.begin() + OCCLUSION_MAX_OCCLUDERS, m_occluders.end(),
+            [&](uint32_t a, uint32_t b) { return screenSize(a) > screenSize(b); });
+        m_occluders.resize(OCCLUSION_MAX_OCCLUDERS);
     }
-    else if (strcmp(pElement->Value(), "light") == 0)
+
+    uint32_t occluderCount = (uint32_t) m_occluders.size();
+    uint32_t triangleCount = 0;
+    uint32_t occludedCount = 0;
+
+    if (occluderCount > 0)
     {
-        CreateLight(pElement);
+        // Same aspect ratio as the screen
+        const float4x4& mtxProjection = m_pCamera->GetNonJitterProjectionMatrix();
+        m_occlusionBuffer.Resize(OCCLUSION_BUFFER_WIDTH, (uint32_t) (OCCLUSION_BUFFER_WIDTH * mtxProjection[0][0] / mtxProjection[1][1]));
+        m_occlusionBuffer.Begin(m_pCamera->GetViewMatrix(), mtxProjection, occluderCount);
+
+        ParallelFor(occluderCount, [&](uint32_t i)
+            {
+                uint32_t id = m_occluders[i];
+                m_occlusionBuffer.SetupOccluder(i, m_objectData.GetWorldMatrix(id), *m_objects[id]->GetOccluder());
+            });
+
+        m_occlusionBuffer.Rasterize();
+        triangleCount = m_occlusionBuffer.GetTriangleCount();
+
+        uint32_t visibleCount = (uint32_t) m_visibleObjects.size();
+        m_occludedFlags.resize(visibleCount);
+
+        ParallelFor(DivideRoundingUp(visibleCount, WORLD_OBJECT_CHUNK_SIZE), [&](uint32_t chunk)
+            {
+                uint32_t begin = chunk * WORLD_OBJECT_CHUNK_SIZE;
+                uint32_t end = min(begin + WORLD_OBJECT_CHUNK_SIZE, visibleCount);
+
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    uint32_t id = m_visibleObjects[i];
+                    m_occludedFlags[i] = m_objectData.IsBounded(id) && m_occlusionBuffer.IsOccluded(float3(pCenterX[id], pCenterY[id], pCenterZ[id]), pRadius[id]);
+                }
+            });
+
+        // Keeps the order of m_visibleObjects
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < visibleCount; ++i)
+        {
+            if (!m_occludedFlags[i])
+            {
+                m_visibleObjects[count++] = m_visibleObjects[i];
+            }
+        }
+        m_visibleObjects.resize(count);
+        occludedCount = visibleCount - count;
     }
+
+    MICROPROFILE_COUNTER_SET("World/Culling/Occluders", occluderCount);
+    MICROPROFILE_COUNTER_SET("World/Culling/OccluderTriangles", triangleCount);
+    MICROPROFILE_COUNTER_SET("World/Culling/OccludedObjects", occludedCount);
+    MICROPROFILE_COUNTER_SET("World/Culling/OcclusionCullingUs", (int64_t) stm_us(stm_since(startTime)));
 }
 
-inline void LoadLight(tinyxml2::XMLElement* pElement, ILight* pLight)
+void World::ClearScene()
 {
-    LoadVisibleObject(pElement, pLight);
+    m_pPrimaryLight = nullptr;
+    m_sceneDesc.Clear();
+    m_sceneObjectIDs.clear();
 
-    const tinyxml2::XMLAttribute* pIntensity = pElement->FindAttribute("intensity");
-    if (pIntensity)
-    {
-        pLight->SetLightIntensity(pIntensity->FloatValue());
-    }
+    m_objects.clear();
+    m_objectData.Clear();
+    m_animatedObjects.clear();
+    m_staticObjectBVH.Clear();
+    m_bStaticObjectBVHDirty = true;
+}
 
-    const tinyxml2::XMLAttribute* pColor = pElement->FindAttribute("color");
-    if (pColor)
-    {
-        pLight->SetLightColor(str_to_float3(pColor->Value()));
-    }
+void World::CreateScene()
+{
+    CreateCamera(m_sceneDesc.m_camera);
 
-    const tinyxml2::XMLAttribute* pRadius = pElement->FindAttribute("radius");
-    if (pRadius)
+    // Saved scenes know how many objects the models expand to
+    if (m_sceneDesc.m_worldObjectCount > 0)
     {
-        pLight->SetLightRadius(pRadius->FloatValue());
+        m_objects.reserve(m_sceneDesc.m_worldObjectCount);
+        m_objectData.Reserve(m_sceneDesc.m_worldObjectCount);
     }
 
-    const tinyxml2::XMLAttribute* pFalloff = pElement->FindAttribute("falloff");
-    if (pFalloff)
+    m_sceneObjectIDs.reserve(m_sceneDesc.m_objects.size() + 1);
+
+    for (size_t i = 0; i < m_sceneDesc.m_objects.size(); ++i)
     {
-        pLight->SetLightFalloff(pFalloff->FloatValue());
+        const SceneObjectDesc& object = m_sceneDesc.m_objects[i];
+        m_sceneObjectIDs.push_back((uint32_t) m_objects.size());
+
+        if (object.m_type == SceneObjectType::Model)
+        {
+            CreateModel(object);
+        }
+        else
+        {
+            CreateLight(object);
+        }
     }
+
+    m_sceneObjectIDs.push_back((uint32_t) m_objects.size());
 }
 
-void World::CreateLight(tinyxml2::XMLElement* pElement)
+inline float4x4 GetSceneTransform(const float3& position, const float3& rotation, const float3& scale)
 {
-    ILight* pLight = nullptr;
+    float4x4 T = translation_matrix(position);
+    float4x4 R = rotation_matrix(rotation_quat(rotation));
+    float4x4 S = scaling_matrix(scale);
+    return mul(T, mul(R, S));
+}
 
-    const tinyxml2::XMLAttribute* pType = pElement->FindAttribute("type");
-    MY_ASSERT(pType != nullptr);
+void World::CreateLight(const SceneObjectDesc& desc)
+{
+    ILight* pLight = nullptr;
 
-    if (strcmp(pType->Value(), "directional") == 0)
+    if (desc.m_type == SceneObjectType::DirectionalLight)
     {
-        return;
+        pLight = new DirectionalLight();
     }
-    else if (strcmp(pType->Value(), "point") == 0)
+    else if (desc.m_type == SceneObjectType::PointLight)
     {
         pLight = new PointLight();
     }
     else
     {
         MY_ASSERT(false);
+        return;
     }
 
     // Load light data
-    LoadLight(pElement, pLight);
+    pLight->SetPosition(desc.m_position);
+    pLight->SetRotation(rotation_quat(desc.m_rotation));
+    pLight->SetScale(desc.m_scale);
+    pLight->SetLightIntensity(desc.m_intensity);
+    pLight->SetLightColor(desc.m_color);
+    pLight->SetLightRadius(desc.m_radius);
+    pLight->SetLightFalloff(desc.m_falloff);
 
     if (!pLight->Create())
     {
@@ -218,40 +413,114 @@ void World::CreateLight(tinyxml2::XMLElement* pElement)
 
     AddObject(pLight);
 
-    const tinyxml2::XMLAttribute* pPrimary = pElement->FindAttribute("primary");
-    if (pPrimary && pPrimary->BoolValue())
+    // The first sun is the primary light if the scene doesn't mark one
+    if (desc.m_bPrimary || (m_pPrimaryLight == nullptr && desc.m_type == SceneObjectType::DirectionalLight))
     {
         m_pPrimaryLight = pLight;
     }
-
 }
 
-void World::CreateCamera(tinyxml2::XMLElement* pElement)
+void World::CreateCamera(const SceneCameraDesc& desc)
 {
-    const tinyxml2::XMLAttribute* pPosition = pElement->FindAttribute("position");
-    if (pPosition)
-    {
-        m_pCamera->SetPosition(str_to_float3(pPosition->Value()));
-    }
-
-    const tinyxml2::XMLAttribute* pRotation = pElement->FindAttribute("rotation");
-    if (pRotation)
-    {
-        m_pCamera->SetRotation(str_to_float3(pRotation->Value()));
-    }
+    m_pCamera->SetPosition(desc.m_position);
+    m_pCamera->SetRotation(desc.m_rotation);
 
     Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
     uint32_t windowWidth = pRenderer->GetRenderWidth();
     uint32_t windowHeight = pRenderer->GetRenderHeight();
 
-    m_pCamera->SetPerspective((float) windowWidth / windowHeight, pElement->FindAttribute("fov")->FloatValue(), pElement->FindAttribute("znear")->FloatValue());
+    m_pCamera->SetPerspective((float) windowWidth / windowHeight, desc.m_fov, desc.m_znear);
 }
 
-void World::CreateModel(tinyxml2::XMLElement* pElement)
+void World::CreateModel(const SceneObjectDesc& desc)
 {
     // Load GLTF 
     GLTFLoader loader(this);
-    loader.LoadSetting(pElement);
+    loader.LoadSetting(m_sceneDesc.GetString(desc.m_file), GetSceneTransform(desc.m_position, desc.m_rotation, desc.m_scale));
+
+    for (uint32_t i = 0; i < desc.m_instanceCount; ++i)
+    {
+        const SceneInstanceDesc& instance = m_sceneDesc.m_instances[desc.m_firstInstance + i];
+        loader.AddInstance(GetSceneTransform(instance.m_position, instance.m_rotation, instance.m_scale));
+    }
+
     loader.Load();
 }
 
+// Smallest sphere around both spheres, w : radius
+inline float4 MergeSphere(const float4& a, const float4& b)
+{
+    if (a.w <= 0.0f)
+    {
+        return b;
+    }
+
+    float3 offset = b.xyz() - a.xyz();
+    float distance = length(offset);
+
+    if (distance + b.w <= a.w)
+    {
+        return a;
+    }
+
+    if (distance + a.w <= b.w)
+    {
+        return b;
+    }
+
+    float radius = (distance + a.w + b.w) * 0.5f;
+    float3 center = a.xyz() + offset * ((radius - a.w) / distance);
+    return float4(center, radius);
+}
+
+void World::UpdateSceneDesc()
+{
+    SceneCameraDesc& camera = m_sceneDesc.m_camera;
+    camera.m_position = m_pCamera->GetPosition();
+    camera.m_rotation = m_pCamera->GetRotation();
+    camera.m_fov = m_pCamera->GetFOV();
+    camera.m_znear = m_pCamera->GetZNear();
+
+    m_sceneDesc.m_worldObjectCount = (uint32_t) m_objects.size();
+
+    const float* pCenterX = m_objectData.GetCenterX();
+    const float* pCenterY = m_objectData.GetCenterY();
+    const float* pCenterZ = m_objectData.GetCenterZ();
+    const float* pRadius = m_objectData.GetRadius();
+
+    for (size_t i = 0; i < m_sceneDesc.m_objects.size(); ++i)
+    {
+        SceneObjectDesc& object = m_sceneDesc.m_objects[i];
+        uint32_t firstID = m_sceneObjectIDs[i];
+        uint32_t endID = m_sceneObjectIDs[i + 1];
+
+        float4 bounds = float4(0.0f, 0.0f, 0.0f, 0.0f);
+        for (uint32_t id = firstID; id < endID; ++id)
+        {
+            if (m_objectData.IsBounded(id))
+            {
+                bounds = MergeSphere(bounds, float4(pCenterX[id], pCenterY[id], pCenterZ[id], pRadius[id]));
+            }
+        }
+        object.m_bounds = bounds;
+
+        // Lights can be edited, models are saved as they were placed
+        ILight* pLight = object.m_type != SceneObjectType::Model && endID > firstID ? dynamic_cast<ILight*>(m_objects[firstID].get()) : nullptr;
+        if (pLight)
+        {
+            object.m_position = pLight->GetPosition();
+            object.m_scale = pLight->GetScale();
+            object.m_color = pLight->GetLightColor();
+            object.m_intensity = pLight->GetLightIntensity();
+            object.m_radius = pLight->GetLightRadius();
+            object.m_falloff = pLight->GetLightFalloff();
+            object.m_bPrimary = pLight == m_pPrimaryLight ? 1 : 0;
+
+            // Keeps the angles of the file unless the light is rotated, both give the same quaternion
+            if (!nearly_equal(rotation_quat(object.m_rotation), pLight->GetRotation()))
+            {
+                object.m_rotation = rotation_angles(pLight->GetRotation());
+            }
+        }
+    }
+}
@@ -3,11 +3,10 @@
 #include "Camera.h"
 #include "Light.h"
 #include "VisibleObject.h"
-
-namespace tinyxml2
-{
-    class XMLElement;
-}
+#include "WorldObjectData.h"
+#include "WorldObjectBVH.h"
+#include "OcclusionCulling.h"
+#include "SceneFile.h"
 
 class World
 {
@@ -16,29 +15,62 @@ public:
     ~World();
 
     Camera* GetCamera() const { return m_pCamera.get(); }
+    ILight* GetPrimaryLight() const { return m_pPrimaryLight; }
     class BillboardSpriteRenderer* GetBillboardSpriteRenderer() const { return m_pBillboardSpriteRenderer.get(); }
 
-    void LoadScene(const eastl::string& file);
+    void LoadScene(const eastl::string& file);     //< Binary if it ends with SCENE_FILE_EXTENSION, otherwise xml
     void SaveScene(const eastl::string& file);
 
-    void AddObject(IVisibleObject* pObject);
+    void AddObject(IVisibleObject* pObject, IVisibleObject* pParent = nullptr);    //< Parent must be added before its children
 
     void Tick(float deltaTime);
 
     IVisibleObject* GetVisibleObject(uint32_t index) const;
+    uint32_t GetVisibleObjectCount() const { return (uint32_t) m_objects.size(); }
+
+    bool IsBVHCullingEnabled() const { return m_bBVHCulling; }
+    void SetBVHCullingEnabled(bool value)
+    {
+        // Static objects may have moved while the BVH wasn't updated
+        m_bStaticObjectBVHDirty |= value && !m_bBVHCulling;
+        m_bBVHCulling = value;
+    }
+
+    bool IsOcclusionCullingEnabled() const { return m_bOcclusionCulling; }
+    void SetOcclusionCullingEnabled(bool value) { m_bOcclusionCulling = value; }
 
 private:
     void ClearScene();
+    void UpdateAnimations(float deltaTime);
+    void CullObjects();
+    void CullOccludedObjects();     //< Removes the objects hidden by the largest occluders on the screen from m_visibleObjects
 
-    void CreateVisibleObject(tinyxml2::XMLElement* pElement);       
-    void CreateLight(tinyxml2::XMLElement* pElement);
-    void CreateCamera(tinyxml2::XMLElement* pElement);
-    void CreateModel(tinyxml2::XMLElement* pElement);           //< Load GLTF file
+    void CreateScene();
+    void CreateLight(const SceneObjectDesc& desc);
+    void CreateCamera(const SceneCameraDesc& desc);
+    void CreateModel(const SceneObjectDesc& desc);      //< Load GLTF file
+    void UpdateSceneDesc();     //< Copies the objects back to the records they were created from
 private:
     eastl::unique_ptr<Camera> m_pCamera;
     eastl::unique_ptr<class BillboardSpriteRenderer> m_pBillboardSpriteRenderer;
     
     eastl::vector<eastl::unique_ptr<IVisibleObject>> m_objects;
+    WorldObjectData m_objectData;   //< Same order as m_objects
+
+    WorldObjectBVH m_staticObjectBVH;
+    eastl::vector<uint32_t> m_dynamicObjects;   //< Objects which are not in the BVH
+    eastl::vector<uint32_t> m_visibleObjects;
+    eastl::vector<uint32_t> m_animatedObjects;
+    bool m_bBVHCulling = true;
+    bool m_bOcclusionCulling = false;
+
+    OcclusionBuffer m_occlusionBuffer;
+    eastl::vector<uint32_t> m_occluders;
+    eastl::vector<uint8_t> m_occludedFlags;     //< Of m_visibleObjects
+    bool m_bStaticObjectBVHDirty = true;
 
     ILight* m_pPrimaryLight = nullptr;
+
+    SceneDesc m_sceneDesc;
+    eastl::vector<uint32_t> m_sceneObjectIDs;   //< First world object created by every scene object, the object count at the end
 };
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include "WorldObjectBVH.h"
+#include "WorldObjectData.h"
+#include "Utils/profiler.h"
+#include "EASTL/sort.h"
+
+static const uint32_t BVH_LEAF_SIZE = 32;   //< Multiple of the SIMD width of FrustumCull
+
+void WorldObjectBVH::Build(const WorldObjectData& objectData)
+{
+    CPU_EVENT("Tick", "WorldObjectBVH::Build");
+
+    Clear();
+
+    for (uint32_t i = 0; i < objectData.GetCount(); ++i)
+    {
+        if (objectData.IsStatic(i) && objectData.IsBounded(i))
+        {
+            m_objectIDs.push_back(i);
+        }
+    }
+
+    uint32_t count = (uint32_t) m_objectIDs.size();
+    if (count == 0)
+    {
+        return;
+    }
+
+    m_nodes.reserve(DivideRoundingUp(count, BVH_LEAF_SIZE) * 2);
+    BuildNode(objectData, 0, count);
+
+    // Bounds in tree order, so the leaves are culled from contiguous ranges
+    m_centerX.resize(count);
+    m_centerY.resize(count);
+    m_centerZ.resize(count);
+    m_radius.resize(count);
+
+    const float* pCenterX = objectData.GetCenterX();
+    const float* pCenterY = objectData.GetCenterY();
+    const float* pCenterZ = objectData.GetCenterZ();
+    const float* pRadius = objectData.GetRadius();
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint32_t id = m_objectIDs[i];
+        m_centerX[i] = pCenterX[id];
+        m_centerY[i] = pCenterY[id];
+        m_centerZ[i] = pCenterZ[id];
+        m_radius[i] = pRadius[id];
+    }
+}
+
+void WorldObjectBVH::Clear()
+{
+    m_nodes.clear();
+    m_objectIDs.clear();
+    m_centerX.clear();
+    m_centerY.clear();
+    m_centerZ.clear();
+    m_radius.clear();
+}
+
+uint32_t WorldObjectBVH::BuildNode(const WorldObjectData& objectData, uint32_t first, uint32_t count)
+{
+    uint32_t nodeIndex = (uint32_t) m_nodes.size();
+    m_nodes.push_back();
+
+    const float* pCenterX = objectData.GetCenterX();
+    const float* pCenterY = objectData.GetCenterY();
+    const float* pCenterZ = objectData.GetCenterZ();
+    const float* pRadius = objectData.GetRadius();
+
+    float3 boundsMin = float3(FLT_MAX, FLT_MAX, FLT_MAX);
+    float3 boundsMax = float3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    float3 centerMin = boundsMin;
+    float3 centerMax = boundsMax;
+
+    for (uint32_t i = first; i < first + count; ++i)
+    {
+        uint32_t id = m_objectIDs[i];
+        float3 center = float3(pCenterX[id], pCenterY[id], pCenterZ[id]);
+        boundsMin = min(boundsMin, center - pRadius[id]);
+        boundsMax = max(boundsMax, center + pRadius[id]);
+        centerMin = min(centerMin, center);
+        centerMax = max(centerMax, center);
+    }
+
+    uint32_t rightChild = 0;
+    if (count > BVH_LEAF_SIZE)
+    {
+        // Median split along the longest axis of the centers, the object IDs of the node are partitioned in place
+        float3 extent = centerMax - centerMin;
+        uint32_t axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        const float* pAxisCenter = axis == 0 ? pCenterX : (axis == 1 ? pCenterY : pCenterZ);
+
+        uint32_t half = count / 2;
+        eastl::nth_element(m_objectIDs.begin() + first, m_objectIDs.begin() + first + half, m_objectIDs.begin() + first + count, [&](uint32_t left, uint32_t right)
+            {
+                return pAxisCenter[left] < pAxisCenter[right];
+            });
+
+        BuildNode(objectData, first, half);
+        rightChild = BuildNode(objectData, first + half, count - half);
+    }
+
+    Node& node = m_nodes[nodeIndex];
+    node.m_min = boundsMin;
+    node.m_max = boundsMax;
+    node.m_first = first;
+    node.m_count = count;
+    node.m_rightChild = rightChild;
+
+    return nodeIndex;
+}
+
+uint32_t WorldObjectBVH::Cull(const float4* planes, uint32_t planeCount, eastl::vector<uint32_t>& visibleObjects) const
+{
+    if (m_nodes.empty())
+    {
+        return 0;
+    }
+
+    uint32_t testedCount = 0;
+    uint32_t visibleIndices[BVH_LEAF_SIZE];
+
+    uint32_t stack[64];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        uint32_t nodeIndex = stack[--stackSize];
+        const Node& node = m_nodes[nodeIndex];
+
+        bool bFullyInside;
+        if (!FrustumCull(planes, planeCount, node.m_min, node.m_max, bFullyInside))
+        {
+            continue;
+        }
+
+        if (bFullyInside)
+        {
+            visibleObjects.insert(visibleObjects.end(), m_objectIDs.begin() + node.m_first, m_objectIDs.begin() + node.m_first + node.m_count);
+        }
+        else if (node.m_rightChild == 0)
+        {
+            uint32_t first = node.m_first;
+            uint32_t visibleCount = FrustumCull(planes, planeCount, &m_centerX[first], &m_centerY[first], &m_centerZ[first], &m_radius[first], node.m_count, visibleIndices);
+            for (uint32_t i = 0; i < visibleCount; ++i)
+            {
+                visibleObjects.push_back(m_objectIDs[first + visibleIndices[i]]);
+            }
+
+            testedCount += node.m_count;
+        }
+        else
+        {
+            MY_ASSERT(stackSize + 2 <= 64);
+            stack[stackSize++] = node.m_rightChild;
+            stack[stackSize++] = nodeIndex + 1;
+        }
+    }
+
+    return testedCount;
+}
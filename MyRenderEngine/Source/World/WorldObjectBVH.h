@@ -0,0 +1,40 @@
+#pragma once
+#include "Utils/math.h"
+#include "EASTL/vector.h"
+
+class WorldObjectData;
+
+// BVH over the bounding spheres of static world objects, whole subtrees are accepted or rejected by the frustum
+class WorldObjectBVH
+{
+public:
+    void Build(const WorldObjectData& objectData);
+    void Clear();
+
+    bool IsEmpty() const { return m_nodes.empty(); }
+    uint32_t GetObjectCount() const { return (uint32_t) m_objectIDs.size(); }
+
+    // Appends the IDs of visible objects, returns the number of spheres tested in leaves
+    uint32_t Cull(const float4* planes, uint32_t planeCount, eastl::vector<uint32_t>& visibleObjects) const;
+
+private:
+    uint32_t BuildNode(const WorldObjectData& objectData, uint32_t first, uint32_t count);
+
+private:
+    struct Node
+    {
+        float3 m_min;
+        uint32_t m_first;       //< First object of the subtree
+        float3 m_max;
+        uint32_t m_count;       //< Object count of the subtree
+        uint32_t m_rightChild;  //< Left child is the next node, 0 for leaves
+    };
+    eastl::vector<Node> m_nodes;
+
+    // Bounds of the objects in tree order, every subtree is a contiguous range
+    eastl::vector<uint32_t> m_objectIDs;
+    eastl::vector<float> m_centerX;
+    eastl::vector<float> m_centerY;
+    eastl::vector<float> m_centerZ;
+    eastl::vector<float> m_radius;
+};
@@ -0,0 +1,172 @@
+#include "WorldObjectData.h"
+#include "Utils/parallel_for.h"
+#include "Utils/profiler.h"
+#include "EASTL/atomic.h"
+
+uint32_t WorldObjectData::Add(uint32_t parent, bool bStatic)
+{
+    uint32_t id = GetCount();
+    MY_ASSERT(parent == WORLD_OBJECT_INVALID_PARENT || parent < id);
+
+    uint32_t depth = parent == WORLD_OBJECT_INVALID_PARENT ? 0 : m_depths[parent] + 1;
+    if (depth >= m_levels.size())
+    {
+        m_levels.resize(depth + 1);
+    }
+    m_levels[depth].push_back(id);
+
+    m_positions.push_back(float3(0.0f, 0.0f, 0.0f));
+    m_rotations.push_back(quaternion(0.0f, 0.0f, 0.0f, 1.0f));
+    m_scales.push_back(float3(1.0f, 1.0f, 1.0f));
+    m_localBounds.push_back(float4(0.0f, 0.0f, 0.0f, 0.0f));
+    m_parents.push_back(parent);
+    m_flags.push_back(bStatic ? WorldObjectFlagDirty | WorldObjectFlagStatic : WorldObjectFlagDirty);
+    m_depths.push_back(depth);
+
+    m_worldMatrices.push_back(identity);
+    m_centerX.push_back(0.0f);
+    m_centerY.push_back(0.0f);
+    m_centerZ.push_back(0.0f);
+    m_radius.push_back(FLT_MAX);
+
+    return id;
+}
+
+void WorldObjectData::Reserve(uint32_t count)
+{
+    m_positions.reserve(count);
+    m_rotations.reserve(count);
+    m_scales.reserve(count);
+    m_localBounds.reserve(count);
+    m_parents.reserve(count);
+    m_flags.reserve(count);
+    m_depths.reserve(count);
+
+    m_worldMatrices.reserve(count);
+    m_centerX.reserve(count);
+    m_centerY.reserve(count);
+    m_centerZ.reserve(count);
+    m_radius.reserve(count);
+}
+
+void WorldObjectData::Clear()
+{
+    m_positions.clear();
+    m_rotations.clear();
+    m_scales.clear();
+    m_localBounds.clear();
+    m_parents.clear();
+    m_flags.clear();
+    m_depths.clear();
+
+    m_worldMatrices.clear();
+    m_centerX.clear();
+    m_centerY.clear();
+    m_centerZ.clear();
+    m_radius.clear();
+
+    m_levels.clear();
+    m_bStaticObjectMoved = false;
+}
+
+void WorldObjectData::SetLocalTransform(uint32_t id, const float3& pos, const quaternion& rotation, const float3& scale)
+{
+    m_positions[id] = pos;
+    m_rotations[id] = rotation;
+    m_scales[id] = scale;
+    m_flags[id] |= WorldObjectFlagDirty;
+}
+
+void WorldObjectData::SetLocalBounds(uint32_t id, const float3& center, float radius)
+{
+    float4 bounds(center, radius);
+    if ((m_flags[id] & WorldObjectFlagBounded) && m_localBounds[id] == bounds)
+    {
+        return;
+    }
+
+    m_localBounds[id] = bounds;
+    m_flags[id] |= WorldObjectFlagDirty | WorldObjectFlagBounded;
+}
+
+void WorldObjectData::Update()
+{
+    CPU_EVENT("Tick", "WorldObjectData::Update");
+
+    uint32_t count = GetCount();
+
+    // Parents are stored before their children, so one linear pass propagates the dirty flags down the hierarchy
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        m_flags[i] &= ~WorldObjectFlagMoved;
+
+        uint32_t parent = m_parents[i];
+        if (parent != WORLD_OBJECT_INVALID_PARENT && (m_flags[parent] & WorldObjectFlagDirty))
+        {
+            m_flags[i] |= WorldObjectFlagDirty;
+        }
+    }
+
+    eastl::atomic<bool> bStaticObjectMoved{ false };
+
+    // Children read the world matrices of their parents, so the levels are updated in order
+    for (size_t level = 0; level < m_levels.size(); ++level)
+    {
+        const eastl::vector<uint32_t>& objects = m_levels[level];
+        uint32_t objectCount = (uint32_t) objects.size();
+        uint32_t chunkCount = DivideRoundingUp(objectCount, WORLD_OBJECT_CHUNK_SIZE);
+        if (chunkCount == 0)
+        {
+            continue;
+        }
+
+        ParallelFor(chunkCount, [&](uint32_t chunk)
+            {
+                uint32_t begin = chunk * WORLD_OBJECT_CHUNK_SIZE;
+                uint32_t end = min(begin + WORLD_OBJECT_CHUNK_SIZE, objectCount);
+                bool bChunkStaticObjectMoved = false;
+
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    uint32_t id = objects[i];
+                    if (m_flags[id] & WorldObjectFlagDirty)
+                    {
+                        UpdateObject(id);
+                        bChunkStaticObjectMoved |= (m_flags[id] & WorldObjectFlagStatic) != 0;
+                    }
+                }
+
+                if (bChunkStaticObjectMoved)
+                {
+                    bStaticObjectMoved.store(true);
+                }
+            });
+    }
+
+    m_bStaticObjectMoved = bStaticObjectMoved.load();
+}
+
+void WorldObjectData::UpdateObject(uint32_t id)
+{
+    float4x4 t = translation_matrix(m_positions[id]);
+    float4x4 r = rotation_matrix(m_rotations[id]);
+    float4x4 s = scaling_matrix(m_scales[id]);
+    float4x4 mtxLocal = mul(t, mul(r, s)); //< Scale -> Rotate -> Trasnlate
+
+    uint32_t parent = m_parents[id];
+    float4x4 mtxWorld = parent == WORLD_OBJECT_INVALID_PARENT ? mtxLocal : mul(m_worldMatrices[parent], mtxLocal);
+    m_worldMatrices[id] = mtxWorld;
+
+    if (m_flags[id] & WorldObjectFlagBounded)
+    {
+        float3 center = mul(mtxWorld, float4(m_localBounds[id].xyz(), 1.0f)).xyz();
+        float scale = max(max(length(mtxWorld[0].xyz()), length(mtxWorld[1].xyz())), length(mtxWorld[2].xyz()));
+
+        m_centerX[id] = center.x;
+        m_centerY[id] = center.y;
+        m_centerZ[id] = center.z;
+        m_radius[id] = m_localBounds[id].w * scale;
+    }
+
+    m_flags[id] = (uint8_t) ((m_flags[id] & ~WorldObjectFlagDirty) | WorldObjectFlagMoved);
+}
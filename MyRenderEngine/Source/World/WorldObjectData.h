@@ -0,0 +1,65 @@
+#pragma once
+#include "Utils/math.h"
+#include "EASTL/vector.h"
+
+#define WORLD_OBJECT_INVALID_PARENT UINT32_MAX
+#define WORLD_OBJECT_CHUNK_SIZE 256     //< Objects per task of the parallel world updates
+
+enum WorldObjectFlagBit : uint8_t
+{
+    WorldObjectFlagDirty = 1 << 0,      //< Local transform or bounds changed, propagated to children in Update
+    WorldObjectFlagMoved = 1 << 1,      //< World transform changed in this frame
+    WorldObjectFlagBounded = 1 << 2,    //< Has a local bounding sphere, otherwise it is never culled
+    WorldObjectFlagStatic = 1 << 3,     //< Expected to never move, culled with WorldObjectBVH
+};
+
+// Hot data of world objects in SoA layout indexed by object ID, parents are always stored before their children
+class WorldObjectData
+{
+public:
+    uint32_t Add(uint32_t parent = WORLD_OBJECT_INVALID_PARENT, bool bStatic = false);
+    void Reserve(uint32_t count);
+    void Clear();
+
+    uint32_t GetCount() const { return (uint32_t) m_flags.size(); }
+
+    void SetLocalTransform(uint32_t id, const float3& pos, const quaternion& rotation, const float3& scale);
+    void SetLocalBounds(uint32_t id, const float3& center, float radius);
+
+    // Updates dirty world transforms and bounds in parallel chunks, one hierarchy level after another
+    void Update();
+
+    const float4x4& GetWorldMatrix(uint32_t id) const { return m_worldMatrices[id]; }
+    bool IsMoved(uint32_t id) const { return m_flags[id] & WorldObjectFlagMoved; }
+    bool IsBounded(uint32_t id) const { return m_flags[id] & WorldObjectFlagBounded; }
+    bool IsStatic(uint32_t id) const { return m_flags[id] & WorldObjectFlagStatic; }
+    bool IsStaticObjectMoved() const { return m_bStaticObjectMoved; }  //< In the last Update
+
+    // World space bounding spheres
+    const float* GetCenterX() const { return m_centerX.data(); }
+    const float* GetCenterY() const { return m_centerY.data(); }
+    const float* GetCenterZ() const { return m_centerZ.data(); }
+    const float* GetRadius() const { return m_radius.data(); }
+
+private:
+    void UpdateObject(uint32_t id);
+
+private:
+    eastl::vector<float3> m_positions;
+    eastl::vector<quaternion> m_rotations;
+    eastl::vector<float3> m_scales;
+    eastl::vector<float4> m_localBounds;    //< xyz : center, w : radius
+    eastl::vector<uint32_t> m_parents;
+    eastl::vector<uint8_t> m_flags;
+
+    eastl::vector<float4x4> m_worldMatrices;
+    eastl::vector<float> m_centerX;
+    eastl::vector<float> m_centerY;
+    eastl::vector<float> m_centerZ;
+    eastl::vector<float> m_radius;
+
+    eastl::vector<eastl::vector<uint32_t>> m_levels;    //< Object IDs of every hierarchy depth
+    eastl::vector<uint32_t> m_depths;
+
+    bool m_bStaticObjectMoved = false;
+};